@@ -0,0 +1,68 @@
+/**
+ * @file bench_common.h
+ * @brief Timing helpers shared by the micro-benchmarks.
+ *
+ * Reports use the same fields as onboard.benchmark.BenchmarkResult so
+ * native and Python numbers can be compared side by side.
+ */
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/** Keep a value alive so the optimizer cannot drop the benchmarked work. */
+static inline void bench_sink(const void *p) {
+    __asm__ __volatile__("" : : "r"(p) : "memory");
+}
+
+/* Seeded LCG for bench inputs; the same sequence as test_rand_next. */
+static inline unsigned bench_rand_next(unsigned *seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed;
+}
+
+/** Uniform in [0, 1), 24 bits. */
+static inline double bench_rand(unsigned *seed) {
+    return (bench_rand_next(seed) >> 8) / 16777216.0;
+}
+
+/** 32 random bits from two draws (the low LCG bits are poor). */
+static inline uint32_t bench_rand_u32(unsigned *seed) {
+    uint32_t hi = bench_rand_next(seed) >> 8;
+    return hi << 16 ^ bench_rand_next(seed) >> 8;
+}
+
+static int bench_cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/** Print mean/median/p95/p99/min/max of samples (sorted in place). */
+static inline void bench_report(const char *name, double *samples, int n,
+                                const char *unit) {
+    if (n <= 0) {
+        printf("%s: no samples\n", name);
+        return;
+    }
+    qsort(samples, (size_t)n, sizeof(double), bench_cmp_double);
+    double sum = 0;
+    for (int i = 0; i < n; i++) sum += samples[i];
+    int i95 = (int)(0.95 * n), i99 = (int)(0.99 * n);
+    if (i95 >= n) i95 = n - 1;
+    if (i99 >= n) i99 = n - 1;
+    printf("%s: mean=%.3f%s median=%.3f%s p95=%.3f%s p99=%.3f%s "
+           "min=%.3f%s max=%.3f%s (n=%d)\n",
+           name, sum / n, unit, samples[n / 2], unit, samples[i95], unit,
+           samples[i99], unit, samples[0], unit, samples[n - 1], unit, n);
+}
+
+#endif /* BENCH_COMMON_H */
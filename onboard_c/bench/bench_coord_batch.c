@@ -0,0 +1,107 @@
+/**
+ * @file bench_coord_batch.c
+ * @brief Coordinate conversion throughput: per-point libm calls vs the
+ *        batch kernels on scalar and SIMD lanes.
+ *
+ * Usage: bench_coord_batch [points]
+ *
+ * Random points inside a 30 km map pack at z19, converted in batches of
+ * 4096 (a keypoint set). Reports ns per point for each variant, then
+ * points/s.
+ */
+#include "bench_common.h"
+#include "coord_batch.h"
+#include "geo_transform.h"
+#include "tile_math.h"
+#include <math.h>
+#include <string.h>
+
+#define BATCH 4096
+#define ZOOM 19
+
+enum { OP_TILE, OP_TILE_PIXEL, OP_TO_GPS, N_OPS };
+enum { V_LIBM, V_SCALAR, V_SIMD, N_VARIANTS };
+
+static const char *op_names[N_OPS] = {"gps_to_tile", "gps_to_tile_pixel", "tile_pixel_to_gps"};
+
+static double lat[BATCH], lon[BATCH], px[BATCH], py[BATCH], lat2[BATCH], lon2[BATCH];
+static int tx[BATCH], ty[BATCH];
+
+static void run(int op, int variant) {
+    if (variant != V_LIBM) {
+        if (op == OP_TILE) vps_gps_to_tile_batch(lat, lon, BATCH, ZOOM, tx, ty);
+        if (op == OP_TILE_PIXEL) vps_gps_to_tile_pixel_batch(lat, lon, BATCH, ZOOM, tx, ty, px, py);
+        if (op == OP_TO_GPS) vps_tile_pixel_to_gps_batch(tx, ty, px, py, BATCH, ZOOM, lat2, lon2);
+        return;
+    }
+    for (int i = 0; i < BATCH; i++) {
+        vps_geopoint_t p = {lat[i], lon[i]};
+        if (op == OP_TILE) {
+            vps_tile_coord_t t = vps_gps_to_tile(p, ZOOM);
+            tx[i] = t.x;
+            ty[i] = t.y;
+        } else if (op == OP_TILE_PIXEL) {
+            vps_tile_coord_t t;
+            vps_pixel_t q;
+            vps_gps_to_tile_pixel(p, ZOOM, &t, &q);
+            tx[i] = t.x;
+            ty[i] = t.y;
+            px[i] = q.x;
+            py[i] = q.y;
+        } else {
+            vps_geopoint_t g = vps_tile_pixel_to_gps((vps_tile_coord_t){ZOOM, tx[i], ty[i]},
+                                                     (vps_pixel_t){px[i], py[i]});
+            lat2[i] = g.lat;
+            lon2[i] = g.lon;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    long points = argc > 1 ? atol(argv[1]) : 20000000;
+    int samples = (int)(points / BATCH);
+    if (samples < 1) samples = 1;
+    double *ns = malloc(sizeof(double) * (size_t)samples);
+    if (!ns) return 1;
+
+    unsigned seed = 7;
+    for (int i = 0; i < BATCH; i++) {
+        lat[i] = 47.3977 + (bench_rand(&seed) - 0.5) * 0.54;
+        lon[i] = 8.5456 + (bench_rand(&seed) - 0.5) * 0.8;
+    }
+    vps_gps_to_tile_pixel_batch(lat, lon, BATCH, ZOOM, tx, ty, px, py);
+
+    const char *simd = vps_coord_batch_isa();
+    const char *variant_names[N_VARIANTS] = {"libm", "scalar_lanes", simd};
+    double mean[N_OPS][N_VARIANTS];
+    char name[64];
+    printf("batch coordinates, z%d, %d points per batch, %d batches (ns per point)\n", ZOOM,
+           BATCH, samples);
+    for (int op = 0; op < N_OPS; op++)
+        for (int v = 0; v < N_VARIANTS; v++) {
+            vps_coord_batch_use_simd(v == V_SIMD);
+            run(op, v);   /* warm up */
+            for (int s = 0; s < samples; s++) {
+                uint64_t t0 = bench_now_ns();
+                run(op, v);
+                bench_sink(lat2);
+                bench_sink(px);
+                ns[s] = (double)(bench_now_ns() - t0) / BATCH;
+            }
+            double sum = 0.0;
+            for (int s = 0; s < samples; s++) sum += ns[s];
+            mean[op][v] = sum / samples;
+            snprintf(name, sizeof(name), "%s_%s", op_names[op], variant_names[v]);
+            bench_report(name, ns, samples, "ns");
+        }
+    vps_coord_batch_use_simd(true);
+
+    printf("\n%-18s %14s %14s %14s %8s\n", "points/s", "libm", "scalar lanes", simd,
+           "speedup");
+    for (int op = 0; op < N_OPS; op++)
+        printf("%-18s %14.0f %14.0f %14.0f %7.2fx\n", op_names[op], 1e9 / mean[op][V_LIBM],
+               1e9 / mean[op][V_SCALAR], 1e9 / mean[op][V_SIMD],
+               mean[op][V_LIBM] / mean[op][V_SIMD]);
+    free(ns);
+    return 0;
+}
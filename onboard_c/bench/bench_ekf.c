@@ -0,0 +1,69 @@
+/**
+ * @file bench_ekf.c
+ * @brief ns/update of the structured EKF kernel vs. the dense reference.
+ *
+ * Usage: bench_ekf [updates]
+ *
+ * Run on both the dev host (x86_64) and the CM4 (aarch64); the same
+ * measurement stream is fed to each variant.
+ */
+#include "bench_common.h"
+#include "ekf.h"
+
+#define N_MEAS 4096
+
+static vps_geopoint_t meas[N_MEAS];
+
+typedef bool (*update_fn)(vps_ekf_state_t *, const vps_ekf_config_t *,
+                          vps_geopoint_t, double, double);
+
+static double run(update_fn fn, int n, const vps_ekf_config_t *cfg) {
+    vps_ekf_state_t s;
+    vps_ekf_init(&s);
+    uint64_t t0 = bench_now_ns();
+    for (int i = 0; i < n; i++)
+        fn(&s, cfg, meas[i & (N_MEAS - 1)], 1.2, i * 0.01);
+    uint64_t dt = bench_now_ns() - t0;
+    bench_sink(&s);
+    return (double)dt / n;
+}
+
+int main(int argc, char **argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 2000000;
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+    cfg.max_gap_s = 1e12;  /* time keeps growing across wraps */
+
+    unsigned seed = 1;
+    for (int i = 0; i < N_MEAS; i++) {
+        double noise = ((bench_rand_next(&seed) >> 8) & 0xffff) / 65536.0 - 0.5;
+        meas[i].lat = 52.0 + 1e-7 * i + 1e-5 * noise;
+        meas[i].lon = 13.0 + 2e-7 * i - 1e-5 * noise;
+    }
+
+#if defined(__aarch64__)
+    const char *arch = "aarch64";
+#elif defined(__x86_64__)
+    const char *arch = "x86_64";
+#else
+    const char *arch = "other";
+#endif
+    /* Warm up, then alternate to even out frequency scaling */
+    run(vps_ekf_update, n / 10, &cfg);
+    double dense = 0, structured = 0;
+    for (int rep = 0; rep < 3; rep++) {
+        dense += run(vps_ekf_update_dense, n, &cfg) / 3;
+        structured += run(vps_ekf_update, n, &cfg) / 3;
+    }
+
+    double x[4] = {52.0, 13.0, 1e-5, 1e-5}, p[VPS_EKF_PACKED] = {1e-6, 0, 0, 0, 1e-6, 0, 0, 1e-6, 0, 1e-6};
+    uint64_t t0 = bench_now_ns();
+    for (int i = 0; i < n; i++) vps_ekf_propagate(x, p, 1e-10, 0.005);
+    double prop = (double)(bench_now_ns() - t0) / n;
+    bench_sink(p);
+
+    printf("arch=%s updates=%d\n", arch, n);
+    printf("dense update:       %7.1f ns/update\n", dense);
+    printf("structured update:  %7.1f ns/update (%.2fx)\n", structured, dense / structured);
+    printf("packed propagate:   %7.1f ns/predict\n", prop);
+    return 0;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file bench_ekf32.c
+ * @brief Float32 local-frame EKF vs. the double degree-space filter.
+ *
+ * Usage: bench_ekf32 [iterations]
+ *
+ * Single filter: ns per update (predict + gated correction). Lanes:
+ * ns per 64-lane propagate + correct with the double bank
+ * (ekf_bank.h) and the float32 bank, where each vector holds twice as
+ * many lanes. Build with -DVPS_AVX2=ON on x86_64; aarch64 uses NEON.
+ */
+#include "bench_common.h"
+#include "ekf32.h"
+#include "ekf_bank.h"
+
+int main(int argc, char **argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 2000000;
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+
+    vps_geopoint_t z[256];
+    for (int i = 0; i < 256; i++)
+        z[i] = (vps_geopoint_t){52.0 + 1e-5 * i + 2e-6 * (i % 7), 13.0 + 5e-6 * i};
+
+    vps_ekf_state_t d;
+    vps_ekf_init(&d);
+    uint64_t t0 = bench_now_ns();
+    for (int i = 0; i < n; i++) vps_ekf_update(&d, &cfg, z[i & 255], 1.0, i / 3.0);
+    double d_ns = (double)(bench_now_ns() - t0) / n;
+    bench_sink(&d);
+
+    vps_ekf32_t f;
+    vps_ekf32_init(&f, 0.0);
+    t0 = bench_now_ns();
+    for (int i = 0; i < n; i++) vps_ekf32_update(&f, &cfg, z[i & 255], 1.0, i / 3.0);
+    double f_ns = (double)(bench_now_ns() - t0) / n;
+    bench_sink(&f);
+
+    /* 64 lanes: candidate scoring in both precisions */
+    enum { L = 64 };
+    double lat[L], lon[L], r[L], dd[L];
+    float zn[L], ze[L], rn[L], re[L], df[L];
+    vps_ekf32_to_state(&f, &d);
+    for (int i = 0; i < L; i++) {
+        lat[i] = d.x[0] + 2e-5 * (i % 7);
+        lon[i] = d.x[1] + 1e-5 * (i % 5);
+        r[i] = cfg.measurement_noise * (1.0 + 0.1 * i);
+        zn[i] = (float)((lat[i] - f.lat0) * f.m_lat);
+        ze[i] = (float)((lon[i] - f.lon0) * f.m_lon);
+        rn[i] = (float)(r[i] * f.m_lat * f.m_lat);
+        re[i] = (float)(r[i] * f.m_lon * f.m_lon);
+    }
+    float qn = (float)(cfg.process_noise * f.m_lat * f.m_lat);
+    float qe = (float)(cfg.process_noise * f.m_lon * f.m_lon);
+    int iters = n / 10 > 0 ? n / 10 : 1;
+
+    static vps_ekf_bank_t bd;
+    vps_ekf_bank_broadcast(&bd, &d, L);
+    t0 = bench_now_ns();
+    for (int it = 0; it < iters; it++) {
+        vps_ekf_bank_propagate(&bd, cfg.process_noise, 0.333);
+        vps_ekf_bank_correct(&bd, lat, lon, r, cfg.gate_threshold, dd);
+        bench_sink(dd);
+    }
+    double bd_ns = (double)(bench_now_ns() - t0) / iters;
+
+    static vps_ekf32_bank_t bf;
+    vps_ekf32_bank_broadcast(&bf, &f, L);
+    t0 = bench_now_ns();
+    for (int it = 0; it < iters; it++) {
+        vps_ekf32_bank_propagate(&bf, qn, qe, 0.333f);
+        vps_ekf32_bank_correct(&bf, zn, ze, rn, re, (float)cfg.gate_threshold, df);
+        bench_sink(df);
+    }
+    double bf_ns = (double)(bench_now_ns() - t0) / iters;
+
+    printf("isa: double=%s float32=%s\n", vps_ekf_bank_isa(), vps_ekf32_bank_isa());
+    printf("%-24s %10s %10s %8s\n", "", "double", "float32", "gain");
+    printf("%-24s %10.1f %10.1f %7.2fx\n", "update (ns)", d_ns, f_ns, d_ns / f_ns);
+    printf("%-24s %10.1f %10.1f %7.2fx\n", "64-lane score (ns)", bd_ns, bf_ns, bd_ns / bf_ns);
+    return 0;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file bench_ekf_bank.c
+ * @brief Scoring N candidate fixes: SIMD bank vs. N scalar updates.
+ *
+ * Usage: bench_ekf_bank [iterations]
+ *
+ * Build with -DVPS_AVX2=ON on x86_64 to get the AVX2 lanes; aarch64
+ * builds use NEON automatically.
+ */
+#include "bench_common.h"
+#include "ekf_bank.h"
+#include <string.h>
+
+int main(int argc, char **argv) {
+    int iters = argc > 1 ? atoi(argv[1]) : 200000;
+
+    vps_ekf_state_t s;
+    vps_ekf_init(&s);
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+    for (int i = 0; i < 20; i++)
+        vps_ekf_update(&s, &cfg, (vps_geopoint_t){52.0 + 1e-5 * i, 13.0}, 1.0, i / 3.0);
+
+    double lat[VPS_EKF_BANK_MAX], lon[VPS_EKF_BANK_MAX], r[VPS_EKF_BANK_MAX];
+    double d[VPS_EKF_BANK_MAX];
+    for (int i = 0; i < VPS_EKF_BANK_MAX; i++) {
+        lat[i] = 52.0 + 2e-4 + 1e-5 * (i % 7);
+        lon[i] = 13.0 + 1e-5 * (i % 5);
+        r[i] = cfg.measurement_noise * (1.0 + 0.1 * i);
+    }
+
+    printf("isa=%s\n", vps_ekf_bank_isa());
+    printf("%4s %14s %14s %10s\n", "N", "bank ns/call", "scalar ns/call", "speed-up");
+    static const int sizes[] = {8, 16, 32, 64};
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        int n = sizes[k];
+        vps_ekf_bank_t bank;
+
+        uint64_t t0 = bench_now_ns();
+        for (int it = 0; it < iters; it++) {
+            vps_ekf_bank_broadcast(&bank, &s, n);
+            vps_ekf_bank_propagate(&bank, cfg.process_noise, 0.333);
+            vps_ekf_bank_correct(&bank, lat, lon, r, cfg.gate_threshold, d);
+            bench_sink(d);
+        }
+        double bank_ns = (double)(bench_now_ns() - t0) / iters;
+
+        double p0[VPS_EKF_PACKED];
+        vps_ekf_pack_cov(p0, &s.P[0][0]);
+        t0 = bench_now_ns();
+        for (int it = 0; it < iters; it++) {
+            for (int i = 0; i < n; i++) {
+                double x[4], p[VPS_EKF_PACKED];
+                memcpy(x, s.x, sizeof(x));
+                memcpy(p, p0, sizeof(p));
+                vps_ekf_propagate(x, p, cfg.process_noise, 0.333);
+                d[i] = vps_ekf_correct(x, p, (vps_geopoint_t){lat[i], lon[i]}, r[i],
+                                       cfg.gate_threshold);
+            }
+            bench_sink(d);
+        }
+        double scalar_ns = (double)(bench_now_ns() - t0) / iters;
+
+        printf("%4d %14.1f %14.1f %9.2fx\n", n, bank_ns, scalar_ns, scalar_ns / bank_ns);
+    }
+    return 0;
+}
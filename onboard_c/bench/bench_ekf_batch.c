@@ -0,0 +1,48 @@
+/**
+ * @file bench_ekf_batch.c
+ * @brief N fixes per frame: one information-form batch vs. N sequential updates.
+ *
+ * Usage: bench_ekf_batch [iterations]
+ */
+#include "bench_common.h"
+#include "ekf.h"
+
+int main(int argc, char **argv) {
+    int iters = argc > 1 ? atoi(argv[1]) : 200000;
+
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+    vps_ekf_state_t s0;
+    vps_ekf_init(&s0);
+    for (int i = 0; i < 20; i++)
+        vps_ekf_update(&s0, &cfg, (vps_geopoint_t){52.0 + 1e-5 * i, 13.0}, 1.0, i / 3.0);
+
+    vps_geopoint_t z[16];
+    double hdop[16];
+    for (int i = 0; i < 16; i++) {
+        z[i] = (vps_geopoint_t){52.0 + 2e-4 + 1e-6 * (i % 5), 13.0 + 1e-6 * (i % 3)};
+        hdop[i] = 0.8 + 0.1 * i;
+    }
+
+    printf("%3s %16s %16s %10s\n", "N", "batch ns/frame", "seq ns/frame", "speed-up");
+    for (int n = 1; n <= 16; n++) {
+        vps_ekf_state_t s;
+        uint64_t t0 = bench_now_ns();
+        for (int it = 0; it < iters; it++) {
+            s = s0;
+            vps_ekf_update_batch(&s, &cfg, z, hdop, n, 7.0, NULL);
+            bench_sink(&s);
+        }
+        double batch_ns = (double)(bench_now_ns() - t0) / iters;
+
+        t0 = bench_now_ns();
+        for (int it = 0; it < iters; it++) {
+            s = s0;
+            for (int i = 0; i < n; i++) vps_ekf_update(&s, &cfg, z[i], hdop[i], 7.0);
+            bench_sink(&s);
+        }
+        double seq_ns = (double)(bench_now_ns() - t0) / iters;
+
+        printf("%3d %16.1f %16.1f %9.2fx\n", n, batch_ns, seq_ns, seq_ns / batch_ns);
+    }
+    return 0;
+}
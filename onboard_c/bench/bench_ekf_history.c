@@ -0,0 +1,75 @@
+/**
+ * @file bench_ekf_history.c
+ * @brief Cost of an out-of-sequence EKF update vs. history depth.
+ *
+ * Usage: bench_ekf_history [iterations]
+ *
+ * For each depth the history is filled with 3 Hz fixes, then a fix is
+ * inserted just after the oldest retained entry (worst case: every
+ * later fix is re-fused) or appended in order (best case).
+ */
+#include "bench_common.h"
+#include "ekf.h"
+#include <string.h>
+
+static vps_ekf_state_t base_state, state;
+static vps_ekf_history_t base_hist, hist;
+
+static vps_geopoint_t meas_at(int i) {
+    vps_geopoint_t p = {52.0 + 1e-5 * i, 13.0 + 5e-6 * i};
+    return p;
+}
+
+static void fill(int depth, const vps_ekf_config_t *cfg) {
+    vps_ekf_init(&base_state);
+    vps_ekf_history_init(&base_hist, depth);
+    for (int i = 0; i < depth; i++)
+        vps_ekf_update_delayed(&base_state, &base_hist, cfg, meas_at(i), 1.0,
+                               i / 3.0, i / 3.0);
+}
+
+static double run(int depth, int iters, bool delayed, const vps_ekf_config_t *cfg,
+                  double *samples) {
+    double t_cap = delayed ? 0.1 : depth / 3.0;
+    double t_arr = depth / 3.0 + 0.4;
+    for (int k = 0; k < iters; k++) {
+        state = base_state;
+        memcpy(&hist, &base_hist, sizeof(hist));
+        uint64_t t0 = bench_now_ns();
+        vps_ekf_update_delayed(&state, &hist, cfg, meas_at(0), 1.0, t_cap, t_arr);
+        samples[k] = (double)(bench_now_ns() - t0);
+        bench_sink(&state);
+    }
+    double sum = 0;
+    for (int k = 0; k < iters; k++) sum += samples[k];
+    return sum / iters;
+}
+
+int main(int argc, char **argv) {
+    int iters = argc > 1 ? atoi(argv[1]) : 20000;
+    double *samples = malloc((size_t)iters * sizeof(double));
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+
+    /* Reference: plain in-order update */
+    vps_ekf_state_t s;
+    vps_ekf_init(&s);
+    uint64_t t0 = bench_now_ns();
+    for (int i = 0; i < iters; i++)
+        vps_ekf_update(&s, &cfg, meas_at(i), 1.0, i / 3.0);
+    bench_sink(&s);
+    printf("vps_ekf_update: %.1f ns/update\n", (double)(bench_now_ns() - t0) / iters);
+
+    printf("%6s %14s %14s %14s\n", "depth", "in-order ns", "oldest ns", "p99 oldest ns");
+    static const int depths[] = {1, 2, 4, 8, 16, 32, 64};
+    for (size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); d++) {
+        int depth = depths[d];
+        fill(depth, &cfg);
+        double in_order = run(depth, iters, false, &cfg, samples);
+        double oldest = run(depth, iters, true, &cfg, samples);
+        qsort(samples, (size_t)iters, sizeof(double), bench_cmp_double);
+        printf("%6d %14.1f %14.1f %14.1f\n", depth, in_order, oldest,
+               samples[(int)(0.99 * iters)]);
+    }
+    free(samples);
+    return 0;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file bench_fence_set.c
+ * @brief Zone set queries against a linear scan, 10 to 10k exclusion zones.
+ *
+ * Usage: bench_fence_set [queries]
+ *
+ * A 30 km inclusion circle with circle, rect and 16-gon exclusion zones
+ * scattered over 100 x 100 km. Times vps_fence_set_contains and
+ * vps_fence_set_check per point, vps_fence_set_check_batch per point of
+ * 5 s predicted tracks at 50 Hz, and the same nearest violation found by
+ * scanning every zone.
+ */
+#include "bench_common.h"
+#include "fence_set.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BATCH 64
+#define TRACK 250
+
+static vps_geopoint_t offset(vps_geopoint_t c, double n_km, double e_km) {
+    return (vps_geopoint_t){c.lat + n_km / 111.195,
+                            c.lon + e_km / (111.195 * cos(c.lat * M_PI / 180.0))};
+}
+
+static double scan(const vps_fence_set_t *s, vps_geopoint_t p) {
+    double best = vps_geofence_distance_km(&s->inclusion.fence, p) - s->inclusion.fence.margin_km;
+    for (int i = 0; i < s->n_zones; i++) {
+        const vps_geofence_t *f = &s->zones[i].fence;
+        best = fmin(best, -vps_geofence_distance_km(f, p) - f->margin_km);
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    int queries = argc > 1 ? atoi(argv[1]) : 100000;
+    int samples = queries / BATCH;
+    if (samples < 1) samples = 1;
+    static const int sizes[] = {10, 100, 1000, 10000};
+    vps_geopoint_t home = {47.3977, 8.5456};
+    vps_fence_zone_t inclusion = {.fence = {VPS_FENCE_CIRCLE, home, 30.0, 0.1, 0.0, 0.0, NULL}};
+    vps_fence_zone_t *zones = malloc(sizeof(vps_fence_zone_t) * 10000);
+    vps_geofence_poly_t *polys = malloc(sizeof(vps_geofence_poly_t) * 10000);
+    vps_geopoint_t *pts = malloc(sizeof(vps_geopoint_t) * BATCH * 64);
+    vps_geopoint_t *track = malloc(sizeof(vps_geopoint_t) * TRACK * 16);
+    vps_fence_result_t *out = malloc(sizeof(vps_fence_result_t) * TRACK);
+    double *ns = malloc(sizeof(double) * (size_t)samples);
+    if (!zones || !polys || !pts || !track || !out || !ns) return 1;
+    volatile double sink = 0.0;
+
+    unsigned seed = 3;
+    for (int i = 0; i < BATCH * 64; i++)
+        pts[i] = offset(home, (bench_rand(&seed) - 0.5) * 70.0, (bench_rand(&seed) - 0.5) * 70.0);
+    for (int k = 0; k < 16; k++) {
+        vps_geopoint_t p = offset(home, (bench_rand(&seed) - 0.5) * 50.0,
+                                  (bench_rand(&seed) - 0.5) * 50.0);
+        double h = 2.0 * M_PI * bench_rand(&seed);
+        for (int i = 0; i < TRACK; i++)   /* 15 m/s, 20 ms steps */
+            track[k * TRACK + i] = offset(p, 0.0003 * i * cos(h), 0.0003 * i * sin(h));
+    }
+
+    printf("fence set, %d points per case (ns per point)\n", samples * BATCH);
+    for (size_t z = 0; z < sizeof(sizes) / sizeof(sizes[0]); z++) {
+        int n = sizes[z], n_polys = 0;
+        for (int i = 0; i < n; i++) {
+            vps_geopoint_t c = offset(home, (bench_rand(&seed) - 0.5) * 100.0,
+                                      (bench_rand(&seed) - 0.5) * 100.0);
+            double size = 0.1 + 0.8 * bench_rand(&seed);
+            vps_geofence_t f = {VPS_FENCE_CIRCLE, c, size, 0.1, 0.0, 0.0, NULL};
+            if (i % 3 == 1) {
+                f = (vps_geofence_t){VPS_FENCE_RECT, c, 0.0, 0.1, size, 0.6 * size, NULL};
+            } else if (i % 3 == 2) {
+                vps_geopoint_t v[16];
+                for (int k = 0; k < 16; k++)
+                    v[k] = offset(c, size * sin(-M_PI * k / 8), size * cos(-M_PI * k / 8));
+                int len[] = {16};
+                if (!vps_geofence_poly_build(&polys[n_polys], v, len, 1)) return 1;
+                f = (vps_geofence_t){VPS_FENCE_POLYGON, c, 0.0, 0.1, 0.0, 0.0, &polys[n_polys++]};
+            }
+            zones[i] = (vps_fence_zone_t){.fence = f, .id = (uint32_t)i};
+        }
+        vps_fence_set_t set;
+        uint64_t t0 = bench_now_ns();
+        if (!vps_fence_set_build(&set, &inclusion, zones, n)) return 1;
+        printf("\n%d zones: build %.3f ms, %d nodes\n", n, (double)(bench_now_ns() - t0) * 1e-6,
+               set.n_nodes);
+
+        char name[48];
+        static const char *names[] = {"contains", "check", "scan"};
+        for (int k = 0; k < 3; k++) {
+            int reps = k == 2 ? (samples * 10 / n > 0 ? samples * 10 / n : 1) : samples;
+            if (reps > samples) reps = samples;
+            for (int s = 0; s < reps; s++) {
+                const vps_geopoint_t *q = pts + (s % 64) * BATCH;
+                t0 = bench_now_ns();
+                for (int i = 0; i < BATCH; i++) {
+                    if (k == 0) sink += vps_fence_set_contains(&set, q[i]);
+                    else if (k == 1) sink += vps_fence_set_check(&set, q[i]).clearance_km;
+                    else sink += scan(&set, q[i]);
+                }
+                ns[s] = (double)(bench_now_ns() - t0) / BATCH;
+            }
+            snprintf(name, sizeof(name), "z%d_%s", n, names[k]);
+            bench_report(name, ns, reps, "ns");
+        }
+        int reps = samples * BATCH / TRACK;
+        if (reps < 1) reps = 1;
+        for (int s = 0; s < reps; s++) {
+            t0 = bench_now_ns();
+            sink += vps_fence_set_check_batch(&set, track + (s % 16) * TRACK, TRACK, out);
+            ns[s] = (double)(bench_now_ns() - t0) / TRACK;
+        }
+        snprintf(name, sizeof(name), "z%d_batch_track", n);
+        bench_report(name, ns, reps, "ns");
+        vps_fence_set_free(&set);
+        for (int i = 0; i < n_polys; i++) vps_geofence_poly_free(&polys[i]);
+    }
+    (void)sink;
+    free(zones);
+    free(polys);
+    free(pts);
+    free(track);
+    free(out);
+    free(ns);
+    return 0;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file bench_footprint.c
+ * @brief Footprint projection and tile coverage per frame.
+ *
+ * Usage: bench_footprint [calls]
+ *
+ * For a few altitudes at z17 and z19, projects the default camera's
+ * frame from a pose at a random heading and from the equivalent
+ * homography, then rasterizes it. Reports ns per frame, and how many tiles
+ * the frame covers against the fixed 3x3 neighbourhood that
+ * refine_with_zoom19 matches.
+ */
+#include "bench_common.h"
+#include "footprint.h"
+#include <math.h>
+
+#define MAX_COVER 256
+
+int main(int argc, char **argv) {
+    int calls = argc > 1 ? atoi(argv[1]) : 20000;
+    if (calls < 1) calls = 1;
+    vps_camera_t cam;
+    vps_camera_default(&cam);
+    double *ns = malloc(sizeof(double) * (size_t)calls);
+    double *hs = malloc(sizeof(double) * (size_t)calls);
+    if (!ns || !hs) return 1;
+    static vps_tile_cover_t cov[MAX_COVER];
+    static const double alts[] = {50.0, 120.0, 300.0};
+    static const int zooms[] = {17, 19};
+
+    printf("footprint + coverage, %d frames per case\n", calls);
+    printf("%-5s %-7s %12s %12s %10s %12s\n", "zoom", "alt_m", "pose_ns", "homog_ns", "tiles",
+           "vs_3x3");
+    for (int z = 0; z < 2; z++)
+        for (int a = 0; a < 3; a++) {
+            unsigned seed = 1;
+            double tiles = 0.0, full = 0.0;
+            for (int i = 0; i < calls; i++) {
+                vps_geopoint_t p = {47.0 + bench_rand(&seed) * 0.2, 8.0 + bench_rand(&seed) * 0.2};
+                double hdg = bench_rand(&seed) * 360.0;
+                vps_footprint_t fp;
+                uint64_t t0 = bench_now_ns();
+                vps_footprint_from_pose(p, alts[a], hdg, &cam, zooms[z], &fp);
+                int n = vps_footprint_tiles(&fp, cov, MAX_COVER);
+                ns[i] = (double)(bench_now_ns() - t0);
+                bench_sink(cov);
+                tiles += n;
+                for (int k = 0; k < n; k++) full += cov[k].overlap >= 0.999;
+
+                /* The same frame as a z17 homography */
+                double sc = ldexp(1.0, 17 - zooms[z]) * 256.0;
+                vps_tile_coord_t tile = {17, (int)floor(fp.x[0] * sc / 256.0),
+                                         (int)floor(fp.y[0] * sc / 256.0)};
+                double w = cam.image_width_px, h = cam.image_height_px;
+                double H[9] = {(fp.x[1] - fp.x[0]) * sc / w, (fp.x[3] - fp.x[0]) * sc / h,
+                               fp.x[0] * sc - tile.x * 256.0, (fp.y[1] - fp.y[0]) * sc / w,
+                               (fp.y[3] - fp.y[0]) * sc / h, fp.y[0] * sc - tile.y * 256.0,
+                               0.0, 0.0, 1.0};
+                t0 = bench_now_ns();
+                vps_footprint_from_homography(H, tile, cam.image_width_px, cam.image_height_px,
+                                              zooms[z], &fp);
+                n = vps_footprint_tiles(&fp, cov, MAX_COVER);
+                hs[i] = (double)(bench_now_ns() - t0);
+                bench_sink(cov);
+            }
+            double mp = 0.0, mh = 0.0;
+            for (int i = 0; i < calls; i++) {
+                mp += ns[i] / calls;
+                mh += hs[i] / calls;
+            }
+            printf("%-5d %-7.0f %12.1f %12.1f %10.2f %11.2fx  (%.2f fully covered)\n",
+                   zooms[z], alts[a], mp, mh, tiles / calls, tiles / calls / 9.0, full / calls);
+        }
+    free(ns);
+    free(hs);
+    return 0;
+}
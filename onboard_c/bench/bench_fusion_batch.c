@@ -0,0 +1,101 @@
+/**
+ * @file bench_fusion_batch.c
+ * @brief Batch fusion replay and a parameter sweep on the work-stealing pool.
+ *
+ * Usage: bench_fusion_batch [param_sets] [threads]
+ *
+ * One simulated 1-hour flight (10 Hz frames, visual fixes at ~3 Hz with
+ * outages) is replayed per parameter set (gate, max_dr_s, process
+ * noise), stats only. Reports frames/s for per-frame vps_fusion_update
+ * calls, vps_fusion_run_batch, and the pool over all sets, plus the
+ * projected time for a 10k-set sweep at that rate.
+ */
+#include "bench_common.h"
+#include "fusion_pool.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define FRAMES (3600 * 10)
+
+static double t_[FRAMES], lat_[FRAMES], lon_[FRAMES], hdop_[FRAMES];
+static double truth_lat[FRAMES], truth_lon[FRAMES];
+static bool fix_[FRAMES];
+
+int main(int argc, char **argv) {
+    int sets = argc > 1 ? atoi(argv[1]) : 200;
+    int threads = argc > 2 ? atoi(argv[2]) : 0;
+    if (sets < 1) sets = 1;
+
+    unsigned seed = 1;
+    double la = 47.0, lo = 8.0;
+    for (int i = 0; i < FRAMES; i++) {
+        double t = i * 0.1;
+        la += 12.0 * sin(t / 60.0) * 0.1 / 111320.0;
+        lo += 12.0 * cos(t / 90.0) * 0.1 / (111320.0 * cos(la * M_PI / 180.0));
+        t_[i] = t;
+        truth_lat[i] = la;
+        truth_lon[i] = lo;
+        fix_[i] = i % 3 == 0 && (i / 900) % 10 != 9;  /* 90 s outage every 15 min */
+        double e = ((bench_rand_next(&seed) >> 8) & 0xffff) / 65536.0 - 0.5;
+        lat_[i] = la + 5.0 * e / 111320.0;
+        lon_[i] = lo - 5.0 * e / 111320.0;
+        hdop_[i] = 1.0 + 0.5 * e;
+    }
+    vps_fusion_frames_t in = {FRAMES, t_, lat_, lon_, hdop_, fix_, truth_lat, truth_lon};
+
+    /* One instance: per-frame calls vs batch */
+    static vps_fusion_t f;
+    vps_fusion_init(&f, NULL, 10.0, NULL);
+    uint64_t t0 = bench_now_ns();
+    for (int i = 0; i < FRAMES; i++) {
+        vps_geopoint_t z = {lat_[i], lon_[i]};
+        vps_fusion_output_t o = vps_fusion_update(&f, fix_[i] ? &z : NULL, hdop_[i], t_[i]);
+        bench_sink(&o);
+    }
+    double call_ns = (double)(bench_now_ns() - t0) / FRAMES;
+
+    vps_fusion_init(&f, NULL, 10.0, NULL);
+    vps_fusion_batch_stats_t st = {0};
+    t0 = bench_now_ns();
+    vps_fusion_run_batch(&f, &in, NULL, &st);
+    double batch_ns = (double)(bench_now_ns() - t0) / FRAMES;
+
+    /* Sweep */
+    vps_fusion_t *fs = malloc(sizeof(vps_fusion_t) * (size_t)sets);
+    vps_fusion_job_t *jobs = malloc(sizeof(vps_fusion_job_t) * (size_t)sets);
+    if (!fs || !jobs) return 1;
+    for (int j = 0; j < sets; j++) {
+        vps_ekf_config_t cfg = vps_ekf_default_config();
+        cfg.gate_threshold = 2.0 + 6.0 * (j % 10) / 9.0;
+        cfg.process_noise = 1e-11 * pow(10.0, (j / 10) % 3);
+        vps_fusion_init(&fs[j], &cfg, 2.0 + (j / 30) % 10, NULL);
+        jobs[j] = (vps_fusion_job_t){&fs[j], &in, NULL, {0}};
+    }
+    vps_fusion_pool_stats_t ps;
+    t0 = bench_now_ns();
+    vps_fusion_run_jobs(jobs, (size_t)sets, threads, &ps);
+    double sweep_s = (double)(bench_now_ns() - t0) * 1e-9;
+
+    int best = 0;
+    for (int j = 1; j < sets; j++)
+        if (jobs[j].stats.err_sum_sq_m2 / jobs[j].stats.err_n <
+            jobs[best].stats.err_sum_sq_m2 / jobs[best].stats.err_n)
+            best = j;
+    double fps = (double)sets * FRAMES / sweep_s;
+
+    printf("batch fusion: 1 h flight, %d frames, sizeof(vps_fusion_t) = %zu B\n",
+           FRAMES, sizeof(vps_fusion_t));
+    printf("  per-frame calls   %8.1f ns/frame  %6.2f M frames/s\n", call_ns, 1e3 / call_ns);
+    printf("  run_batch         %8.1f ns/frame  %6.2f M frames/s\n", batch_ns, 1e3 / batch_ns);
+    printf("  sweep %d sets on %d threads: %.2f s, %.2f M frames/s, %llu steals\n",
+           sets, ps.threads, sweep_s, fps * 1e-6, (unsigned long long)ps.steals);
+    printf("  projected 10k sets x 1 h: %.1f s\n", 1e4 * FRAMES / fps);
+    printf("  best set %d: gate %.2f, rms %.2f m\n", best, fs[best].ekf_cfg.gate_threshold,
+           sqrt(jobs[best].stats.err_sum_sq_m2 / jobs[best].stats.err_n));
+    free(jobs);
+    free(fs);
+    return 0;
+}
@@ -0,0 +1,220 @@
+/**
+ * @file bench_fusion_fx.c
+ * @brief Fixed-point fusion core: cost per update and agreement with the double build.
+ *
+ * Usage: bench_fusion_fx [iterations] [flight.vpsf]
+ *
+ * Times vps_fx_fusion_update on a 3 Hz fix stream with two prediction
+ * ticks per fix (plus the MSP encode) and, on hosts, vps_fusion_update on
+ * the same stream. With a VPSF recording, its visual records are replayed
+ * through both builds and the position differences reported.
+ *
+ * On Cortex-M targets the time base is SysTick in processor clocks, so
+ * samples are cycles. QEMU does not model cycles; with -icount shift=0
+ * the SysTick count becomes the number of instructions executed, e.g.
+ *   arm-none-eabi-gcc -mcpu=cortex-m4 -mthumb -mfloat-abi=soft -O2 \
+ *       -Iinclude bench/bench_fusion_fx.c src/fusion_fx.c src/msp.c \
+ *       --specs=rdimon.specs -T mps2_an386.ld -o bench_fusion_fx.elf
+ *   qemu-system-arm -M mps2-an386 -nographic -semihosting -icount shift=0 \
+ *       -kernel bench_fusion_fx.elf
+ * (the linker script is board specific). Only the fixed-point core is
+ * built there; the double comparison is host only.
+ */
+#include "bench_common.h"
+#include "fusion_fx.h"
+#include "msp.h"
+#include <string.h>
+
+#if defined(__ARM_ARCH_PROFILE) && __ARM_ARCH_PROFILE == 'M'
+#define FX_MCU 1
+#define SYST_CSR (*(volatile uint32_t *)0xE000E010u)
+#define SYST_RVR (*(volatile uint32_t *)0xE000E014u)
+#define SYST_CVR (*(volatile uint32_t *)0xE000E018u)
+#define UNIT "cyc"
+typedef uint32_t fx_clock_t;
+
+static void clock_start(void) {
+    SYST_RVR = 0xFFFFFFu;
+    SYST_CVR = 0;
+    SYST_CSR = 0x5;   /* enable, processor clock, no interrupt */
+}
+
+static fx_clock_t clock_now(void) {
+    return SYST_CVR;
+}
+
+/* SysTick counts down and wraps at 24 bits */
+static double clock_delta(fx_clock_t a, fx_clock_t b) {
+    return (double)((a - b) & 0xFFFFFFu);
+}
+#else
+#define FX_MCU 0
+#define UNIT "ns"
+typedef uint64_t fx_clock_t;
+#include "fusion.h"
+#include "smoother.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static void clock_start(void) {}
+
+static fx_clock_t clock_now(void) {
+    return bench_now_ns();
+}
+
+static double clock_delta(fx_clock_t a, fx_clock_t b) {
+    return (double)(b - a);
+}
+#endif
+
+#define FIXES 3000
+
+static vps_fx_point_t fixes[FIXES];
+static uint16_t hdops[FIXES];
+
+/* Curving flight around Zurich, 9 m/s, about 4 m of fix noise */
+static void make_flight(void) {
+    int32_t n_mm = 0, e_mm = 0, heading = 0;
+    unsigned seed = 1;
+    for (int k = 0; k < FIXES; k++) {
+        heading += (k / 200) % 2 ? 6000000 : -3000000;   /* degrees * 1e7 */
+        int32_t c = vps_fx_cos_deg7(heading), s = vps_fx_cos_deg7(heading - 900000000);
+        n_mm += (int32_t)(((int64_t)3000 * c) >> 30);
+        e_mm += (int32_t)(((int64_t)3000 * s) >> 30);
+        unsigned r = bench_rand_next(&seed);
+        int32_t wn = (int32_t)(r >> 20) - 2048, we = (int32_t)((r >> 8) & 4095) - 2048;
+        fixes[k].lat = 473977000 + (n_mm + 2 * wn) / 11;            /* ~1.1132 cm per unit */
+        fixes[k].lon = 85456000 + (e_mm + 2 * we) * 10 / 75;         /* ~0.75 cm per unit */
+        hdops[k] = (uint16_t)(80 + k % 90);
+    }
+}
+
+static void run_fx(int iters, double *upd, double *pred) {
+    vps_fx_fence_t fence = {VPS_FENCE_CIRCLE, {473977000, 85456000}, 20000000, 50000, 0, 0};
+    vps_fx_fusion_t f;
+    vps_fx_fusion_init(&f, NULL, &fence);
+    uint8_t frame[MSP_GPS_FRAME_SIZE];
+    clock_start();
+    uint32_t t_ms = 0;
+    for (int i = 0; i < iters; i++) {
+        int k = i % FIXES;
+        if (k == 0) vps_fx_fusion_init(&f, NULL, &fence);
+        t_ms += 333;
+
+        fx_clock_t t0 = clock_now();
+        vps_fx_output_t o = vps_fx_fusion_update(&f, &fixes[k], hdops[k], t_ms);
+        vps_fx_encode_msp(frame, &o);
+        upd[i] = clock_delta(t0, clock_now());
+        bench_sink(frame);
+
+        t0 = clock_now();
+        o = vps_fx_fusion_update(&f, NULL, 0, t_ms + 111);
+        vps_fx_encode_msp(frame, &o);
+        pred[i] = clock_delta(t0, clock_now());
+        bench_sink(frame);
+    }
+}
+
+#if !FX_MCU
+static void run_double(int iters, double *upd, double *pred) {
+    vps_geofence_t fence = {VPS_FENCE_CIRCLE, {47.3977, 8.5456}, 20.0, 0.05, 0.0, 0.0, NULL};
+    vps_fusion_t f;
+    uint8_t frame[MSP_GPS_FRAME_SIZE];
+    double t = 0.0;
+    for (int i = 0; i < iters; i++) {
+        int k = i % FIXES;
+        if (k == 0) vps_fusion_init(&f, NULL, 10.0, &fence);
+        t += 0.333;
+        vps_geopoint_t z = {fixes[k].lat * 1e-7, fixes[k].lon * 1e-7};
+
+        fx_clock_t t0 = clock_now();
+        vps_fusion_output_t o = vps_fusion_update(&f, &z, hdops[k] / 100.0, t);
+        vps_msp_encode_position(frame, o.position, o.speed_mps, o.heading_deg, o.hdop,
+                                o.has_position);
+        upd[i] = clock_delta(t0, clock_now());
+        bench_sink(frame);
+
+        t0 = clock_now();
+        o = vps_fusion_update(&f, NULL, 0.0, t + 0.111);
+        vps_msp_encode_position(frame, o.position, o.speed_mps, o.heading_deg, o.hdop,
+                                o.has_position);
+        pred[i] = clock_delta(t0, clock_now());
+        bench_sink(frame);
+    }
+}
+
+/* Replay the visual records of a recording through both builds */
+static int replay(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "bench_fusion_fx: cannot open %s\n", path);
+        return 1;
+    }
+    uint8_t hdr[VPS_VPSF_HEADER_SIZE], rec[VPS_VPSF_RECORD_SIZE];
+    if (fread(hdr, 1, sizeof(hdr), fp) != sizeof(hdr) || !vps_vpsf_check_header(hdr)) {
+        fprintf(stderr, "bench_fusion_fx: %s is not a VPSF recording\n", path);
+        fclose(fp);
+        return 1;
+    }
+    vps_fusion_t f;
+    vps_fusion_init(&f, NULL, 10.0, NULL);
+    vps_fx_fusion_t fx;
+    vps_fx_fusion_init(&fx, NULL, NULL);
+    double worst = 0.0, sum = 0.0;
+    int fixes_n = 0, outputs = 0, differ = 0;
+    while (fread(rec, 1, sizeof(rec), fp) == sizeof(rec)) {
+        vps_vpsf_record_t r;
+        vps_vpsf_decode(rec, &r);
+        if (r.source != VPS_VPSF_SOURCE_VISUAL) continue;
+        vps_fx_point_t zq = {(int32_t)lrint(r.lat * 1e7), (int32_t)lrint(r.lon * 1e7)};
+        vps_geopoint_t z = {zq.lat * 1e-7, zq.lon * 1e-7};
+        uint16_t hdop = (uint16_t)lrint(r.hdop * 100.0);
+        vps_fusion_output_t o = vps_fusion_update(&f, &z, hdop / 100.0, r.timestamp);
+        vps_fx_output_t q = vps_fx_fusion_update(&fx, &zq, hdop,
+                                                 (uint32_t)llrint(r.timestamp * 1000.0));
+        fixes_n++;
+        differ += o.ekf_accepted != q.ekf_accepted || o.has_position != q.has_position;
+        if (!o.has_position || !q.has_position) continue;
+        double dn = (q.position.lat * 1e-7 - o.position.lat) * 111320.0;
+        double de = (q.position.lon * 1e-7 - o.position.lon) * 111320.0 *
+                    cos(o.position.lat * M_PI / 180.0);
+        double e = hypot(dn, de);
+        sum += e;
+        if (e > worst) worst = e;
+        outputs++;
+    }
+    fclose(fp);
+    printf("replay %s: %d visual fixes, %d decisions differ\n", path, fixes_n, differ);
+    printf("  position difference: mean %.4f m, max %.4f m\n", outputs ? sum / outputs : 0.0,
+           worst);
+    return 0;
+}
+#endif
+
+int main(int argc, char **argv) {
+    int iters = argc > 1 ? atoi(argv[1]) : 30000;
+    if (iters < 1) iters = 1;
+    make_flight();
+    double *upd = malloc(sizeof(double) * (size_t)iters);
+    double *pred = malloc(sizeof(double) * (size_t)iters);
+    if (!upd || !pred) return 1;
+
+    printf("fusion update + MSP encode, %d fixes with predictions between\n", iters);
+    run_fx(iters, upd, pred);
+    bench_report("fx_fix", upd, iters, UNIT);
+    bench_report("fx_predict", pred, iters, UNIT);
+#if !FX_MCU
+    run_double(iters, upd, pred);
+    bench_report("double_fix", upd, iters, UNIT);
+    bench_report("double_predict", pred, iters, UNIT);
+    if (argc > 2 && replay(argv[2]) != 0) return 1;
+#else
+    (void)argv;
+#endif
+    free(upd);
+    free(pred);
+    return 0;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file bench_geofence_breach.c
+ * @brief Predicted breach over a 5 s horizon, analytic sweep vs sampling.
+ *
+ * Usage: bench_geofence_breach [calls]
+ *
+ * Random tracks (5-30 m/s, 20 m uncertainty) around circle, rect and
+ * polygon fences of 100 and 10k vertices, and a zone set of 1000 zones.
+ * Each case times the analytic sweep and the same answer found by
+ * checking the track at 50 Hz (250 points).
+ */
+#include "bench_common.h"
+#include "fence_set.h"
+#include "geofence.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BATCH 64
+#define N_TRACKS 1024
+#define HORIZON 5.0
+#define RADIUS_KM 0.02
+#define N_ZONES 1000
+
+static vps_geopoint_t offset(vps_geopoint_t c, double n_km, double e_km) {
+    return (vps_geopoint_t){c.lat + n_km / 111.195,
+                            c.lon + e_km / (111.195 * cos(c.lat * M_PI / 180.0))};
+}
+
+typedef struct {
+    vps_geopoint_t p;
+    double vn, ve;
+} track_t;
+
+static track_t tracks[N_TRACKS];
+
+static bool polygon(vps_geofence_poly_t *poly, vps_geopoint_t c, int n, double size) {
+    vps_geopoint_t *v = malloc(sizeof(vps_geopoint_t) * (size_t)n);
+    if (!v) return false;
+    for (int k = 0; k < n; k++) {
+        double a = 2.0 * M_PI * k / n, r = size * (1.0 + 0.1 * sin(7.0 * a));
+        v[k] = offset(c, r * sin(a), r * cos(a));
+    }
+    int len[] = {n};
+    bool ok = vps_geofence_poly_build(poly, v, len, 1);
+    free(v);
+    return ok;
+}
+
+/* First 50 Hz sample within reach of leaving the fence */
+static double sampled(const vps_geofence_t *f, const track_t *tr) {
+    vps_geofence_t g = *f;
+    g.margin_km += RADIUS_KM;
+    for (int i = 0; i <= 250; i++) {
+        double t = i * 0.02;
+        if (!vps_geofence_contains(&g, offset(tr->p, tr->vn * t * 1e-3, tr->ve * t * 1e-3)))
+            return t;
+    }
+    return INFINITY;
+}
+
+static double sampled_set(const vps_fence_set_t *s, const track_t *tr) {
+    vps_geopoint_t pts[251];
+    for (int i = 0; i <= 250; i++) {
+        double t = i * 0.02;
+        pts[i] = offset(tr->p, tr->vn * t * 1e-3, tr->ve * t * 1e-3);
+    }
+    int k = vps_fence_set_check_batch(s, pts, 251, NULL);
+    return k < 0 ? INFINITY : k * 0.02;
+}
+
+int main(int argc, char **argv) {
+    int calls = argc > 1 ? atoi(argv[1]) : 200000;
+    int samples = calls / BATCH;
+    if (samples < 1) samples = 1;
+    double *ns = malloc(sizeof(double) * (size_t)samples);
+    vps_fence_zone_t *zones = malloc(sizeof(vps_fence_zone_t) * N_ZONES);
+    if (!ns || !zones) return 1;
+    volatile double sink = 0.0;
+
+    vps_geopoint_t home = {47.3977, 8.5456};
+    unsigned seed = 3;
+    for (int i = 0; i < N_TRACKS; i++) {
+        double h = 2.0 * M_PI * bench_rand(&seed), v = 5.0 + 25.0 * bench_rand(&seed);
+        tracks[i] = (track_t){offset(home, (bench_rand(&seed) - 0.5) * 3.6,
+                                     (bench_rand(&seed) - 0.5) * 3.6),
+                              v * cos(h), v * sin(h)};
+    }
+    vps_geofence_poly_t p100, p10k;
+    if (!polygon(&p100, home, 100, 1.5) || !polygon(&p10k, home, 10000, 1.5)) return 1;
+    vps_geofence_t fences[] = {
+        {VPS_FENCE_CIRCLE, home, 1.5, 0.1, 0.0, 0.0, NULL},
+        {VPS_FENCE_RECT, home, 0.0, 0.1, 1.2, 1.6, NULL},
+        {VPS_FENCE_POLYGON, home, 0.0, 0.1, 0.0, 0.0, &p100},
+        {VPS_FENCE_POLYGON, home, 0.0, 0.1, 0.0, 0.0, &p10k},
+    };
+    static const char *names[] = {"circle", "rect", "poly100", "poly10k", "set1000"};
+
+    vps_fence_zone_t inclusion = {.fence = {VPS_FENCE_CIRCLE, home, 30.0, 0.1, 0.0, 0.0, NULL}};
+    for (int i = 0; i < N_ZONES; i++) {
+        vps_geopoint_t c = offset(home, (bench_rand(&seed) - 0.5) * 60.0,
+                                  (bench_rand(&seed) - 0.5) * 60.0);
+        double size = 0.1 + 0.5 * bench_rand(&seed);
+        zones[i] = (vps_fence_zone_t){
+            .fence = i % 2 ? (vps_geofence_t){VPS_FENCE_RECT, c, 0.0, 0.1, size, size, NULL}
+                           : (vps_geofence_t){VPS_FENCE_CIRCLE, c, size, 0.1, 0.0, 0.0, NULL},
+            .id = (uint32_t)i};
+    }
+    vps_fence_set_t set;
+    if (!vps_fence_set_build(&set, &inclusion, zones, N_ZONES)) return 1;
+    track_t set_tracks[N_TRACKS];
+    for (int i = 0; i < N_TRACKS; i++) {
+        set_tracks[i] = tracks[i];
+        set_tracks[i].p = offset(home, (bench_rand(&seed) - 0.5) * 50.0,
+                                 (bench_rand(&seed) - 0.5) * 50.0);
+    }
+
+    char name[48];
+    printf("predicted breach, %d s horizon, %d calls per case (ns per call)\n", (int)HORIZON,
+           samples * BATCH);
+    for (int c = 0; c < 5; c++) {
+        int breaches = 0;
+        for (int sampling = 0; sampling < 2; sampling++) {
+            int reps = sampling ? (samples / 16 > 0 ? samples / 16 : 1) : samples;
+            for (int s = 0; s < reps; s++) {
+                uint64_t t0 = bench_now_ns();
+                for (int i = 0; i < BATCH; i++) {
+                    const track_t *tr = c == 4 ? &set_tracks[(s * BATCH + i) % N_TRACKS]
+                                               : &tracks[(s * BATCH + i) % N_TRACKS];
+                    double t;
+                    if (sampling) {
+                        t = c == 4 ? sampled_set(&set, tr) : sampled(&fences[c], tr);
+                    } else if (c == 4) {
+                        vps_fence_set_time_to_breach(&set, tr->p, tr->vn, tr->ve, RADIUS_KM,
+                                                     HORIZON, &t, NULL);
+                    } else {
+                        vps_geofence_time_to_breach(&fences[c], tr->p, tr->vn, tr->ve,
+                                                    RADIUS_KM, HORIZON, &t);
+                    }
+                    breaches += !sampling && s == 0 && t <= HORIZON;
+                    sink += t <= HORIZON ? t : 0.0;
+                }
+                ns[s] = (double)(bench_now_ns() - t0) / BATCH;
+            }
+            snprintf(name, sizeof(name), "%s_%s", names[c], sampling ? "sampled_50hz" : "sweep");
+            bench_report(name, ns, reps, "ns");
+        }
+        printf("  (%d of %d tracks breach)\n", breaches, BATCH);
+    }
+    (void)sink;
+    vps_fence_set_free(&set);
+    vps_geofence_poly_free(&p100);
+    vps_geofence_poly_free(&p10k);
+    free(zones);
+    free(ns);
+    return 0;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file bench_geofence_poly.c
+ * @brief Polygon geofence cost per query from 10 to 100k vertices.
+ *
+ * Usage: bench_geofence_poly [queries]
+ *
+ * For each size a wavy ring (radius 4..6 km, one hole at 100+ vertices)
+ * is built and queried at random points of its bounding box and at
+ * points within 100 m of the boundary, which is where margins are
+ * decided in flight. A plain even-odd scan over the edge table and the
+ * haversine circle fence are timed for comparison.
+ */
+#include "bench_common.h"
+#include "geofence.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BATCH 64   /* queries per timed sample */
+
+static bool scan_inside(const vps_geofence_poly_t *p, vps_geopoint_t q) {
+    double x, y;
+    vps_geofence_poly_project(p, q, &x, &y);
+    bool in = false;
+    for (int i = 0; i < p->n_edges; i++) {
+        const vps_poly_edge_t *e = &p->edges[i];
+        if ((e->ay > y) != (e->by > y) &&
+            x < e->ax + (y - e->ay) * (e->bx - e->ax) / (e->by - e->ay))
+            in = !in;
+    }
+    return in;
+}
+
+static int make_ring(vps_geopoint_t *pts, int *len, int n, vps_geopoint_t c) {
+    double ky = 1.0 / 111.195, kx = ky / cos(c.lat * M_PI / 180.0);
+    int hole = n >= 100 ? n / 10 : 0, outer = n - hole;
+    for (int i = 0; i < outer; i++) {
+        double a = 2.0 * M_PI * i / outer;
+        double r = 5.0 + sin(9.0 * a) + 0.2 * sin(97.0 * a);
+        pts[i] = (vps_geopoint_t){c.lat + r * sin(a) * ky, c.lon + r * cos(a) * kx};
+    }
+    len[0] = outer;
+    if (!hole) return 1;
+    for (int i = 0; i < hole; i++) {
+        double a = -2.0 * M_PI * i / hole;
+        pts[outer + i] = (vps_geopoint_t){c.lat + 1.5 * sin(a) * ky, c.lon + 1.5 * cos(a) * kx};
+    }
+    len[1] = hole;
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    int queries = argc > 1 ? atoi(argv[1]) : 200000;
+    int samples = queries / BATCH;
+    if (samples < 1) samples = 1;
+    vps_geopoint_t c = {47.3977, 8.5456};
+    static const int sizes[] = {10, 100, 1000, 10000, 100000};
+    vps_geopoint_t *pts = malloc(sizeof(vps_geopoint_t) * 100000);
+    vps_geopoint_t *rand_q = malloc(sizeof(vps_geopoint_t) * BATCH * 64);
+    vps_geopoint_t *edge_q = malloc(sizeof(vps_geopoint_t) * BATCH * 64);
+    double *ns = malloc(sizeof(double) * (size_t)samples);
+    if (!pts || !rand_q || !edge_q || !ns) return 1;
+    volatile double sink = 0.0;
+
+    printf("polygon geofence, %d queries per case (ns per query)\n", samples * BATCH);
+    vps_geofence_t circle = {VPS_FENCE_CIRCLE, c, 5.0, 0.05, 0.0, 0.0, NULL};
+    unsigned seed = 1;
+    for (int i = 0; i < BATCH * 64; i++)
+        rand_q[i] = (vps_geopoint_t){c.lat + (bench_rand(&seed) - 0.5) * 0.12,
+                                     c.lon + (bench_rand(&seed) - 0.5) * 0.18};
+    for (int s = 0; s < samples; s++) {
+        const vps_geopoint_t *q = rand_q + (s % 64) * BATCH;
+        uint64_t t0 = bench_now_ns();
+        for (int i = 0; i < BATCH; i++) sink += vps_geofence_contains(&circle, q[i]);
+        ns[s] = (double)(bench_now_ns() - t0) / BATCH;
+    }
+    bench_report("circle_contains", ns, samples, "ns");
+
+    for (size_t z = 0; z < sizeof(sizes) / sizeof(sizes[0]); z++) {
+        int n = sizes[z], len[2];
+        int rings = make_ring(pts, len, n, c);
+        vps_geofence_poly_t poly;
+        uint64_t t0 = bench_now_ns();
+        if (!vps_geofence_poly_build(&poly, pts, len, rings)) return 1;
+        double build_ms = (double)(bench_now_ns() - t0) * 1e-6;
+        printf("\n%d vertices: build %.2f ms, %d cells of %.1f m, %d edge refs\n", n, build_ms,
+               poly.n_cells, poly.cell_km * 1000.0, (int)poly.cells[poly.n_cells].first);
+
+        /* Points within 100 m of a random vertex */
+        for (int i = 0; i < BATCH * 64; i++) {
+            vps_geopoint_t v = pts[(int)(bench_rand(&seed) * n) % n];
+            edge_q[i] = (vps_geopoint_t){v.lat + (bench_rand(&seed) - 0.5) * 0.0018,
+                                         v.lon + (bench_rand(&seed) - 0.5) * 0.0026};
+        }
+        char name[48];
+        for (int k = 0; k < 5; k++) {
+            const vps_geopoint_t *set = k % 2 ? edge_q : rand_q;
+            int reps = k == 4 ? (samples * 10 / n > 0 ? samples * 10 / n : 1) : samples;
+            if (reps > samples) reps = samples;
+            for (int s = 0; s < reps; s++) {
+                const vps_geopoint_t *q = set + (s % 64) * BATCH;
+                t0 = bench_now_ns();
+                for (int i = 0; i < BATCH; i++) {
+                    if (k < 2) sink += vps_geofence_poly_contains(&poly, q[i], 0.05);
+                    else if (k < 4) sink += vps_geofence_poly_distance_km(&poly, q[i]);
+                    else sink += scan_inside(&poly, q[i]);
+                }
+                ns[s] = (double)(bench_now_ns() - t0) / BATCH;
+            }
+            static const char *names[] = {"contains_random", "contains_edge", "distance_random",
+                                          "distance_edge", "scan_contains_random"};
+            snprintf(name, sizeof(name), "n%d_%s", n, names[k]);
+            bench_report(name, ns, reps, "ns");
+        }
+        vps_geofence_poly_free(&poly);
+    }
+    (void)sink;
+    free(pts);
+    free(rand_q);
+    free(edge_q);
+    free(ns);
+    return 0;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file bench_global_pixel.c
+ * @brief Tile/pixel/distance work on z24 global pixels vs the float paths.
+ *
+ * Usage: bench_global_pixel [calls]
+ *
+ * Each case runs the current lat/lon call and its global-pixel
+ * counterpart on the same random points inside a 30 km map pack (points
+ * converted once, as a pipeline keeping positions as global pixels
+ * would), reporting ns per call and then calls/s before and after.
+ */
+#include "bench_common.h"
+#include "geo_transform.h"
+#include "global_pixel.h"
+#include "tile_math.h"
+#include <math.h>
+
+#define BATCH 64
+#define N_PTS 1024
+#define ZOOM 17
+
+enum {
+    C_TILE, C_TILE_PIXEL, C_NEIGHBORS, C_OFFSET, C_DISTANCE, C_WITHIN, C_FROM_GPS, C_TO_GPS,
+    N_CASES
+};
+
+static const char *case_names[N_CASES] = {
+    "tile",     "tile_pixel", "neighbors_3x3", "pixel_offset",
+    "distance", "within_1km", "from_gps",      "to_gps",
+};
+
+static vps_geopoint_t pts[N_PTS];
+static vps_gpx_t gpx[N_PTS];
+static vps_gpx_scale_t scale;
+
+static double run(int c, bool gp, int i) {
+    vps_geopoint_t p = pts[i % N_PTS], q = pts[(i + 1) % N_PTS];
+    vps_gpx_t g = gpx[i % N_PTS], h = gpx[(i + 1) % N_PTS];
+    vps_tile_coord_t tiles[9], t, u;
+    vps_pixel_t a, b;
+    switch (c) {
+    case C_TILE:
+        t = gp ? vps_gpx_tile(g, ZOOM) : vps_gps_to_tile(p, ZOOM);
+        return t.x + t.y;
+    case C_TILE_PIXEL:
+        if (gp) {
+            a = vps_gpx_tile_pixel(g, ZOOM);
+            t = vps_gpx_tile(g, ZOOM);
+        } else {
+            vps_gps_to_tile_pixel(p, ZOOM, &t, &a);
+        }
+        return a.x + t.x;
+    case C_NEIGHBORS:
+        /* 3x3 around the point; the float path sizes a radius to one tile */
+        if (gp) return vps_gpx_neighbors(g, ZOOM, 1, tiles, 9);
+        return vps_tiles_in_radius(p, vps_meters_per_pixel(p.lat, ZOOM) * 0.256, ZOOM, tiles, 9);
+    case C_OFFSET:
+        /* z17 pixel offset between two points */
+        if (gp) {
+            vps_gpx_t d = vps_gpx_delta(g, h);
+            return (double)(d.x >> (VPS_GPX_ZOOM - ZOOM)) + (double)(d.y >> (VPS_GPX_ZOOM - ZOOM));
+        }
+        vps_gps_to_tile_pixel(p, ZOOM, &t, &a);
+        vps_gps_to_tile_pixel(q, ZOOM, &u, &b);
+        return (u.x - t.x) * 256.0 + b.x - a.x + (u.y - t.y) * 256.0 + b.y - a.y;
+    case C_DISTANCE:
+        if (gp) {
+            int64_t mm = 0;
+            vps_gpx_distance_mm(&scale, g, h, &mm);
+            return (double)mm;
+        }
+        return vps_haversine_km(p, q);
+    case C_WITHIN:
+        return gp ? vps_gpx_within_mm(&scale, g, h, 1000000) : vps_haversine_km(p, q) <= 1.0;
+    case C_FROM_GPS:
+        if (gp) return (double)vps_gpx_from_gps(p).y;
+        vps_gps_to_tile_pixel(p, ZOOM, &t, &a);
+        return a.y;
+    default:
+        if (gp) return vps_gpx_to_gps(g).lat;
+        t = (vps_tile_coord_t){ZOOM, 68000, 45000};
+        return vps_tile_pixel_to_gps(t, (vps_pixel_t){p.lat, 3.0}).lat;
+    }
+}
+
+int main(int argc, char **argv) {
+    int calls = argc > 1 ? atoi(argv[1]) : 1000000;
+    int samples = calls / BATCH;
+    if (samples < 1) samples = 1;
+    double *ns = malloc(sizeof(double) * (size_t)samples);
+    if (!ns) return 1;
+
+    vps_geopoint_t home = {47.3977, 8.5456};
+    unsigned seed = 5;
+    for (int i = 0; i < N_PTS; i++) {
+        pts[i] = (vps_geopoint_t){home.lat + (bench_rand(&seed) - 0.5) * 0.54,
+                                  home.lon + (bench_rand(&seed) - 0.5) * 0.8};
+        gpx[i] = vps_gpx_from_gps(pts[i]);
+    }
+    vps_gpx_scale_init(&scale, vps_gpx_from_gps(home));
+
+    volatile double sink = 0.0;
+    double mean[N_CASES][2];
+    char name[48];
+    printf("global pixels, z%d, %d calls per case (ns per call)\n", ZOOM, samples * BATCH);
+    for (int c = 0; c < N_CASES; c++)
+        for (int gp = 0; gp < 2; gp++) {
+            for (int s = 0; s < samples; s++) {
+                uint64_t t0 = bench_now_ns();
+                for (int i = 0; i < BATCH; i++) sink += run(c, gp, s * BATCH + i);
+                ns[s] = (double)(bench_now_ns() - t0) / BATCH;
+            }
+            double sum = 0.0;
+            for (int s = 0; s < samples; s++) sum += ns[s];
+            mean[c][gp] = sum / samples;
+            snprintf(name, sizeof(name), "%s_%s", case_names[c], gp ? "gpx" : "float");
+            bench_report(name, ns, samples, "ns");
+        }
+
+    printf("\n%-18s %14s %14s %8s\n", "calls/s", "float", "gpx", "speedup");
+    for (int c = 0; c < N_CASES; c++)
+        printf("%-18s %14.0f %14.0f %7.2fx\n", case_names[c], 1e9 / mean[c][0],
+               1e9 / mean[c][1], mean[c][0] / mean[c][1]);
+    (void)sink;
+    free(ns);
+    return 0;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file bench_imm.c
+ * @brief IMM (hover/cruise/turn) update cost next to the single EKF.
+ *
+ * Usage: bench_imm [iterations]
+ *
+ * ns per update on a hover/cruise/turn track with 1 m noise at 3 Hz:
+ * vps_ekf_update (one constant-velocity model, structured kernel), the
+ * dense reference filter, vps_imm_update (three models in bank lanes)
+ * and vps_imm_update + vps_imm_to_state, which is what fusion pays in
+ * IMM mode. Build with -DVPS_AVX2=ON on x86_64.
+ */
+#include "bench_common.h"
+#include "imm.h"
+#include <math.h>
+
+#define TRACK 4096
+
+int main(int argc, char **argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+
+    static vps_geopoint_t z[TRACK];
+    unsigned seed = 1;
+    double pn = 0.0, pe = 0.0;
+    for (int k = 0; k < TRACK; k++) {
+        double t = k / 3.0, vn = 0.0, ve = 0.0;
+        int phase = (k / 90) % 3;
+        if (phase == 1) vn = 15.0;
+        if (phase == 2) {
+            vn = 15.0 * cos(0.6 * t);
+            ve = 15.0 * sin(0.6 * t);
+        }
+        pn += vn / 3.0;
+        pe += ve / 3.0;
+        double noise = ((bench_rand_next(&seed) >> 8) & 0xffff) / 65536.0 - 0.5;
+        z[k] = (vps_geopoint_t){47.0 + (pn + noise) / 111320.0, 8.0 + (pe - noise) / 111320.0};
+    }
+
+    vps_ekf_state_t s;
+    vps_ekf_init(&s);
+    uint64_t t0 = bench_now_ns();
+    for (int i = 0; i < n; i++) {
+        if ((i & (TRACK - 1)) == 0) vps_ekf_reset(&s);
+        vps_ekf_update(&s, &cfg, z[i & (TRACK - 1)], 0.3, i / 3.0);
+    }
+    double ekf_ns = (double)(bench_now_ns() - t0) / n;
+    bench_sink(&s);
+
+    vps_ekf_init(&s);
+    t0 = bench_now_ns();
+    for (int i = 0; i < n; i++) {
+        if ((i & (TRACK - 1)) == 0) vps_ekf_reset(&s);
+        vps_ekf_update_dense(&s, &cfg, z[i & (TRACK - 1)], 0.3, i / 3.0);
+    }
+    double dense_ns = (double)(bench_now_ns() - t0) / n;
+    bench_sink(&s);
+
+    static vps_imm_t m;
+    vps_imm_init(&m, NULL);
+    t0 = bench_now_ns();
+    for (int i = 0; i < n; i++) {
+        if ((i & (TRACK - 1)) == 0) vps_imm_reset(&m);
+        vps_imm_update(&m, &cfg, z[i & (TRACK - 1)], 0.3, i / 3.0);
+    }
+    double imm_ns = (double)(bench_now_ns() - t0) / n;
+    bench_sink(&m);
+
+    vps_imm_init(&m, NULL);
+    t0 = bench_now_ns();
+    for (int i = 0; i < n; i++) {
+        if ((i & (TRACK - 1)) == 0) vps_imm_reset(&m);
+        vps_imm_update(&m, &cfg, z[i & (TRACK - 1)], 0.3, i / 3.0);
+        vps_imm_to_state(&m, &s);
+        bench_sink(&s);
+    }
+    double fused_ns = (double)(bench_now_ns() - t0) / n;
+
+    printf("IMM vs single EKF (%s lanes, %d updates)\n", vps_ekf_bank_isa(), n);
+    printf("%-28s %10s %8s\n", "", "ns/update", "x ekf");
+    printf("%-28s %10.1f %8.2f\n", "ekf (1 model)", ekf_ns, 1.0);
+    printf("%-28s %10.1f %8.2f\n", "ekf dense (1 model)", dense_ns, dense_ns / ekf_ns);
+    printf("%-28s %10.1f %8.2f\n", "imm (3 models)", imm_ns, imm_ns / ekf_ns);
+    printf("%-28s %10.1f %8.2f\n", "imm + combined state", fused_ns, fused_ns / ekf_ns);
+    printf("model probabilities: hover %.3f cruise %.3f turn %.3f\n",
+           m.mu[VPS_IMM_HOVER], m.mu[VPS_IMM_CRUISE], m.mu[VPS_IMM_TURN]);
+    return 0;
+}
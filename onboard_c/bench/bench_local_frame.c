@@ -0,0 +1,132 @@
+/**
+ * @file bench_local_frame.c
+ * @brief Per-frame geometry with and without a local frame.
+ *
+ * Usage: bench_local_frame [calls]
+ *
+ * Each case runs the original call (haversine / cos / atan2) and its
+ * local-frame counterpart on the same random points inside a 30 km map
+ * pack, reporting ns per call and then calls/s before and after.
+ */
+#include "bench_common.h"
+#include "dead_reckoning.h"
+#include "ekf.h"
+#include "fusion.h"
+#include "geo_transform.h"
+#include "geofence.h"
+#include "local_frame.h"
+#include "tile_math.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BATCH 64
+#define N_PTS 1024
+
+enum {
+    C_DISTANCE, C_CIRCLE, C_RECT, C_DR, C_SPEED, C_HEADING, C_PIXELS, C_FUSION, N_CASES
+};
+
+static const char *case_names[N_CASES] = {
+    "distance", "fence_circle", "fence_rect", "dr_extrapolate",
+    "ekf_speed", "heading", "pixel_distance", "fusion_update_dr",
+};
+
+static vps_geopoint_t pts[N_PTS];
+static vps_geofence_t circle, rect;
+static vps_local_frame_t frame;
+static vps_dr_state_t dr_plain, dr_frame;
+static vps_ekf_state_t ekf;
+static vps_fusion_t fu_plain, fu_frame;
+
+static double run(int c, bool local, int i) {
+    vps_geopoint_t p = pts[i % N_PTS], q = pts[(i + 1) % N_PTS];
+    vps_geopoint_t pos;
+    double h;
+    switch (c) {
+    case C_DISTANCE:
+        return local ? vps_local_frame_distance_m(&frame, p, q) : vps_haversine_km(p, q);
+    case C_CIRCLE:
+        return local ? vps_geofence_contains_local(&circle, &frame, p)
+                     : vps_geofence_contains(&circle, p);
+    case C_RECT:
+        return local ? vps_geofence_contains_local(&rect, &frame, p)
+                     : vps_geofence_contains(&rect, p);
+    case C_DR:
+        vps_dr_extrapolate(local ? &dr_frame : &dr_plain, 0.01 * (i % 512), &pos, &h);
+        return pos.lat;
+    case C_SPEED:
+        ekf.x[0] = p.lat;
+        return local ? vps_ekf_speed_local(&ekf, &frame) : vps_ekf_speed(&ekf);
+    case C_HEADING:
+        return local ? vps_heading_deg(p.lat - q.lat, p.lon - q.lon)
+                     : fmod(atan2(p.lon - q.lon, p.lat - q.lat) * 180.0 / M_PI + 360.0, 360.0);
+    case C_PIXELS:
+        return local ? vps_pixel_distance_to_meters_local(&frame, 3.0, 4.0, p.lat, 18)
+                     : vps_pixel_distance_to_meters(3.0, 4.0, p.lat, 18);
+    default: {
+        vps_fusion_t *f = local ? &fu_frame : &fu_plain;
+        return vps_fusion_update(f, NULL, 1.0, 10.0 + 0.01 * (i % 512)).position.lat;
+    }
+    }
+}
+
+int main(int argc, char **argv) {
+    int calls = argc > 1 ? atoi(argv[1]) : 1000000;
+    int samples = calls / BATCH;
+    if (samples < 1) samples = 1;
+    double *ns = malloc(sizeof(double) * (size_t)samples);
+    if (!ns) return 1;
+
+    vps_geopoint_t home = {47.3977, 8.5456};
+    if (!vps_local_frame_init(&frame, home, 30.0)) return 1;
+    unsigned seed = 5;
+    for (int i = 0; i < N_PTS; i++)
+        pts[i] = vps_local_frame_from_enu(&frame, (bench_rand(&seed) - 0.5) * 40000.0,
+                                          (bench_rand(&seed) - 0.5) * 40000.0);
+    circle = (vps_geofence_t){VPS_FENCE_CIRCLE, {47.40, 8.55}, 12.0, 0.1, 0.0, 0.0, NULL};
+    rect = (vps_geofence_t){VPS_FENCE_RECT, {47.39, 8.54}, 0.0, 0.1, 10.0, 12.0, NULL};
+    vps_dr_init(&dr_plain, 10.0, 2.0);
+    vps_dr_init(&dr_frame, 10.0, 2.0);
+    vps_dr_set_frame(&dr_frame, &frame);
+    vps_dr_update_ref(&dr_plain, home, 8.0, 9.0, 1.0, 0.0);
+    vps_dr_update_ref(&dr_frame, home, 8.0, 9.0, 1.0, 0.0);
+    vps_ekf_init(&ekf);
+    ekf.initialized = true;
+    ekf.x[2] = 8.0 / 111320.0;
+    ekf.x[3] = 9.0 / 75000.0;
+    /* Fusion with a fence, coasting on dead reckoning (no EKF, no fixes) */
+    vps_fusion_init(&fu_plain, NULL, 1e9, &circle);
+    vps_fusion_init(&fu_frame, NULL, 1e9, &circle);
+    vps_fusion_set_frame(&fu_frame, &frame);
+    vps_dr_update_ref(&fu_plain.dr, home, 8.0, 9.0, 1.0, 0.0);
+    vps_dr_update_ref(&fu_frame.dr, home, 8.0, 9.0, 1.0, 0.0);
+
+    volatile double sink = 0.0;
+    double mean[N_CASES][2];
+    char name[48];
+    printf("local frame, %d calls per case (ns per call)\n", samples * BATCH);
+    for (int c = 0; c < N_CASES; c++)
+        for (int local = 0; local < 2; local++) {
+            for (int s = 0; s < samples; s++) {
+                uint64_t t0 = bench_now_ns();
+                for (int i = 0; i < BATCH; i++) sink += run(c, local, s * BATCH + i);
+                ns[s] = (double)(bench_now_ns() - t0) / BATCH;
+            }
+            double sum = 0.0;
+            for (int s = 0; s < samples; s++) sum += ns[s];
+            mean[c][local] = sum / samples;
+            snprintf(name, sizeof(name), "%s_%s", case_names[c], local ? "frame" : "trig");
+            bench_report(name, ns, samples, "ns");
+        }
+
+    printf("\n%-18s %14s %14s %8s\n", "calls/s", "before", "after", "speedup");
+    for (int c = 0; c < N_CASES; c++)
+        printf("%-18s %14.0f %14.0f %7.2fx\n", case_names[c], 1e9 / mean[c][0],
+               1e9 / mean[c][1], mean[c][0] / mean[c][1]);
+    (void)sink;
+    free(ns);
+    return 0;
+}
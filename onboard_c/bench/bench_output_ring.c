@@ -0,0 +1,76 @@
+/**
+ * @file bench_output_ring.c
+ * @brief End-to-end fusion update to encoded bytes in the output ring.
+ *
+ * Usage: bench_output_ring [iterations]
+ *
+ * Each sample is one call, timed from vps_fusion_update entry until the
+ * output's bytes are committed to the ring: fusion alone, the legacy
+ * path (vps_runtime_encode into a stack buffer, then copied into the
+ * ring) and the in-place sink for NMEA, MSP and both. The ring is
+ * drained between samples, outside the timed region.
+ */
+#include "bench_common.h"
+#include "runtime.h"
+
+enum { PLAIN, LEGACY_NMEA, LEGACY_MSP, SINK_NMEA, SINK_MSP, SINK_BOTH, MODES };
+
+static const char *names[MODES] = {
+    "fusion only        ", "legacy NMEA + copy ", "legacy MSP + copy  ",
+    "sink NMEA          ", "sink MSP           ", "sink NMEA + MSP    ",
+};
+
+int main(int argc, char **argv) {
+    int iters = argc > 1 ? atoi(argv[1]) : 100000;
+    if (iters < 1) iters = 1;
+    double *ns = malloc(sizeof(double) * (size_t)iters);
+    if (!ns) return 1;
+
+    vps_out_ring_t ring;
+    if (!vps_out_ring_init(&ring, 1 << 16)) return 1;
+    uint64_t bytes[MODES] = {0};
+
+    for (int mode = 0; mode < MODES; mode++) {
+        vps_fusion_t f;
+        vps_fusion_sink_t sink;
+        vps_fusion_init(&f, NULL, 10.0, NULL);
+        unsigned protocols = mode == SINK_NMEA ? VPS_SINK_NMEA
+                           : mode == SINK_MSP  ? VPS_SINK_MSP
+                                               : VPS_SINK_NMEA | VPS_SINK_MSP;
+        vps_fusion_sink_init(&sink, &ring, protocols);
+        if (mode >= SINK_NMEA) vps_fusion_set_sink(&f, &sink);
+
+        for (int i = 0; i < iters; i++) {
+            double t = i * 0.05;
+            vps_geopoint_t z = {52.52 + 2e-6 * t, 13.405 + 3e-6 * t};
+            uint64_t t0 = bench_now_ns();
+            vps_fusion_output_t o = vps_fusion_update(&f, i % 4 ? NULL : &z, 1.2, t);
+            if (mode == LEGACY_NMEA || mode == LEGACY_MSP) {
+                uint8_t buf[VPS_RUNTIME_OUT_MAX];
+                int n = vps_runtime_encode(mode == LEGACY_MSP ? VPS_OUTPUT_MSP : VPS_OUTPUT_NMEA,
+                                           &o, buf, sizeof(buf));
+                vps_out_ring_write(&ring, buf, (size_t)n);
+            }
+            ns[i] = (double)(bench_now_ns() - t0);
+            bench_sink(&o);
+            bytes[mode] += vps_out_ring_used(&ring);
+            const uint8_t *p;
+            size_t n;
+            while ((n = vps_out_ring_peek(&ring, &p)) > 0) vps_out_ring_consume(&ring, n);
+        }
+        bench_report(names[mode], ns, iters, "ns");
+    }
+
+    /* Timer overhead, included in every sample above */
+    for (int i = 0; i < iters; i++) {
+        uint64_t t0 = bench_now_ns();
+        ns[i] = (double)(bench_now_ns() - t0);
+    }
+    bench_report("clock overhead     ", ns, iters, "ns");
+    printf("bytes/output: NMEA %.1f, MSP %.1f, both %.1f\n",
+           (double)bytes[SINK_NMEA] / iters, (double)bytes[SINK_MSP] / iters,
+           (double)bytes[SINK_BOTH] / iters);
+    vps_out_ring_free(&ring);
+    free(ns);
+    return 0;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file bench_output_thread.c
+ * @brief Output interval and wake-up jitter of the fixed-rate thread.
+ *
+ * Usage: bench_output_thread [rate_hz] [seconds] [match_ms] [rt_priority]
+ *
+ * A producer thread simulates slow matching (one fix every match_ms of
+ * busy CPU) while the output thread ticks at rate_hz. SCHED_FIFO needs
+ * CAP_SYS_NICE or an rtprio limit.
+ */
+#include "bench_common.h"
+#include "output_thread.h"
+#include <stdatomic.h>
+
+#define MAX_SAMPLES 100000
+
+typedef struct {
+    double last_t;
+    double *intervals_ms;
+    int n;
+} sink_t;
+
+typedef struct {
+    vps_output_thread_t *ot;
+    double match_ms;
+    _Atomic bool stop;
+} producer_t;
+
+static void on_output(void *ctx, const vps_fusion_output_t *out, double t) {
+    sink_t *s = ctx;
+    (void)out;
+    if (s->last_t > 0 && s->n < MAX_SAMPLES)
+        s->intervals_ms[s->n++] = (t - s->last_t) * 1e3;
+    s->last_t = t;
+}
+
+static void *producer_main(void *arg) {
+    producer_t *p = arg;
+    uint32_t seq = 0;
+    while (!atomic_load(&p->stop)) {
+        double t_capture = vps_monotonic_s();
+        uint64_t end = bench_now_ns() + (uint64_t)(p->match_ms * 1e6);
+        while (bench_now_ns() < end && !atomic_load(&p->stop)) {
+        }
+        vps_visual_fix_t fix = {.position = {52.52 + 1e-6 * seq, 13.405}, .hdop = 1.5,
+                                .t = t_capture, .seq = seq};
+        vps_output_thread_post(p->ot, &fix);
+        seq++;
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    double rate = argc > 1 ? atof(argv[1]) : 50.0;
+    double seconds = argc > 2 ? atof(argv[2]) : 5.0;
+    double match_ms = argc > 3 ? atof(argv[3]) : 400.0;
+    int prio = argc > 4 ? atoi(argv[4]) : 0;
+
+    vps_config_t cfg;
+    vps_config_defaults(&cfg);
+    vps_runtime_t rt;
+    vps_frame_source_t src = {NULL, NULL};
+    vps_matcher_t m = {NULL, NULL, NULL};
+    vps_runtime_init(&rt, &cfg, src, m, NULL);
+
+    sink_t sink = {0, malloc(MAX_SAMPLES * sizeof(double)), 0};
+    vps_output_thread_config_t oc = vps_output_thread_default_config();
+    oc.rate_hz = rate;
+    oc.rt_priority = prio;
+    oc.on_output = on_output;
+    oc.on_output_ctx = &sink;
+
+    vps_output_thread_t ot;
+    if (!vps_output_thread_start(&ot, &rt, &oc)) return 1;
+    producer_t prod = {&ot, match_ms, false};
+    pthread_t th;
+    pthread_create(&th, NULL, producer_main, &prod);
+
+    struct timespec ts = {(time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9)};
+    nanosleep(&ts, NULL);
+    atomic_store(&prod.stop, true);
+    pthread_join(th, NULL);
+    vps_output_thread_stop(&ot);
+
+    vps_output_stats_t st;
+    vps_output_thread_stats(&ot, &st);
+    printf("rate=%.1fHz match=%.0fms sched=%s ticks=%llu missed=%llu "
+           "fixes=%llu overwritten=%llu\n",
+           rate, match_ms, st.realtime ? "SCHED_FIFO" : "normal",
+           (unsigned long long)st.ticks, (unsigned long long)st.missed_ticks,
+           (unsigned long long)st.fixes_applied,
+           (unsigned long long)st.fixes_overwritten);
+    bench_report("output interval", sink.intervals_ms, sink.n, "ms");
+    printf("wake-up jitter: mean=%.1fus max=%.1fus\n",
+           st.jitter_mean_ns / 1e3, st.jitter_max_ns / 1e3);
+    for (int i = 0; i < VPS_JITTER_BUCKETS; i++) {
+        if (!st.hist[i]) continue;
+        if (i == 0)
+            printf("  <1us        %llu\n", (unsigned long long)st.hist[i]);
+        else
+            printf("  %6llu-%-6lluus %llu\n", 1ull << (i - 1), 1ull << i,
+                   (unsigned long long)st.hist[i]);
+    }
+    free(sink.intervals_ms);
+    return 0;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file bench_pipeline.c
+ * @brief Sequential loop vs pipelined runtime with synthetic stage costs.
+ *
+ * Usage: bench_pipeline [frames] [capture_ms] [retrieval_ms] [match_ms]
+ *
+ * Stage costs are CPU busy-loops, so the pipelined speed-up needs at
+ * least as many cores as busy stages (CM4: 4).
+ */
+#include "bench_common.h"
+#include "pipeline.h"
+#include "tile_math.h"
+#include <string.h>
+#include <unistd.h>
+
+typedef struct {
+    int frames;
+    int next;
+    double capture_ms;
+    double retrieval_ms;
+    double match_ms;
+} synth_t;
+
+static void spin_ms(double ms) {
+    uint64_t end = bench_now_ns() + (uint64_t)(ms * 1e6);
+    while (bench_now_ns() < end) {
+    }
+}
+
+static bool synth_grab(void *ctx, vps_frame_t *frame) {
+    synth_t *s = ctx;
+    if (s->next >= s->frames) return false;
+    spin_ms(s->capture_ms);
+    frame->pixels = NULL;
+    frame->width = 640;
+    frame->height = 640;
+    frame->stride = 640;
+    frame->t = s->next / 3.0;
+    frame->seq = (uint32_t)s->next++;
+    return true;
+}
+
+static int synth_retrieve(void *ctx, const vps_frame_t *frame,
+                          vps_tile_coord_t *out, int max_out) {
+    synth_t *s = ctx;
+    spin_ms(s->retrieval_ms);
+    if (max_out < 1) return 0;
+    vps_geopoint_t p = {52.52 + 1e-5 * frame->seq, 13.405};
+    out[0] = vps_gps_to_tile(p, 19);
+    return 1;
+}
+
+static bool synth_match(void *ctx, const vps_frame_t *frame,
+                        vps_tile_coord_t tile, vps_match_t *out) {
+    synth_t *s = ctx;
+    spin_ms(s->match_ms);
+    memset(out, 0, sizeof(*out));
+    out->tile = tile;
+    out->num_matches = 100;
+    out->inlier_ratio = 0.7;
+    out->confidence = 0.7;
+    out->H[0] = out->H[4] = 0.4;
+    out->H[8] = 1.0;
+    (void)frame;
+    return true;
+}
+
+static void setup(vps_runtime_t *rt, synth_t *s) {
+    vps_config_t cfg;
+    vps_config_defaults(&cfg);
+    vps_frame_source_t src = {s, synth_grab};
+    vps_matcher_t m = {s, synth_retrieve, synth_match};
+    vps_runtime_init(rt, &cfg, src, m, NULL);
+}
+
+int main(int argc, char **argv) {
+    synth_t s = {
+        .frames = argc > 1 ? atoi(argv[1]) : 60,
+        .capture_ms = argc > 2 ? atof(argv[2]) : 10.0,
+        .retrieval_ms = argc > 3 ? atof(argv[3]) : 20.0,
+        .match_ms = argc > 4 ? atof(argv[4]) : 40.0,
+    };
+    printf("frames=%d capture=%.1fms retrieval=%.1fms match=%.1fms cores=%ld\n",
+           s.frames, s.capture_ms, s.retrieval_ms, s.match_ms,
+           sysconf(_SC_NPROCESSORS_ONLN));
+
+    /* Sequential */
+    vps_runtime_t rt;
+    setup(&rt, &s);
+    vps_step_result_t res;
+    uint64_t t0 = bench_now_ns();
+    while (vps_runtime_step(&rt, &res)) {
+    }
+    double seq_s = (double)(bench_now_ns() - t0) / 1e9;
+    printf("sequential: %.1f frames/s\n", s.frames / seq_s);
+
+    /* Pipelined: blocking capture queue, then latest-frame-wins */
+    for (int policy = 0; policy < 2; policy++) {
+        s.next = 0;
+        setup(&rt, &s);
+        vps_pipeline_config_t pc = vps_pipeline_default_config();
+        pc.queue_policy[VPS_STAGE_CAPTURE] = policy ? VPS_QUEUE_LATEST : VPS_QUEUE_BLOCK;
+
+        vps_pipeline_t pipe;
+        t0 = bench_now_ns();
+        if (!vps_pipeline_start(&pipe, &rt, &pc)) return 1;
+        vps_pipeline_join(&pipe);
+        double pipe_s = (double)(bench_now_ns() - t0) / 1e9;
+
+        vps_stage_stats_t st[VPS_STAGE_COUNT];
+        vps_pipeline_stats(&pipe, st);
+        printf("pipelined (%s capture queue): %.1f frames in/s, %.1f frames out/s\n",
+               policy ? "latest-wins" : "blocking",
+               st[VPS_STAGE_CAPTURE].processed / pipe_s,
+               st[VPS_STAGE_OUTPUT].processed / pipe_s);
+        for (int i = 0; i < VPS_STAGE_COUNT; i++) {
+            printf("  %-9s processed=%llu dropped=%llu depth_max=%u "
+                   "busy=%.1fms wait=%.1fms block=%.1fms\n",
+                   vps_stage_name((vps_stage_t)i),
+                   (unsigned long long)st[i].processed,
+                   (unsigned long long)st[i].dropped, st[i].queue_max_depth,
+                   st[i].busy_ns / 1e6, st[i].wait_ns / 1e6, st[i].block_ns / 1e6);
+        }
+        vps_pipeline_free(&pipe);
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file bench_runtime.c
+ * @brief Native loop throughput and latency on a recorded frame set.
+ *
+ * Usage: bench_runtime [MATCH_LOG] [iterations]
+ *
+ * Compare with onboard.benchmark.benchmark_replay_loop on the same log.
+ * Without a log a synthetic 3 Hz straight-line flight is replayed.
+ */
+#include "bench_common.h"
+#include "match_log.h"
+#include "geo_transform.h"
+#include <string.h>
+
+static void synthesize(vps_match_log_t *log, int n) {
+    memset(log, 0, sizeof(*log));
+    for (int i = 0; i < n; i++) {
+        vps_match_log_entry_t e;
+        memset(&e, 0, sizeof(e));
+        e.t = i / 3.0;
+        e.width = 640;
+        e.height = 640;
+
+        /* ~10 m/s north-east; every 10th frame unmatched */
+        vps_geopoint_t p = {52.5200 + 6.35e-5 * e.t, 13.4050 + 1.04e-4 * e.t};
+        if (i % 10 != 9) {
+            vps_pixel_t px;
+            vps_gps_to_tile_pixel(p, 19, &e.match.tile, &px);
+            e.match.num_matches = 120;
+            e.match.inlier_ratio = 0.7;
+            e.match.confidence = 0.7;
+            /* Scale + translation: frame center lands on px */
+            e.match.H[0] = 0.4; e.match.H[2] = px.x - 0.4 * 320.0;
+            e.match.H[4] = 0.4; e.match.H[5] = px.y - 0.4 * 320.0;
+            e.match.H[8] = 1.0;
+        }
+        vps_match_log_append(log, &e);
+    }
+}
+
+static bool count_bytes(void *ctx, const uint8_t *data, size_t len) {
+    (void)data;
+    *(size_t *)ctx += len;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    vps_match_log_t log;
+    if (argc > 1) {
+        if (!vps_match_log_load(&log, argv[1])) {
+            fprintf(stderr, "cannot load %s\n", argv[1]);
+            return 1;
+        }
+    } else {
+        synthesize(&log, 3 * 60 * 10);  /* 10 minutes at 3 Hz */
+    }
+    int iterations = argc > 2 ? atoi(argv[2]) : 20000;
+    log.loop = true;
+
+    vps_config_t cfg;
+    vps_config_defaults(&cfg);
+
+    size_t bytes = 0;
+    vps_runtime_t rt;
+    vps_runtime_init(&rt, &cfg, vps_match_log_source(&log),
+                     vps_match_log_matcher(&log), NULL);
+    rt.write = count_bytes;
+    rt.write_ctx = &bytes;
+
+    double *ms = malloc(sizeof(double) * (size_t)iterations);
+    vps_step_result_t res;
+    uint64_t t0 = bench_now_ns();
+    int n = 0;
+    for (; n < iterations; n++) {
+        uint64_t a = bench_now_ns();
+        if (!vps_runtime_step(&rt, &res)) break;
+        ms[n] = (double)(bench_now_ns() - a) / 1e6;
+    }
+    double elapsed = (double)(bench_now_ns() - t0) / 1e9;
+
+    printf("native loop: %d frames (%d in log), %.0f frames/s, %zu bytes out\n",
+           n, log.count, n / elapsed, bytes);
+    bench_report("native loop", ms, n, "ms");
+
+    free(ms);
+    vps_match_log_free(&log);
+    return 0;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file bench_smoother.c
+ * @brief Fixed-lag RTS smoother throughput (target: > 1M records/s).
+ *
+ * Usage: bench_smoother [records] [lag]
+ *
+ * Times the smoother alone (in-memory records) and the full file path
+ * (decode, smooth, encode) through a temporary file.
+ */
+#include "bench_common.h"
+#include "smoother.h"
+#include <math.h>
+
+static void count_emit(void *ctx, const vps_vpsf_record_t *rec) {
+    (*(uint64_t *)ctx)++;
+    bench_sink(rec);
+}
+
+static vps_vpsf_record_t synth(int i) {
+    vps_vpsf_record_t r = {0};
+    r.timestamp = i * 0.1;
+    r.lat = 52.0 + 1e-5 * i + 2e-5 * sin(i * 0.37);
+    r.lon = 13.0 + 2e-5 * cos(i * 0.21);
+    r.hdop = 1.5f;
+    r.source = (i % 10 == 9) ? 2 : 1;   /* every 10th frame without a match */
+    return r;
+}
+
+int main(int argc, char **argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 2000000;
+    vps_smoother_config_t cfg = vps_smoother_default_config();
+    if (argc > 2) cfg.lag = atoi(argv[2]);
+
+    static vps_smoother_t s;
+    uint64_t emitted = 0;
+    vps_smoother_init(&s, &cfg, count_emit, &emitted);
+
+    /* Records are generated up front so only smoothing is timed */
+    int chunk = 65536;
+    vps_vpsf_record_t *recs = malloc((size_t)chunk * sizeof(*recs));
+    for (int i = 0; i < chunk; i++) recs[i] = synth(i);
+    uint64_t t0 = bench_now_ns();
+    for (int i = 0; i < n; i++) {
+        vps_vpsf_record_t r = recs[i % chunk];
+        r.timestamp = i * 0.1;
+        vps_smoother_push(&s, &r);
+    }
+    vps_smoother_flush(&s);
+    double mem_s = (bench_now_ns() - t0) * 1e-9;
+
+    FILE *in = tmpfile(), *out = tmpfile();
+    if (!in || !out) return 1;
+    uint8_t buf[VPS_VPSF_RECORD_SIZE];
+    vps_vpsf_encode_header(buf);
+    fwrite(buf, 1, VPS_VPSF_HEADER_SIZE, in);
+    for (int i = 0; i < n; i++) {
+        vps_vpsf_record_t r = synth(i);
+        vps_vpsf_encode(buf, &r);
+        fwrite(buf, 1, sizeof(buf), in);
+    }
+    rewind(in);
+    vps_smoother_stats_t st;
+    t0 = bench_now_ns();
+    bool ok = vps_smoother_run_file(in, out, &cfg, &st);
+    double file_s = (bench_now_ns() - t0) * 1e-9;
+    fclose(in);
+    fclose(out);
+    free(recs);
+
+    printf("lag=%d records=%d emitted=%llu\n", cfg.lag, n, (unsigned long long)emitted);
+    printf("in-memory: %.2f M records/s (%.1f ns/record)\n", n / mem_s * 1e-6, mem_s * 1e9 / n);
+    printf("file:      %.2f M records/s (%.1f ns/record)%s\n", n / file_s * 1e-6,
+           file_s * 1e9 / n, ok ? "" : " FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file bench_snapshot.c
+ * @brief Snapshot publication: seqlock vs. a mutex-protected copy.
+ *
+ * Usage: bench_snapshot [publish_hz] [seconds]
+ *
+ * One writer publishes at publish_hz (default 0 = as fast as possible)
+ * while four reader threads copy the latest state in a loop. Reports
+ * writer ns/publish and its worst case, reader ns/read and retries per
+ * read, for the seqlock and for a pthread mutex baseline.
+ */
+#include "bench_common.h"
+#include "snapshot.h"
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#define READERS 4
+
+typedef struct {
+    vps_fusion_pub_t pub;
+    pthread_mutex_t mu;
+    vps_fusion_snapshot_t locked;
+    bool use_mutex;
+    _Atomic bool done;
+} shared_t;
+
+typedef struct {
+    shared_t *sh;
+    uint64_t reads, retries, ns;
+} reader_t;
+
+static void *reader_main(void *arg) {
+    reader_t *r = arg;
+    vps_fusion_snapshot_t s;
+    uint64_t t0 = bench_now_ns();
+    while (!atomic_load_explicit(&r->sh->done, memory_order_acquire)) {
+        if (r->sh->use_mutex) {
+            pthread_mutex_lock(&r->sh->mu);
+            s = r->sh->locked;
+            pthread_mutex_unlock(&r->sh->mu);
+        } else {
+            uint32_t retries;
+            vps_fusion_snapshot_read(&r->sh->pub, &s, &retries);
+            r->retries += retries;
+        }
+        bench_sink(&s);
+        r->reads++;
+    }
+    r->ns = bench_now_ns() - t0;
+    return NULL;
+}
+
+static void run(shared_t *sh, bool use_mutex, double hz, double seconds) {
+    vps_fusion_pub_init(&sh->pub);
+    sh->use_mutex = use_mutex;
+    atomic_store(&sh->done, false);
+
+    vps_fusion_t f;
+    vps_fusion_init(&f, NULL, 10.0, NULL);
+    vps_geopoint_t z = {52.52, 13.405};
+    vps_fusion_output_t o = vps_fusion_update(&f, &z, 1.0, 0.0);
+
+    reader_t r[READERS];
+    pthread_t tid[READERS];
+    for (int i = 0; i < READERS; i++) {
+        r[i] = (reader_t){sh, 0, 0, 0};
+        pthread_create(&tid[i], NULL, reader_main, &r[i]);
+    }
+
+    uint64_t n = 0, write_ns = 0, worst = 0;
+    uint64_t start = bench_now_ns(), end = start + (uint64_t)(seconds * 1e9);
+    uint64_t period = hz > 0 ? (uint64_t)(1e9 / hz) : 0;
+    for (uint64_t now = start; now < end; now = bench_now_ns()) {
+        uint64_t t0 = bench_now_ns();
+        if (use_mutex) {
+            pthread_mutex_lock(&sh->mu);
+            sh->locked.t = (double)n;
+            sh->locked.version = n + 1;
+            sh->locked.out = o;
+            sh->locked.ekf = f.ekf;
+            sh->locked.dr = f.dr;
+            pthread_mutex_unlock(&sh->mu);
+        } else {
+            vps_fusion_publish(&sh->pub, &f, &o, (double)n);
+        }
+        uint64_t dt = bench_now_ns() - t0;
+        write_ns += dt;
+        if (dt > worst) worst = dt;
+        n++;
+        if (period) {
+            struct timespec ts = {0, (long)period};
+            nanosleep(&ts, NULL);
+        }
+    }
+    atomic_store_explicit(&sh->done, true, memory_order_release);
+
+    uint64_t reads = 0, retries = 0, read_ns = 0;
+    for (int i = 0; i < READERS; i++) {
+        pthread_join(tid[i], NULL);
+        reads += r[i].reads;
+        retries += r[i].retries;
+        read_ns += r[i].ns;
+    }
+    printf("  %-8s publish %7.1f ns (max %6.1f us, %llu)  read %7.1f ns  "
+           "%.4f retries/read\n",
+           use_mutex ? "mutex" : "seqlock", (double)write_ns / (double)n, worst * 1e-3,
+           (unsigned long long)n, reads ? (double)read_ns / (double)reads : 0.0,
+           reads ? (double)retries / (double)reads : 0.0);
+}
+
+int main(int argc, char **argv) {
+    double hz = argc > 1 ? atof(argv[1]) : 0.0;
+    double seconds = argc > 2 ? atof(argv[2]) : 1.0;
+    static shared_t sh;
+    pthread_mutex_init(&sh.mu, NULL);
+    memset(&sh.locked, 0, sizeof(sh.locked));
+
+    printf("snapshot publication: 1 writer, %d readers, %zu B snapshot, %s\n", READERS,
+           sizeof(vps_fusion_snapshot_t), hz > 0 ? "paced writer" : "unpaced writer");
+    run(&sh, false, hz, seconds);
+    run(&sh, true, hz, seconds);
+    pthread_mutex_destroy(&sh.mu);
+    return 0;
+}
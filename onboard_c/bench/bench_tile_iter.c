@@ -0,0 +1,109 @@
+/**
+ * @file bench_tile_iter.c
+ * @brief Candidate tiles around a point: bounding-box fill vs the lazy
+ *        distance-ordered iterator.
+ *
+ * Usage: bench_tile_iter [calls]
+ *
+ * The baseline is the previous vps_tiles_in_radius: fill the whole
+ * lat/lon bounding box into a buffer, column-major, no circle test. The
+ * iterator runs the same circle to the end, then stops after ring 3 (the
+ * 7x7 tiles a retrieval step usually needs first), and runs a 3-sigma
+ * EKF ellipse elongated 4:1 with the radius as its semi-major axis.
+ * z19 tiles are about 52 m across at the test point, so 5 km is about
+ * 100 rings.
+ */
+#include "bench_common.h"
+#include "tile_iter.h"
+#include "tile_math.h"
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define ZOOM 19
+#define MAX_TILES (1 << 18)
+
+static vps_tile_coord_t buf[MAX_TILES];
+
+/* vps_tiles_in_radius before the iterator */
+static int bbox_fill(vps_geopoint_t center, double radius_km, int zoom,
+                     vps_tile_coord_t *out, int max_out) {
+    double dlat = radius_km / 111.32;
+    double dlon = radius_km / (111.32 * cos(center.lat * M_PI / 180.0));
+    vps_tile_coord_t t_nw = vps_gps_to_tile((vps_geopoint_t){center.lat + dlat,
+                                                             center.lon - dlon}, zoom);
+    vps_tile_coord_t t_se = vps_gps_to_tile((vps_geopoint_t){center.lat - dlat,
+                                                             center.lon + dlon}, zoom);
+    int count = 0;
+    for (int x = t_nw.x; x <= t_se.x && count < max_out; x++)
+        for (int y = t_nw.y; y <= t_se.y && count < max_out; y++)
+            out[count++] = (vps_tile_coord_t){zoom, x, y};
+    return count;
+}
+
+static int drain(vps_tile_iter_t *it) {
+    int n = 0;
+    while (vps_tile_iter_next(it, &buf[n & (MAX_TILES - 1)])) n++;
+    return n;
+}
+
+int main(int argc, char **argv) {
+    int calls = argc > 1 ? atoi(argv[1]) : 200;
+    if (calls < 1) calls = 1;
+    static const double radii_m[] = {100.0, 1000.0, 5000.0};
+    vps_geopoint_t p = {47.3977, 8.5456};
+    double *ns = malloc(sizeof(double) * (size_t)calls);
+    if (!ns) return 1;
+
+    printf("tile candidates at z%d, %d calls per case (us per call)\n", ZOOM, calls);
+    printf("%-8s %-14s %9s %10s\n", "radius", "case", "tiles", "us");
+    for (int r = 0; r < 3; r++) {
+        double sigma_deg = radii_m[r] / 3.0 / 111320.0;
+        vps_ekf_state_t ekf;
+        memset(&ekf, 0, sizeof(ekf));
+        ekf.x[0] = p.lat;
+        ekf.x[1] = p.lon;
+        /* 4:1 ellipse at 45 degrees, semi-major axis the radius */
+        double clat = cos(p.lat * M_PI / 180.0), a2 = sigma_deg * sigma_deg, b2 = a2 / 16.0;
+        ekf.P[0][0] = (a2 + b2) / 2.0;
+        ekf.P[1][1] = (a2 + b2) / 2.0 / (clat * clat);
+        ekf.P[0][1] = ekf.P[1][0] = (a2 - b2) / 2.0 / clat;
+
+        static const char *names[] = {"bbox_fill", "iter_all", "iter_3_rings", "iter_ellipse"};
+        double mean[4];
+        int tiles[4] = {0};
+        for (int c = 0; c < 4; c++) {
+            for (int i = 0; i < calls; i++) {
+                vps_tile_iter_t it;
+                uint64_t t0 = bench_now_ns();
+                switch (c) {
+                case 0:
+                    tiles[c] = bbox_fill(p, radii_m[r] / 1000.0, ZOOM, buf, MAX_TILES);
+                    break;
+                case 1:
+                    vps_tile_iter_circle(&it, p, radii_m[r], ZOOM);
+                    tiles[c] = drain(&it);
+                    break;
+                case 2:
+                    vps_tile_iter_circle(&it, p, radii_m[r], ZOOM);
+                    if (it.max_ring > 3) it.max_ring = 3;
+                    tiles[c] = drain(&it);
+                    break;
+                default:
+                    vps_tile_iter_ellipse(&it, &ekf, 3.0, ZOOM);
+                    tiles[c] = drain(&it);
+                }
+                ns[i] = (double)(bench_now_ns() - t0);
+                bench_sink(buf);
+            }
+            mean[c] = 0.0;
+            for (int i = 0; i < calls; i++) mean[c] += ns[i] / calls;
+            printf("%-8.0f %-14s %9d %10.2f\n", radii_m[r], names[c], tiles[c], mean[c] / 1e3);
+        }
+    }
+    free(ns);
+    return 0;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file bench_tile_key.c
+ * @brief Tile map startup and lookup cost for 1M- and 4M-tile packs.
+ *
+ * Usage: bench_tile_key [lookups]
+ *
+ * A pack is a square of z19 tiles plus its pyramid up to z14 (1.4M and
+ * 5.6M tiles). Startup is keying the tile list and building the map.
+ * Lookups are random tiles of the pack: independent (throughput),
+ * dependent (each key chosen by the previous value, so latency), batched
+ * with prefetch, misses, a 3x3 neighbourhood and a walk up the pyramid.
+ * A sorted key array with binary search is the baseline.
+ */
+#include "bench_common.h"
+#include "tile_key.h"
+
+#define BATCH 64
+
+static int cmp_key(const void *a, const void *b) {
+    vps_tile_key_t x = *(const vps_tile_key_t *)a, y = *(const vps_tile_key_t *)b;
+    return (x > y) - (x < y);
+}
+
+static bool bsearch_key(const vps_tile_key_t *sorted, int n, vps_tile_key_t key) {
+    return bsearch(&key, sorted, (size_t)n, sizeof(key), cmp_key) != NULL;
+}
+
+static double ms_since(uint64_t t0) {
+    return (double)(bench_now_ns() - t0) / 1e6;
+}
+
+static void run_pack(int side, int lookups) {
+    int n = 0;
+    for (int s = side; s >= side >> 5; s /= 2) n += s * s;
+    vps_tile_coord_t *tiles = malloc(sizeof(vps_tile_coord_t) * (size_t)n);
+    vps_tile_key_t *keys = malloc(sizeof(vps_tile_key_t) * (size_t)n);
+    vps_tile_key_t *sorted = malloc(sizeof(vps_tile_key_t) * (size_t)n);
+    vps_tile_key_t *q = malloc(sizeof(vps_tile_key_t) * (size_t)lookups);
+    uint32_t *vals = malloc(sizeof(uint32_t) * (size_t)lookups);
+    int samples = lookups / BATCH;
+    double *ns = malloc(sizeof(double) * (size_t)samples);
+    if (!tiles || !keys || !sorted || !q || !vals || !ns) exit(1);
+    n = 0;
+    for (int z = 19, s = side; s >= side >> 5; z--, s /= 2)
+        for (int y = 0; y < s; y++)
+            for (int x = 0; x < s; x++)
+                tiles[n++] = (vps_tile_coord_t){z, (274000 >> (19 - z)) + x,
+                                                (183000 >> (19 - z)) + y};
+    printf("\npack: %d tiles (z19 %dx%d + pyramid to z14)\n", n, side, side);
+
+    /* Startup */
+    uint64_t t0 = bench_now_ns();
+    for (int i = 0; i < n; i++) keys[i] = vps_tile_key(tiles[i]);
+    double key_ms = ms_since(t0);
+    vps_tile_map_t m;
+    t0 = bench_now_ns();
+    if (!vps_tile_map_build(&m, keys, n)) exit(1);
+    double build_ms = ms_since(t0);
+    t0 = bench_now_ns();
+    for (int i = 0; i < n; i++) sorted[i] = keys[i];
+    qsort(sorted, (size_t)n, sizeof(vps_tile_key_t), cmp_key);
+    double sort_ms = ms_since(t0);
+    printf("startup: keys %.1f ms, map build %.1f ms (%.1f ns/tile, %zu MB slots), "
+           "sorted baseline %.1f ms\n", key_ms, build_ms, build_ms * 1e6 / n,
+           (m.mask + 1) * sizeof(vps_tile_slot_t) >> 20, sort_ms);
+
+    unsigned seed = 11;
+    for (int i = 0; i < lookups; i++) q[i] = keys[bench_rand_u32(&seed) % (uint32_t)n];
+    uint32_t v = 0, acc = 0;
+    for (int c = 0; c < 7; c++) {
+        static const char *names[] = {"hit", "hit_dependent", "hit_batch", "miss",
+                                      "neighbors_3x3", "parents_to_z14", "bsearch_hit"};
+        for (int s = 0; s < samples; s++) {
+            const vps_tile_key_t *b = q + s * BATCH;
+            uint64_t t = bench_now_ns();
+            switch (c) {
+            case 0:
+                for (int i = 0; i < BATCH; i++) acc += vps_tile_map_get(&m, b[i], &v) + v;
+                break;
+            case 1:
+                for (int i = 0; i < BATCH; i++) {
+                    vps_tile_map_get(&m, keys[(v + (uint32_t)i * 2654435761u) % (uint32_t)n], &v);
+                    acc += v;
+                }
+                break;
+            case 2:
+                acc += (uint32_t)vps_tile_map_get_batch(&m, b, BATCH, vals + s * BATCH);
+                break;
+            case 3:
+                for (int i = 0; i < BATCH; i++) acc += vps_tile_map_get(&m, b[i] ^ 1ull << 50, &v);
+                break;
+            case 4:
+                for (int i = 0; i < BATCH; i++)
+                    for (int dy = -1; dy <= 1; dy++)
+                        for (int dx = -1; dx <= 1; dx++) {
+                            vps_tile_key_t k;
+                            if (vps_tile_key_neighbor(b[i], dx, dy, &k))
+                                acc += vps_tile_map_get(&m, k, &v);
+                        }
+                break;
+            case 5:
+                for (int i = 0; i < BATCH; i++)
+                    for (vps_tile_key_t k = b[i]; vps_tile_key_zoom(k) >= 14;
+                         k = vps_tile_key_parent(k))
+                        acc += vps_tile_map_get(&m, k, &v);
+                break;
+            default:
+                for (int i = 0; i < BATCH; i++) acc += bsearch_key(sorted, n, b[i]);
+            }
+            ns[s] = (double)(bench_now_ns() - t) / BATCH;
+        }
+        bench_report(names[c], ns, samples, "ns");
+    }
+    bench_sink(&acc);
+    vps_tile_map_free(&m);
+    free(tiles);
+    free(keys);
+    free(sorted);
+    free(q);
+    free(vals);
+    free(ns);
+}
+
+int main(int argc, char **argv) {
+    int lookups = argc > 1 ? atoi(argv[1]) : 1 << 20;
+    if (lookups < BATCH) lookups = BATCH;
+    printf("tile map, %d lookups per case (ns per lookup; per tile for neighbours/parents"
+           " is 9 and 6 lookups)\n", lookups);
+    run_pack(1024, lookups);
+    run_pack(2048, lookups);
+    return 0;
+}
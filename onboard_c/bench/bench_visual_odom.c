@@ -0,0 +1,110 @@
+/**
+ * @file bench_visual_odom.c
+ * @brief Per-frame visual odometry cost at 640x640.
+ *
+ * Usage: bench_visual_odom [frames] [levels] [grid]
+ *
+ * Renders a synthetic nadir flight (textured ground, 1.5 m/frame
+ * forward, slow yaw) and times vps_vo_process per frame, i.e. pyramid,
+ * corner selection, forward + backward LK and the similarity fit. The
+ * budget line compares the median with 30 Hz camera frames.
+ */
+#include "bench_common.h"
+#include "visual_odom.h"
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define G 2048
+#define S 640
+
+static uint8_t ground[G * G];
+
+static void make_ground(void) {
+    static uint8_t tmp[G * G];
+    unsigned seed = 5;
+    for (int i = 0; i < G * G; i++) ground[i] = (uint8_t)(bench_rand_next(&seed) >> 24);
+    for (int y = 1; y < G - 1; y++)
+        for (int x = 1; x < G - 1; x++) {
+            int s = 0;
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++) s += ground[(y + dy) * G + x + dx];
+            int v = 128 + 3 * (s / 9 - 128);
+            tmp[y * G + x] = (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+        }
+    memcpy(ground, tmp, sizeof(tmp));
+}
+
+static void render(uint8_t *img, double gx, double gy, double heading_deg) {
+    double h = heading_deg * M_PI / 180.0, c = cos(h), s = sin(h);
+    for (int v = 0; v < S; v++)
+        for (int u = 0; u < S; u++) {
+            double a = u - (S - 1) * 0.5, b = v - (S - 1) * 0.5;
+            double x = gx + a * c - b * s, y = gy + a * s + b * c;
+            int ix = (int)x, iy = (int)y;
+            double fx = x - ix, fy = y - iy;
+            const uint8_t *p = ground + iy * G + ix;
+            img[v * S + u] = (uint8_t)((1 - fy) * ((1 - fx) * p[0] + fx * p[1]) +
+                                       fy * ((1 - fx) * p[G] + fx * p[G + 1]) + 0.5);
+        }
+}
+
+int main(int argc, char **argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 60;
+    vps_vo_config_t cfg = vps_vo_default_config();
+    if (argc > 2) cfg.levels = atoi(argv[2]);
+    if (argc > 3) cfg.grid = atoi(argv[3]);
+    if (frames < 2) frames = 2;
+
+    make_ground();
+    vps_vo_t vo;
+    if (!vps_vo_init(&vo, &cfg, S, S)) return 1;
+    uint8_t *img = malloc((size_t)S * S);
+    double *ms = malloc(sizeof(double) * (size_t)frames);
+    if (!img || !ms) return 1;
+
+    double gx = 1024.0, gy = 1300.0, heading = 10.0;
+    double sum_n = 0.0, sum_e = 0.0, x0 = 0.0, y0 = 0.0, rms = 0.0;
+    int n = 0, tracked = 0, inliers = 0;
+    for (int k = 0; k < frames; k++) {
+        double h = heading * M_PI / 180.0;
+        gx += 7.5 * sin(h);   /* 1.5 m at 0.2 m/px */
+        gy -= 7.5 * cos(h);
+        heading += 0.3;
+        render(img, gx, gy, heading);
+
+        vps_vo_motion_t m;
+        uint64_t t0 = bench_now_ns();
+        bool ok = vps_vo_process(&vo, img, S, 100.0, heading, &m);
+        double dt = (double)(bench_now_ns() - t0) * 1e-6;
+        if (k == 0) {
+            x0 = gx;   /* the first frame only primes the pyramid */
+            y0 = gy;
+            continue;
+        }
+        ms[n++] = dt;
+        if (ok) {
+            sum_n += m.dn_m;
+            sum_e += m.de_m;
+            tracked += m.tracked;
+            inliers += m.inliers;
+            rms += m.rms_px;
+        }
+    }
+    double true_n = -(gy - y0) * 0.2, true_e = (gx - x0) * 0.2;
+
+    printf("visual odometry %dx%d, %s kernels, %d levels, grid %d\n", S, S, vps_vo_isa(),
+           cfg.levels, cfg.grid);
+    bench_report("vo_process", ms, n, "ms");
+    printf("  tracked %.1f, inliers %.1f, rms %.3f px per frame\n", (double)tracked / n,
+           (double)inliers / n, rms / n);
+    printf("  path %.2f m N %.2f m E, truth %.2f m N %.2f m E\n", sum_n, sum_e, true_n, true_e);
+    printf("  30 Hz budget: %.1f%% of 33.3 ms (median)\n", 100.0 * ms[n / 2] / 33.333);
+    vps_vo_free(&vo);
+    free(img);
+    free(ms);
+    return 0;
+}
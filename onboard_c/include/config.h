@@ -0,0 +1,70 @@
+/**
+ * @file config.h
+ * @brief Runtime configuration (mirrors onboard.config.VPSConfig).
+ *
+ * Reads the same /opt/vps/config.json the Python service uses. Unknown
+ * keys are ignored so both runtimes can share one file.
+ */
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include "vps_types.h"
+
+#define VPS_CONFIG_PATH_MAX 256
+#define VPS_CONFIG_DEFAULT_PATH "/opt/vps/config.json"
+
+/** Camera capture settings. */
+typedef struct {
+    char device[VPS_CONFIG_PATH_MAX];  /* "0" or /dev/videoN */
+    int width;
+    int height;
+    int fps;
+    bool use_picamera2;
+} vps_camera_config_t;
+
+/** UART output settings for flight controller. */
+typedef struct {
+    char port[VPS_CONFIG_PATH_MAX];
+    int baudrate;
+    bool enabled;
+} vps_uart_config_t;
+
+/** Feature matching pipeline settings. */
+typedef struct {
+    char superpoint_onnx[VPS_CONFIG_PATH_MAX];
+    char lightglue_onnx[VPS_CONFIG_PATH_MAX];
+    int min_matches;              /* minimum inlier matches to accept a fix */
+    double confidence_threshold;  /* minimum inlier ratio */
+    int max_candidates;           /* top-k tiles from retrieval */
+    bool use_orb_fallback;
+} vps_matcher_config_t;
+
+/** Top-level configuration. */
+typedef struct {
+    char map_pack[VPS_CONFIG_PATH_MAX];
+    vps_camera_config_t camera;
+    vps_uart_config_t uart;
+    vps_matcher_config_t matcher;
+    double target_hz;
+    char log_level[16];
+    double ekf_measurement_noise;  /* deg^2 */
+    double ekf_gate_threshold;
+    char telemetry_dir[VPS_CONFIG_PATH_MAX];  /* empty = disabled */
+} vps_config_t;
+
+/** Fill config with the VPSConfig defaults. */
+void vps_config_defaults(vps_config_t *cfg);
+
+/**
+ * Parse a JSON document on top of the current values in cfg.
+ * @return true on success; on a syntax error cfg may be partially updated
+ */
+bool vps_config_parse(vps_config_t *cfg, const char *json);
+
+/**
+ * Load config from a JSON file on top of the current values in cfg.
+ * @return false if the file cannot be read or parsed
+ */
+bool vps_config_load(vps_config_t *cfg, const char *path);
+
+#endif /* CONFIG_H */
@@ -5,6 +5,7 @@
 #ifndef DEAD_RECKONING_H
 #define DEAD_RECKONING_H
 
+#include "local_frame.h"
 #include "vps_types.h"
 
 typedef struct {
@@ -16,15 +17,33 @@ typedef struct {
     double hdop_growth_rate;
     double max_extrap_s;
     bool has_reference;
+    bool odometry;      /* reference advanced by odometry since the last fix */
+    const vps_local_frame_t *frame;  /* NULL: 111320 m/deg and cos(lat) */
 } vps_dr_state_t;
 
 /** Initialize dead reckoning state. */
 void vps_dr_init(vps_dr_state_t *dr, double max_extrap_s, double hdop_growth_rate);
 
+/**
+ * Convert metres to degrees with the frame's scales instead of calling
+ * cos() per update. NULL (as after vps_dr_init) restores the default.
+ */
+void vps_dr_set_frame(vps_dr_state_t *dr, const vps_local_frame_t *frame);
+
 /** Update reference position and velocity. */
 void vps_dr_update_ref(vps_dr_state_t *dr, vps_geopoint_t pos,
                        double vn, double ve, double hdop, double t);
 
+/**
+ * Advance the reference by a measured displacement (e.g. visual
+ * odometry) observed between the reference time and t. Velocity becomes
+ * the displacement rate, HDOP grows by hdop_add, and max_extrap_s then
+ * counts from t.
+ * @return false without a reference or if t is not after ref_t
+ */
+bool vps_dr_apply_odometry(vps_dr_state_t *dr, double dn_m, double de_m,
+                           double hdop_add, double t);
+
 /**
  * Extrapolate position at time t.
  * @param pos_out output position
@@ -4,10 +4,15 @@
  *
  * State: [lat, lon, vlat, vlon]
  * Constant-velocity motion model with Mahalanobis gating.
+ *
+ * vps_ekf_update runs a structure-exploiting kernel on the packed upper
+ * triangle of P; vps_ekf_update_dense is the original dense 4x4
+ * formulation, kept as the reference.
  */
 #ifndef EKF_H
 #define EKF_H
 
+#include "local_frame.h"
 #include "vps_types.h"
 
 /** EKF configuration. */
@@ -27,6 +32,35 @@ typedef struct {
     double last_gate; /* last Mahalanobis distance */
 } vps_ekf_state_t;
 
+/** Packed upper triangle of the symmetric P: 00 01 02 03 11 12 13 22 23 33. */
+#define VPS_EKF_PACKED 10
+
+/** Default depth of the measurement history (10 s at 3 Hz). */
+#define VPS_EKF_HISTORY_DEFAULT 32
+#define VPS_EKF_HISTORY_MAX 64
+
+/** One fused measurement and the filter state right after it. */
+typedef struct {
+    double t;                 /* capture timestamp */
+    vps_geopoint_t z;
+    double hdop;
+    bool accepted;
+    vps_ekf_state_t post;
+} vps_ekf_history_entry_t;
+
+/**
+ * Ring buffer of past measurements and posterior states for
+ * out-of-sequence updates. Fixed size, no allocation.
+ */
+typedef struct {
+    vps_ekf_history_entry_t entries[VPS_EKF_HISTORY_MAX];
+    int depth;     /* retained entries (<= VPS_EKF_HISTORY_MAX) */
+    int start;     /* index of the oldest entry */
+    int count;
+    double last_latency;  /* arrival - capture of the last measurement */
+    uint32_t replayed;    /* measurements re-fused by the last update */
+} vps_ekf_history_t;
+
 /** Initialize EKF with default config. */
 vps_ekf_config_t vps_ekf_default_config(void);
 
@@ -43,6 +77,95 @@ void vps_ekf_reset(vps_ekf_state_t *state);
 bool vps_ekf_update(vps_ekf_state_t *state, const vps_ekf_config_t *cfg,
                     vps_geopoint_t measurement, double hdop, double t);
 
+/** Dense reference implementation of vps_ekf_update (same semantics). */
+bool vps_ekf_update_dense(vps_ekf_state_t *state, const vps_ekf_config_t *cfg,
+                          vps_geopoint_t measurement, double hdop, double t);
+
+/** Copy the upper triangle of P (row-major 4x4, &P[0][0]) into packed form. */
+void vps_ekf_pack_cov(double p[VPS_EKF_PACKED], const double *P);
+
+/** Expand packed covariance into a full symmetric matrix. */
+void vps_ekf_unpack_cov(double P[4][4], const double p[VPS_EKF_PACKED]);
+
+/** Closed-form predict: x = F x, P = F P F' + Q(q, dt). */
+void vps_ekf_propagate(double x[4], double p[VPS_EKF_PACKED], double q, double dt);
+
+/**
+ * Closed-form position update with measurement noise r (deg²).
+ * x and p are only modified if the Mahalanobis distance is within gate.
+ * @return Mahalanobis distance (INFINITY if S is singular)
+ */
+double vps_ekf_correct(double x[4], double p[VPS_EKF_PACKED],
+                       vps_geopoint_t z, double r, double gate);
+
+/**
+ * Information-form sum of position fixes taken at the same time. With
+ * H = [I 0] and R = r·I each fix adds 1/r to the lat/lon information and
+ * z/r to the information vector, so any number of fixes collapses to one
+ * equivalent fix (z = Σ(z/r) / Σ(1/r), r = 1 / Σ(1/r)). Applying that
+ * with vps_ekf_correct is the information update P⁺ = (P⁻¹ + Σ H'R⁻¹H)⁻¹
+ * with a single 2x2 inversion.
+ */
+typedef struct {
+    double w;        /* Σ 1/r */
+    double wz[2];    /* Σ z/r (lat, lon) */
+    int n;
+} vps_ekf_info_t;
+
+void vps_ekf_info_clear(vps_ekf_info_t *info);
+
+/** Add a fix with measurement noise r (deg²). */
+void vps_ekf_info_add(vps_ekf_info_t *info, vps_geopoint_t z, double r);
+
+/** Equivalent single fix. @return false if nothing was added */
+bool vps_ekf_info_fix(const vps_ekf_info_t *info, vps_geopoint_t *z, double *r);
+
+/**
+ * Gate n fixes taken at time t against the prediction and combine the
+ * accepted ones (see vps_ekf_info_t). Does not modify the state. Before
+ * the first fix, or after a gap longer than max_gap_s, nothing can be
+ * gated and every fix is accepted.
+ * @param accepted per-fix gate result (may be NULL)
+ * @param z, hdop  combined fix, hdop such that R = measurement_noise·hdop²
+ * @return number of fixes combined
+ */
+int vps_ekf_combine_batch(const vps_ekf_state_t *state, const vps_ekf_config_t *cfg,
+                          const vps_geopoint_t *fixes, const double *hdops, int n,
+                          double t, bool *accepted, vps_geopoint_t *z, double *hdop);
+
+/**
+ * Fuse n fixes taken at time t in one step: each is gated individually,
+ * the accepted ones are applied together in information form. Same
+ * result as sequential vps_ekf_update calls when nothing is gated out.
+ * With no accepted fix the filter still advances to t.
+ * @return number of fixes fused
+ */
+int vps_ekf_update_batch(vps_ekf_state_t *state, const vps_ekf_config_t *cfg,
+                         const vps_geopoint_t *fixes, const double *hdops, int n,
+                         double t, bool *accepted);
+
+/** Initialize an empty history retaining up to depth measurements. */
+void vps_ekf_history_init(vps_ekf_history_t *h, int depth);
+
+/** Drop all retained measurements. */
+void vps_ekf_history_clear(vps_ekf_history_t *h);
+
+/**
+ * Update with a measurement captured at t_capture and received at
+ * t_arrival. A measurement older than the filter time is fused at its
+ * capture timestamp: the state is rolled back to the newest retained
+ * entry at or before t_capture, the measurement is applied, and every
+ * later retained measurement is re-applied. In-order measurements cost
+ * the same as vps_ekf_update. state must only be updated through this
+ * function while h is in use.
+ * @return false if gated out, captured after arrival, or older than the
+ *         oldest retained entry (state unchanged in the last two cases)
+ */
+bool vps_ekf_update_delayed(vps_ekf_state_t *state, vps_ekf_history_t *h,
+                            const vps_ekf_config_t *cfg,
+                            vps_geopoint_t measurement, double hdop,
+                            double t_capture, double t_arrival);
+
 /** Predict position at time t (without measurement). */
 vps_geopoint_t vps_ekf_predict(const vps_ekf_state_t *state, double t);
 
@@ -52,6 +175,9 @@ vps_velocity_t vps_ekf_velocity(const vps_ekf_state_t *state);
 /** Get current speed in m/s. */
 double vps_ekf_speed(const vps_ekf_state_t *state);
 
+/** vps_ekf_speed with the frame's metres per degree (no trig). */
+double vps_ekf_speed_local(const vps_ekf_state_t *state, const vps_local_frame_t *frame);
+
 /** Get current position estimate. */
 vps_geopoint_t vps_ekf_position(const vps_ekf_state_t *state);
 
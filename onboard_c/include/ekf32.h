@@ -0,0 +1,98 @@
+/**
+ * @file ekf32.h
+ * @brief Single-precision EKF on a local north/east tangent plane.
+ *
+ * Same constant-velocity model and semantics as vps_ekf_update, but the
+ * state is float32 meters (n, e, vn, ve) relative to a double-precision
+ * origin. The degree-space filter maps onto it with the diagonal scale
+ * T = diag(a, b, a, b), a = 111320 m/deg, b = a·cos(lat0), so Q and R are
+ * scaled per axis and Mahalanobis gating is unchanged: the two filters
+ * agree up to float rounding.
+ *
+ * The origin moves to the current position once the state drifts more
+ * than reanchor_m away, which keeps positions small enough that float32
+ * resolves them to well under a millimetre. Without double promotion the
+ * kernels map onto float32x4 NEON lanes on Cortex-A.
+ */
+#ifndef EKF32_H
+#define EKF32_H
+
+#include "ekf.h"
+
+#define VPS_EKF32_REANCHOR_DEFAULT_M 1000.0
+
+typedef struct {
+    double lat0, lon0;     /* origin */
+    double m_lat, m_lon;   /* meters per degree at the origin */
+    float x[4];            /* n, e (m), vn, ve (m/s) */
+    float p[VPS_EKF_PACKED];
+    double last_t;
+    bool initialized;
+    float last_gate;
+    double reanchor_m;
+    uint32_t reanchors;
+} vps_ekf32_t;
+
+/** Initialize (uninitialized). reanchor_m <= 0 selects the default. */
+void vps_ekf32_init(vps_ekf32_t *f, double reanchor_m);
+
+/** vps_ekf_update in the local frame (same return and gating rules). */
+bool vps_ekf32_update(vps_ekf32_t *f, const vps_ekf_config_t *cfg,
+                      vps_geopoint_t measurement, double hdop, double t);
+
+/** Move the origin to the current position (done automatically). */
+void vps_ekf32_reanchor(vps_ekf32_t *f);
+
+/** Predicted position at time t ({0, 0} if uninitialized). */
+vps_geopoint_t vps_ekf32_predict(const vps_ekf32_t *f, double t);
+
+/** Current position ({0, 0} if uninitialized). */
+vps_geopoint_t vps_ekf32_position(const vps_ekf32_t *f);
+
+/** Current speed in m/s. */
+double vps_ekf32_speed(const vps_ekf32_t *f);
+
+/** Express the filter as a degree-space state (for code built on vps_ekf_state_t). */
+void vps_ekf32_to_state(const vps_ekf32_t *f, vps_ekf_state_t *s);
+
+/** Load a degree-space state, anchoring the origin at its position. */
+void vps_ekf32_from_state(vps_ekf32_t *f, const vps_ekf_state_t *s);
+
+/** Float kernels: per-axis process noise qn/qe and measurement noise rn/re. */
+void vps_ekf32_propagate(float x[4], float p[VPS_EKF_PACKED], float qn, float qe, float dt);
+float vps_ekf32_correct(float x[4], float p[VPS_EKF_PACKED], float zn, float ze,
+                        float rn, float re, float gate);
+
+/**
+ * Float32 counterpart of vps_ekf_bank_t: twice the lanes per vector
+ * (8 with AVX2, 4 with NEON) for the same kernel, in local-frame units.
+ */
+#define VPS_EKF32_BANK_MAX 64
+
+typedef struct {
+    _Alignas(32) float x[4][VPS_EKF32_BANK_MAX];
+    _Alignas(32) float p[VPS_EKF_PACKED][VPS_EKF32_BANK_MAX];
+    int n;
+} vps_ekf32_bank_t;
+
+/** Zero all lanes and set the active lane count (clamped to the max). */
+void vps_ekf32_bank_init(vps_ekf32_bank_t *b, int n);
+
+/** Copy the filter state into lanes [0, n). */
+void vps_ekf32_bank_broadcast(vps_ekf32_bank_t *b, const vps_ekf32_t *f, int n);
+
+/** Propagate every lane by dt. */
+void vps_ekf32_bank_propagate(vps_ekf32_bank_t *b, float qn, float qe, float dt);
+
+/**
+ * Gate and update every lane with its own local-frame measurement
+ * (same rules as vps_ekf_bank_correct).
+ * @return number of lanes that passed the gate
+ */
+int vps_ekf32_bank_correct(vps_ekf32_bank_t *b, const float *zn, const float *ze,
+                           const float *rn, const float *re, float gate, float *d_out);
+
+/** Instruction set of the float lanes: "avx2", "neon" or "scalar". */
+const char *vps_ekf32_bank_isa(void);
+
+#endif /* EKF32_H */
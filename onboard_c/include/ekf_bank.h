@@ -0,0 +1,67 @@
+/**
+ * @file ekf_bank.h
+ * @brief Structure-of-arrays bank of 4-state EKFs updated in SIMD lanes.
+ *
+ * Each lane holds one hypothesis (state + packed covariance). Gate and
+ * update for all lanes run in one call: AVX2 (4 lanes/instruction) when
+ * built with -mavx2, NEON (2 lanes) on aarch64, scalar otherwise. The
+ * math is the closed-form kernel of vps_ekf_correct, lane by lane.
+ *
+ * Typical use is scoring candidate fixes: broadcast the current filter
+ * into n lanes, propagate to the frame time, correct lane i with
+ * candidate i and pick the smallest Mahalanobis distance.
+ */
+#ifndef EKF_BANK_H
+#define EKF_BANK_H
+
+#include "ekf.h"
+
+#define VPS_EKF_BANK_MAX 64
+
+typedef struct {
+    _Alignas(32) double x[4][VPS_EKF_BANK_MAX];
+    _Alignas(32) double p[VPS_EKF_PACKED][VPS_EKF_BANK_MAX];
+    int n;
+} vps_ekf_bank_t;
+
+/** Zero all lanes and set the active lane count (clamped to the max). */
+void vps_ekf_bank_init(vps_ekf_bank_t *b, int n);
+
+/** Copy one filter state into lanes [0, n). */
+void vps_ekf_bank_broadcast(vps_ekf_bank_t *b, const vps_ekf_state_t *s, int n);
+
+/** Set / get a single lane. */
+void vps_ekf_bank_set(vps_ekf_bank_t *b, int lane, const double x[4],
+                      const double p[VPS_EKF_PACKED]);
+void vps_ekf_bank_get(const vps_ekf_bank_t *b, int lane, double x[4],
+                      double p[VPS_EKF_PACKED]);
+
+/** Propagate every lane by dt (same q, dt for all lanes). */
+void vps_ekf_bank_propagate(vps_ekf_bank_t *b, double q, double dt);
+
+/**
+ * Propagate lane i with its own motion model: process noise q[i] and
+ * velocity retention a[i] over dt (v ← a·v, position still integrates
+ * the prior velocity; a = 1 is the constant-velocity model).
+ */
+void vps_ekf_bank_propagate_models(vps_ekf_bank_t *b, const double *q,
+                                   const double *a, double dt);
+
+/**
+ * Gate and update every lane with its own measurement.
+ * Lanes whose distance exceeds gate keep their prior.
+ * @param z_lat, z_lon, r per-lane measurement and noise (n entries)
+ * @param d_out per-lane Mahalanobis distance (INFINITY if S singular)
+ * @return number of lanes that passed the gate
+ */
+int vps_ekf_bank_correct(vps_ekf_bank_t *b, const double *z_lat,
+                         const double *z_lon, const double *r,
+                         double gate, double *d_out);
+
+/** Index of the smallest distance within gate, -1 if none. */
+int vps_ekf_bank_best(const double *d, int n, double gate);
+
+/** Instruction set the bank was compiled for: "avx2", "neon" or "scalar". */
+const char *vps_ekf_bank_isa(void);
+
+#endif /* EKF_BANK_H */
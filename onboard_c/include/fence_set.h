@@ -0,0 +1,115 @@
+/**
+ * @file fence_set.h
+ * @brief One inclusion fence plus many exclusion zones behind a BVH.
+ *
+ * Exclusion zones (airports, restricted areas) are circle, rect or
+ * polygon geofences whose margin is a keep-out distance. Their lat/lon
+ * bounding boxes, grown by the margin, go into a bounding-volume
+ * hierarchy (median split on the longer axis, up to VPS_FENCE_SET_LEAF
+ * zones per leaf), so a point only meets the zones whose boxes hold it.
+ *
+ * Clearance is the distance to the nearest violation: for the inclusion
+ * fence its distance to the boundary minus the margin, for an exclusion
+ * zone the distance from the zone minus the keep-out margin. A position
+ * is clear when every clearance is >= 0. The nearest violation is found
+ * branch and bound over the BVH, pruning boxes by a lower bound on their
+ * distance. Batches (e.g. a predicted trajectory) seed each search with
+ * the previous point's nearest zone.
+ *
+ * Zone files ("VPSZ", written by `vps-program build-fences`):
+ *   header  "<4sHHI"   magic, version, reserved, zone count
+ *   zone    "<BBHii3fI" type, role, ring count, centre lat/lon * 1e7,
+ *                       radius or half_lat km, half_lon km, margin km, id
+ *   polygon zones follow with ring_count u32 ring lengths and then
+ *   (lat, lon) * 1e7 i32 pairs. All fields little-endian.
+ */
+#ifndef FENCE_SET_H
+#define FENCE_SET_H
+
+#include "geofence.h"
+#include <stddef.h>
+
+#define VPS_ZONE_FILE_VERSION 1
+#define VPS_ZONE_HEADER_SIZE 12
+#define VPS_ZONE_RECORD_SIZE 28
+#define VPS_FENCE_SET_LEAF 4
+
+typedef enum {
+    VPS_ZONE_INCLUSION = 0,
+    VPS_ZONE_EXCLUSION = 1,
+} vps_zone_role_t;
+
+typedef struct {
+    vps_geofence_t fence;       /* margin_km is the keep-out distance */
+    uint32_t id;
+    double min_lat, min_lon, max_lat, max_lon;  /* grown box, set by vps_fence_set_build */
+} vps_fence_zone_t;
+
+typedef struct {
+    double min_lat, min_lon, max_lat, max_lon;  /* zone boxes grown by their margins */
+    int32_t first;              /* leaf: first zone; inner: right child (left is next) */
+    int32_t count;              /* zones in a leaf, 0 for inner nodes */
+} vps_bvh_node_t;
+
+typedef struct {
+    bool has_inclusion;
+    vps_fence_zone_t inclusion;
+    vps_fence_zone_t *zones;    /* exclusion zones in BVH leaf order */
+    int n_zones;
+    vps_bvh_node_t *nodes;
+    int n_nodes;
+    vps_geofence_poly_t *polys; /* polygons owned by the set (loaded files) */
+    int n_polys;
+} vps_fence_set_t;
+
+typedef struct {
+    bool ok;                    /* inside the inclusion fence and clear of every zone */
+    int zone;                   /* nearest violation: zone index, -1 inclusion, -2 none */
+    uint32_t zone_id;
+    double clearance_km;        /* negative while violating */
+} vps_fence_result_t;
+
+/**
+ * Build a set from zones (copied; polygon pointers stay borrowed).
+ * @param inclusion may be NULL (no inclusion fence)
+ * @return false on allocation failure
+ */
+bool vps_fence_set_build(vps_fence_set_t *set, const vps_fence_zone_t *inclusion,
+                         const vps_fence_zone_t *zones, int n_zones);
+
+/** Build a set from a zone file image. @return false if malformed */
+bool vps_fence_set_parse(vps_fence_set_t *set, const uint8_t *buf, size_t len);
+
+/** Load a zone file. */
+bool vps_fence_set_load(vps_fence_set_t *set, const char *path);
+
+/** Release the set (and polygons it owns). */
+void vps_fence_set_free(vps_fence_set_t *set);
+
+/** Inside the inclusion fence and clear of every exclusion zone. */
+bool vps_fence_set_contains(const vps_fence_set_t *set, vps_geopoint_t point);
+
+/** Nearest violation for one point. */
+vps_fence_result_t vps_fence_set_check(const vps_fence_set_t *set, vps_geopoint_t point);
+
+/**
+ * Check n points in order (e.g. a predicted trajectory).
+ * @param out per-point results (may be NULL)
+ * @return index of the first point that is not clear, -1 if all are
+ */
+int vps_fence_set_check_batch(const vps_fence_set_t *set, const vps_geopoint_t *points,
+                              int n, vps_fence_result_t *out);
+
+/**
+ * Earliest predicted breach of the inclusion fence or any exclusion
+ * zone along a straight track (see vps_geofence_time_to_breach). Only
+ * zones whose boxes meet the box swept by the track are swept.
+ * @param t_out    seconds to the breach, INFINITY if none within horizon_s
+ * @param zone_out zone index, -1 for the inclusion fence, -2 if none (may be NULL)
+ * @return true if a breach is predicted within horizon_s
+ */
+bool vps_fence_set_time_to_breach(const vps_fence_set_t *set, vps_geopoint_t point,
+                                  double vn_mps, double ve_mps, double radius_km,
+                                  double horizon_s, double *t_out, int *zone_out);
+
+#endif /* FENCE_SET_H */
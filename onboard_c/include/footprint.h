@@ -0,0 +1,79 @@
+/**
+ * @file footprint.h
+ * @brief Camera frame footprint on the ground and the tiles it covers.
+ *
+ * The footprint is the frame's four corners in global tile units at a
+ * zoom (tile x + pixel / 256, y down). It can come from the predicted
+ * drone → tile homography, or from the pose: the centre, altitude and
+ * heading with the camera intrinsics of src/onboard/altitude.py. In the
+ * pose case the camera looks straight down with the image top towards
+ * the nose, as in visual_odom.h, and the ground is flat at the centre's
+ * latitude.
+ *
+ * vps_footprint_tiles rasterizes the quadrilateral. It clips the quad
+ * to each tile row, then each row polygon to each tile column, and takes
+ * the area of what is left. Each covered tile comes with the fraction of
+ * its area under the frame. Matching can then load only these tiles,
+ * largest overlap first, instead of a fixed 3x3 neighbourhood.
+ */
+#ifndef FOOTPRINT_H
+#define FOOTPRINT_H
+
+#include "vps_types.h"
+
+#define VPS_FOOTPRINT_MAX_SPAN 64   /* tiles across; wider footprints are rejected */
+
+/** Camera intrinsics, as CameraIntrinsics in src/onboard/altitude.py. */
+typedef struct {
+    double focal_length_mm;   /* default 4.74 (RPi Camera Module 3) */
+    double sensor_width_mm;   /* default 6.287 */
+    int image_width_px;       /* default 640 */
+    int image_height_px;      /* default 480 */
+} vps_camera_t;
+
+/** Frame corners in global tile units: top-left, top-right, bottom-right, bottom-left. */
+typedef struct {
+    int zoom;
+    double x[4], y[4];
+} vps_footprint_t;
+
+/** One covered tile. */
+typedef struct {
+    vps_tile_coord_t tile;
+    double overlap;           /* fraction of the tile under the frame, (0, 1] */
+} vps_tile_cover_t;
+
+void vps_camera_default(vps_camera_t *cam);
+
+/**
+ * Footprint of a w x h frame through a drone → tile homography (row-major,
+ * tile pixels of `tile`, as vps_match_t.H), at a zoom.
+ * @return false if the corners straddle the horizon, the quad is not
+ *         convex, or it spans more than VPS_FOOTPRINT_MAX_SPAN tiles
+ */
+bool vps_footprint_from_homography(const double H[9], vps_tile_coord_t tile, int w, int h,
+                                   int zoom, vps_footprint_t *out);
+
+/**
+ * Footprint of a nadir frame centred on center at altitude_m, image top
+ * towards heading_deg (0 = north, clockwise), at a zoom.
+ * @return false for a non-positive altitude or focal length, or a
+ *         footprint over VPS_FOOTPRINT_MAX_SPAN tiles across
+ */
+bool vps_footprint_from_pose(vps_geopoint_t center, double altitude_m, double heading_deg,
+                             const vps_camera_t *cam, int zoom, vps_footprint_t *out);
+
+/** Area of the footprint in tiles. */
+double vps_footprint_area(const vps_footprint_t *fp);
+
+/**
+ * Tiles under the footprint, largest overlap first, at most max_out
+ * (the smallest overlaps are dropped). Columns wrap at the antimeridian
+ * and rows off the map are skipped. Each row only visits the columns its
+ * slice of the quad spans, so the cost is close to one clip per covered
+ * tile.
+ * @return number written
+ */
+int vps_footprint_tiles(const vps_footprint_t *fp, vps_tile_cover_t *out, int max_out);
+
+#endif /* FOOTPRINT_H */
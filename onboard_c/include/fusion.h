@@ -7,8 +7,14 @@
 
 #include "vps_types.h"
 #include "ekf.h"
+#include "ekf32.h"
+#include "imm.h"
 #include "dead_reckoning.h"
+#include "fence_set.h"
 #include "geofence.h"
+#include "imu_nav.h"
+#include "output_ring.h"
+#include <stddef.h>
 
 /** Fusion output for one frame. */
 typedef struct {
@@ -21,14 +27,24 @@ typedef struct {
     bool geofence_ok;
     bool ekf_accepted;
     bool has_position;
+    double model_prob[VPS_IMM_MODELS];  /* IMM model probabilities, 0 without IMM */
 } vps_fusion_output_t;
 
 /** Fusion engine state. */
 typedef struct {
     vps_ekf_state_t ekf;
     vps_ekf_config_t ekf_cfg;
+    vps_ekf_history_t hist;  /* for delayed (out-of-sequence) fixes */
+    vps_ekf32_t ekf32;       /* float32 local-frame filter (use_ekf32) */
+    bool use_ekf32;
+    vps_imm_t imm;           /* hover/cruise/turn models (use_imm) */
+    bool use_imm;
     vps_dr_state_t dr;
     vps_geofence_t *fence;  /* NULL if no geofence */
+    const vps_fence_set_t *zones;  /* NULL if no inclusion/exclusion zone set */
+    const vps_local_frame_t *frame;  /* NULL: per-call trig and haversine */
+    vps_imu_nav_t *imu;     /* NULL if no IMU feed */
+    vps_fusion_sink_t *sink; /* NULL if outputs are not encoded in place */
 } vps_fusion_t;
 
 /** Initialize fusion engine. */
@@ -40,7 +56,151 @@ vps_fusion_output_t vps_fusion_update(vps_fusion_t *f,
                                       const vps_geopoint_t *visual,
                                       double hdop, double t);
 
+/**
+ * Process n visual fixes of the same frame (e.g. overlapping tiles or
+ * zoom levels) in one EKF step: each is gated against the prediction and
+ * the accepted ones are fused together in information form (see
+ * vps_ekf_update_batch). The output hdop is that of the combined fix.
+ */
+vps_fusion_output_t vps_fusion_update_batch(vps_fusion_t *f,
+                                            const vps_geopoint_t *fixes,
+                                            const double *hdop, int n, double t);
+
+/**
+ * Process a visual fix captured at t_capture that became available at
+ * t_arrival. The fix is fused at its capture time (see
+ * vps_ekf_update_delayed) and the output describes t_arrival.
+ * visual may be NULL, which is the same as vps_fusion_update at t_arrival.
+ */
+vps_fusion_output_t vps_fusion_update_delayed(vps_fusion_t *f,
+                                              const vps_geopoint_t *visual,
+                                              double hdop, double t_capture,
+                                              double t_arrival);
+
+/**
+ * Score n candidate fixes against the EKF predicted to time t in one
+ * SIMD bank pass (see ekf_bank.h).
+ * @param d_out per-candidate Mahalanobis distance (may be NULL)
+ * @return index of the closest candidate within the gate, 0 if the
+ *         filter is not initialized, -1 if every candidate is gated out
+ */
+int vps_fusion_select(const vps_fusion_t *f, const vps_geopoint_t *fixes,
+                      const double *hdop, int n, double t, double *d_out);
+
+/**
+ * Use an IMU navigator for predictions between visual fixes. Accepted
+ * fixes re-anchor it; the caller keeps feeding it samples from the
+ * thread that calls vps_fusion_update. NULL detaches.
+ */
+void vps_fusion_attach_imu(vps_fusion_t *f, vps_imu_nav_t *imu);
+
+/**
+ * Run visual updates through the float32 local-frame filter (ekf32.h);
+ * ekf mirrors it so prediction, scoring and output are unchanged. In
+ * this mode delayed fixes are fused at arrival time (no history).
+ */
+void vps_fusion_use_ekf32(vps_fusion_t *f, bool on);
+
+/**
+ * Run visual updates through the IMM filter (imm.h); ekf mirrors its
+ * combined estimate and the output carries the model probabilities.
+ * Delayed fixes are fused at arrival time. Takes precedence over
+ * use_ekf32.
+ */
+void vps_fusion_use_imm(vps_fusion_t *f, bool on);
+
+/**
+ * Feed a visual-odometry displacement (visual_odom.h) observed up to t
+ * into dead reckoning. Until the next visual fix, outputs without a fix
+ * come from this odometry-advanced reference instead of the constant
+ * velocity EKF prediction (an attached IMU still takes precedence).
+ * @return false if there is no reference to advance yet
+ */
+bool vps_fusion_odometry(vps_fusion_t *f, double dn_m, double de_m,
+                         double hdop_add, double t);
+
+/**
+ * Encode every output of vps_fusion_update / _batch / _delayed into the
+ * sink's ring as part of the update, without an intermediate buffer
+ * (see output_ring.h). vps_fusion_run_batch does not emit. NULL detaches.
+ */
+void vps_fusion_set_sink(vps_fusion_t *f, vps_fusion_sink_t *sink);
+
+/**
+ * Check positions against a zone set (inclusion fence plus exclusion
+ * zones, see fence_set.h) in addition to the single fence. NULL detaches.
+ */
+void vps_fusion_set_zones(vps_fusion_t *f, const vps_fence_set_t *zones);
+
+/**
+ * Use a local frame (see local_frame.h) for the geofence, dead reckoning
+ * and speed/heading, so an update makes no trig calls while the drone is
+ * inside the frame's box. Zone sets keep their own distances. NULL
+ * detaches.
+ */
+void vps_fusion_set_frame(vps_fusion_t *f, const vps_local_frame_t *frame);
+
+/**
+ * Predicted geofence breach: sweep the EKF track from its prediction at
+ * t over horizon_s (e.g. 5 s) against the fence and the zone set, with
+ * radius_km of position uncertainty (see vps_geofence_time_to_breach).
+ * @param t_out seconds from t to the first breach, INFINITY if none
+ * @return true if a breach is predicted; false also without an EKF state
+ */
+bool vps_fusion_time_to_breach(const vps_fusion_t *f, double t, double horizon_s,
+                               double radius_km, double *t_out);
+
 /** Reset all state. */
 void vps_fusion_reset(vps_fusion_t *f);
 
+/**
+ * Frame sequence for vps_fusion_run_batch, as structure of arrays of n
+ * entries. fix may be NULL (every frame has a visual fix); truth_lat /
+ * truth_lon may be NULL (no error statistics).
+ */
+typedef struct {
+    size_t n;
+    const double *t;
+    const double *lat, *lon;      /* visual fix, read only where fix[i] */
+    const double *hdop;
+    const bool *fix;
+    const double *truth_lat, *truth_lon;
+} vps_fusion_frames_t;
+
+/* Output flag bits (the low two as in the flight recorder) */
+#define VPS_FUSION_FLAG_GEOFENCE_OK 0x01
+#define VPS_FUSION_FLAG_EKF_ACCEPTED 0x02
+#define VPS_FUSION_FLAG_POSITION 0x10
+
+/** Per-frame outputs as structure of arrays; any array may be NULL. */
+typedef struct {
+    double *lat, *lon;
+    double *hdop;
+    double *speed_mps, *heading_deg;
+    uint8_t *fix_quality;         /* vps_fix_quality_t */
+    uint8_t *source;              /* vps_source_t */
+    uint8_t *flags;               /* VPS_FUSION_FLAG_* */
+} vps_fusion_track_t;
+
+typedef struct {
+    uint64_t frames;
+    uint64_t fixes;               /* frames with a visual fix */
+    uint64_t accepted;            /* fixes that passed the EKF gate */
+    uint64_t positioned;          /* frames with an output position */
+    uint64_t fence_blocked;       /* positions withheld by the geofence */
+    uint64_t err_n;               /* positioned frames compared to truth */
+    double err_sum_sq_m2;
+    double err_max_m;
+} vps_fusion_batch_stats_t;
+
+/**
+ * Run vps_fusion_update over every frame in order (same results as the
+ * per-frame calls). Position error against truth uses a local flat-earth
+ * scale fixed at the first truth point, which is fine for one flight.
+ * @param out   per-frame outputs (may be NULL)
+ * @param stats accumulated into (may be NULL)
+ */
+void vps_fusion_run_batch(vps_fusion_t *f, const vps_fusion_frames_t *in,
+                          vps_fusion_track_t *out, vps_fusion_batch_stats_t *stats);
+
 #endif /* FUSION_H */
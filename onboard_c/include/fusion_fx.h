@@ -0,0 +1,182 @@
+/**
+ * @file fusion_fx.h
+ * @brief Fixed-point fusion core for the flight controller (no FPU, no libm).
+ *
+ * Integer counterpart of vps_fusion_update without IMU/IMM: the local-frame
+ * EKF of ekf32.h, odometry dead reckoning, circle/rect geofence and the
+ * MSP_SET_RAW_GPS encoding, so the fusion and output half can run on the
+ * FC (or a small co-processor) while the Pi only produces visual fixes.
+ *
+ * Units follow MSP: positions are degrees * 1e7, HDOP * 100, times are
+ * millisecond ticks (wrapping). Internally:
+ *   - state n, e (m) and vn, ve (m/s) are Q16.16 relative to an origin
+ *     that moves once the state drifts reanchor_m away (as ekf32),
+ *   - the covariance is Q24.8 for position (up to 8.4e6 m²), Q20.12
+ *     for position-velocity and Q16.16 for velocity terms,
+ *   - gains are Q8.24 (Q4.28 on velocity rows), products go through int64.
+ * Trig is integer only: cos by a range-reduced Taylor polynomial (error
+ * < 2e-9), atan2 by 28 CORDIC iterations (< 1e-5 deg). Right shifts of
+ * negative values are assumed arithmetic (two's complement targets).
+ *
+ * Replaying recorded flights through both builds, positions agree to
+ * within a centimetre (see test_fusion_fx.c); the geofence uses an equirectangular distance at the
+ * mid latitude instead of haversine, which differs by under 1 cm within
+ * 10 km of the centre.
+ */
+#ifndef FUSION_FX_H
+#define FUSION_FX_H
+
+#include "geofence.h"
+#include "vps_types.h"
+
+#define VPS_FX_PACKED 10        /* packed covariance, as VPS_EKF_PACKED */
+#define VPS_FX_ONE 65536        /* 1.0 in Q16.16 */
+
+/** Position in MSP units. */
+typedef struct {
+    int32_t lat, lon;           /* degrees * 1e7 */
+} vps_fx_point_t;
+
+typedef struct {
+    int32_t q;                  /* process noise north, m²/s³ (Q16.16) */
+    int32_t r;                  /* measurement noise north at HDOP 1, m² (Q24.8) */
+    int32_t gate;               /* Mahalanobis gate (Q16.16) */
+    uint32_t max_gap_ms;        /* longer gaps restart the filter */
+    int32_t reanchor_m;
+    uint32_t max_dr_ms;         /* dead reckoning horizon */
+    uint16_t dr_hdop_rate;      /* HDOP * 100 added per second of DR */
+} vps_fx_config_t;
+
+/** Defaults equivalent to vps_ekf_default_config(), 10 s DR, 2.0 HDOP/s. */
+vps_fx_config_t vps_fx_default_config(void);
+
+/* --- Integer math --- */
+
+/** cos of an angle in degrees * 1e7, Q2.30. */
+int32_t vps_fx_cos_deg7(int32_t deg7);
+
+/** atan2(y, x) in degrees, Q16.16 in (-180, 180]; 0 for (0, 0). */
+int32_t vps_fx_atan2_deg(int32_t y, int32_t x);
+
+/** floor(sqrt(v)). */
+uint32_t vps_fx_isqrt64(uint64_t v);
+
+/* --- EKF --- */
+
+typedef struct {
+    int32_t lat0, lon0;         /* origin, degrees * 1e7 */
+    uint32_t k_lon;             /* metres per 1e-7 deg east at lat0 (Q0.32) */
+    int32_t cos2;               /* cos²(lat0), east noise scale (Q2.30) */
+    int32_t x[4];               /* n, e, vn, ve (Q16.16) */
+    int32_t p[VPS_FX_PACKED];   /* Q24.8 / Q20.12 / Q16.16 (pos / cross / vel) */
+    uint32_t last_ms;
+    bool initialized;
+    int32_t last_gate;          /* Q16.16 */
+    uint32_t reanchors;
+} vps_fx_ekf_t;
+
+/** Initialize (uninitialized). */
+void vps_fx_ekf_init(vps_fx_ekf_t *e);
+
+/** vps_ekf32_update in fixed point (same return and gating rules). */
+bool vps_fx_ekf_update(vps_fx_ekf_t *e, const vps_fx_config_t *cfg,
+                       vps_fx_point_t z, uint16_t hdop, uint32_t t_ms);
+
+/** Predicted position at t_ms ({0, 0} if uninitialized). */
+vps_fx_point_t vps_fx_ekf_predict(const vps_fx_ekf_t *e, uint32_t t_ms);
+
+/** Speed in m/s (Q16.16). */
+int32_t vps_fx_ekf_speed(const vps_fx_ekf_t *e);
+
+/** Kernels: qn/qe Q16.16, dt seconds Q16.16, zn/ze Q16.16, rn/re Q24.8 (m²). */
+void vps_fx_ekf_propagate(int32_t x[4], int32_t p[VPS_FX_PACKED],
+                          int32_t qn, int32_t qe, int32_t dt);
+
+/**
+ * Gated correction.
+ * @return Mahalanobis distance (Q16.16, rounded up, saturating), -1 if the
+ *         innovation covariance is singular; the state is updated only
+ *         when the distance is <= gate
+ */
+int32_t vps_fx_ekf_correct(int32_t x[4], int32_t p[VPS_FX_PACKED], int32_t zn,
+                           int32_t ze, int32_t rn, int32_t re, int32_t gate);
+
+/* --- Dead reckoning --- */
+
+typedef struct {
+    bool has_reference;
+    bool odometry;              /* reference advanced by odometry */
+    vps_fx_point_t ref;
+    int32_t vn, ve;             /* m/s (Q16.16) */
+    uint16_t hdop;              /* HDOP * 100 */
+    uint32_t ref_ms;
+} vps_fx_dr_t;
+
+void vps_fx_dr_update_ref(vps_fx_dr_t *dr, vps_fx_point_t pos, int32_t vn,
+                          int32_t ve, uint16_t hdop, uint32_t t_ms);
+
+/** vps_dr_apply_odometry: displacement in mm since the reference. */
+bool vps_fx_dr_apply_odometry(vps_fx_dr_t *dr, int32_t dn_mm, int32_t de_mm,
+                              uint16_t hdop_add, uint32_t t_ms);
+
+bool vps_fx_dr_extrapolate(const vps_fx_dr_t *dr, const vps_fx_config_t *cfg,
+                           uint32_t t_ms, vps_fx_point_t *pos, uint16_t *hdop);
+
+/* --- Geofence --- */
+
+typedef struct {
+    vps_fence_type_t type;
+    vps_fx_point_t center;
+    int32_t radius_mm;          /* circle */
+    int32_t margin_mm;
+    int32_t half_n_mm;          /* rect: center ± half_n_mm north */
+    int32_t half_e_mm;          /* rect: center ± half_e_mm east */
+} vps_fx_fence_t;
+
+/** Check if point is inside the fence (margin applied, as vps_geofence_contains). */
+bool vps_fx_fence_contains(const vps_fx_fence_t *fence, vps_fx_point_t point);
+
+/** Distance to the nearest boundary in mm (negative = outside). */
+int32_t vps_fx_fence_distance_mm(const vps_fx_fence_t *fence, vps_fx_point_t point);
+
+/* --- Fusion --- */
+
+typedef struct {
+    bool has_position;
+    vps_fx_point_t position;
+    uint16_t hdop;              /* HDOP * 100 */
+    uint16_t speed_cms;
+    uint16_t heading_deg10;     /* 0..3599 */
+    vps_fix_quality_t fix_quality;
+    vps_source_t source;
+    bool geofence_ok;
+    bool ekf_accepted;
+} vps_fx_output_t;
+
+typedef struct {
+    vps_fx_config_t cfg;
+    vps_fx_ekf_t ekf;
+    vps_fx_dr_t dr;
+    const vps_fx_fence_t *fence;  /* borrowed, may be NULL */
+} vps_fx_fusion_t;
+
+/** cfg and fence may be NULL (defaults, no fence). */
+void vps_fx_fusion_init(vps_fx_fusion_t *f, const vps_fx_config_t *cfg,
+                        const vps_fx_fence_t *fence);
+
+/** vps_fusion_update: visual fix (or NULL) with HDOP * 100 at t_ms. */
+vps_fx_output_t vps_fx_fusion_update(vps_fx_fusion_t *f, const vps_fx_point_t *visual,
+                                     uint16_t hdop, uint32_t t_ms);
+
+/** vps_fusion_odometry with a displacement in mm. */
+bool vps_fx_fusion_odometry(vps_fx_fusion_t *f, int32_t dn_mm, int32_t de_mm,
+                            uint16_t hdop_add, uint32_t t_ms);
+
+/**
+ * Encode MSP_SET_RAW_GPS for an output.
+ * @param out buffer (>= MSP_GPS_FRAME_SIZE bytes)
+ * @return frame size (always 24)
+ */
+int vps_fx_encode_msp(uint8_t *out, const vps_fx_output_t *o);
+
+#endif /* FUSION_FX_H */
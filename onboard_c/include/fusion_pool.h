@@ -0,0 +1,42 @@
+/**
+ * @file fusion_pool.h
+ * @brief Work-stealing pool running many independent fusion instances.
+ *
+ * For offline replay and parameter sweeps: each job is one vps_fusion_t
+ * (with its own EKF/DR/geofence settings) replayed over one frame
+ * sequence with vps_fusion_run_batch. Jobs are split into contiguous
+ * ranges, one per worker; a worker that runs dry steals half of the
+ * remaining range of another. Each range is a single 64-bit word
+ * (head | tail << 32) updated by CAS, so owner pops and steals need no
+ * locks. Jobs share nothing, so results are identical for any thread
+ * count.
+ */
+#ifndef FUSION_POOL_H
+#define FUSION_POOL_H
+
+#include "fusion.h"
+
+#define VPS_FUSION_POOL_MAX_THREADS 64
+
+typedef struct {
+    vps_fusion_t *f;                  /* initialized by the caller */
+    const vps_fusion_frames_t *in;    /* may be shared between jobs */
+    vps_fusion_track_t *out;          /* may be NULL */
+    vps_fusion_batch_stats_t stats;   /* zeroed and filled by the run */
+} vps_fusion_job_t;
+
+typedef struct {
+    int threads;                      /* workers used, including the caller */
+    uint64_t steals;                  /* successful steals */
+} vps_fusion_pool_stats_t;
+
+/**
+ * Run every job to completion on up to threads workers (<= 0: one per
+ * online CPU), the calling thread being one of them.
+ * @param ps may be NULL
+ * @return false if fewer threads could be started (all jobs still run)
+ */
+bool vps_fusion_run_jobs(vps_fusion_job_t *jobs, size_t n, int threads,
+                         vps_fusion_pool_stats_t *ps);
+
+#endif /* FUSION_POOL_H */
@@ -5,6 +5,7 @@
 #ifndef GEO_TRANSFORM_H
 #define GEO_TRANSFORM_H
 
+#include "local_frame.h"
 #include "vps_types.h"
 
 /** Convert a pixel within a tile to GPS. */
@@ -25,4 +26,8 @@ vps_geopoint_t vps_homography_to_gps(const double H[9],
 /** Convert pixel displacement to meters. */
 double vps_pixel_distance_to_meters(double dx, double dy, double lat, int zoom);
 
+/** vps_pixel_distance_to_meters with cos(lat) from the frame. */
+double vps_pixel_distance_to_meters_local(const vps_local_frame_t *frame,
+                                          double dx, double dy, double lat, int zoom);
+
 #endif /* GEO_TRANSFORM_H */
@@ -1,17 +1,33 @@
 /**
  * @file geofence.h
  * @brief Geofence safety boundary checks.
+ *
+ * Circle and rectangle fences are checked with haversine distances.
+ * Polygon fences (any number of rings, even-odd rule so inner rings are
+ * holes) are projected once into a local km plane around their bounding
+ * box and indexed by a uniform grid whose cells are about two mean edge
+ * lengths wide. Only cells crossed by an edge are stored, row by row,
+ * each with the edges that touch it and the inside/outside state of its
+ * centre and of the empty run to its right. Containment is a lookup plus
+ * crossing tests against the few edges of one cell, O(1) on average
+ * instead of O(vertices). Distances search rows outwards from the query
+ * cell until no closer edge is possible, so their cost grows with the
+ * distance in cells; margin checks stop at the margin.
  */
 #ifndef GEOFENCE_H
 #define GEOFENCE_H
 
+#include "local_frame.h"
 #include "vps_types.h"
 
 typedef enum {
     VPS_FENCE_CIRCLE,
     VPS_FENCE_RECT,
+    VPS_FENCE_POLYGON,
 } vps_fence_type_t;
 
+typedef struct vps_geofence_poly vps_geofence_poly_t;
+
 typedef struct {
     vps_fence_type_t type;
     vps_geopoint_t center;
@@ -20,6 +36,7 @@ typedef struct {
     /* For rect: center ± half_lat_km, center ± half_lon_km */
     double half_lat_km;
     double half_lon_km;
+    const vps_geofence_poly_t *poly;  /* for polygon (borrowed) */
 } vps_geofence_t;
 
 /** Check if point is inside geofence. */
@@ -28,4 +45,100 @@ bool vps_geofence_contains(const vps_geofence_t *fence, vps_geopoint_t point);
 /** Distance to nearest fence boundary in km (negative = outside). */
 double vps_geofence_distance_km(const vps_geofence_t *fence, vps_geopoint_t point);
 
+/**
+ * vps_geofence_contains / _distance_km with the frame's trig-free
+ * distances (within frame->max_err_m of haversine) when both the fence
+ * centre and the point lie inside the frame's box. Polygons and points
+ * outside the box take the haversine path.
+ */
+bool vps_geofence_contains_local(const vps_geofence_t *fence, const vps_local_frame_t *frame,
+                                 vps_geopoint_t point);
+double vps_geofence_distance_km_local(const vps_geofence_t *fence,
+                                      const vps_local_frame_t *frame, vps_geopoint_t point);
+
+/**
+ * Predicted breach along a straight track, solved analytically rather
+ * than by sampling. A disc of radius_km (the position uncertainty) moves
+ * from point at vn, ve m/s, as the EKF predicts; the result is the first
+ * time within horizon_s at which part of it leaves the fence less its
+ * margin. Circles are a quadratic and rects a slab test in a plane at
+ * the fence centre (O(1)); polygons test the capsule of each edge (edge
+ * grown by margin + radius) near the track, found through the grid
+ * index, so their cost grows with the track length in cells (one or two
+ * for a 5 s horizon at typical speeds).
+ * @param t_out seconds to the breach, 0 if already breaching, INFINITY if none
+ * @return true if the fence is breached within horizon_s
+ */
+bool vps_geofence_time_to_breach(const vps_geofence_t *fence, vps_geopoint_t point,
+                                 double vn_mps, double ve_mps, double radius_km,
+                                 double horizon_s, double *t_out);
+
+/**
+ * As vps_geofence_time_to_breach for a keep-out zone: the first time the
+ * disc comes within margin_km of the fence or enters it.
+ */
+bool vps_geofence_time_to_entry(const vps_geofence_t *fence, vps_geopoint_t point,
+                                double vn_mps, double ve_mps, double radius_km,
+                                double horizon_s, double *t_out);
+
+/* --- Polygon fences --- */
+
+/** Edge a -> b in the local plane (km). */
+typedef struct {
+    double ax, ay;
+    double bx, by;
+    double inv_len2;             /* 1 / |b - a|² */
+} vps_poly_edge_t;
+
+/** Grid cell crossed by at least one edge. */
+typedef struct {
+    int32_t col;
+    uint32_t first;              /* edges are edge_idx[first .. next cell's first) */
+    uint8_t flags;               /* VPS_POLY_CENTER_IN, VPS_POLY_RUN_IN */
+} vps_poly_cell_t;
+
+#define VPS_POLY_CENTER_IN 1     /* cell centre is inside */
+#define VPS_POLY_RUN_IN 2        /* empty cells up to the next stored cell are inside */
+
+struct vps_geofence_poly {
+    double lat0, lon0;           /* projection origin (bounding box centre) */
+    double min_lat, min_lon, max_lat, max_lon;  /* vertex bounding box */
+    double x0, y0;               /* grid origin, km */
+    double cell_km, inv_cell;
+    int rows;
+    int n_edges, n_cells;
+    vps_poly_edge_t *edges;
+    vps_poly_cell_t *cells;      /* n_cells + 1, sorted by row then column */
+    uint32_t *row_start;         /* rows + 1, into cells */
+    uint32_t *edge_idx;
+};
+
+/**
+ * Build a polygon fence.
+ * @param points    vertices of all rings back to back (closing the ring is optional)
+ * @param ring_len  vertex count of each ring, >= 3
+ * @param n_rings   rings; with the even-odd rule any ring inside another is a hole
+ * @return false on invalid input or allocation failure
+ */
+bool vps_geofence_poly_build(vps_geofence_poly_t *poly, const vps_geopoint_t *points,
+                             const int *ring_len, int n_rings);
+
+/** Release the index. */
+void vps_geofence_poly_free(vps_geofence_poly_t *poly);
+
+/** Check if point is inside and at least margin_km from the boundary. */
+bool vps_geofence_poly_contains(const vps_geofence_poly_t *poly, vps_geopoint_t point,
+                                double margin_km);
+
+/** Distance to the nearest edge in km (negative = outside). */
+double vps_geofence_poly_distance_km(const vps_geofence_poly_t *poly, vps_geopoint_t point);
+
+/** As vps_geofence_poly_distance_km with the search stopped at limit_km (|result| <= limit_km). */
+double vps_geofence_poly_distance_capped_km(const vps_geofence_poly_t *poly,
+                                            vps_geopoint_t point, double limit_km);
+
+/** Project a point into the polygon's local plane (km east, km north). */
+void vps_geofence_poly_project(const vps_geofence_poly_t *poly, vps_geopoint_t point,
+                               double *x, double *y);
+
 #endif /* GEOFENCE_H */
@@ -0,0 +1,96 @@
+/**
+ * @file global_pixel.h
+ * @brief 64-bit global Web Mercator pixel coordinates at z24.
+ *
+ * A point is held as its pixel in the 2^32 x 2^32 pixel world of zoom 24
+ * (9.3 mm at the equator, less towards the poles). The pixel, and the
+ * global pixel at any zoom up to 24, is the z24 value shifted right, so
+ * the tile is a shift too. Tile lookup, neighbour enumeration, pixel
+ * offsets and distances between nearby points are integer only.
+ * Floating-point trig is left at the lat/lon boundary (from_gps, to_gps)
+ * and at the once-per-area distance scale.
+ *
+ * Coordinates are int64 so sums and differences never overflow. x wraps
+ * at the antimeridian: deltas go the short way round and neighbours wrap.
+ * Distances are on the same equatorial sphere as vps_meters_per_pixel,
+ * 0.11% longer than vps_haversine_km.
+ */
+#ifndef GLOBAL_PIXEL_H
+#define GLOBAL_PIXEL_H
+
+#include "vps_types.h"
+
+#define VPS_GPX_ZOOM 24
+#define VPS_GPX_BITS 32                     /* z24 world is 2^32 pixels wide */
+#define VPS_GPX_NEAR_PX ((int64_t)1 << 24)  /* distance reach, ~156 km at the equator */
+
+/** Global pixel at VPS_GPX_ZOOM. */
+typedef struct {
+    int64_t x;
+    int64_t y;
+} vps_gpx_t;
+
+/**
+ * Ground scale around a reference row, for integer distances: mm per z24
+ * pixel as a quadratic in the row offset (relative error < 5e-6 within
+ * VPS_GPX_NEAR_PX rows).
+ */
+typedef struct {
+    int64_t y0;
+    int64_t s0;     /* mm per pixel at y0, Q24 */
+    int64_t a;      /* first-order row term, Q56 per pixel */
+    int64_t b;      /* second-order row term, Q88 per pixel^2 */
+} vps_gpx_scale_t;
+
+/**
+ * Nearest z24 pixel of a point (trig). Latitudes are clamped to
+ * +/-VPS_MAX_MERCATOR_LAT and longitudes wrapped into [-180, 180).
+ */
+vps_gpx_t vps_gpx_from_gps(vps_geopoint_t point);
+
+/** Point of a z24 pixel (trig); from_gps round trips to within 5 mm. */
+vps_geopoint_t vps_gpx_to_gps(vps_gpx_t g);
+
+/** z24 pixel of a pixel within a tile of zoom <= 24 (pixel rounded). */
+vps_gpx_t vps_gpx_from_tile_pixel(vps_tile_coord_t tile, vps_pixel_t pixel);
+
+/** Global pixel at zoom <= 24: the z24 pixel shifted right. */
+vps_gpx_t vps_gpx_at_zoom(vps_gpx_t g, int zoom);
+
+/** Tile containing g at zoom <= 24. */
+vps_tile_coord_t vps_gpx_tile(vps_gpx_t g, int zoom);
+
+/** Pixel of g within its tile at zoom <= 24, with the z24 fraction. */
+vps_pixel_t vps_gpx_tile_pixel(vps_gpx_t g, int zoom);
+
+/**
+ * Tiles within ring tiles (Chebyshev) of g's tile at zoom, row by row.
+ * Columns wrap at the antimeridian, rows off the map are dropped.
+ * @return number of tiles written (at most max_out)
+ */
+int vps_gpx_neighbors(vps_gpx_t g, int zoom, int ring, vps_tile_coord_t *out, int max_out);
+
+/** b - a in z24 pixels, x the short way round the antimeridian. */
+vps_gpx_t vps_gpx_delta(vps_gpx_t a, vps_gpx_t b);
+
+/** Ground scale around ref (trig, once per map area). */
+void vps_gpx_scale_init(vps_gpx_scale_t *s, vps_gpx_t ref);
+
+/**
+ * Ground distance from a to b in mm, integer only: pixel length times the
+ * scale at their mid row (within 1e-5 of vps_meters_per_pixel at z24).
+ * The integer square root makes it about half the speed of haversine on
+ * a host with an FPU; threshold tests should use vps_gpx_within_mm.
+ * @return false if a and b are more than VPS_GPX_NEAR_PX apart on an axis,
+ *         or their mid row more than that from the scale's reference row
+ */
+bool vps_gpx_distance_mm(const vps_gpx_scale_t *s, vps_gpx_t a, vps_gpx_t b,
+                         int64_t *mm_out);
+
+/**
+ * distance_mm(a, b) <= mm without the square root (one divide).
+ * @return false also where vps_gpx_distance_mm fails
+ */
+bool vps_gpx_within_mm(const vps_gpx_scale_t *s, vps_gpx_t a, vps_gpx_t b, int64_t mm);
+
+#endif /* GLOBAL_PIXEL_H */
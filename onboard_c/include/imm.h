@@ -0,0 +1,73 @@
+/**
+ * @file imm.h
+ * @brief Interacting Multiple Model filter over hover/cruise/turn models.
+ *
+ * Each model is a 4-state EKF in one lane of an ekf_bank: hover (low
+ * process noise, velocity decaying to zero), cruise (the configured
+ * constant-velocity model) and turn (constant velocity with high process
+ * noise to follow manoeuvres). One update is the standard IMM cycle:
+ * mix the model states through the Markov transition matrix, propagate
+ * and correct all lanes in one bank pass, reweight the models by their
+ * measurement likelihood and combine them into one estimate.
+ *
+ * A fix is accepted if any model gates it in; models that gate it out
+ * keep their prediction and lose weight. The three models fit in one
+ * AVX2 vector, so the lane work costs one vectorised filter step.
+ */
+#ifndef IMM_H
+#define IMM_H
+
+#include "ekf_bank.h"
+
+typedef enum {
+    VPS_IMM_HOVER = 0,
+    VPS_IMM_CRUISE,
+    VPS_IMM_TURN,
+    VPS_IMM_MODELS
+} vps_imm_model_t;
+
+typedef struct {
+    double q_scale[VPS_IMM_MODELS];  /* process noise = q_scale · ekf process_noise */
+    double tau_s[VPS_IMM_MODELS];    /* velocity decay time constant, 0 = constant */
+    double p_stay;                   /* probability of keeping the model per update */
+    double mu_min;                   /* probability floor (keeps models revivable) */
+} vps_imm_config_t;
+
+typedef struct {
+    vps_imm_config_t cfg;
+    vps_ekf_bank_t bank;             /* lane j = model j */
+    double mu[VPS_IMM_MODELS];       /* model probabilities */
+    double d[VPS_IMM_MODELS];        /* per-model distance of the last fix */
+    double last_t;
+    bool initialized;
+    double last_gate;                /* smallest model distance of the last fix */
+    double decay_dt, decay[VPS_IMM_MODELS];  /* velocity retention cached per dt */
+} vps_imm_t;
+
+/** Defaults: q ×0.01/×1/×100, hover tau 2 s, p_stay 0.95, mu_min 1e-4. */
+vps_imm_config_t vps_imm_default_config(void);
+
+/** Initialize (uninitialized). cfg may be NULL for defaults. */
+void vps_imm_init(vps_imm_t *m, const vps_imm_config_t *cfg);
+
+/** Reset to uninitialized, keeping the configuration. */
+void vps_imm_reset(vps_imm_t *m);
+
+/**
+ * One IMM cycle with a position fix. Same first-fix, gap and time rules
+ * as vps_ekf_update; cfg supplies the base noise, gate and max gap.
+ * @return true if at least one model accepted the fix
+ */
+bool vps_imm_update(vps_imm_t *m, const vps_ekf_config_t *cfg,
+                    vps_geopoint_t measurement, double hdop, double t);
+
+/** Combined estimate as an EKF state (moment-matched mixture). */
+void vps_imm_to_state(const vps_imm_t *m, vps_ekf_state_t *s);
+
+/** Seed every model from an EKF state (probabilities reset to the prior). */
+void vps_imm_from_state(vps_imm_t *m, const vps_ekf_state_t *s);
+
+/** Most probable model. */
+vps_imm_model_t vps_imm_best(const vps_imm_t *m);
+
+#endif /* IMM_H */
@@ -0,0 +1,114 @@
+/**
+ * @file imu_nav.h
+ * @brief High-rate IMU/attitude prediction between visual fixes.
+ *
+ * Acceleration (100–400 Hz) is rotated to north/east with the latest FC
+ * attitude and integrated into a local position/velocity. Each visual
+ * EKF update re-anchors the integrator at the filter state and replays
+ * the buffered samples captured after it, so the fix latency does not
+ * show in the output.
+ *
+ * Costs are fixed: an attitude sample does six sin/cos, an accel sample
+ * a 2x3 rotation and one integration step, an anchor at most
+ * VPS_IMU_RING integration steps. No allocation.
+ *
+ * Frames: NED navigation frame, FRD body frame, Euler ZYX attitude
+ * (roll right-wing-down, pitch nose-up, yaw clockwise from north).
+ * Feed it from the thread that owns the fusion state.
+ */
+#ifndef IMU_NAV_H
+#define IMU_NAV_H
+
+#include "vps_types.h"
+#include "ekf.h"
+#include "msp.h"
+
+#define VPS_IMU_RING 512   /* 1.28 s at 400 Hz */
+#define VPS_GRAVITY 9.80665
+
+/** Specific force in the body frame (FRD, m/s²), as an accelerometer reads it. */
+typedef struct {
+    double t;
+    float fx, fy, fz;
+} vps_imu_sample_t;
+
+/** Attitude in radians. */
+typedef struct {
+    double t;
+    float roll, pitch, yaw;
+} vps_attitude_t;
+
+typedef struct {
+    double hdop_growth;   /* HDOP added per second since the last anchor */
+    double max_age_s;     /* stop predicting this long after an anchor */
+} vps_imu_nav_config_t;
+
+typedef struct {
+    vps_imu_nav_config_t cfg;
+
+    /* Body → NED rows for north and east (from the latest attitude) */
+    float rn[3], re[3];
+    bool has_attitude;
+
+    /* North/east acceleration history for re-anchoring */
+    struct {
+        double t;
+        float an, ae;
+    } ring[VPS_IMU_RING];
+    int head;    /* next write index */
+    int count;
+
+    /* Integrated state relative to the anchor position */
+    double ref_lat, ref_lon;
+    double m_per_deg_lon;
+    double pn, pe;      /* m */
+    double vn, ve;      /* m/s */
+    float an, ae;       /* latest acceleration (held until the next sample) */
+    double t;           /* time of pn/pe/vn/ve */
+    double t_anchor;
+    double anchor_hdop;
+    bool valid;
+
+    uint64_t samples;
+} vps_imu_nav_t;
+
+/** Defaults: 0.5 HDOP/s growth, 10 s max age. */
+vps_imu_nav_config_t vps_imu_nav_default_config(void);
+
+/** Initialize (no attitude, no anchor). cfg may be NULL for defaults. */
+void vps_imu_nav_init(vps_imu_nav_t *nav, const vps_imu_nav_config_t *cfg);
+
+/** Update the attitude used to rotate following accel samples. */
+void vps_imu_nav_attitude(vps_imu_nav_t *nav, const vps_attitude_t *att);
+
+/**
+ * Add an accel sample (ignored until the first attitude). Samples must
+ * arrive in time order.
+ */
+void vps_imu_nav_push(vps_imu_nav_t *nav, const vps_imu_sample_t *s);
+
+/**
+ * Re-anchor at the EKF state (position and velocity at ekf->last_t) and
+ * replay buffered samples newer than that.
+ */
+void vps_imu_nav_anchor(vps_imu_nav_t *nav, const vps_ekf_state_t *ekf, double hdop);
+
+/**
+ * Position/velocity at time t (>= the latest sample; held acceleration
+ * is extrapolated). vel may be NULL.
+ * @return false if not anchored or older than max_age_s
+ */
+bool vps_imu_nav_position(const vps_imu_nav_t *nav, double t, vps_geopoint_t *pos,
+                          vps_velocity_t *vel, double *hdop);
+
+/** Convert MSP readings (FC sensor axes: x forward, y left, z up). */
+vps_imu_sample_t vps_imu_from_msp(const vps_msp_raw_imu_t *raw, double t);
+vps_attitude_t vps_attitude_from_msp(const vps_msp_attitude_t *att, double t);
+
+/**
+ * Dispatch a parsed MSP reply (RAW_IMU or ATTITUDE) received at t.
+ * @return true if the frame was consumed
+ */
+bool vps_imu_nav_feed_msp(vps_imu_nav_t *nav, const vps_msp_parser_t *frame, double t);
+
+#endif /* IMU_NAV_H */
@@ -0,0 +1,81 @@
+/**
+ * @file local_frame.h
+ * @brief Trig-free local east/north frame around a map pack.
+ *
+ * Built once (with trig) for a reference point and the radius the map
+ * pack covers, it holds metres per degree of latitude and a Taylor
+ * polynomial in (lat - lat0) for cos(lat), so metres per degree of
+ * longitude anywhere in the frame costs a few multiplies (as many terms
+ * as keep the truncation near 1e-14: 4 at 1 km, 8 at 500 km). Distances
+ * are haversine on the same 6371 km sphere as vps_haversine_km, with sin
+ * and asin replaced by series that converge fast for the small angles
+ * inside the frame.
+ *
+ * The frame covers the lat/lon box around the radius disc, so coverage
+ * is two compares. max_err_m bounds |distance - haversine| for two points
+ * in the box: the sin, cos and asin series remainders carried to metres,
+ * plus a rounding term. It stays under 1 mm up to VPS_LOCAL_FRAME_MAX_KM.
+ *
+ * East/north offsets (to_enu) are equirectangular at the mid latitude,
+ * a local projection for dead reckoning, not a distance-preserving one.
+ * The frame's 111195 m per degree of latitude differs by 0.1% from the
+ * 111320 that the frame-less EKF and dead-reckoning paths use.
+ */
+#ifndef LOCAL_FRAME_H
+#define LOCAL_FRAME_H
+
+#include "vps_types.h"
+
+#define VPS_LOCAL_FRAME_MAX_KM 500.0
+#define VPS_LOCAL_FRAME_MAX_LAT 80.0   /* |lat| the box may reach */
+#define VPS_LOCAL_FRAME_COS_TERMS 8
+
+typedef struct {
+    vps_geopoint_t origin;
+    double radius_km;       /* map pack radius the box is built around */
+    double m_per_deg_lat;
+    double m_per_deg_lon;   /* at origin.lat */
+    double cos_poly[VPS_LOCAL_FRAME_COS_TERMS];  /* cos(lat) = sum c[k] (lat - lat0)^k */
+    int cos_terms;          /* enough for 1e-14 over the box */
+    double max_lat_off;     /* box half extents, degrees */
+    double max_lon_off;
+    double max_err_m;       /* bound on |distance - haversine| in the box */
+} vps_local_frame_t;
+
+/**
+ * Build a frame around origin covering radius_km.
+ * @return false for a radius outside (0, VPS_LOCAL_FRAME_MAX_KM] or a box
+ *         reaching beyond VPS_LOCAL_FRAME_MAX_LAT
+ */
+bool vps_local_frame_init(vps_local_frame_t *f, vps_geopoint_t origin, double radius_km);
+
+/** cos(lat), without trig inside the box (cos() outside it). */
+double vps_local_frame_cos_lat(const vps_local_frame_t *f, double lat);
+
+/** Metres per degree of longitude at lat. */
+double vps_local_frame_m_per_deg_lon(const vps_local_frame_t *f, double lat);
+
+/** Whether p lies inside the frame's box. */
+bool vps_local_frame_covers(const vps_local_frame_t *f, vps_geopoint_t p);
+
+/** Distance in metres (within max_err_m of haversine inside the box). */
+double vps_local_frame_distance_m(const vps_local_frame_t *f,
+                                  vps_geopoint_t a, vps_geopoint_t b);
+
+/** distance_m(a, b) <= dist_m, without the square root and asin. */
+bool vps_local_frame_within_m(const vps_local_frame_t *f, vps_geopoint_t a,
+                              vps_geopoint_t b, double dist_m);
+
+/** East/north metres of p from the origin; the inverse is exact. */
+void vps_local_frame_to_enu(const vps_local_frame_t *f, vps_geopoint_t p,
+                            double *e_m, double *n_m);
+vps_geopoint_t vps_local_frame_from_enu(const vps_local_frame_t *f,
+                                        double e_m, double n_m);
+
+/**
+ * Course over ground in degrees [0, 360) from north/east velocity, by an
+ * odd polynomial for atan (error <= 2e-8 rad, under 2e-6 degrees); 0 for (0, 0).
+ */
+double vps_heading_deg(double vn, double ve);
+
+#endif /* LOCAL_FRAME_H */
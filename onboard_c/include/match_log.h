@@ -0,0 +1,55 @@
+/**
+ * @file match_log.h
+ * @brief Recorded frame set: replays per-frame matcher results.
+ *
+ * A match log is CSV with one line per captured frame, written by
+ * onboard.benchmark.save_match_log:
+ *
+ *   t,width,height,z,x,y,num_matches,inlier_ratio,confidence,h0,...,h8
+ *
+ * num_matches == 0 marks a frame with no usable match. Lines starting
+ * with '#' and a leading "t," header line are skipped. Both the native
+ * loop and the Python loop replay the same file so their timings are
+ * directly comparable.
+ */
+#ifndef MATCH_LOG_H
+#define MATCH_LOG_H
+
+#include "runtime.h"
+
+typedef struct {
+    double t;
+    int width;
+    int height;
+    vps_match_t match;  /* num_matches == 0 if no match */
+} vps_match_log_entry_t;
+
+typedef struct {
+    vps_match_log_entry_t *entries;
+    int count;
+    int capacity;
+    int cursor;         /* next frame to grab */
+    bool loop;          /* restart at the end instead of stopping */
+    double t_offset;    /* added to timestamps after each wrap */
+    bool restamp;       /* stamp frames with vps_monotonic_s() instead */
+} vps_match_log_t;
+
+/** Load a match log. @return false on I/O or parse error */
+bool vps_match_log_load(vps_match_log_t *log, const char *path);
+
+/** Append an entry (grows the buffer). @return false on allocation failure */
+bool vps_match_log_append(vps_match_log_t *log, const vps_match_log_entry_t *e);
+
+/** Release memory. */
+void vps_match_log_free(vps_match_log_t *log);
+
+/** Rewind replay to the first frame. */
+void vps_match_log_rewind(vps_match_log_t *log);
+
+/** Frame source replaying the log's timestamps and frame sizes. */
+vps_frame_source_t vps_match_log_source(vps_match_log_t *log);
+
+/** Matcher returning the recorded result for each replayed frame. */
+vps_matcher_t vps_match_log_matcher(vps_match_log_t *log);
+
+#endif /* MATCH_LOG_H */
@@ -1,6 +1,10 @@
 /**
  * @file msp.h
- * @brief MSP (MultiWii Serial Protocol) GPS injection.
+ * @brief MSP (MultiWii Serial Protocol) GPS injection and FC telemetry.
+ *
+ * Besides encoding MSP_SET_RAW_GPS, the FC can be polled for
+ * MSP_RAW_IMU / MSP_ATTITUDE; replies are decoded by a byte-wise parser
+ * with a fixed buffer (no allocation).
  */
 #ifndef MSP_H
 #define MSP_H
@@ -8,10 +12,17 @@
 #include "vps_types.h"
 #include <stddef.h>
 
+#define MSP_CMD_RAW_IMU 102
+#define MSP_CMD_ATTITUDE 108
 #define MSP_CMD_SET_RAW_GPS 201
 #define MSP_HEADER_SIZE 5   /* $M< + len + cmd */
 #define MSP_GPS_PAYLOAD 18
 #define MSP_GPS_FRAME_SIZE (MSP_HEADER_SIZE + MSP_GPS_PAYLOAD + 1) /* +checksum */
+#define MSP_REQUEST_SIZE (MSP_HEADER_SIZE + 1)
+#define MSP_MAX_PAYLOAD 255
+#define MSP_RAW_IMU_PAYLOAD 18
+#define MSP_ATTITUDE_PAYLOAD 6
+#define MSP_ACC_1G 512      /* MSP_RAW_IMU accelerometer scale (1 g) */
 
 /** MSP GPS data. */
 typedef struct {
@@ -25,6 +36,32 @@ typedef struct {
     uint16_t hdop;           /* HDOP * 100 */
 } vps_msp_gps_t;
 
+/** MSP_RAW_IMU reply (sensor axes, FC units). */
+typedef struct {
+    int16_t acc[3];      /* 1 g = MSP_ACC_1G */
+    int16_t gyro[3];     /* deg/s */
+    int16_t mag[3];
+} vps_msp_raw_imu_t;
+
+/** MSP_ATTITUDE reply. */
+typedef struct {
+    int16_t roll_deg10;
+    int16_t pitch_deg10;
+    int16_t yaw_deg;     /* 0..359 */
+} vps_msp_attitude_t;
+
+/** Byte-wise MSP v1 reply parser ($M>). */
+typedef struct {
+    int state;
+    uint8_t len;
+    uint8_t cmd;
+    uint8_t pos;
+    uint8_t cs;
+    uint8_t payload[MSP_MAX_PAYLOAD];
+    uint32_t frames;       /* valid frames decoded */
+    uint32_t errors;       /* checksum errors and error replies ($M!) */
+} vps_msp_parser_t;
+
 /** Build MSP GPS data from position. */
 vps_msp_gps_t vps_msp_from_position(vps_geopoint_t pos, double speed_mps,
                                     double heading_deg, double hdop,
@@ -38,6 +75,38 @@ vps_msp_gps_t vps_msp_from_position(vps_geopoint_t pos, double speed_mps,
  */
 int vps_msp_encode(uint8_t *out, const vps_msp_gps_t *gps);
 
+/**
+ * Encode MSP_SET_RAW_GPS straight from a position: same bytes as
+ * vps_msp_from_position followed by vps_msp_encode.
+ * @param out buffer (>= MSP_GPS_FRAME_SIZE bytes)
+ * @return frame size (always 24)
+ */
+int vps_msp_encode_position(uint8_t *out, vps_geopoint_t pos, double speed_mps,
+                            double heading_deg, double hdop, bool has_fix);
+
+/**
+ * Encode a payload-less request (e.g. MSP_CMD_RAW_IMU).
+ * @param out buffer (>= MSP_REQUEST_SIZE bytes)
+ * @return frame size (always 6)
+ */
+int vps_msp_encode_request(uint8_t *out, uint8_t cmd);
+
+/** Reset parser state and counters. */
+void vps_msp_parser_init(vps_msp_parser_t *p);
+
+/**
+ * Feed one received byte.
+ * @return true when a complete, valid reply is available in p->cmd,
+ *         p->payload and p->len (valid until the next call)
+ */
+bool vps_msp_parse_byte(vps_msp_parser_t *p, uint8_t byte);
+
+/** Decode an MSP_RAW_IMU payload. @return false if too short */
+bool vps_msp_decode_raw_imu(const uint8_t *payload, size_t len, vps_msp_raw_imu_t *out);
+
+/** Decode an MSP_ATTITUDE payload. @return false if too short */
+bool vps_msp_decode_attitude(const uint8_t *payload, size_t len, vps_msp_attitude_t *out);
+
 /** Compute MSP checksum (XOR of len + cmd + payload). */
 uint8_t vps_msp_checksum(const uint8_t *data, size_t len);
 
@@ -7,6 +7,17 @@
 
 #include "vps_types.h"
 #include <stddef.h>
+#include <time.h>
+
+/** Longest sentence from the vps_nmea_write_* encoders, with CR LF. */
+#define VPS_NMEA_SENTENCE_MAX 96
+
+/** UTC fields of one second, formatted once and reused by every sentence. */
+typedef struct {
+    time_t sec;
+    char hms[6];     /* hhmmss */
+    char dmy[6];     /* ddmmyy */
+} vps_nmea_time_t;
 
 /** Compute NMEA checksum (XOR of chars between $ and *). */
 uint8_t vps_nmea_checksum(const char *sentence);
@@ -37,4 +48,27 @@ int vps_format_rmc(char *buf, size_t buflen,
                    vps_geopoint_t pos, bool active,
                    double speed_knots, double heading_deg);
 
+/** Fill t for UTC second sec (no-op if it already holds sec). */
+void vps_nmea_time_set(vps_nmea_time_t *t, time_t sec);
+
+/**
+ * Encode a $GPGGA sentence without stdio: byte-identical to
+ * vps_format_gga at the same UTC second. hdop and altitude are clamped
+ * to 999.9 and +-99999.9 so the sentence fits VPS_NMEA_SENTENCE_MAX.
+ * @param buf output (>= VPS_NMEA_SENTENCE_MAX bytes, not terminated)
+ * @return number of bytes written
+ */
+size_t vps_nmea_write_gga(char *buf, const vps_nmea_time_t *utc,
+                          vps_geopoint_t pos, int fix_quality,
+                          double hdop, double altitude);
+
+/**
+ * Encode a $GPRMC sentence without stdio, byte-identical to
+ * vps_format_rmc (speed clamped to 9999.9 kn).
+ * @return number of bytes written
+ */
+size_t vps_nmea_write_rmc(char *buf, const vps_nmea_time_t *utc,
+                          vps_geopoint_t pos, bool active,
+                          double speed_knots, double heading_deg);
+
 #endif /* NMEA_H */
@@ -0,0 +1,87 @@
+/**
+ * @file output_ring.h
+ * @brief SPSC byte ring for serial output, written in place by encoders.
+ *
+ * The producer reserves a contiguous window, encodes straight into it
+ * and commits the bytes actually written; the consumer (the UART
+ * writer) takes contiguous spans and hands them to write(). The buffer
+ * has VPS_OUT_RING_SPILL bytes of slack past the end, so a window that
+ * crosses the end is still contiguous; on commit the spilled bytes are
+ * moved to the front (rare, at most one frame).
+ *
+ * A fusion sink (vps_fusion_sink_t) attached with vps_fusion_set_sink()
+ * makes every fusion update encode its output into the ring.
+ */
+#ifndef OUTPUT_RING_H
+#define OUTPUT_RING_H
+
+#include "nmea.h"
+#include "spsc_queue.h"
+
+#define VPS_OUT_RING_SPILL 256   /* largest reservation */
+
+typedef struct {
+    _Alignas(VPS_CACHE_LINE) _Atomic uint32_t head;  /* consumer byte index */
+    _Alignas(VPS_CACHE_LINE) _Atomic uint32_t tail;  /* producer byte index */
+    _Alignas(VPS_CACHE_LINE) uint32_t capacity;       /* power of two */
+    uint32_t mask;
+    uint8_t *buf;                                     /* capacity + spill */
+} vps_out_ring_t;
+
+/**
+ * Allocate a ring. capacity is rounded up to a power of two and to at
+ * least VPS_OUT_RING_SPILL.
+ * @return false on allocation failure
+ */
+bool vps_out_ring_init(vps_out_ring_t *r, uint32_t capacity);
+
+/** Release ring memory. */
+void vps_out_ring_free(vps_out_ring_t *r);
+
+/**
+ * Producer: reserve n contiguous bytes (n <= VPS_OUT_RING_SPILL).
+ * @return write window, or NULL if fewer than n bytes are free
+ */
+uint8_t *vps_out_ring_reserve(vps_out_ring_t *r, size_t n);
+
+/** Producer: publish the first n bytes of the last reservation. */
+void vps_out_ring_commit(vps_out_ring_t *r, size_t n);
+
+/** Producer: copy len bytes in. @return false if they do not fit */
+bool vps_out_ring_write(vps_out_ring_t *r, const uint8_t *data, size_t len);
+
+/**
+ * Consumer: longest contiguous readable span.
+ * @return its length (0 if empty)
+ */
+size_t vps_out_ring_peek(const vps_out_ring_t *r, const uint8_t **data);
+
+/** Consumer: release n bytes returned by peek. */
+void vps_out_ring_consume(vps_out_ring_t *r, size_t n);
+
+/** Consumer: copy up to max bytes out. @return bytes copied */
+size_t vps_out_ring_read(vps_out_ring_t *r, uint8_t *dst, size_t max);
+
+/** Bytes queued (approximate under concurrency). */
+uint32_t vps_out_ring_used(const vps_out_ring_t *r);
+
+/* Sink protocol bits */
+#define VPS_SINK_NMEA 0x01   /* $GPGGA + $GPRMC */
+#define VPS_SINK_MSP 0x02    /* MSP_SET_RAW_GPS */
+
+/**
+ * Where fusion outputs are encoded. Owned by the thread that runs
+ * fusion; an output that does not fit in the ring is dropped whole.
+ */
+typedef struct {
+    vps_out_ring_t *ring;
+    unsigned protocols;       /* VPS_SINK_* */
+    vps_nmea_time_t utc;      /* cached sentence time */
+    uint64_t emitted;         /* outputs encoded */
+    uint64_t dropped;         /* outputs dropped, ring full */
+} vps_fusion_sink_t;
+
+/** Initialize a sink on ring for the given VPS_SINK_* protocols. */
+void vps_fusion_sink_init(vps_fusion_sink_t *s, vps_out_ring_t *ring, unsigned protocols);
+
+#endif /* OUTPUT_RING_H */
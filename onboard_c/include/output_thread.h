@@ -0,0 +1,136 @@
+/**
+ * @file output_thread.h
+ * @brief Fixed-rate fusion/output thread decoupled from visual fixes.
+ *
+ * A timerfd-driven thread (optionally SCHED_FIFO) runs fusion at a
+ * steady rate, e.g. 10–50 Hz. Visual fixes arrive through a lock-free
+ * latest-wins mailbox and are folded into the EKF on the next tick;
+ * ticks without a fix take the EKF predict / dead-reckoning path. The
+ * flight controller therefore sees evenly spaced positions even when a
+ * match takes 400 ms.
+ *
+ * Fix timestamps must use the same clock as vps_monotonic_s().
+ */
+#ifndef OUTPUT_THREAD_H
+#define OUTPUT_THREAD_H
+
+#include "runtime.h"
+#include "snapshot.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+/** Jitter histogram: bucket 0 is < 1 µs, bucket i is [2^(i-1), 2^i) µs. */
+#define VPS_JITTER_BUCKETS 20
+
+/**
+ * One visual fix handed to the output thread. With n > 1 the frame had
+ * several accepted candidates; the output thread picks one with
+ * vps_fusion_select against its own filter (score_candidates) or, with
+ * batch set, fuses them all with vps_fusion_update_batch (batch_fixes).
+ * A batch has no delayed form, so it is fused at the tick's time.
+ */
+typedef struct {
+    vps_geopoint_t position;
+    double hdop;
+    double t;        /* capture timestamp (monotonic s) */
+    uint32_t seq;
+    int n;           /* candidates in fix_*; 0 or 1 uses position */
+    bool batch;      /* fuse all n at once instead of selecting one */
+    vps_geopoint_t fix_position[VPS_RUNTIME_MAX_CANDIDATES];
+    double fix_hdop[VPS_RUNTIME_MAX_CANDIDATES];
+} vps_visual_fix_t;
+
+/**
+ * Single-producer/single-consumer latest-wins mailbox (triple buffer).
+ * post() never blocks; an unread fix is replaced by the newer one.
+ */
+typedef struct {
+    vps_visual_fix_t slots[3];
+    _Atomic uint32_t state;   /* middle slot index | fresh flag */
+    uint32_t back;            /* producer-owned slot */
+    uint32_t front;           /* consumer-owned slot */
+    _Atomic uint64_t posted;
+    _Atomic uint64_t overwritten;
+} vps_fix_mailbox_t;
+
+typedef struct {
+    double rate_hz;       /* tick rate (default 20) */
+    int rt_priority;      /* SCHED_FIFO priority, 0 = inherit policy */
+    /** Called after each tick's output is written. May be NULL. */
+    void (*on_output)(void *ctx, const vps_fusion_output_t *out, double t);
+    void *on_output_ctx;
+    /** Each tick's output and filter state is published here. May be NULL. */
+    vps_fusion_pub_t *publish;
+} vps_output_thread_config_t;
+
+/** Tick timing statistics. Jitter is wake-up time minus deadline. */
+typedef struct {
+    uint64_t ticks;
+    uint64_t missed_ticks;        /* timer expirations skipped by overruns */
+    uint64_t fixes_applied;
+    uint64_t fixes_overwritten;   /* replaced in the mailbox before a tick */
+    uint64_t jitter_max_ns;
+    double jitter_mean_ns;
+    uint64_t hist[VPS_JITTER_BUCKETS];
+    bool realtime;                /* SCHED_FIFO was granted */
+} vps_output_stats_t;
+
+typedef struct {
+    vps_runtime_t *rt;
+    vps_output_thread_config_t cfg;
+    vps_fix_mailbox_t mailbox;
+
+    int timer_fd;
+    pthread_t thread;
+    _Atomic bool stop;
+    bool running;
+
+    /* Written by the output thread only */
+    _Atomic uint64_t ticks;
+    _Atomic uint64_t missed_ticks;
+    _Atomic uint64_t fixes_applied;
+    _Atomic uint64_t jitter_sum_ns;
+    _Atomic uint64_t jitter_max_ns;
+    _Atomic uint64_t hist[VPS_JITTER_BUCKETS];
+    _Atomic bool realtime;
+} vps_output_thread_t;
+
+/** Reset a mailbox to empty. */
+void vps_fix_mailbox_init(vps_fix_mailbox_t *mb);
+
+/** Producer: publish a fix. @return true if an unread fix was replaced */
+bool vps_fix_mailbox_post(vps_fix_mailbox_t *mb, const vps_visual_fix_t *fix);
+
+/** Consumer: take the newest unread fix. @return false if none */
+bool vps_fix_mailbox_take(vps_fix_mailbox_t *mb, vps_visual_fix_t *out);
+
+/** Default config: 20 Hz, normal scheduling. */
+vps_output_thread_config_t vps_output_thread_default_config(void);
+
+/**
+ * Start the output thread. rt->fusion, rt's output sink and its FC
+ * reader (vps_runtime_attach_fc) belong to the thread until stop
+ * returns. If rt_priority is set but SCHED_FIFO is not permitted, the
+ * thread runs with normal scheduling (see stats.realtime).
+ * @return false on timerfd or thread creation failure
+ */
+bool vps_output_thread_start(vps_output_thread_t *ot, vps_runtime_t *rt,
+                             const vps_output_thread_config_t *cfg);
+
+/** Hand a visual fix to the output thread (any one producer thread). */
+void vps_output_thread_post(vps_output_thread_t *ot, const vps_visual_fix_t *fix);
+
+/** Stop the thread and close the timer. */
+void vps_output_thread_stop(vps_output_thread_t *ot);
+
+/** Snapshot statistics (safe while running). */
+void vps_output_thread_stats(const vps_output_thread_t *ot, vps_output_stats_t *out);
+
+/**
+ * One tick of work, exposed for tests and single-threaded use: fold in a
+ * pending fix (choosing among its candidates first), then produce the
+ * output for time t.
+ */
+vps_fusion_output_t vps_output_tick(vps_fusion_t *f, const vps_visual_fix_t *fix, double t);
+
+#endif /* OUTPUT_THREAD_H */
@@ -0,0 +1,125 @@
+/**
+ * @file pipeline.h
+ * @brief Multi-stage pipelined runtime around vps_core.
+ *
+ * capture → retrieval → matching/homography → fusion → output, one
+ * thread per stage, connected by bounded SPSC ring queues. Throughput
+ * approaches the slowest stage instead of the sum of all stages.
+ *
+ * The capture queue uses latest-frame-wins back-pressure by default:
+ * when retrieval falls behind, stale frames are evicted rather than
+ * delaying new ones. Downstream queues block the producer instead, so
+ * every located frame reaches fusion in order.
+ */
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "output_thread.h"
+#include "runtime.h"
+#include "spsc_queue.h"
+#include <pthread.h>
+
+typedef enum {
+    VPS_STAGE_CAPTURE = 0,
+    VPS_STAGE_RETRIEVAL,
+    VPS_STAGE_MATCH,
+    VPS_STAGE_FUSION,
+    VPS_STAGE_OUTPUT,
+    VPS_STAGE_COUNT,
+} vps_stage_t;
+
+/** Queue feeding stage i is queue i-1 (capture has no input queue). */
+#define VPS_PIPE_QUEUES (VPS_STAGE_COUNT - 1)
+
+typedef enum {
+    VPS_QUEUE_BLOCK = 0,   /* producer waits for space */
+    VPS_QUEUE_LATEST = 1,  /* producer evicts the oldest element */
+} vps_queue_policy_t;
+
+/** Called from the output stage after each frame is written. */
+typedef void (*vps_pipeline_output_fn)(void *ctx, const vps_fusion_output_t *out,
+                                       double t_capture, uint32_t seq);
+
+typedef struct {
+    uint32_t queue_capacity[VPS_PIPE_QUEUES];
+    vps_queue_policy_t queue_policy[VPS_PIPE_QUEUES];
+    vps_pipeline_output_fn on_output;  /* may be NULL */
+    void *on_output_ctx;
+    /** If set, fixes are posted to this fixed-rate thread, which then owns
+     * fusion and output (candidate selection included); the fusion/output
+     * stages only count frames. */
+    vps_output_thread_t *output_thread;
+} vps_pipeline_config_t;
+
+/** Per-stage counters. Times are cumulative nanoseconds. */
+typedef struct {
+    uint64_t processed;
+    uint64_t dropped;        /* evicted/rejected from this stage's input queue */
+    uint32_t queue_depth;    /* current input queue depth */
+    uint32_t queue_max_depth;
+    uint64_t wait_ns;        /* idle, waiting for input */
+    uint64_t block_ns;       /* waiting for space downstream */
+    uint64_t busy_ns;        /* doing work */
+} vps_stage_stats_t;
+
+typedef struct {
+    _Alignas(VPS_CACHE_LINE) _Atomic uint64_t processed;
+    _Atomic uint64_t wait_ns;
+    _Atomic uint64_t block_ns;
+    _Atomic uint64_t busy_ns;
+} vps_stage_counters_t;
+
+typedef struct vps_pipeline vps_pipeline_t;
+
+typedef struct {
+    vps_pipeline_t *pipe;
+    vps_stage_t stage;
+} vps_stage_arg_t;
+
+struct vps_pipeline {
+    vps_runtime_t *rt;
+    vps_pipeline_config_t cfg;
+
+    vps_spsc_queue_t queues[VPS_PIPE_QUEUES];
+    vps_stage_counters_t counters[VPS_STAGE_COUNT];
+    _Atomic bool stage_done[VPS_STAGE_COUNT];
+    _Atomic bool stop;
+
+    /* Frame copies owned by the pipeline (source buffers are reused) */
+    uint8_t **pool;
+    size_t *pool_len;
+    _Atomic bool *pool_busy;
+    uint32_t pool_size;
+
+    pthread_t threads[VPS_STAGE_COUNT];
+    vps_stage_arg_t args[VPS_STAGE_COUNT];
+    bool running;
+};
+
+/** Default queues: 2 latest-wins capture slots, 4 blocking slots elsewhere. */
+vps_pipeline_config_t vps_pipeline_default_config(void);
+
+/**
+ * Start stage threads. rt is owned by the pipeline until join/stop
+ * returns: its fusion state is touched only by the fusion stage.
+ * @return false on allocation or thread creation failure
+ */
+bool vps_pipeline_start(vps_pipeline_t *p, vps_runtime_t *rt,
+                        const vps_pipeline_config_t *cfg);
+
+/** Wait until the source is exhausted and every queue has drained. */
+void vps_pipeline_join(vps_pipeline_t *p);
+
+/** Ask all stages to exit promptly, then join. */
+void vps_pipeline_stop(vps_pipeline_t *p);
+
+/** Snapshot per-stage counters (safe while running and after join). */
+void vps_pipeline_stats(const vps_pipeline_t *p, vps_stage_stats_t out[VPS_STAGE_COUNT]);
+
+/** Release queues and frame buffers after join/stop. */
+void vps_pipeline_free(vps_pipeline_t *p);
+
+/** Stage name for logs. */
+const char *vps_stage_name(vps_stage_t stage);
+
+#endif /* PIPELINE_H */
@@ -0,0 +1,214 @@
+/**
+ * @file runtime.h
+ * @brief Native positioning loop: capture → retrieval → matching →
+ *        homography → fusion → NMEA/MSP output.
+ *
+ * Capture and matching are pluggable backends so vps_core keeps no
+ * external dependencies (OpenCV / ONNX Runtime live in the backends).
+ */
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#include "vps_types.h"
+#include "config.h"
+#include "fusion.h"
+#include "msp.h"
+#include <stddef.h>
+
+#define VPS_RUNTIME_MAX_CANDIDATES 16
+#define VPS_RUNTIME_OUT_MAX 256   /* GGA + RMC, or one MSP frame */
+
+/** One captured camera frame (8-bit grayscale). */
+typedef struct {
+    const uint8_t *pixels;  /* NULL for replayed frames */
+    int width;
+    int height;
+    int stride;
+    double t;               /* capture timestamp (monotonic s) */
+    uint32_t seq;
+} vps_frame_t;
+
+/** Frame source backend. grab() returns false when the source is exhausted. */
+typedef struct {
+    void *ctx;
+    bool (*grab)(void *ctx, vps_frame_t *frame);
+} vps_frame_source_t;
+
+/** Fine match of one frame against one tile. */
+typedef struct {
+    vps_tile_coord_t tile;
+    double H[9];          /* drone → tile homography, row-major */
+    int num_matches;
+    double inlier_ratio;
+    double confidence;
+} vps_match_t;
+
+/** Retrieval + fine matching backend. */
+typedef struct {
+    void *ctx;
+    /** Top-k candidate tiles for a frame. @return number written */
+    int (*retrieve)(void *ctx, const vps_frame_t *frame,
+                    vps_tile_coord_t *out, int max_out);
+    /** Match frame against tile. @return false if no homography */
+    bool (*match)(void *ctx, const vps_frame_t *frame,
+                  vps_tile_coord_t tile, vps_match_t *out);
+} vps_matcher_t;
+
+/** Serial output protocol. */
+typedef enum {
+    VPS_OUTPUT_NMEA = 0,  /* $GPGGA + $GPRMC */
+    VPS_OUTPUT_MSP = 1,   /* MSP_SET_RAW_GPS */
+} vps_output_protocol_t;
+
+/** Byte sink for encoded output. @return false on write error */
+typedef bool (*vps_write_fn)(void *ctx, const uint8_t *data, size_t len);
+
+/** Non-blocking byte source for FC replies. @return bytes read, 0 if none wait */
+typedef size_t (*vps_read_fn)(void *ctx, uint8_t *buf, size_t cap);
+
+/** Runtime state. */
+typedef struct {
+    vps_frame_source_t source;
+    vps_matcher_t matcher;
+    vps_fusion_t fusion;
+
+    int min_matches;
+    double min_inlier_ratio;
+    int max_candidates;
+    bool score_candidates;  /* match every candidate, pick by EKF distance */
+    bool batch_fixes;       /* match every candidate, fuse all in one EKF step */
+
+    vps_output_protocol_t protocol;
+    vps_write_fn write;    /* NULL = discard output */
+    void *write_ctx;
+
+    /* FC telemetry (vps_runtime_attach_fc); read NULL = not polled */
+    vps_read_fn read;
+    void *read_ctx;
+    vps_imu_nav_t *imu;
+    vps_msp_parser_t fc_parser;
+
+    uint32_t frames;
+    uint32_t fixes;
+    uint32_t misses;
+} vps_runtime_t;
+
+/** Result of locating one frame (retrieval + matching + homography). */
+typedef struct {
+    bool has_fix;
+    vps_geopoint_t position;
+    double hdop;
+    vps_match_t match;
+    double retrieval_ms;
+    double match_ms;
+
+    /* Every accepted candidate (only with score_candidates/batch_fixes) */
+    int n_fixes;
+    vps_geopoint_t fix_position[VPS_RUNTIME_MAX_CANDIDATES];
+    double fix_hdop[VPS_RUNTIME_MAX_CANDIDATES];
+    vps_match_t fix_match[VPS_RUNTIME_MAX_CANDIDATES];
+} vps_locate_result_t;
+
+/** Result of one full loop iteration. */
+typedef struct {
+    vps_frame_t frame;
+    vps_locate_result_t loc;
+    vps_fusion_output_t out;
+    int bytes_out;
+    double total_ms;
+} vps_step_result_t;
+
+/** Monotonic clock in seconds. */
+double vps_monotonic_s(void);
+
+/** Initialize runtime from config. fence may be NULL. */
+void vps_runtime_init(vps_runtime_t *rt, const vps_config_t *cfg,
+                      vps_frame_source_t source, vps_matcher_t matcher,
+                      vps_geofence_t *fence);
+
+/**
+ * Coarse retrieval stage.
+ * @param out candidate buffer (>= VPS_RUNTIME_MAX_CANDIDATES)
+ * @return number of candidates written
+ */
+int vps_runtime_retrieve(const vps_runtime_t *rt, const vps_frame_t *frame,
+                         vps_tile_coord_t *out);
+
+/**
+ * Fine matching + homography stage: match candidates in order until the
+ * first accepted homography (same acceptance rules as _try_match_frame
+ * in main.py). With rt->score_candidates (or rt->batch_fixes) every
+ * candidate is matched and
+ * all accepted ones are kept in fix_*; the first is still reported as
+ * position until vps_runtime_select_fix() picks one.
+ * Fills everything in res except retrieval_ms.
+ * @return true if a visual fix was produced
+ */
+bool vps_runtime_match(const vps_runtime_t *rt, const vps_frame_t *frame,
+                       const vps_tile_coord_t *candidates, int n,
+                       vps_locate_result_t *res);
+
+/**
+ * Choose among several accepted candidates the one closest to the fusion
+ * EKF at time t (smallest Mahalanobis distance, see vps_fusion_select)
+ * and make it res->position/hdop/match. Must run where fusion is owned.
+ * @return index of the chosen fix
+ */
+int vps_runtime_select_fix(const vps_runtime_t *rt, vps_locate_result_t *res, double t);
+
+/**
+ * Fuse a located frame at time t: all accepted candidates as one batch
+ * with rt->batch_fixes (see vps_fusion_update_batch), otherwise the
+ * chosen position. Must run where fusion is owned.
+ */
+vps_fusion_output_t vps_runtime_fuse(vps_runtime_t *rt, const vps_locate_result_t *res,
+                                     double t);
+
+/**
+ * Retrieval followed by matching.
+ * @return true if a visual fix was produced
+ */
+bool vps_runtime_locate(const vps_runtime_t *rt, const vps_frame_t *frame,
+                        vps_locate_result_t *res);
+
+/**
+ * Encode a fusion output for the flight controller.
+ * @param buf output buffer (>= VPS_RUNTIME_OUT_MAX bytes)
+ * @return number of bytes written
+ */
+int vps_runtime_encode(vps_output_protocol_t protocol,
+                       const vps_fusion_output_t *out,
+                       uint8_t *buf, size_t buflen);
+
+/**
+ * Encode a fusion output with rt->protocol and pass it to rt->write.
+ * @return number of bytes produced
+ */
+int vps_runtime_emit(const vps_runtime_t *rt, const vps_fusion_output_t *out);
+
+/**
+ * Poll the FC for MSP_RAW_IMU and MSP_ATTITUDE. Requests go out through
+ * rt->write after each output; replies come in through read and feed
+ * imu, which is attached to rt->fusion for predictions between visual
+ * fixes. Replies are stamped with vps_monotonic_s(), so frame times must
+ * use that clock. The IMU rate is the output rate. imu NULL detaches.
+ */
+void vps_runtime_attach_fc(vps_runtime_t *rt, vps_imu_nav_t *imu, vps_read_fn read, void *ctx);
+
+/** Send the FC poll requests through rt->write. Runs where output is written. */
+void vps_runtime_request_fc(const vps_runtime_t *rt);
+
+/**
+ * Parse waiting FC replies into rt->imu. Must run where fusion is owned.
+ * @return number of replies consumed
+ */
+int vps_runtime_read_fc(vps_runtime_t *rt);
+
+/**
+ * Run one loop iteration: read FC replies, grab, locate, fuse, encode,
+ * write, request FC telemetry.
+ * @return false when the frame source is exhausted
+ */
+bool vps_runtime_step(vps_runtime_t *rt, vps_step_result_t *res);
+
+#endif /* RUNTIME_H */
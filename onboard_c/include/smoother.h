@@ -0,0 +1,133 @@
+/**
+ * @file smoother.h
+ * @brief Fixed-lag Rauch–Tung–Striebel smoother over VPSF flight recordings.
+ *
+ * Re-runs the 4-state EKF forward over the recorded visual fixes and
+ * smooths it backwards in blocks: once 2·lag steps are buffered, one RTS
+ * pass runs over the block and the oldest lag steps are emitted, so each
+ * output has between lag and 2·lag later steps of hindsight. Memory is
+ * fixed (VPS_SMOOTHER_MAX_LAG), cost is two backward steps per record.
+ *
+ * The backward step avoids forming the RTS gain: with
+ * C_k = P_k F' P⁻_{k+1}⁻¹ only C_k·(x^s_{k+1} − x⁻_{k+1}) is needed, i.e.
+ * one 4x4 Cholesky solve and a 4x4 product. Only the smoothed state is
+ * computed, not its covariance.
+ *
+ * VPSF records are the onboard/flight_recorder.py format ("<3d5fBBHfHH",
+ * 56 bytes little-endian, after an 8-byte "VPSF" header).
+ */
+#ifndef SMOOTHER_H
+#define SMOOTHER_H
+
+#include "ekf.h"
+#include <stdio.h>
+
+#define VPS_VPSF_HEADER_SIZE 8
+#define VPS_VPSF_RECORD_SIZE 56
+#define VPS_VPSF_VERSION 2
+
+/* Source codes and flag bits (as in flight_recorder.py) */
+#define VPS_VPSF_SOURCE_VISUAL 1
+#define VPS_VPSF_FLAG_GEOFENCE_OK 0x01
+#define VPS_VPSF_FLAG_EKF_ACCEPTED 0x02
+#define VPS_VPSF_FLAG_BLUR_SKIP 0x04
+#define VPS_VPSF_FLAG_SMOOTHED 0x08
+
+#define VPS_SMOOTHER_MAX_LAG 512
+#define VPS_SMOOTHER_DEFAULT_LAG 100
+
+/** One flight recorder record. */
+typedef struct {
+    double timestamp;
+    double lat, lon;
+    float vn_mps, ve_mps;
+    float hdop;
+    float speed_mps, heading_deg;
+    uint8_t fix_quality;
+    uint8_t source;
+    uint16_t match_count;
+    float inlier_ratio;
+    uint16_t latency_ms;
+    uint16_t flags;
+} vps_vpsf_record_t;
+
+/** Decode VPS_VPSF_RECORD_SIZE bytes. */
+void vps_vpsf_decode(const uint8_t *buf, vps_vpsf_record_t *rec);
+
+/** Encode into VPS_VPSF_RECORD_SIZE bytes. */
+void vps_vpsf_encode(uint8_t *buf, const vps_vpsf_record_t *rec);
+
+/** Write the file header. */
+void vps_vpsf_encode_header(uint8_t *buf);
+
+/** @return false unless buf is a VPSF header, version 1..VPS_VPSF_VERSION, with 56-byte records */
+bool vps_vpsf_check_header(const uint8_t *buf);
+
+typedef struct {
+    int lag;                /* steps of hindsight, 1..VPS_SMOOTHER_MAX_LAG */
+    vps_ekf_config_t ekf;   /* forward filter (gate, noise, max gap) */
+} vps_smoother_config_t;
+
+typedef void (*vps_smoother_emit_fn)(void *ctx, const vps_vpsf_record_t *rec);
+
+typedef struct {
+    uint64_t records;
+    uint64_t fixes;         /* visual records fused */
+    uint64_t rejected;      /* visual records outside the gate */
+    uint64_t resets;        /* filter restarts after gaps */
+    uint64_t smoothed;      /* records emitted with a smoothed position */
+} vps_smoother_stats_t;
+
+/** One buffered step: forward prediction and posterior. */
+typedef struct {
+    vps_vpsf_record_t rec;
+    double xp[4], pp[VPS_EKF_PACKED];   /* predicted (prior) */
+    double xf[4], pf[VPS_EKF_PACKED];   /* filtered (posterior) */
+    double dt;                           /* from the previous step */
+} vps_smoother_step_t;
+
+/**
+ * Smoother state. Holds 2·VPS_SMOOTHER_MAX_LAG steps (~300 KiB); keep it
+ * static or on the heap.
+ */
+typedef struct {
+    vps_smoother_config_t cfg;
+    vps_smoother_emit_fn emit;
+    void *emit_ctx;
+
+    vps_smoother_step_t steps[2 * VPS_SMOOTHER_MAX_LAG];
+    int n;
+    bool initialized;
+    double last_t;
+    double xs[4];   /* backward-pass scratch */
+
+    vps_smoother_stats_t stats;
+} vps_smoother_t;
+
+/** Defaults: lag VPS_SMOOTHER_DEFAULT_LAG, vps_ekf_default_config(). */
+vps_smoother_config_t vps_smoother_default_config(void);
+
+/** Initialize. cfg may be NULL for defaults. */
+void vps_smoother_init(vps_smoother_t *s, const vps_smoother_config_t *cfg,
+                       vps_smoother_emit_fn emit, void *ctx);
+
+/**
+ * Add the next record (time order). Records are emitted in input order;
+ * those covered by the filter get smoothed lat/lon/velocity/speed/heading
+ * and VPS_VPSF_FLAG_SMOOTHED, the rest pass through unchanged.
+ */
+void vps_smoother_push(vps_smoother_t *s, const vps_vpsf_record_t *rec);
+
+/** Smooth and emit everything still buffered (end of file). */
+void vps_smoother_flush(vps_smoother_t *s);
+
+/**
+ * Smooth a VPSF file into another, streaming through a fixed buffer.
+ * Records before a truncated last record are still smoothed and written.
+ * @return false on I/O error, a bad header or a truncated last record
+ *         (stats may be NULL)
+ */
+bool vps_smoother_run_file(FILE *in, FILE *out, const vps_smoother_config_t *cfg,
+                           vps_smoother_stats_t *stats);
+
+#endif /* SMOOTHER_H */
@@ -0,0 +1,62 @@
+/**
+ * @file snapshot.h
+ * @brief Lock-free publication of fusion snapshots to any number of readers.
+ *
+ * One writer (the thread that owns vps_fusion_t) publishes an immutable
+ * copy of the latest output and filter state; status, health and
+ * telemetry threads read consistent copies without locks and without
+ * ever delaying the writer.
+ *
+ * The layout is a double-buffered seqlock (a "latch"): the sequence
+ * counter is bumped before each of the two copies is rewritten, and
+ * readers always read the copy the writer is not touching (seq & 1).
+ * A read retries only if the writer completed a whole half-cycle
+ * during the copy, so readers never spin on an in-progress write.
+ * Copies go through relaxed atomic 64-bit words, which keeps the
+ * protocol free of data races in C11 and costs plain loads and stores
+ * on x86_64 and aarch64.
+ */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "fusion.h"
+#include "spsc_queue.h"
+#include <stdatomic.h>
+
+/** One published state. */
+typedef struct {
+    double t;                   /* output time */
+    uint64_t version;           /* 1 for the first publish, then +1 */
+    vps_fusion_output_t out;
+    vps_ekf_state_t ekf;
+    vps_dr_state_t dr;
+} vps_fusion_snapshot_t;
+
+#define VPS_SNAPSHOT_WORDS ((sizeof(vps_fusion_snapshot_t) + 7) / 8)
+
+typedef struct {
+    _Alignas(VPS_CACHE_LINE) _Atomic uint32_t seq;
+    _Alignas(VPS_CACHE_LINE) _Atomic uint64_t copy[2][VPS_SNAPSHOT_WORDS];
+    uint64_t version;           /* writer-owned */
+} vps_fusion_pub_t;
+
+/** Initialize with nothing published. */
+void vps_fusion_pub_init(vps_fusion_pub_t *p);
+
+/** Writer: publish the state of f with its output for time t. Wait-free. */
+void vps_fusion_publish(vps_fusion_pub_t *p, const vps_fusion_t *f,
+                        const vps_fusion_output_t *out, double t);
+
+/** Writer: publish a prepared snapshot (its version is overwritten). */
+void vps_fusion_publish_snapshot(vps_fusion_pub_t *p, const vps_fusion_snapshot_t *s);
+
+/**
+ * Reader: copy the latest snapshot (any thread, any number of readers).
+ * @param retries copies discarded because the writer overtook the read
+ *                (may be NULL)
+ * @return false if nothing has been published yet
+ */
+bool vps_fusion_snapshot_read(const vps_fusion_pub_t *p, vps_fusion_snapshot_t *out,
+                              uint32_t *retries);
+
+#endif /* SNAPSHOT_H */
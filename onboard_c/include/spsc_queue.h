@@ -0,0 +1,62 @@
+/**
+ * @file spsc_queue.h
+ * @brief Bounded lock-free single-producer/single-consumer ring queue.
+ *
+ * Fixed-size elements are copied in and out. Besides the usual
+ * reject-when-full push, vps_spsc_push_latest() evicts the oldest
+ * element so a slow consumer always sees the freshest data
+ * (latest-frame-wins back-pressure).
+ */
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include "vps_types.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+#define VPS_CACHE_LINE 64
+
+typedef struct {
+    _Alignas(VPS_CACHE_LINE) _Atomic uint32_t head;  /* consumer index */
+    _Alignas(VPS_CACHE_LINE) _Atomic uint32_t tail;  /* producer index */
+    _Alignas(VPS_CACHE_LINE) uint32_t capacity;       /* power of two */
+    uint32_t mask;
+    size_t elem_size;
+    uint8_t *slots;
+
+    /* Counters (written by one side, read by anyone) */
+    _Atomic uint64_t pushed;
+    _Atomic uint64_t popped;
+    _Atomic uint64_t dropped;   /* evicted by push_latest or rejected */
+    _Atomic uint32_t max_depth;
+} vps_spsc_queue_t;
+
+/**
+ * Allocate a queue. capacity is rounded up to a power of two.
+ * @return false on allocation failure
+ */
+bool vps_spsc_init(vps_spsc_queue_t *q, uint32_t capacity, size_t elem_size);
+
+/** Release queue memory. */
+void vps_spsc_free(vps_spsc_queue_t *q);
+
+/** Producer: copy item in. @return false if full (counted as dropped) */
+bool vps_spsc_push(vps_spsc_queue_t *q, const void *item);
+
+/** Producer: try to push without counting a drop when full. */
+bool vps_spsc_try_push(vps_spsc_queue_t *q, const void *item);
+
+/**
+ * Producer: push, evicting the oldest element if full.
+ * @param evicted if non-NULL, receives a copy of the evicted element
+ * @return true if an element was evicted
+ */
+bool vps_spsc_push_latest(vps_spsc_queue_t *q, const void *item, void *evicted);
+
+/** Consumer: copy the oldest item out. @return false if empty */
+bool vps_spsc_pop(vps_spsc_queue_t *q, void *out);
+
+/** Current number of queued elements (approximate under concurrency). */
+uint32_t vps_spsc_depth(const vps_spsc_queue_t *q);
+
+#endif /* SPSC_QUEUE_H */
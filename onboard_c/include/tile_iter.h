@@ -0,0 +1,62 @@
+/**
+ * @file tile_iter.h
+ * @brief Lazy, distance-ordered tile iteration over a circle or an EKF
+ *        uncertainty ellipse.
+ *
+ * The iterator walks square rings around the tile holding the point:
+ * ring 0 is that tile, ring k the 8k tiles at Chebyshev distance k.
+ * Within a ring it goes outward from the ring's axes, so the tiles level
+ * with the point come first and the corners last. Every tile of ring k
+ * lies at least k - 1 tile widths from the point, so a caller can stop
+ * after the first few rings (lower max_ring, or stop calling next).
+ *
+ * Only tiles touching the region are produced. The region is an ellipse
+ * in tile units, clipped exactly per ring side: the ellipse's extent
+ * across the side's row or column gives the range of tiles on that side,
+ * so tiles outside it are skipped without being visited. A circle is
+ * flat at the point's latitude (tile width from vps_meters_per_pixel);
+ * an EKF ellipse is its lat/lon covariance through the Mercator Jacobian
+ * at the point. Columns wrap at the antimeridian, rows stop at the map
+ * edge, and a region wider than the world is cut half a world either
+ * side of the point so no tile repeats.
+ *
+ * The state is a small struct; nothing is allocated.
+ */
+#ifndef TILE_ITER_H
+#define TILE_ITER_H
+
+#include "ekf.h"
+#include "vps_types.h"
+
+typedef struct {
+    int zoom;
+    int cx, cy;                 /* tile of the point */
+    double fx, fy;              /* point within it, tile units */
+    double sxx, sxy, syy;       /* ellipse shape (x east, y south), tile units^2 */
+    double tile_m;              /* tile width at the point, metres */
+    int x_lo, x_hi;             /* column offsets kept, half a world each side */
+    int ring;                   /* ring of the last tile produced */
+    int max_ring;               /* last ring; callers may lower it */
+    int t, t_end;               /* distance from the ring's axes, and its bound */
+    int side;                   /* next of the 8 candidates at t */
+    int lo[4], hi[4];           /* tile range along each side of the ring (E W S N) */
+} vps_tile_iter_t;
+
+/** Tiles at a zoom touching the circle of radius_m around center. */
+void vps_tile_iter_circle(vps_tile_iter_t *it, vps_geopoint_t center, double radius_m,
+                          int zoom);
+
+/**
+ * Tiles touching the n_sigma position ellipse of an EKF state (x[0..1]
+ * and the lat/lon block of P).
+ */
+void vps_tile_iter_ellipse(vps_tile_iter_t *it, const vps_ekf_state_t *ekf, double n_sigma,
+                           int zoom);
+
+/** Next tile. @return false when the region is exhausted */
+bool vps_tile_iter_next(vps_tile_iter_t *it, vps_tile_coord_t *out);
+
+/** Lower bound on the distance of every tile still to come, metres. */
+double vps_tile_iter_min_dist_m(const vps_tile_iter_t *it);
+
+#endif /* TILE_ITER_H */
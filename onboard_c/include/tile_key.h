@@ -0,0 +1,103 @@
+/**
+ * @file tile_key.h
+ * @brief Morton tile keys and an open-addressing tile hash map.
+ *
+ * A tile key holds the zoom in its top 6 bits and the Morton code of
+ * (x, y) in its low 2z bits: x on the even bits, y on the odd bits. Each
+ * level adds two bits, so the Morton code read two bits at a time from
+ * the top is the tile's quadkey. Parent and children are shifts. The
+ * neighbours are dilated-integer adds on the x or y bits. Columns wrap at
+ * the antimeridian; rows off the map have no neighbour.
+ *
+ * vps_tile_map_t maps keys to uint32 values, normally the tile's index in
+ * the pack's tile list (its retrieval row). It uses linear probing over
+ * 16-byte key/value slots in a power-of-two table kept at most half full,
+ * with Fibonacci hashing of the key. A hit usually reads one cache line,
+ * so a 1M-tile pack (32 MB of slots) costs about one memory access per
+ * lookup. Tiles cannot be removed; a pack is built once.
+ */
+#ifndef TILE_KEY_H
+#define TILE_KEY_H
+
+#include "vps_types.h"
+#include <stddef.h>
+
+typedef uint64_t vps_tile_key_t;
+
+#define VPS_TILE_KEY_MAX_ZOOM 29
+#define VPS_TILE_KEY_NONE UINT64_MAX    /* not a tile; also the empty slot */
+#define VPS_TILE_MAP_NONE UINT32_MAX    /* value of a missing key in batches */
+
+/** Key of a tile (zoom up to VPS_TILE_KEY_MAX_ZOOM, x and y inside it). */
+vps_tile_key_t vps_tile_key(vps_tile_coord_t tile);
+
+/** Tile of a key. */
+vps_tile_coord_t vps_tile_key_coord(vps_tile_key_t key);
+
+/** Zoom of a key. */
+int vps_tile_key_zoom(vps_tile_key_t key);
+
+/** Ancestor at a zoom <= the key's; VPS_TILE_KEY_NONE above it. */
+vps_tile_key_t vps_tile_key_ancestor(vps_tile_key_t key, int zoom);
+
+/** Parent tile; VPS_TILE_KEY_NONE at zoom 0. */
+vps_tile_key_t vps_tile_key_parent(vps_tile_key_t key);
+
+/**
+ * Child by quadkey digit (0 NW, 1 NE, 2 SW, 3 SE); VPS_TILE_KEY_NONE at
+ * the max zoom.
+ */
+vps_tile_key_t vps_tile_key_child(vps_tile_key_t key, int digit);
+
+/**
+ * Neighbour dx columns east and dy rows south (each -1, 0 or 1).
+ * @return false off the top or bottom of the map
+ */
+bool vps_tile_key_neighbor(vps_tile_key_t key, int dx, int dy, vps_tile_key_t *out);
+
+/** Quadkey string (zoom digits and a NUL into out). @return its length */
+int vps_tile_key_quadkey(vps_tile_key_t key, char *out);
+
+/** Key of a quadkey string. @return false if malformed or too long */
+bool vps_tile_key_from_quadkey(const char *quadkey, vps_tile_key_t *out);
+
+/* --- Hash map --- */
+
+typedef struct {
+    vps_tile_key_t key;
+    uint32_t value;
+} vps_tile_slot_t;
+
+typedef struct {
+    vps_tile_slot_t *slots;
+    size_t mask;                /* capacity - 1 */
+    int shift;                  /* 64 - log2(capacity) */
+    int count;
+} vps_tile_map_t;
+
+/** Empty map sized for expected keys. @return false on allocation failure */
+bool vps_tile_map_init(vps_tile_map_t *m, int expected);
+
+/** Map keys[i] to i. @return false on allocation failure */
+bool vps_tile_map_build(vps_tile_map_t *m, const vps_tile_key_t *keys, int n);
+
+void vps_tile_map_free(vps_tile_map_t *m);
+
+/**
+ * Insert or replace, growing the table past half full.
+ * @return false for VPS_TILE_KEY_NONE or on allocation failure
+ */
+bool vps_tile_map_put(vps_tile_map_t *m, vps_tile_key_t key, uint32_t value);
+
+/** @return false if key is not in the map */
+bool vps_tile_map_get(const vps_tile_map_t *m, vps_tile_key_t key, uint32_t *value_out);
+
+/**
+ * Look up n keys, prefetching a few ahead so the memory accesses overlap.
+ * Missing keys give VPS_TILE_MAP_NONE.
+ * @return number found
+ */
+int vps_tile_map_get_batch(const vps_tile_map_t *m, const vps_tile_key_t *keys, int n,
+                           uint32_t *values_out);
+
+#endif /* TILE_KEY_H */
@@ -19,7 +19,10 @@ double vps_haversine_km(vps_geopoint_t a, vps_geopoint_t b);
 /** Ground resolution in meters per pixel. */
 double vps_meters_per_pixel(double lat, int zoom);
 
-/** Number of tiles covering a radius around a center point. */
+/**
+ * Tiles touching the circle of radius_km around center, nearest ring
+ * first (vps_tile_iter_circle), at most max_out. @return count
+ */
 int vps_tiles_in_radius(vps_geopoint_t center, double radius_km, int zoom,
                         vps_tile_coord_t *out, int max_out);
 
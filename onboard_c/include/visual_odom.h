@@ -0,0 +1,105 @@
+/**
+ * @file visual_odom.h
+ * @brief Frame-to-frame visual odometry for dead reckoning between fixes.
+ *
+ * Corners are picked on a coarse pyramid level (best Shi-Tomasi score
+ * per grid cell) and tracked into the next frame with pyramidal
+ * Lucas-Kanade. Patches are sampled with 7-bit fixed-point bilinear
+ * weights and the LK sums are exact integers, so the NEON, SSE2 and
+ * scalar kernels give identical tracks. A 2-D similarity (shift,
+ * rotation, scale) is fitted to the tracks with a small deterministic
+ * RANSAC and converted to a metric camera displacement with the ground
+ * sample distance (altitude / focal length) and the heading.
+ *
+ * The camera is assumed to look straight down with the image top
+ * towards the nose. Feed the displacements to vps_fusion_odometry().
+ */
+#ifndef VISUAL_ODOM_H
+#define VISUAL_ODOM_H
+
+#include "vps_types.h"
+
+#define VPS_VO_WIN 16             /* LK window (pixels, square) */
+#define VPS_VO_MAX_LEVELS 5
+#define VPS_VO_MAX_FEATURES 256
+
+typedef struct {
+    int levels;           /* pyramid levels incl. full resolution (default 3) */
+    int grid;             /* features: best corner per grid x grid cell (default 10) */
+    int max_iters;        /* LK iterations per level (default 10) */
+    double min_eig;       /* min gradient eigenvalue, (grey/px)^2 (default 4) */
+    double max_fb_px;     /* forward-backward check, 0 = off (default 0.5) */
+    double inlier_px;     /* RANSAC inlier distance (default 1.5) */
+    int min_inliers;      /* fewer is a failed estimate (default 12) */
+    double focal_px;      /* camera focal length in pixels (default 500) */
+    double hdop_per_m;    /* HDOP added per metre of odometry (default 0.02) */
+} vps_vo_config_t;
+
+/** Motion between the previous and the current frame. */
+typedef struct {
+    bool valid;
+    double dx_px, dy_px;  /* scene shift at the image centre (x right, y down) */
+    double dtheta_rad;    /* scene rotation, clockwise on screen */
+    double scale;         /* scene scale (> 1: camera descended) */
+    double fwd_m, right_m;/* camera displacement in the body frame */
+    double dn_m, de_m;    /* camera displacement north / east */
+    double hdop_add;      /* uncertainty added by this step */
+    double rms_px;        /* inlier residual */
+    int features;         /* corners in the previous frame */
+    int tracked;          /* tracks that survived LK and the FB check */
+    int inliers;
+} vps_vo_motion_t;
+
+typedef struct {
+    uint8_t *px;          /* w x h, stride w */
+    int w, h;
+} vps_vo_image_t;
+
+typedef struct {
+    vps_vo_config_t cfg;
+    int width, height;
+    vps_vo_image_t pyr[2][VPS_VO_MAX_LEVELS];
+    int cur;              /* pyramid of the latest frame */
+    bool has_prev;
+    int n_features;       /* corners of the latest frame, level-0 pixels */
+    float features[VPS_VO_MAX_FEATURES][2];
+    int32_t *score;       /* corner score scratch (selection level) */
+    uint64_t frames;
+} vps_vo_t;
+
+/** Default configuration. */
+vps_vo_config_t vps_vo_default_config(void);
+
+/**
+ * Allocate pyramids for width x height frames (cfg may be NULL).
+ * @return false on allocation failure or frames too small for the pyramid
+ */
+bool vps_vo_init(vps_vo_t *vo, const vps_vo_config_t *cfg, int width, int height);
+
+/** Release buffers. */
+void vps_vo_free(vps_vo_t *vo);
+
+/** Forget the previous frame (e.g. after a gap). */
+void vps_vo_reset(vps_vo_t *vo);
+
+/**
+ * Add a grayscale frame and estimate the motion since the previous one.
+ * @param altitude_m  height above ground at this frame
+ * @param heading_deg heading of the image top (0 = north, clockwise)
+ * @return false on the first frame or if the estimate failed (out->valid)
+ */
+bool vps_vo_process(vps_vo_t *vo, const uint8_t *pixels, int stride,
+                    double altitude_m, double heading_deg, vps_vo_motion_t *out);
+
+/**
+ * Track level-0 points pts0 of the previous frame into the current one
+ * with pyramidal LK. Exposed for tests.
+ * @return number of points tracked (status[i] set for each)
+ */
+int vps_vo_track(const vps_vo_t *vo, const float (*pts0)[2], int n,
+                 float (*pts1)[2], bool *status);
+
+/** Kernel set compiled in: "neon", "sse2" or "scalar". */
+const char *vps_vo_isa(void);
+
+#endif /* VISUAL_ODOM_H */
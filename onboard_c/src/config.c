@@ -0,0 +1,298 @@
+/**
+ * @file config.c
+ * @brief Minimal JSON reader for the VPSConfig schema.
+ *
+ * Only what pydantic's model_dump_json emits is supported: objects,
+ * strings, numbers, booleans and null. Arrays are skipped.
+ */
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void vps_config_defaults(vps_config_t *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    strcpy(cfg->map_pack, "/opt/vps/maps/map_pack");
+
+    strcpy(cfg->camera.device, "0");
+    cfg->camera.width = 640;
+    cfg->camera.height = 640;
+    cfg->camera.fps = 10;
+    cfg->camera.use_picamera2 = false;
+
+    strcpy(cfg->uart.port, "/dev/ttyAMA0");
+    cfg->uart.baudrate = 9600;
+    cfg->uart.enabled = true;
+
+    strcpy(cfg->matcher.superpoint_onnx, "models/superpoint.onnx");
+    strcpy(cfg->matcher.lightglue_onnx, "models/lightglue.onnx");
+    cfg->matcher.min_matches = 15;
+    cfg->matcher.confidence_threshold = 0.3;
+    cfg->matcher.max_candidates = 5;
+    cfg->matcher.use_orb_fallback = false;
+
+    cfg->target_hz = 3.0;
+    strcpy(cfg->log_level, "INFO");
+    cfg->ekf_measurement_noise = 1e-8;
+    cfg->ekf_gate_threshold = 9.0;
+    cfg->telemetry_dir[0] = '\0';
+}
+
+/* --- Parser --- */
+
+typedef enum { JV_STRING, JV_NUMBER, JV_BOOL, JV_NULL } jv_type_t;
+
+typedef struct {
+    jv_type_t type;
+    char str[VPS_CONFIG_PATH_MAX];
+    double num;
+    bool b;
+} jv_t;
+
+typedef struct {
+    const char *p;
+} jp_t;
+
+static void skip_ws(jp_t *jp) {
+    while (*jp->p == ' ' || *jp->p == '\t' || *jp->p == '\n' || *jp->p == '\r')
+        jp->p++;
+}
+
+static bool parse_string(jp_t *jp, char *out, size_t outlen) {
+    if (*jp->p != '"') return false;
+    jp->p++;
+    size_t n = 0;
+    while (*jp->p && *jp->p != '"') {
+        char c = *jp->p++;
+        if (c == '\\') {
+            c = *jp->p++;
+            switch (c) {
+            case 'n': c = '\n'; break;
+            case 't': c = '\t'; break;
+            case 'r': c = '\r'; break;
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'u':
+                /* Non-ASCII escapes are not expected in paths; keep a placeholder */
+                for (int i = 0; i < 4; i++) {
+                    if (!*jp->p) return false;
+                    jp->p++;
+                }
+                c = '?';
+                break;
+            case '\0': return false;
+            default: break;  /* \" \\ \/ */
+            }
+        }
+        if (n + 1 < outlen) out[n++] = c;
+    }
+    if (*jp->p != '"') return false;
+    jp->p++;
+    out[n] = '\0';
+    return true;
+}
+
+static bool parse_value(jp_t *jp, const char *path, vps_config_t *cfg);
+
+static void assign(vps_config_t *cfg, const char *path, const jv_t *v) {
+    /* String fields */
+    struct { const char *key; char *dst; size_t len; } strs[] = {
+        {"map_pack", cfg->map_pack, sizeof(cfg->map_pack)},
+        {"camera.device", cfg->camera.device, sizeof(cfg->camera.device)},
+        {"uart.port", cfg->uart.port, sizeof(cfg->uart.port)},
+        {"matcher.superpoint_onnx", cfg->matcher.superpoint_onnx,
+         sizeof(cfg->matcher.superpoint_onnx)},
+        {"matcher.lightglue_onnx", cfg->matcher.lightglue_onnx,
+         sizeof(cfg->matcher.lightglue_onnx)},
+        {"log_level", cfg->log_level, sizeof(cfg->log_level)},
+        {"telemetry_dir", cfg->telemetry_dir, sizeof(cfg->telemetry_dir)},
+    };
+    for (size_t i = 0; i < sizeof(strs) / sizeof(strs[0]); i++) {
+        if (strcmp(path, strs[i].key) != 0) continue;
+        if (v->type == JV_STRING) {
+            snprintf(strs[i].dst, strs[i].len, "%s", v->str);
+        } else if (v->type == JV_NULL) {
+            strs[i].dst[0] = '\0';
+        } else if (v->type == JV_NUMBER) {
+            /* camera.device may be an integer index */
+            snprintf(strs[i].dst, strs[i].len, "%d", (int)v->num);
+        }
+        return;
+    }
+
+    if (v->type == JV_NUMBER) {
+        struct { const char *key; int *dst; } ints[] = {
+            {"camera.width", &cfg->camera.width},
+            {"camera.height", &cfg->camera.height},
+            {"camera.fps", &cfg->camera.fps},
+            {"uart.baudrate", &cfg->uart.baudrate},
+            {"matcher.min_matches", &cfg->matcher.min_matches},
+            {"matcher.max_candidates", &cfg->matcher.max_candidates},
+        };
+        for (size_t i = 0; i < sizeof(ints) / sizeof(ints[0]); i++) {
+            if (strcmp(path, ints[i].key) == 0) {
+                *ints[i].dst = (int)v->num;
+                return;
+            }
+        }
+        struct { const char *key; double *dst; } dbls[] = {
+            {"matcher.confidence_threshold", &cfg->matcher.confidence_threshold},
+            {"target_hz", &cfg->target_hz},
+            {"ekf_measurement_noise", &cfg->ekf_measurement_noise},
+            {"ekf_gate_threshold", &cfg->ekf_gate_threshold},
+        };
+        for (size_t i = 0; i < sizeof(dbls) / sizeof(dbls[0]); i++) {
+            if (strcmp(path, dbls[i].key) == 0) {
+                *dbls[i].dst = v->num;
+                return;
+            }
+        }
+    } else if (v->type == JV_BOOL) {
+        struct { const char *key; bool *dst; } bools[] = {
+            {"camera.use_picamera2", &cfg->camera.use_picamera2},
+            {"uart.enabled", &cfg->uart.enabled},
+            {"matcher.use_orb_fallback", &cfg->matcher.use_orb_fallback},
+        };
+        for (size_t i = 0; i < sizeof(bools) / sizeof(bools[0]); i++) {
+            if (strcmp(path, bools[i].key) == 0) {
+                *bools[i].dst = v->b;
+                return;
+            }
+        }
+    }
+}
+
+static bool parse_object(jp_t *jp, const char *path, vps_config_t *cfg) {
+    jp->p++;  /* { */
+    skip_ws(jp);
+    if (*jp->p == '}') {
+        jp->p++;
+        return true;
+    }
+    for (;;) {
+        char key[64];
+        char child[128];
+        skip_ws(jp);
+        if (!parse_string(jp, key, sizeof(key))) return false;
+        skip_ws(jp);
+        if (*jp->p != ':') return false;
+        jp->p++;
+        if (path[0])
+            snprintf(child, sizeof(child), "%s.%s", path, key);
+        else
+            snprintf(child, sizeof(child), "%s", key);
+        if (!parse_value(jp, child, cfg)) return false;
+        skip_ws(jp);
+        if (*jp->p == ',') {
+            jp->p++;
+            continue;
+        }
+        if (*jp->p == '}') {
+            jp->p++;
+            return true;
+        }
+        return false;
+    }
+}
+
+static bool parse_array(jp_t *jp, vps_config_t *cfg) {
+    jp->p++;  /* [ */
+    skip_ws(jp);
+    if (*jp->p == ']') {
+        jp->p++;
+        return true;
+    }
+    for (;;) {
+        /* Elements are parsed for syntax only; no schema field is a list */
+        if (!parse_value(jp, "[]", cfg)) return false;
+        skip_ws(jp);
+        if (*jp->p == ',') {
+            jp->p++;
+            continue;
+        }
+        if (*jp->p == ']') {
+            jp->p++;
+            return true;
+        }
+        return false;
+    }
+}
+
+static bool parse_value(jp_t *jp, const char *path, vps_config_t *cfg) {
+    jv_t v;
+    skip_ws(jp);
+    switch (*jp->p) {
+    case '{':
+        return parse_object(jp, path, cfg);
+    case '[':
+        return parse_array(jp, cfg);
+    case '"':
+        v.type = JV_STRING;
+        if (!parse_string(jp, v.str, sizeof(v.str))) return false;
+        break;
+    case 't':
+        if (strncmp(jp->p, "true", 4) != 0) return false;
+        jp->p += 4;
+        v.type = JV_BOOL;
+        v.b = true;
+        break;
+    case 'f':
+        if (strncmp(jp->p, "false", 5) != 0) return false;
+        jp->p += 5;
+        v.type = JV_BOOL;
+        v.b = false;
+        break;
+    case 'n':
+        if (strncmp(jp->p, "null", 4) != 0) return false;
+        jp->p += 4;
+        v.type = JV_NULL;
+        break;
+    default: {
+        char *end;
+        v.num = strtod(jp->p, &end);
+        if (end == jp->p) return false;
+        jp->p = end;
+        v.type = JV_NUMBER;
+        break;
+    }
+    }
+    assign(cfg, path, &v);
+    return true;
+}
+
+bool vps_config_parse(vps_config_t *cfg, const char *json) {
+    jp_t jp = {json};
+    skip_ws(&jp);
+    if (*jp.p != '{') return false;
+    if (!parse_object(&jp, "", cfg)) return false;
+    skip_ws(&jp);
+    return *jp.p == '\0';
+}
+
+bool vps_config_load(vps_config_t *cfg, const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return false;
+
+    if (fseek(fp, 0, SEEK_END) != 0) {
+        fclose(fp);
+        return false;
+    }
+    long size = ftell(fp);
+    if (size < 0 || fseek(fp, 0, SEEK_SET) != 0) {
+        fclose(fp);
+        return false;
+    }
+
+    char *buf = malloc((size_t)size + 1);
+    if (!buf) {
+        fclose(fp);
+        return false;
+    }
+    size_t n = fread(buf, 1, (size_t)size, fp);
+    fclose(fp);
+    buf[n] = '\0';
+
+    bool ok = vps_config_parse(cfg, buf);
+    free(buf);
+    return ok;
+}
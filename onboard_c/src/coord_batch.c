@@ -0,0 +1,250 @@
+/**
+ * @file coord_batch.c
+ * @brief Batch GPS <-> tile <-> pixel conversions in SIMD lanes.
+ *
+ * The lane kernels (coord_batch_lanes.h) are compiled once per
+ * instruction set: AVX2/FMA through a target attribute, so they exist
+ * whatever the global flags and are picked when the CPU reports them;
+ * NEON on aarch64, where it is always present; scalar everywhere.
+ */
+#include "coord_batch.h"
+#include <math.h>
+#include <stddef.h>
+
+#define PI 3.14159265358979323846
+#define LN2 0.69314718055994530942
+#define LN2_HI 6.93147180369123816490e-01   /* k * LN2_HI exact for small k */
+#define LN2_LO 1.90821492927058770002e-10
+#define SQRT1_2 0.70710678118654752440
+#define TAN_PI_8 0.41421356237309504880
+#define PSI_MAX 20.0                         /* Mercator y beyond 89.9999999 deg */
+
+/*
+ * Series terms, each cut where the first dropped term is below 1e-17 of
+ * the result over the kernel's interval.
+ */
+#define SIN_TERMS 11    /* x^21, |x| <= pi/2 */
+static const double SIN_C[SIN_TERMS] = {
+    1.0, -1.0 / 6.0, 1.0 / 120.0, -1.0 / 5040.0, 1.0 / 362880.0, -1.0 / 39916800.0,
+    1.0 / 6227020800.0, -1.0 / 1307674368000.0, 1.0 / 355687428096000.0,
+    -1.0 / 121645100408832000.0, 1.0 / 51090942171709440000.0,
+};
+
+#define LOG_TERMS 10    /* 2 atanh(t) to t^19, |t| <= 0.1716 */
+static const double LOG_C[LOG_TERMS] = {
+    1.0, 1.0 / 3.0, 1.0 / 5.0, 1.0 / 7.0, 1.0 / 9.0,
+    1.0 / 11.0, 1.0 / 13.0, 1.0 / 15.0, 1.0 / 17.0, 1.0 / 19.0,
+};
+
+#define EXP_TERMS 14    /* r^13, |r| <= ln2 / 2 */
+static const double EXP_C[EXP_TERMS] = {
+    1.0, 1.0, 1.0 / 2.0, 1.0 / 6.0, 1.0 / 24.0, 1.0 / 120.0, 1.0 / 720.0, 1.0 / 5040.0,
+    1.0 / 40320.0, 1.0 / 362880.0, 1.0 / 3628800.0, 1.0 / 39916800.0, 1.0 / 479001600.0,
+    1.0 / 6227020800.0,
+};
+
+#define ATAN_TERMS 21   /* x^41, |x| <= tan(pi/8) */
+static const double ATAN_C[ATAN_TERMS] = {
+    1.0, -1.0 / 3.0, 1.0 / 5.0, -1.0 / 7.0, 1.0 / 9.0, -1.0 / 11.0, 1.0 / 13.0,
+    -1.0 / 15.0, 1.0 / 17.0, -1.0 / 19.0, 1.0 / 21.0, -1.0 / 23.0, 1.0 / 25.0,
+    -1.0 / 27.0, 1.0 / 29.0, -1.0 / 31.0, 1.0 / 33.0, -1.0 / 35.0, 1.0 / 37.0,
+    -1.0 / 39.0, 1.0 / 41.0,
+};
+
+typedef void (*forward_fn)(const double *, const double *, int, int, bool, int *, int *,
+                           double *, double *);
+typedef void (*inverse_fn)(const int *, const int *, const double *, const double *, int, int,
+                           double *, double *);
+
+typedef struct {
+    const char *isa;
+    forward_fn forward;
+    inverse_fn inverse;
+} lanes_t;
+
+/* --- Scalar lanes --- */
+
+static double frexp_scalar(double x, double *e) {
+    int k;
+    double m = frexp(x, &k);
+    *e = k;
+    return m;
+}
+
+#define VW 1
+#define vd double
+#define vm bool
+#define KFN static
+#define K(name) name##_scalar
+#define vloadu(p)        (*(p))
+#define vstoreu(p, a)    (*(p) = (a))
+#define vset1(s)         (s)
+#define vadd(a, b)       ((a) + (b))
+#define vsub(a, b)       ((a) - (b))
+#define vmul(a, b)       ((a) * (b))
+#define vdiv(a, b)       ((a) / (b))
+#define vfma(a, b, c)    ((a) * (b) + (c))
+#define vabs(a)          fabs(a)
+#define vneg(a)          (-(a))
+#define vmin(a, b)       ((a) < (b) ? (a) : (b))
+#define vmax(a, b)       ((a) > (b) ? (a) : (b))
+#define vlt(a, b)        ((a) < (b))
+#define vgt(a, b)        ((a) > (b))
+#define vsel(m, a, b)    ((m) ? (a) : (b))
+#define vtrunc(a)        trunc(a)
+#define vround(a)        nearbyint(a)
+#define vfrexp(x, e)     frexp_scalar(x, e)
+#define vpow2i(k)        ldexp(1.0, (int)(k))
+#define vload_i32(p)     ((double)*(p))
+#define vstore_i32(p, a) (*(p) = (int)(a))
+#include "coord_batch_lanes.h"
+
+static const lanes_t LANES_SCALAR = {"scalar", forward_scalar, inverse_scalar};
+
+/* --- AVX2 lanes (x86_64, chosen at run time) --- */
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define HAVE_AVX2_LANES
+#define AVX2_FN static __attribute__((target("avx2,fma")))
+
+/* Mantissa in [0.5, 1) and exponent of positive normal x, from the bits */
+AVX2_FN __m256d frexp_avx2(__m256d x, __m256d *e) {
+    __m256i b = _mm256_castpd_si256(x);
+    __m256i eb = _mm256_or_si256(_mm256_srli_epi64(b, 52),
+                                 _mm256_set1_epi64x(0x4330000000000000));   /* 2^52 + e */
+    *e = _mm256_sub_pd(_mm256_castsi256_pd(eb), _mm256_set1_pd(4503599627370496.0 + 1022.0));
+    __m256i mb = _mm256_or_si256(_mm256_and_si256(b, _mm256_set1_epi64x(0x000FFFFFFFFFFFFF)),
+                                 _mm256_set1_epi64x(0x3FE0000000000000));
+    return _mm256_castsi256_pd(mb);
+}
+
+/* 2^k for integral k well inside the exponent range */
+AVX2_FN __m256d pow2i_avx2(__m256d k) {
+    __m256i e = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(k));
+    return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(e, _mm256_set1_epi64x(1023)),
+                                                 52));
+}
+
+#define VW 4
+#define vd __m256d
+#define vm __m256d
+#define KFN AVX2_FN
+#define K(name) name##_avx2
+#define vloadu(p)        _mm256_loadu_pd(p)
+#define vstoreu(p, a)    _mm256_storeu_pd(p, a)
+#define vset1(s)         _mm256_set1_pd(s)
+#define vadd(a, b)       _mm256_add_pd(a, b)
+#define vsub(a, b)       _mm256_sub_pd(a, b)
+#define vmul(a, b)       _mm256_mul_pd(a, b)
+#define vdiv(a, b)       _mm256_div_pd(a, b)
+#define vfma(a, b, c)    _mm256_fmadd_pd(a, b, c)
+#define vabs(a)          _mm256_andnot_pd(_mm256_set1_pd(-0.0), a)
+#define vneg(a)          _mm256_xor_pd(a, _mm256_set1_pd(-0.0))
+#define vmin(a, b)       _mm256_min_pd(a, b)
+#define vmax(a, b)       _mm256_max_pd(a, b)
+#define vlt(a, b)        _mm256_cmp_pd(a, b, _CMP_LT_OQ)
+#define vgt(a, b)        _mm256_cmp_pd(a, b, _CMP_GT_OQ)
+#define vsel(m, a, b)    _mm256_blendv_pd(b, a, m)
+#define vtrunc(a)        _mm256_round_pd(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC)
+#define vround(a)        _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+#define vfrexp(x, e)     frexp_avx2(x, e)
+#define vpow2i(k)        pow2i_avx2(k)
+#define vload_i32(p)     _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *)(p)))
+#define vstore_i32(p, a) _mm_storeu_si128((__m128i *)(p), _mm256_cvttpd_epi32(a))
+#include "coord_batch_lanes.h"
+
+static const lanes_t LANES_AVX2 = {"avx2", forward_avx2, inverse_avx2};
+#endif
+
+/* --- NEON lanes (aarch64, always present) --- */
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HAVE_NEON_LANES
+
+static float64x2_t frexp_neon(float64x2_t x, float64x2_t *e) {
+    uint64x2_t b = vreinterpretq_u64_f64(x);
+    *e = vsubq_f64(vcvtq_f64_u64(vshrq_n_u64(b, 52)), vdupq_n_f64(1022.0));
+    uint64x2_t mb = vorrq_u64(vandq_u64(b, vdupq_n_u64(0x000FFFFFFFFFFFFFull)),
+                              vdupq_n_u64(0x3FE0000000000000ull));
+    return vreinterpretq_f64_u64(mb);
+}
+
+static float64x2_t pow2i_neon(float64x2_t k) {
+    int64x2_t e = vaddq_s64(vcvtq_s64_f64(k), vdupq_n_s64(1023));
+    return vreinterpretq_f64_s64(vshlq_n_s64(e, 52));
+}
+
+#define VW 2
+#define vd float64x2_t
+#define vm uint64x2_t
+#define KFN static
+#define K(name) name##_neon
+#define vloadu(p)        vld1q_f64(p)
+#define vstoreu(p, a)    vst1q_f64(p, a)
+#define vset1(s)         vdupq_n_f64(s)
+#define vadd(a, b)       vaddq_f64(a, b)
+#define vsub(a, b)       vsubq_f64(a, b)
+#define vmul(a, b)       vmulq_f64(a, b)
+#define vdiv(a, b)       vdivq_f64(a, b)
+#define vfma(a, b, c)    vfmaq_f64(c, a, b)
+#define vabs(a)          vabsq_f64(a)
+#define vneg(a)          vnegq_f64(a)
+#define vmin(a, b)       vminq_f64(a, b)
+#define vmax(a, b)       vmaxq_f64(a, b)
+#define vlt(a, b)        vcltq_f64(a, b)
+#define vgt(a, b)        vcgtq_f64(a, b)
+#define vsel(m, a, b)    vbslq_f64(m, a, b)
+#define vtrunc(a)        vrndq_f64(a)
+#define vround(a)        vrndnq_f64(a)
+#define vfrexp(x, e)     frexp_neon(x, e)
+#define vpow2i(k)        pow2i_neon(k)
+#define vload_i32(p)     vcvtq_f64_s64(vmovl_s32(vld1_s32(p)))
+#define vstore_i32(p, a) vst1_s32(p, vmovn_s64(vcvtq_s64_f64(a)))
+#include "coord_batch_lanes.h"
+
+static const lanes_t LANES_NEON = {"neon", forward_neon, inverse_neon};
+#endif
+
+/* --- Dispatch --- */
+
+static bool simd_enabled = true;
+
+static const lanes_t *lanes(void) {
+    if (simd_enabled) {
+#if defined(HAVE_NEON_LANES)
+        return &LANES_NEON;
+#elif defined(HAVE_AVX2_LANES)
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return &LANES_AVX2;
+#endif
+    }
+    return &LANES_SCALAR;
+}
+
+/* --- Public API --- */
+
+void vps_gps_to_tile_batch(const double *lat, const double *lon, int n, int zoom,
+                           int *x_out, int *y_out) {
+    if (n > 0) lanes()->forward(lat, lon, n, zoom, true, x_out, y_out, NULL, NULL);
+}
+
+void vps_gps_to_tile_pixel_batch(const double *lat, const double *lon, int n, int zoom,
+                                 int *tx_out, int *ty_out, double *px_out, double *py_out) {
+    if (n > 0) lanes()->forward(lat, lon, n, zoom, false, tx_out, ty_out, px_out, py_out);
+}
+
+void vps_tile_pixel_to_gps_batch(const int *tx, const int *ty, const double *px,
+                                 const double *py, int n, int zoom,
+                                 double *lat_out, double *lon_out) {
+    if (n > 0) lanes()->inverse(tx, ty, px, py, n, zoom, lat_out, lon_out);
+}
+
+const char *vps_coord_batch_isa(void) {
+    return lanes()->isa;
+}
+
+const char *vps_coord_batch_use_simd(bool enable) {
+    simd_enabled = enable;
+    return lanes()->isa;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file coord_batch_lanes.h
+ * @brief Lane kernels of coord_batch.c, included once per instruction set.
+ *
+ * The includer defines vd / vm (VW doubles and a lane mask), the v*
+ * operations, KFN (function qualifiers) and K(name) (per-ISA name); they
+ * are undefined again at the end. Inputs are clamped so each polynomial
+ * only sees the interval its term count was chosen for.
+ */
+
+/* sin(x), |x| <= pi/2 */
+KFN vd K(v_sin)(vd x) {
+    vd x2 = vmul(x, x), p = vset1(SIN_C[SIN_TERMS - 1]);
+    for (int k = SIN_TERMS - 2; k >= 0; k--) p = vfma(p, x2, vset1(SIN_C[k]));
+    return vmul(p, x);
+}
+
+/* log(x), x positive and normal: x = m 2^e, m in [1/sqrt2, sqrt2) */
+KFN vd K(v_log)(vd x) {
+    vd one = vset1(1.0), e;
+    vd m = vfrexp(x, &e);
+    vm lo = vlt(m, vset1(SQRT1_2));
+    m = vsel(lo, vadd(m, m), m);
+    e = vsel(lo, vsub(e, one), e);
+    vd t = vdiv(vsub(m, one), vadd(m, one)), t2 = vmul(t, t);
+    vd p = vset1(LOG_C[LOG_TERMS - 1]);
+    for (int k = LOG_TERMS - 2; k >= 0; k--) p = vfma(p, t2, vset1(LOG_C[k]));
+    return vfma(e, vset1(LN2_HI), vfma(e, vset1(LN2_LO), vmul(vadd(t, t), p)));
+}
+
+/* exp(x), |x| <= PSI_MAX: x = k ln2 + r, |r| <= ln2 / 2 */
+KFN vd K(v_exp)(vd x) {
+    vd k = vround(vmul(x, vset1(1.0 / LN2)));
+    vd r = vsub(vsub(x, vmul(k, vset1(LN2_HI))), vmul(k, vset1(LN2_LO)));
+    vd p = vset1(EXP_C[EXP_TERMS - 1]);
+    for (int j = EXP_TERMS - 2; j >= 0; j--) p = vfma(p, r, vset1(EXP_C[j]));
+    return vmul(p, vpow2i(k));
+}
+
+/* atan(x), |x| <= 1: above tan(pi/8), pi/4 + atan((x - 1) / (x + 1)) */
+KFN vd K(v_atan)(vd x) {
+    vd one = vset1(1.0), a = vabs(x);
+    vm big = vgt(a, vset1(TAN_PI_8));
+    vd u = vsel(big, vdiv(vsub(a, one), vadd(a, one)), a), u2 = vmul(u, u);
+    vd p = vset1(ATAN_C[ATAN_TERMS - 1]);
+    for (int k = ATAN_TERMS - 2; k >= 0; k--) p = vfma(p, u2, vset1(ATAN_C[k]));
+    vd r = vmul(p, u);
+    r = vsel(big, vadd(r, vset1(PI / 4.0)), r);
+    return vsel(vlt(x, vset1(0.0)), vneg(r), r);
+}
+
+/* Mercator forward: tile x/y (clamped to the zoom if clamp), pixels if px_out */
+KFN void K(forward)(const double *lat, const double *lon, int n, int zoom, bool clamp,
+                    int *tx_out, int *ty_out, double *px_out, double *py_out) {
+    double tiles = ldexp(1.0, zoom);
+    vd lat_max = vset1(VPS_MAX_MERCATOR_LAT * PI / 180.0), lat_min = vneg(lat_max);
+    vd one = vset1(1.0), zero = vset1(0.0), top = vset1(tiles - 1.0);
+    vd x_scale = vset1(tiles / 360.0), y_scale = vset1(tiles / 2.0);
+    double lat_t[VW], lon_t[VW], px_t[VW], py_t[VW];
+    int tx_t[VW], ty_t[VW];
+    for (int i = 0; i < n; i += VW) {
+        int m = n - i < VW ? n - i : VW;
+        const double *a = lat + i, *b = lon + i;
+        if (m < VW) {   /* tail: pad with the equator */
+            for (int k = 0; k < VW; k++) {
+                lat_t[k] = k < m ? a[k] : 0.0;
+                lon_t[k] = k < m ? b[k] : 0.0;
+            }
+            a = lat_t;
+            b = lon_t;
+        }
+        vd phi = vmul(vloadu(a), vset1(PI / 180.0));
+        vd s = K(v_sin)(vmin(vmax(phi, lat_min), lat_max));
+        vd psi = vmul(vset1(0.5), K(v_log)(vdiv(vadd(one, s), vsub(one, s))));
+        vd gx = vmul(vadd(vloadu(b), vset1(180.0)), x_scale);
+        vd gy = vmul(vsub(one, vmul(psi, vset1(1.0 / PI))), y_scale);
+        vd fx = vtrunc(gx), fy = vtrunc(gy);
+        if (clamp) {
+            fx = vmin(vmax(fx, zero), top);
+            fy = vmin(vmax(fy, zero), top);
+        }
+        int *x = m < VW ? tx_t : tx_out + i, *y = m < VW ? ty_t : ty_out + i;
+        vstore_i32(x, fx);
+        vstore_i32(y, fy);
+        double *u = NULL, *v = NULL;
+        if (px_out) {
+            u = m < VW ? px_t : px_out + i;
+            v = m < VW ? py_t : py_out + i;
+            vstoreu(u, vmul(vsub(gx, fx), vset1(VPS_TILE_SIZE)));
+            vstoreu(v, vmul(vsub(gy, fy), vset1(VPS_TILE_SIZE)));
+        }
+        if (m < VW)
+            for (int k = 0; k < m; k++) {
+                tx_out[i + k] = x[k];
+                ty_out[i + k] = y[k];
+                if (px_out) {
+                    px_out[i + k] = u[k];
+                    py_out[i + k] = v[k];
+                }
+            }
+    }
+}
+
+/* Mercator inverse: lat = 2 atan(tanh(psi / 2)) */
+KFN void K(inverse)(const int *tx, const int *ty, const double *px, const double *py, int n,
+                    int zoom, double *lat_out, double *lon_out) {
+    double tiles = ldexp(1.0, zoom);
+    vd one = vset1(1.0), psi_max = vset1(PSI_MAX), pix = vset1(1.0 / VPS_TILE_SIZE);
+    double px_t[VW], py_t[VW], lat_t[VW], lon_t[VW];
+    int tx_t[VW], ty_t[VW];
+    for (int i = 0; i < n; i += VW) {
+        int m = n - i < VW ? n - i : VW;
+        const int *a = tx + i, *b = ty + i;
+        const double *c = px + i, *d = py + i;
+        if (m < VW) {
+            for (int k = 0; k < VW; k++) {
+                tx_t[k] = k < m ? a[k] : 0;
+                ty_t[k] = k < m ? b[k] : 0;
+                px_t[k] = k < m ? c[k] : 0.0;
+                py_t[k] = k < m ? d[k] : 0.0;
+            }
+            a = tx_t;
+            b = ty_t;
+            c = px_t;
+            d = py_t;
+        }
+        vd gx = vfma(vloadu(c), pix, vload_i32(a));
+        vd gy = vfma(vloadu(d), pix, vload_i32(b));
+        vd psi = vmul(vset1(PI), vsub(one, vmul(gy, vset1(2.0 / tiles))));
+        vd e = K(v_exp)(vmin(vmax(psi, vneg(psi_max)), psi_max));
+        vd lat = vmul(K(v_atan)(vdiv(vsub(e, one), vadd(e, one))), vset1(360.0 / PI));
+        vd lon = vsub(vmul(gx, vset1(360.0 / tiles)), vset1(180.0));
+        double *y = m < VW ? lat_t : lat_out + i, *x = m < VW ? lon_t : lon_out + i;
+        vstoreu(y, lat);
+        vstoreu(x, lon);
+        for (int k = 0; m < VW && k < m; k++) {
+            lat_out[i + k] = y[k];
+            lon_out[i + k] = x[k];
+        }
+    }
+}
+
+#undef VW
+#undef vd
+#undef vm
+#undef KFN
+#undef K
+#undef vloadu
+#undef vstoreu
+#undef vset1
+#undef vadd
+#undef vsub
+#undef vmul
+#undef vdiv
+#undef vfma
+#undef vabs
+#undef vneg
+#undef vmin
+#undef vmax
+#undef vlt
+#undef vgt
+#undef vsel
+#undef vtrunc
+#undef vround
+#undef vfrexp
+#undef vpow2i
+#undef vload_i32
+#undef vstore_i32
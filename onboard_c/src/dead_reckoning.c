@@ -4,6 +4,7 @@
  */
 #include "dead_reckoning.h"
 #include <math.h>
+#include <stddef.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -14,6 +15,22 @@ void vps_dr_init(vps_dr_state_t *dr, double max_extrap_s, double hdop_growth_rat
     dr->ref_t = 0;
     dr->max_extrap_s = max_extrap_s;
     dr->hdop_growth_rate = hdop_growth_rate;
+    dr->odometry = false;
+    dr->frame = NULL;
+}
+
+void vps_dr_set_frame(vps_dr_state_t *dr, const vps_local_frame_t *frame) {
+    dr->frame = frame;
+}
+
+/* Metres per degree north, and east at lat */
+static inline double m_per_deg_lat(const vps_dr_state_t *dr) {
+    return dr->frame ? dr->frame->m_per_deg_lat : 111320.0;
+}
+
+static inline double m_per_deg_lon(const vps_dr_state_t *dr, double lat) {
+    return dr->frame ? vps_local_frame_m_per_deg_lon(dr->frame, lat)
+                     : 111320.0 * cos(lat * M_PI / 180.0);
 }
 
 void vps_dr_update_ref(vps_dr_state_t *dr, vps_geopoint_t pos,
@@ -24,6 +41,22 @@ void vps_dr_update_ref(vps_dr_state_t *dr, vps_geopoint_t pos,
     dr->ref_hdop = hdop;
     dr->ref_t = t;
     dr->has_reference = true;
+    dr->odometry = false;
+}
+
+bool vps_dr_apply_odometry(vps_dr_state_t *dr, double dn_m, double de_m,
+                           double hdop_add, double t) {
+    double dt = t - dr->ref_t;
+    if (!dr->has_reference || !(dt > 0)) return false;
+
+    dr->ref_pos.lat += dn_m / m_per_deg_lat(dr);
+    dr->ref_pos.lon += de_m / m_per_deg_lon(dr, dr->ref_pos.lat);
+    dr->vn_mps = dn_m / dt;
+    dr->ve_mps = de_m / dt;
+    dr->ref_hdop += hdop_add;
+    dr->ref_t = t;
+    dr->odometry = true;
+    return true;
 }
 
 bool vps_dr_extrapolate(const vps_dr_state_t *dr, double t,
@@ -34,8 +67,8 @@ bool vps_dr_extrapolate(const vps_dr_state_t *dr, double t,
     if (dt < 0 || dt > dr->max_extrap_s) return false;
 
     /* Convert m/s to degrees/s */
-    double dlat = dr->vn_mps / 111320.0;
-    double dlon = dr->ve_mps / (111320.0 * cos(dr->ref_pos.lat * M_PI / 180.0));
+    double dlat = dr->vn_mps / m_per_deg_lat(dr);
+    double dlon = dr->ve_mps / m_per_deg_lon(dr, dr->ref_pos.lat);
 
     pos_out->lat = dr->ref_pos.lat + dlat * dt;
     pos_out->lon = dr->ref_pos.lon + dlon * dt;
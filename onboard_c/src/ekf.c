@@ -80,19 +80,23 @@ static void build_Q(double Q[4][4], double q, double dt) {
     Q[3][1] = q * dt3;  Q[3][3] = q * dt2;
 }
 
-bool vps_ekf_update(vps_ekf_state_t *state, const vps_ekf_config_t *cfg,
-                    vps_geopoint_t measurement, double hdop, double t) {
+/* First measurement — initialize */
+static void ekf_first_fix(vps_ekf_state_t *state, vps_geopoint_t measurement, double t) {
+    state->x[0] = measurement.lat;
+    state->x[1] = measurement.lon;
+    state->x[2] = 0.0;  /* vlat */
+    state->x[3] = 0.0;  /* vlon */
+    mat4_eye(state->P);
+    for (int i = 0; i < 4; i++) state->P[i][i] = 1e-6;
+    state->last_t = t;
+    state->initialized = true;
+    state->last_gate = 0.0;
+}
+
+bool vps_ekf_update_dense(vps_ekf_state_t *state, const vps_ekf_config_t *cfg,
+                          vps_geopoint_t measurement, double hdop, double t) {
     if (!state->initialized) {
-        /* First measurement — initialize */
-        state->x[0] = measurement.lat;
-        state->x[1] = measurement.lon;
-        state->x[2] = 0.0;  /* vlat */
-        state->x[3] = 0.0;  /* vlon */
-        mat4_eye(state->P);
-        for (int i = 0; i < 4; i++) state->P[i][i] = 1e-6;
-        state->last_t = t;
-        state->initialized = true;
-        state->last_gate = 0.0;
+        ekf_first_fix(state, measurement, t);
         return true;
     }
 
@@ -102,7 +106,7 @@ bool vps_ekf_update(vps_ekf_state_t *state, const vps_ekf_config_t *cfg,
     /* Reset on long gap */
     if (dt > cfg->max_gap_s) {
         vps_ekf_reset(state);
-        return vps_ekf_update(state, cfg, measurement, hdop, t);
+        return vps_ekf_update_dense(state, cfg, measurement, hdop, t);
     }
 
     /* --- Predict --- */
@@ -190,6 +194,217 @@ bool vps_ekf_update(vps_ekf_state_t *state, const vps_ekf_config_t *cfg,
     return true;
 }
 
+/* --- Structured kernel ---
+ *
+ * F = I + dt·(e0e2' + e1e3') and H = [I2 0], so F P F' + Q and
+ * (I - K H) P reduce to a handful of scalar updates on the 10 unique
+ * entries of the symmetric covariance.
+ */
+
+enum { P00, P01, P02, P03, P11, P12, P13, P22, P23, P33 };
+
+void vps_ekf_pack_cov(double p[VPS_EKF_PACKED], const double *P) {
+    p[P00] = P[0];  p[P01] = P[1];  p[P02] = P[2];  p[P03] = P[3];
+    p[P11] = P[5];  p[P12] = P[6];  p[P13] = P[7];
+    p[P22] = P[10]; p[P23] = P[11];
+    p[P33] = P[15];
+}
+
+void vps_ekf_unpack_cov(double P[4][4], const double p[VPS_EKF_PACKED]) {
+    P[0][0] = p[P00];
+    P[0][1] = P[1][0] = p[P01];
+    P[0][2] = P[2][0] = p[P02];
+    P[0][3] = P[3][0] = p[P03];
+    P[1][1] = p[P11];
+    P[1][2] = P[2][1] = p[P12];
+    P[1][3] = P[3][1] = p[P13];
+    P[2][2] = p[P22];
+    P[2][3] = P[3][2] = p[P23];
+    P[3][3] = p[P33];
+}
+
+void vps_ekf_propagate(double x[4], double p[VPS_EKF_PACKED], double q, double dt) {
+    double dt2 = dt * dt;
+    double q4 = q * dt2 * dt2 / 4.0;
+    double q3 = q * dt2 * dt / 2.0;
+    double q2 = q * dt2;
+
+    x[0] += x[2] * dt;
+    x[1] += x[3] * dt;
+
+    /* Rows/cols 2 and 3 of F P F' are unchanged; fold them in first */
+    p[P00] += dt * (2.0 * p[P02] + dt * p[P22]) + q4;
+    p[P11] += dt * (2.0 * p[P13] + dt * p[P33]) + q4;
+    p[P01] += dt * (p[P03] + p[P12] + dt * p[P23]);
+    p[P02] += dt * p[P22] + q3;
+    p[P03] += dt * p[P23];
+    p[P12] += dt * p[P23];
+    p[P13] += dt * p[P33] + q3;
+    p[P22] += q2;
+    p[P33] += q2;
+}
+
+double vps_ekf_correct(double x[4], double p[VPS_EKF_PACKED],
+                       vps_geopoint_t z, double r, double gate) {
+    double y0 = z.lat - x[0];
+    double y1 = z.lon - x[1];
+
+    double s00 = p[P00] + r, s01 = p[P01], s11 = p[P11] + r;
+    double det = s00 * s11 - s01 * s01;
+    if (fabs(det) < 1e-30) return INFINITY;
+    double i00 = s11 / det, i01 = -s01 / det, i11 = s00 / det;
+
+    double d = sqrt(fabs(y0 * (i00 * y0 + i01 * y1) + y1 * (i01 * y0 + i11 * y1)));
+    if (d > gate) return d;
+
+    /* Columns 0 and 1 of P (= P H') */
+    double c0[4] = {p[P00], p[P01], p[P02], p[P03]};
+    double c1[4] = {p[P01], p[P11], p[P12], p[P13]};
+    double k0[4], k1[4];
+    for (int i = 0; i < 4; i++) {
+        k0[i] = c0[i] * i00 + c1[i] * i01;
+        k1[i] = c0[i] * i01 + c1[i] * i11;
+        x[i] += k0[i] * y0 + k1[i] * y1;
+    }
+
+    /* P -= K (H P), upper triangle only */
+    p[P00] -= k0[0] * c0[0] + k1[0] * c1[0];
+    p[P01] -= k0[0] * c0[1] + k1[0] * c1[1];
+    p[P02] -= k0[0] * c0[2] + k1[0] * c1[2];
+    p[P03] -= k0[0] * c0[3] + k1[0] * c1[3];
+    p[P11] -= k0[1] * c0[1] + k1[1] * c1[1];
+    p[P12] -= k0[1] * c0[2] + k1[1] * c1[2];
+    p[P13] -= k0[1] * c0[3] + k1[1] * c1[3];
+    p[P22] -= k0[2] * c0[2] + k1[2] * c1[2];
+    p[P23] -= k0[2] * c0[3] + k1[2] * c1[3];
+    p[P33] -= k0[3] * c0[3] + k1[3] * c1[3];
+    return d;
+}
+
+/* --- Batch (information-form) update --- */
+
+void vps_ekf_info_clear(vps_ekf_info_t *info) {
+    info->w = 0.0;
+    info->wz[0] = info->wz[1] = 0.0;
+    info->n = 0;
+}
+
+void vps_ekf_info_add(vps_ekf_info_t *info, vps_geopoint_t z, double r) {
+    double w = 1.0 / r;
+    info->w += w;
+    info->wz[0] += w * z.lat;
+    info->wz[1] += w * z.lon;
+    info->n++;
+}
+
+bool vps_ekf_info_fix(const vps_ekf_info_t *info, vps_geopoint_t *z, double *r) {
+    if (info->n == 0 || !(info->w > 0.0)) return false;
+    *r = 1.0 / info->w;
+    z->lat = info->wz[0] * *r;
+    z->lon = info->wz[1] * *r;
+    return true;
+}
+
+/** Mahalanobis distance of z from the predicted position. */
+static double fix_distance(const double x[4], const double p[VPS_EKF_PACKED],
+                           vps_geopoint_t z, double r) {
+    double y0 = z.lat - x[0], y1 = z.lon - x[1];
+    double s00 = p[P00] + r, s01 = p[P01], s11 = p[P11] + r;
+    double det = s00 * s11 - s01 * s01;
+    if (fabs(det) < 1e-30) return INFINITY;
+    return sqrt(fabs((s11 * y0 * y0 - 2.0 * s01 * y0 * y1 + s00 * y1 * y1) / det));
+}
+
+int vps_ekf_combine_batch(const vps_ekf_state_t *state, const vps_ekf_config_t *cfg,
+                          const vps_geopoint_t *fixes, const double *hdops, int n,
+                          double t, bool *accepted, vps_geopoint_t *z, double *hdop) {
+    double dt = t - state->last_t;
+    bool gated = state->initialized && dt <= cfg->max_gap_s;
+    if (state->initialized && dt < 0) {
+        for (int i = 0; accepted && i < n; i++) accepted[i] = false;
+        return 0;
+    }
+
+    double x[4], p[VPS_EKF_PACKED];
+    if (gated) {
+        memcpy(x, state->x, sizeof(x));
+        vps_ekf_pack_cov(p, &state->P[0][0]);
+        vps_ekf_propagate(x, p, cfg->process_noise, dt);
+    }
+
+    vps_ekf_info_t info;
+    vps_ekf_info_clear(&info);
+    for (int i = 0; i < n; i++) {
+        double r = cfg->measurement_noise * hdops[i] * hdops[i];
+        bool ok = !gated || fix_distance(x, p, fixes[i], r) <= cfg->gate_threshold;
+        if (ok) vps_ekf_info_add(&info, fixes[i], r);
+        if (accepted) accepted[i] = ok;
+    }
+
+    double r;
+    if (!vps_ekf_info_fix(&info, z, &r)) return 0;
+    *hdop = sqrt(r / cfg->measurement_noise);
+    return info.n;
+}
+
+int vps_ekf_update_batch(vps_ekf_state_t *state, const vps_ekf_config_t *cfg,
+                         const vps_geopoint_t *fixes, const double *hdops, int n,
+                         double t, bool *accepted) {
+    if (n == 1) {
+        bool ok = vps_ekf_update(state, cfg, fixes[0], hdops[0], t);
+        if (accepted) accepted[0] = ok;
+        return ok ? 1 : 0;
+    }
+
+    vps_geopoint_t z;
+    double hdop;
+    int k = vps_ekf_combine_batch(state, cfg, fixes, hdops, n, t, accepted, &z, &hdop);
+    if (k == 0) {
+        /* Everything gated out: advance time like a rejected single fix */
+        if (state->initialized && t >= state->last_t && n > 0)
+            vps_ekf_update(state, cfg, fixes[0], hdops[0], t);
+        return 0;
+    }
+
+    /* Fixes were gated individually; the combined one always applies */
+    vps_ekf_config_t c = *cfg;
+    c.gate_threshold = INFINITY;
+    vps_ekf_update(state, &c, z, hdop, t);
+    return k;
+}
+
+bool vps_ekf_update(vps_ekf_state_t *state, const vps_ekf_config_t *cfg,
+                    vps_geopoint_t measurement, double hdop, double t) {
+    if (!state->initialized) {
+        ekf_first_fix(state, measurement, t);
+        return true;
+    }
+
+    double dt = t - state->last_t;
+    if (dt < 0) return false;
+    if (dt > cfg->max_gap_s) {
+        vps_ekf_reset(state);
+        ekf_first_fix(state, measurement, t);
+        return true;
+    }
+
+    double x[4] = {state->x[0], state->x[1], state->x[2], state->x[3]};
+    double p[VPS_EKF_PACKED];
+    vps_ekf_pack_cov(p, &state->P[0][0]);
+    vps_ekf_propagate(x, p, cfg->process_noise, dt);
+
+    double r = cfg->measurement_noise * hdop * hdop;
+    double d = vps_ekf_correct(x, p, measurement, r, cfg->gate_threshold);
+    if (isinf(d)) return false;  /* singular S: state untouched, as before */
+
+    /* A gated-out fix still advances time (x, p hold the prediction) */
+    state->last_gate = d;
+    memcpy(state->x, x, sizeof(x));
+    vps_ekf_unpack_cov(state->P, p);
+    state->last_t = t;
+    return d <= cfg->gate_threshold;
+}
+
 vps_geopoint_t vps_ekf_predict(const vps_ekf_state_t *state, double t) {
     vps_geopoint_t p = {0.0, 0.0};
     if (!state->initialized) return p;
@@ -218,6 +433,13 @@ double vps_ekf_speed(const vps_ekf_state_t *state) {
     return sqrt(vn_ms * vn_ms + ve_ms * ve_ms);
 }
 
+double vps_ekf_speed_local(const vps_ekf_state_t *state, const vps_local_frame_t *frame) {
+    if (!state->initialized) return 0.0;
+    double vn_ms = state->x[2] * frame->m_per_deg_lat;
+    double ve_ms = state->x[3] * vps_local_frame_m_per_deg_lon(frame, state->x[0]);
+    return sqrt(vn_ms * vn_ms + ve_ms * ve_ms);
+}
+
 vps_geopoint_t vps_ekf_position(const vps_ekf_state_t *state) {
     vps_geopoint_t p = {0.0, 0.0};
     if (state->initialized) {
@@ -226,3 +448,92 @@ vps_geopoint_t vps_ekf_position(const vps_ekf_state_t *state) {
     }
     return p;
 }
+
+/* --- Out-of-sequence measurements --- */
+
+void vps_ekf_history_init(vps_ekf_history_t *h, int depth) {
+    if (depth < 1) depth = 1;
+    if (depth > VPS_EKF_HISTORY_MAX) depth = VPS_EKF_HISTORY_MAX;
+    h->depth = depth;
+    vps_ekf_history_clear(h);
+}
+
+void vps_ekf_history_clear(vps_ekf_history_t *h) {
+    h->start = 0;
+    h->count = 0;
+    h->last_latency = 0.0;
+    h->replayed = 0;
+}
+
+static vps_ekf_history_entry_t *hist_at(vps_ekf_history_t *h, int i) {
+    return &h->entries[(h->start + i) % h->depth];
+}
+
+static void hist_push(vps_ekf_history_t *h, const vps_ekf_state_t *post,
+                      vps_geopoint_t z, double hdop, double t, bool accepted) {
+    if (h->count == h->depth) {
+        h->start = (h->start + 1) % h->depth;
+        h->count--;
+    }
+    vps_ekf_history_entry_t *e = hist_at(h, h->count++);
+    e->t = t;
+    e->z = z;
+    e->hdop = hdop;
+    e->accepted = accepted;
+    e->post = *post;
+}
+
+bool vps_ekf_update_delayed(vps_ekf_state_t *state, vps_ekf_history_t *h,
+                            const vps_ekf_config_t *cfg,
+                            vps_geopoint_t measurement, double hdop,
+                            double t_capture, double t_arrival) {
+    if (t_capture > t_arrival) return false;
+    h->replayed = 0;
+
+    /* In order: plain update */
+    if (h->count == 0 || t_capture >= hist_at(h, h->count - 1)->t) {
+        if (state->initialized && t_capture < state->last_t) return false;
+        bool ok = vps_ekf_update(state, cfg, measurement, hdop, t_capture);
+        hist_push(h, state, measurement, hdop, t_capture, ok);
+        h->last_latency = t_arrival - t_capture;
+        return ok;
+    }
+
+    /* Newest entry at or before t_capture */
+    int a = h->count - 1;
+    while (a >= 0 && hist_at(h, a)->t > t_capture) a--;
+    if (a < 0) return false;  /* older than the retained window */
+
+    vps_ekf_state_t s = hist_at(h, a)->post;
+    if (h->count == h->depth) {
+        /* Make room by dropping the oldest entry (anchor already copied) */
+        h->start = (h->start + 1) % h->depth;
+        h->count--;
+        a--;
+    }
+
+    /* Shift later entries up by one and insert after the anchor */
+    for (int i = h->count; i > a + 1; i--)
+        *hist_at(h, i) = *hist_at(h, i - 1);
+    h->count++;
+
+    bool ok = vps_ekf_update(&s, cfg, measurement, hdop, t_capture);
+    vps_ekf_history_entry_t *e = hist_at(h, a + 1);
+    e->t = t_capture;
+    e->z = measurement;
+    e->hdop = hdop;
+    e->accepted = ok;
+    e->post = s;
+
+    /* Re-fuse everything captured after it */
+    for (int i = a + 2; i < h->count; i++) {
+        e = hist_at(h, i);
+        e->accepted = vps_ekf_update(&s, cfg, e->z, e->hdop, e->t);
+        e->post = s;
+        h->replayed++;
+    }
+
+    *state = s;
+    h->last_latency = t_arrival - t_capture;
+    return ok;
+}
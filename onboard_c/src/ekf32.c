@@ -0,0 +1,393 @@
+/**
+ * @file ekf32.c
+ * @brief Single-precision local-frame EKF.
+ */
+#include "ekf32.h"
+#include <math.h>
+#include <string.h>
+
+/* --- Float lane vector abstraction (as in ekf_bank.c) --- */
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VW 8
+#define ISA "avx2"
+typedef __m256 vf;
+#define vload(p)      _mm256_load_ps(p)
+#define vstore(p, a)  _mm256_store_ps(p, a)
+#define vset1(s)      _mm256_set1_ps(s)
+#define vadd(a, b)    _mm256_add_ps(a, b)
+#define vsub(a, b)    _mm256_sub_ps(a, b)
+#define vmul(a, b)    _mm256_mul_ps(a, b)
+#define vdiv(a, b)    _mm256_div_ps(a, b)
+#define vsqrt(a)      _mm256_sqrt_ps(a)
+#define vabs(a)       _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a)
+#define vneg(a)       _mm256_xor_ps(a, _mm256_set1_ps(-0.0f))
+#define vgt(a, b)     _mm256_cmp_ps(a, b, _CMP_GT_OQ)
+#define vle(a, b)     _mm256_cmp_ps(a, b, _CMP_LE_OQ)
+#define vand(m, n)    _mm256_and_ps(m, n)
+#define vsel(m, a, b) _mm256_blendv_ps(b, a, m)
+typedef __m256 vm;
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define VW 4
+#define ISA "neon"
+typedef float32x4_t vf;
+typedef uint32x4_t vm;
+#define vload(p)      vld1q_f32(p)
+#define vstore(p, a)  vst1q_f32(p, a)
+#define vset1(s)      vdupq_n_f32(s)
+#define vadd(a, b)    vaddq_f32(a, b)
+#define vsub(a, b)    vsubq_f32(a, b)
+#define vmul(a, b)    vmulq_f32(a, b)
+#define vdiv(a, b)    vdivq_f32(a, b)
+#define vsqrt(a)      vsqrtq_f32(a)
+#define vabs(a)       vabsq_f32(a)
+#define vneg(a)       vnegq_f32(a)
+#define vgt(a, b)     vcgtq_f32(a, b)
+#define vle(a, b)     vcleq_f32(a, b)
+#define vand(m, n)    vandq_u32(m, n)
+#define vsel(m, a, b) vbslq_f32(m, a, b)
+#else
+#define VW 1
+#define ISA "scalar"
+typedef float vf;
+typedef int vm;
+#define vload(p)      (*(p))
+#define vstore(p, a)  (*(p) = (a))
+#define vset1(s)      (s)
+#define vadd(a, b)    ((a) + (b))
+#define vsub(a, b)    ((a) - (b))
+#define vmul(a, b)    ((a) * (b))
+#define vdiv(a, b)    ((a) / (b))
+#define vsqrt(a)      sqrtf(a)
+#define vabs(a)       fabsf(a)
+#define vneg(a)       (-(a))
+#define vgt(a, b)     ((a) > (b))
+#define vle(a, b)     ((a) <= (b))
+#define vand(m, n)    ((m) && (n))
+#define vsel(m, a, b) ((m) ? (a) : (b))
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define M_PER_DEG 111320.0
+
+enum { P00, P01, P02, P03, P11, P12, P13, P22, P23, P33 };
+
+/* Row/column of each packed entry */
+static const int prow[VPS_EKF_PACKED] = {0, 0, 0, 0, 1, 1, 1, 2, 2, 3};
+static const int pcol[VPS_EKF_PACKED] = {0, 1, 2, 3, 1, 2, 3, 2, 3, 3};
+
+/* --- Float kernels (closed form, as vps_ekf_propagate/correct) --- */
+
+void vps_ekf32_propagate(float x[4], float p[VPS_EKF_PACKED], float qn, float qe, float dt) {
+    float dt2 = dt * dt;
+    float d4 = dt2 * dt2 * 0.25f, d3 = dt2 * dt * 0.5f;
+
+    x[0] += x[2] * dt;
+    x[1] += x[3] * dt;
+
+    p[P00] += dt * (2.0f * p[P02] + dt * p[P22]) + qn * d4;
+    p[P11] += dt * (2.0f * p[P13] + dt * p[P33]) + qe * d4;
+    p[P01] += dt * (p[P03] + p[P12] + dt * p[P23]);
+    p[P02] += dt * p[P22] + qn * d3;
+    p[P03] += dt * p[P23];
+    p[P12] += dt * p[P23];
+    p[P13] += dt * p[P33] + qe * d3;
+    p[P22] += qn * dt2;
+    p[P33] += qe * dt2;
+}
+
+float vps_ekf32_correct(float x[4], float p[VPS_EKF_PACKED], float zn, float ze,
+                        float rn, float re, float gate) {
+    float y0 = zn - x[0];
+    float y1 = ze - x[1];
+
+    float s00 = p[P00] + rn, s01 = p[P01], s11 = p[P11] + re;
+    float det = s00 * s11 - s01 * s01;
+    if (!(det > 0.0f)) return INFINITY;
+    float idet = 1.0f / det;
+    float i00 = s11 * idet, i01 = -s01 * idet, i11 = s00 * idet;
+
+    float d = sqrtf(fabsf(y0 * (i00 * y0 + i01 * y1) + y1 * (i01 * y0 + i11 * y1)));
+    if (d > gate) return d;
+
+    float c0[4] = {p[P00], p[P01], p[P02], p[P03]};
+    float c1[4] = {p[P01], p[P11], p[P12], p[P13]};
+    float k0[4], k1[4];
+    for (int i = 0; i < 4; i++) {
+        k0[i] = c0[i] * i00 + c1[i] * i01;
+        k1[i] = c0[i] * i01 + c1[i] * i11;
+        x[i] += k0[i] * y0 + k1[i] * y1;
+    }
+
+    p[P00] -= k0[0] * c0[0] + k1[0] * c1[0];
+    p[P01] -= k0[0] * c0[1] + k1[0] * c1[1];
+    p[P02] -= k0[0] * c0[2] + k1[0] * c1[2];
+    p[P03] -= k0[0] * c0[3] + k1[0] * c1[3];
+    p[P11] -= k0[1] * c0[1] + k1[1] * c1[1];
+    p[P12] -= k0[1] * c0[2] + k1[1] * c1[2];
+    p[P13] -= k0[1] * c0[3] + k1[1] * c1[3];
+    p[P22] -= k0[2] * c0[2] + k1[2] * c1[2];
+    p[P23] -= k0[2] * c0[3] + k1[2] * c1[3];
+    p[P33] -= k0[3] * c0[3] + k1[3] * c1[3];
+    return d;
+}
+
+/* --- Filter --- */
+
+void vps_ekf32_init(vps_ekf32_t *f, double reanchor_m) {
+    memset(f, 0, sizeof(*f));
+    f->reanchor_m = reanchor_m > 0 ? reanchor_m : VPS_EKF32_REANCHOR_DEFAULT_M;
+}
+
+static void set_origin(vps_ekf32_t *f, double lat, double lon) {
+    f->lat0 = lat;
+    f->lon0 = lon;
+    f->m_lat = M_PER_DEG;
+    f->m_lon = M_PER_DEG * cos(lat * M_PI / 180.0);
+}
+
+/* First measurement: same prior as the degree filter (1e-6 deg² on the diagonal) */
+static void first_fix(vps_ekf32_t *f, vps_geopoint_t z, double t) {
+    set_origin(f, z.lat, z.lon);
+    memset(f->x, 0, sizeof(f->x));
+    memset(f->p, 0, sizeof(f->p));
+    f->p[P00] = f->p[P22] = (float)(1e-6 * f->m_lat * f->m_lat);
+    f->p[P11] = f->p[P33] = (float)(1e-6 * f->m_lon * f->m_lon);
+    f->last_t = t;
+    f->initialized = true;
+    f->last_gate = 0.0f;
+}
+
+void vps_ekf32_reanchor(vps_ekf32_t *f) {
+    if (!f->initialized) return;
+    double m_lon = f->m_lon;
+    set_origin(f, f->lat0 + f->x[0] / f->m_lat, f->lon0 + f->x[1] / m_lon);
+
+    /* East scale changes with cos(lat0): rescale the e / ve rows and columns */
+    float s = (float)(f->m_lon / m_lon), s2 = s * s;
+    f->x[0] = 0.0f;
+    f->x[1] = 0.0f;
+    f->x[3] *= s;
+    f->p[P01] *= s; f->p[P03] *= s; f->p[P12] *= s; f->p[P23] *= s;
+    f->p[P11] *= s2; f->p[P13] *= s2; f->p[P33] *= s2;
+    f->reanchors++;
+}
+
+bool vps_ekf32_update(vps_ekf32_t *f, const vps_ekf_config_t *cfg,
+                      vps_geopoint_t measurement, double hdop, double t) {
+    if (!f->initialized) {
+        first_fix(f, measurement, t);
+        return true;
+    }
+
+    double dt = t - f->last_t;
+    if (dt < 0) return false;
+    if (dt > cfg->max_gap_s) {
+        first_fix(f, measurement, t);
+        return true;
+    }
+
+    double a2 = f->m_lat * f->m_lat, b2 = f->m_lon * f->m_lon;
+    double r = cfg->measurement_noise * hdop * hdop;
+    float x[4], p[VPS_EKF_PACKED];
+    memcpy(x, f->x, sizeof(x));
+    memcpy(p, f->p, sizeof(p));
+    vps_ekf32_propagate(x, p, (float)(cfg->process_noise * a2),
+                        (float)(cfg->process_noise * b2), (float)dt);
+
+    float zn = (float)((measurement.lat - f->lat0) * f->m_lat);
+    float ze = (float)((measurement.lon - f->lon0) * f->m_lon);
+    float d = vps_ekf32_correct(x, p, zn, ze, (float)(r * a2), (float)(r * b2),
+                                (float)cfg->gate_threshold);
+    if (isinf(d)) return false;
+
+    f->last_gate = d;
+    memcpy(f->x, x, sizeof(x));
+    memcpy(f->p, p, sizeof(p));
+    f->last_t = t;
+    if (f->x[0] * f->x[0] + f->x[1] * f->x[1] > f->reanchor_m * f->reanchor_m)
+        vps_ekf32_reanchor(f);
+    return d <= cfg->gate_threshold;
+}
+
+vps_geopoint_t vps_ekf32_predict(const vps_ekf32_t *f, double t) {
+    vps_geopoint_t g = {0.0, 0.0};
+    if (!f->initialized) return g;
+    double dt = t - f->last_t;
+    g.lat = f->lat0 + (f->x[0] + (double)f->x[2] * dt) / f->m_lat;
+    g.lon = f->lon0 + (f->x[1] + (double)f->x[3] * dt) / f->m_lon;
+    return g;
+}
+
+vps_geopoint_t vps_ekf32_position(const vps_ekf32_t *f) {
+    vps_geopoint_t g = {0.0, 0.0};
+    if (!f->initialized) return g;
+    g.lat = f->lat0 + f->x[0] / f->m_lat;
+    g.lon = f->lon0 + f->x[1] / f->m_lon;
+    return g;
+}
+
+double vps_ekf32_speed(const vps_ekf32_t *f) {
+    if (!f->initialized) return 0.0;
+    return sqrt((double)f->x[2] * f->x[2] + (double)f->x[3] * f->x[3]);
+}
+
+void vps_ekf32_to_state(const vps_ekf32_t *f, vps_ekf_state_t *s) {
+    vps_ekf_init(s);
+    if (!f->initialized) return;
+    double sc[4] = {f->m_lat, f->m_lon, f->m_lat, f->m_lon};
+    s->x[0] = f->lat0 + f->x[0] / sc[0];
+    s->x[1] = f->lon0 + f->x[1] / sc[1];
+    s->x[2] = f->x[2] / sc[2];
+    s->x[3] = f->x[3] / sc[3];
+    double p[VPS_EKF_PACKED];
+    for (int k = 0; k < VPS_EKF_PACKED; k++) p[k] = f->p[k] / (sc[prow[k]] * sc[pcol[k]]);
+    vps_ekf_unpack_cov(s->P, p);
+    s->last_t = f->last_t;
+    s->initialized = true;
+    s->last_gate = f->last_gate;
+}
+
+void vps_ekf32_from_state(vps_ekf32_t *f, const vps_ekf_state_t *s) {
+    double reanchor_m = f->reanchor_m;
+    uint32_t reanchors = f->reanchors;
+    vps_ekf32_init(f, reanchor_m);
+    f->reanchors = reanchors;
+    if (!s->initialized) return;
+    set_origin(f, s->x[0], s->x[1]);
+    double sc[4] = {f->m_lat, f->m_lon, f->m_lat, f->m_lon};
+    f->x[2] = (float)(s->x[2] * sc[2]);
+    f->x[3] = (float)(s->x[3] * sc[3]);
+    double p[VPS_EKF_PACKED];
+    vps_ekf_pack_cov(p, &s->P[0][0]);
+    for (int k = 0; k < VPS_EKF_PACKED; k++) f->p[k] = (float)(p[k] * sc[prow[k]] * sc[pcol[k]]);
+    f->last_t = s->last_t;
+    f->initialized = true;
+    f->last_gate = (float)s->last_gate;
+}
+
+/* --- Float lanes --- */
+
+static int padded(const vps_ekf32_bank_t *b) {
+    return (b->n + VW - 1) / VW * VW;
+}
+
+void vps_ekf32_bank_init(vps_ekf32_bank_t *b, int n) {
+    memset(b, 0, sizeof(*b));
+    if (n < 0) n = 0;
+    if (n > VPS_EKF32_BANK_MAX) n = VPS_EKF32_BANK_MAX;
+    b->n = n;
+}
+
+void vps_ekf32_bank_broadcast(vps_ekf32_bank_t *b, const vps_ekf32_t *f, int n) {
+    vps_ekf32_bank_init(b, n);
+    for (int lane = 0; lane < b->n; lane++) {
+        for (int k = 0; k < 4; k++) b->x[k][lane] = f->x[k];
+        for (int k = 0; k < VPS_EKF_PACKED; k++) b->p[k][lane] = f->p[k];
+    }
+}
+
+void vps_ekf32_bank_propagate(vps_ekf32_bank_t *b, float qn, float qe, float dt) {
+    float dt2 = dt * dt;
+    vf vdt = vset1(dt), two = vset1(2.0f);
+    vf qn4 = vset1(qn * dt2 * dt2 * 0.25f), qe4 = vset1(qe * dt2 * dt2 * 0.25f);
+    vf qn3 = vset1(qn * dt2 * dt * 0.5f), qe3 = vset1(qe * dt2 * dt * 0.5f);
+    vf qn2 = vset1(qn * dt2), qe2 = vset1(qe * dt2);
+
+    int n = padded(b);
+    for (int i = 0; i < n; i += VW) {
+        vf p0 = vload(&b->p[P00][i]), p1 = vload(&b->p[P01][i]);
+        vf p2 = vload(&b->p[P02][i]), p3 = vload(&b->p[P03][i]);
+        vf p4 = vload(&b->p[P11][i]), p5 = vload(&b->p[P12][i]);
+        vf p6 = vload(&b->p[P13][i]), p7 = vload(&b->p[P22][i]);
+        vf p8 = vload(&b->p[P23][i]), p9 = vload(&b->p[P33][i]);
+
+        vstore(&b->x[0][i], vadd(vload(&b->x[0][i]), vmul(vload(&b->x[2][i]), vdt)));
+        vstore(&b->x[1][i], vadd(vload(&b->x[1][i]), vmul(vload(&b->x[3][i]), vdt)));
+
+        vstore(&b->p[P00][i], vadd(vadd(p0, vmul(vdt, vadd(vmul(two, p2), vmul(vdt, p7)))), qn4));
+        vstore(&b->p[P11][i], vadd(vadd(p4, vmul(vdt, vadd(vmul(two, p6), vmul(vdt, p9)))), qe4));
+        vstore(&b->p[P01][i], vadd(p1, vmul(vdt, vadd(vadd(p3, p5), vmul(vdt, p8)))));
+        vstore(&b->p[P02][i], vadd(vadd(p2, vmul(vdt, p7)), qn3));
+        vstore(&b->p[P03][i], vadd(p3, vmul(vdt, p8)));
+        vstore(&b->p[P12][i], vadd(p5, vmul(vdt, p8)));
+        vstore(&b->p[P13][i], vadd(vadd(p6, vmul(vdt, p9)), qe3));
+        vstore(&b->p[P22][i], vadd(p7, qn2));
+        vstore(&b->p[P33][i], vadd(p9, qe2));
+    }
+}
+
+int vps_ekf32_bank_correct(vps_ekf32_bank_t *b, const float *zn, const float *ze,
+                           const float *rn, const float *re, float gate, float *d_out) {
+    _Alignas(32) float z0[VPS_EKF32_BANK_MAX], z1[VPS_EKF32_BANK_MAX];
+    _Alignas(32) float r0[VPS_EKF32_BANK_MAX], r1[VPS_EKF32_BANK_MAX];
+    _Alignas(32) float dd[VPS_EKF32_BANK_MAX];
+    int n = padded(b);
+    for (int i = 0; i < n; i++) {
+        bool live = i < b->n;
+        z0[i] = live ? zn[i] : 0.0f;
+        z1[i] = live ? ze[i] : 0.0f;
+        r0[i] = live ? rn[i] : 0.0f;
+        r1[i] = live ? re[i] : 0.0f;
+    }
+
+    vf vgate = vset1(gate), zero = vset1(0.0f), inf = vset1(INFINITY);
+    for (int i = 0; i < n; i += VW) {
+        vf c0[4], c1[4], x[4];
+        for (int k = 0; k < 4; k++) x[k] = vload(&b->x[k][i]);
+        c0[0] = vload(&b->p[P00][i]); c0[1] = vload(&b->p[P01][i]);
+        c0[2] = vload(&b->p[P02][i]); c0[3] = vload(&b->p[P03][i]);
+        c1[0] = c0[1];                c1[1] = vload(&b->p[P11][i]);
+        c1[2] = vload(&b->p[P12][i]); c1[3] = vload(&b->p[P13][i]);
+
+        vf y0 = vsub(vload(&z0[i]), x[0]);
+        vf y1 = vsub(vload(&z1[i]), x[1]);
+
+        vf s00 = vadd(c0[0], vload(&r0[i])), s01 = c0[1], s11 = vadd(c1[1], vload(&r1[i]));
+        vf det = vsub(vmul(s00, s11), vmul(s01, s01));
+        vf i00 = vdiv(s11, det), i01 = vdiv(vneg(s01), det), i11 = vdiv(s00, det);
+
+        vf d2 = vadd(vmul(y0, vadd(vmul(i00, y0), vmul(i01, y1))),
+                     vmul(y1, vadd(vmul(i01, y0), vmul(i11, y1))));
+        vm ok = vgt(det, zero);
+        vf d = vsel(ok, vsqrt(vabs(d2)), inf);
+        vstore(&dd[i], d);
+        vm acc = vand(ok, vle(d, vgate));
+
+        vf k0[4], k1[4];
+        for (int k = 0; k < 4; k++) {
+            k0[k] = vadd(vmul(c0[k], i00), vmul(c1[k], i01));
+            k1[k] = vadd(vmul(c0[k], i01), vmul(c1[k], i11));
+            vf xn = vadd(x[k], vadd(vmul(k0[k], y0), vmul(k1[k], y1)));
+            vstore(&b->x[k][i], vsel(acc, xn, x[k]));
+        }
+
+#define UPD(idx, a, c)                                                     \
+        do {                                                               \
+            vf old = vload(&b->p[idx][i]);                                 \
+            vf nw = vsub(old, vadd(vmul(k0[a], c0[c]), vmul(k1[a], c1[c]))); \
+            vstore(&b->p[idx][i], vsel(acc, nw, old));                     \
+        } while (0)
+        UPD(P00, 0, 0); UPD(P01, 0, 1); UPD(P02, 0, 2); UPD(P03, 0, 3);
+        UPD(P11, 1, 1); UPD(P12, 1, 2); UPD(P13, 1, 3);
+        UPD(P22, 2, 2); UPD(P23, 2, 3);
+        UPD(P33, 3, 3);
+#undef UPD
+    }
+
+    int passed = 0;
+    for (int i = 0; i < b->n; i++) {
+        if (d_out) d_out[i] = dd[i];
+        if (dd[i] <= gate) passed++;
+    }
+    return passed;
+}
+
+const char *vps_ekf32_bank_isa(void) {
+    return ISA;
+}
@@ -0,0 +1,262 @@
+/**
+ * @file ekf_bank.c
+ * @brief SoA EKF bank with AVX2 / NEON / scalar lane kernels.
+ */
+#include "ekf_bank.h"
+#include <math.h>
+#include <string.h>
+
+/* --- Lane vector abstraction --- */
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VW 4
+#define ISA "avx2"
+typedef __m256d vd;
+typedef __m256d vm;
+#define vload(p)      _mm256_load_pd(p)
+#define vstore(p, a)  _mm256_store_pd(p, a)
+#define vset1(s)      _mm256_set1_pd(s)
+#define vadd(a, b)    _mm256_add_pd(a, b)
+#define vsub(a, b)    _mm256_sub_pd(a, b)
+#define vmul(a, b)    _mm256_mul_pd(a, b)
+#define vdiv(a, b)    _mm256_div_pd(a, b)
+#define vsqrt(a)      _mm256_sqrt_pd(a)
+#define vabs(a)       _mm256_andnot_pd(_mm256_set1_pd(-0.0), a)
+#define vneg(a)       _mm256_xor_pd(a, _mm256_set1_pd(-0.0))
+#define vle(a, b)     _mm256_cmp_pd(a, b, _CMP_LE_OQ)
+#define vge(a, b)     _mm256_cmp_pd(a, b, _CMP_GE_OQ)
+#define vand(m, n)    _mm256_and_pd(m, n)
+#define vsel(m, a, b) _mm256_blendv_pd(b, a, m)
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define VW 2
+#define ISA "neon"
+typedef float64x2_t vd;
+typedef uint64x2_t vm;
+#define vload(p)      vld1q_f64(p)
+#define vstore(p, a)  vst1q_f64(p, a)
+#define vset1(s)      vdupq_n_f64(s)
+#define vadd(a, b)    vaddq_f64(a, b)
+#define vsub(a, b)    vsubq_f64(a, b)
+#define vmul(a, b)    vmulq_f64(a, b)
+#define vdiv(a, b)    vdivq_f64(a, b)
+#define vsqrt(a)      vsqrtq_f64(a)
+#define vabs(a)       vabsq_f64(a)
+#define vneg(a)       vnegq_f64(a)
+#define vle(a, b)     vcleq_f64(a, b)
+#define vge(a, b)     vcgeq_f64(a, b)
+#define vand(m, n)    vandq_u64(m, n)
+#define vsel(m, a, b) vbslq_f64(m, a, b)
+#else
+#define VW 1
+#define ISA "scalar"
+typedef double vd;
+typedef int vm;
+#define vload(p)      (*(p))
+#define vstore(p, a)  (*(p) = (a))
+#define vset1(s)      (s)
+#define vadd(a, b)    ((a) + (b))
+#define vsub(a, b)    ((a) - (b))
+#define vmul(a, b)    ((a) * (b))
+#define vdiv(a, b)    ((a) / (b))
+#define vsqrt(a)      sqrt(a)
+#define vabs(a)       fabs(a)
+#define vneg(a)       (-(a))
+#define vle(a, b)     ((a) <= (b))
+#define vge(a, b)     ((a) >= (b))
+#define vand(m, n)    ((m) && (n))
+#define vsel(m, a, b) ((m) ? (a) : (b))
+#endif
+
+enum { P00, P01, P02, P03, P11, P12, P13, P22, P23, P33 };
+
+/** Active lanes rounded up to whole vectors. */
+static int padded(const vps_ekf_bank_t *b) {
+    return (b->n + VW - 1) / VW * VW;
+}
+
+/* --- Public API --- */
+
+void vps_ekf_bank_init(vps_ekf_bank_t *b, int n) {
+    memset(b, 0, sizeof(*b));
+    if (n < 0) n = 0;
+    if (n > VPS_EKF_BANK_MAX) n = VPS_EKF_BANK_MAX;
+    b->n = n;
+}
+
+void vps_ekf_bank_broadcast(vps_ekf_bank_t *b, const vps_ekf_state_t *s, int n) {
+    vps_ekf_bank_init(b, n);
+    double p[VPS_EKF_PACKED];
+    vps_ekf_pack_cov(p, &s->P[0][0]);
+    for (int lane = 0; lane < b->n; lane++) vps_ekf_bank_set(b, lane, s->x, p);
+}
+
+void vps_ekf_bank_set(vps_ekf_bank_t *b, int lane, const double x[4],
+                      const double p[VPS_EKF_PACKED]) {
+    for (int k = 0; k < 4; k++) b->x[k][lane] = x[k];
+    for (int k = 0; k < VPS_EKF_PACKED; k++) b->p[k][lane] = p[k];
+}
+
+void vps_ekf_bank_get(const vps_ekf_bank_t *b, int lane, double x[4],
+                      double p[VPS_EKF_PACKED]) {
+    for (int k = 0; k < 4; k++) x[k] = b->x[k][lane];
+    for (int k = 0; k < VPS_EKF_PACKED; k++) p[k] = b->p[k][lane];
+}
+
+void vps_ekf_bank_propagate(vps_ekf_bank_t *b, double q, double dt) {
+    double dt2 = dt * dt;
+    vd vdt = vset1(dt), two = vset1(2.0);
+    vd q4 = vset1(q * dt2 * dt2 / 4.0);
+    vd q3 = vset1(q * dt2 * dt / 2.0);
+    vd q2 = vset1(q * dt2);
+
+    int n = padded(b);
+    for (int i = 0; i < n; i += VW) {
+        vd p0 = vload(&b->p[P00][i]), p1 = vload(&b->p[P01][i]);
+        vd p2 = vload(&b->p[P02][i]), p3 = vload(&b->p[P03][i]);
+        vd p4 = vload(&b->p[P11][i]), p5 = vload(&b->p[P12][i]);
+        vd p6 = vload(&b->p[P13][i]), p7 = vload(&b->p[P22][i]);
+        vd p8 = vload(&b->p[P23][i]), p9 = vload(&b->p[P33][i]);
+        vd x0 = vload(&b->x[0][i]), x1 = vload(&b->x[1][i]);
+        vd x2 = vload(&b->x[2][i]), x3 = vload(&b->x[3][i]);
+
+        vstore(&b->x[0][i], vadd(x0, vmul(x2, vdt)));
+        vstore(&b->x[1][i], vadd(x1, vmul(x3, vdt)));
+
+        vstore(&b->p[P00][i], vadd(vadd(p0, vmul(vdt, vadd(vmul(two, p2), vmul(vdt, p7)))), q4));
+        vstore(&b->p[P11][i], vadd(vadd(p4, vmul(vdt, vadd(vmul(two, p6), vmul(vdt, p9)))), q4));
+        vstore(&b->p[P01][i], vadd(p1, vmul(vdt, vadd(vadd(p3, p5), vmul(vdt, p8)))));
+        vstore(&b->p[P02][i], vadd(vadd(p2, vmul(vdt, p7)), q3));
+        vstore(&b->p[P03][i], vadd(p3, vmul(vdt, p8)));
+        vstore(&b->p[P12][i], vadd(p5, vmul(vdt, p8)));
+        vstore(&b->p[P13][i], vadd(vadd(p6, vmul(vdt, p9)), q3));
+        vstore(&b->p[P22][i], vadd(p7, q2));
+        vstore(&b->p[P33][i], vadd(p9, q2));
+    }
+}
+
+void vps_ekf_bank_propagate_models(vps_ekf_bank_t *b, const double *q,
+                                   const double *a, double dt) {
+    /* Per-lane noise and velocity retention, padded like the measurements */
+    _Alignas(32) double q4[VPS_EKF_BANK_MAX], q3[VPS_EKF_BANK_MAX];
+    _Alignas(32) double q2[VPS_EKF_BANK_MAX], aa[VPS_EKF_BANK_MAX];
+    double dt2 = dt * dt;
+    int n = padded(b);
+    for (int i = 0; i < n; i++) {
+        bool live = i < b->n;
+        double qi = live ? q[i] : 0.0;
+        q4[i] = qi * dt2 * dt2 / 4.0;
+        q3[i] = qi * dt2 * dt / 2.0;
+        q2[i] = qi * dt2;
+        aa[i] = live ? a[i] : 1.0;
+    }
+
+    vd vdt = vset1(dt), two = vset1(2.0);
+    for (int i = 0; i < n; i += VW) {
+        vd p0 = vload(&b->p[P00][i]), p1 = vload(&b->p[P01][i]);
+        vd p2 = vload(&b->p[P02][i]), p3 = vload(&b->p[P03][i]);
+        vd p4 = vload(&b->p[P11][i]), p5 = vload(&b->p[P12][i]);
+        vd p6 = vload(&b->p[P13][i]), p7 = vload(&b->p[P22][i]);
+        vd p8 = vload(&b->p[P23][i]), p9 = vload(&b->p[P33][i]);
+        vd x0 = vload(&b->x[0][i]), x1 = vload(&b->x[1][i]);
+        vd x2 = vload(&b->x[2][i]), x3 = vload(&b->x[3][i]);
+        vd va = vload(&aa[i]), va2 = vmul(va, va);
+        vd vq4 = vload(&q4[i]), vq3 = vload(&q3[i]), vq2 = vload(&q2[i]);
+
+        vstore(&b->x[0][i], vadd(x0, vmul(x2, vdt)));
+        vstore(&b->x[1][i], vadd(x1, vmul(x3, vdt)));
+        vstore(&b->x[2][i], vmul(va, x2));
+        vstore(&b->x[3][i], vmul(va, x3));
+
+        vstore(&b->p[P00][i], vadd(vadd(p0, vmul(vdt, vadd(vmul(two, p2), vmul(vdt, p7)))), vq4));
+        vstore(&b->p[P11][i], vadd(vadd(p4, vmul(vdt, vadd(vmul(two, p6), vmul(vdt, p9)))), vq4));
+        vstore(&b->p[P01][i], vadd(p1, vmul(vdt, vadd(vadd(p3, p5), vmul(vdt, p8)))));
+        vstore(&b->p[P02][i], vadd(vmul(va, vadd(p2, vmul(vdt, p7))), vq3));
+        vstore(&b->p[P03][i], vmul(va, vadd(p3, vmul(vdt, p8))));
+        vstore(&b->p[P12][i], vmul(va, vadd(p5, vmul(vdt, p8))));
+        vstore(&b->p[P13][i], vadd(vmul(va, vadd(p6, vmul(vdt, p9))), vq3));
+        vstore(&b->p[P22][i], vadd(vmul(va2, p7), vq2));
+        vstore(&b->p[P23][i], vmul(va2, p8));
+        vstore(&b->p[P33][i], vadd(vmul(va2, p9), vq2));
+    }
+}
+
+int vps_ekf_bank_correct(vps_ekf_bank_t *b, const double *z_lat,
+                         const double *z_lon, const double *r,
+                         double gate, double *d_out) {
+    /* Aligned, padded copies so the tail vector never reads past n */
+    _Alignas(32) double zl[VPS_EKF_BANK_MAX], zo[VPS_EKF_BANK_MAX];
+    _Alignas(32) double rr[VPS_EKF_BANK_MAX], dd[VPS_EKF_BANK_MAX];
+    int n = padded(b);
+    for (int i = 0; i < n; i++) {
+        bool live = i < b->n;
+        zl[i] = live ? z_lat[i] : 0.0;
+        zo[i] = live ? z_lon[i] : 0.0;
+        rr[i] = live ? r[i] : 0.0;
+    }
+
+    vd vgate = vset1(gate), tiny = vset1(1e-30), inf = vset1(INFINITY);
+    for (int i = 0; i < n; i += VW) {
+        vd c0[4], c1[4], x[4];
+        for (int k = 0; k < 4; k++) x[k] = vload(&b->x[k][i]);
+        c0[0] = vload(&b->p[P00][i]); c0[1] = vload(&b->p[P01][i]);
+        c0[2] = vload(&b->p[P02][i]); c0[3] = vload(&b->p[P03][i]);
+        c1[0] = c0[1];                c1[1] = vload(&b->p[P11][i]);
+        c1[2] = vload(&b->p[P12][i]); c1[3] = vload(&b->p[P13][i]);
+
+        vd y0 = vsub(vload(&zl[i]), x[0]);
+        vd y1 = vsub(vload(&zo[i]), x[1]);
+        vd vr = vload(&rr[i]);
+
+        vd s00 = vadd(c0[0], vr), s01 = c0[1], s11 = vadd(c1[1], vr);
+        vd det = vsub(vmul(s00, s11), vmul(s01, s01));
+        vd i00 = vdiv(s11, det), i01 = vdiv(vneg(s01), det), i11 = vdiv(s00, det);
+
+        vd d2 = vadd(vmul(y0, vadd(vmul(i00, y0), vmul(i01, y1))),
+                     vmul(y1, vadd(vmul(i01, y0), vmul(i11, y1))));
+        vm ok = vge(vabs(det), tiny);
+        vd d = vsel(ok, vsqrt(vabs(d2)), inf);
+        vstore(&dd[i], d);
+        vm acc = vand(ok, vle(d, vgate));
+
+        vd k0[4], k1[4];
+        for (int k = 0; k < 4; k++) {
+            k0[k] = vadd(vmul(c0[k], i00), vmul(c1[k], i01));
+            k1[k] = vadd(vmul(c0[k], i01), vmul(c1[k], i11));
+            vd xn = vadd(x[k], vadd(vmul(k0[k], y0), vmul(k1[k], y1)));
+            vstore(&b->x[k][i], vsel(acc, xn, x[k]));
+        }
+
+#define UPD(idx, a, c)                                                     \
+        do {                                                               \
+            vd old = vload(&b->p[idx][i]);                                 \
+            vd nw = vsub(old, vadd(vmul(k0[a], c0[c]), vmul(k1[a], c1[c]))); \
+            vstore(&b->p[idx][i], vsel(acc, nw, old));                     \
+        } while (0)
+        UPD(P00, 0, 0); UPD(P01, 0, 1); UPD(P02, 0, 2); UPD(P03, 0, 3);
+        UPD(P11, 1, 1); UPD(P12, 1, 2); UPD(P13, 1, 3);
+        UPD(P22, 2, 2); UPD(P23, 2, 3);
+        UPD(P33, 3, 3);
+#undef UPD
+    }
+
+    /* Padding lanes are updated too but never reported */
+    int passed = 0;
+    for (int i = 0; i < b->n; i++) {
+        d_out[i] = dd[i];
+        if (dd[i] <= gate) passed++;
+    }
+    return passed;
+}
+
+int vps_ekf_bank_best(const double *d, int n, double gate) {
+    int best = -1;
+    for (int i = 0; i < n; i++)
+        if (d[i] <= gate && (best < 0 || d[i] < d[best])) best = i;
+    return best;
+}
+
+const char *vps_ekf_bank_isa(void) {
+    return ISA;
+}
@@ -0,0 +1,465 @@
+/**
+ * @file fence_set.c
+ * @brief Inclusion fence plus exclusion zones behind a BVH.
+ */
+#include "fence_set.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define KM_PER_DEG (6371.0 * M_PI / 180.0)   /* same sphere as vps_haversine_km */
+#define STACK 64
+#define NO_ZONE (-2)
+
+/* --- Zones --- */
+
+static double cos_deg(double deg) {
+    return cos(fmin(fabs(deg), 89.9) * M_PI / 180.0);
+}
+
+/* Box around the zone grown by its margin, padded for haversine vs. flat */
+static void zone_box(vps_fence_zone_t *z) {
+    const vps_geofence_t *f = &z->fence;
+    double lat0, lat1, lon0, lon1;
+    if (f->type == VPS_FENCE_POLYGON) {
+        lat0 = f->poly->min_lat;
+        lat1 = f->poly->max_lat;
+        lon0 = f->poly->min_lon;
+        lon1 = f->poly->max_lon;
+    } else {
+        double hn = f->type == VPS_FENCE_CIRCLE ? f->radius_km : f->half_lat_km;
+        double he = f->type == VPS_FENCE_CIRCLE ? f->radius_km : f->half_lon_km;
+        double dlat = hn / KM_PER_DEG;
+        double c = f->type == VPS_FENCE_CIRCLE ? cos_deg(fabs(f->center.lat) + dlat)
+                                               : cos_deg(f->center.lat);
+        lat0 = f->center.lat - dlat;
+        lat1 = f->center.lat + dlat;
+        lon0 = f->center.lon - he / (KM_PER_DEG * c);
+        lon1 = f->center.lon + he / (KM_PER_DEG * c);
+    }
+    double m = fmax(f->margin_km, 0.0);
+    double dlat = m / KM_PER_DEG + 0.01 * (lat1 - lat0) + 1e-6;
+    lat0 -= dlat;
+    lat1 += dlat;
+    double c = cos_deg(fmax(fabs(lat0), fabs(lat1)));
+    double dlon = m / (KM_PER_DEG * c) + 0.01 * (lon1 - lon0) + 1e-6;
+    z->min_lat = lat0;
+    z->max_lat = lat1;
+    z->min_lon = lon0 - dlon;
+    z->max_lon = lon1 + dlon;
+}
+
+/*
+ * Clearance of one zone, exact up to limit_km (larger values may be
+ * returned as limit_km). The polygon search is capped accordingly.
+ */
+static double zone_clearance(const vps_fence_zone_t *z, bool exclusion, vps_geopoint_t p,
+                             double limit_km) {
+    const vps_geofence_t *f = &z->fence;
+    double d = f->type == VPS_FENCE_POLYGON
+                   ? vps_geofence_poly_distance_capped_km(f->poly, p, limit_km + f->margin_km)
+                   : vps_geofence_distance_km(f, p);
+    return (exclusion ? -d : d) - f->margin_km;
+}
+
+/*
+ * Lower bound (km) on the clearance of anything inside the box. Rect
+ * fences measure north and east separately, so the bound is the larger
+ * axis gap rather than the Euclidean one.
+ */
+static double box_bound_km(double min_lat, double min_lon, double max_lat, double max_lon,
+                           vps_geopoint_t p) {
+    double dlat = fmax(0.0, fmax(min_lat - p.lat, p.lat - max_lat));
+    double dlon = fmax(0.0, fmax(min_lon - p.lon, p.lon - max_lon));
+    if (dlat == 0.0 && dlon == 0.0) return 0.0;
+    double c = cos_deg(fmax(fabs(p.lat), fmax(fabs(min_lat), fabs(max_lat))));
+    return 0.99 * KM_PER_DEG * fmax(dlat, dlon * c);
+}
+
+static inline bool box_holds(double min_lat, double min_lon, double max_lat, double max_lon,
+                             vps_geopoint_t p) {
+    return p.lat >= min_lat && p.lat <= max_lat && p.lon >= min_lon && p.lon <= max_lon;
+}
+
+/* Inside the zone or within its keep-out margin */
+static bool zone_violated(const vps_fence_zone_t *z, vps_geopoint_t p) {
+    const vps_geofence_t *f = &z->fence;
+    if (f->type != VPS_FENCE_POLYGON) return zone_clearance(z, true, p, 0.0) < 0.0;
+    if (vps_geofence_poly_contains(f->poly, p, 0.0)) return true;
+    return f->margin_km > 0.0 &&
+           -vps_geofence_poly_distance_capped_km(f->poly, p, f->margin_km) < f->margin_km;
+}
+
+/* --- BVH --- */
+
+typedef struct {
+    vps_fence_zone_t zone;
+    double clat, clon;
+} build_item_t;
+
+static int cmp_lat(const void *a, const void *b) {
+    double x = ((const build_item_t *)a)->clat, y = ((const build_item_t *)b)->clat;
+    return (x > y) - (x < y);
+}
+
+static int cmp_lon(const void *a, const void *b) {
+    double x = ((const build_item_t *)a)->clon, y = ((const build_item_t *)b)->clon;
+    return (x > y) - (x < y);
+}
+
+/* Node over items[lo, hi); zones are written in leaf order */
+static int build_node(vps_fence_set_t *set, build_item_t *items, int lo, int hi) {
+    int idx = set->n_nodes++;
+    vps_bvh_node_t *node = &set->nodes[idx];
+    node->min_lat = node->min_lon = INFINITY;
+    node->max_lat = node->max_lon = -INFINITY;
+    for (int i = lo; i < hi; i++) {
+        const vps_fence_zone_t *z = &items[i].zone;
+        node->min_lat = fmin(node->min_lat, z->min_lat);
+        node->min_lon = fmin(node->min_lon, z->min_lon);
+        node->max_lat = fmax(node->max_lat, z->max_lat);
+        node->max_lon = fmax(node->max_lon, z->max_lon);
+    }
+    if (hi - lo <= VPS_FENCE_SET_LEAF) {
+        node->first = lo;
+        node->count = hi - lo;
+        for (int i = lo; i < hi; i++) set->zones[i] = items[i].zone;
+        return idx;
+    }
+    /* Median split of the centres on the longer axis (lon scaled at mid latitude) */
+    double mid_lat = 0.5 * (node->min_lat + node->max_lat);
+    bool by_lat = node->max_lat - node->min_lat >=
+                  (node->max_lon - node->min_lon) * cos_deg(mid_lat);
+    qsort(items + lo, (size_t)(hi - lo), sizeof(build_item_t), by_lat ? cmp_lat : cmp_lon);
+    int mid = lo + (hi - lo) / 2;
+    node->count = 0;
+    build_node(set, items, lo, mid);
+    int right = build_node(set, items, mid, hi);
+    set->nodes[idx].first = right;
+    return idx;
+}
+
+bool vps_fence_set_build(vps_fence_set_t *set, const vps_fence_zone_t *inclusion,
+                         const vps_fence_zone_t *zones, int n_zones) {
+    memset(set, 0, sizeof(*set));
+    if (n_zones < 0 || (n_zones > 0 && !zones)) return false;
+    if (inclusion) {
+        set->has_inclusion = true;
+        set->inclusion = *inclusion;
+        zone_box(&set->inclusion);
+    }
+    if (n_zones == 0) return true;
+
+    build_item_t *items = malloc(sizeof(build_item_t) * (size_t)n_zones);
+    set->zones = malloc(sizeof(vps_fence_zone_t) * (size_t)n_zones);
+    set->nodes = malloc(sizeof(vps_bvh_node_t) * (size_t)(2 * n_zones));
+    if (!items || !set->zones || !set->nodes) {
+        free(items);
+        vps_fence_set_free(set);
+        return false;
+    }
+    for (int i = 0; i < n_zones; i++) {
+        items[i].zone = zones[i];
+        zone_box(&items[i].zone);
+        items[i].clat = 0.5 * (items[i].zone.min_lat + items[i].zone.max_lat);
+        items[i].clon = 0.5 * (items[i].zone.min_lon + items[i].zone.max_lon);
+    }
+    set->n_zones = n_zones;
+    build_node(set, items, 0, n_zones);
+    free(items);
+    return true;
+}
+
+void vps_fence_set_free(vps_fence_set_t *set) {
+    for (int i = 0; i < set->n_polys; i++) vps_geofence_poly_free(&set->polys[i]);
+    free(set->polys);
+    free(set->zones);
+    free(set->nodes);
+    memset(set, 0, sizeof(*set));
+}
+
+/* --- Queries --- */
+
+bool vps_fence_set_contains(const vps_fence_set_t *set, vps_geopoint_t point) {
+    if (set->has_inclusion && !vps_geofence_contains(&set->inclusion.fence, point))
+        return false;
+    if (set->n_zones == 0) return true;
+    int stack[STACK], top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const vps_bvh_node_t *node = &set->nodes[stack[--top]];
+        if (!box_holds(node->min_lat, node->min_lon, node->max_lat, node->max_lon, point))
+            continue;
+        if (node->count == 0) {
+            stack[top++] = node->first;
+            stack[top++] = (int)(node - set->nodes) + 1;
+            continue;
+        }
+        for (int i = node->first; i < node->first + node->count; i++) {
+            const vps_fence_zone_t *z = &set->zones[i];
+            if (box_holds(z->min_lat, z->min_lon, z->max_lat, z->max_lon, point) &&
+                zone_violated(z, point))
+                return false;
+        }
+    }
+    return true;
+}
+
+static void try_zone(const vps_fence_set_t *set, int i, vps_geopoint_t p,
+                     vps_fence_result_t *r) {
+    const vps_fence_zone_t *z = &set->zones[i];
+    if (box_bound_km(z->min_lat, z->min_lon, z->max_lat, z->max_lon, p) >= r->clearance_km)
+        return;
+    double c = zone_clearance(z, true, p, r->clearance_km);
+    if (c < r->clearance_km) {
+        r->clearance_km = c;
+        r->zone = i;
+        r->zone_id = z->id;
+    }
+}
+
+/* Branch and bound for the smallest clearance, seeded with zone hint */
+static vps_fence_result_t check_one(const vps_fence_set_t *set, vps_geopoint_t p, int hint) {
+    vps_fence_result_t r = {true, NO_ZONE, 0, INFINITY};
+    if (set->has_inclusion) {
+        r.clearance_km = zone_clearance(&set->inclusion, false, p, INFINITY);
+        r.zone = -1;
+        r.zone_id = set->inclusion.id;
+    }
+    if (set->n_zones > 0) {
+        if (hint >= 0 && hint < set->n_zones) try_zone(set, hint, p, &r);
+        int stack[STACK], top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            int ni = stack[--top];
+            const vps_bvh_node_t *node = &set->nodes[ni];
+            if (box_bound_km(node->min_lat, node->min_lon, node->max_lat, node->max_lon, p) >=
+                r.clearance_km)
+                continue;
+            if (node->count > 0) {
+                for (int i = node->first; i < node->first + node->count; i++)
+                    try_zone(set, i, p, &r);
+                continue;
+            }
+            /* Visit the nearer child first */
+            const vps_bvh_node_t *a = &set->nodes[ni + 1], *b = &set->nodes[node->first];
+            double da = box_bound_km(a->min_lat, a->min_lon, a->max_lat, a->max_lon, p);
+            double db = box_bound_km(b->min_lat, b->min_lon, b->max_lat, b->max_lon, p);
+            if (da <= db) {
+                stack[top++] = node->first;
+                stack[top++] = ni + 1;
+            } else {
+                stack[top++] = ni + 1;
+                stack[top++] = node->first;
+            }
+        }
+    }
+    r.ok = r.clearance_km >= 0.0;
+    return r;
+}
+
+vps_fence_result_t vps_fence_set_check(const vps_fence_set_t *set, vps_geopoint_t point) {
+    return check_one(set, point, NO_ZONE);
+}
+
+int vps_fence_set_check_batch(const vps_fence_set_t *set, const vps_geopoint_t *points,
+                              int n, vps_fence_result_t *out) {
+    int first_bad = -1, hint = NO_ZONE;
+    for (int i = 0; i < n; i++) {
+        vps_fence_result_t r = check_one(set, points[i], hint);
+        hint = r.zone;
+        if (!r.ok && first_bad < 0) first_bad = i;
+        if (out) out[i] = r;
+    }
+    return first_bad;
+}
+
+/* --- Predicted breach --- */
+
+static inline bool boxes_meet(const double a[4], double min_lat, double min_lon,
+                              double max_lat, double max_lon) {
+    return a[0] <= max_lat && a[2] >= min_lat && a[1] <= max_lon && a[3] >= min_lon;
+}
+
+bool vps_fence_set_time_to_breach(const vps_fence_set_t *set, vps_geopoint_t point,
+                                  double vn_mps, double ve_mps, double radius_km,
+                                  double horizon_s, double *t_out, int *zone_out) {
+    double best = INFINITY, t;
+    int zone = NO_ZONE;
+    if (set->has_inclusion &&
+        vps_geofence_time_to_breach(&set->inclusion.fence, point, vn_mps, ve_mps, radius_km,
+                                    horizon_s, &t)) {
+        best = t;
+        zone = -1;
+    }
+    if (set->n_zones > 0 && best > 0.0) {
+        /* Box swept by the track, grown by the radius */
+        double dlat = vn_mps * 1e-3 * horizon_s / KM_PER_DEG;
+        double glat = fmax(radius_km, 0.0) / KM_PER_DEG;
+        double c = cos_deg(fabs(point.lat) + fabs(dlat) + glat);
+        double dlon = ve_mps * 1e-3 * horizon_s / (KM_PER_DEG * c), glon = glat / c;
+        double box[4] = {point.lat + fmin(dlat, 0.0) - glat, point.lon + fmin(dlon, 0.0) - glon,
+                         point.lat + fmax(dlat, 0.0) + glat, point.lon + fmax(dlon, 0.0) + glon};
+        int stack[STACK], top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const vps_bvh_node_t *node = &set->nodes[stack[--top]];
+            if (!boxes_meet(box, node->min_lat, node->min_lon, node->max_lat, node->max_lon))
+                continue;
+            if (node->count == 0) {
+                stack[top++] = node->first;
+                stack[top++] = (int)(node - set->nodes) + 1;
+                continue;
+            }
+            for (int i = node->first; i < node->first + node->count; i++) {
+                const vps_fence_zone_t *z = &set->zones[i];
+                if (boxes_meet(box, z->min_lat, z->min_lon, z->max_lat, z->max_lon) &&
+                    vps_geofence_time_to_entry(&z->fence, point, vn_mps, ve_mps, radius_km,
+                                               fmin(horizon_s, best), &t) &&
+                    t < best) {
+                    best = t;
+                    zone = i;
+                }
+            }
+        }
+    }
+    *t_out = best;
+    if (zone_out) *zone_out = zone;
+    return zone != NO_ZONE;
+}
+
+/* --- Zone files --- */
+
+static uint32_t get_u32(const uint8_t *b) {
+    return (uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24;
+}
+
+static int32_t get_i32(const uint8_t *b) {
+    return (int32_t)get_u32(b);
+}
+
+static float get_f32(const uint8_t *b) {
+    uint32_t u = get_u32(b);
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+bool vps_fence_set_parse(vps_fence_set_t *set, const uint8_t *buf, size_t len) {
+    memset(set, 0, sizeof(*set));
+    if (len < VPS_ZONE_HEADER_SIZE || memcmp(buf, "VPSZ", 4) != 0 ||
+        (buf[4] | buf[5] << 8) != VPS_ZONE_FILE_VERSION)
+        return false;
+    uint32_t count = get_u32(buf + 8);
+    if (count > (len - VPS_ZONE_HEADER_SIZE) / VPS_ZONE_RECORD_SIZE) return false;
+
+    vps_fence_zone_t *zones = calloc(count ? count : 1, sizeof(vps_fence_zone_t));
+    vps_geofence_poly_t *polys = calloc(count ? count : 1, sizeof(vps_geofence_poly_t));
+    vps_fence_zone_t inclusion;
+    int n_zones = 0, n_polys = 0;
+    bool has_inclusion = false, ok = zones && polys;
+    size_t off = VPS_ZONE_HEADER_SIZE;
+    for (uint32_t k = 0; ok && k < count; k++) {
+        if (len - off < VPS_ZONE_RECORD_SIZE) {
+            ok = false;
+            break;
+        }
+        const uint8_t *r = buf + off;
+        off += VPS_ZONE_RECORD_SIZE;
+        vps_fence_zone_t z;
+        memset(&z, 0, sizeof(z));
+        z.fence.type = (vps_fence_type_t)r[0];
+        z.fence.center = (vps_geopoint_t){get_i32(r + 4) * 1e-7, get_i32(r + 8) * 1e-7};
+        z.fence.radius_km = z.fence.half_lat_km = get_f32(r + 12);
+        z.fence.half_lon_km = get_f32(r + 16);
+        z.fence.margin_km = get_f32(r + 20);
+        z.id = get_u32(r + 24);
+        if (z.fence.type == VPS_FENCE_CIRCLE) {
+            z.fence.half_lat_km = 0.0;
+        } else if (z.fence.type == VPS_FENCE_RECT) {
+            z.fence.radius_km = 0.0;
+        } else if (z.fence.type == VPS_FENCE_POLYGON) {
+            z.fence.radius_km = z.fence.half_lat_km = 0.0;
+            int rings = r[2] | r[3] << 8;
+            if (rings < 1 || (len - off) / 4 < (size_t)rings) {
+                ok = false;
+                break;
+            }
+            int *ring_len = malloc(sizeof(int) * (size_t)rings);
+            size_t n_pts = 0;
+            for (int i = 0; ring_len && i < rings; i++) {
+                ring_len[i] = (int)get_u32(buf + off + 4 * (size_t)i);
+                n_pts += (size_t)get_u32(buf + off + 4 * (size_t)i);
+            }
+            off += 4 * (size_t)rings;
+            vps_geopoint_t *pts = NULL;
+            if (ring_len && n_pts <= (len - off) / 8 && n_pts < INT32_MAX) {
+                pts = malloc(sizeof(vps_geopoint_t) * (n_pts ? n_pts : 1));
+                for (size_t i = 0; pts && i < n_pts; i++)
+                    pts[i] = (vps_geopoint_t){get_i32(buf + off + 8 * i) * 1e-7,
+                                              get_i32(buf + off + 8 * i + 4) * 1e-7};
+                off += 8 * n_pts;
+            }
+            ok = pts && vps_geofence_poly_build(&polys[n_polys], pts, ring_len, rings);
+            free(pts);
+            free(ring_len);
+            if (!ok) break;
+            z.fence.poly = &polys[n_polys++];
+        } else {
+            ok = false;
+            break;
+        }
+        if (r[1] == VPS_ZONE_INCLUSION && !has_inclusion) {
+            inclusion = z;
+            has_inclusion = true;
+        } else if (r[1] == VPS_ZONE_EXCLUSION) {
+            zones[n_zones++] = z;
+        } else {
+            ok = false;   /* unknown role or a second inclusion fence */
+        }
+    }
+    ok = ok && off == len && vps_fence_set_build(set, has_inclusion ? &inclusion : NULL, zones,
+                                                 n_zones);
+    free(zones);
+    if (!ok) {
+        for (int i = 0; i < n_polys; i++) vps_geofence_poly_free(&polys[i]);
+        free(polys);
+        return false;
+    }
+    set->polys = polys;
+    set->n_polys = n_polys;
+    return true;
+}
+
+bool vps_fence_set_load(vps_fence_set_t *set, const char *path) {
+    memset(set, 0, sizeof(*set));
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return false;
+
+    if (fseek(fp, 0, SEEK_END) != 0) {
+        fclose(fp);
+        return false;
+    }
+    long size = ftell(fp);
+    if (size < 0 || fseek(fp, 0, SEEK_SET) != 0) {
+        fclose(fp);
+        return false;
+    }
+
+    uint8_t *buf = malloc((size_t)size + 1);
+    if (!buf) {
+        fclose(fp);
+        return false;
+    }
+    size_t n = fread(buf, 1, (size_t)size, fp);
+    fclose(fp);
+
+    bool ok = n == (size_t)size && vps_fence_set_parse(set, buf, n);
+    free(buf);
+    return ok;
+}
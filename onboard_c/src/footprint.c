@@ -0,0 +1,160 @@
+/**
+ * @file footprint.c
+ * @brief Camera frame footprint on the ground and the tiles it covers.
+ */
+#include "footprint.h"
+#include "geo_transform.h"
+#include "tile_math.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define MAX_VERTS 12            /* a quad clipped by four half-planes has at most 8 */
+#define MIN_OVERLAP 1e-9        /* tiles only touched along an edge */
+
+typedef struct {
+    double x, y;
+} pt_t;
+
+void vps_camera_default(vps_camera_t *cam) {
+    cam->focal_length_mm = 4.74;
+    cam->sensor_width_mm = 6.287;
+    cam->image_width_px = 640;
+    cam->image_height_px = 480;
+}
+
+/* Convex, and no wider or taller than the span limit */
+static bool check_quad(const vps_footprint_t *fp) {
+    double sign = 0.0, x0 = fp->x[0], x1 = fp->x[0], y0 = fp->y[0], y1 = fp->y[0];
+    for (int i = 0; i < 4; i++) {
+        int j = (i + 1) & 3, k = (i + 2) & 3;
+        double c = (fp->x[j] - fp->x[i]) * (fp->y[k] - fp->y[j]) -
+                   (fp->y[j] - fp->y[i]) * (fp->x[k] - fp->x[j]);
+        if (!(c != 0.0) || c * sign < 0.0) return false;    /* also NaN */
+        sign = c;
+        x0 = fmin(x0, fp->x[i]);
+        x1 = fmax(x1, fp->x[i]);
+        y0 = fmin(y0, fp->y[i]);
+        y1 = fmax(y1, fp->y[i]);
+    }
+    return x1 - x0 <= VPS_FOOTPRINT_MAX_SPAN && y1 - y0 <= VPS_FOOTPRINT_MAX_SPAN;
+}
+
+bool vps_footprint_from_homography(const double H[9], vps_tile_coord_t tile, int w, int h,
+                                   int zoom, vps_footprint_t *out) {
+    static const int cu[4] = {0, 1, 1, 0}, cv[4] = {0, 0, 1, 1};
+    double scale = ldexp(1.0, zoom - tile.z), w0 = 0.0;
+    out->zoom = zoom;
+    for (int i = 0; i < 4; i++) {
+        double u = cu[i] * w, v = cv[i] * h;
+        double X = H[0] * u + H[1] * v + H[2];
+        double Y = H[3] * u + H[4] * v + H[5];
+        double W = H[6] * u + H[7] * v + H[8];
+        if (fabs(W) < 1e-10 || W * w0 < 0.0) return false;
+        w0 = W;
+        out->x[i] = (tile.x + X / W / VPS_TILE_SIZE) * scale;
+        out->y[i] = (tile.y + Y / W / VPS_TILE_SIZE) * scale;
+    }
+    return check_quad(out);
+}
+
+bool vps_footprint_from_pose(vps_geopoint_t center, double altitude_m, double heading_deg,
+                             const vps_camera_t *cam, int zoom, vps_footprint_t *out) {
+    if (!(altitude_m > 0.0) || !(cam->focal_length_mm > 0.0)) return false;
+    vps_tile_coord_t t;
+    vps_pixel_t px;
+    vps_gps_to_tile_pixel(center, zoom, &t, &px);
+    double cx = t.x + px.x / VPS_TILE_SIZE, cy = t.y + px.y / VPS_TILE_SIZE;
+    double focal_px = cam->focal_length_mm * cam->image_width_px / cam->sensor_width_mm;
+    double tiles_per_px = altitude_m / focal_px /
+                          (vps_meters_per_pixel(center.lat, zoom) * VPS_TILE_SIZE);
+    double hd = heading_deg * M_PI / 180.0, ch = cos(hd), sh = sin(hd);
+    double hw = 0.5 * cam->image_width_px, hh = 0.5 * cam->image_height_px;
+    static const double cu[4] = {-1.0, 1.0, 1.0, -1.0}, cv[4] = {1.0, 1.0, -1.0, -1.0};
+    out->zoom = zoom;
+    for (int i = 0; i < 4; i++) {
+        /* Body frame (forward = image top, right = image right) to east / south */
+        double right = cu[i] * hw * tiles_per_px, fwd = cv[i] * hh * tiles_per_px;
+        out->x[i] = cx + fwd * sh + right * ch;
+        out->y[i] = cy - (fwd * ch - right * sh);
+    }
+    return check_quad(out);
+}
+
+/* Shoelace about the first vertex; global tile coordinates are up to 2^zoom */
+static double poly_area(const pt_t *p, int n) {
+    double a = 0.0;
+    for (int i = 2; i < n; i++)
+        a += (p[i - 1].x - p[0].x) * (p[i].y - p[0].y) - (p[i].x - p[0].x) * (p[i - 1].y - p[0].y);
+    return 0.5 * fabs(a);
+}
+
+double vps_footprint_area(const vps_footprint_t *fp) {
+    pt_t q[4];
+    for (int i = 0; i < 4; i++) q[i] = (pt_t){fp->x[i], fp->y[i]};
+    return poly_area(q, 4);
+}
+
+/* Sutherland-Hodgman against one axis-aligned half-plane: sgn * (coord - c) >= 0 */
+static int clip_half(const pt_t *in, int n, bool on_y, double c, double sgn, pt_t *out) {
+    int m = 0;
+    for (int i = 0, j = n - 1; i < n; j = i++) {
+        double dj = sgn * ((on_y ? in[j].y : in[j].x) - c);
+        double di = sgn * ((on_y ? in[i].y : in[i].x) - c);
+        if ((dj >= 0.0) != (di >= 0.0)) {
+            double s = dj / (dj - di);
+            out[m++] = (pt_t){in[j].x + s * (in[i].x - in[j].x), in[j].y + s * (in[i].y - in[j].y)};
+        }
+        if (di >= 0.0) out[m++] = in[i];
+    }
+    return m;
+}
+
+/* Clip to lo <= coord <= hi */
+static int clip_slab(const pt_t *in, int n, bool on_y, double lo, double hi, pt_t *out) {
+    pt_t tmp[MAX_VERTS];
+    n = clip_half(in, n, on_y, lo, 1.0, tmp);
+    return n < 3 ? 0 : clip_half(tmp, n, on_y, hi, -1.0, out);
+}
+
+/* Insert keeping out sorted by overlap, largest first, at most max_out */
+static int insert(vps_tile_cover_t *out, int count, int max_out, vps_tile_cover_t c) {
+    int pos = count;
+    while (pos > 0 && out[pos - 1].overlap < c.overlap) pos--;
+    if (pos >= max_out) return count;
+    if (count == max_out) count--;
+    for (int i = count; i > pos; i--) out[i] = out[i - 1];
+    out[pos] = c;
+    return count + 1;
+}
+
+int vps_footprint_tiles(const vps_footprint_t *fp, vps_tile_cover_t *out, int max_out) {
+    int n = 1 << fp->zoom, count = 0;
+    pt_t quad[4], row[MAX_VERTS], cell[MAX_VERTS];
+    double y0 = fp->y[0], y1 = fp->y[0];
+    for (int i = 0; i < 4; i++) {
+        quad[i] = (pt_t){fp->x[i], fp->y[i]};
+        y0 = fmin(y0, fp->y[i]);
+        y1 = fmax(y1, fp->y[i]);
+    }
+    int r0 = (int)fmax(floor(y0), 0.0), r1 = (int)fmin(floor(y1), n - 1.0);
+    for (int r = r0; r <= r1 && max_out > 0; r++) {
+        int nr = clip_slab(quad, 4, true, r, r + 1.0, row);
+        if (nr < 3) continue;
+        double x0 = row[0].x, x1 = row[0].x;
+        for (int i = 1; i < nr; i++) {
+            x0 = fmin(x0, row[i].x);
+            x1 = fmax(x1, row[i].x);
+        }
+        for (int c = (int)floor(x0); c <= (int)floor(x1); c++) {
+            int nc = clip_slab(row, nr, false, c, c + 1.0, cell);
+            double a = nc < 3 ? 0.0 : poly_area(cell, nc);
+            if (a <= MIN_OVERLAP) continue;
+            vps_tile_cover_t tc = {{fp->zoom, ((c % n) + n) % n, r}, fmin(a, 1.0)};
+            count = insert(out, count, max_out, tc);
+        }
+    }
+    return count;
+}
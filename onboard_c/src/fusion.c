@@ -3,12 +3,17 @@
  * @brief Position fusion engine.
  */
 #include "fusion.h"
+#include "ekf_bank.h"
+#include "msp.h"
 #include <math.h>
+#include <stddef.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+#define MPS_TO_KNOTS 1.94384
+
 void vps_fusion_init(vps_fusion_t *f, const vps_ekf_config_t *ekf_cfg,
                      double max_dr_s, vps_geofence_t *fence) {
     if (ekf_cfg)
@@ -17,13 +22,107 @@ void vps_fusion_init(vps_fusion_t *f, const vps_ekf_config_t *ekf_cfg,
         f->ekf_cfg = vps_ekf_default_config();
 
     vps_ekf_init(&f->ekf);
+    vps_ekf_history_init(&f->hist, VPS_EKF_HISTORY_DEFAULT);
     vps_dr_init(&f->dr, max_dr_s, 2.0);
     f->fence = fence;
+    f->imu = NULL;
+    vps_ekf32_init(&f->ekf32, 0.0);
+    f->use_ekf32 = false;
+    vps_imm_init(&f->imm, NULL);
+    f->use_imm = false;
+    f->sink = NULL;
+    f->zones = NULL;
+    f->frame = NULL;
 }
 
-vps_fusion_output_t vps_fusion_update(vps_fusion_t *f,
-                                      const vps_geopoint_t *visual,
-                                      double hdop, double t) {
+void vps_fusion_use_ekf32(vps_fusion_t *f, bool on) {
+    if (on && !f->use_ekf32) vps_ekf32_from_state(&f->ekf32, &f->ekf);
+    if (!on && f->use_ekf32) vps_ekf_history_clear(&f->hist);
+    f->use_ekf32 = on;
+}
+
+void vps_fusion_use_imm(vps_fusion_t *f, bool on) {
+    if (on && !f->use_imm) vps_imm_from_state(&f->imm, &f->ekf);
+    if (!on && f->use_imm) {
+        vps_ekf_history_clear(&f->hist);
+        if (f->use_ekf32) vps_ekf32_from_state(&f->ekf32, &f->ekf);
+    }
+    f->use_imm = on;
+}
+
+bool vps_fusion_odometry(vps_fusion_t *f, double dn_m, double de_m,
+                         double hdop_add, double t) {
+    return vps_dr_apply_odometry(&f->dr, dn_m, de_m, hdop_add, t);
+}
+
+void vps_fusion_set_sink(vps_fusion_t *f, vps_fusion_sink_t *sink) {
+    f->sink = sink;
+}
+
+void vps_fusion_set_zones(vps_fusion_t *f, const vps_fence_set_t *zones) {
+    f->zones = zones;
+}
+
+void vps_fusion_set_frame(vps_fusion_t *f, const vps_local_frame_t *frame) {
+    f->frame = frame;
+    vps_dr_set_frame(&f->dr, frame);
+}
+
+bool vps_fusion_time_to_breach(const vps_fusion_t *f, double t, double horizon_s,
+                               double radius_km, double *t_out) {
+    *t_out = INFINITY;
+    if (!f->ekf.initialized) return false;
+    vps_geopoint_t p = vps_ekf_predict(&f->ekf, t);
+    /* m/s on the fences' 6371 km sphere, so the track matches the EKF's degrees */
+    double m_lat = 6371000.0 * M_PI / 180.0;
+    double vn = f->ekf.x[2] * m_lat;
+    double ve = f->ekf.x[3] * (f->frame ? vps_local_frame_m_per_deg_lon(f->frame, p.lat)
+                                        : m_lat * cos(p.lat * M_PI / 180.0));
+    double tb;
+    if (f->fence && vps_geofence_time_to_breach(f->fence, p, vn, ve, radius_km, horizon_s, &tb))
+        *t_out = tb;
+    if (f->zones && vps_fence_set_time_to_breach(f->zones, p, vn, ve, radius_km,
+                                                 fmin(horizon_s, *t_out), &tb, NULL))
+        *t_out = fmin(*t_out, tb);
+    return *t_out <= horizon_s;
+}
+
+/* Encode an output into the sink's ring: NMEA GGA + RMC, then MSP */
+static void sink_emit(vps_fusion_sink_t *s, const vps_fusion_output_t *o) {
+    size_t need = (s->protocols & VPS_SINK_NMEA ? 2 * VPS_NMEA_SENTENCE_MAX : 0) +
+                  (s->protocols & VPS_SINK_MSP ? MSP_GPS_FRAME_SIZE : 0);
+    uint8_t *p = vps_out_ring_reserve(s->ring, need);
+    if (!p) {
+        s->dropped++;
+        return;
+    }
+    size_t n = 0;
+    if (s->protocols & VPS_SINK_NMEA) {
+        vps_nmea_time_set(&s->utc, time(NULL));
+        n += vps_nmea_write_gga((char *)p, &s->utc, o->position, o->has_position ? 1 : 0,
+                                o->hdop, 0.0);
+        n += vps_nmea_write_rmc((char *)p + n, &s->utc, o->position, o->has_position,
+                                o->speed_mps * MPS_TO_KNOTS, o->heading_deg);
+    }
+    if (s->protocols & VPS_SINK_MSP)
+        n += (size_t)vps_msp_encode_position(p + n, o->position, o->speed_mps,
+                                             o->heading_deg, o->hdop, o->has_position);
+    vps_out_ring_commit(s->ring, n);
+    s->emitted++;
+}
+
+void vps_fusion_attach_imu(vps_fusion_t *f, vps_imu_nav_t *imu) {
+    f->imu = imu;
+    if (imu && f->ekf.initialized) vps_imu_nav_anchor(imu, &f->ekf, 3.0);
+}
+
+/**
+ * vps_fusion_update with the EKF configuration for this fix. Without
+ * motion, speed and heading are left at 0 (batch runs that skip them).
+ */
+static vps_fusion_output_t update_with(vps_fusion_t *f, const vps_ekf_config_t *cfg,
+                                       const vps_geopoint_t *visual,
+                                       double hdop, double t, bool motion) {
     vps_fusion_output_t out;
     out.has_position = false;
     out.position = (vps_geopoint_t){0, 0};
@@ -34,10 +133,22 @@ vps_fusion_output_t vps_fusion_update(vps_fusion_t *f,
     out.source = VPS_SOURCE_NONE;
     out.geofence_ok = true;
     out.ekf_accepted = false;
+    for (int j = 0; j < VPS_IMM_MODELS; j++) out.model_prob[j] = 0.0;
+    vps_velocity_t imu_vel;
+    bool from_imu = false;
 
     if (visual) {
         /* Case 1: Visual fix */
-        out.ekf_accepted = vps_ekf_update(&f->ekf, &f->ekf_cfg, *visual, hdop, t);
+        if (f->use_imm) {
+            out.ekf_accepted = vps_imm_update(&f->imm, cfg, *visual, hdop, t);
+            vps_imm_to_state(&f->imm, &f->ekf);
+        } else if (f->use_ekf32) {
+            out.ekf_accepted = vps_ekf32_update(&f->ekf32, cfg, *visual, hdop, t);
+            vps_ekf32_to_state(&f->ekf32, &f->ekf);
+        } else {
+            out.ekf_accepted = vps_ekf_update_delayed(&f->ekf, &f->hist, cfg,
+                                                      *visual, hdop, t, t);
+        }
         if (f->ekf.initialized) {
             out.position = vps_ekf_position(&f->ekf);
             out.hdop = hdop;
@@ -48,11 +159,21 @@ vps_fusion_output_t vps_fusion_update(vps_fusion_t *f,
             /* Update dead reckoning reference */
             vps_velocity_t vel = vps_ekf_velocity(&f->ekf);
             vps_dr_update_ref(&f->dr, out.position, vel.vn, vel.ve, hdop, t);
+            if (f->imu && out.ekf_accepted) vps_imu_nav_anchor(f->imu, &f->ekf, hdop);
         }
     } else if (f->ekf.initialized) {
-        /* Case 2: EKF prediction */
+        /* Case 2: EKF prediction, IMU-propagated when available */
         vps_geopoint_t pred = vps_ekf_predict(&f->ekf, t);
-        if (pred.lat != 0.0 || pred.lon != 0.0) {
+        double imu_hdop;
+        if (f->imu && vps_imu_nav_position(f->imu, t, &out.position, &imu_vel, &imu_hdop)) {
+            out.hdop = imu_hdop;
+            out.source = VPS_SOURCE_EKF_PREDICT;
+            out.fix_quality = VPS_FIX_EKF;
+            out.has_position = true;
+            from_imu = true;
+        } else if (f->dr.odometry && t - f->dr.ref_t <= f->dr.max_extrap_s) {
+            /* Measured motion beats constant velocity: case 3 below */
+        } else if (pred.lat != 0.0 || pred.lon != 0.0) {
             out.position = pred;
             out.hdop = 3.0;
             out.source = VPS_SOURCE_EKF_PREDICT;
@@ -75,8 +196,12 @@ vps_fusion_output_t vps_fusion_update(vps_fusion_t *f,
     }
 
     /* Geofence check */
-    if (out.has_position && f->fence) {
-        out.geofence_ok = vps_geofence_contains(f->fence, out.position);
+    if (out.has_position && (f->fence || f->zones)) {
+        bool in_fence = !f->fence ||
+            (f->frame ? vps_geofence_contains_local(f->fence, f->frame, out.position)
+                      : vps_geofence_contains(f->fence, out.position));
+        out.geofence_ok = in_fence &&
+                          (!f->zones || vps_fence_set_contains(f->zones, out.position));
         if (!out.geofence_ok) {
             out.has_position = false;
             out.fix_quality = VPS_FIX_NONE;
@@ -84,8 +209,24 @@ vps_fusion_output_t vps_fusion_update(vps_fusion_t *f,
         }
     }
 
+    if (f->use_imm && f->imm.initialized)
+        for (int j = 0; j < VPS_IMM_MODELS; j++) out.model_prob[j] = f->imm.mu[j];
+
     /* Speed and heading */
-    if (f->ekf.initialized) {
+    if (!motion) {
+        /* not requested */
+    } else if (from_imu) {
+        out.speed_mps = sqrt(imu_vel.vn * imu_vel.vn + imu_vel.ve * imu_vel.ve);
+        if (out.speed_mps > 0.5)
+            out.heading_deg = f->frame ? vps_heading_deg(imu_vel.vn, imu_vel.ve)
+                : fmod(atan2(imu_vel.ve, imu_vel.vn) * 180.0 / M_PI + 360.0, 360.0);
+    } else if (f->ekf.initialized && f->frame) {
+        out.speed_mps = vps_ekf_speed_local(&f->ekf, f->frame);
+        if (out.speed_mps > 0.5)
+            out.heading_deg = vps_heading_deg(
+                f->ekf.x[2] * f->frame->m_per_deg_lat,
+                f->ekf.x[3] * vps_local_frame_m_per_deg_lon(f->frame, f->ekf.x[0]));
+    } else if (f->ekf.initialized) {
         out.speed_mps = vps_ekf_speed(&f->ekf);
         if (out.speed_mps > 0.5) {
             vps_velocity_t vel = vps_ekf_velocity(&f->ekf);
@@ -98,7 +239,146 @@ vps_fusion_output_t vps_fusion_update(vps_fusion_t *f,
     return out;
 }
 
+vps_fusion_output_t vps_fusion_update(vps_fusion_t *f,
+                                      const vps_geopoint_t *visual,
+                                      double hdop, double t) {
+    vps_fusion_output_t out = update_with(f, &f->ekf_cfg, visual, hdop, t, true);
+    if (f->sink) sink_emit(f->sink, &out);
+    return out;
+}
+
+vps_fusion_output_t vps_fusion_update_batch(vps_fusion_t *f,
+                                            const vps_geopoint_t *fixes,
+                                            const double *hdop, int n, double t) {
+    if (n <= 1) return vps_fusion_update(f, n == 1 ? fixes : NULL, n == 1 ? hdop[0] : 0.0, t);
+
+    vps_geopoint_t z;
+    double z_hdop;
+    if (vps_ekf_combine_batch(&f->ekf, &f->ekf_cfg, fixes, hdop, n, t, NULL, &z, &z_hdop) == 0)
+        return vps_fusion_update(f, &fixes[0], hdop[0], t);  /* gated out, as a single fix */
+
+    /* The fixes were gated individually; the combined one always applies */
+    vps_ekf_config_t cfg = f->ekf_cfg;
+    cfg.gate_threshold = INFINITY;
+    vps_fusion_output_t out = update_with(f, &cfg, &z, z_hdop, t, true);
+    if (f->sink) sink_emit(f->sink, &out);
+    return out;
+}
+
+vps_fusion_output_t vps_fusion_update_delayed(vps_fusion_t *f,
+                                              const vps_geopoint_t *visual,
+                                              double hdop, double t_capture,
+                                              double t_arrival) {
+    if (!visual || t_capture >= t_arrival || f->use_ekf32 || f->use_imm)
+        return vps_fusion_update(f, visual, hdop, t_arrival);
+
+    bool accepted = vps_ekf_update_delayed(&f->ekf, &f->hist, &f->ekf_cfg,
+                                           *visual, hdop, t_capture, t_arrival);
+    if (accepted) {
+        vps_velocity_t vel = vps_ekf_velocity(&f->ekf);
+        vps_dr_update_ref(&f->dr, vps_ekf_predict(&f->ekf, t_arrival),
+                          vel.vn, vel.ve, hdop, t_arrival);
+        if (f->imu) vps_imu_nav_anchor(f->imu, &f->ekf, hdop);
+    }
+
+    /* Report the filter propagated to arrival time */
+    vps_fusion_output_t out = update_with(f, &f->ekf_cfg, NULL, hdop, t_arrival, true);
+    if (accepted && out.has_position && out.source == VPS_SOURCE_EKF_PREDICT) {
+        out.source = VPS_SOURCE_VISUAL;
+        out.fix_quality = VPS_FIX_VISUAL;
+        out.hdop = hdop;
+    }
+    out.ekf_accepted = accepted;
+    if (f->sink) sink_emit(f->sink, &out);
+    return out;
+}
+
+int vps_fusion_select(const vps_fusion_t *f, const vps_geopoint_t *fixes,
+                      const double *hdop, int n, double t, double *d_out) {
+    if (n > VPS_EKF_BANK_MAX) n = VPS_EKF_BANK_MAX;
+    if (n <= 0) return -1;
+    if (!f->ekf.initialized) return 0;
+
+    double dt = t - f->ekf.last_t;
+    if (dt < 0) dt = 0;  /* delayed frame: score against the current state */
+    if (dt > f->ekf_cfg.max_gap_s) return 0;  /* the filter will reset */
+
+    vps_ekf_bank_t bank;
+    vps_ekf_bank_broadcast(&bank, &f->ekf, n);
+    vps_ekf_bank_propagate(&bank, f->ekf_cfg.process_noise, dt);
+
+    double lat[VPS_EKF_BANK_MAX], lon[VPS_EKF_BANK_MAX], r[VPS_EKF_BANK_MAX];
+    double d[VPS_EKF_BANK_MAX];
+    for (int i = 0; i < n; i++) {
+        lat[i] = fixes[i].lat;
+        lon[i] = fixes[i].lon;
+        r[i] = f->ekf_cfg.measurement_noise * hdop[i] * hdop[i];
+    }
+    vps_ekf_bank_correct(&bank, lat, lon, r, f->ekf_cfg.gate_threshold, d);
+    if (d_out)
+        for (int i = 0; i < n; i++) d_out[i] = d[i];
+    return vps_ekf_bank_best(d, n, f->ekf_cfg.gate_threshold);
+}
+
 void vps_fusion_reset(vps_fusion_t *f) {
     vps_ekf_reset(&f->ekf);
+    vps_ekf_history_clear(&f->hist);
+    vps_ekf32_init(&f->ekf32, f->ekf32.reanchor_m);
+    vps_imm_reset(&f->imm);
+    if (f->imu) f->imu->valid = false;
     vps_dr_init(&f->dr, f->dr.max_extrap_s, f->dr.hdop_growth_rate);
+    vps_dr_set_frame(&f->dr, f->frame);
+}
+
+void vps_fusion_run_batch(vps_fusion_t *f, const vps_fusion_frames_t *in,
+                          vps_fusion_track_t *out, vps_fusion_batch_stats_t *stats) {
+    vps_fusion_batch_stats_t st = {0};
+    bool motion = out && (out->speed_mps || out->heading_deg);
+    double m_lon = 0.0;
+    if (in->truth_lat && in->n > 0) m_lon = 111320.0 * cos(in->truth_lat[0] * M_PI / 180.0);
+
+    for (size_t i = 0; i < in->n; i++) {
+        bool has_fix = !in->fix || in->fix[i];
+        vps_geopoint_t z = {0.0, 0.0};
+        if (has_fix) z = (vps_geopoint_t){in->lat[i], in->lon[i]};
+        vps_fusion_output_t o = update_with(f, &f->ekf_cfg, has_fix ? &z : NULL,
+                                            in->hdop[i], in->t[i], motion);
+
+        st.fixes += has_fix;
+        st.accepted += o.ekf_accepted;
+        st.positioned += o.has_position;
+        st.fence_blocked += !o.geofence_ok;
+        if (o.has_position && in->truth_lat) {
+            double dn = (o.position.lat - in->truth_lat[i]) * 111320.0;
+            double de = (o.position.lon - in->truth_lon[i]) * m_lon;
+            double e2 = dn * dn + de * de;
+            st.err_sum_sq_m2 += e2;
+            if (e2 > st.err_max_m) st.err_max_m = e2;  /* squared until the end */
+            st.err_n++;
+        }
+        if (!out) continue;
+        if (out->lat) out->lat[i] = o.position.lat;
+        if (out->lon) out->lon[i] = o.position.lon;
+        if (out->hdop) out->hdop[i] = o.hdop;
+        if (out->speed_mps) out->speed_mps[i] = o.speed_mps;
+        if (out->heading_deg) out->heading_deg[i] = o.heading_deg;
+        if (out->fix_quality) out->fix_quality[i] = (uint8_t)o.fix_quality;
+        if (out->source) out->source[i] = (uint8_t)o.source;
+        if (out->flags)
+            out->flags[i] = (uint8_t)((o.geofence_ok ? VPS_FUSION_FLAG_GEOFENCE_OK : 0) |
+                                      (o.ekf_accepted ? VPS_FUSION_FLAG_EKF_ACCEPTED : 0) |
+                                      (o.has_position ? VPS_FUSION_FLAG_POSITION : 0));
+    }
+    st.frames = in->n;
+    st.err_max_m = sqrt(st.err_max_m);
+
+    if (!stats) return;
+    stats->frames += st.frames;
+    stats->fixes += st.fixes;
+    stats->accepted += st.accepted;
+    stats->positioned += st.positioned;
+    stats->fence_blocked += st.fence_blocked;
+    stats->err_n += st.err_n;
+    stats->err_sum_sq_m2 += st.err_sum_sq_m2;
+    if (st.err_max_m > stats->err_max_m) stats->err_max_m = st.err_max_m;
 }
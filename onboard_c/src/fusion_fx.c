@@ -0,0 +1,516 @@
+/**
+ * @file fusion_fx.c
+ * @brief Fixed-point fusion core (integer only, no libm).
+ */
+#include "fusion_fx.h"
+#include "msp.h"
+#include <string.h>
+
+#define Q30 ((int64_t)1 << 30)
+
+/* Metres per 1e-7 degree (Q0.32): EKF frame (111320 m/deg, as ekf32) and
+ * geofence (6371 km sphere, as vps_haversine_km) */
+#define K_LAT 47811576u
+#define K_FENCE 47757857u
+
+/* pi / 180e7 in Q2.62: degrees * 1e7 to radians */
+#define K_RAD 8048910509ll
+
+/* Covariance formats: position terms Q24.8, position-velocity Q20.12,
+ * velocity Q16.16, i.e. velocity carries VEL_BITS more fraction bits.
+ * Gains are Q8.24 on position rows and Q4.28 on velocity rows. */
+#define VEL_BITS 4
+
+/* First-fix prior: 1e-6 deg² at 111320 m/deg */
+#define P0_POS 3172388          /* Q24.8 */
+#define P0_VEL 812131444        /* Q16.16 */
+
+#define DEG7_90 900000000ll
+#define DEG7_360 3600000000ll
+
+enum { P00, P01, P02, P03, P11, P12, P13, P22, P23, P33 };
+
+/* --- Integer helpers --- */
+
+static int64_t rsh(int64_t v, int s) {
+    return (v + ((int64_t)1 << (s - 1))) >> s;
+}
+
+static int32_t sat32(int64_t v) {
+    return v > INT32_MAX ? INT32_MAX : v < -INT32_MAX ? -INT32_MAX : (int32_t)v;
+}
+
+static int64_t div_round(int64_t n, int64_t d) {
+    return n >= 0 ? (n + d / 2) / d : -((-n + d / 2) / d);
+}
+
+/* num / den in Q(frac), den > 0, saturating at ±2^62 */
+static int64_t div_q(int64_t num, int64_t den, int frac) {
+    while (den >= ((int64_t)1 << 31)) {
+        num /= 2;
+        den /= 2;
+    }
+    int64_t q = num / den, r = num % den;
+    int64_t lim = (int64_t)1 << (62 - frac);
+    if (q >= lim) return (int64_t)1 << 62;
+    if (q <= -lim) return -((int64_t)1 << 62);
+    return q * ((int64_t)1 << frac) + r * ((int64_t)1 << frac) / den;
+}
+
+static int64_t clamp64(int64_t v, int64_t lim) {
+    return v > lim ? lim : v < -lim ? -lim : v;
+}
+
+/* Degrees * 1e7 <-> metres (Q16.16) with k metres per unit (Q0.32) */
+static int64_t m_from_units(int64_t d7, uint32_t k) {
+    return rsh(d7 * (int64_t)k, 16);
+}
+
+static int32_t units_from_m(int64_t m, uint32_t k) {
+    return sat32(div_round(m * 65536, (int64_t)k));
+}
+
+/* --- Trig --- */
+
+/* Taylor series in Horner form on [0, 45 deg], Q2.30 */
+static int64_t cos_poly(int64_t deg7) {
+    int64_t x = rsh(deg7 * K_RAD, 32), x2 = rsh(x * x, 30);
+    int64_t r = Q30;
+    r = Q30 - rsh(x2 * r, 30) / 90;
+    r = Q30 - rsh(x2 * r, 30) / 56;
+    r = Q30 - rsh(x2 * r, 30) / 30;
+    r = Q30 - rsh(x2 * r, 30) / 12;
+    return Q30 - rsh(x2 * r, 30) / 2;
+}
+
+static int64_t sin_poly(int64_t deg7) {
+    int64_t x = rsh(deg7 * K_RAD, 32), x2 = rsh(x * x, 30);
+    int64_t r = Q30;
+    r = Q30 - rsh(x2 * r, 30) / 110;
+    r = Q30 - rsh(x2 * r, 30) / 72;
+    r = Q30 - rsh(x2 * r, 30) / 42;
+    r = Q30 - rsh(x2 * r, 30) / 20;
+    r = Q30 - rsh(x2 * r, 30) / 6;
+    return rsh(x * r, 30);
+}
+
+int32_t vps_fx_cos_deg7(int32_t deg7) {
+    int64_t a = deg7 < 0 ? -(int64_t)deg7 : deg7;
+    a %= DEG7_360;
+    if (a > 2 * DEG7_90) a = DEG7_360 - a;
+    bool neg = a > DEG7_90;
+    if (neg) a = 2 * DEG7_90 - a;
+    int64_t c = 2 * a > DEG7_90 ? sin_poly(DEG7_90 - a) : cos_poly(a);
+    return (int32_t)(neg ? -c : c);
+}
+
+/* atan(2^-i) in degrees, Q8.24 */
+static const int32_t cordic_atan[28] = {
+    754974720, 445687602, 235489088, 119537938, 60000934, 30029717, 15018523,
+    7509720, 3754917, 1877466, 938734, 469367, 234684, 117342, 58671, 29335,
+    14668, 7334, 3667, 1833, 917, 458, 229, 115, 57, 29, 14, 7,
+};
+
+int32_t vps_fx_atan2_deg(int32_t y, int32_t x) {
+    if (x == 0 && y == 0) return 0;
+    int64_t xx = x, yy = y, ang = 0;
+    if (xx < 0) {   /* rotate into the right half-plane */
+        int64_t t = xx;
+        if (yy >= 0) {
+            xx = yy;
+            yy = -t;
+            ang = 90ll << 24;
+        } else {
+            xx = -yy;
+            yy = t;
+            ang = -(90ll << 24);
+        }
+    }
+    xx *= (int64_t)1 << 24;
+    yy *= (int64_t)1 << 24;
+    for (int i = 0; i < 28; i++) {
+        int64_t dx = yy >> i, dy = xx >> i;
+        if (yy > 0) {
+            xx += dx;
+            yy -= dy;
+            ang += cordic_atan[i];
+        } else {
+            xx -= dx;
+            yy += dy;
+            ang -= cordic_atan[i];
+        }
+    }
+    int32_t deg = (int32_t)rsh(ang, 8);
+    return deg <= -(180 << 16) ? deg + (360 << 16) : deg;
+}
+
+uint32_t vps_fx_isqrt64(uint64_t v) {
+    uint64_t r = 0, bit = (uint64_t)1 << 62;
+    while (bit > v) bit >>= 2;
+    for (; bit; bit >>= 2) {   /* branch-free: the compare is a coin flip */
+        uint64_t t = r + bit, take = 0 - (uint64_t)(v >= t);
+        v -= t & take;
+        r = (r >> 1) + (bit & take);
+    }
+    return (uint32_t)r;
+}
+
+/* East metres per unit at a latitude (Q0.32) */
+static uint32_t k_east(uint32_t k, int32_t lat) {
+    return (uint32_t)rsh((int64_t)k * vps_fx_cos_deg7(lat), 30);
+}
+
+vps_fx_config_t vps_fx_default_config(void) {
+    vps_fx_config_t c;
+    c.q = 81213;                /* 1e-10 deg²/s³ */
+    c.r = 31724;                /* 1e-8 deg² */
+    c.gate = 5 * VPS_FX_ONE;
+    c.max_gap_ms = 30000;
+    c.reanchor_m = 1000;
+    c.max_dr_ms = 10000;
+    c.dr_hdop_rate = 200;
+    return c;
+}
+
+/* --- EKF kernels (closed form, as vps_ekf32_propagate/correct) --- */
+
+void vps_fx_ekf_propagate(int32_t x[4], int32_t p[VPS_FX_PACKED],
+                          int32_t qn, int32_t qe, int32_t dt) {
+    int64_t dt2 = rsh((int64_t)dt * dt, 16);
+    int64_t d3 = rsh(dt2 * dt, 17), d4 = rsh(dt2 * dt2, 18);
+
+    x[0] = sat32(x[0] + rsh((int64_t)x[2] * dt, 16));
+    x[1] = sat32(x[1] + rsh((int64_t)x[3] * dt, 16));
+
+    int64_t p02 = p[P02], p13 = p[P13], p22 = p[P22], p23 = p[P23], p33 = p[P33];
+    p[P00] = sat32(p[P00] + rsh(dt * (2 * p02 + rsh(dt * p22, 20)), 20) + rsh(qn * d4, 24));
+    p[P11] = sat32(p[P11] + rsh(dt * (2 * p13 + rsh(dt * p33, 20)), 20) + rsh(qe * d4, 24));
+    p[P01] = sat32(p[P01] + rsh(dt * ((int64_t)p[P03] + p[P12] + rsh(dt * p23, 20)), 20));
+    p[P02] = sat32(p02 + rsh(dt * p22, 20) + rsh(qn * d3, 20));
+    p[P03] = sat32(p[P03] + rsh(dt * p23, 20));
+    p[P12] = sat32(p[P12] + rsh(dt * p23, 20));
+    p[P13] = sat32(p13 + rsh(dt * p33, 20) + rsh(qe * d3, 20));
+    p[P22] = sat32(p22 + rsh(qn * dt2, 16));
+    p[P33] = sat32(p33 + rsh(qe * dt2, 16));
+}
+
+int32_t vps_fx_ekf_correct(int32_t x[4], int32_t p[VPS_FX_PACKED], int32_t zn,
+                           int32_t ze, int32_t rn, int32_t re, int32_t gate) {
+    int64_t y0 = clamp64((int64_t)zn - x[0], INT32_MAX);
+    int64_t y1 = clamp64((int64_t)ze - x[1], INT32_MAX);
+    int64_t c0[4] = {p[P00], p[P01], p[P02], p[P03]};
+    int64_t c1[4] = {p[P01], p[P11], p[P12], p[P13]};
+    int64_t s00 = sat32(c0[0] + rn), s01 = c0[1], s11 = sat32(c1[1] + re);
+
+    /* Gains and S⁻¹y are ratios: scale S and C down together so every
+     * product stays within 62 bits */
+    int64_t m = s00 > s11 ? s00 : s11;
+    for (int i = 0; i < 4; i++) {
+        if (c0[i] > m || -c0[i] > m) m = c0[i] < 0 ? -c0[i] : c0[i];
+        if (c1[i] > m || -c1[i] > m) m = c1[i] < 0 ? -c1[i] : c1[i];
+    }
+    int sh = 0;
+    while ((m >> sh) >= Q30) sh++;
+    int64_t a00 = s00 >> sh, a01 = s01 >> sh, a11 = s11 >> sh;
+    int64_t det = a00 * a11 - a01 * a01;
+    if (det <= 0) return -1;
+
+    /* d² = y'S⁻¹y with y in Q.8 and S⁻¹y in Q.24 (1/m) */
+    int64_t v0 = clamp64(rsh(y0, 8), (int64_t)1 << 30);
+    int64_t v1 = clamp64(rsh(y1, 8), (int64_t)1 << 30);
+    int64_t w0 = clamp64(div_q(v0 * a11 - v1 * a01, det, 24), (int64_t)1 << 30);
+    int64_t w1 = clamp64(div_q(v1 * a00 - v0 * a01, det, 24), (int64_t)1 << 30);
+    int64_t d2 = (v0 * w0 + v1 * w1) >> sh;
+    if (d2 < 0) d2 = 0;
+    int64_t d = vps_fx_isqrt64((uint64_t)d2);
+    if (d * d < d2) d++;
+    if (d > (int64_t)gate) return sat32(d);
+
+    int64_t k0[4], k1[4];
+    for (int i = 0; i < 4; i++) {
+        int64_t b0 = c0[i] >> sh, b1 = c1[i] >> sh;
+        k0[i] = clamp64(div_q(b0 * a11 - b1 * a01, det, 24), Q30);
+        k1[i] = clamp64(div_q(b1 * a00 - b0 * a01, det, 24), Q30);
+        x[i] = sat32(x[i] + rsh(k0[i] * y0 + k1[i] * y1, i < 2 ? 24 : 24 + VEL_BITS));
+    }
+
+#define UPD(idx, a, c) p[idx] = sat32(p[idx] - rsh(k0[a] * c0[c] + k1[a] * c1[c], 24))
+    UPD(P00, 0, 0); UPD(P01, 0, 1); UPD(P02, 0, 2); UPD(P03, 0, 3);
+    UPD(P11, 1, 1); UPD(P12, 1, 2); UPD(P13, 1, 3);
+    UPD(P22, 2, 2); UPD(P23, 2, 3);
+    UPD(P33, 3, 3);
+#undef UPD
+    return (int32_t)d;
+}
+
+/* --- Filter --- */
+
+void vps_fx_ekf_init(vps_fx_ekf_t *e) {
+    memset(e, 0, sizeof(*e));
+}
+
+static void set_origin(vps_fx_ekf_t *e, vps_fx_point_t o) {
+    int64_t c = vps_fx_cos_deg7(o.lat);
+    e->lat0 = o.lat;
+    e->lon0 = o.lon;
+    e->k_lon = (uint32_t)rsh((int64_t)K_LAT * c, 30);
+    e->cos2 = (int32_t)rsh(c * c, 30);
+}
+
+static void first_fix(vps_fx_ekf_t *e, vps_fx_point_t z, uint32_t t_ms) {
+    set_origin(e, z);
+    memset(e->x, 0, sizeof(e->x));
+    memset(e->p, 0, sizeof(e->p));
+    e->p[P00] = P0_POS;
+    e->p[P22] = P0_VEL;
+    e->p[P11] = (int32_t)rsh((int64_t)P0_POS * e->cos2, 30);
+    e->p[P33] = (int32_t)rsh((int64_t)P0_VEL * e->cos2, 30);
+    e->last_ms = t_ms;
+    e->initialized = true;
+    e->last_gate = 0;
+}
+
+/* Move the origin to the current position, keeping the sub-unit residual */
+static void reanchor(vps_fx_ekf_t *e) {
+    int32_t dlat = units_from_m(e->x[0], K_LAT), dlon = units_from_m(e->x[1], e->k_lon);
+    int64_t rn = e->x[0] - m_from_units(dlat, K_LAT);
+    int64_t re = e->x[1] - m_from_units(dlon, e->k_lon);
+    uint32_t k_old = e->k_lon;
+    set_origin(e, (vps_fx_point_t){e->lat0 + dlat, e->lon0 + dlon});
+
+    /* East scale changes with cos(lat0): rescale the e / ve rows and columns */
+    int64_t s = ((int64_t)e->k_lon << 30) / k_old, s2 = rsh(s * s, 30);
+    e->x[0] = (int32_t)rn;
+    e->x[1] = sat32(rsh(re * s, 30));
+    e->x[3] = sat32(rsh((int64_t)e->x[3] * s, 30));
+    static const int east1[] = {P01, P03, P12, P23}, east2[] = {P11, P13, P33};
+    for (int i = 0; i < 4; i++) e->p[east1[i]] = sat32(rsh((int64_t)e->p[east1[i]] * s, 30));
+    for (int i = 0; i < 3; i++) e->p[east2[i]] = sat32(rsh((int64_t)e->p[east2[i]] * s2, 30));
+    e->reanchors++;
+}
+
+bool vps_fx_ekf_update(vps_fx_ekf_t *e, const vps_fx_config_t *cfg,
+                       vps_fx_point_t z, uint16_t hdop, uint32_t t_ms) {
+    if (!e->initialized) {
+        first_fix(e, z, t_ms);
+        return true;
+    }
+
+    int32_t dt_ms = (int32_t)(t_ms - e->last_ms);
+    if (dt_ms < 0) return false;
+    if ((uint32_t)dt_ms > cfg->max_gap_ms) {
+        first_fix(e, z, t_ms);
+        return true;
+    }
+
+    int32_t dt = (int32_t)div_round((int64_t)dt_ms << 16, 1000);
+    int32_t qe = (int32_t)rsh((int64_t)cfg->q * e->cos2, 30);
+    int32_t rn = sat32(div_round((int64_t)cfg->r * hdop * hdop, 10000));
+    int32_t re = (int32_t)rsh((int64_t)rn * e->cos2, 30);
+
+    int32_t x[4], p[VPS_FX_PACKED];
+    memcpy(x, e->x, sizeof(x));
+    memcpy(p, e->p, sizeof(p));
+    vps_fx_ekf_propagate(x, p, cfg->q, qe, dt);
+
+    int32_t zn = sat32(m_from_units((int64_t)z.lat - e->lat0, K_LAT));
+    int32_t ze = sat32(m_from_units((int64_t)z.lon - e->lon0, e->k_lon));
+    int32_t d = vps_fx_ekf_correct(x, p, zn, ze, rn, re, cfg->gate);
+    if (d < 0) return false;
+
+    e->last_gate = d;
+    memcpy(e->x, x, sizeof(x));
+    memcpy(e->p, p, sizeof(p));
+    e->last_ms = t_ms;
+    int64_t r = (int64_t)cfg->reanchor_m << 16;
+    if ((int64_t)e->x[0] * e->x[0] + (int64_t)e->x[1] * e->x[1] > r * r) reanchor(e);
+    return d <= cfg->gate;
+}
+
+vps_fx_point_t vps_fx_ekf_predict(const vps_fx_ekf_t *e, uint32_t t_ms) {
+    vps_fx_point_t g = {0, 0};
+    if (!e->initialized) return g;
+    int64_t dt_ms = (int32_t)(t_ms - e->last_ms);
+    int64_t n = e->x[0] + div_round(e->x[2] * dt_ms, 1000);
+    int64_t east = e->x[1] + div_round(e->x[3] * dt_ms, 1000);
+    g.lat = e->lat0 + units_from_m(n, K_LAT);
+    g.lon = e->lon0 + units_from_m(east, e->k_lon);
+    return g;
+}
+
+int32_t vps_fx_ekf_speed(const vps_fx_ekf_t *e) {
+    if (!e->initialized) return 0;
+    uint64_t v2 = (uint64_t)((int64_t)e->x[2] * e->x[2]) + (uint64_t)((int64_t)e->x[3] * e->x[3]);
+    return (int32_t)vps_fx_isqrt64(v2);
+}
+
+/* --- Dead reckoning --- */
+
+void vps_fx_dr_update_ref(vps_fx_dr_t *dr, vps_fx_point_t pos, int32_t vn,
+                          int32_t ve, uint16_t hdop, uint32_t t_ms) {
+    dr->ref = pos;
+    dr->vn = vn;
+    dr->ve = ve;
+    dr->hdop = hdop;
+    dr->ref_ms = t_ms;
+    dr->has_reference = true;
+    dr->odometry = false;
+}
+
+static uint16_t hdop_grow(uint16_t hdop, int64_t add) {
+    int64_t h = hdop + add;
+    return (uint16_t)(h > 65535 ? 65535 : h);
+}
+
+bool vps_fx_dr_apply_odometry(vps_fx_dr_t *dr, int32_t dn_mm, int32_t de_mm,
+                              uint16_t hdop_add, uint32_t t_ms) {
+    int32_t dt_ms = (int32_t)(t_ms - dr->ref_ms);
+    if (!dr->has_reference || dt_ms <= 0) return false;
+
+    int64_t dn = div_round((int64_t)dn_mm * 65536, 1000);
+    int64_t de = div_round((int64_t)de_mm * 65536, 1000);
+    dr->ref.lat += units_from_m(dn, K_LAT);
+    dr->ref.lon += units_from_m(de, k_east(K_LAT, dr->ref.lat));
+    dr->vn = sat32(div_round(dn * 1000, dt_ms));
+    dr->ve = sat32(div_round(de * 1000, dt_ms));
+    dr->hdop = hdop_grow(dr->hdop, hdop_add);
+    dr->ref_ms = t_ms;
+    dr->odometry = true;
+    return true;
+}
+
+bool vps_fx_dr_extrapolate(const vps_fx_dr_t *dr, const vps_fx_config_t *cfg,
+                           uint32_t t_ms, vps_fx_point_t *pos, uint16_t *hdop) {
+    if (!dr->has_reference) return false;
+    int32_t dt_ms = (int32_t)(t_ms - dr->ref_ms);
+    if (dt_ms < 0 || (uint32_t)dt_ms > cfg->max_dr_ms) return false;
+
+    pos->lat = dr->ref.lat + units_from_m(div_round((int64_t)dr->vn * dt_ms, 1000), K_LAT);
+    pos->lon = dr->ref.lon + units_from_m(div_round((int64_t)dr->ve * dt_ms, 1000),
+                                          k_east(K_LAT, dr->ref.lat));
+    *hdop = hdop_grow(dr->hdop, div_round((int64_t)cfg->dr_hdop_rate * dt_ms, 1000));
+    return true;
+}
+
+/* --- Geofence --- */
+
+/* Offset of point from the fence centre in mm; east at cos(lat_ref) */
+static void fence_offset(const vps_fx_fence_t *fence, vps_fx_point_t point, int32_t lat_ref,
+                         int64_t *dn, int64_t *de) {
+    int64_t n = m_from_units((int64_t)point.lat - fence->center.lat, K_FENCE);
+    int64_t e = m_from_units((int64_t)point.lon - fence->center.lon, k_east(K_FENCE, lat_ref));
+    *dn = clamp64(rsh(n * 1000, 16), INT32_MAX);
+    *de = clamp64(rsh(e * 1000, 16), INT32_MAX);
+}
+
+static int64_t fence_distance(const vps_fx_fence_t *fence, vps_fx_point_t point) {
+    int64_t dn, de;
+    if (fence->type == VPS_FENCE_CIRCLE) {
+        /* Equirectangular at the mid latitude */
+        int32_t mid = (int32_t)(((int64_t)point.lat + fence->center.lat) / 2);
+        fence_offset(fence, point, mid, &dn, &de);
+        return (int64_t)fence->radius_mm - vps_fx_isqrt64((uint64_t)(dn * dn) + (uint64_t)(de * de));
+    }
+    /* Rect: east offsets along the centre's parallel, as the double version */
+    fence_offset(fence, point, fence->center.lat, &dn, &de);
+    int64_t mn = fence->half_n_mm - (dn < 0 ? -dn : dn);
+    int64_t me = fence->half_e_mm - (de < 0 ? -de : de);
+    return mn < me ? mn : me;
+}
+
+bool vps_fx_fence_contains(const vps_fx_fence_t *fence, vps_fx_point_t point) {
+    return fence_distance(fence, point) >= fence->margin_mm;
+}
+
+int32_t vps_fx_fence_distance_mm(const vps_fx_fence_t *fence, vps_fx_point_t point) {
+    return sat32(fence_distance(fence, point));
+}
+
+/* --- Fusion --- */
+
+void vps_fx_fusion_init(vps_fx_fusion_t *f, const vps_fx_config_t *cfg,
+                        const vps_fx_fence_t *fence) {
+    memset(f, 0, sizeof(*f));
+    f->cfg = cfg ? *cfg : vps_fx_default_config();
+    vps_fx_ekf_init(&f->ekf);
+    f->fence = fence;
+}
+
+vps_fx_output_t vps_fx_fusion_update(vps_fx_fusion_t *f, const vps_fx_point_t *visual,
+                                     uint16_t hdop, uint32_t t_ms) {
+    vps_fx_output_t out;
+    memset(&out, 0, sizeof(out));
+    out.hdop = 9900;
+    out.fix_quality = VPS_FIX_NONE;
+    out.source = VPS_SOURCE_NONE;
+    out.geofence_ok = true;
+
+    if (visual) {
+        /* Case 1: Visual fix */
+        out.ekf_accepted = vps_fx_ekf_update(&f->ekf, &f->cfg, *visual, hdop, t_ms);
+        if (f->ekf.initialized) {
+            out.position = vps_fx_ekf_predict(&f->ekf, f->ekf.last_ms);
+            out.hdop = hdop;
+            out.source = VPS_SOURCE_VISUAL;
+            out.fix_quality = VPS_FIX_VISUAL;
+            out.has_position = true;
+            vps_fx_dr_update_ref(&f->dr, out.position, f->ekf.x[2], f->ekf.x[3], hdop, t_ms);
+        }
+    } else if (f->ekf.initialized &&
+               !(f->dr.odometry && (uint32_t)(t_ms - f->dr.ref_ms) <= f->cfg.max_dr_ms)) {
+        /* Case 2: EKF prediction, unless odometry is fresher (case 3) */
+        out.position = vps_fx_ekf_predict(&f->ekf, t_ms);
+        out.hdop = 300;
+        out.source = VPS_SOURCE_EKF_PREDICT;
+        out.fix_quality = VPS_FIX_EKF;
+        out.has_position = true;
+    }
+
+    if (!out.has_position &&
+        vps_fx_dr_extrapolate(&f->dr, &f->cfg, t_ms, &out.position, &out.hdop)) {
+        /* Case 3: Dead reckoning */
+        out.source = VPS_SOURCE_DEAD_RECKONING;
+        out.fix_quality = VPS_FIX_DR;
+        out.has_position = true;
+    }
+
+    if (out.has_position && f->fence) {
+        out.geofence_ok = vps_fx_fence_contains(f->fence, out.position);
+        if (!out.geofence_ok) {
+            out.has_position = false;
+            out.fix_quality = VPS_FIX_NONE;
+            out.source = VPS_SOURCE_NONE;
+        }
+    }
+
+    /* Speed and heading (truncated like vps_msp_from_position) */
+    if (f->ekf.initialized) {
+        int64_t speed = vps_fx_ekf_speed(&f->ekf);
+        int64_t cms = (speed * 100) >> 16;
+        out.speed_cms = (uint16_t)(cms > 65535 ? 65535 : cms);
+        if (speed > VPS_FX_ONE / 2) {
+            int64_t h = vps_fx_atan2_deg(f->ekf.x[3], f->ekf.x[2]);
+            if (h < 0) h += 360 << 16;
+            out.heading_deg10 = (uint16_t)((h * 10) >> 16);
+        }
+    }
+    return out;
+}
+
+bool vps_fx_fusion_odometry(vps_fx_fusion_t *f, int32_t dn_mm, int32_t de_mm,
+                            uint16_t hdop_add, uint32_t t_ms) {
+    return vps_fx_dr_apply_odometry(&f->dr, dn_mm, de_mm, hdop_add, t_ms);
+}
+
+int vps_fx_encode_msp(uint8_t *out, const vps_fx_output_t *o) {
+    vps_msp_gps_t g;
+    g.fix_type = o->has_position ? 2 : 0;
+    g.num_sat = o->has_position ? 12 : 0;
+    g.lat = o->position.lat;
+    g.lon = o->position.lon;
+    g.altitude_m = 0;
+    g.speed_cms = o->speed_cms;
+    g.heading_deg10 = o->heading_deg10;
+    g.hdop = o->hdop;
+    return vps_msp_encode(out, &g);
+}
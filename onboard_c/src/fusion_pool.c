@@ -0,0 +1,124 @@
+/**
+ * @file fusion_pool.c
+ * @brief Work-stealing job pool for batch fusion.
+ */
+#include "fusion_pool.h"
+#include "spsc_queue.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct {
+    _Alignas(VPS_CACHE_LINE) _Atomic uint64_t range;  /* head | tail << 32 */
+} job_range_t;
+
+typedef struct {
+    vps_fusion_job_t *jobs;
+    job_range_t ranges[VPS_FUSION_POOL_MAX_THREADS];
+    int threads;
+    _Atomic uint64_t steals;
+} pool_t;
+
+typedef struct {
+    pool_t *pool;
+    int id;
+} worker_t;
+
+static uint64_t pack(uint32_t head, uint32_t tail) {
+    return (uint64_t)head | (uint64_t)tail << 32;
+}
+
+/* Owner: take the next job from the front of its own range */
+static bool pop(job_range_t *r, uint32_t *job) {
+    uint64_t cur = atomic_load_explicit(&r->range, memory_order_acquire);
+    for (;;) {
+        uint32_t head = (uint32_t)cur, tail = (uint32_t)(cur >> 32);
+        if (head >= tail) return false;
+        if (atomic_compare_exchange_weak_explicit(&r->range, &cur, pack(head + 1, tail),
+                                                  memory_order_acq_rel,
+                                                  memory_order_acquire)) {
+            *job = head;
+            return true;
+        }
+    }
+}
+
+/* Thief: move the back half of a victim's range into its own (empty) range */
+static bool steal(pool_t *p, int self) {
+    for (int k = 1; k < p->threads; k++) {
+        job_range_t *v = &p->ranges[(self + k) % p->threads];
+        uint64_t cur = atomic_load_explicit(&v->range, memory_order_acquire);
+        for (;;) {
+            uint32_t head = (uint32_t)cur, tail = (uint32_t)(cur >> 32);
+            if (head >= tail) break;
+            uint32_t take = (tail - head + 1) / 2;
+            if (atomic_compare_exchange_weak_explicit(&v->range, &cur, pack(head, tail - take),
+                                                      memory_order_acq_rel,
+                                                      memory_order_acquire)) {
+                atomic_store_explicit(&p->ranges[self].range, pack(tail - take, tail),
+                                      memory_order_release);
+                atomic_fetch_add_explicit(&p->steals, 1, memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void *worker_main(void *arg) {
+    worker_t *w = arg;
+    pool_t *p = w->pool;
+    uint32_t job;
+    do {
+        while (pop(&p->ranges[w->id], &job)) {
+            vps_fusion_job_t *j = &p->jobs[job];
+            memset(&j->stats, 0, sizeof(j->stats));
+            vps_fusion_run_batch(j->f, j->in, j->out, &j->stats);
+        }
+    } while (steal(p, w->id));
+    return NULL;
+}
+
+bool vps_fusion_run_jobs(vps_fusion_job_t *jobs, size_t n, int threads,
+                         vps_fusion_pool_stats_t *ps) {
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threads > VPS_FUSION_POOL_MAX_THREADS) threads = VPS_FUSION_POOL_MAX_THREADS;
+    if ((size_t)threads > n) threads = n > 0 ? (int)n : 1;
+    if (n > UINT32_MAX) n = UINT32_MAX;
+
+    pool_t pool;
+    memset(&pool, 0, sizeof(pool));
+    pool_t *p = &pool;
+    p->jobs = jobs;
+    p->threads = threads;
+    atomic_init(&p->steals, 0);
+    for (int i = 0; i < threads; i++) {
+        uint32_t head = (uint32_t)(n * (size_t)i / (size_t)threads);
+        uint32_t tail = (uint32_t)(n * (size_t)(i + 1) / (size_t)threads);
+        atomic_init(&p->ranges[i].range, pack(head, tail));
+    }
+
+    worker_t w[VPS_FUSION_POOL_MAX_THREADS];
+    pthread_t tid[VPS_FUSION_POOL_MAX_THREADS];
+    bool started[VPS_FUSION_POOL_MAX_THREADS] = {false};
+    int running = 1;
+    for (int i = 0; i < threads; i++) w[i] = (worker_t){p, i};
+    for (int i = 1; i < threads; i++) {
+        started[i] = pthread_create(&tid[i], NULL, worker_main, &w[i]) == 0;
+        running += started[i];
+    }
+    /* The caller is worker 0; ranges of threads that failed to start are stolen */
+    worker_main(&w[0]);
+    for (int i = 1; i < threads; i++)
+        if (started[i]) pthread_join(tid[i], NULL);
+
+    if (ps) {
+        ps->threads = running;
+        ps->steals = atomic_load(&p->steals);
+    }
+    return running == threads;
+}
@@ -58,3 +58,10 @@ double vps_pixel_distance_to_meters(double dx, double dy, double lat, int zoom)
     double mpp = vps_meters_per_pixel(lat, zoom);
     return sqrt(dx * dx + dy * dy) * mpp;
 }
+
+double vps_pixel_distance_to_meters_local(const vps_local_frame_t *frame,
+                                          double dx, double dy, double lat, int zoom) {
+    double mpp = ldexp(VPS_EARTH_CIRCUMFERENCE_M / VPS_TILE_SIZE, -zoom) *
+                 vps_local_frame_cos_lat(frame, lat);
+    return sqrt(dx * dx + dy * dy) * mpp;
+}
@@ -4,9 +4,21 @@
  */
 #include "geofence.h"
 #include "tile_math.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define KM_PER_DEG (6371.0 * M_PI / 180.0)   /* same sphere as vps_haversine_km */
+#define MAX_ROWS (1 << 22)
 
 bool vps_geofence_contains(const vps_geofence_t *fence, vps_geopoint_t point) {
-    if (fence->type == VPS_FENCE_CIRCLE) {
+    if (fence->type == VPS_FENCE_POLYGON) {
+        return vps_geofence_poly_contains(fence->poly, point, fence->margin_km);
+    } else if (fence->type == VPS_FENCE_CIRCLE) {
         double dist = vps_haversine_km(fence->center, point);
         return dist <= (fence->radius_km - fence->margin_km);
     } else {
@@ -27,6 +39,9 @@ bool vps_geofence_contains(const vps_geofence_t *fence, vps_geopoint_t point) {
 }
 
 double vps_geofence_distance_km(const vps_geofence_t *fence, vps_geopoint_t point) {
+    if (fence->type == VPS_FENCE_POLYGON) {
+        return vps_geofence_poly_distance_km(fence->poly, point);
+    }
     if (fence->type == VPS_FENCE_CIRCLE) {
         double dist = vps_haversine_km(fence->center, point);
         return fence->radius_km - dist;
@@ -41,3 +56,542 @@ double vps_geofence_distance_km(const vps_geofence_t *fence, vps_geopoint_t poin
     double margin_lon = fence->half_lon_km - dlon;
     return (margin_lat < margin_lon) ? margin_lat : margin_lon;
 }
+
+static inline bool local_ok(const vps_geofence_t *fence, const vps_local_frame_t *frame,
+                            vps_geopoint_t point) {
+    return fence->type != VPS_FENCE_POLYGON && vps_local_frame_covers(frame, point) &&
+           vps_local_frame_covers(frame, fence->center);
+}
+
+/* Unsigned km offsets of point from a rect centre, as the haversine path measures them */
+static void rect_offsets(const vps_geofence_t *fence, const vps_local_frame_t *frame,
+                         vps_geopoint_t point, double *dn_km, double *de_km) {
+    *dn_km = fabs(point.lat - fence->center.lat) * frame->m_per_deg_lat * 1e-3;
+    *de_km = vps_local_frame_distance_m(frame, fence->center,
+                                        (vps_geopoint_t){fence->center.lat, point.lon}) * 1e-3;
+}
+
+bool vps_geofence_contains_local(const vps_geofence_t *fence, const vps_local_frame_t *frame,
+                                 vps_geopoint_t point) {
+    if (!local_ok(fence, frame, point)) return vps_geofence_contains(fence, point);
+    if (fence->type == VPS_FENCE_CIRCLE)
+        return vps_local_frame_within_m(frame, fence->center, point,
+                                        (fence->radius_km - fence->margin_km) * 1e3);
+    double dn, de;
+    rect_offsets(fence, frame, point, &dn, &de);
+    return dn <= fence->half_lat_km - fence->margin_km &&
+           de <= fence->half_lon_km - fence->margin_km;
+}
+
+double vps_geofence_distance_km_local(const vps_geofence_t *fence,
+                                      const vps_local_frame_t *frame, vps_geopoint_t point) {
+    if (!local_ok(fence, frame, point)) return vps_geofence_distance_km(fence, point);
+    if (fence->type == VPS_FENCE_CIRCLE)
+        return fence->radius_km - vps_local_frame_distance_m(frame, fence->center, point) * 1e-3;
+    double dn, de;
+    rect_offsets(fence, frame, point, &dn, &de);
+    return fmin(fence->half_lat_km - dn, fence->half_lon_km - de);
+}
+
+/* --- Polygon fences --- */
+
+/*
+ * Sign tests treat zero as negative. Every point is classified against a
+ * segment or edge the same way wherever it comes up, so a crossing
+ * through a shared vertex counts once and the centre-to-centre chain used
+ * at build time agrees with the centre-to-point test used by queries.
+ */
+static inline bool left_of(double ax, double ay, double bx, double by, double px, double py) {
+    return (bx - ax) * (py - ay) - (by - ay) * (px - ax) > 0.0;
+}
+
+/* Does segment c -> p cross edge e? */
+static inline bool crosses(const vps_poly_edge_t *e, double cx, double cy, double px,
+                           double py) {
+    if (left_of(cx, cy, px, py, e->ax, e->ay) == left_of(cx, cy, px, py, e->bx, e->by))
+        return false;
+    return left_of(e->ax, e->ay, e->bx, e->by, cx, cy) !=
+           left_of(e->ax, e->ay, e->bx, e->by, px, py);
+}
+
+static inline double edge_dist2(const vps_poly_edge_t *e, double px, double py) {
+    double dx = e->bx - e->ax, dy = e->by - e->ay;
+    double wx = px - e->ax, wy = py - e->ay;
+    double t = (wx * dx + wy * dy) * e->inv_len2;
+    if (t < 0.0) t = 0.0;
+    if (t > 1.0) t = 1.0;
+    wx -= t * dx;
+    wy -= t * dy;
+    return wx * wx + wy * wy;
+}
+
+void vps_geofence_poly_project(const vps_geofence_poly_t *poly, vps_geopoint_t point,
+                               double *x, double *y) {
+    *x = (point.lon - poly->lon0) * cos(point.lat * M_PI / 180.0) * KM_PER_DEG;
+    *y = (point.lat - poly->lat0) * KM_PER_DEG;
+}
+
+typedef struct {
+    int32_t row, col;
+    uint32_t edge;
+} cell_edge_t;
+
+static int cmp_cell_edge(const void *a, const void *b) {
+    const cell_edge_t *x = a, *y = b;
+    if (x->row != y->row) return x->row < y->row ? -1 : 1;
+    if (x->col != y->col) return x->col < y->col ? -1 : 1;
+    return (x->edge > y->edge) - (x->edge < y->edge);
+}
+
+/* Crossings of segment c -> p with the union of two sorted edge lists */
+static int count_crossings(const vps_geofence_poly_t *poly, const uint32_t *a, int na,
+                           const uint32_t *b, int nb, double cx, double cy, double px,
+                           double py) {
+    int n = 0, i = 0, j = 0;
+    while (i < na || j < nb) {
+        uint32_t e;
+        if (j >= nb || (i < na && a[i] < b[j])) {
+            e = a[i++];
+        } else {
+            if (i < na && a[i] == b[j]) i++;
+            e = b[j++];
+        }
+        n += crosses(&poly->edges[e], cx, cy, px, py);
+    }
+    return n;
+}
+
+/* Cells of one row crossed by edge e, padded by eps so rounding never drops one */
+static int rasterize_edge(const vps_geofence_poly_t *poly, uint32_t e, cell_edge_t *out) {
+    const vps_poly_edge_t *ed = &poly->edges[e];
+    double s = poly->cell_km, eps = s * 1e-9;
+    double ax = ed->ax - poly->x0, ay = ed->ay - poly->y0;
+    double bx = ed->bx - poly->x0, by = ed->by - poly->y0;
+    double dx = bx - ax, dy = by - ay;
+    double ylo = fmin(ay, by) - eps, yhi = fmax(ay, by) + eps;
+    int r0 = (int)floor(ylo * poly->inv_cell), r1 = (int)floor(yhi * poly->inv_cell);
+    int n = 0;
+    for (int r = r0; r <= r1; r++) {
+        /* x range of the edge within the row band */
+        double b0 = fmax(ylo, r * s - eps), b1 = fmin(yhi, (r + 1) * s + eps);
+        double xa, xb;
+        if (dy == 0.0) {
+            xa = ax;
+            xb = bx;
+        } else {
+            double ta = (b0 - ay) / dy, tb = (b1 - ay) / dy;
+            ta = fmin(fmax(ta, 0.0), 1.0);
+            tb = fmin(fmax(tb, 0.0), 1.0);
+            xa = ax + ta * dx;
+            xb = ax + tb * dx;
+        }
+        int c0 = (int)floor((fmin(xa, xb) - eps) * poly->inv_cell);
+        int c1 = (int)floor((fmax(xa, xb) + eps) * poly->inv_cell);
+        for (int c = c0; c <= c1; c++) {
+            if (out) out[n] = (cell_edge_t){r, c, e};
+            n++;
+        }
+    }
+    return n;
+}
+
+bool vps_geofence_poly_build(vps_geofence_poly_t *poly, const vps_geopoint_t *points,
+                             const int *ring_len, int n_rings) {
+    memset(poly, 0, sizeof(*poly));
+    if (!points || !ring_len || n_rings < 1) return false;
+    int n_points = 0;
+    for (int r = 0; r < n_rings; r++) {
+        if (ring_len[r] < 3) return false;
+        n_points += ring_len[r];
+    }
+
+    double min_lat = points[0].lat, max_lat = min_lat;
+    double min_lon = points[0].lon, max_lon = min_lon;
+    for (int i = 1; i < n_points; i++) {
+        min_lat = fmin(min_lat, points[i].lat);
+        max_lat = fmax(max_lat, points[i].lat);
+        min_lon = fmin(min_lon, points[i].lon);
+        max_lon = fmax(max_lon, points[i].lon);
+    }
+    poly->min_lat = min_lat;
+    poly->min_lon = min_lon;
+    poly->max_lat = max_lat;
+    poly->max_lon = max_lon;
+    poly->lat0 = 0.5 * (min_lat + max_lat);
+    poly->lon0 = 0.5 * (min_lon + max_lon);
+
+    /* Edge table, skipping zero-length edges (e.g. an explicit ring closure) */
+    poly->edges = malloc(sizeof(vps_poly_edge_t) * (size_t)n_points);
+    if (!poly->edges) return false;
+    double min_x = INFINITY, max_x = -INFINITY, min_y = INFINITY, max_y = -INFINITY;
+    double total_len = 0.0;
+    int base = 0;
+    for (int r = 0; r < n_rings; r++) {
+        for (int i = 0; i < ring_len[r]; i++) {
+            double ax, ay, bx, by;
+            vps_geofence_poly_project(poly, points[base + i], &ax, &ay);
+            vps_geofence_poly_project(poly, points[base + (i + 1) % ring_len[r]], &bx, &by);
+            min_x = fmin(min_x, ax);
+            max_x = fmax(max_x, ax);
+            min_y = fmin(min_y, ay);
+            max_y = fmax(max_y, ay);
+            double len2 = (bx - ax) * (bx - ax) + (by - ay) * (by - ay);
+            if (len2 <= 0.0) continue;
+            poly->edges[poly->n_edges++] =
+                (vps_poly_edge_t){ax, ay, bx, by, 1.0 / len2};
+            total_len += sqrt(len2);
+        }
+        base += ring_len[r];
+    }
+    if (poly->n_edges < 3) {
+        vps_geofence_poly_free(poly);
+        return false;
+    }
+
+    /* Cells about two mean edges wide, one empty cell of padding all round */
+    double s = 2.0 * total_len / poly->n_edges;
+    double extent = fmax(max_x - min_x, max_y - min_y);
+    if (s < extent / (MAX_ROWS - 3)) s = extent / (MAX_ROWS - 3);
+    poly->cell_km = s;
+    poly->inv_cell = 1.0 / s;
+    poly->x0 = min_x - s;
+    poly->y0 = min_y - s;
+    poly->rows = (int)((max_y - poly->y0) * poly->inv_cell) + 2;
+
+    size_t n_entries = 0;
+    for (int e = 0; e < poly->n_edges; e++) n_entries += (size_t)rasterize_edge(poly, (uint32_t)e, NULL);
+    cell_edge_t *tmp = malloc(sizeof(cell_edge_t) * n_entries);
+    poly->edge_idx = malloc(sizeof(uint32_t) * n_entries);
+    poly->row_start = calloc((size_t)poly->rows + 1, sizeof(uint32_t));
+    if (!tmp || !poly->edge_idx || !poly->row_start) {
+        free(tmp);
+        vps_geofence_poly_free(poly);
+        return false;
+    }
+    size_t k = 0;
+    for (int e = 0; e < poly->n_edges; e++) k += (size_t)rasterize_edge(poly, (uint32_t)e, tmp + k);
+    qsort(tmp, n_entries, sizeof(cell_edge_t), cmp_cell_edge);
+
+    size_t n_cells = 0;
+    for (size_t i = 0; i < n_entries; i++)
+        n_cells += i == 0 || tmp[i].row != tmp[i - 1].row || tmp[i].col != tmp[i - 1].col;
+    poly->cells = malloc(sizeof(vps_poly_cell_t) * (n_cells + 1));
+    if (!poly->cells) {
+        free(tmp);
+        vps_geofence_poly_free(poly);
+        return false;
+    }
+    size_t c = 0;
+    for (size_t i = 0; i < n_entries; i++) {
+        if (i == 0 || tmp[i].row != tmp[i - 1].row || tmp[i].col != tmp[i - 1].col) {
+            poly->cells[c++] = (vps_poly_cell_t){tmp[i].col, (uint32_t)i, 0};
+            poly->row_start[tmp[i].row + 1]++;
+        }
+        poly->edge_idx[i] = tmp[i].edge;
+    }
+    poly->cells[c] = (vps_poly_cell_t){INT32_MAX, (uint32_t)n_entries, 0};
+    poly->n_cells = (int)n_cells;
+    for (int r = 0; r < poly->rows; r++) poly->row_start[r + 1] += poly->row_start[r];
+    free(tmp);
+
+    /*
+     * Inside flags: walk each row from the empty cell left of its first
+     * stored cell (outside the polygon) through the cell centres, toggling
+     * on every edge crossed between neighbouring centres.
+     */
+    for (int r = 0; r < poly->rows; r++) {
+        double cy = poly->y0 + (r + 0.5) * s;
+        bool in = false;
+        int prev_col = INT32_MIN;
+        for (uint32_t i = poly->row_start[r]; i < poly->row_start[r + 1]; i++) {
+            vps_poly_cell_t *cell = &poly->cells[i];
+            const uint32_t *ce = poly->edge_idx + cell->first;
+            int cn = (int)(cell[1].first - cell->first);
+            double cx = poly->x0 + (cell->col + 0.5) * s;
+            if (prev_col == cell->col - 1) {
+                const vps_poly_cell_t *pc = cell - 1;
+                in ^= count_crossings(poly, poly->edge_idx + pc->first,
+                                      (int)(cell->first - pc->first), ce, cn, cx - s, cy,
+                                      cx, cy) & 1;
+            } else {
+                if (prev_col != INT32_MIN) {
+                    vps_poly_cell_t *pc = cell - 1;
+                    in ^= count_crossings(poly, poly->edge_idx + pc->first,
+                                          (int)(cell->first - pc->first), NULL, 0,
+                                          poly->x0 + (pc->col + 0.5) * s, cy,
+                                          poly->x0 + (pc->col + 1.5) * s, cy) & 1;
+                    if (in) pc->flags |= VPS_POLY_RUN_IN;
+                }
+                in ^= count_crossings(poly, ce, cn, NULL, 0, cx - s, cy, cx, cy) & 1;
+            }
+            if (in) cell->flags |= VPS_POLY_CENTER_IN;
+            prev_col = cell->col;
+        }
+    }
+    return true;
+}
+
+void vps_geofence_poly_free(vps_geofence_poly_t *poly) {
+    free(poly->edges);
+    free(poly->cells);
+    free(poly->row_start);
+    free(poly->edge_idx);
+    memset(poly, 0, sizeof(*poly));
+}
+
+/* First cell of row r with col >= c */
+static uint32_t row_lower_bound(const vps_geofence_poly_t *poly, int r, int c) {
+    uint32_t lo = poly->row_start[r], hi = poly->row_start[r + 1];
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (poly->cells[mid].col < c) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static bool inside_xy(const vps_geofence_poly_t *poly, double x, double y) {
+    double gx = (x - poly->x0) * poly->inv_cell, gy = (y - poly->y0) * poly->inv_cell;
+    if (!(gy >= 0.0 && gy < poly->rows)) return false;
+    int r = (int)gy;
+    if (!(gx >= 0.0 && gx < (double)INT32_MAX)) return false;
+    int c = (int)gx;
+    uint32_t i = row_lower_bound(poly, r, c);
+    const vps_poly_cell_t *cell = &poly->cells[i];
+    if (i == poly->row_start[r + 1] || cell->col != c)
+        return i > poly->row_start[r] && (cell[-1].flags & VPS_POLY_RUN_IN);
+    double cx = poly->x0 + (c + 0.5) * poly->cell_km, cy = poly->y0 + (r + 0.5) * poly->cell_km;
+    int n = count_crossings(poly, poly->edge_idx + cell->first,
+                            (int)(cell[1].first - cell->first), NULL, 0, cx, cy, x, y);
+    return ((cell->flags & VPS_POLY_CENTER_IN) != 0) ^ (n & 1);
+}
+
+/* Squared distance to the nearest edge, searching only up to sqrt(limit2) */
+static double nearest2(const vps_geofence_poly_t *poly, double x, double y, double limit2) {
+    double s = poly->cell_km, best = limit2;
+    double gy = (y - poly->y0) * poly->inv_cell;
+    int r0 = gy < 0.0 ? 0 : gy >= poly->rows ? poly->rows - 1 : (int)gy;
+    double gx = floor((x - poly->x0) * poly->inv_cell);
+    int c0 = gx < -1.0 ? -1 : gx > (double)INT32_MAX - 1 ? INT32_MAX - 1 : (int)gx;
+    bool up = true, down = true;
+    for (int k = 0; up || down; k++) {
+        for (int side = 0; side < 2; side++) {
+            int r = side ? r0 - k : r0 + k;
+            if (side && k == 0) continue;
+            if (side ? !down : !up) continue;
+            if (r < 0 || r >= poly->rows) {
+                if (side) down = false;
+                else up = false;
+                continue;
+            }
+            double ylo = poly->y0 + r * s, dy = y < ylo ? ylo - y : fmax(0.0, y - (ylo + s));
+            double dy2 = dy * dy;
+            if (dy2 >= best) {
+                if (side) down = false;
+                else up = false;
+                continue;
+            }
+            uint32_t beg = poly->row_start[r], end = poly->row_start[r + 1];
+            uint32_t mid = row_lower_bound(poly, r, c0);
+            for (uint32_t i = mid; i < end; i++) {      /* rightwards */
+                const vps_poly_cell_t *cell = &poly->cells[i];
+                double dx = fmax(0.0, poly->x0 + cell->col * s - x);
+                if (dx * dx + dy2 >= best) break;
+                for (uint32_t j = cell->first; j < cell[1].first; j++)
+                    best = fmin(best, edge_dist2(&poly->edges[poly->edge_idx[j]], x, y));
+            }
+            for (uint32_t i = mid; i > beg; i--) {      /* leftwards */
+                const vps_poly_cell_t *cell = &poly->cells[i - 1];
+                double dx = fmax(0.0, x - (poly->x0 + (cell->col + 1) * s));
+                if (dx * dx + dy2 >= best) break;
+                for (uint32_t j = cell->first; j < cell[1].first; j++)
+                    best = fmin(best, edge_dist2(&poly->edges[poly->edge_idx[j]], x, y));
+            }
+        }
+    }
+    return best;
+}
+
+bool vps_geofence_poly_contains(const vps_geofence_poly_t *poly, vps_geopoint_t point,
+                                double margin_km) {
+    double x, y;
+    vps_geofence_poly_project(poly, point, &x, &y);
+    if (!inside_xy(poly, x, y)) return false;
+    if (margin_km <= 0.0) return true;
+    double m2 = margin_km * margin_km;
+    return nearest2(poly, x, y, m2) >= m2;
+}
+
+double vps_geofence_poly_distance_km(const vps_geofence_poly_t *poly, vps_geopoint_t point) {
+    return vps_geofence_poly_distance_capped_km(poly, point, INFINITY);
+}
+
+double vps_geofence_poly_distance_capped_km(const vps_geofence_poly_t *poly,
+                                            vps_geopoint_t point, double limit_km) {
+    double x, y;
+    vps_geofence_poly_project(poly, point, &x, &y);
+    double d = sqrt(nearest2(poly, x, y, limit_km * limit_km));
+    return inside_xy(poly, x, y) ? d : -d;
+}
+
+/* --- Predicted breach --- */
+
+/* First t >= 0 with |p + v t| <= r, INFINITY if never */
+static double enter_circle(double px, double py, double vx, double vy, double r) {
+    double a = vx * vx + vy * vy, b = px * vx + py * vy, c = px * px + py * py - r * r;
+    if (c <= 0.0) return 0.0;
+    if (b >= 0.0) return INFINITY;
+    double disc = b * b - a * c;
+    if (disc < 0.0) return INFINITY;
+    return c / (-b + sqrt(disc));      /* smaller root, without cancellation */
+}
+
+/* First t >= 0 with |p + v t| >= r, INFINITY if never */
+static double exit_circle(double px, double py, double vx, double vy, double r) {
+    double a = vx * vx + vy * vy, b = px * vx + py * vy, c = px * px + py * py - r * r;
+    if (c >= 0.0) return 0.0;
+    if (a == 0.0) return INFINITY;
+    double s = sqrt(b * b - a * c);
+    return b <= 0.0 ? (-b + s) / a : -c / (b + s);
+}
+
+/* Entry and exit times of x0 + v t through the slab [-h, h] */
+static void slab(double x0, double v, double h, double *t_in, double *t_out) {
+    if (v == 0.0) {
+        bool in = fabs(x0) <= h;
+        *t_in = in ? -INFINITY : INFINITY;
+        *t_out = in ? INFINITY : -INFINITY;
+        return;
+    }
+    double t0 = (-h - x0) / v, t1 = (h - x0) / v;
+    *t_in = fmin(t0, t1);
+    *t_out = fmax(t0, t1);
+}
+
+/* First t >= 0 at which the point comes within r of the edge */
+static double edge_contact(const vps_poly_edge_t *e, double px, double py, double vx, double vy,
+                           double r) {
+    double dx = e->bx - e->ax, dy = e->by - e->ay;
+    double t = fmin(enter_circle(px - e->ax, py - e->ay, vx, vy, r),
+                    enter_circle(px - e->bx, py - e->by, vx, vy, r));
+    /* Side of the capsule: signed distance to the line reaches r */
+    double inv_len = sqrt(e->inv_len2);
+    double s0 = (dx * (py - e->ay) - dy * (px - e->ax)) * inv_len;
+    double sv = (dx * vy - dy * vx) * inv_len;
+    if (s0 * sv < 0.0) {
+        double th = fmax(0.0, (fabs(s0) - r) / fabs(sv));
+        double u = ((px + vx * th - e->ax) * dx + (py + vy * th - e->ay) * dy) * e->inv_len2;
+        if (u >= 0.0 && u <= 1.0) t = fmin(t, th);
+    }
+    return t;
+}
+
+/* Earliest edge contact within reach along p -> p + v t_max, t_max if none */
+static double poly_contact(const vps_geofence_poly_t *poly, double px, double py, double vx,
+                           double vy, double reach, double t_max) {
+    double s = poly->cell_km, best = t_max;
+    double qy = py + vy * t_max;
+    int r_lo = (int)floor((fmin(py, qy) - reach - poly->y0) * poly->inv_cell);
+    int r_hi = (int)floor((fmax(py, qy) + reach - poly->y0) * poly->inv_cell);
+    if (r_lo < 0) r_lo = 0;
+    if (r_hi >= poly->rows) r_hi = poly->rows - 1;
+    /* Rows in the direction of travel, so later rows can be cut at the best time */
+    int step = vy < 0.0 ? -1 : 1;
+    for (int r = step > 0 ? r_lo : r_hi; r >= r_lo && r <= r_hi; r += step) {
+        /* Part of the track before best within reach of this row band */
+        double ylo = poly->y0 + r * s - reach, yhi = ylo + s + 2.0 * reach;
+        double t0 = 0.0, t1 = best;
+        if (vy != 0.0) {
+            double a = (ylo - py) / vy, b = (yhi - py) / vy;
+            t0 = fmax(t0, fmin(a, b));
+            t1 = fmin(t1, fmax(a, b));
+        }
+        if (t0 > t1) continue;
+        double xa = px + vx * t0, xb = px + vx * t1;
+        double gx0 = floor((fmin(xa, xb) - reach - poly->x0) * poly->inv_cell);
+        double gx1 = floor((fmax(xa, xb) + reach - poly->x0) * poly->inv_cell);
+        if (gx1 < 0.0 || gx0 > (double)INT32_MAX) continue;
+        int c_lo = gx0 < 0.0 ? 0 : (int)gx0;
+        int c_hi = gx1 > (double)INT32_MAX ? INT32_MAX : (int)gx1;
+        uint32_t end = poly->row_start[r + 1];
+        for (uint32_t i = row_lower_bound(poly, r, c_lo); i < end; i++) {
+            const vps_poly_cell_t *cell = &poly->cells[i];
+            if (cell->col > c_hi) break;
+            for (uint32_t j = cell->first; j < cell[1].first; j++)
+                best = fmin(best, edge_contact(&poly->edges[poly->edge_idx[j]], px, py, vx, vy,
+                                               reach));
+        }
+    }
+    return best;
+}
+
+/*
+ * Time until the disc of radius_km moving at (vn, ve) m/s leaves the fence
+ * less its margin (exclusion: comes within the margin of it). INFINITY if
+ * not within horizon_s.
+ */
+static double sweep(const vps_geofence_t *fence, bool exclusion, vps_geopoint_t p,
+                    double vn_mps, double ve_mps, double radius_km, double horizon_s) {
+    double reach = fmax(fence->margin_km, 0.0) + fmax(radius_km, 0.0);
+    double vx = ve_mps * 1e-3, vy = vn_mps * 1e-3;   /* km/s */
+    double t;
+    if (fence->type == VPS_FENCE_POLYGON) {
+        const vps_geofence_poly_t *poly = fence->poly;
+        double px, py;
+        vps_geofence_poly_project(poly, p, &px, &py);
+        bool inside = inside_xy(poly, px, py);
+        double near2 = reach > 0.0 ? nearest2(poly, px, py, reach * reach) : INFINITY;
+        if (inside == exclusion || near2 < reach * reach) return 0.0;
+        /* x = dlon cos(lat) K: east speed plus the shear of moving north */
+        vx -= (p.lon - poly->lon0) * (M_PI / 180.0) * sin(p.lat * M_PI / 180.0) * vy;
+        t = poly_contact(poly, px, py, vx, vy, reach, horizon_s);
+        return t < horizon_s ? t : INFINITY;
+    }
+    /*
+     * Circle and rect: plane at the fence centre, east scaled at the mid
+     * latitude for circles (close to haversine) and at the centre for
+     * rects (which measure east along the centre's parallel)
+     */
+    double dlon = p.lon - fence->center.lon;
+    if (dlon > 180.0) dlon -= 360.0;
+    if (dlon < -180.0) dlon += 360.0;
+    double lat_e = fence->type == VPS_FENCE_CIRCLE ? 0.5 * (p.lat + fence->center.lat)
+                                                   : fence->center.lat;
+    double px = dlon * cos(lat_e * M_PI / 180.0) * KM_PER_DEG;
+    double py = (p.lat - fence->center.lat) * KM_PER_DEG;
+    if (fence->type == VPS_FENCE_CIRCLE) {
+        double r = fence->radius_km + (exclusion ? reach : -reach);
+        if (r < 0.0) t = exclusion ? INFINITY : 0.0;
+        else t = exclusion ? enter_circle(px, py, vx, vy, r) : exit_circle(px, py, vx, vy, r);
+    } else {
+        /* Rects measure north and east separately, so the margin grows the box per axis */
+        double hx = fence->half_lon_km + (exclusion ? reach : -reach);
+        double hy = fence->half_lat_km + (exclusion ? reach : -reach);
+        double ix, ox, iy, oy;
+        slab(px, vx, hx, &ix, &ox);
+        slab(py, vy, hy, &iy, &oy);
+        double t_in = fmax(ix, iy), t_out = fmin(ox, oy);
+        bool hit = hx >= 0.0 && hy >= 0.0 && t_in <= t_out;
+        if (exclusion)
+            t = hit && t_out >= 0.0 ? fmax(t_in, 0.0) : INFINITY;
+        else
+            t = hit && t_in <= 0.0 && t_out >= 0.0 ? t_out : 0.0;
+    }
+    return t <= horizon_s ? t : INFINITY;
+}
+
+bool vps_geofence_time_to_breach(const vps_geofence_t *fence, vps_geopoint_t point,
+                                 double vn_mps, double ve_mps, double radius_km,
+                                 double horizon_s, double *t_out) {
+    double t = sweep(fence, false, point, vn_mps, ve_mps, radius_km, horizon_s);
+    *t_out = t;
+    return t <= horizon_s;
+}
+
+bool vps_geofence_time_to_entry(const vps_geofence_t *fence, vps_geopoint_t point,
+                                double vn_mps, double ve_mps, double radius_km,
+                                double horizon_s, double *t_out) {
+    double t = sweep(fence, true, point, vn_mps, ve_mps, radius_km, horizon_s);
+    *t_out = t;
+    return t <= horizon_s;
+}
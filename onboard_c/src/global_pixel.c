@@ -0,0 +1,131 @@
+/**
+ * @file global_pixel.c
+ * @brief 64-bit global Web Mercator pixel coordinates at z24.
+ */
+#include "global_pixel.h"
+#include "fusion_fx.h"
+#include <math.h>
+#include <stdlib.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define WORLD ((int64_t)1 << VPS_GPX_BITS)
+#define HALF_WORLD ((int64_t)1 << (VPS_GPX_BITS - 1))
+#define LEN_FRAC 6      /* pixel length in Q6 before scaling */
+#define WITHIN_MAX_MM ((int64_t)1 << 32)   /* keeps mm << 30 in range */
+
+/* Arithmetic right shift of a signed value (two's complement targets) */
+static int64_t rsh(int64_t v, int s) {
+    return v >> s;
+}
+
+vps_gpx_t vps_gpx_from_gps(vps_geopoint_t point) {
+    double lat = fmax(-VPS_MAX_MERCATOR_LAT, fmin(VPS_MAX_MERCATOR_LAT, point.lat));
+    double lat_rad = lat * M_PI / 180.0;
+    double y = (1.0 - log(tan(lat_rad) + 1.0 / cos(lat_rad)) / M_PI) / 2.0;
+    vps_gpx_t g;
+    g.x = llround((point.lon + 180.0) / 360.0 * (double)WORLD) & (WORLD - 1);
+    g.y = llround(y * (double)WORLD);
+    if (g.y < 0) g.y = 0;
+    if (g.y > WORLD - 1) g.y = WORLD - 1;
+    return g;
+}
+
+vps_geopoint_t vps_gpx_to_gps(vps_gpx_t g) {
+    vps_geopoint_t p;
+    p.lon = ldexp((double)g.x, -VPS_GPX_BITS) * 360.0 - 180.0;
+    p.lat = atan(sinh(M_PI * (1.0 - ldexp((double)g.y, 1 - VPS_GPX_BITS)))) * 180.0 / M_PI;
+    return p;
+}
+
+vps_gpx_t vps_gpx_from_tile_pixel(vps_tile_coord_t tile, vps_pixel_t pixel) {
+    int s = VPS_GPX_ZOOM - tile.z;
+    vps_gpx_t g;
+    g.x = ((int64_t)tile.x * VPS_TILE_SIZE << s) + llround(ldexp(pixel.x, s));
+    g.y = ((int64_t)tile.y * VPS_TILE_SIZE << s) + llround(ldexp(pixel.y, s));
+    return g;
+}
+
+vps_gpx_t vps_gpx_at_zoom(vps_gpx_t g, int zoom) {
+    int s = VPS_GPX_ZOOM - zoom;
+    return (vps_gpx_t){rsh(g.x, s), rsh(g.y, s)};
+}
+
+vps_tile_coord_t vps_gpx_tile(vps_gpx_t g, int zoom) {
+    int s = VPS_GPX_BITS - zoom;
+    return (vps_tile_coord_t){zoom, (int)rsh(g.x, s), (int)rsh(g.y, s)};
+}
+
+vps_pixel_t vps_gpx_tile_pixel(vps_gpx_t g, int zoom) {
+    int s = VPS_GPX_ZOOM - zoom;
+    int64_t mask = ((int64_t)VPS_TILE_SIZE << s) - 1;
+    return (vps_pixel_t){ldexp((double)(g.x & mask), -s), ldexp((double)(g.y & mask), -s)};
+}
+
+int vps_gpx_neighbors(vps_gpx_t g, int zoom, int ring, vps_tile_coord_t *out, int max_out) {
+    vps_tile_coord_t c = vps_gpx_tile(g, zoom);
+    int n = 1 << zoom, count = 0;
+    int x0 = c.x - ring, x1 = c.x + ring;
+    if (x1 - x0 + 1 >= n) {   /* ring spans the world: every column once */
+        x0 = 0;
+        x1 = n - 1;
+    }
+    for (int y = c.y - ring; y <= c.y + ring; y++) {
+        if (y < 0 || y >= n) continue;
+        for (int x = x0; x <= x1 && count < max_out; x++)
+            out[count++] = (vps_tile_coord_t){zoom, x & (n - 1), y};
+    }
+    return count;
+}
+
+vps_gpx_t vps_gpx_delta(vps_gpx_t a, vps_gpx_t b) {
+    int64_t dx = ((b.x - a.x + HALF_WORLD) & (WORLD - 1)) - HALF_WORLD;
+    return (vps_gpx_t){dx, b.y - a.y};
+}
+
+void vps_gpx_scale_init(vps_gpx_scale_t *s, vps_gpx_t ref) {
+    /* cos(lat) = sech(psi), psi = pi (1 - y / 2^31); d psi / dy = -pi / 2^31 */
+    double psi = M_PI * (1.0 - ldexp((double)ref.y, 1 - VPS_GPX_BITS));
+    double sech = 1.0 / cosh(psi), th = tanh(psi);
+    s->y0 = ref.y;
+    s->s0 = llround(VPS_EARTH_CIRCUMFERENCE_M * 1000.0 * sech * ldexp(1.0, 24 - VPS_GPX_BITS));
+    s->a = llround(th * M_PI * ldexp(1.0, 57 - VPS_GPX_BITS));
+    s->b = llround((2.0 * th * th - 1.0) / 2.0 * M_PI * M_PI * ldexp(1.0, 90 - 2 * VPS_GPX_BITS));
+}
+
+/* Delta of a and b and the mm per pixel (Q24) at their mid row */
+static bool mid_scale(const vps_gpx_scale_t *s, vps_gpx_t a, vps_gpx_t b, vps_gpx_t *d,
+                      int64_t *scale) {
+    *d = vps_gpx_delta(a, b);
+    int64_t dy = rsh(a.y + b.y, 1) - s->y0;
+    if (llabs(d->x) > VPS_GPX_NEAR_PX || llabs(d->y) > VPS_GPX_NEAR_PX ||
+        llabs(dy) > VPS_GPX_NEAR_PX)
+        return false;
+    /* sech(psi) / sech(psi0) = 1 + a dy + b dy^2, Q56 */
+    int64_t f = ((int64_t)1 << 56) + s->a * dy + rsh(s->b * dy, 32) * dy;
+    *scale = rsh(s->s0 * rsh(f, 28), 28);
+    return true;
+}
+
+bool vps_gpx_distance_mm(const vps_gpx_scale_t *s, vps_gpx_t a, vps_gpx_t b,
+                         int64_t *mm_out) {
+    vps_gpx_t d;
+    int64_t scale;
+    if (!mid_scale(s, a, b, &d, &scale)) return false;
+    uint64_t len2 = (uint64_t)(d.x * d.x + d.y * d.y) << (2 * LEN_FRAC);
+    int64_t len = vps_fx_isqrt64(len2);                               /* pixels, Q6 */
+    *mm_out = rsh(len * scale + ((int64_t)1 << (23 + LEN_FRAC)), 24 + LEN_FRAC);
+    return true;
+}
+
+bool vps_gpx_within_mm(const vps_gpx_scale_t *s, vps_gpx_t a, vps_gpx_t b, int64_t mm) {
+    vps_gpx_t d;
+    int64_t scale;
+    if (mm < 0 || !mid_scale(s, a, b, &d, &scale)) return false;
+    if (mm > WITHIN_MAX_MM) return true;
+    int64_t lim = (mm << (24 + LEN_FRAC)) / scale;                    /* pixels, Q6 */
+    if (lim >= (int64_t)1 << 31) return true;   /* longer than any pair inside the reach */
+    return (uint64_t)(d.x * d.x + d.y * d.y) << (2 * LEN_FRAC) <= (uint64_t)(lim * lim);
+}
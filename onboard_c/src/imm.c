@@ -0,0 +1,209 @@
+/**
+ * @file imm.c
+ * @brief IMM filter: mixing, bank pass, model likelihoods, combination.
+ */
+#include "imm.h"
+#include <math.h>
+
+#define M VPS_IMM_MODELS
+
+enum { P00, P01, P02, P03, P11, P12, P13, P22, P23, P33 };
+
+/* Packed covariance entries with their row and column, for X-macros */
+#define FOR_PACKED(X)                                                      \
+    X(P00, 0, 0) X(P01, 0, 1) X(P02, 0, 2) X(P03, 0, 3) X(P11, 1, 1)        \
+    X(P12, 1, 2) X(P13, 1, 3) X(P22, 2, 2) X(P23, 2, 3) X(P33, 3, 3)
+
+vps_imm_config_t vps_imm_default_config(void) {
+    vps_imm_config_t cfg;
+    cfg.q_scale[VPS_IMM_HOVER] = 0.01;
+    cfg.q_scale[VPS_IMM_CRUISE] = 1.0;
+    cfg.q_scale[VPS_IMM_TURN] = 100.0;
+    cfg.tau_s[VPS_IMM_HOVER] = 2.0;
+    cfg.tau_s[VPS_IMM_CRUISE] = 0.0;
+    cfg.tau_s[VPS_IMM_TURN] = 0.0;
+    cfg.p_stay = 0.95;
+    cfg.mu_min = 1e-4;
+    return cfg;
+}
+
+void vps_imm_init(vps_imm_t *m, const vps_imm_config_t *cfg) {
+    m->cfg = cfg ? *cfg : vps_imm_default_config();
+    vps_imm_reset(m);
+}
+
+void vps_imm_reset(vps_imm_t *m) {
+    vps_ekf_bank_init(&m->bank, M);
+    for (int j = 0; j < M; j++) {
+        m->mu[j] = 1.0 / M;
+        m->d[j] = 0.0;
+    }
+    m->last_t = 0.0;
+    m->initialized = false;
+    m->last_gate = 0.0;
+    m->decay_dt = -1.0;
+}
+
+void vps_imm_from_state(vps_imm_t *m, const vps_ekf_state_t *s) {
+    vps_imm_reset(m);
+    if (!s->initialized) return;
+    double p[VPS_EKF_PACKED];
+    vps_ekf_pack_cov(p, &s->P[0][0]);
+    for (int j = 0; j < M; j++) vps_ekf_bank_set(&m->bank, j, s->x, p);
+    m->last_t = s->last_t;
+    m->initialized = true;
+    m->last_gate = s->last_gate;
+}
+
+static void first_fix(vps_imm_t *m, vps_geopoint_t z, double t) {
+    vps_ekf_state_t s;
+    vps_ekf_init(&s);
+    s.x[0] = z.lat;
+    s.x[1] = z.lon;
+    for (int i = 0; i < 4; i++) s.P[i][i] = 1e-6;  /* as vps_ekf_update */
+    s.last_t = t;
+    s.initialized = true;
+    vps_imm_from_state(m, &s);
+}
+
+/*
+ * IMM interaction. With the symmetric transition matrix (p_stay on the
+ * diagonal, off elsewhere) the mixing weights are
+ * w_ij = (off + (p_stay - off)·δ_ij)·mu_i / c_j, so every mixed moment is
+ * the mu-weighted sum over all models plus a term for model j alone:
+ * O(models) instead of O(models²). Spreads are taken relative to model 0
+ * so that no large terms cancel. c gets the predicted probabilities.
+ */
+static void mix(vps_imm_t *m, double c[M]) {
+    double off = (1.0 - m->cfg.p_stay) / (M - 1), g = m->cfg.p_stay - off;
+    double x0[4], dx[4][M], a[VPS_EKF_PACKED][M], sx[4], sp[VPS_EKF_PACKED];
+    for (int k = 0; k < 4; k++) {
+        x0[k] = m->bank.x[k][0];
+        sx[k] = 0.0;
+        for (int i = 0; i < M; i++) {
+            dx[k][i] = m->bank.x[k][i] - x0[k];
+            sx[k] += m->mu[i] * dx[k][i];
+        }
+    }
+    for (int i = 0; i < M; i++) {
+#define SPREAD(e, r, q) a[e][i] = m->bank.p[e][i] + dx[r][i] * dx[q][i];
+        FOR_PACKED(SPREAD)
+#undef SPREAD
+    }
+    for (int e = 0; e < VPS_EKF_PACKED; e++) {
+        sp[e] = 0.0;
+        for (int i = 0; i < M; i++) sp[e] += m->mu[i] * a[e][i];
+    }
+
+    for (int j = 0; j < M; j++) {
+        c[j] = off + g * m->mu[j];  /* Σ mu = 1 */
+        double h = off / c[j], gj = g * m->mu[j] / c[j];
+        double mx[4];
+        for (int k = 0; k < 4; k++) mx[k] = h * sx[k] + gj * dx[k][j];
+#define MIXED(e, r, q) m->bank.p[e][j] = h * sp[e] + gj * a[e][j] - mx[r] * mx[q];
+        FOR_PACKED(MIXED)
+#undef MIXED
+        for (int k = 0; k < 4; k++) m->bank.x[k][j] = x0[k] + mx[k];
+    }
+}
+
+bool vps_imm_update(vps_imm_t *m, const vps_ekf_config_t *cfg,
+                    vps_geopoint_t measurement, double hdop, double t) {
+    if (!m->initialized) {
+        first_fix(m, measurement, t);
+        return true;
+    }
+
+    double dt = t - m->last_t;
+    if (dt < 0) return false;
+    if (dt > cfg->max_gap_s) {
+        first_fix(m, measurement, t);
+        return true;
+    }
+
+    double c[M];
+    mix(m, c);
+
+    double q[M];
+    if (dt != m->decay_dt) {  /* fixes usually arrive at a steady rate */
+        for (int j = 0; j < M; j++)
+            m->decay[j] = m->cfg.tau_s[j] > 0.0 ? exp(-dt / m->cfg.tau_s[j]) : 1.0;
+        m->decay_dt = dt;
+    }
+    for (int j = 0; j < M; j++) q[j] = m->cfg.q_scale[j] * cfg->process_noise;
+    vps_ekf_bank_propagate_models(&m->bank, q, m->decay, dt);
+
+    /* Innovation covariance of each model, before the correction */
+    double r = cfg->measurement_noise * hdop * hdop;
+    double lat[M], lon[M], rr[M], det[M];
+    for (int j = 0; j < M; j++) {
+        double s00 = m->bank.p[P00][j] + r, s11 = m->bank.p[P11][j] + r;
+        double s01 = m->bank.p[P01][j];
+        det[j] = s00 * s11 - s01 * s01;
+        lat[j] = measurement.lat;
+        lon[j] = measurement.lon;
+        rr[j] = r;
+    }
+    int passed = vps_ekf_bank_correct(&m->bank, lat, lon, rr, cfg->gate_threshold, m->d);
+    m->last_t = t;
+
+    double dmin = INFINITY;
+    for (int j = 0; j < M; j++)
+        if (m->d[j] < dmin) dmin = m->d[j];
+    m->last_gate = dmin;
+    if (passed == 0) {
+        /* Outlier for every model: keep the predicted probabilities */
+        for (int j = 0; j < M; j++) m->mu[j] = c[j];
+        return false;
+    }
+
+    /* mu_j ∝ c_j · N(ν; 0, S_j), scaled by exp(dmin²/2) so the closest
+     * model cannot underflow; the common 1/2π cancels */
+    double sum = 0.0;
+    for (int j = 0; j < M; j++) {
+        double e = m->d[j] * m->d[j] - dmin * dmin;
+        m->mu[j] = c[j] * exp(-0.5 * e) / sqrt(det[j]);
+        if (!(m->mu[j] > 0.0)) m->mu[j] = 0.0;  /* singular S */
+        sum += m->mu[j];
+    }
+    double lo = m->cfg.mu_min * sum;
+    sum = 0.0;
+    for (int j = 0; j < M; j++) {
+        if (m->mu[j] < lo) m->mu[j] = lo;
+        sum += m->mu[j];
+    }
+    for (int j = 0; j < M; j++) m->mu[j] /= sum;
+    return true;
+}
+
+void vps_imm_to_state(const vps_imm_t *m, vps_ekf_state_t *s) {
+    vps_ekf_init(s);
+    if (!m->initialized) return;
+
+    /* Moment-matched mixture, spreads relative to model 0 as in mix() */
+    double dx[4][M], mx[4], p[VPS_EKF_PACKED];
+    for (int k = 0; k < 4; k++) {
+        mx[k] = 0.0;
+        for (int j = 0; j < M; j++) {
+            dx[k][j] = m->bank.x[k][j] - m->bank.x[k][0];
+            mx[k] += m->mu[j] * dx[k][j];
+        }
+        s->x[k] = m->bank.x[k][0] + mx[k];
+    }
+#define COMBINED(e, r, q)                                                  \
+    p[e] = -mx[r] * mx[q];                                                 \
+    for (int j = 0; j < M; j++) p[e] += m->mu[j] * (m->bank.p[e][j] + dx[r][j] * dx[q][j]);
+    FOR_PACKED(COMBINED)
+#undef COMBINED
+    vps_ekf_unpack_cov(s->P, p);
+    s->last_t = m->last_t;
+    s->initialized = true;
+    s->last_gate = m->last_gate;
+}
+
+vps_imm_model_t vps_imm_best(const vps_imm_t *m) {
+    int best = 0;
+    for (int j = 1; j < M; j++)
+        if (m->mu[j] > m->mu[best]) best = j;
+    return (vps_imm_model_t)best;
+}
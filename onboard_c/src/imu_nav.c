@@ -0,0 +1,156 @@
+/**
+ * @file imu_nav.c
+ * @brief IMU/attitude prediction between visual fixes.
+ */
+#include "imu_nav.h"
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define M_PER_DEG_LAT 111320.0
+
+vps_imu_nav_config_t vps_imu_nav_default_config(void) {
+    vps_imu_nav_config_t cfg;
+    cfg.hdop_growth = 0.5;
+    cfg.max_age_s = 10.0;
+    return cfg;
+}
+
+void vps_imu_nav_init(vps_imu_nav_t *nav, const vps_imu_nav_config_t *cfg) {
+    memset(nav, 0, sizeof(*nav));
+    nav->cfg = cfg ? *cfg : vps_imu_nav_default_config();
+}
+
+void vps_imu_nav_attitude(vps_imu_nav_t *nav, const vps_attitude_t *att) {
+    float sr = sinf(att->roll), cr = cosf(att->roll);
+    float sp = sinf(att->pitch), cp = cosf(att->pitch);
+    float sy = sinf(att->yaw), cy = cosf(att->yaw);
+
+    /* First two rows of the ZYX body → NED rotation */
+    nav->rn[0] = cp * cy;
+    nav->rn[1] = sr * sp * cy - cr * sy;
+    nav->rn[2] = cr * sp * cy + sr * sy;
+    nav->re[0] = cp * sy;
+    nav->re[1] = sr * sp * sy + cr * cy;
+    nav->re[2] = cr * sp * sy - sr * cy;
+    nav->has_attitude = true;
+}
+
+/** Advance the integrated state to t holding the current acceleration. */
+static void integrate(vps_imu_nav_t *nav, double t) {
+    double dt = t - nav->t;
+    if (dt <= 0) return;
+    double h = 0.5 * dt * dt;
+    nav->pn += nav->vn * dt + nav->an * h;
+    nav->pe += nav->ve * dt + nav->ae * h;
+    nav->vn += nav->an * dt;
+    nav->ve += nav->ae * dt;
+    nav->t = t;
+}
+
+void vps_imu_nav_push(vps_imu_nav_t *nav, const vps_imu_sample_t *s) {
+    if (!nav->has_attitude) return;
+
+    /* Gravity is purely vertical in NED, so it drops out of north/east */
+    float an = nav->rn[0] * s->fx + nav->rn[1] * s->fy + nav->rn[2] * s->fz;
+    float ae = nav->re[0] * s->fx + nav->re[1] * s->fy + nav->re[2] * s->fz;
+
+    nav->ring[nav->head].t = s->t;
+    nav->ring[nav->head].an = an;
+    nav->ring[nav->head].ae = ae;
+    nav->head = (nav->head + 1) % VPS_IMU_RING;
+    if (nav->count < VPS_IMU_RING) nav->count++;
+    nav->samples++;
+
+    if (nav->valid) integrate(nav, s->t);
+    nav->an = an;
+    nav->ae = ae;
+}
+
+void vps_imu_nav_anchor(vps_imu_nav_t *nav, const vps_ekf_state_t *ekf, double hdop) {
+    if (!ekf->initialized) return;
+
+    nav->ref_lat = ekf->x[0];
+    nav->ref_lon = ekf->x[1];
+    nav->m_per_deg_lon = M_PER_DEG_LAT * cos(ekf->x[0] * M_PI / 180.0);
+    nav->pn = 0.0;
+    nav->pe = 0.0;
+    nav->vn = ekf->x[2] * M_PER_DEG_LAT;
+    nav->ve = ekf->x[3] * nav->m_per_deg_lon;
+    nav->an = 0.0f;
+    nav->ae = 0.0f;
+    nav->t = ekf->last_t;
+    nav->t_anchor = ekf->last_t;
+    nav->anchor_hdop = hdop;
+    nav->valid = true;
+
+    /* Replay samples captured after the fix, oldest first */
+    int start = (nav->head - nav->count + VPS_IMU_RING) % VPS_IMU_RING;
+    for (int k = 0; k < nav->count; k++) {
+        int i = (start + k) % VPS_IMU_RING;
+        if (nav->ring[i].t > nav->t_anchor) integrate(nav, nav->ring[i].t);
+        nav->an = nav->ring[i].an;
+        nav->ae = nav->ring[i].ae;
+    }
+}
+
+bool vps_imu_nav_position(const vps_imu_nav_t *nav, double t, vps_geopoint_t *pos,
+                          vps_velocity_t *vel, double *hdop) {
+    if (!nav->valid) return false;
+    double age = t - nav->t_anchor;
+    if (age < 0 || age > nav->cfg.max_age_s) return false;
+
+    double dt = t > nav->t ? t - nav->t : 0.0;
+    double h = 0.5 * dt * dt;
+    double pn = nav->pn + nav->vn * dt + nav->an * h;
+    double pe = nav->pe + nav->ve * dt + nav->ae * h;
+    pos->lat = nav->ref_lat + pn / M_PER_DEG_LAT;
+    pos->lon = nav->ref_lon + (nav->m_per_deg_lon > 1e-6 ? pe / nav->m_per_deg_lon : 0.0);
+    if (vel) {
+        vel->vn = nav->vn + nav->an * dt;
+        vel->ve = nav->ve + nav->ae * dt;
+    }
+    *hdop = nav->anchor_hdop + nav->cfg.hdop_growth * age;
+    return true;
+}
+
+vps_imu_sample_t vps_imu_from_msp(const vps_msp_raw_imu_t *raw, double t) {
+    const float k = (float)(VPS_GRAVITY / MSP_ACC_1G);
+    vps_imu_sample_t s;
+    s.t = t;
+    s.fx = k * raw->acc[0];
+    s.fy = -k * raw->acc[1];
+    s.fz = -k * raw->acc[2];
+    return s;
+}
+
+vps_attitude_t vps_attitude_from_msp(const vps_msp_attitude_t *att, double t) {
+    const float d2r = (float)(M_PI / 180.0);
+    vps_attitude_t a;
+    a.t = t;
+    a.roll = att->roll_deg10 * 0.1f * d2r;
+    a.pitch = att->pitch_deg10 * 0.1f * d2r;
+    a.yaw = att->yaw_deg * d2r;
+    return a;
+}
+
+bool vps_imu_nav_feed_msp(vps_imu_nav_t *nav, const vps_msp_parser_t *frame, double t) {
+    if (frame->cmd == MSP_CMD_RAW_IMU) {
+        vps_msp_raw_imu_t raw;
+        if (!vps_msp_decode_raw_imu(frame->payload, frame->len, &raw)) return false;
+        vps_imu_sample_t s = vps_imu_from_msp(&raw, t);
+        vps_imu_nav_push(nav, &s);
+        return true;
+    }
+    if (frame->cmd == MSP_CMD_ATTITUDE) {
+        vps_msp_attitude_t att;
+        if (!vps_msp_decode_attitude(frame->payload, frame->len, &att)) return false;
+        vps_attitude_t a = vps_attitude_from_msp(&att, t);
+        vps_imu_nav_attitude(nav, &a);
+        return true;
+    }
+    return false;
+}
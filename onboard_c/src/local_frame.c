@@ -0,0 +1,143 @@
+/**
+ * @file local_frame.c
+ * @brief Trig-free local east/north frame.
+ */
+#include "local_frame.h"
+#include "tile_math.h"
+#include <float.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define EARTH_RADIUS_M 6371000.0   /* same sphere as vps_haversine_km */
+
+bool vps_local_frame_init(vps_local_frame_t *f, vps_geopoint_t origin, double radius_km) {
+    if (!(radius_km > 0.0) || radius_km > VPS_LOCAL_FRAME_MAX_KM) return false;
+    double k = M_PI / 180.0;
+    f->origin = origin;
+    f->radius_km = radius_km;
+    f->m_per_deg_lat = EARTH_RADIUS_M * k;
+    f->max_lat_off = radius_km * 1000.0 / f->m_per_deg_lat;
+    double edge = fabs(origin.lat) + f->max_lat_off;
+    if (edge > VPS_LOCAL_FRAME_MAX_LAT) return false;
+    f->max_lon_off = f->max_lat_off / cos(edge * k);
+
+    /* Taylor series of cos(lat0 + u) in u = lat - lat0 (degrees) */
+    double c = cos(origin.lat * k), s = sin(origin.lat * k), kn = 1.0, un = 1.0;
+    f->cos_terms = 0;
+    while (f->cos_terms < VPS_LOCAL_FRAME_COS_TERMS && un >= 1e-14) {
+        static const double sign[4] = {1.0, -1.0, -1.0, 1.0};
+        int i = f->cos_terms++;
+        f->cos_poly[i] = sign[i % 4] * (i % 2 ? s : c) * kn;
+        kn *= k / (i + 1);
+        un *= f->max_lat_off * k / (i + 1);   /* next term's bound */
+    }
+    f->m_per_deg_lon = f->m_per_deg_lat * c;
+
+    /*
+     * Bound |distance_m - haversine| for two points in the box from the series remainders.
+     * sin_small drops x^13/13!, relative to sin x at most xm^12/13! / (sin xm / xm); the cos
+     * polynomial is off by at most un (Lagrange), relative to the smallest cos in the box.
+     * Both terms of hav are products of these, so h is off by a relative eh and y = sqrt(h)
+     * by eh / 2. asin is convex, so that moves asin(y) by at most y ey / sqrt(1 - y^2); the
+     * dropped asin tail is sum c_k y^(2k+1), k >= 5, with c_k <= c_5 = 63/2816, so at most
+     * c_5 y^11 / (1 - y^2). y is bounded from the box with the largest cos in it. Rounding
+     * adds 64 ulps of the longest distance and 1 um for the coordinate differences.
+     */
+    double xl = f->max_lat_off * k, xo = f->max_lon_off * k, xm = fmax(xl, xo);
+    double es = pow(xm, 12) / 6227020800.0 / (sin(xm) / xm);
+    double ec = un / cos(edge * k);
+    double ey = 0.5 * ((1.0 + es) * (1.0 + es) * (1.0 + ec) * (1.0 + ec) - 1.0);
+    double cmax = cos(fmax(fabs(origin.lat) - f->max_lat_off, 0.0) * k);
+    double y = sqrt(sin(xl) * sin(xl) + cmax * cmax * sin(xo) * sin(xo)) * (1.0 + ey);
+    double y2 = y * y;
+    f->max_err_m = 2.0 * EARTH_RADIUS_M * (y * ey / sqrt(1.0 - y2) +
+                                           63.0 / 2816.0 * pow(y, 11) / (1.0 - y2)) +
+                   64.0 * DBL_EPSILON * 2.0 * EARTH_RADIUS_M * asin(y) + 1e-6;
+    return true;
+}
+
+double vps_local_frame_cos_lat(const vps_local_frame_t *f, double lat) {
+    double u = lat - f->origin.lat, c = 0.0;
+    if (fabs(u) > f->max_lat_off) return cos(lat * M_PI / 180.0);
+    for (int i = f->cos_terms - 1; i >= 0; i--) c = c * u + f->cos_poly[i];
+    return c;
+}
+
+double vps_local_frame_m_per_deg_lon(const vps_local_frame_t *f, double lat) {
+    return f->m_per_deg_lat * vps_local_frame_cos_lat(f, lat);
+}
+
+static inline double wrap_lon(double dlon) {
+    if (dlon > 180.0) return dlon - 360.0;
+    if (dlon < -180.0) return dlon + 360.0;
+    return dlon;
+}
+
+/* sin(x) for |x| < 0.5 (half the box's longitude span), Taylor to x^11 */
+static inline double sin_small(double x) {
+    double x2 = x * x;
+    return x * (1.0 - x2 / 6.0 * (1.0 - x2 / 20.0 * (1.0 - x2 / 42.0 *
+           (1.0 - x2 / 72.0 * (1.0 - x2 / 110.0)))));
+}
+
+/* Haversine term sin²(d / 2R), with the trig replaced by series valid in the box */
+static inline double hav(const vps_local_frame_t *f, vps_geopoint_t a, vps_geopoint_t b) {
+    double half = M_PI / 360.0;
+    double sl = sin_small((b.lat - a.lat) * half);
+    double so = sin_small(wrap_lon(b.lon - a.lon) * half);
+    return sl * sl +
+           vps_local_frame_cos_lat(f, a.lat) * vps_local_frame_cos_lat(f, b.lat) * so * so;
+}
+
+double vps_local_frame_distance_m(const vps_local_frame_t *f,
+                                  vps_geopoint_t a, vps_geopoint_t b) {
+    double h = hav(f, a, b), y = sqrt(h);
+    /* asin(y), y < 0.16 for points up to 2000 km apart */
+    double as = y * (1.0 + h * (1.0 / 6.0 + h * (3.0 / 40.0 + h * (5.0 / 112.0 +
+                h * (35.0 / 1152.0)))));
+    return 2.0 * EARTH_RADIUS_M * as;
+}
+
+bool vps_local_frame_within_m(const vps_local_frame_t *f, vps_geopoint_t a,
+                              vps_geopoint_t b, double dist_m) {
+    if (dist_m < 0.0) return false;
+    double s = sin_small(dist_m / (2.0 * EARTH_RADIUS_M));
+    return hav(f, a, b) <= s * s;
+}
+
+bool vps_local_frame_covers(const vps_local_frame_t *f, vps_geopoint_t p) {
+    return fabs(p.lat - f->origin.lat) <= f->max_lat_off &&
+           fabs(wrap_lon(p.lon - f->origin.lon)) <= f->max_lon_off;
+}
+
+void vps_local_frame_to_enu(const vps_local_frame_t *f, vps_geopoint_t p,
+                            double *e_m, double *n_m) {
+    *n_m = (p.lat - f->origin.lat) * f->m_per_deg_lat;
+    *e_m = wrap_lon(p.lon - f->origin.lon) *
+           vps_local_frame_m_per_deg_lon(f, 0.5 * (f->origin.lat + p.lat));
+}
+
+vps_geopoint_t vps_local_frame_from_enu(const vps_local_frame_t *f,
+                                        double e_m, double n_m) {
+    double lat = f->origin.lat + n_m / f->m_per_deg_lat;
+    double lon = f->origin.lon +
+                 e_m / vps_local_frame_m_per_deg_lon(f, 0.5 * (f->origin.lat + lat));
+    return (vps_geopoint_t){lat, lon};
+}
+
+double vps_heading_deg(double vn, double ve) {
+    double a = fabs(vn), b = fabs(ve);
+    if (a == 0.0 && b == 0.0) return 0.0;
+    /* atan on [0, 1], Abramowitz & Stegun 4.4.49 (|error| <= 2e-8 rad) */
+    double z = a >= b ? b / a : a / b, z2 = z * z;
+    double t = z * (1.0 + z2 * (-0.3333314528 + z2 * (0.1999355085 +
+               z2 * (-0.1420889944 + z2 * (0.1065626393 + z2 * (-0.0752896400 +
+               z2 * (0.0429096138 + z2 * (-0.0161657367 + z2 * 0.0028662257))))))));
+    if (b > a) t = M_PI / 2.0 - t;
+    if (vn < 0.0) t = M_PI - t;
+    if (ve < 0.0) t = 2.0 * M_PI - t;
+    return t * (180.0 / M_PI);
+}
@@ -0,0 +1,304 @@
+/**
+ * @file main.c
+ * @brief Native onboard VPS service (replaces the Python loop in main.py).
+ *
+ * Usage:
+ *   vps_onboard [--config PATH] [--replay MATCH_LOG] [--protocol nmea|msp]
+ *               [--stdout] [--fast] [--pipeline] [--rate HZ]
+ *               [--rt-priority N] [--score-candidates] [--batch-fixes]
+ *
+ * --pipeline runs capture, retrieval, matching, fusion and output as
+ * separate threads (see pipeline.h) instead of one sequential loop.
+ * --rate additionally moves fusion and output to a fixed-rate thread
+ * (see output_thread.h), optionally SCHED_FIFO with --rt-priority.
+ * --score-candidates matches every retrieved tile and keeps the fix
+ * closest to the EKF instead of the first accepted one.
+ * --batch-fixes matches every retrieved tile and fuses all accepted fixes
+ * in one information-form EKF step.
+ * --fc-imu polls the flight controller for MSP_RAW_IMU and MSP_ATTITUDE
+ * on the UART after each output (needs --protocol msp) and predicts
+ * between visual fixes with the IMU (see imu_nav.h).
+ *
+ * Live matching needs a SuperPoint/LightGlue backend built against ONNX
+ * Runtime; until that is available the service runs from a recorded
+ * frame set (--replay).
+ */
+#include "config.h"
+#include "match_log.h"
+#include "output_thread.h"
+#include "pipeline.h"
+#include "runtime.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t g_running = 1;
+
+static void on_signal(int sig) {
+    (void)sig;
+    g_running = 0;
+}
+
+static speed_t baud_to_speed(int baud) {
+    switch (baud) {
+    case 4800: return B4800;
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    default: return B9600;
+    }
+}
+
+static int open_uart(const char *port, int baudrate) {
+    int fd = open(port, O_RDWR | O_NOCTTY);
+    if (fd < 0) return -1;
+
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0) {
+        close(fd);
+        return -1;
+    }
+    cfmakeraw(&tio);
+    cfsetospeed(&tio, baud_to_speed(baudrate));
+    cfsetispeed(&tio, baud_to_speed(baudrate));
+    tio.c_cflag |= CLOCAL;
+    tio.c_cc[VMIN] = 0;     /* reads return what is waiting, possibly nothing */
+    tio.c_cc[VTIME] = 0;
+    if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool fd_write(void *ctx, const uint8_t *data, size_t len) {
+    int fd = *(int *)ctx;
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static size_t fd_read(void *ctx, uint8_t *buf, size_t cap) {
+    int fd = *(int *)ctx;
+    ssize_t n;
+    do {
+        n = read(fd, buf, cap);
+    } while (n < 0 && errno == EINTR);
+    return n > 0 ? (size_t)n : 0;
+}
+
+static void sleep_s(double s) {
+    if (s <= 0) return;
+    struct timespec ts;
+    ts.tv_sec = (time_t)s;
+    ts.tv_nsec = (long)((s - (double)ts.tv_sec) * 1e9);
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR && g_running) {
+    }
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [--config PATH] [--replay MATCH_LOG] "
+            "[--protocol nmea|msp] [--stdout] [--fast] [--pipeline] "
+            "[--rate HZ] [--rt-priority N] [--score-candidates] [--batch-fixes] "
+            "[--fc-imu]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *config_path = VPS_CONFIG_DEFAULT_PATH;
+    const char *replay_path = NULL;
+    vps_output_protocol_t protocol = VPS_OUTPUT_NMEA;
+    bool to_stdout = false;
+    bool fast = false;
+    bool pipelined = false;
+    double output_hz = 0.0;
+    int rt_priority = 0;
+    bool score_candidates = false;
+    bool batch_fixes = false;
+    bool fc_imu = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            config_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--protocol") == 0 && i + 1 < argc) {
+            const char *p = argv[++i];
+            if (strcmp(p, "msp") == 0) {
+                protocol = VPS_OUTPUT_MSP;
+            } else if (strcmp(p, "nmea") != 0) {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--stdout") == 0) {
+            to_stdout = true;
+        } else if (strcmp(argv[i], "--fast") == 0) {
+            fast = true;
+        } else if (strcmp(argv[i], "--pipeline") == 0) {
+            pipelined = true;
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            output_hz = atof(argv[++i]);
+            pipelined = true;
+        } else if (strcmp(argv[i], "--rt-priority") == 0 && i + 1 < argc) {
+            rt_priority = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--score-candidates") == 0) {
+            score_candidates = true;
+        } else if (strcmp(argv[i], "--batch-fixes") == 0) {
+            batch_fixes = true;
+        } else if (strcmp(argv[i], "--fc-imu") == 0) {
+            fc_imu = true;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    vps_config_t cfg;
+    vps_config_defaults(&cfg);
+    if (access(config_path, R_OK) == 0 && !vps_config_load(&cfg, config_path)) {
+        fprintf(stderr, "vps: invalid config %s\n", config_path);
+        return 1;
+    }
+
+    if (fc_imu && (to_stdout || !cfg.uart.enabled || protocol != VPS_OUTPUT_MSP)) {
+        fprintf(stderr, "vps: --fc-imu needs the UART with --protocol msp\n");
+        return 2;
+    }
+
+    if (!replay_path) {
+        fprintf(stderr, "vps: no native matcher backend built; use --replay\n");
+        return 1;
+    }
+
+    vps_match_log_t log;
+    if (!vps_match_log_load(&log, replay_path)) {
+        fprintf(stderr, "vps: cannot load match log %s\n", replay_path);
+        return 1;
+    }
+    fprintf(stderr, "vps: replaying %d frames from %s\n", log.count, replay_path);
+
+    int fd = -1;
+    if (to_stdout) {
+        fd = STDOUT_FILENO;
+    } else if (cfg.uart.enabled) {
+        fd = open_uart(cfg.uart.port, cfg.uart.baudrate);
+        if (fd < 0) {
+            fprintf(stderr, "vps: cannot open %s: %s\n", cfg.uart.port, strerror(errno));
+            vps_match_log_free(&log);
+            return 1;
+        }
+        fprintf(stderr, "vps: UART open on %s @ %d baud\n", cfg.uart.port, cfg.uart.baudrate);
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    vps_runtime_t rt;
+    vps_runtime_init(&rt, &cfg, vps_match_log_source(&log),
+                     vps_match_log_matcher(&log), NULL);
+    rt.protocol = protocol;
+    rt.score_candidates = score_candidates;
+    rt.batch_fixes = batch_fixes;
+    if (fd >= 0) {
+        rt.write = fd_write;
+        rt.write_ctx = &fd;
+    }
+    static vps_imu_nav_t imu;
+    if (fc_imu) {
+        vps_imu_nav_init(&imu, NULL);
+        vps_runtime_attach_fc(&rt, &imu, fd_read, &fd);
+        log.restamp = true;  /* IMU replies are stamped with vps_monotonic_s() */
+    }
+
+    if (pipelined) {
+        vps_pipeline_config_t pc = vps_pipeline_default_config();
+        vps_output_thread_t ot;
+        if (output_hz > 0) {
+            vps_output_thread_config_t oc = vps_output_thread_default_config();
+            oc.rate_hz = output_hz;
+            oc.rt_priority = rt_priority;
+            log.restamp = true;  /* fixes must share the output thread's clock */
+            if (!vps_output_thread_start(&ot, &rt, &oc)) {
+                fprintf(stderr, "vps: cannot start output thread\n");
+                vps_match_log_free(&log);
+                return 1;
+            }
+            pc.output_thread = &ot;
+        }
+
+        vps_pipeline_t pipe;
+        if (!vps_pipeline_start(&pipe, &rt, &pc)) {
+            fprintf(stderr, "vps: cannot start pipeline\n");
+            if (output_hz > 0) vps_output_thread_stop(&ot);
+            vps_match_log_free(&log);
+            return 1;
+        }
+        while (g_running && !atomic_load(&pipe.stage_done[VPS_STAGE_OUTPUT]))
+            sleep_s(0.1);
+        if (g_running)
+            vps_pipeline_join(&pipe);
+        else
+            vps_pipeline_stop(&pipe);
+
+        vps_stage_stats_t st[VPS_STAGE_COUNT];
+        vps_pipeline_stats(&pipe, st);
+        for (int i = 0; i < VPS_STAGE_COUNT; i++) {
+            fprintf(stderr, "vps: %-9s processed=%llu dropped=%llu depth_max=%u "
+                            "wait=%.0fms block=%.0fms\n",
+                    vps_stage_name((vps_stage_t)i),
+                    (unsigned long long)st[i].processed,
+                    (unsigned long long)st[i].dropped, st[i].queue_max_depth,
+                    st[i].wait_ns / 1e6, st[i].block_ns / 1e6);
+        }
+        vps_pipeline_free(&pipe);
+
+        if (output_hz > 0) {
+            vps_output_thread_stop(&ot);
+            vps_output_stats_t os;
+            vps_output_thread_stats(&ot, &os);
+            fprintf(stderr, "vps: output %.0f Hz%s: %llu ticks, %llu missed, "
+                            "jitter mean=%.0fus max=%.0fus\n",
+                    output_hz, os.realtime ? " (SCHED_FIFO)" : "",
+                    (unsigned long long)os.ticks, (unsigned long long)os.missed_ticks,
+                    os.jitter_mean_ns / 1e3, os.jitter_max_ns / 1e3);
+        }
+    }
+
+    double period = cfg.target_hz > 0 ? 1.0 / cfg.target_hz : 0.0;
+    vps_step_result_t res;
+    while (g_running && !pipelined) {
+        double t0 = vps_monotonic_s();
+        if (!vps_runtime_step(&rt, &res)) break;
+
+        if (rt.frames % 100 == 0) {
+            fprintf(stderr, "vps: stats %u/%u fixes (%.0f%%), %.1f ms/frame\n",
+                    rt.fixes, rt.frames, 100.0 * rt.fixes / rt.frames, res.total_ms);
+        }
+
+        if (!fast) sleep_s(period - (vps_monotonic_s() - t0));
+    }
+
+    fprintf(stderr, "vps: shutdown. Total fixes: %u, misses: %u\n", rt.fixes, rt.misses);
+    if (fc_imu)
+        fprintf(stderr, "vps: FC IMU: %llu samples, %u bad replies\n",
+                (unsigned long long)imu.samples, rt.fc_parser.errors);
+    if (fd >= 0 && fd != STDOUT_FILENO) close(fd);
+    vps_match_log_free(&log);
+    return 0;
+}
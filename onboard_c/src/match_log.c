@@ -0,0 +1,140 @@
+/**
+ * @file match_log.c
+ * @brief Recorded frame set replay backend.
+ */
+#include "match_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LINE_MAX_LEN 1024
+#define FIELDS 18
+
+static bool parse_line(const char *line, vps_match_log_entry_t *e) {
+    double v[FIELDS];
+    const char *p = line;
+    for (int i = 0; i < FIELDS; i++) {
+        char *end;
+        v[i] = strtod(p, &end);
+        if (end == p) return false;
+        p = end;
+        if (i < FIELDS - 1) {
+            if (*p != ',') return false;
+            p++;
+        }
+    }
+
+    memset(e, 0, sizeof(*e));
+    e->t = v[0];
+    e->width = (int)v[1];
+    e->height = (int)v[2];
+    e->match.tile.z = (int)v[3];
+    e->match.tile.x = (int)v[4];
+    e->match.tile.y = (int)v[5];
+    e->match.num_matches = (int)v[6];
+    e->match.inlier_ratio = v[7];
+    e->match.confidence = v[8];
+    for (int i = 0; i < 9; i++) e->match.H[i] = v[9 + i];
+    return true;
+}
+
+bool vps_match_log_append(vps_match_log_t *log, const vps_match_log_entry_t *e) {
+    if (log->count == log->capacity) {
+        int cap = log->capacity ? log->capacity * 2 : 256;
+        vps_match_log_entry_t *p = realloc(log->entries, (size_t)cap * sizeof(*p));
+        if (!p) return false;
+        log->entries = p;
+        log->capacity = cap;
+    }
+    log->entries[log->count++] = *e;
+    return true;
+}
+
+bool vps_match_log_load(vps_match_log_t *log, const char *path) {
+    memset(log, 0, sizeof(*log));
+
+    FILE *fp = fopen(path, "r");
+    if (!fp) return false;
+
+    char line[LINE_MAX_LEN];
+    bool ok = true;
+    while (fgets(line, sizeof(line), fp)) {
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue;
+        if (strncmp(line, "t,", 2) == 0) continue;  /* header */
+
+        vps_match_log_entry_t e;
+        if (!parse_line(line, &e) || !vps_match_log_append(log, &e)) {
+            ok = false;
+            break;
+        }
+    }
+    fclose(fp);
+
+    if (!ok) vps_match_log_free(log);
+    return ok;
+}
+
+void vps_match_log_free(vps_match_log_t *log) {
+    free(log->entries);
+    memset(log, 0, sizeof(*log));
+}
+
+void vps_match_log_rewind(vps_match_log_t *log) {
+    log->cursor = 0;
+    log->t_offset = 0.0;
+}
+
+/* --- Backends --- */
+
+static bool log_grab(void *ctx, vps_frame_t *frame) {
+    vps_match_log_t *log = ctx;
+    if (log->count == 0) return false;
+    if (log->cursor >= log->count) {
+        if (!log->loop) return false;
+        /* Keep time monotonic across wraps for the EKF */
+        double span = log->entries[log->count - 1].t - log->entries[0].t;
+        log->t_offset += span + 1.0 / 3.0;
+        log->cursor = 0;
+    }
+
+    const vps_match_log_entry_t *e = &log->entries[log->cursor];
+    frame->pixels = NULL;
+    frame->width = e->width;
+    frame->height = e->height;
+    frame->stride = e->width;
+    frame->t = log->restamp ? vps_monotonic_s() : e->t + log->t_offset;
+    frame->seq = (uint32_t)log->cursor;
+    log->cursor++;
+    return true;
+}
+
+static int log_retrieve(void *ctx, const vps_frame_t *frame,
+                        vps_tile_coord_t *out, int max_out) {
+    vps_match_log_t *log = ctx;
+    if (max_out < 1 || frame->seq >= (uint32_t)log->count) return 0;
+    const vps_match_log_entry_t *e = &log->entries[frame->seq];
+    if (e->match.num_matches <= 0) return 0;
+    out[0] = e->match.tile;
+    return 1;
+}
+
+static bool log_match(void *ctx, const vps_frame_t *frame,
+                      vps_tile_coord_t tile, vps_match_t *out) {
+    vps_match_log_t *log = ctx;
+    (void)tile;
+    if (frame->seq >= (uint32_t)log->count) return false;
+    const vps_match_log_entry_t *e = &log->entries[frame->seq];
+    if (e->match.num_matches <= 0) return false;
+    *out = e->match;
+    return true;
+}
+
+vps_frame_source_t vps_match_log_source(vps_match_log_t *log) {
+    vps_frame_source_t s = {log, log_grab};
+    return s;
+}
+
+vps_matcher_t vps_match_log_matcher(vps_match_log_t *log) {
+    vps_matcher_t m = {log, log_retrieve, log_match};
+    return m;
+}
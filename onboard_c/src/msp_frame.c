@@ -0,0 +1,158 @@
+/**
+ * @file msp_frame.c
+ * @brief MSP framing, checksum and reply decoding, in integers only.
+ *
+ * Built into vps_fc without FP registers, so nothing here may use float
+ * or double.
+ */
+#include "msp.h"
+#include <string.h>
+
+uint8_t vps_msp_checksum(const uint8_t *data, size_t len) {
+    uint8_t cs = 0;
+    for (size_t i = 0; i < len; i++) {
+        cs ^= data[i];
+    }
+    return cs;
+}
+
+int vps_msp_encode(uint8_t *out, const vps_msp_gps_t *gps) {
+    /* Header: $M< */
+    out[0] = '$';
+    out[1] = 'M';
+    out[2] = '<';
+    out[3] = MSP_GPS_PAYLOAD;
+    out[4] = MSP_CMD_SET_RAW_GPS;
+
+    /* Payload (little-endian) */
+    uint8_t *p = &out[5];
+    p[0] = gps->fix_type;
+    p[1] = gps->num_sat;
+
+    /* lat (int32 LE) */
+    p[2] = (gps->lat >>  0) & 0xFF;
+    p[3] = (gps->lat >>  8) & 0xFF;
+    p[4] = (gps->lat >> 16) & 0xFF;
+    p[5] = (gps->lat >> 24) & 0xFF;
+
+    /* lon (int32 LE) */
+    p[6] = (gps->lon >>  0) & 0xFF;
+    p[7] = (gps->lon >>  8) & 0xFF;
+    p[8] = (gps->lon >> 16) & 0xFF;
+    p[9] = (gps->lon >> 24) & 0xFF;
+
+    /* altitude (int16 LE) */
+    p[10] = (gps->altitude_m >>  0) & 0xFF;
+    p[11] = (gps->altitude_m >>  8) & 0xFF;
+
+    /* speed (uint16 LE) */
+    p[12] = (gps->speed_cms >>  0) & 0xFF;
+    p[13] = (gps->speed_cms >>  8) & 0xFF;
+
+    /* heading (uint16 LE) */
+    p[14] = (gps->heading_deg10 >>  0) & 0xFF;
+    p[15] = (gps->heading_deg10 >>  8) & 0xFF;
+
+    /* hdop (uint16 LE) */
+    p[16] = (gps->hdop >>  0) & 0xFF;
+    p[17] = (gps->hdop >>  8) & 0xFF;
+
+    /* Checksum: XOR of [len, cmd, payload...] */
+    out[MSP_GPS_FRAME_SIZE - 1] = vps_msp_checksum(&out[3], MSP_GPS_PAYLOAD + 2);
+
+    return MSP_GPS_FRAME_SIZE;
+}
+
+int vps_msp_encode_request(uint8_t *out, uint8_t cmd) {
+    out[0] = '$';
+    out[1] = 'M';
+    out[2] = '<';
+    out[3] = 0;
+    out[4] = cmd;
+    out[5] = vps_msp_checksum(&out[3], 2);
+    return MSP_REQUEST_SIZE;
+}
+
+/* --- Reply parser --- */
+
+enum {
+    MSP_IDLE,
+    MSP_HEADER_M,
+    MSP_HEADER_DIR,
+    MSP_HEADER_LEN,
+    MSP_HEADER_CMD,
+    MSP_PAYLOAD,
+};
+
+void vps_msp_parser_init(vps_msp_parser_t *p) {
+    memset(p, 0, sizeof(*p));
+    p->state = MSP_IDLE;
+}
+
+bool vps_msp_parse_byte(vps_msp_parser_t *p, uint8_t byte) {
+    switch (p->state) {
+    case MSP_IDLE:
+        if (byte == '$') p->state = MSP_HEADER_M;
+        return false;
+    case MSP_HEADER_M:
+        p->state = byte == 'M' ? MSP_HEADER_DIR : MSP_IDLE;
+        return false;
+    case MSP_HEADER_DIR:
+        if (byte == '>') {
+            p->state = MSP_HEADER_LEN;
+        } else {
+            if (byte == '!') p->errors++;  /* FC rejected the request */
+            p->state = MSP_IDLE;
+        }
+        return false;
+    case MSP_HEADER_LEN:
+        p->len = byte;
+        p->cs = byte;
+        p->state = MSP_HEADER_CMD;
+        return false;
+    case MSP_HEADER_CMD:
+        p->cmd = byte;
+        p->cs ^= byte;
+        p->pos = 0;
+        p->state = MSP_PAYLOAD;
+        return false;
+    case MSP_PAYLOAD:
+        if (p->pos < p->len) {
+            p->payload[p->pos++] = byte;
+            p->cs ^= byte;
+            return false;
+        }
+        p->state = MSP_IDLE;
+        if (byte != p->cs) {
+            p->errors++;
+            return false;
+        }
+        p->frames++;
+        return true;
+    default:
+        p->state = MSP_IDLE;
+        return false;
+    }
+}
+
+static int16_t rd_i16(const uint8_t *b) {
+    return (int16_t)(uint16_t)(b[0] | (b[1] << 8));
+}
+
+bool vps_msp_decode_raw_imu(const uint8_t *payload, size_t len, vps_msp_raw_imu_t *out) {
+    if (len < MSP_RAW_IMU_PAYLOAD) return false;
+    for (int i = 0; i < 3; i++) {
+        out->acc[i] = rd_i16(payload + 2 * i);
+        out->gyro[i] = rd_i16(payload + 6 + 2 * i);
+        out->mag[i] = rd_i16(payload + 12 + 2 * i);
+    }
+    return true;
+}
+
+bool vps_msp_decode_attitude(const uint8_t *payload, size_t len, vps_msp_attitude_t *out) {
+    if (len < MSP_ATTITUDE_PAYLOAD) return false;
+    out->roll_deg10 = rd_i16(payload);
+    out->pitch_deg10 = rd_i16(payload + 2);
+    out->yaw_deg = rd_i16(payload + 4);
+    return true;
+}
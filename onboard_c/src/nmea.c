@@ -87,3 +87,141 @@ int vps_format_rmc(char *buf, size_t buflen,
 
     return snprintf(buf, buflen, "$%s*%02X\r\n", body, cs);
 }
+
+/* --- stdio-free encoders --- */
+
+void vps_nmea_time_set(vps_nmea_time_t *t, time_t sec) {
+    if (t->sec == sec) return;
+    struct tm utc;
+    gmtime_r(&sec, &utc);
+    int f[6] = {utc.tm_hour, utc.tm_min, utc.tm_sec,
+                utc.tm_mday, utc.tm_mon + 1, utc.tm_year % 100};
+    for (int i = 0; i < 3; i++) {
+        t->hms[2 * i] = (char)('0' + f[i] / 10);
+        t->hms[2 * i + 1] = (char)('0' + f[i] % 10);
+        t->dmy[2 * i] = (char)('0' + f[3 + i] / 10);
+        t->dmy[2 * i + 1] = (char)('0' + f[3 + i] % 10);
+    }
+    t->sec = sec;
+}
+
+static double clamp_field(double x, double lim) {
+    if (!(x == x)) return 0.0;
+    return x > lim ? lim : (x < -lim ? -lim : x);
+}
+
+/*
+ * x * scale rounded as printf does: to nearest, exact ties to even. A
+ * product that lands on .5 is resolved with its exact residual; any
+ * other fraction is at least one ulp from .5, beyond the product error.
+ */
+static uint64_t round_scaled(double x, double scale) {
+    double p = x * scale;
+    double r = floor(p);
+    double frac = p - r;
+    uint64_t u = (uint64_t)r;
+    if (frac > 0.5) {
+        u++;
+    } else if (frac == 0.5) {
+        double e = fma(x, scale, -p);
+        if (e > 0.0 || (e == 0.0 && (u & 1))) u++;
+    }
+    return u;
+}
+
+/* Decimal v, zero-padded to at least width digits */
+static char *put_uint(char *p, uint64_t v, int width) {
+    char tmp[20];
+    int n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n < width) tmp[n++] = '0';
+    while (n) *p++ = tmp[--n];
+    return p;
+}
+
+/* %.1f */
+static char *put_fixed1(char *p, double x) {
+    if (signbit(x)) *p++ = '-';
+    uint64_t v = round_scaled(fabs(x), 10.0);
+    p = put_uint(p, v / 10, 1);
+    *p++ = '.';
+    *p++ = (char)('0' + v % 10);
+    return p;
+}
+
+/* As deg_to_nmea: degrees (2 or 3 digits), minutes %08.5f, then ",N," */
+static char *put_coord(char *p, double deg, int is_lon) {
+    double abs_deg = fabs(clamp_field(deg, 999.0));
+    int d = (int)abs_deg;
+    double m = (abs_deg - d) * 60.0;
+    uint64_t m5 = round_scaled(m, 1e5);
+    p = put_uint(p, (uint64_t)d, is_lon ? 3 : 2);
+    p = put_uint(p, m5 / 100000, 2);
+    *p++ = '.';
+    p = put_uint(p, m5 % 100000, 5);
+    *p++ = ',';
+    *p++ = is_lon ? (deg >= 0 ? 'E' : 'W') : (deg >= 0 ? 'N' : 'S');
+    *p++ = ',';
+    return p;
+}
+
+static char *put_str(char *p, const char *s, size_t n) {
+    memcpy(p, s, n);
+    return p + n;
+}
+
+static size_t finish_sentence(char *buf, char *p) {
+    static const char hex[] = "0123456789ABCDEF";
+    uint8_t cs = 0;
+    for (const char *c = buf + 1; c < p; c++) cs ^= (uint8_t)*c;
+    *p++ = '*';
+    *p++ = hex[cs >> 4];
+    *p++ = hex[cs & 15];
+    *p++ = '\r';
+    *p++ = '\n';
+    return (size_t)(p - buf);
+}
+
+size_t vps_nmea_write_gga(char *buf, const vps_nmea_time_t *utc,
+                          vps_geopoint_t pos, int fix_quality,
+                          double hdop, double altitude) {
+    char *p = put_str(buf, "$GPGGA,", 7);
+    p = put_str(p, utc->hms, 6);
+    p = put_str(p, ".00,", 4);
+    p = put_coord(p, pos.lat, 0);
+    p = put_coord(p, pos.lon, 1);
+    if (fix_quality < 0) {
+        *p++ = '-';
+        p = put_uint(p, (uint64_t)-(int64_t)fix_quality, 1);
+    } else {
+        p = put_uint(p, (uint64_t)fix_quality, 1);
+    }
+    p = put_str(p, ",08,", 4);
+    p = put_fixed1(p, clamp_field(hdop, 999.9));
+    *p++ = ',';
+    p = put_fixed1(p, clamp_field(altitude, 99999.9));
+    p = put_str(p, ",M,0.0,M,,", 10);
+    return finish_sentence(buf, p);
+}
+
+size_t vps_nmea_write_rmc(char *buf, const vps_nmea_time_t *utc,
+                          vps_geopoint_t pos, bool active,
+                          double speed_knots, double heading_deg) {
+    char *p = put_str(buf, "$GPRMC,", 7);
+    p = put_str(p, utc->hms, 6);
+    p = put_str(p, ".00,", 4);
+    *p++ = active ? 'A' : 'V';
+    *p++ = ',';
+    p = put_coord(p, pos.lat, 0);
+    p = put_coord(p, pos.lon, 1);
+    p = put_fixed1(p, clamp_field(speed_knots, 9999.9));
+    *p++ = ',';
+    p = put_fixed1(p, clamp_field(heading_deg, 9999.9));
+    *p++ = ',';
+    p = put_str(p, utc->dmy, 6);
+    p = put_str(p, ",,,A", 4);
+    return finish_sentence(buf, p);
+}
@@ -0,0 +1,97 @@
+/**
+ * @file output_ring.c
+ * @brief SPSC byte ring for serial output.
+ */
+#include "output_ring.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool vps_out_ring_init(vps_out_ring_t *r, uint32_t capacity) {
+    uint32_t cap = VPS_OUT_RING_SPILL;
+    while (cap < capacity) cap <<= 1;
+
+    r->buf = malloc((size_t)cap + VPS_OUT_RING_SPILL);
+    if (!r->buf) return false;
+
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    r->capacity = cap;
+    r->mask = cap - 1;
+    return true;
+}
+
+void vps_out_ring_free(vps_out_ring_t *r) {
+    free(r->buf);
+    r->buf = NULL;
+}
+
+uint8_t *vps_out_ring_reserve(vps_out_ring_t *r, size_t n) {
+    uint32_t t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint32_t h = atomic_load_explicit(&r->head, memory_order_acquire);
+    if (n > VPS_OUT_RING_SPILL || r->capacity - (t - h) < n) return NULL;
+    return r->buf + (t & r->mask);
+}
+
+void vps_out_ring_commit(vps_out_ring_t *r, size_t n) {
+    uint32_t t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint32_t off = t & r->mask;
+    /* Bytes written past the end belong at the front (free, as reserved) */
+    if (off + n > r->capacity)
+        memcpy(r->buf, r->buf + r->capacity, off + n - r->capacity);
+    atomic_store_explicit(&r->tail, t + (uint32_t)n, memory_order_release);
+}
+
+bool vps_out_ring_write(vps_out_ring_t *r, const uint8_t *data, size_t len) {
+    uint32_t t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint32_t h = atomic_load_explicit(&r->head, memory_order_acquire);
+    if (r->capacity - (t - h) < len) return false;
+    uint32_t off = t & r->mask;
+    size_t first = r->capacity - off < len ? r->capacity - off : len;
+    memcpy(r->buf + off, data, first);
+    memcpy(r->buf, data + first, len - first);
+    atomic_store_explicit(&r->tail, t + (uint32_t)len, memory_order_release);
+    return true;
+}
+
+size_t vps_out_ring_peek(const vps_out_ring_t *r, const uint8_t **data) {
+    uint32_t h = atomic_load_explicit(&r->head, memory_order_relaxed);
+    uint32_t t = atomic_load_explicit(&r->tail, memory_order_acquire);
+    uint32_t off = h & r->mask;
+    size_t n = t - h;
+    if (n > r->capacity - off) n = r->capacity - off;
+    *data = r->buf + off;
+    return n;
+}
+
+void vps_out_ring_consume(vps_out_ring_t *r, size_t n) {
+    uint32_t h = atomic_load_explicit(&r->head, memory_order_relaxed);
+    atomic_store_explicit(&r->head, h + (uint32_t)n, memory_order_release);
+}
+
+size_t vps_out_ring_read(vps_out_ring_t *r, uint8_t *dst, size_t max) {
+    size_t total = 0;
+    while (total < max) {
+        const uint8_t *p;
+        size_t n = vps_out_ring_peek(r, &p);
+        if (n == 0) break;
+        if (n > max - total) n = max - total;
+        memcpy(dst + total, p, n);
+        vps_out_ring_consume(r, n);
+        total += n;
+    }
+    return total;
+}
+
+uint32_t vps_out_ring_used(const vps_out_ring_t *r) {
+    return atomic_load_explicit(&r->tail, memory_order_acquire) -
+           atomic_load_explicit(&r->head, memory_order_acquire);
+}
+
+void vps_fusion_sink_init(vps_fusion_sink_t *s, vps_out_ring_t *ring, unsigned protocols) {
+    s->ring = ring;
+    s->protocols = protocols;
+    memset(&s->utc, 0, sizeof(s->utc));
+    s->utc.sec = -1;
+    s->emitted = 0;
+    s->dropped = 0;
+}
@@ -0,0 +1,216 @@
+/**
+ * @file output_thread.c
+ * @brief Fixed-rate fusion/output thread.
+ */
+#include "output_thread.h"
+#include <errno.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAILBOX_FRESH 4u
+
+/* --- Mailbox --- */
+
+void vps_fix_mailbox_init(vps_fix_mailbox_t *mb) {
+    memset(mb->slots, 0, sizeof(mb->slots));
+    atomic_init(&mb->state, 1u);
+    mb->back = 0;
+    mb->front = 2;
+    atomic_init(&mb->posted, 0);
+    atomic_init(&mb->overwritten, 0);
+}
+
+bool vps_fix_mailbox_post(vps_fix_mailbox_t *mb, const vps_visual_fix_t *fix) {
+    mb->slots[mb->back] = *fix;
+    uint32_t prev = atomic_exchange_explicit(&mb->state, mb->back | MAILBOX_FRESH,
+                                             memory_order_acq_rel);
+    mb->back = prev & 3u;
+    atomic_fetch_add_explicit(&mb->posted, 1, memory_order_relaxed);
+    if (prev & MAILBOX_FRESH) {
+        atomic_fetch_add_explicit(&mb->overwritten, 1, memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool vps_fix_mailbox_take(vps_fix_mailbox_t *mb, vps_visual_fix_t *out) {
+    if (!(atomic_load_explicit(&mb->state, memory_order_relaxed) & MAILBOX_FRESH))
+        return false;
+    uint32_t prev = atomic_exchange_explicit(&mb->state, mb->front,
+                                             memory_order_acq_rel);
+    mb->front = prev & 3u;
+    *out = mb->slots[mb->front];
+    return true;
+}
+
+/* --- Tick --- */
+
+vps_fusion_output_t vps_output_tick(vps_fusion_t *f, const vps_visual_fix_t *fix, double t) {
+    if (!fix) return vps_fusion_update(f, NULL, 0.0, t);
+    if (fix->n > 1 && fix->batch)
+        return vps_fusion_update_batch(f, fix->fix_position, fix->fix_hdop, fix->n, t);
+    if (fix->n > 1) {
+        int i = vps_fusion_select(f, fix->fix_position, fix->fix_hdop, fix->n, fix->t, NULL);
+        if (i < 0) i = 0;
+        return vps_fusion_update_delayed(f, &fix->fix_position[i], fix->fix_hdop[i], fix->t, t);
+    }
+    return vps_fusion_update_delayed(f, &fix->position, fix->hdop, fix->t, t);
+}
+
+/* --- Thread --- */
+
+static uint64_t ts_to_ns(const struct timespec *ts) {
+    return (uint64_t)ts->tv_sec * 1000000000ull + (uint64_t)ts->tv_nsec;
+}
+
+static struct timespec ns_to_ts(uint64_t ns) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ns / 1000000000ull);
+    ts.tv_nsec = (long)(ns % 1000000000ull);
+    return ts;
+}
+
+static int jitter_bucket(uint64_t ns) {
+    uint64_t us = ns / 1000;
+    int b = 0;
+    while (us > 0 && b < VPS_JITTER_BUCKETS - 1) {
+        us >>= 1;
+        b++;
+    }
+    return b;
+}
+
+static void record_jitter(vps_output_thread_t *ot, uint64_t ns) {
+    atomic_fetch_add_explicit(&ot->hist[jitter_bucket(ns)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&ot->jitter_sum_ns, ns, memory_order_relaxed);
+    if (ns > atomic_load_explicit(&ot->jitter_max_ns, memory_order_relaxed))
+        atomic_store_explicit(&ot->jitter_max_ns, ns, memory_order_relaxed);
+}
+
+static void *output_main(void *arg) {
+    vps_output_thread_t *ot = arg;
+
+    if (ot->cfg.rt_priority > 0) {
+        struct sched_param sp = {.sched_priority = ot->cfg.rt_priority};
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp) == 0)
+            atomic_store(&ot->realtime, true);
+    }
+
+    uint64_t period_ns = (uint64_t)(1e9 / ot->cfg.rate_hz);
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t deadline = ts_to_ns(&now) + period_ns;
+
+    struct itimerspec its;
+    its.it_value = ns_to_ts(deadline);
+    its.it_interval = ns_to_ts(period_ns);
+    if (timerfd_settime(ot->timer_fd, TFD_TIMER_ABSTIME, &its, NULL) != 0)
+        return NULL;
+
+    while (!atomic_load_explicit(&ot->stop, memory_order_acquire)) {
+        uint64_t expirations;
+        ssize_t n = read(ot->timer_fd, &expirations, sizeof(expirations));
+        if (n != (ssize_t)sizeof(expirations)) {
+            if (n < 0 && errno == EINTR) continue;
+            break;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        uint64_t wake = ts_to_ns(&now);
+
+        /* Deadline of the latest expiration; earlier ones were missed */
+        deadline += (expirations - 1) * period_ns;
+        record_jitter(ot, wake > deadline ? wake - deadline : 0);
+        if (expirations > 1)
+            atomic_fetch_add_explicit(&ot->missed_ticks, expirations - 1,
+                                      memory_order_relaxed);
+        deadline += period_ns;
+
+        vps_runtime_read_fc(ot->rt);
+        vps_visual_fix_t fix;
+        bool have_fix = vps_fix_mailbox_take(&ot->mailbox, &fix);
+        double t = (double)wake * 1e-9;
+        vps_fusion_output_t out = vps_output_tick(&ot->rt->fusion,
+                                                  have_fix ? &fix : NULL, t);
+        if (have_fix)
+            atomic_fetch_add_explicit(&ot->fixes_applied, 1, memory_order_relaxed);
+
+        vps_runtime_emit(ot->rt, &out);
+        vps_runtime_request_fc(ot->rt);
+        if (ot->cfg.publish)
+            vps_fusion_publish(ot->cfg.publish, &ot->rt->fusion, &out, t);
+        if (ot->cfg.on_output)
+            ot->cfg.on_output(ot->cfg.on_output_ctx, &out, t);
+        atomic_fetch_add_explicit(&ot->ticks, 1, memory_order_relaxed);
+    }
+    return NULL;
+}
+
+/* --- Public API --- */
+
+vps_output_thread_config_t vps_output_thread_default_config(void) {
+    vps_output_thread_config_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.rate_hz = 20.0;
+    return cfg;
+}
+
+bool vps_output_thread_start(vps_output_thread_t *ot, vps_runtime_t *rt,
+                             const vps_output_thread_config_t *cfg) {
+    memset(ot, 0, sizeof(*ot));
+    ot->rt = rt;
+    ot->cfg = cfg ? *cfg : vps_output_thread_default_config();
+    if (ot->cfg.rate_hz <= 0) ot->cfg.rate_hz = 20.0;
+
+    vps_fix_mailbox_init(&ot->mailbox);
+    atomic_init(&ot->stop, false);
+    atomic_init(&ot->ticks, 0);
+    atomic_init(&ot->missed_ticks, 0);
+    atomic_init(&ot->fixes_applied, 0);
+    atomic_init(&ot->jitter_sum_ns, 0);
+    atomic_init(&ot->jitter_max_ns, 0);
+    for (int i = 0; i < VPS_JITTER_BUCKETS; i++) atomic_init(&ot->hist[i], 0);
+    atomic_init(&ot->realtime, false);
+
+    ot->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (ot->timer_fd < 0) return false;
+
+    if (pthread_create(&ot->thread, NULL, output_main, ot) != 0) {
+        close(ot->timer_fd);
+        ot->timer_fd = -1;
+        return false;
+    }
+    ot->running = true;
+    return true;
+}
+
+void vps_output_thread_post(vps_output_thread_t *ot, const vps_visual_fix_t *fix) {
+    vps_fix_mailbox_post(&ot->mailbox, fix);
+}
+
+void vps_output_thread_stop(vps_output_thread_t *ot) {
+    if (!ot->running) return;
+    /* The thread notices the flag on its next tick (<= one period) */
+    atomic_store_explicit(&ot->stop, true, memory_order_release);
+    pthread_join(ot->thread, NULL);
+    close(ot->timer_fd);
+    ot->timer_fd = -1;
+    ot->running = false;
+}
+
+void vps_output_thread_stats(const vps_output_thread_t *ot, vps_output_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->ticks = atomic_load_explicit(&ot->ticks, memory_order_relaxed);
+    out->missed_ticks = atomic_load_explicit(&ot->missed_ticks, memory_order_relaxed);
+    out->fixes_applied = atomic_load_explicit(&ot->fixes_applied, memory_order_relaxed);
+    out->fixes_overwritten = atomic_load_explicit(&ot->mailbox.overwritten,
+                                                  memory_order_relaxed);
+    out->jitter_max_ns = atomic_load_explicit(&ot->jitter_max_ns, memory_order_relaxed);
+    uint64_t sum = atomic_load_explicit(&ot->jitter_sum_ns, memory_order_relaxed);
+    out->jitter_mean_ns = out->ticks ? (double)sum / (double)out->ticks : 0.0;
+    for (int i = 0; i < VPS_JITTER_BUCKETS; i++)
+        out->hist[i] = atomic_load_explicit(&ot->hist[i], memory_order_relaxed);
+    out->realtime = atomic_load_explicit(&ot->realtime, memory_order_relaxed);
+}
@@ -0,0 +1,404 @@
+/**
+ * @file pipeline.c
+ * @brief Multi-stage pipelined runtime.
+ */
+#include "pipeline.h"
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NO_SLOT UINT32_MAX
+
+/* --- Queue items --- */
+
+typedef struct {
+    vps_frame_t frame;
+    uint32_t slot;      /* pool slot holding pixels, NO_SLOT if none */
+} frame_item_t;
+
+typedef struct {
+    frame_item_t f;
+    vps_tile_coord_t candidates[VPS_RUNTIME_MAX_CANDIDATES];
+    int n;
+    double retrieval_ms;
+} retrieval_item_t;
+
+typedef struct {
+    vps_frame_t frame;
+    vps_locate_result_t loc;
+} locate_item_t;
+
+typedef struct {
+    vps_fusion_output_t out;
+    double t_capture;
+    uint32_t seq;
+} output_item_t;
+
+static const size_t item_size[VPS_PIPE_QUEUES] = {
+    sizeof(frame_item_t),
+    sizeof(retrieval_item_t),
+    sizeof(locate_item_t),
+    sizeof(output_item_t),
+};
+
+/* --- Helpers --- */
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/** Spin briefly, then yield, then sleep: stages idle for 100s of ms. */
+static void backoff(unsigned *spins) {
+    if (*spins < 64) {
+        (*spins)++;
+    } else if (*spins < 128) {
+        (*spins)++;
+        sched_yield();
+    } else {
+        struct timespec ts = {0, 50000};
+        nanosleep(&ts, NULL);
+    }
+}
+
+static bool is_stopping(const vps_pipeline_t *p) {
+    return atomic_load_explicit(&p->stop, memory_order_acquire);
+}
+
+/** Pop from stage's input queue, waiting. @return false at end of stream */
+static bool stage_pop(vps_pipeline_t *p, vps_stage_t stage, void *item) {
+    vps_spsc_queue_t *q = &p->queues[stage - 1];
+    uint64_t t0 = now_ns();
+    unsigned spins = 0;
+    bool ok = false;
+    for (;;) {
+        if (vps_spsc_pop(q, item)) {
+            ok = true;
+            break;
+        }
+        if (is_stopping(p)) break;
+        if (atomic_load_explicit(&p->stage_done[stage - 1], memory_order_acquire)) {
+            /* Upstream finished: one last look for items pushed before it exited */
+            ok = vps_spsc_pop(q, item);
+            break;
+        }
+        backoff(&spins);
+    }
+    atomic_fetch_add_explicit(&p->counters[stage].wait_ns, now_ns() - t0,
+                              memory_order_relaxed);
+    return ok;
+}
+
+/** Push to stage's output queue per policy. @return false if stopping */
+static bool stage_push(vps_pipeline_t *p, vps_stage_t stage, const void *item,
+                       void *evicted, bool *did_evict) {
+    vps_spsc_queue_t *q = &p->queues[stage];
+    if (did_evict) *did_evict = false;
+
+    if (p->cfg.queue_policy[stage] == VPS_QUEUE_LATEST) {
+        bool ev = vps_spsc_push_latest(q, item, evicted);
+        if (did_evict) *did_evict = ev;
+        return true;
+    }
+
+    uint64_t t0 = now_ns();
+    unsigned spins = 0;
+    while (!vps_spsc_try_push(q, item)) {
+        if (is_stopping(p)) return false;
+        backoff(&spins);
+    }
+    atomic_fetch_add_explicit(&p->counters[stage].block_ns, now_ns() - t0,
+                              memory_order_relaxed);
+    return true;
+}
+
+static void count_work(vps_pipeline_t *p, vps_stage_t stage, uint64_t t0) {
+    atomic_fetch_add_explicit(&p->counters[stage].busy_ns, now_ns() - t0,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&p->counters[stage].processed, 1,
+                              memory_order_relaxed);
+}
+
+/* --- Frame pool --- */
+
+static uint32_t pool_acquire(vps_pipeline_t *p) {
+    _Atomic bool *busy = p->pool_busy;
+    unsigned spins = 0;
+    for (;;) {
+        for (uint32_t i = 0; i < p->pool_size; i++) {
+            if (!atomic_load_explicit(&busy[i], memory_order_acquire)) {
+                atomic_store_explicit(&busy[i], true, memory_order_relaxed);
+                return i;
+            }
+        }
+        if (is_stopping(p)) return NO_SLOT;
+        backoff(&spins);
+    }
+}
+
+static void pool_release(vps_pipeline_t *p, uint32_t slot) {
+    if (slot != NO_SLOT)
+        atomic_store_explicit(&p->pool_busy[slot], false, memory_order_release);
+}
+
+/** Copy the grabbed frame into a pool slot (source buffers are reused). */
+static bool pool_copy(vps_pipeline_t *p, frame_item_t *fi) {
+    fi->slot = NO_SLOT;
+    if (!fi->frame.pixels) return true;
+
+    uint32_t slot = pool_acquire(p);
+    if (slot == NO_SLOT) return false;
+
+    size_t row = (size_t)fi->frame.width;
+    size_t need = row * (size_t)fi->frame.height;
+    if (p->pool_len[slot] < need) {
+        uint8_t *buf = realloc(p->pool[slot], need);
+        if (!buf) {
+            pool_release(p, slot);
+            return false;
+        }
+        p->pool[slot] = buf;
+        p->pool_len[slot] = need;
+    }
+    for (int y = 0; y < fi->frame.height; y++)
+        memcpy(p->pool[slot] + (size_t)y * row,
+               fi->frame.pixels + (size_t)y * (size_t)fi->frame.stride, row);
+
+    fi->frame.pixels = p->pool[slot];
+    fi->frame.stride = fi->frame.width;
+    fi->slot = slot;
+    return true;
+}
+
+/* --- Stages --- */
+
+static void run_capture(vps_pipeline_t *p) {
+    vps_runtime_t *rt = p->rt;
+    while (!is_stopping(p)) {
+        frame_item_t fi, evicted;
+        if (!rt->source.grab(rt->source.ctx, &fi.frame)) break;
+
+        uint64_t t0 = now_ns();
+        rt->frames++;
+        if (!pool_copy(p, &fi)) break;
+
+        bool did_evict;
+        if (!stage_push(p, VPS_STAGE_CAPTURE, &fi, &evicted, &did_evict)) break;
+        if (did_evict) pool_release(p, evicted.slot);
+        count_work(p, VPS_STAGE_CAPTURE, t0);
+    }
+}
+
+static void run_retrieval(vps_pipeline_t *p) {
+    retrieval_item_t ri;
+    while (stage_pop(p, VPS_STAGE_RETRIEVAL, &ri.f)) {
+        uint64_t t0 = now_ns();
+        ri.n = vps_runtime_retrieve(p->rt, &ri.f.frame, ri.candidates);
+        ri.retrieval_ms = (double)(now_ns() - t0) / 1e6;
+        count_work(p, VPS_STAGE_RETRIEVAL, t0);
+
+        if (!stage_push(p, VPS_STAGE_RETRIEVAL, &ri, NULL, NULL)) {
+            pool_release(p, ri.f.slot);
+            break;
+        }
+    }
+}
+
+static void run_match(vps_pipeline_t *p) {
+    retrieval_item_t ri;
+    locate_item_t li;
+    while (stage_pop(p, VPS_STAGE_MATCH, &ri)) {
+        uint64_t t0 = now_ns();
+        li.frame = ri.f.frame;
+        vps_runtime_match(p->rt, &ri.f.frame, ri.candidates, ri.n, &li.loc);
+        li.loc.retrieval_ms = ri.retrieval_ms;
+        li.frame.pixels = NULL;  /* pixels are not needed past matching */
+        pool_release(p, ri.f.slot);
+        count_work(p, VPS_STAGE_MATCH, t0);
+
+        if (!stage_push(p, VPS_STAGE_MATCH, &li, NULL, NULL)) break;
+    }
+}
+
+static void run_fusion(vps_pipeline_t *p) {
+    vps_runtime_t *rt = p->rt;
+    locate_item_t li;
+    output_item_t oi;
+    while (stage_pop(p, VPS_STAGE_FUSION, &li)) {
+        uint64_t t0 = now_ns();
+        if (li.loc.has_fix)
+            rt->fixes++;
+        else
+            rt->misses++;
+
+        /* rt->fusion belongs to the output thread: it selects or batches the candidates */
+        if (p->cfg.output_thread) {
+            if (li.loc.has_fix) {
+                vps_visual_fix_t fix = {.position = li.loc.position, .hdop = li.loc.hdop,
+                                        .t = li.frame.t, .seq = li.frame.seq,
+                                        .n = li.loc.n_fixes, .batch = rt->batch_fixes};
+                for (int i = 0; i < li.loc.n_fixes; i++) {
+                    fix.fix_position[i] = li.loc.fix_position[i];
+                    fix.fix_hdop[i] = li.loc.fix_hdop[i];
+                }
+                vps_output_thread_post(p->cfg.output_thread, &fix);
+            }
+            count_work(p, VPS_STAGE_FUSION, t0);
+            continue;
+        }
+
+        vps_runtime_read_fc(rt);
+        vps_runtime_select_fix(rt, &li.loc, li.frame.t);
+        oi.out = vps_runtime_fuse(rt, &li.loc, li.frame.t);
+        oi.t_capture = li.frame.t;
+        oi.seq = li.frame.seq;
+        count_work(p, VPS_STAGE_FUSION, t0);
+
+        if (!stage_push(p, VPS_STAGE_FUSION, &oi, NULL, NULL)) break;
+    }
+}
+
+static void run_output(vps_pipeline_t *p) {
+    output_item_t oi;
+    while (stage_pop(p, VPS_STAGE_OUTPUT, &oi)) {
+        uint64_t t0 = now_ns();
+        vps_runtime_emit(p->rt, &oi.out);
+        vps_runtime_request_fc(p->rt);
+        if (p->cfg.on_output)
+            p->cfg.on_output(p->cfg.on_output_ctx, &oi.out, oi.t_capture, oi.seq);
+        count_work(p, VPS_STAGE_OUTPUT, t0);
+    }
+}
+
+static void *stage_main(void *arg) {
+    vps_stage_arg_t *a = arg;
+    vps_pipeline_t *p = a->pipe;
+    switch (a->stage) {
+    case VPS_STAGE_CAPTURE: run_capture(p); break;
+    case VPS_STAGE_RETRIEVAL: run_retrieval(p); break;
+    case VPS_STAGE_MATCH: run_match(p); break;
+    case VPS_STAGE_FUSION: run_fusion(p); break;
+    case VPS_STAGE_OUTPUT: run_output(p); break;
+    default: break;
+    }
+    atomic_store_explicit(&p->stage_done[a->stage], true, memory_order_release);
+    return NULL;
+}
+
+/* --- Public API --- */
+
+vps_pipeline_config_t vps_pipeline_default_config(void) {
+    vps_pipeline_config_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    for (int i = 0; i < VPS_PIPE_QUEUES; i++) {
+        cfg.queue_capacity[i] = 4;
+        cfg.queue_policy[i] = VPS_QUEUE_BLOCK;
+    }
+    cfg.queue_capacity[VPS_STAGE_CAPTURE] = 2;
+    cfg.queue_policy[VPS_STAGE_CAPTURE] = VPS_QUEUE_LATEST;
+    return cfg;
+}
+
+static void release_all(vps_pipeline_t *p) {
+    for (int i = 0; i < VPS_PIPE_QUEUES; i++) vps_spsc_free(&p->queues[i]);
+    if (p->pool) {
+        for (uint32_t i = 0; i < p->pool_size; i++) free(p->pool[i]);
+    }
+    free(p->pool);
+    free(p->pool_len);
+    free((void *)p->pool_busy);
+    p->pool = NULL;
+    p->pool_len = NULL;
+    p->pool_busy = NULL;
+}
+
+bool vps_pipeline_start(vps_pipeline_t *p, vps_runtime_t *rt,
+                        const vps_pipeline_config_t *cfg) {
+    memset(p, 0, sizeof(*p));
+    p->rt = rt;
+    p->cfg = cfg ? *cfg : vps_pipeline_default_config();
+
+    for (int i = 0; i < VPS_PIPE_QUEUES; i++) {
+        if (p->cfg.queue_capacity[i] == 0) p->cfg.queue_capacity[i] = 1;
+        if (!vps_spsc_init(&p->queues[i], p->cfg.queue_capacity[i], item_size[i])) {
+            release_all(p);
+            return false;
+        }
+    }
+    for (int i = 0; i < VPS_STAGE_COUNT; i++) {
+        atomic_init(&p->counters[i].processed, 0);
+        atomic_init(&p->counters[i].wait_ns, 0);
+        atomic_init(&p->counters[i].block_ns, 0);
+        atomic_init(&p->counters[i].busy_ns, 0);
+        atomic_init(&p->stage_done[i], false);
+    }
+    atomic_init(&p->stop, false);
+
+    /* Frames with pixels live in the capture and retrieval queues plus
+     * one each in capture, retrieval and matching. */
+    p->pool_size = p->queues[0].capacity + p->queues[1].capacity + 3;
+    p->pool = calloc(p->pool_size, sizeof(*p->pool));
+    p->pool_len = calloc(p->pool_size, sizeof(*p->pool_len));
+    p->pool_busy = malloc(p->pool_size * sizeof(*p->pool_busy));
+    if (!p->pool || !p->pool_len || !p->pool_busy) {
+        release_all(p);
+        return false;
+    }
+    for (uint32_t i = 0; i < p->pool_size; i++) atomic_init(&p->pool_busy[i], false);
+
+    for (int i = 0; i < VPS_STAGE_COUNT; i++) {
+        p->args[i].pipe = p;
+        p->args[i].stage = (vps_stage_t)i;
+        if (pthread_create(&p->threads[i], NULL, stage_main, &p->args[i]) != 0) {
+            atomic_store(&p->stop, true);
+            for (int j = 0; j < i; j++) pthread_join(p->threads[j], NULL);
+            release_all(p);
+            return false;
+        }
+    }
+    p->running = true;
+    return true;
+}
+
+void vps_pipeline_join(vps_pipeline_t *p) {
+    if (!p->running) return;
+    for (int i = 0; i < VPS_STAGE_COUNT; i++) pthread_join(p->threads[i], NULL);
+    p->running = false;
+}
+
+void vps_pipeline_stop(vps_pipeline_t *p) {
+    atomic_store_explicit(&p->stop, true, memory_order_release);
+    vps_pipeline_join(p);
+}
+
+void vps_pipeline_free(vps_pipeline_t *p) {
+    if (p->running) vps_pipeline_stop(p);
+    release_all(p);
+}
+
+void vps_pipeline_stats(const vps_pipeline_t *p, vps_stage_stats_t out[VPS_STAGE_COUNT]) {
+    for (int i = 0; i < VPS_STAGE_COUNT; i++) {
+        const vps_stage_counters_t *c = &p->counters[i];
+        vps_stage_stats_t *s = &out[i];
+        memset(s, 0, sizeof(*s));
+        s->processed = atomic_load_explicit(&c->processed, memory_order_relaxed);
+        s->wait_ns = atomic_load_explicit(&c->wait_ns, memory_order_relaxed);
+        s->block_ns = atomic_load_explicit(&c->block_ns, memory_order_relaxed);
+        s->busy_ns = atomic_load_explicit(&c->busy_ns, memory_order_relaxed);
+        if (i > 0 && p->queues[i - 1].slots) {
+            const vps_spsc_queue_t *q = &p->queues[i - 1];
+            s->dropped = atomic_load_explicit(&q->dropped, memory_order_relaxed);
+            s->queue_depth = vps_spsc_depth(q);
+            s->queue_max_depth = atomic_load_explicit(&q->max_depth, memory_order_relaxed);
+        }
+    }
+}
+
+const char *vps_stage_name(vps_stage_t stage) {
+    static const char *names[VPS_STAGE_COUNT] = {
+        "capture", "retrieval", "match", "fusion", "output",
+    };
+    return (stage >= 0 && stage < VPS_STAGE_COUNT) ? names[stage] : "?";
+}
@@ -0,0 +1,214 @@
+/**
+ * @file runtime.c
+ * @brief Native positioning loop.
+ */
+#include "runtime.h"
+#include "geo_transform.h"
+#include "msp.h"
+#include "nmea.h"
+#include <time.h>
+
+#define MPS_TO_KNOTS 1.94384
+
+double vps_monotonic_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+void vps_runtime_init(vps_runtime_t *rt, const vps_config_t *cfg,
+                      vps_frame_source_t source, vps_matcher_t matcher,
+                      vps_geofence_t *fence) {
+    rt->source = source;
+    rt->matcher = matcher;
+
+    vps_ekf_config_t ekf_cfg = vps_ekf_default_config();
+    ekf_cfg.measurement_noise = cfg->ekf_measurement_noise;
+    ekf_cfg.gate_threshold = cfg->ekf_gate_threshold;
+    vps_fusion_init(&rt->fusion, &ekf_cfg, 10.0, fence);
+
+    rt->min_matches = cfg->matcher.min_matches;
+    rt->min_inlier_ratio = cfg->matcher.confidence_threshold;
+    rt->max_candidates = cfg->matcher.max_candidates;
+    if (rt->max_candidates > VPS_RUNTIME_MAX_CANDIDATES)
+        rt->max_candidates = VPS_RUNTIME_MAX_CANDIDATES;
+    rt->score_candidates = false;
+    rt->batch_fixes = false;
+
+    rt->protocol = VPS_OUTPUT_NMEA;
+    rt->write = NULL;
+    rt->write_ctx = NULL;
+    rt->read = NULL;
+    rt->read_ctx = NULL;
+    rt->imu = NULL;
+    vps_msp_parser_init(&rt->fc_parser);
+
+    rt->frames = 0;
+    rt->fixes = 0;
+    rt->misses = 0;
+}
+
+int vps_runtime_retrieve(const vps_runtime_t *rt, const vps_frame_t *frame,
+                         vps_tile_coord_t *out) {
+    int n = rt->matcher.retrieve(rt->matcher.ctx, frame, out, rt->max_candidates);
+    if (n < 0) n = 0;
+    if (n > rt->max_candidates) n = rt->max_candidates;
+    return n;
+}
+
+bool vps_runtime_match(const vps_runtime_t *rt, const vps_frame_t *frame,
+                       const vps_tile_coord_t *candidates, int n,
+                       vps_locate_result_t *res) {
+    res->has_fix = false;
+    res->hdop = 0.0;
+    res->position = (vps_geopoint_t){0.0, 0.0};
+    res->n_fixes = 0;
+
+    double t_match = vps_monotonic_s();
+    vps_match_t m;
+    for (int i = 0; i < n; i++) {
+        if (!rt->matcher.match(rt->matcher.ctx, frame, candidates[i], &m))
+            continue;
+        if (m.num_matches < rt->min_matches) continue;
+        if (m.inlier_ratio < rt->min_inlier_ratio) continue;
+
+        vps_geopoint_t p = vps_homography_to_gps(m.H, m.tile,
+                                                 frame->width / 2.0,
+                                                 frame->height / 2.0);
+        if (p.lat == 0.0 && p.lon == 0.0) continue;  /* degenerate H */
+
+        double hdop = 5.0 * (1.0 - m.confidence);
+        if (hdop < 0.5) hdop = 0.5;
+        if (!res->has_fix) {
+            res->match = m;
+            res->position = p;
+            res->hdop = hdop;
+            res->has_fix = true;
+        }
+        if (!rt->score_candidates && !rt->batch_fixes) break;
+
+        res->fix_position[res->n_fixes] = p;
+        res->fix_hdop[res->n_fixes] = hdop;
+        res->fix_match[res->n_fixes] = m;
+        res->n_fixes++;
+    }
+
+    res->match_ms = (vps_monotonic_s() - t_match) * 1000.0;
+    return res->has_fix;
+}
+
+int vps_runtime_select_fix(const vps_runtime_t *rt, vps_locate_result_t *res, double t) {
+    if (res->n_fixes < 2) return 0;
+    int i = vps_fusion_select(&rt->fusion, res->fix_position, res->fix_hdop,
+                              res->n_fixes, t, NULL);
+    if (i < 0) i = 0;
+    res->position = res->fix_position[i];
+    res->hdop = res->fix_hdop[i];
+    res->match = res->fix_match[i];
+    return i;
+}
+
+vps_fusion_output_t vps_runtime_fuse(vps_runtime_t *rt, const vps_locate_result_t *res,
+                                     double t) {
+    if (rt->batch_fixes && res->n_fixes > 1)
+        return vps_fusion_update_batch(&rt->fusion, res->fix_position, res->fix_hdop,
+                                       res->n_fixes, t);
+    return vps_fusion_update(&rt->fusion, res->has_fix ? &res->position : NULL,
+                             res->hdop, t);
+}
+
+bool vps_runtime_locate(const vps_runtime_t *rt, const vps_frame_t *frame,
+                        vps_locate_result_t *res) {
+    double t_ret = vps_monotonic_s();
+    vps_tile_coord_t candidates[VPS_RUNTIME_MAX_CANDIDATES];
+    int n = vps_runtime_retrieve(rt, frame, candidates);
+    double retrieval_ms = (vps_monotonic_s() - t_ret) * 1000.0;
+
+    bool ok = vps_runtime_match(rt, frame, candidates, n, res);
+    res->retrieval_ms = retrieval_ms;
+    return ok;
+}
+
+int vps_runtime_encode(vps_output_protocol_t protocol,
+                       const vps_fusion_output_t *out,
+                       uint8_t *buf, size_t buflen) {
+    if (protocol == VPS_OUTPUT_MSP) {
+        if (buflen < MSP_GPS_FRAME_SIZE) return 0;
+        vps_msp_gps_t gps = vps_msp_from_position(out->position, out->speed_mps,
+                                                  out->heading_deg, out->hdop,
+                                                  out->has_position);
+        return vps_msp_encode(buf, &gps);
+    }
+
+    /* NMEA: GGA followed by RMC, as UartSender.send_fix does */
+    char *p = (char *)buf;
+    int n = vps_format_gga(p, buflen, out->position, out->has_position ? 1 : 0,
+                           out->hdop, 0.0);
+    if (n < 0 || (size_t)n >= buflen) return 0;
+    int m = vps_format_rmc(p + n, buflen - (size_t)n, out->position,
+                           out->has_position, out->speed_mps * MPS_TO_KNOTS,
+                           out->heading_deg);
+    if (m < 0 || (size_t)(n + m) >= buflen) return n;
+    return n + m;
+}
+
+int vps_runtime_emit(const vps_runtime_t *rt, const vps_fusion_output_t *out) {
+    uint8_t buf[VPS_RUNTIME_OUT_MAX];
+    int n = vps_runtime_encode(rt->protocol, out, buf, sizeof(buf));
+    if (rt->write && n > 0)
+        rt->write(rt->write_ctx, buf, (size_t)n);
+    return n;
+}
+
+void vps_runtime_attach_fc(vps_runtime_t *rt, vps_imu_nav_t *imu, vps_read_fn read, void *ctx) {
+    rt->imu = imu;
+    rt->read = imu ? read : NULL;
+    rt->read_ctx = ctx;
+    vps_msp_parser_init(&rt->fc_parser);
+    vps_fusion_attach_imu(&rt->fusion, imu);
+}
+
+void vps_runtime_request_fc(const vps_runtime_t *rt) {
+    if (!rt->read || !rt->write) return;
+    uint8_t buf[2 * MSP_REQUEST_SIZE];
+    int n = vps_msp_encode_request(buf, MSP_CMD_RAW_IMU);
+    n += vps_msp_encode_request(buf + n, MSP_CMD_ATTITUDE);
+    rt->write(rt->write_ctx, buf, (size_t)n);
+}
+
+int vps_runtime_read_fc(vps_runtime_t *rt) {
+    if (!rt->read) return 0;
+    uint8_t buf[256];
+    int frames = 0;
+    size_t got;
+    while ((got = rt->read(rt->read_ctx, buf, sizeof(buf))) > 0) {
+        double t = vps_monotonic_s();
+        for (size_t i = 0; i < got; i++)
+            if (vps_msp_parse_byte(&rt->fc_parser, buf[i]) &&
+                vps_imu_nav_feed_msp(rt->imu, &rt->fc_parser, t))
+                frames++;
+    }
+    return frames;
+}
+
+bool vps_runtime_step(vps_runtime_t *rt, vps_step_result_t *res) {
+    double t0 = vps_monotonic_s();
+    vps_runtime_read_fc(rt);   /* before grab: samples are not newer than the frame */
+    if (!rt->source.grab(rt->source.ctx, &res->frame)) return false;
+    rt->frames++;
+
+    vps_runtime_locate(rt, &res->frame, &res->loc);
+    vps_runtime_select_fix(rt, &res->loc, res->frame.t);
+    if (res->loc.has_fix)
+        rt->fixes++;
+    else
+        rt->misses++;
+
+    res->out = vps_runtime_fuse(rt, &res->loc, res->frame.t);
+
+    res->bytes_out = vps_runtime_emit(rt, &res->out);
+    vps_runtime_request_fc(rt);
+
+    res->total_ms = (vps_monotonic_s() - t0) * 1000.0;
+    return true;
+}
@@ -0,0 +1,288 @@
+/**
+ * @file smoother.c
+ * @brief Fixed-lag RTS smoother over VPSF flight recordings.
+ */
+#include "smoother.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+enum { P00, P01, P02, P03, P11, P12, P13, P22, P23, P33 };
+
+/* --- VPSF codec (little-endian hosts: fields are copied as-is) --- */
+
+#define GET(off, field) memcpy(&rec->field, buf + (off), sizeof(rec->field))
+#define PUT(off, field) memcpy(buf + (off), &rec->field, sizeof(rec->field))
+
+void vps_vpsf_decode(const uint8_t *buf, vps_vpsf_record_t *rec) {
+    GET(0, timestamp); GET(8, lat); GET(16, lon);
+    GET(24, vn_mps); GET(28, ve_mps); GET(32, hdop);
+    GET(36, speed_mps); GET(40, heading_deg);
+    GET(44, fix_quality); GET(45, source); GET(46, match_count);
+    GET(48, inlier_ratio); GET(52, latency_ms); GET(54, flags);
+}
+
+void vps_vpsf_encode(uint8_t *buf, const vps_vpsf_record_t *rec) {
+    PUT(0, timestamp); PUT(8, lat); PUT(16, lon);
+    PUT(24, vn_mps); PUT(28, ve_mps); PUT(32, hdop);
+    PUT(36, speed_mps); PUT(40, heading_deg);
+    PUT(44, fix_quality); PUT(45, source); PUT(46, match_count);
+    PUT(48, inlier_ratio); PUT(52, latency_ms); PUT(54, flags);
+}
+
+#undef GET
+#undef PUT
+
+void vps_vpsf_encode_header(uint8_t *buf) {
+    memcpy(buf, "VPSF", 4);
+    buf[4] = VPS_VPSF_VERSION;
+    buf[5] = 0;
+    buf[6] = VPS_VPSF_RECORD_SIZE;
+    buf[7] = 0;
+}
+
+bool vps_vpsf_check_header(const uint8_t *buf) {
+    int version = buf[4] | (buf[5] << 8);
+    return memcmp(buf, "VPSF", 4) == 0 && version >= 1 && version <= VPS_VPSF_VERSION &&
+           (buf[6] | (buf[7] << 8)) == VPS_VPSF_RECORD_SIZE;
+}
+
+/* --- Smoother --- */
+
+vps_smoother_config_t vps_smoother_default_config(void) {
+    vps_smoother_config_t cfg;
+    cfg.lag = VPS_SMOOTHER_DEFAULT_LAG;
+    cfg.ekf = vps_ekf_default_config();
+    return cfg;
+}
+
+void vps_smoother_init(vps_smoother_t *s, const vps_smoother_config_t *cfg,
+                       vps_smoother_emit_fn emit, void *ctx) {
+    s->cfg = cfg ? *cfg : vps_smoother_default_config();
+    if (s->cfg.lag < 1) s->cfg.lag = 1;
+    if (s->cfg.lag > VPS_SMOOTHER_MAX_LAG) s->cfg.lag = VPS_SMOOTHER_MAX_LAG;
+    s->emit = emit;
+    s->emit_ctx = ctx;
+    s->n = 0;
+    s->initialized = false;
+    s->last_t = 0.0;
+    memset(&s->stats, 0, sizeof(s->stats));
+}
+
+/**
+ * Solve P w = v for the packed SPD 4x4 P (Cholesky).
+ * @return false if P is not positive definite
+ */
+static bool solve4(const double p[VPS_EKF_PACKED], const double v[4], double w[4]) {
+    double a[4][4] = {
+        {p[P00], p[P01], p[P02], p[P03]},
+        {p[P01], p[P11], p[P12], p[P13]},
+        {p[P02], p[P12], p[P22], p[P23]},
+        {p[P03], p[P13], p[P23], p[P33]},
+    };
+    double l[4][4], inv[4];
+    for (int j = 0; j < 4; j++) {
+        double d = a[j][j];
+        for (int k = 0; k < j; k++) d -= l[j][k] * l[j][k];
+        if (!(d > 0.0)) return false;
+        l[j][j] = sqrt(d);
+        inv[j] = 1.0 / l[j][j];
+        for (int i = j + 1; i < 4; i++) {
+            double e = a[i][j];
+            for (int k = 0; k < j; k++) e -= l[i][k] * l[j][k];
+            l[i][j] = e * inv[j];
+        }
+    }
+    double y[4];
+    for (int i = 0; i < 4; i++) {
+        double e = v[i];
+        for (int k = 0; k < i; k++) e -= l[i][k] * y[k];
+        y[i] = e * inv[i];
+    }
+    for (int i = 3; i >= 0; i--) {
+        double e = y[i];
+        for (int k = i + 1; k < 4; k++) e -= l[k][i] * w[k];
+        w[i] = e * inv[i];
+    }
+    return true;
+}
+
+/**
+ * One RTS step: xs holds x^s_{k+1} on entry and x^s_k on return.
+ * x^s_k = x_k + P_k F' P⁻_{k+1}⁻¹ (x^s_{k+1} − x⁻_{k+1})
+ */
+static void rts_step(const vps_smoother_step_t *k, const vps_smoother_step_t *k1,
+                     double xs[4]) {
+    double v[4], w[4];
+    for (int i = 0; i < 4; i++) v[i] = xs[i] - k1->xp[i];
+    if (!solve4(k1->pp, v, w)) {
+        memcpy(xs, k->xf, sizeof(k->xf));
+        return;
+    }
+    /* F' w */
+    double u[4] = {w[0], w[1], w[2] + k1->dt * w[0], w[3] + k1->dt * w[1]};
+    const double *p = k->pf;
+    xs[0] = k->xf[0] + p[P00] * u[0] + p[P01] * u[1] + p[P02] * u[2] + p[P03] * u[3];
+    xs[1] = k->xf[1] + p[P01] * u[0] + p[P11] * u[1] + p[P12] * u[2] + p[P13] * u[3];
+    xs[2] = k->xf[2] + p[P02] * u[0] + p[P12] * u[1] + p[P22] * u[2] + p[P23] * u[3];
+    xs[3] = k->xf[3] + p[P03] * u[0] + p[P13] * u[1] + p[P23] * u[2] + p[P33] * u[3];
+}
+
+static void apply_state(vps_vpsf_record_t *rec, const double xs[4]) {
+    double vn = xs[2] * 111320.0;
+    double ve = xs[3] * 111320.0 * cos(xs[0] * M_PI / 180.0);
+    double speed = sqrt(vn * vn + ve * ve);
+    rec->lat = xs[0];
+    rec->lon = xs[1];
+    rec->vn_mps = (float)vn;
+    rec->ve_mps = (float)ve;
+    rec->speed_mps = (float)speed;
+    if (speed > 0.5)
+        rec->heading_deg = (float)fmod(atan2(ve, vn) * 180.0 / M_PI + 360.0, 360.0);
+    rec->flags |= VPS_VPSF_FLAG_SMOOTHED;
+}
+
+/** Backward pass over the buffer; emit and drop the oldest count steps. */
+static void smooth_block(vps_smoother_t *s, int count) {
+    int n = s->n;
+    if (n == 0) return;
+    double *xs = s->xs;
+    memcpy(xs, s->steps[n - 1].xf, sizeof(s->xs));
+    if (count == n) apply_state(&s->steps[n - 1].rec, xs);
+    for (int k = n - 2; k >= 0; k--) {
+        rts_step(&s->steps[k], &s->steps[k + 1], xs);
+        if (k < count) apply_state(&s->steps[k].rec, xs);
+    }
+
+    for (int k = 0; k < count; k++) s->emit(s->emit_ctx, &s->steps[k].rec);
+    s->stats.smoothed += (uint64_t)count;
+    s->n = n - count;
+    memmove(s->steps, s->steps + count, (size_t)s->n * sizeof(s->steps[0]));
+}
+
+void vps_smoother_flush(vps_smoother_t *s) {
+    smooth_block(s, s->n);
+}
+
+void vps_smoother_push(vps_smoother_t *s, const vps_vpsf_record_t *rec) {
+    s->stats.records++;
+    bool fix = rec->source == VPS_VPSF_SOURCE_VISUAL && rec->hdop > 0.0f;
+    double t = rec->timestamp;
+
+    if (s->initialized && t - s->last_t > s->cfg.ekf.max_gap_s) {
+        vps_smoother_flush(s);
+        s->initialized = false;
+        s->stats.resets++;
+    }
+
+    if (!s->initialized) {
+        if (!fix) {
+            s->emit(s->emit_ctx, rec);
+            return;
+        }
+        vps_ekf_state_t e;
+        vps_ekf_init(&e);
+        vps_ekf_update(&e, &s->cfg.ekf, (vps_geopoint_t){rec->lat, rec->lon}, rec->hdop, t);
+        vps_smoother_step_t *st = &s->steps[s->n++];
+        st->rec = *rec;
+        memcpy(st->xf, e.x, sizeof(st->xf));
+        vps_ekf_pack_cov(st->pf, &e.P[0][0]);
+        memcpy(st->xp, st->xf, sizeof(st->xp));
+        memcpy(st->pp, st->pf, sizeof(st->pp));
+        st->dt = 0.0;
+        s->initialized = true;
+        s->last_t = t;
+        s->stats.fixes++;
+    } else {
+        const vps_smoother_step_t *prev = &s->steps[s->n - 1];
+        vps_smoother_step_t *st = &s->steps[s->n++];
+        double dt = t > s->last_t ? t - s->last_t : 0.0;
+        st->rec = *rec;
+        st->dt = dt;
+        memcpy(st->xp, prev->xf, sizeof(st->xp));
+        memcpy(st->pp, prev->pf, sizeof(st->pp));
+        vps_ekf_propagate(st->xp, st->pp, s->cfg.ekf.process_noise, dt);
+        memcpy(st->xf, st->xp, sizeof(st->xf));
+        memcpy(st->pf, st->pp, sizeof(st->pf));
+        if (fix) {
+            double r = s->cfg.ekf.measurement_noise * rec->hdop * rec->hdop;
+            double d = vps_ekf_correct(st->xf, st->pf, (vps_geopoint_t){rec->lat, rec->lon},
+                                       r, s->cfg.ekf.gate_threshold);
+            if (d <= s->cfg.ekf.gate_threshold)
+                s->stats.fixes++;
+            else
+                s->stats.rejected++;
+        }
+        if (t > s->last_t) s->last_t = t;
+    }
+
+    if (s->n >= 2 * s->cfg.lag) smooth_block(s, s->cfg.lag);
+}
+
+/* --- File driver --- */
+
+#define IO_RECORDS 512
+
+typedef struct {
+    FILE *out;
+    uint8_t buf[IO_RECORDS * VPS_VPSF_RECORD_SIZE];
+    int used;
+    bool error;
+} file_sink_t;
+
+static void sink_flush(file_sink_t *k) {
+    size_t bytes = (size_t)k->used * VPS_VPSF_RECORD_SIZE;
+    if (bytes && fwrite(k->buf, 1, bytes, k->out) != bytes) k->error = true;
+    k->used = 0;
+}
+
+static void sink_emit(void *ctx, const vps_vpsf_record_t *rec) {
+    file_sink_t *k = ctx;
+    vps_vpsf_encode(k->buf + (size_t)k->used * VPS_VPSF_RECORD_SIZE, rec);
+    if (++k->used == IO_RECORDS) sink_flush(k);
+}
+
+bool vps_smoother_run_file(FILE *in, FILE *out, const vps_smoother_config_t *cfg,
+                           vps_smoother_stats_t *stats) {
+    uint8_t hdr[VPS_VPSF_HEADER_SIZE];
+    if (fread(hdr, 1, sizeof(hdr), in) != sizeof(hdr) || !vps_vpsf_check_header(hdr))
+        return false;
+
+    vps_smoother_t *s = malloc(sizeof(*s));
+    file_sink_t *sink = malloc(sizeof(*sink));
+    uint8_t *buf = malloc(IO_RECORDS * VPS_VPSF_RECORD_SIZE);
+    bool ok = s && sink && buf;
+    if (ok) {
+        sink->out = out;
+        sink->used = 0;
+        sink->error = false;
+        vps_smoother_init(s, cfg, sink_emit, sink);
+
+        vps_vpsf_encode_header(hdr);
+        if (fwrite(hdr, 1, sizeof(hdr), out) != sizeof(hdr)) sink->error = true;
+
+        /* Bytes, not records, so a truncated last record is seen */
+        size_t got, partial = 0;
+        while (!sink->error && partial == 0 &&
+               (got = fread(buf, 1, IO_RECORDS * VPS_VPSF_RECORD_SIZE, in)) > 0) {
+            partial = got % VPS_VPSF_RECORD_SIZE;
+            for (size_t i = 0; i < got / VPS_VPSF_RECORD_SIZE; i++) {
+                vps_vpsf_record_t rec;
+                vps_vpsf_decode(buf + i * VPS_VPSF_RECORD_SIZE, &rec);
+                vps_smoother_push(s, &rec);
+            }
+        }
+        vps_smoother_flush(s);
+        sink_flush(sink);
+        ok = !sink->error && !ferror(in) && partial == 0;
+        if (stats) *stats = s->stats;
+    }
+    free(buf);
+    free(sink);
+    free(s);
+    return ok;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file snapshot.c
+ * @brief Double-buffered seqlock for fusion snapshots.
+ */
+#include "snapshot.h"
+#include <string.h>
+
+void vps_fusion_pub_init(vps_fusion_pub_t *p) {
+    atomic_init(&p->seq, 0);
+    for (int c = 0; c < 2; c++)
+        for (size_t w = 0; w < VPS_SNAPSHOT_WORDS; w++) atomic_init(&p->copy[c][w], 0);
+    p->version = 0;
+}
+
+static void store_copy(_Atomic uint64_t *dst, const uint64_t *src) {
+    for (size_t w = 0; w < VPS_SNAPSHOT_WORDS; w++)
+        atomic_store_explicit(&dst[w], src[w], memory_order_relaxed);
+}
+
+void vps_fusion_publish_snapshot(vps_fusion_pub_t *p, const vps_fusion_snapshot_t *s) {
+    uint64_t words[VPS_SNAPSHOT_WORDS] = {0};
+    memcpy(words, s, sizeof(*s));
+    p->version++;
+    memcpy(words + offsetof(vps_fusion_snapshot_t, version) / 8, &p->version,
+           sizeof(p->version));
+
+    /* Readers go to copy 1 as soon as seq leaves 0; fill it first */
+    if (p->version == 1) store_copy(p->copy[1], words);
+    /* seq odd: readers move to copy 1 while copy 0 is rewritten, then back.
+     * The fence orders the last copy 1 writes (this pre-fill or the
+     * previous publish) before readers can be sent there. */
+    uint32_t seq = atomic_load_explicit(&p->seq, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&p->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    store_copy(p->copy[0], words);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&p->seq, seq + 2, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    store_copy(p->copy[1], words);
+}
+
+void vps_fusion_publish(vps_fusion_pub_t *p, const vps_fusion_t *f,
+                        const vps_fusion_output_t *out, double t) {
+    vps_fusion_snapshot_t s;
+    memset(&s, 0, sizeof(s));   /* padding is published too */
+    s.t = t;
+    s.out = *out;
+    s.ekf = f->ekf;
+    s.dr = f->dr;
+    vps_fusion_publish_snapshot(p, &s);
+}
+
+bool vps_fusion_snapshot_read(const vps_fusion_pub_t *p, vps_fusion_snapshot_t *out,
+                              uint32_t *retries) {
+    uint64_t words[VPS_SNAPSHOT_WORDS];
+    uint32_t n = 0;
+    for (;;) {
+        uint32_t seq = atomic_load_explicit(&p->seq, memory_order_acquire);
+        if (seq == 0) {
+            if (retries) *retries = n;
+            return false;
+        }
+        /* During a publish copy (seq & 1) is the one not being written */
+        _Atomic uint64_t *src = (_Atomic uint64_t *)p->copy[seq & 1];
+        for (size_t w = 0; w < VPS_SNAPSHOT_WORDS; w++)
+            words[w] = atomic_load_explicit(&src[w], memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&p->seq, memory_order_relaxed) == seq) break;
+        n++;
+    }
+    if (retries) *retries = n;
+    /* Version 0 is the zeroed initial copy, never a publish */
+    uint64_t version;
+    memcpy(&version, words + offsetof(vps_fusion_snapshot_t, version) / 8, sizeof(version));
+    if (version == 0) return false;
+    memcpy(out, words, sizeof(*out));
+    return true;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file spsc_queue.c
+ * @brief Bounded lock-free SPSC ring queue.
+ *
+ * head is normally advanced only by the consumer. push_latest lets the
+ * producer advance it too (evicting the oldest slot), so the consumer
+ * claims elements with a CAS on head and retries if the producer
+ * evicted the slot while it was being copied.
+ */
+#include "spsc_queue.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool vps_spsc_init(vps_spsc_queue_t *q, uint32_t capacity, size_t elem_size) {
+    uint32_t cap = 1;
+    while (cap < capacity) cap <<= 1;
+
+    q->slots = malloc((size_t)cap * elem_size);
+    if (!q->slots) return false;
+
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    q->capacity = cap;
+    q->mask = cap - 1;
+    q->elem_size = elem_size;
+    atomic_init(&q->pushed, 0);
+    atomic_init(&q->popped, 0);
+    atomic_init(&q->dropped, 0);
+    atomic_init(&q->max_depth, 0);
+    return true;
+}
+
+void vps_spsc_free(vps_spsc_queue_t *q) {
+    free(q->slots);
+    q->slots = NULL;
+}
+
+static inline uint8_t *slot(const vps_spsc_queue_t *q, uint32_t i) {
+    return q->slots + (size_t)(i & q->mask) * q->elem_size;
+}
+
+static inline void publish(vps_spsc_queue_t *q, uint32_t t, uint32_t h,
+                           const void *item) {
+    memcpy(slot(q, t), item, q->elem_size);
+    atomic_store_explicit(&q->tail, t + 1, memory_order_release);
+    atomic_fetch_add_explicit(&q->pushed, 1, memory_order_relaxed);
+
+    uint32_t depth = t + 1 - h;
+    if (depth > atomic_load_explicit(&q->max_depth, memory_order_relaxed))
+        atomic_store_explicit(&q->max_depth, depth, memory_order_relaxed);
+}
+
+bool vps_spsc_try_push(vps_spsc_queue_t *q, const void *item) {
+    uint32_t t = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    uint32_t h = atomic_load_explicit(&q->head, memory_order_acquire);
+    if (t - h >= q->capacity) return false;
+    publish(q, t, h, item);
+    return true;
+}
+
+bool vps_spsc_push(vps_spsc_queue_t *q, const void *item) {
+    if (vps_spsc_try_push(q, item)) return true;
+    atomic_fetch_add_explicit(&q->dropped, 1, memory_order_relaxed);
+    return false;
+}
+
+bool vps_spsc_push_latest(vps_spsc_queue_t *q, const void *item, void *evicted_out) {
+    uint32_t t = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    uint32_t h = atomic_load_explicit(&q->head, memory_order_acquire);
+    bool evicted = false;
+
+    if (t - h >= q->capacity) {
+        /* Full: drop the oldest. Only the producer writes slots, so the
+         * copy is stable; if the CAS fails the consumer just popped it,
+         * which frees the slot as well. */
+        if (evicted_out) memcpy(evicted_out, slot(q, h), q->elem_size);
+        if (atomic_compare_exchange_strong_explicit(&q->head, &h, h + 1,
+                                                    memory_order_acq_rel,
+                                                    memory_order_acquire)) {
+            atomic_fetch_add_explicit(&q->dropped, 1, memory_order_relaxed);
+            evicted = true;
+        }
+        h = atomic_load_explicit(&q->head, memory_order_acquire);
+    }
+
+    publish(q, t, h, item);
+    return evicted;
+}
+
+bool vps_spsc_pop(vps_spsc_queue_t *q, void *out) {
+    for (;;) {
+        uint32_t h = atomic_load_explicit(&q->head, memory_order_acquire);
+        uint32_t t = atomic_load_explicit(&q->tail, memory_order_acquire);
+        if (h == t) return false;
+
+        memcpy(out, slot(q, h), q->elem_size);
+
+        /* Fails only if push_latest evicted this slot mid-copy */
+        if (atomic_compare_exchange_strong_explicit(&q->head, &h, h + 1,
+                                                    memory_order_acq_rel,
+                                                    memory_order_acquire)) {
+            atomic_fetch_add_explicit(&q->popped, 1, memory_order_relaxed);
+            return true;
+        }
+    }
+}
+
+uint32_t vps_spsc_depth(const vps_spsc_queue_t *q) {
+    uint32_t t = atomic_load_explicit(&q->tail, memory_order_acquire);
+    uint32_t h = atomic_load_explicit(&q->head, memory_order_acquire);
+    return t - h;
+}
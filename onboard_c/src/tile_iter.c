@@ -0,0 +1,175 @@
+/**
+ * @file tile_iter.c
+ * @brief Lazy, distance-ordered tile iteration over a circle or an EKF
+ *        uncertainty ellipse.
+ */
+#include "tile_iter.h"
+#include "tile_math.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define MAX_LAT 85.05112878
+#define MIN_VAR 1e-12           /* tile units^2; keeps a zero radius well defined */
+
+enum { EAST, WEST, SOUTH, NORTH };
+
+static int clamp_floor(double v, int lo, int hi) {
+    if (!(v >= lo)) return lo;      /* also NaN */
+    if (v >= hi) return hi;
+    return (int)floor(v);
+}
+
+/*
+ * Extent in v of the ellipse {p : p' S^-1 p <= 1}, S = [a b; b c] in
+ * (u, v), over the slab u0 <= u <= u1. The upper chord is concave with
+ * its top at u = b / sqrt(c), so its maximum over the slab is the top or
+ * the slab edge nearer to it; the lower chord likewise.
+ */
+static bool slab_extent(double a, double b, double c, double u0, double u1,
+                        double *lo, double *hi) {
+    double eu = sqrt(a), ev = sqrt(c);
+    if (u1 < -eu || u0 > eu) return false;
+    u0 = fmax(u0, -eu);
+    u1 = fmin(u1, eu);
+    double m = b / a, w2 = fmax(c - b * b / a, 0.0), ut = b / ev;
+    double e0 = ut < u0 ? u0 : u1, e1 = -ut < u0 ? u0 : u1;
+    *hi = ut >= u0 && ut <= u1 ? ev : m * e0 + sqrt(w2 * fmax(0.0, 1.0 - e0 * e0 / a));
+    *lo = -ut >= u0 && -ut <= u1 ? -ev : m * e1 - sqrt(w2 * fmax(0.0, 1.0 - e1 * e1 / a));
+    return true;
+}
+
+static void init(vps_tile_iter_t *it, vps_geopoint_t p, int zoom,
+                 double sxx, double sxy, double syy) {
+    int n = 1 << zoom;
+    double lat_deg = fmax(-MAX_LAT, fmin(MAX_LAT, p.lat)), lat = lat_deg * M_PI / 180.0;
+    double xg = fmod((p.lon + 180.0) / 360.0, 1.0);
+    if (xg < 0.0) xg += 1.0;
+    double yg = fmin((1.0 - log(tan(lat) + 1.0 / cos(lat)) / M_PI) / 2.0, 1.0) * n;
+    xg *= n;
+    it->zoom = zoom;
+    it->cx = clamp_floor(xg, 0, n - 1);
+    it->cy = clamp_floor(yg, 0, n - 1);
+    it->fx = xg - it->cx;
+    it->fy = yg - it->cy;
+    it->sxx = fmax(sxx, MIN_VAR);
+    it->syy = fmax(syy, MIN_VAR);
+    it->sxy = fmax(-1.0, fmin(1.0, sxy / sqrt(it->sxx * it->syy))) * sqrt(it->sxx * it->syy);
+    it->tile_m = vps_meters_per_pixel(lat_deg, zoom) * VPS_TILE_SIZE;
+    it->x_lo = -(n / 2);
+    it->x_hi = (n - 1) / 2;
+
+    /* Last ring: the ellipse's bounding box, clipped to the map */
+    double ex = sqrt(it->sxx), ey = sqrt(it->syy);
+    int i0 = clamp_floor(it->fx - ex, it->x_lo, it->x_hi);
+    int i1 = clamp_floor(it->fx + ex, it->x_lo, it->x_hi);
+    int j0 = clamp_floor(it->fy - ey, -it->cy, n - 1 - it->cy);
+    int j1 = clamp_floor(it->fy + ey, -it->cy, n - 1 - it->cy);
+    it->max_ring = -i0 > i1 ? -i0 : i1;
+    if (-j0 > it->max_ring) it->max_ring = -j0;
+    if (j1 > it->max_ring) it->max_ring = j1;
+
+    /* Ring 0 is the point's own tile, as the east side at offset 0 */
+    it->ring = 0;
+    it->t = it->t_end = it->side = 0;
+    for (int s = 0; s < 4; s++) {
+        it->lo[s] = 1;
+        it->hi[s] = 0;
+    }
+    it->lo[EAST] = it->hi[EAST] = 0;
+}
+
+void vps_tile_iter_circle(vps_tile_iter_t *it, vps_geopoint_t center, double radius_m,
+                          int zoom) {
+    /* Tile width at the clipped row: it goes to 0 at the poles */
+    double lat = fmax(-MAX_LAT, fmin(MAX_LAT, center.lat));
+    double r = radius_m / (vps_meters_per_pixel(lat, zoom) * VPS_TILE_SIZE);
+    init(it, center, zoom, r * r, 0.0, r * r);
+}
+
+void vps_tile_iter_ellipse(vps_tile_iter_t *it, const vps_ekf_state_t *ekf, double n_sigma,
+                           int zoom) {
+    vps_geopoint_t p = {ekf->x[0], ekf->x[1]};
+    double clat = cos(fmax(-MAX_LAT, fmin(MAX_LAT, p.lat)) * M_PI / 180.0);
+    /* Mercator Jacobian at the point: tile units per degree */
+    double jx = ldexp(1.0, zoom) / 360.0, jy = -jx / clat, k2 = n_sigma * n_sigma;
+    init(it, p, zoom, k2 * jx * jx * ekf->P[1][1], k2 * jx * jy * ekf->P[0][1],
+         k2 * jy * jy * ekf->P[0][0]);
+}
+
+/* Tile ranges along the four sides of ring k; false if all are empty */
+static bool start_ring(vps_tile_iter_t *it, int k) {
+    int n = 1 << it->zoom;
+    double lo, hi;
+    for (int s = 0; s < 4; s++) {
+        it->lo[s] = 1;
+        it->hi[s] = 0;
+    }
+    /* East and west: columns +-k, rows -k..k */
+    for (int s = EAST; s <= WEST; s++) {
+        int i = s == EAST ? k : -k;
+        if (i > it->x_hi || i < it->x_lo) continue;
+        if (!slab_extent(it->sxx, it->sxy, it->syy, i - it->fx, i + 1 - it->fx, &lo, &hi))
+            continue;
+        int rlo = -k > -it->cy ? -k : -it->cy, rhi = k < n - 1 - it->cy ? k : n - 1 - it->cy;
+        it->lo[s] = clamp_floor(lo + it->fy, rlo, rhi + 1);
+        it->hi[s] = clamp_floor(hi + it->fy, rlo - 1, rhi);
+    }
+    /* South and north: rows +-k, columns -(k-1)..k-1 */
+    for (int s = SOUTH; s <= NORTH; s++) {
+        int j = s == SOUTH ? k : -k;
+        if (it->cy + j < 0 || it->cy + j >= n) continue;
+        if (!slab_extent(it->syy, it->sxy, it->sxx, j - it->fy, j + 1 - it->fy, &lo, &hi))
+            continue;
+        int clo = 1 - k > it->x_lo ? 1 - k : it->x_lo, chi = k - 1 < it->x_hi ? k - 1 : it->x_hi;
+        it->lo[s] = clamp_floor(lo + it->fx, clo, chi + 1);
+        it->hi[s] = clamp_floor(hi + it->fx, clo - 1, chi);
+    }
+    /* Offsets from the axes to visit: from the nearest range to the farthest */
+    it->t = k + 1;
+    it->t_end = -1;
+    for (int s = 0; s < 4; s++) {
+        if (it->lo[s] > it->hi[s]) continue;
+        int near = it->lo[s] > 0 ? it->lo[s] : it->hi[s] < 0 ? -it->hi[s] : 0;
+        int far = -it->lo[s] > it->hi[s] ? -it->lo[s] : it->hi[s];
+        if (near < it->t) it->t = near;
+        if (far > it->t_end) it->t_end = far;
+    }
+    it->side = 0;
+    return it->t_end >= 0;
+}
+
+bool vps_tile_iter_next(vps_tile_iter_t *it, vps_tile_coord_t *out) {
+    for (;;) {
+        for (; it->t <= it->t_end; it->t++, it->side = 0) {
+            /* E+t E-t W+t W-t S+t S-t N+t N-t */
+            while (it->side < 8) {
+                int s = it->side >> 1, off = it->side & 1 ? -it->t : it->t;
+                it->side++;
+                if ((it->side & 1) == 0 && it->t == 0) continue;
+                if (off < it->lo[s] || off > it->hi[s]) continue;
+                int k = it->ring;
+                int dx = s == EAST ? k : s == WEST ? -k : off;
+                int dy = s == SOUTH ? k : s == NORTH ? -k : off;
+                out->z = it->zoom;
+                out->x = (int)((uint32_t)(it->cx + dx) & (((uint32_t)1 << it->zoom) - 1));
+                out->y = it->cy + dy;
+                return true;
+            }
+        }
+        /* A convex region reaching past this ring would have touched it */
+        if (it->ring >= it->max_ring || !start_ring(it, it->ring + 1)) {
+            it->max_ring = it->ring;
+            it->t = 1;
+            it->t_end = 0;
+            return false;
+        }
+        it->ring++;
+    }
+}
+
+double vps_tile_iter_min_dist_m(const vps_tile_iter_t *it) {
+    return it->ring > 1 ? (it->ring - 1) * it->tile_m : 0.0;
+}
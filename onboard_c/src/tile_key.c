@@ -0,0 +1,198 @@
+/**
+ * @file tile_key.c
+ * @brief Morton tile keys and an open-addressing tile hash map.
+ */
+#include "tile_key.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ZOOM_SHIFT 58
+#define MORTON_MASK (((uint64_t)1 << ZOOM_SHIFT) - 1)
+#define X_BITS 0x5555555555555555ull
+#define Y_BITS 0xAAAAAAAAAAAAAAAAull
+#define FIB 0x9E3779B97F4A7C15ull       /* 2^64 / golden ratio */
+#define PREFETCH_AHEAD 8
+
+/* Spread the low 32 bits of v to the even bits */
+static uint64_t dilate(uint64_t v) {
+    v &= 0xFFFFFFFFull;
+    v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+    v = (v | (v << 8)) & 0x00FF00FF00FF00FFull;
+    v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0Full;
+    v = (v | (v << 2)) & 0x3333333333333333ull;
+    v = (v | (v << 1)) & 0x5555555555555555ull;
+    return v;
+}
+
+/* Gather the even bits of v */
+static uint32_t undilate(uint64_t v) {
+    v &= 0x5555555555555555ull;
+    v = (v | (v >> 1)) & 0x3333333333333333ull;
+    v = (v | (v >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+    v = (v | (v >> 4)) & 0x00FF00FF00FF00FFull;
+    v = (v | (v >> 8)) & 0x0000FFFF0000FFFFull;
+    v = (v | (v >> 16)) & 0x00000000FFFFFFFFull;
+    return (uint32_t)v;
+}
+
+static uint64_t low_bits(int zoom) {
+    return ((uint64_t)1 << (2 * zoom)) - 1;
+}
+
+static vps_tile_key_t make_key(int zoom, uint64_t morton) {
+    return (uint64_t)zoom << ZOOM_SHIFT | morton;
+}
+
+vps_tile_key_t vps_tile_key(vps_tile_coord_t tile) {
+    return make_key(tile.z, dilate((uint32_t)tile.x) | dilate((uint32_t)tile.y) << 1);
+}
+
+vps_tile_coord_t vps_tile_key_coord(vps_tile_key_t key) {
+    uint64_t m = key & MORTON_MASK;
+    return (vps_tile_coord_t){vps_tile_key_zoom(key), (int)undilate(m), (int)undilate(m >> 1)};
+}
+
+int vps_tile_key_zoom(vps_tile_key_t key) {
+    return (int)(key >> ZOOM_SHIFT);
+}
+
+vps_tile_key_t vps_tile_key_ancestor(vps_tile_key_t key, int zoom) {
+    int z = vps_tile_key_zoom(key);
+    if (zoom < 0 || zoom > z) return VPS_TILE_KEY_NONE;
+    return make_key(zoom, (key & MORTON_MASK) >> (2 * (z - zoom)));
+}
+
+vps_tile_key_t vps_tile_key_parent(vps_tile_key_t key) {
+    return vps_tile_key_ancestor(key, vps_tile_key_zoom(key) - 1);
+}
+
+vps_tile_key_t vps_tile_key_child(vps_tile_key_t key, int digit) {
+    int z = vps_tile_key_zoom(key);
+    if (z >= VPS_TILE_KEY_MAX_ZOOM) return VPS_TILE_KEY_NONE;
+    return make_key(z + 1, (key & MORTON_MASK) << 2 | (uint64_t)(digit & 3));
+}
+
+bool vps_tile_key_neighbor(vps_tile_key_t key, int dx, int dy, vps_tile_key_t *out) {
+    int z = vps_tile_key_zoom(key);
+    uint64_t m = key & MORTON_MASK, x = m & X_BITS, y = m & Y_BITS;
+    /* Dilated add: fill the other lane with ones so the carry crosses it */
+    if (dx > 0) x = ((x | Y_BITS) + 1) & X_BITS;
+    if (dx < 0) x = (x - 1) & X_BITS;
+    if (dy > 0) y = ((y | X_BITS) + 2) & Y_BITS;
+    if (dy < 0) y = (y - 2) & Y_BITS;
+    if (y & ~low_bits(z)) return false;     /* off the top or bottom row */
+    *out = make_key(z, (x & low_bits(z)) | y);
+    return true;
+}
+
+int vps_tile_key_quadkey(vps_tile_key_t key, char *out) {
+    int z = vps_tile_key_zoom(key);
+    for (int i = 0; i < z; i++) out[i] = (char)('0' + ((key >> (2 * (z - 1 - i))) & 3));
+    out[z] = '\0';
+    return z;
+}
+
+bool vps_tile_key_from_quadkey(const char *quadkey, vps_tile_key_t *out) {
+    uint64_t m = 0;
+    int z = 0;
+    for (; quadkey[z]; z++) {
+        if (z >= VPS_TILE_KEY_MAX_ZOOM || quadkey[z] < '0' || quadkey[z] > '3') return false;
+        m = m << 2 | (uint64_t)(quadkey[z] - '0');
+    }
+    *out = make_key(z, m);
+    return true;
+}
+
+/* --- Hash map --- */
+
+static size_t home_slot(const vps_tile_map_t *m, vps_tile_key_t key) {
+    return (size_t)((key * FIB) >> m->shift);
+}
+
+static bool alloc_slots(vps_tile_map_t *m, int log2_cap) {
+    size_t cap = (size_t)1 << log2_cap;
+    m->slots = malloc(cap * sizeof(vps_tile_slot_t));
+    if (!m->slots) return false;
+    memset(m->slots, 0xFF, cap * sizeof(vps_tile_slot_t));   /* every key NONE */
+    m->mask = cap - 1;
+    m->shift = 64 - log2_cap;
+    m->count = 0;
+    return true;
+}
+
+/* Place a key known to be absent */
+static void place(vps_tile_map_t *m, vps_tile_key_t key, uint32_t value) {
+    size_t i = home_slot(m, key);
+    while (m->slots[i].key != VPS_TILE_KEY_NONE) i = (i + 1) & m->mask;
+    m->slots[i].key = key;
+    m->slots[i].value = value;
+    m->count++;
+}
+
+bool vps_tile_map_init(vps_tile_map_t *m, int expected) {
+    int log2_cap = 4;
+    while (((size_t)1 << log2_cap) < 2 * (size_t)(expected > 0 ? expected : 0)) log2_cap++;
+    return alloc_slots(m, log2_cap);
+}
+
+bool vps_tile_map_build(vps_tile_map_t *m, const vps_tile_key_t *keys, int n) {
+    if (!vps_tile_map_init(m, n)) return false;
+    for (int i = 0; i < n; i++)
+        if (!vps_tile_map_put(m, keys[i], (uint32_t)i)) {
+            vps_tile_map_free(m);
+            return false;
+        }
+    return true;
+}
+
+void vps_tile_map_free(vps_tile_map_t *m) {
+    free(m->slots);
+    memset(m, 0, sizeof(*m));
+}
+
+bool vps_tile_map_put(vps_tile_map_t *m, vps_tile_key_t key, uint32_t value) {
+    if (key == VPS_TILE_KEY_NONE) return false;
+    size_t i = home_slot(m, key);
+    for (; m->slots[i].key != VPS_TILE_KEY_NONE; i = (i + 1) & m->mask)
+        if (m->slots[i].key == key) {
+            m->slots[i].value = value;
+            return true;
+        }
+    if (2 * (size_t)(m->count + 1) > m->mask + 1) {
+        vps_tile_map_t grown;
+        if (!alloc_slots(&grown, 64 - m->shift + 1)) return false;
+        for (size_t j = 0; j <= m->mask; j++)
+            if (m->slots[j].key != VPS_TILE_KEY_NONE)
+                place(&grown, m->slots[j].key, m->slots[j].value);
+        free(m->slots);
+        *m = grown;
+    }
+    place(m, key, value);
+    return true;
+}
+
+bool vps_tile_map_get(const vps_tile_map_t *m, vps_tile_key_t key, uint32_t *value_out) {
+    for (size_t i = home_slot(m, key);; i = (i + 1) & m->mask) {
+        vps_tile_key_t k = m->slots[i].key;
+        if (k == key && k != VPS_TILE_KEY_NONE) {
+            *value_out = m->slots[i].value;
+            return true;
+        }
+        if (k == VPS_TILE_KEY_NONE) return false;
+    }
+}
+
+int vps_tile_map_get_batch(const vps_tile_map_t *m, const vps_tile_key_t *keys, int n,
+                           uint32_t *values_out) {
+    int found = 0;
+    for (int i = 0; i < n; i++) {
+#if defined(__GNUC__) || defined(__clang__)
+        if (i + PREFETCH_AHEAD < n)
+            __builtin_prefetch(&m->slots[home_slot(m, keys[i + PREFETCH_AHEAD])]);
+#endif
+        bool hit = vps_tile_map_get(m, keys[i], &values_out[i]);
+        if (!hit) values_out[i] = VPS_TILE_MAP_NONE;
+        found += hit;
+    }
+    return found;
+}
@@ -3,6 +3,7 @@
  * @brief GPS ↔ tile ↔ pixel coordinate conversions.
  */
 #include "tile_math.h"
+#include "tile_iter.h"
 #include <math.h>
 
 #ifndef M_PI
@@ -57,24 +58,9 @@ double vps_meters_per_pixel(double lat, int zoom) {
 
 int vps_tiles_in_radius(vps_geopoint_t center, double radius_km, int zoom,
                         vps_tile_coord_t *out, int max_out) {
-    /* Compute bounding box in tile coordinates */
-    double dlat = radius_km / 111.32;
-    double dlon = radius_km / (111.32 * cos(center.lat * M_PI / 180.0));
-
-    vps_geopoint_t nw = {center.lat + dlat, center.lon - dlon};
-    vps_geopoint_t se = {center.lat - dlat, center.lon + dlon};
-
-    vps_tile_coord_t t_nw = vps_gps_to_tile(nw, zoom);
-    vps_tile_coord_t t_se = vps_gps_to_tile(se, zoom);
-
+    vps_tile_iter_t it;
+    vps_tile_iter_circle(&it, center, radius_km * 1000.0, zoom);
     int count = 0;
-    for (int x = t_nw.x; x <= t_se.x && count < max_out; x++) {
-        for (int y = t_nw.y; y <= t_se.y && count < max_out; y++) {
-            out[count].z = zoom;
-            out[count].x = x;
-            out[count].y = y;
-            count++;
-        }
-    }
+    while (count < max_out && vps_tile_iter_next(&it, &out[count])) count++;
     return count;
 }
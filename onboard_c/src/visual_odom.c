@@ -0,0 +1,563 @@
+/**
+ * @file visual_odom.c
+ * @brief Pyramidal LK visual odometry with NEON / SSE2 / scalar kernels.
+ *
+ * Fixed point: patches hold grey * 128 (7-bit bilinear weights summing
+ * to 128, at most 32640), gradients are unhalved central differences
+ * and every LK sum is an exact int64, so all kernel sets agree bit for
+ * bit. The only floating point is the 2x2 solve per iteration.
+ */
+#include "visual_odom.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define ISA "neon"
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define ISA "sse2"
+#else
+#define ISA "scalar"
+#endif
+
+#define WIN VPS_VO_WIN
+#define NPIX (WIN * WIN)
+#define SEL_LEVEL 2          /* corners are scored on this level (or the top) */
+
+/* --- Kernels --- */
+
+/* 2x2 box downsample of one row pair: dst[x] = (a + b + c + d + 2) >> 2 */
+static void down_row(const uint8_t *s0, const uint8_t *s1, uint8_t *dst, int w) {
+    int x = 0;
+#if defined(__ARM_NEON)
+    for (; x + 8 <= w; x += 8) {
+        uint16x8_t s = vaddq_u16(vpaddlq_u8(vld1q_u8(s0 + 2 * x)),
+                                 vpaddlq_u8(vld1q_u8(s1 + 2 * x)));
+        vst1_u8(dst + x, vrshrn_n_u16(s, 2));
+    }
+#elif defined(__SSE2__)
+    const __m128i lo = _mm_set1_epi16(0xff), two = _mm_set1_epi16(2);
+    for (; x + 8 <= w; x += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(s0 + 2 * x));
+        __m128i b = _mm_loadu_si128((const __m128i *)(s1 + 2 * x));
+        __m128i s = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a, lo), _mm_srli_epi16(a, 8)),
+                                  _mm_add_epi16(_mm_and_si128(b, lo), _mm_srli_epi16(b, 8)));
+        s = _mm_srli_epi16(_mm_add_epi16(s, two), 2);
+        _mm_storel_epi64((__m128i *)(dst + x), _mm_packus_epi16(s, s));
+    }
+#endif
+    for (; x < w; x++)
+        dst[x] = (uint8_t)((s0[2 * x] + s0[2 * x + 1] + s1[2 * x] + s1[2 * x + 1] + 2) >> 2);
+}
+
+/*
+ * rows x WIN bilinear patch with top-left pixel (ix, iy): reads columns
+ * ix..ix+WIN and rows iy..iy+rows. w = {w00, w01, w10, w11}, sum 128.
+ */
+static void patch(const vps_vo_image_t *im, int ix, int iy, const uint8_t w[4],
+                  int rows, int16_t *out) {
+    for (int r = 0; r < rows; r++, out += WIN) {
+        const uint8_t *a = im->px + (size_t)(iy + r) * (size_t)im->w + ix;
+        const uint8_t *b = a + im->w;
+#if defined(__ARM_NEON)
+        uint8x8_t w00 = vdup_n_u8(w[0]), w01 = vdup_n_u8(w[1]);
+        uint8x8_t w10 = vdup_n_u8(w[2]), w11 = vdup_n_u8(w[3]);
+        for (int c = 0; c < WIN; c += 8) {
+            uint16x8_t s = vmull_u8(vld1_u8(a + c), w00);
+            s = vmlal_u8(s, vld1_u8(a + c + 1), w01);
+            s = vmlal_u8(s, vld1_u8(b + c), w10);
+            s = vmlal_u8(s, vld1_u8(b + c + 1), w11);
+            vst1q_s16(out + c, vreinterpretq_s16_u16(s));
+        }
+#elif defined(__SSE2__)
+        const __m128i z = _mm_setzero_si128();
+        __m128i w00 = _mm_set1_epi16(w[0]), w01 = _mm_set1_epi16(w[1]);
+        __m128i w10 = _mm_set1_epi16(w[2]), w11 = _mm_set1_epi16(w[3]);
+        for (int c = 0; c < WIN; c += 16) {
+            __m128i a0 = _mm_loadu_si128((const __m128i *)(a + c));
+            __m128i a1 = _mm_loadu_si128((const __m128i *)(a + c + 1));
+            __m128i b0 = _mm_loadu_si128((const __m128i *)(b + c));
+            __m128i b1 = _mm_loadu_si128((const __m128i *)(b + c + 1));
+#define BILERP(unpack)                                                   \
+    _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(unpack(a0, z), w00),     \
+                                _mm_mullo_epi16(unpack(a1, z), w01)),    \
+                  _mm_add_epi16(_mm_mullo_epi16(unpack(b0, z), w10),     \
+                                _mm_mullo_epi16(unpack(b1, z), w11)))
+            _mm_storeu_si128((__m128i *)(out + c), BILERP(_mm_unpacklo_epi8));
+            _mm_storeu_si128((__m128i *)(out + c + 8), BILERP(_mm_unpackhi_epi8));
+#undef BILERP
+        }
+#else
+        for (int c = 0; c < WIN; c++)
+            out[c] = (int16_t)(a[c] * w[0] + a[c + 1] * w[1] + b[c] * w[2] + b[c + 1] * w[3]);
+#endif
+    }
+}
+
+/* out = a - b over n (multiple of 8) entries; inputs are in [0, 32640] */
+static void sub(const int16_t *a, const int16_t *b, int16_t *out, int n) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i < n; i += 8) vst1q_s16(out + i, vsubq_s16(vld1q_s16(a + i), vld1q_s16(b + i)));
+#elif defined(__SSE2__)
+    for (; i < n; i += 8)
+        _mm_storeu_si128((__m128i *)(out + i),
+                         _mm_sub_epi16(_mm_loadu_si128((const __m128i *)(a + i)),
+                                       _mm_loadu_si128((const __m128i *)(b + i))));
+#endif
+    for (; i < n; i++) out[i] = (int16_t)(a[i] - b[i]);
+}
+
+/* Exact sum of a[i] * b[i], n a multiple of 8, |a|, |b| <= 32640 */
+static int64_t dot(const int16_t *a, const int16_t *b, int n) {
+    int64_t s = 0;
+    int i = 0;
+#if defined(__ARM_NEON)
+    int64x2_t acc = vdupq_n_s64(0);
+    for (; i < n; i += 8) {
+        int16x8_t x = vld1q_s16(a + i), y = vld1q_s16(b + i);
+        acc = vpadalq_s32(acc, vmull_s16(vget_low_s16(x), vget_low_s16(y)));
+        acc = vpadalq_s32(acc, vmull_s16(vget_high_s16(x), vget_high_s16(y)));
+    }
+    s = vgetq_lane_s64(acc, 0) + vgetq_lane_s64(acc, 1);
+#elif defined(__SSE2__)
+    /* madd pairs stay below 2^31: 2 * 32640^2 = 2130739200 */
+    __m128i acc = _mm_setzero_si128();
+    for (; i < n; i += 8) {
+        __m128i p = _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(a + i)),
+                                   _mm_loadu_si128((const __m128i *)(b + i)));
+        __m128i sign = _mm_srai_epi32(p, 31);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(p, sign));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(p, sign));
+    }
+    int64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    s = lanes[0] + lanes[1];
+#endif
+    for (; i < n; i++) s += (int64_t)a[i] * b[i];
+    return s;
+}
+
+const char *vps_vo_isa(void) {
+    return ISA;
+}
+
+/* --- Pyramids --- */
+
+vps_vo_config_t vps_vo_default_config(void) {
+    vps_vo_config_t c;
+    c.levels = 3;
+    c.grid = 10;
+    c.max_iters = 10;
+    c.min_eig = 4.0;
+    c.max_fb_px = 0.5;
+    c.inlier_px = 1.5;
+    c.min_inliers = 12;
+    c.focal_px = 500.0;
+    c.hdop_per_m = 0.02;
+    return c;
+}
+
+static int sel_level(const vps_vo_t *vo) {
+    return vo->cfg.levels - 1 < SEL_LEVEL ? vo->cfg.levels - 1 : SEL_LEVEL;
+}
+
+bool vps_vo_init(vps_vo_t *vo, const vps_vo_config_t *cfg, int width, int height) {
+    memset(vo, 0, sizeof(*vo));
+    vo->cfg = cfg ? *cfg : vps_vo_default_config();
+    if (vo->cfg.levels < 1) vo->cfg.levels = 1;
+    if (vo->cfg.levels > VPS_VO_MAX_LEVELS) vo->cfg.levels = VPS_VO_MAX_LEVELS;
+    if (vo->cfg.grid < 1) vo->cfg.grid = 1;
+    while (vo->cfg.grid * vo->cfg.grid > VPS_VO_MAX_FEATURES) vo->cfg.grid--;
+    vo->width = width;
+    vo->height = height;
+
+    /* The top level must hold a window plus its gradient border */
+    int top = vo->cfg.levels - 1;
+    if ((width >> top) < 2 * WIN + 4 || (height >> top) < 2 * WIN + 4) return false;
+
+    for (int k = 0; k < 2; k++)
+        for (int l = 0; l < vo->cfg.levels; l++) {
+            vps_vo_image_t *im = &vo->pyr[k][l];
+            im->w = width >> l;
+            im->h = height >> l;
+            im->px = malloc((size_t)im->w * (size_t)im->h);
+            if (!im->px) {
+                vps_vo_free(vo);
+                return false;
+            }
+        }
+    int s = sel_level(vo);
+    vo->score = malloc(sizeof(int32_t) * 3 * (size_t)(width >> s) * (size_t)(height >> s));
+    if (!vo->score) {
+        vps_vo_free(vo);
+        return false;
+    }
+    return true;
+}
+
+void vps_vo_free(vps_vo_t *vo) {
+    for (int k = 0; k < 2; k++)
+        for (int l = 0; l < VPS_VO_MAX_LEVELS; l++) {
+            free(vo->pyr[k][l].px);
+            vo->pyr[k][l].px = NULL;
+        }
+    free(vo->score);
+    vo->score = NULL;
+}
+
+void vps_vo_reset(vps_vo_t *vo) {
+    vo->has_prev = false;
+    vo->n_features = 0;
+}
+
+static void build_pyramid(vps_vo_t *vo, vps_vo_image_t *pyr, const uint8_t *pixels, int stride) {
+    for (int y = 0; y < vo->height; y++)
+        memcpy(pyr[0].px + (size_t)y * (size_t)vo->width, pixels + (size_t)y * (size_t)stride,
+               (size_t)vo->width);
+    for (int l = 1; l < vo->cfg.levels; l++) {
+        const vps_vo_image_t *s = &pyr[l - 1];
+        vps_vo_image_t *d = &pyr[l];
+        for (int y = 0; y < d->h; y++) {
+            const uint8_t *s0 = s->px + (size_t)(2 * y) * (size_t)s->w;
+            down_row(s0, s0 + s->w, d->px + (size_t)y * (size_t)d->w, d->w);
+        }
+    }
+}
+
+/* --- Corners --- */
+
+/* Level-0 border that keeps a point trackable on every level */
+static int margin0(const vps_vo_t *vo) {
+    return (WIN / 2 + 3) << (vo->cfg.levels - 1);
+}
+
+/* Best Shi-Tomasi corner per grid cell on the selection level */
+static void select_features(vps_vo_t *vo, const vps_vo_image_t *pyr) {
+    int s = sel_level(vo);
+    const vps_vo_image_t *im = &pyr[s];
+    int w = im->w, h = im->h;
+    int32_t *gxx = vo->score, *gxy = gxx + (size_t)w * h, *gyy = gxy + (size_t)w * h;
+    for (int y = 1; y < h - 1; y++) {
+        const uint8_t *p = im->px + (size_t)y * w;
+        for (int x = 1; x < w - 1; x++) {
+            int gx = p[x + 1] - p[x - 1], gy = p[x + w] - p[x - w];
+            size_t i = (size_t)y * w + x;
+            gxx[i] = gx * gx;
+            gxy[i] = gx * gy;
+            gyy[i] = gy * gy;
+        }
+    }
+
+    int m = (margin0(vo) >> s) + 1;
+    int g = vo->cfg.grid;
+    double cell_w = (double)(w - 2 * m) / g, cell_h = (double)(h - 2 * m) / g;
+    double min_score = vo->cfg.min_eig * 9.0 * 4.0;   /* 3x3 sum of doubled gradients */
+    vo->n_features = 0;
+    for (int cy = 0; cy < g; cy++)
+        for (int cx = 0; cx < g; cx++) {
+            int x0 = m + (int)(cx * cell_w), x1 = m + (int)((cx + 1) * cell_w);
+            int y0 = m + (int)(cy * cell_h), y1 = m + (int)((cy + 1) * cell_h);
+            double best = min_score;
+            int bx = -1, by = -1;
+            for (int y = y0; y < y1; y++)
+                for (int x = x0; x < x1; x++) {
+                    int64_t a = 0, b = 0, c = 0;
+                    for (int dy = -1; dy <= 1; dy++)
+                        for (int dx = -1; dx <= 1; dx++) {
+                            size_t i = (size_t)(y + dy) * w + (x + dx);
+                            a += gxx[i];
+                            b += gxy[i];
+                            c += gyy[i];
+                        }
+                    double d = (double)(a - c);
+                    double lmin = 0.5 * ((double)(a + c) - sqrt(d * d + 4.0 * (double)b * b));
+                    if (lmin > best) {
+                        best = lmin;
+                        bx = x;
+                        by = y;
+                    }
+                }
+            if (bx < 0) continue;
+            float k = (float)(1 << s);
+            vo->features[vo->n_features][0] = ((float)bx + 0.5f) * k - 0.5f;
+            vo->features[vo->n_features][1] = ((float)by + 0.5f) * k - 0.5f;
+            vo->n_features++;
+        }
+}
+
+/* --- Pyramidal Lucas-Kanade --- */
+
+/* Integer top-left and 7-bit bilinear weights for a window centred at (x, y) */
+static void window_at(double x, double y, int *ix, int *iy, uint8_t w[4]) {
+    double xs = x - (WIN - 1) * 0.5, ys = y - (WIN - 1) * 0.5;
+    double fx0 = floor(xs), fy0 = floor(ys);
+    double fx = xs - fx0, fy = ys - fy0;
+    *ix = (int)fx0;
+    *iy = (int)fy0;
+    int v[4] = {(int)lrint((1 - fx) * (1 - fy) * 128), (int)lrint(fx * (1 - fy) * 128),
+                (int)lrint((1 - fx) * fy * 128), (int)lrint(fx * fy * 128)};
+    /* The largest weight (>= 32) absorbs the rounding so the sum is 128 */
+    int big = 0;
+    for (int i = 1; i < 4; i++)
+        if (v[i] > v[big]) big = i;
+    v[big] = 128 - (v[0] + v[1] + v[2] + v[3] - v[big]);
+    for (int i = 0; i < 4; i++) w[i] = (uint8_t)v[i];
+}
+
+static bool fits(const vps_vo_image_t *im, int ix, int iy, int rows) {
+    return ix >= 0 && iy >= 0 && ix + WIN < im->w && iy + rows < im->h;
+}
+
+static bool finite_coord(double x, double y) {
+    return fabs(x) < 1e6 && fabs(y) < 1e6;
+}
+
+/* Track one point from pyramid a into pyramid b; p and q in level-0 pixels */
+static bool track_point(const vps_vo_t *vo, const vps_vo_image_t *a, const vps_vo_image_t *b,
+                        const float p[2], float q[2]) {
+    int16_t tud[(WIN + 2) * WIN], tl[NPIX], tr[NPIX], gx[NPIX], gy[NPIX];
+    int16_t j[NPIX], d[NPIX];
+    double min_eig = vo->cfg.min_eig * NPIX * 128.0 * 128.0 * 4.0;
+    double gux = 0.0, guy = 0.0;   /* guess at the current level */
+
+    for (int l = vo->cfg.levels - 1; l >= 0; l--) {
+        double k = 1.0 / (double)(1 << l);
+        double px = (p[0] + 0.5) * k - 0.5, py = (p[1] + 0.5) * k - 0.5;
+        int ix, iy;
+        uint8_t w[4];
+        window_at(px, py, &ix, &iy, w);
+        if (!fits(&a[l], ix - 1, iy - 1, WIN + 2) || !fits(&a[l], ix + 1, iy, WIN))
+            return false;
+
+        /* Template and unhalved central-difference gradients */
+        patch(&a[l], ix, iy - 1, w, WIN + 2, tud);
+        patch(&a[l], ix - 1, iy, w, WIN, tl);
+        patch(&a[l], ix + 1, iy, w, WIN, tr);
+        const int16_t *t = tud + WIN;
+        sub(tr, tl, gx, NPIX);
+        sub(tud + 2 * WIN, tud, gy, NPIX);
+        double gxx = (double)dot(gx, gx, NPIX), gxy = (double)dot(gx, gy, NPIX);
+        double gyy = (double)dot(gy, gy, NPIX);
+        double det = gxx * gyy - gxy * gxy;
+        double lmin = 0.5 * (gxx + gyy - sqrt((gxx - gyy) * (gxx - gyy) + 4.0 * gxy * gxy));
+        if (lmin < min_eig || det <= 0.0) return false;
+
+        double vx = 0.0, vy = 0.0;
+        for (int it = 0; it < vo->cfg.max_iters; it++) {
+            double qx = px + gux + vx, qy = py + guy + vy;
+            if (!finite_coord(qx, qy)) return false;
+            int jx, jy;
+            uint8_t wj[4];
+            window_at(qx, qy, &jx, &jy, wj);
+            if (!fits(&b[l], jx, jy, WIN)) return false;
+            patch(&b[l], jx, jy, wj, WIN, j);
+            sub(t, j, d, NPIX);
+            double bx = (double)dot(d, gx, NPIX), by = (double)dot(d, gy, NPIX);
+            /* Gradients are doubled: delta = 2 G^-1 b */
+            double dx = 2.0 * (gyy * bx - gxy * by) / det;
+            double dy = 2.0 * (gxx * by - gxy * bx) / det;
+            vx += dx;
+            vy += dy;
+            if (dx * dx + dy * dy < 1e-4) break;
+        }
+        if (l > 0) {
+            gux = 2.0 * (gux + vx);
+            guy = 2.0 * (guy + vy);
+        } else {
+            gux += vx;
+            guy += vy;
+        }
+    }
+    q[0] = (float)(p[0] + gux);
+    q[1] = (float)(p[1] + guy);
+    return true;
+}
+
+static int track(const vps_vo_t *vo, const vps_vo_image_t *a, const vps_vo_image_t *b,
+                 const float (*pts0)[2], int n, float (*pts1)[2], bool *status) {
+    int ok = 0;
+    for (int i = 0; i < n; i++) {
+        status[i] = track_point(vo, a, b, pts0[i], pts1[i]);
+        ok += status[i];
+    }
+    return ok;
+}
+
+int vps_vo_track(const vps_vo_t *vo, const float (*pts0)[2], int n,
+                 float (*pts1)[2], bool *status) {
+    return track(vo, vo->pyr[vo->cur ^ 1], vo->pyr[vo->cur], pts0, n, pts1, status);
+}
+
+/* --- Motion --- */
+
+typedef struct {
+    double ar, ai;   /* q = a p + t with a = s e^{i theta} as a complex number */
+    double tx, ty;
+} sim2_t;
+
+static int count_inliers(const sim2_t *m, const double (*p)[2], const double (*q)[2], int n,
+                         double tol2, bool *in) {
+    int c = 0;
+    for (int i = 0; i < n; i++) {
+        double ex = m->ar * p[i][0] - m->ai * p[i][1] + m->tx - q[i][0];
+        double ey = m->ai * p[i][0] + m->ar * p[i][1] + m->ty - q[i][1];
+        in[i] = ex * ex + ey * ey < tol2;
+        c += in[i];
+    }
+    return c;
+}
+
+/* Least-squares similarity over the inliers */
+static bool fit_sim2(const double (*p)[2], const double (*q)[2], const bool *in, int n,
+                     sim2_t *m) {
+    double mpx = 0, mpy = 0, mqx = 0, mqy = 0;
+    int c = 0;
+    for (int i = 0; i < n; i++)
+        if (in[i]) {
+            mpx += p[i][0];
+            mpy += p[i][1];
+            mqx += q[i][0];
+            mqy += q[i][1];
+            c++;
+        }
+    if (c < 2) return false;
+    mpx /= c;
+    mpy /= c;
+    mqx /= c;
+    mqy /= c;
+    double sr = 0, si = 0, pp = 0;
+    for (int i = 0; i < n; i++)
+        if (in[i]) {
+            double ux = p[i][0] - mpx, uy = p[i][1] - mpy;
+            double vx = q[i][0] - mqx, vy = q[i][1] - mqy;
+            sr += vx * ux + vy * uy;   /* sum v * conj(u) */
+            si += vy * ux - vx * uy;
+            pp += ux * ux + uy * uy;
+        }
+    if (pp <= 0) return false;
+    m->ar = sr / pp;
+    m->ai = si / pp;
+    m->tx = mqx - (m->ar * mpx - m->ai * mpy);
+    m->ty = mqy - (m->ai * mpx + m->ar * mpy);
+    return true;
+}
+
+/* Deterministic 2-point RANSAC, then two least-squares refits */
+static int estimate(const vps_vo_t *vo, const double (*p)[2], const double (*q)[2], int n,
+                    sim2_t *best, bool *in, double *rms) {
+    enum { HYPOTHESES = 64 };
+    bool tmp[VPS_VO_MAX_FEATURES];
+    double tol2 = vo->cfg.inlier_px * vo->cfg.inlier_px;
+    int best_n = 0;
+    memset(in, 0, sizeof(bool) * (size_t)n);
+    uint32_t seed = 0x9e3779b9u ^ (uint32_t)vo->frames;
+    for (int h = 0; h < HYPOTHESES && n >= 2; h++) {
+        seed = seed * 1664525u + 1013904223u;
+        int i = (int)((seed >> 8) % (uint32_t)n);
+        seed = seed * 1664525u + 1013904223u;
+        int j = (int)((seed >> 8) % (uint32_t)n);
+        double ux = p[j][0] - p[i][0], uy = p[j][1] - p[i][1];
+        double uu = ux * ux + uy * uy;
+        if (i == j || uu < 400.0) continue;
+        double vx = q[j][0] - q[i][0], vy = q[j][1] - q[i][1];
+        sim2_t m;
+        m.ar = (vx * ux + vy * uy) / uu;
+        m.ai = (vy * ux - vx * uy) / uu;
+        m.tx = q[i][0] - (m.ar * p[i][0] - m.ai * p[i][1]);
+        m.ty = q[i][1] - (m.ai * p[i][0] + m.ar * p[i][1]);
+        int c = count_inliers(&m, p, q, n, tol2, tmp);
+        if (c > best_n) {
+            best_n = c;
+            *best = m;
+            memcpy(in, tmp, sizeof(bool) * (size_t)n);
+        }
+    }
+    for (int r = 0; r < 2 && best_n >= 2; r++) {
+        if (!fit_sim2(p, q, in, n, best)) return 0;
+        best_n = count_inliers(best, p, q, n, tol2, in);
+    }
+    double e2 = 0;
+    for (int i = 0; i < n; i++)
+        if (in[i]) {
+            double ex = best->ar * p[i][0] - best->ai * p[i][1] + best->tx - q[i][0];
+            double ey = best->ai * p[i][0] + best->ar * p[i][1] + best->ty - q[i][1];
+            e2 += ex * ex + ey * ey;
+        }
+    *rms = best_n > 0 ? sqrt(e2 / best_n) : 0.0;
+    return best_n;
+}
+
+bool vps_vo_process(vps_vo_t *vo, const uint8_t *pixels, int stride,
+                    double altitude_m, double heading_deg, vps_vo_motion_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->scale = 1.0;
+    vo->cur ^= 1;
+    const vps_vo_image_t *prev = vo->pyr[vo->cur ^ 1], *cur = vo->pyr[vo->cur];
+    build_pyramid(vo, vo->pyr[vo->cur], pixels, stride);
+    vo->frames++;
+
+    bool had_prev = vo->has_prev;
+    int n = vo->n_features;
+    float fwd[VPS_VO_MAX_FEATURES][2], back[VPS_VO_MAX_FEATURES][2];
+    bool st[VPS_VO_MAX_FEATURES], st_back[VPS_VO_MAX_FEATURES];
+    double p[VPS_VO_MAX_FEATURES][2], q[VPS_VO_MAX_FEATURES][2];
+    int m = 0;
+    if (had_prev && n > 0) {
+        track(vo, prev, cur, (const float(*)[2])vo->features, n, fwd, st);
+        if (vo->cfg.max_fb_px > 0) {
+            track(vo, cur, prev, (const float(*)[2])fwd, n, back, st_back);
+            double lim2 = vo->cfg.max_fb_px * vo->cfg.max_fb_px;
+            for (int i = 0; i < n; i++) {
+                double ex = back[i][0] - vo->features[i][0], ey = back[i][1] - vo->features[i][1];
+                st[i] = st[i] && st_back[i] && ex * ex + ey * ey < lim2;
+            }
+        }
+        /* Centre the coordinates so the similarity shift is the centre's */
+        double cx = (vo->width - 1) * 0.5, cy = (vo->height - 1) * 0.5;
+        for (int i = 0; i < n; i++)
+            if (st[i]) {
+                p[m][0] = vo->features[i][0] - cx;
+                p[m][1] = vo->features[i][1] - cy;
+                q[m][0] = fwd[i][0] - cx;
+                q[m][1] = fwd[i][1] - cy;
+                m++;
+            }
+    }
+    out->features = had_prev ? n : 0;
+    out->tracked = m;
+
+    /* Corners for the next frame */
+    select_features(vo, cur);
+    vo->has_prev = true;
+    if (!had_prev) return false;
+
+    sim2_t sim = {1.0, 0.0, 0.0, 0.0};
+    bool in[VPS_VO_MAX_FEATURES];
+    out->inliers = m >= 2 ? estimate(vo, (const double(*)[2])p, (const double(*)[2])q, m,
+                                     &sim, in, &out->rms_px)
+                          : 0;
+    if (out->inliers < vo->cfg.min_inliers) return false;
+
+    out->dx_px = sim.tx;
+    out->dy_px = sim.ty;
+    out->dtheta_rad = atan2(sim.ai, sim.ar);
+    out->scale = sqrt(sim.ar * sim.ar + sim.ai * sim.ai);
+
+    /* The ground moves opposite to the camera; image top is forward */
+    double gsd = altitude_m / vo->cfg.focal_px;
+    out->fwd_m = sim.ty * gsd;
+    out->right_m = -sim.tx * gsd;
+    double h = heading_deg * M_PI / 180.0, ch = cos(h), sh = sin(h);
+    out->dn_m = out->fwd_m * ch - out->right_m * sh;
+    out->de_m = out->fwd_m * sh + out->right_m * ch;
+    out->hdop_add = vo->cfg.hdop_per_m * hypot(out->fwd_m, out->right_m);
+    out->valid = true;
+    return true;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file test_common.h
+ * @brief Minimal check macros for the native unit tests.
+ *
+ * assert() is compiled out in Release (-DNDEBUG), so tests count
+ * failures explicitly and return non-zero from main.
+ */
+#ifndef TEST_COMMON_H
+#define TEST_COMMON_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+static int test_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        test_failures++; \
+    } \
+} while (0)
+
+#define CHECK_NEAR(a, b, tol) CHECK(fabs((double)(a) - (double)(b)) <= (tol))
+
+/*
+ * Seeded LCG shared by the tests, so a seed gives the same sequence in
+ * every file. Not for anything beyond test data.
+ */
+static inline unsigned test_rand_next(unsigned *seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed;
+}
+
+/** Uniform in [0, 1), 24 bits. */
+static inline double test_rand(unsigned *seed) {
+    return (test_rand_next(seed) >> 8) / 16777216.0;
+}
+
+/** 32 random bits from two draws (the low LCG bits are poor). */
+static inline uint32_t test_rand_u32(unsigned *seed) {
+    uint32_t hi = test_rand_next(seed) >> 8;
+    return hi << 16 ^ test_rand_next(seed) >> 8;
+}
+
+/** Roughly N(0, 1): sum of 12 uniforms minus 6. */
+static inline double test_rand_gauss(unsigned *seed) {
+    double s = 0.0;
+    for (int i = 0; i < 12; i++) s += test_rand(seed);
+    return s - 6.0;
+}
+
+/** Print summary and return the process exit code. */
+static inline int test_report(const char *name) {
+    if (test_failures) {
+        fprintf(stderr, "%s: %d failure(s)\n", name, test_failures);
+        return 1;
+    }
+    printf("%s: all tests passed\n", name);
+    return 0;
+}
+
+#endif /* TEST_COMMON_H */
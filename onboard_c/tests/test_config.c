@@ -0,0 +1,81 @@
+/**
+ * @file test_config.c
+ * @brief Tests for the VPSConfig JSON reader.
+ */
+#include "config.h"
+#include "test_common.h"
+#include <string.h>
+
+static void test_defaults(void) {
+    vps_config_t cfg;
+    vps_config_defaults(&cfg);
+    CHECK(strcmp(cfg.map_pack, "/opt/vps/maps/map_pack") == 0);
+    CHECK(cfg.camera.width == 640);
+    CHECK(cfg.uart.baudrate == 9600);
+    CHECK(cfg.uart.enabled);
+    CHECK(cfg.matcher.min_matches == 15);
+    CHECK_NEAR(cfg.target_hz, 3.0, 1e-12);
+    CHECK_NEAR(cfg.ekf_gate_threshold, 9.0, 1e-12);
+    CHECK(cfg.telemetry_dir[0] == '\0');
+}
+
+static void test_parse_model_dump(void) {
+    /* Shape of VPSConfig().model_dump_json() */
+    const char *json =
+        "{\"map_pack\":\"/data/maps\",\"camera\":{\"device\":2,\"width\":800,"
+        "\"height\":600,\"fps\":15,\"use_picamera2\":true},"
+        "\"uart\":{\"port\":\"/dev/ttyS1\",\"baudrate\":115200,\"enabled\":false},"
+        "\"matcher\":{\"superpoint_onnx\":\"m/sp.onnx\",\"lightglue_onnx\":\"m/lg.onnx\","
+        "\"min_matches\":20,\"confidence_threshold\":0.45,\"max_candidates\":8,"
+        "\"use_orb_fallback\":true},\"target_hz\":5.0,\"log_level\":\"DEBUG\","
+        "\"ekf_measurement_noise\":2e-8,\"ekf_gate_threshold\":7.5,"
+        "\"telemetry_dir\":null,\"extra\":[1,2,{\"a\":\"b\"}]}";
+
+    vps_config_t cfg;
+    vps_config_defaults(&cfg);
+    CHECK(vps_config_parse(&cfg, json));
+    CHECK(strcmp(cfg.map_pack, "/data/maps") == 0);
+    CHECK(strcmp(cfg.camera.device, "2") == 0);
+    CHECK(cfg.camera.width == 800);
+    CHECK(cfg.camera.height == 600);
+    CHECK(cfg.camera.use_picamera2);
+    CHECK(strcmp(cfg.uart.port, "/dev/ttyS1") == 0);
+    CHECK(cfg.uart.baudrate == 115200);
+    CHECK(!cfg.uart.enabled);
+    CHECK(strcmp(cfg.matcher.lightglue_onnx, "m/lg.onnx") == 0);
+    CHECK(cfg.matcher.min_matches == 20);
+    CHECK_NEAR(cfg.matcher.confidence_threshold, 0.45, 1e-12);
+    CHECK(cfg.matcher.max_candidates == 8);
+    CHECK(cfg.matcher.use_orb_fallback);
+    CHECK_NEAR(cfg.target_hz, 5.0, 1e-12);
+    CHECK(strcmp(cfg.log_level, "DEBUG") == 0);
+    CHECK_NEAR(cfg.ekf_measurement_noise, 2e-8, 1e-20);
+    CHECK_NEAR(cfg.ekf_gate_threshold, 7.5, 1e-12);
+    CHECK(cfg.telemetry_dir[0] == '\0');
+}
+
+static void test_partial_keeps_defaults(void) {
+    vps_config_t cfg;
+    vps_config_defaults(&cfg);
+    CHECK(vps_config_parse(&cfg, "{ \"uart\": { \"port\": \"/dev/serial0\" } }"));
+    CHECK(strcmp(cfg.uart.port, "/dev/serial0") == 0);
+    CHECK(cfg.uart.baudrate == 9600);
+    CHECK(cfg.camera.width == 640);
+}
+
+static void test_invalid(void) {
+    vps_config_t cfg;
+    vps_config_defaults(&cfg);
+    CHECK(!vps_config_parse(&cfg, "{\"target_hz\": }"));
+    CHECK(!vps_config_parse(&cfg, "{\"target_hz\": 3.0"));
+    CHECK(!vps_config_parse(&cfg, "[]"));
+    CHECK(!vps_config_load(&cfg, "/nonexistent/config.json"));
+}
+
+int main(void) {
+    test_defaults();
+    test_parse_model_dump();
+    test_partial_keeps_defaults();
+    test_invalid();
+    return test_report("test_config");
+}
@@ -0,0 +1,132 @@
+/**
+ * @file test_coord_batch.c
+ * @brief Batch conversions against the scalar libm versions, on every
+ *        available lane kernel, with the error in metres at z19.
+ */
+#include "coord_batch.h"
+#include "geo_transform.h"
+#include "test_common.h"
+#include "tile_math.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define N 20000
+
+static double lat[N], lon[N], px[N], py[N], lat2[N], lon2[N];
+static int tx[N], ty[N];
+
+/* Metres per global pixel at z19 and lat */
+static double m_per_px19(double la) {
+    return vps_meters_per_pixel(la, 19);
+}
+
+static void fill(unsigned *seed) {
+    for (int i = 0; i < N; i++) {
+        lat[i] = (2.0 * test_rand(seed) - 1.0) * VPS_MAX_MERCATOR_LAT;
+        lon[i] = (2.0 * test_rand(seed) - 1.0) * 180.0;
+    }
+    lat[0] = 0.0;
+    lat[1] = VPS_MAX_MERCATOR_LAT;
+    lat[2] = -VPS_MAX_MERCATOR_LAT;
+    lat[3] = 1e-12;
+    lon[4] = -180.0;
+    lon[5] = 179.999999999;
+}
+
+/* Forward and inverse at z19 against the scalar calls; worst error in metres */
+static void test_z19(double *fwd_m, double *inv_m) {
+    unsigned seed = 3;
+    fill(&seed);
+    vps_gps_to_tile_pixel_batch(lat, lon, N, 19, tx, ty, px, py);
+    *fwd_m = 0.0;
+    for (int i = 0; i < N; i++) {
+        vps_tile_coord_t t;
+        vps_pixel_t p;
+        vps_gps_to_tile_pixel((vps_geopoint_t){lat[i], lon[i]}, 19, &t, &p);
+        double dx = (tx[i] - t.x) * 256.0 + px[i] - p.x;
+        double dy = (ty[i] - t.y) * 256.0 + py[i] - p.y;
+        *fwd_m = fmax(*fwd_m, sqrt(dx * dx + dy * dy) * m_per_px19(lat[i]));
+        if (tx[i] != t.x || ty[i] != t.y)   /* only on a tile edge */
+            CHECK(fmin(fmin(px[i], 256.0 - px[i]), fmin(py[i], 256.0 - py[i])) < 1e-6);
+    }
+
+    /* Inverse of the scalar tile/pixel of each point */
+    for (int i = 0; i < N; i++) {
+        vps_tile_coord_t t;
+        vps_pixel_t p;
+        vps_gps_to_tile_pixel((vps_geopoint_t){lat[i], lon[i]}, 19, &t, &p);
+        tx[i] = t.x;
+        ty[i] = t.y;
+        px[i] = p.x;
+        py[i] = p.y;
+    }
+    vps_tile_pixel_to_gps_batch(tx, ty, px, py, N, 19, lat2, lon2);
+    *inv_m = 0.0;
+    for (int i = 0; i < N; i++) {
+        vps_geopoint_t want = vps_tile_pixel_to_gps((vps_tile_coord_t){19, tx[i], ty[i]},
+                                                    (vps_pixel_t){px[i], py[i]});
+        double dn = (lat2[i] - want.lat) * 111195.0;
+        double de = (lon2[i] - want.lon) * 111195.0 * cos(want.lat * M_PI / 180.0);
+        *inv_m = fmax(*inv_m, sqrt(dn * dn + de * de));
+        CHECK_NEAR(lat2[i], lat[i], 1e-9);   /* round trip */
+    }
+}
+
+static void test_zooms_and_tails(void) {
+    unsigned seed = 9;
+    fill(&seed);
+    for (int z = 0; z <= 22; z++) {
+        vps_gps_to_tile_batch(lat, lon, 1000, z, tx, ty);
+        int mismatches = 0;
+        for (int i = 0; i < 1000; i++) {
+            vps_tile_coord_t t = vps_gps_to_tile((vps_geopoint_t){lat[i], lon[i]}, z);
+            mismatches += tx[i] != t.x || ty[i] != t.y;
+            CHECK(tx[i] >= 0 && ty[i] >= 0 && tx[i] < (1 << z) && ty[i] < (1 << z));
+        }
+        CHECK(mismatches == 0);
+    }
+    /* Every tail length writes exactly n outputs */
+    for (int n = 1; n <= 9; n++) {
+        memset(tx, 0x7f, sizeof(int) * 16);
+        memset(lat2, 0, sizeof(double) * 16);
+        vps_gps_to_tile_pixel_batch(lat, lon, n, 15, tx, ty, px, py);
+        for (int i = 0; i < n; i++) {
+            vps_tile_coord_t t;
+            vps_pixel_t p;
+            vps_gps_to_tile_pixel((vps_geopoint_t){lat[i], lon[i]}, 15, &t, &p);
+            CHECK(tx[i] == t.x && ty[i] == t.y);
+            CHECK_NEAR(px[i], p.x, 1e-6);
+        }
+        CHECK(tx[n] == 0x7f7f7f7f);
+        vps_tile_pixel_to_gps_batch(tx, ty, px, py, n, 15, lat2, lon2);
+        for (int i = 0; i < n; i++) CHECK_NEAR(lat2[i], lat[i], 1e-9);
+        CHECK(lat2[n] == 0.0);
+    }
+    /* Beyond the Mercator limit: clamped to the first / last row */
+    double plat[] = {89.9, -89.9}, plon[] = {0.0, 0.0};
+    vps_gps_to_tile_batch(plat, plon, 2, 10, tx, ty);
+    CHECK(ty[0] == 0 && ty[1] == 1023);
+    vps_gps_to_tile_batch(plat, plon, 0, 10, NULL, NULL);
+}
+
+int main(void) {
+    const char *simd = vps_coord_batch_isa();
+    CHECK(!strcmp(simd, "avx2") || !strcmp(simd, "neon") || !strcmp(simd, "scalar"));
+    for (int pass = 0; pass < 2; pass++) {
+        const char *isa = vps_coord_batch_use_simd(pass == 0);
+        CHECK(pass == 0 ? !strcmp(isa, simd) : !strcmp(isa, "scalar"));
+        double fwd_m, inv_m;
+        test_z19(&fwd_m, &inv_m);
+        printf("%s lanes: max error at z19 %.2e m forward, %.2e m inverse\n", isa, fwd_m,
+               inv_m);
+        CHECK(fwd_m < VPS_COORD_BATCH_MAX_ERR_M);
+        CHECK(inv_m < VPS_COORD_BATCH_MAX_ERR_M);
+        test_zooms_and_tails();
+    }
+    vps_coord_batch_use_simd(true);
+    return test_report("test_coord_batch");
+}
@@ -0,0 +1,155 @@
+/**
+ * @file test_ekf32.c
+ * @brief Float32 local-frame EKF vs. the double-precision degree filter.
+ */
+#include "ekf32.h"
+#include "fusion.h"
+#include "test_common.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Position error in meters between two geopoints */
+static double dist_m(vps_geopoint_t a, vps_geopoint_t b) {
+    double dn = (a.lat - b.lat) * 111320.0;
+    double de = (a.lon - b.lon) * 111320.0 * cos(a.lat * M_PI / 180.0);
+    return sqrt(dn * dn + de * de);
+}
+
+/* One hour at 3 Hz: 15 m/s figure-eights drifting north-east, 3 m noise,
+ * varying HDOP, dropouts and the odd outlier. */
+static void test_one_hour_matches_double(void) {
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+    vps_ekf_state_t ref;
+    vps_ekf_init(&ref);
+    vps_ekf32_t f;
+    vps_ekf32_init(&f, 0.0);
+
+    unsigned seed = 11;
+    double max_err = 0.0;
+    int mismatched_gate = 0, n = 0;
+    double lat = 47.3, lon = 8.5;
+    for (int k = 0; k < 3 * 3600; k++) {
+        double t = k / 3.0;
+        double vn = 15.0 * sin(t / 40.0) + 2.0, ve = 15.0 * sin(t / 20.0) + 1.5;
+        lat += vn / 3.0 / 111320.0;
+        lon += ve / 3.0 / (111320.0 * cos(lat * M_PI / 180.0));
+        if ((k / 150) % 7 == 6) continue;   /* 50 s of every 350 s without fixes */
+
+        double hdop = 0.8 + 0.6 * (0.5 + 0.5 * sin(t / 7.0));
+        double gn = test_rand_gauss(&seed), ge = test_rand_gauss(&seed);
+        vps_geopoint_t z = {lat + 3.0 * gn / 111320.0,
+                            lon + 3.0 * ge / (111320.0 * cos(lat * M_PI / 180.0))};
+        if (k % 97 == 0) z.lat += 0.01;      /* gated outlier */
+
+        bool a = vps_ekf_update(&ref, &cfg, z, hdop, t);
+        bool b = vps_ekf32_update(&f, &cfg, z, hdop, t);
+        if (a != b) mismatched_gate++;
+        double e = dist_m(vps_ekf_position(&ref), vps_ekf32_position(&f));
+        if (e > max_err) max_err = e;
+        n++;
+    }
+    printf("ekf32: %d updates, %u re-anchors, max |double - float32| = %.2f mm\n",
+           n, f.reanchors, max_err * 1e3);
+    CHECK(max_err < 0.01);
+    CHECK(mismatched_gate == 0);
+    CHECK(f.reanchors > 10);
+    CHECK_NEAR(vps_ekf32_speed(&f), vps_ekf_speed(&ref), 0.01);
+
+    vps_geopoint_t pa = vps_ekf_predict(&ref, ref.last_t + 2.0);
+    vps_geopoint_t pb = vps_ekf32_predict(&f, f.last_t + 2.0);
+    CHECK(dist_m(pa, pb) < 0.01);
+}
+
+static void test_state_round_trip(void) {
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+    vps_ekf32_t f;
+    vps_ekf32_init(&f, 200.0);
+    for (int i = 0; i < 50; i++)
+        vps_ekf32_update(&f, &cfg, (vps_geopoint_t){-33.9 + 1e-4 * i, 151.2 + 5e-5 * i}, 1.0, i);
+
+    vps_ekf_state_t s;
+    vps_ekf32_to_state(&f, &s);
+    CHECK(s.initialized && s.last_t == f.last_t);
+    CHECK(dist_m(vps_ekf_position(&s), vps_ekf32_position(&f)) < 1e-6);
+
+    vps_ekf32_t g;
+    vps_ekf32_init(&g, 200.0);
+    vps_ekf32_from_state(&g, &s);
+    CHECK(dist_m(vps_ekf32_position(&g), vps_ekf32_position(&f)) < 1e-6);
+    CHECK_NEAR(vps_ekf32_speed(&g), vps_ekf32_speed(&f), 1e-4);
+    CHECK(g.x[0] == 0.0f && g.x[1] == 0.0f);   /* re-anchored at the state */
+
+    /* Both continue identically (up to float rounding) */
+    vps_geopoint_t z = {-33.9 + 1e-4 * 50, 151.2 + 5e-5 * 50};
+    vps_ekf32_update(&f, &cfg, z, 1.0, 50.0);
+    vps_ekf32_update(&g, &cfg, z, 1.0, 50.0);
+    CHECK(dist_m(vps_ekf32_position(&g), vps_ekf32_position(&f)) < 1e-3);
+}
+
+static void test_fusion_mode(void) {
+    vps_fusion_t a, b;
+    vps_fusion_init(&a, NULL, 10.0, NULL);
+    vps_fusion_init(&b, NULL, 10.0, NULL);
+    vps_fusion_use_ekf32(&b, true);
+    for (int i = 0; i < 30; i++) {
+        vps_geopoint_t z = {52.0 + 5e-5 * i, 13.0 + 2e-5 * i};
+        vps_fusion_output_t oa = vps_fusion_update(&a, &z, 1.0, i * 0.5);
+        vps_fusion_output_t ob = vps_fusion_update(&b, &z, 1.0, i * 0.5);
+        CHECK(oa.ekf_accepted == ob.ekf_accepted);
+        CHECK(dist_m(oa.position, ob.position) < 0.01);
+    }
+    vps_fusion_output_t oa = vps_fusion_update(&a, NULL, 0.0, 15.5);
+    vps_fusion_output_t ob = vps_fusion_update(&b, NULL, 0.0, 15.5);
+    CHECK(ob.source == VPS_SOURCE_EKF_PREDICT);
+    CHECK(dist_m(oa.position, ob.position) < 0.01);
+    CHECK_NEAR(oa.speed_mps, ob.speed_mps, 0.01);
+}
+
+static void test_bank_lanes(void) {
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+    vps_ekf32_t f;
+    vps_ekf32_init(&f, 0.0);
+    for (int i = 0; i < 20; i++)
+        vps_ekf32_update(&f, &cfg, (vps_geopoint_t){52.0 + 1e-5 * i, 13.0}, 1.0, i / 3.0);
+
+    int n = 37;   /* not a multiple of any lane width */
+    float zn[VPS_EKF32_BANK_MAX], ze[VPS_EKF32_BANK_MAX];
+    float rn[VPS_EKF32_BANK_MAX], re[VPS_EKF32_BANK_MAX], d[VPS_EKF32_BANK_MAX];
+    for (int i = 0; i < n; i++) {
+        zn[i] = f.x[0] + 2.0f * (i % 9) - 6.0f + 25.0f * (i % 5 == 4);
+        ze[i] = f.x[1] + 1.5f * (i % 7) - 3.0f;
+        rn[i] = re[i] = 124.0f * (1.0f + 0.1f * i);
+    }
+    float qn = (float)(cfg.process_noise * f.m_lat * f.m_lat);
+    float qe = (float)(cfg.process_noise * f.m_lon * f.m_lon);
+    vps_ekf32_bank_t b;
+    vps_ekf32_bank_broadcast(&b, &f, n);
+    vps_ekf32_bank_propagate(&b, qn, qe, 0.4f);
+    int passed = vps_ekf32_bank_correct(&b, zn, ze, rn, re, 1.5f, d);
+
+    int expect = 0;
+    for (int i = 0; i < n; i++) {
+        float x[4], p[VPS_EKF_PACKED];
+        for (int k = 0; k < 4; k++) x[k] = f.x[k];
+        for (int k = 0; k < VPS_EKF_PACKED; k++) p[k] = f.p[k];
+        vps_ekf32_propagate(x, p, qn, qe, 0.4f);
+        float ds = vps_ekf32_correct(x, p, zn[i], ze[i], rn[i], re[i], 1.5f);
+        if (ds <= 1.5f) expect++;
+        CHECK_NEAR(d[i], ds, 1e-4 * ds + 1e-6);
+        for (int k = 0; k < 4; k++) CHECK_NEAR(b.x[k][i], x[k], 1e-3);
+        for (int k = 0; k < VPS_EKF_PACKED; k++) CHECK_NEAR(b.p[k][i], p[k], 1e-4 * fabs(p[k]) + 1e-6);
+    }
+    CHECK(passed == expect);
+    CHECK(passed > 0 && passed < n);
+}
+
+int main(void) {
+    printf("ekf32 bank ISA: %s\n", vps_ekf32_bank_isa());
+    test_one_hour_matches_double();
+    test_state_round_trip();
+    test_fusion_mode();
+    test_bank_lanes();
+    return test_report("test_ekf32");
+}
@@ -0,0 +1,229 @@
+/**
+ * @file test_ekf_bank.c
+ * @brief SIMD EKF bank vs. the scalar kernel, and candidate scoring.
+ */
+#include "ekf_bank.h"
+#include "fusion.h"
+#include "geo_transform.h"
+#include "runtime.h"
+#include "test_common.h"
+#include <string.h>
+
+static void random_lane(unsigned *seed, double x[4], double p[VPS_EKF_PACKED]) {
+    double A[4][4], P[4][4];
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++) A[i][j] = 1e-4 * (test_rand(seed) - 0.5);
+    for (int i = 0; i < 4; i++) {
+        x[i] = (i < 2 ? 50.0 : 0.0) + 1e-4 * (test_rand(seed) - 0.5);
+        for (int j = 0; j < 4; j++) {
+            double s = 0;
+            for (int k = 0; k < 4; k++) s += A[i][k] * A[j][k];
+            P[i][j] = s + (i == j ? 1e-9 : 0.0);
+        }
+    }
+    vps_ekf_pack_cov(p, &P[0][0]);
+}
+
+static bool close_rel(double a, double b, double rel) {
+    return fabs(a - b) <= rel * fmax(fmax(fabs(a), fabs(b)), 1e-300);
+}
+
+static void test_lanes_match_scalar_kernel(void) {
+    static const int sizes[] = {1, 3, 8, 13, 64};
+    unsigned seed = 5;
+    int total_passed = 0, total = 0;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int n = sizes[s];
+        vps_ekf_bank_t bank;
+        vps_ekf_bank_init(&bank, n);
+        double xs[VPS_EKF_BANK_MAX][4], ps[VPS_EKF_BANK_MAX][VPS_EKF_PACKED];
+        double lat[VPS_EKF_BANK_MAX], lon[VPS_EKF_BANK_MAX], r[VPS_EKF_BANK_MAX];
+        double d[VPS_EKF_BANK_MAX];
+        for (int i = 0; i < n; i++) {
+            random_lane(&seed, xs[i], ps[i]);
+            vps_ekf_bank_set(&bank, i, xs[i], ps[i]);
+            lat[i] = xs[i][0] + 4e-4 * (test_rand(&seed) - 0.5);
+            lon[i] = xs[i][1] + 4e-4 * (test_rand(&seed) - 0.5);
+            r[i] = 1e-8 * (1.0 + test_rand(&seed));
+        }
+        double gate = 2.0;  /* some lanes pass, some do not */
+
+        vps_ekf_bank_propagate(&bank, 1e-6, 0.3);
+        int passed = vps_ekf_bank_correct(&bank, lat, lon, r, gate, d);
+
+        int expect_passed = 0;
+        for (int i = 0; i < n; i++) {
+            vps_ekf_propagate(xs[i], ps[i], 1e-6, 0.3);
+            double ds = vps_ekf_correct(xs[i], ps[i], (vps_geopoint_t){lat[i], lon[i]},
+                                        r[i], gate);
+            if (ds <= gate) expect_passed++;
+            CHECK(close_rel(d[i], ds, 1e-9));
+
+            double x[4], p[VPS_EKF_PACKED];
+            vps_ekf_bank_get(&bank, i, x, p);
+            for (int k = 0; k < 4; k++) CHECK(close_rel(x[k], xs[i][k], 1e-12));
+            for (int k = 0; k < VPS_EKF_PACKED; k++)
+                CHECK(fabs(p[k] - ps[i][k]) <= 1e-9 * fmax(fabs(ps[i][0]), fabs(ps[i][4])));
+        }
+        CHECK(passed == expect_passed);
+        total_passed += passed;
+        total += n;
+    }
+    CHECK(total_passed > 0 && total_passed < total);
+}
+
+/* Per-lane models against the dense F P F' + Q with F = [I dt·I; 0 a·I] */
+static void test_propagate_models(void) {
+    enum { N = 7 };
+    unsigned seed = 9;
+    vps_ekf_bank_t bank;
+    vps_ekf_bank_init(&bank, N);
+    double xs[N][4], ps[N][VPS_EKF_PACKED], q[N], a[N], dt = 0.4;
+    for (int i = 0; i < N; i++) {
+        random_lane(&seed, xs[i], ps[i]);
+        vps_ekf_bank_set(&bank, i, xs[i], ps[i]);
+        q[i] = 1e-8 * (i + 1);
+        a[i] = i % 2 ? 1.0 : 0.5 + 0.05 * i;
+    }
+    vps_ekf_bank_propagate_models(&bank, q, a, dt);
+
+    for (int i = 0; i < N; i++) {
+        double F[4][4] = {{1, 0, dt, 0}, {0, 1, 0, dt}, {0, 0, a[i], 0}, {0, 0, 0, a[i]}};
+        double P[4][4], FP[4][4], Pn[4][4], xn[4];
+        vps_ekf_unpack_cov(P, ps[i]);
+        for (int r = 0; r < 4; r++) {
+            xn[r] = 0;
+            for (int c = 0; c < 4; c++) {
+                xn[r] += F[r][c] * xs[i][c];
+                FP[r][c] = 0;
+                for (int k = 0; k < 4; k++) FP[r][c] += F[r][k] * P[k][c];
+            }
+        }
+        double q4 = q[i] * dt * dt * dt * dt / 4, q3 = q[i] * dt * dt * dt / 2, q2 = q[i] * dt * dt;
+        double Q[4][4] = {{q4, 0, q3, 0}, {0, q4, 0, q3}, {q3, 0, q2, 0}, {0, q3, 0, q2}};
+        for (int r = 0; r < 4; r++)
+            for (int c = 0; c < 4; c++) {
+                Pn[r][c] = Q[r][c];
+                for (int k = 0; k < 4; k++) Pn[r][c] += FP[r][k] * F[c][k];
+            }
+        double x[4], p[VPS_EKF_PACKED], pn[VPS_EKF_PACKED];
+        vps_ekf_bank_get(&bank, i, x, p);
+        vps_ekf_pack_cov(pn, &Pn[0][0]);
+        for (int k = 0; k < 4; k++) CHECK(close_rel(x[k], xn[k], 1e-12));
+        for (int k = 0; k < VPS_EKF_PACKED; k++)
+            CHECK(fabs(p[k] - pn[k]) <= 1e-12 * fmax(fabs(pn[0]), fabs(pn[4])));
+    }
+}
+
+static void test_best(void) {
+    double d[5] = {3.0, 0.5, INFINITY, 0.4, 9.0};
+    CHECK(vps_ekf_bank_best(d, 5, 5.0) == 3);
+    CHECK(vps_ekf_bank_best(d, 2, 5.0) == 1);
+    CHECK(vps_ekf_bank_best(d, 1, 1.0) == -1);
+}
+
+static void test_fusion_select(void) {
+    vps_fusion_t f;
+    vps_fusion_init(&f, NULL, 10.0, NULL);
+    vps_geopoint_t only = {52.0, 13.0};
+    double h1 = 1.0;
+    CHECK(vps_fusion_select(&f, &only, &h1, 1, 0.0, NULL) == 0);  /* uninitialized */
+
+    for (int i = 0; i < 10; i++)
+        vps_fusion_update(&f, &(vps_geopoint_t){52.0 + 1e-5 * i, 13.0}, 1.0, i);
+
+    vps_geopoint_t cands[4] = {
+        {52.0 + 1e-3, 13.0},          /* ~110 m off */
+        {52.0 + 1e-4, 13.0 + 2e-4},   /* ~14 m off */
+        {52.0 + 1.0e-4, 13.0},        /* on track */
+        {51.0, 13.0},
+    };
+    double hdop[4] = {1.0, 1.0, 1.0, 1.0};
+    double d[4];
+    CHECK(vps_fusion_select(&f, cands, hdop, 4, 10.0, d) == 2);
+    CHECK(d[2] < d[1] && d[1] < d[0] && d[0] < d[3]);
+
+    double far_hdop = 1.0;
+    CHECK(vps_fusion_select(&f, &cands[3], &far_hdop, 1, 10.0, NULL) == -1);
+}
+
+/* Matcher whose first candidate is a confident wrong match */
+typedef struct {
+    int frame;
+} scene_t;
+
+static vps_geopoint_t truth(int frame) {
+    return (vps_geopoint_t){52.52 + 1e-5 * frame, 13.405};
+}
+
+static bool scene_grab(void *ctx, vps_frame_t *frame) {
+    scene_t *s = ctx;
+    if (s->frame >= 20) return false;
+    memset(frame, 0, sizeof(*frame));
+    frame->width = 640;
+    frame->height = 640;
+    frame->t = s->frame;
+    frame->seq = (uint32_t)s->frame++;
+    return true;
+}
+
+static int scene_retrieve(void *ctx, const vps_frame_t *frame,
+                          vps_tile_coord_t *out, int max_out) {
+    (void)ctx;
+    int n = frame->seq < 5 ? 1 : 3;  /* decoys once the filter has locked on */
+    for (int i = 0; i < n && i < max_out; i++) out[i] = (vps_tile_coord_t){19, i, (int)frame->seq};
+    return n < max_out ? n : max_out;
+}
+
+static bool scene_match(void *ctx, const vps_frame_t *frame,
+                        vps_tile_coord_t tile, vps_match_t *out) {
+    (void)ctx;
+    vps_geopoint_t p = truth((int)frame->seq);
+    if (frame->seq >= 5 && tile.x == 0) p.lat += 2e-3;  /* wrong tile, 220 m */
+    if (tile.x == 2) p.lon -= 3e-3;
+    vps_pixel_t px;
+    memset(out, 0, sizeof(*out));
+    vps_gps_to_tile_pixel(p, 19, &out->tile, &px);
+    out->num_matches = 100;
+    out->inlier_ratio = 0.8;
+    out->confidence = 0.8;
+    out->H[0] = 1.0; out->H[2] = px.x - 320.0;
+    out->H[4] = 1.0; out->H[5] = px.y - 320.0;
+    out->H[8] = 1.0;
+    return true;
+}
+
+static int run_scene(bool score) {
+    scene_t scene = {0};
+    vps_config_t cfg;
+    vps_config_defaults(&cfg);
+    vps_runtime_t rt;
+    vps_runtime_init(&rt, &cfg, (vps_frame_source_t){&scene, scene_grab},
+                     (vps_matcher_t){&scene, scene_retrieve, scene_match}, NULL);
+    rt.score_candidates = score;
+
+    int on_track = 0;
+    vps_step_result_t res;
+    while (vps_runtime_step(&rt, &res)) {
+        vps_geopoint_t t = truth((int)res.frame.seq);
+        if (res.loc.has_fix && fabs(res.loc.position.lat - t.lat) < 1e-5 &&
+            fabs(res.loc.position.lon - t.lon) < 1e-5)
+            on_track++;
+    }
+    return on_track;
+}
+
+static void test_runtime_scores_candidates(void) {
+    CHECK(run_scene(false) == 5);    /* first-accepted takes the decoy */
+    CHECK(run_scene(true) == 20);
+}
+
+int main(void) {
+    printf("ekf bank ISA: %s\n", vps_ekf_bank_isa());
+    test_lanes_match_scalar_kernel();
+    test_propagate_models();
+    test_best();
+    test_fusion_select();
+    test_runtime_scores_candidates();
+    return test_report("test_ekf_bank");
+}
@@ -0,0 +1,127 @@
+/**
+ * @file test_ekf_batch.c
+ * @brief Information-form batch update vs. sequential updates.
+ */
+#include "ekf.h"
+#include "fusion.h"
+#include "test_common.h"
+
+static bool close_rel(double a, double b, double rel) {
+    return fabs(a - b) <= rel * fmax(fmax(fabs(a), fabs(b)), 1e-300);
+}
+
+static void warm_up(vps_ekf_state_t *s, const vps_ekf_config_t *cfg) {
+    vps_ekf_init(s);
+    for (int i = 0; i < 10; i++)
+        vps_ekf_update(s, cfg, (vps_geopoint_t){52.0 + 1e-5 * i, 13.0 + 5e-6 * i}, 1.0, i * 0.5);
+}
+
+static void test_info_accumulator(void) {
+    vps_ekf_info_t info;
+    vps_ekf_info_clear(&info);
+    vps_geopoint_t z;
+    double r;
+    CHECK(!vps_ekf_info_fix(&info, &z, &r));
+    vps_ekf_info_add(&info, (vps_geopoint_t){10.0, 20.0}, 1.0);
+    vps_ekf_info_add(&info, (vps_geopoint_t){13.0, 23.0}, 2.0);
+    CHECK(vps_ekf_info_fix(&info, &z, &r));
+    CHECK_NEAR(r, 2.0 / 3.0, 1e-15);
+    CHECK_NEAR(z.lat, 11.0, 1e-12);
+    CHECK_NEAR(z.lon, 21.0, 1e-12);
+}
+
+static void test_batch_matches_sequential(void) {
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+    cfg.gate_threshold = 1e9;   /* nothing gated: both forms are exact */
+    for (int n = 1; n <= 16; n++) {
+        vps_ekf_state_t seq, bat;
+        warm_up(&seq, &cfg);
+        bat = seq;
+
+        vps_geopoint_t z[16];
+        double hdop[16];
+        for (int i = 0; i < n; i++) {
+            z[i] = (vps_geopoint_t){52.0 + 1e-4 + 2e-5 * (i % 3), 13.0 + 5e-5 - 1e-5 * (i % 4)};
+            hdop[i] = 0.7 + 0.2 * i;
+        }
+        double t = 5.2;
+        for (int i = 0; i < n; i++) vps_ekf_update(&seq, &cfg, z[i], hdop[i], t);
+        CHECK(vps_ekf_update_batch(&bat, &cfg, z, hdop, n, t, NULL) == n);
+
+        /* Sequential rounding differs in the last digits; 1e-12 deg/s is ~0.1 µm/s */
+        for (int i = 0; i < 2; i++) CHECK(close_rel(bat.x[i], seq.x[i], 1e-12));
+        for (int i = 2; i < 4; i++) CHECK_NEAR(bat.x[i], seq.x[i], 1e-12);
+        for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 4; j++)
+                CHECK(fabs(bat.P[i][j] - seq.P[i][j]) <= 1e-9 * seq.P[i == j ? i : 0][i == j ? i : 0]);
+        CHECK(bat.last_t == t);
+    }
+}
+
+static void test_outliers_gated_individually(void) {
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+    vps_ekf_state_t s;
+    warm_up(&s, &cfg);
+    vps_geopoint_t pred = vps_ekf_predict(&s, 5.0);
+
+    vps_geopoint_t z[3] = {pred, {pred.lat + 1e-2, pred.lon}, {pred.lat + 2e-6, pred.lon}};
+    double hdop[3] = {1.0, 1.0, 1.0};
+    bool acc[3];
+    vps_ekf_state_t ref = s;
+    CHECK(vps_ekf_update_batch(&s, &cfg, z, hdop, 3, 5.0, acc) == 2);
+    CHECK(acc[0] && !acc[1] && acc[2]);
+
+    /* Same as fusing only the two inliers */
+    vps_geopoint_t in[2] = {z[0], z[2]};
+    vps_ekf_update_batch(&ref, &cfg, in, hdop, 2, 5.0, NULL);
+    CHECK(s.x[0] == ref.x[0] && s.x[1] == ref.x[1]);
+
+    /* All outliers: no correction, but time advances */
+    vps_geopoint_t far[2] = {{51.0, 13.0}, {53.0, 13.0}};
+    double lat_pred = vps_ekf_predict(&s, 6.0).lat;
+    CHECK(vps_ekf_update_batch(&s, &cfg, far, hdop, 2, 6.0, acc) == 0);
+    CHECK(!acc[0] && !acc[1]);
+    CHECK(s.last_t == 6.0);
+    CHECK_NEAR(s.x[0], lat_pred, 1e-12);
+}
+
+static void test_first_batch_initializes(void) {
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+    vps_ekf_state_t s;
+    vps_ekf_init(&s);
+    vps_geopoint_t z[2] = {{52.0, 13.0}, {52.0002, 13.0004}};
+    double hdop[2] = {1.0, 1.0};
+    CHECK(vps_ekf_update_batch(&s, &cfg, z, hdop, 2, 0.0, NULL) == 2);
+    CHECK(s.initialized);
+    CHECK_NEAR(s.x[0], 52.0001, 1e-12);
+    CHECK_NEAR(s.x[1], 13.0002, 1e-12);
+}
+
+static void test_fusion_batch(void) {
+    vps_fusion_t f;
+    vps_fusion_init(&f, NULL, 10.0, NULL);
+    for (int i = 0; i < 5; i++)
+        vps_fusion_update(&f, &(vps_geopoint_t){52.0, 13.0}, 1.0, i);
+
+    /* z17 and z19 matches of the same frame, plus a wrong tile */
+    vps_geopoint_t z[3] = {{52.0, 13.0}, {52.00001, 13.0}, {52.01, 13.0}};
+    double hdop[3] = {2.0, 1.0, 1.0};
+    vps_fusion_output_t out = vps_fusion_update_batch(&f, z, hdop, 3, 5.0);
+    CHECK(out.has_position && out.ekf_accepted);
+    CHECK(out.source == VPS_SOURCE_VISUAL);
+    CHECK(out.hdop < 1.0);                 /* sqrt(1/(1/4 + 1)) */
+    CHECK(fabs(out.position.lat - 52.0) < 1e-4);
+    CHECK(f.hist.count == 6);              /* one history entry per frame */
+
+    vps_fusion_output_t one = vps_fusion_update_batch(&f, z, hdop, 1, 6.0);
+    CHECK(one.has_position && one.hdop == 2.0);
+}
+
+int main(void) {
+    test_info_accumulator();
+    test_batch_matches_sequential();
+    test_outliers_gated_individually();
+    test_first_batch_initializes();
+    test_fusion_batch();
+    return test_report("test_ekf_batch");
+}
@@ -0,0 +1,142 @@
+/**
+ * @file test_ekf_history.c
+ * @brief Tests for out-of-sequence EKF updates and delayed fusion.
+ */
+#include "fusion.h"
+#include "test_common.h"
+#include <string.h>
+
+#define N_MEAS 40
+
+/* Track moving north-east with alternating small offsets (some gated) */
+static vps_geopoint_t meas_at(int i) {
+    double wobble = (i % 2 ? 1.0 : -1.0) * 2e-6;
+    vps_geopoint_t p = {52.0 + 1e-5 * i + wobble, 13.0 + 5e-6 * i - wobble};
+    if (i == 17) p.lat += 0.01;  /* outlier */
+    return p;
+}
+
+static double t_at(int i) { return i / 3.0; }
+
+static bool states_equal(const vps_ekf_state_t *a, const vps_ekf_state_t *b, double tol) {
+    for (int i = 0; i < 4; i++) {
+        if (fabs(a->x[i] - b->x[i]) > tol) return false;
+        for (int j = 0; j < 4; j++)
+            if (fabs(a->P[i][j] - b->P[i][j]) > tol) return false;
+    }
+    return a->last_t == b->last_t && a->initialized == b->initialized;
+}
+
+static void test_in_order_matches_plain_update(void) {
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+    vps_ekf_state_t ref, s;
+    vps_ekf_init(&ref);
+    vps_ekf_init(&s);
+    static vps_ekf_history_t h;
+    vps_ekf_history_init(&h, 8);
+
+    for (int i = 0; i < N_MEAS; i++) {
+        bool a = vps_ekf_update(&ref, &cfg, meas_at(i), 1.0, t_at(i));
+        bool b = vps_ekf_update_delayed(&s, &h, &cfg, meas_at(i), 1.0,
+                                        t_at(i), t_at(i) + 0.3);
+        CHECK(a == b);
+    }
+    CHECK(states_equal(&ref, &s, 0.0));
+    CHECK(h.count == 8);
+    CHECK_NEAR(h.last_latency, 0.3, 1e-12);
+}
+
+static void test_out_of_order_matches_sorted(void) {
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+    vps_ekf_state_t ref, s;
+    vps_ekf_init(&ref);
+    vps_ekf_init(&s);
+    static vps_ekf_history_t h;
+    vps_ekf_history_init(&h, 16);
+
+    for (int i = 0; i < N_MEAS; i++)
+        vps_ekf_update(&ref, &cfg, meas_at(i), 1.5, t_at(i));
+
+    /* Every 5th measurement arrives after the next two */
+    int order[N_MEAS], n = 0;
+    for (int i = 0; i < N_MEAS; i++) {
+        if (i % 5 == 2 && i + 2 < N_MEAS) {
+            order[n++] = i + 1;
+            order[n++] = i + 2;
+            order[n++] = i;
+            i += 2;
+        } else {
+            order[n++] = i;
+        }
+    }
+    CHECK(n == N_MEAS);
+
+    uint32_t max_replayed = 0;
+    for (int k = 0; k < n; k++) {
+        int i = order[k];
+        vps_ekf_update_delayed(&s, &h, &cfg, meas_at(i), 1.5, t_at(i), t_at(order[k]) + 1.0);
+        if (h.replayed > max_replayed) max_replayed = h.replayed;
+    }
+    CHECK(max_replayed == 2);
+    CHECK(states_equal(&ref, &s, 1e-15));
+}
+
+static void test_rejects_outside_window(void) {
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+    vps_ekf_state_t s;
+    vps_ekf_init(&s);
+    static vps_ekf_history_t h;
+    vps_ekf_history_init(&h, 4);
+
+    for (int i = 0; i < 10; i++)
+        vps_ekf_update_delayed(&s, &h, &cfg, meas_at(i), 1.0, t_at(i), t_at(i));
+    vps_ekf_state_t before = s;
+
+    /* Older than the 4 retained entries */
+    CHECK(!vps_ekf_update_delayed(&s, &h, &cfg, meas_at(3), 1.0, t_at(3), t_at(10)));
+    CHECK(states_equal(&before, &s, 0.0));
+    /* Captured after it arrived */
+    CHECK(!vps_ekf_update_delayed(&s, &h, &cfg, meas_at(11), 1.0, t_at(11), t_at(10)));
+    CHECK(states_equal(&before, &s, 0.0));
+    CHECK(h.count == 4);
+
+    /* Inside the window: accepted, history stays bounded */
+    CHECK(vps_ekf_update_delayed(&s, &h, &cfg, meas_at(8), 1.0, t_at(8) - 0.1, t_at(10)));
+    CHECK(h.count == 4);
+    CHECK(s.last_t == t_at(9));
+}
+
+static void test_fusion_delayed_reports_arrival_time(void) {
+    vps_fusion_t f;
+    vps_fusion_init(&f, NULL, 10.0, NULL);
+
+    vps_fusion_output_t out;
+    for (int i = 0; i < 10; i++) {
+        out = vps_fusion_update_delayed(&f, &(vps_geopoint_t){52.0 + 1e-5 * i, 13.0},
+                                        1.0, i, i + 0.4);
+    }
+    CHECK(out.has_position);
+    CHECK(out.source == VPS_SOURCE_VISUAL);
+    CHECK(out.ekf_accepted);
+    /* Propagated 0.4 s past the last capture (~1e-5 deg/s north) */
+    CHECK_NEAR(out.position.lat, 52.0 + 9.4e-5, 1e-6);
+    CHECK(f.hist.count == 10);
+
+    /* Late fix for t=8.5 lands between two retained entries */
+    out = vps_fusion_update_delayed(&f, &(vps_geopoint_t){52.0 + 8.5e-5, 13.0},
+                                    1.0, 8.5, 9.6);
+    CHECK(out.ekf_accepted);
+    CHECK(f.hist.replayed == 1);
+    CHECK(f.ekf.last_t == 9.0);
+
+    vps_fusion_reset(&f);
+    CHECK(f.hist.count == 0);
+}
+
+int main(void) {
+    test_in_order_matches_plain_update();
+    test_out_of_order_matches_sorted();
+    test_rejects_outside_window();
+    test_fusion_delayed_reports_arrival_time();
+    return test_report("test_ekf_history");
+}
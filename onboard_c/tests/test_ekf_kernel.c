@@ -0,0 +1,147 @@
+/**
+ * @file test_ekf_kernel.c
+ * @brief Structured EKF kernel vs. the dense reference implementation.
+ */
+#include "ekf.h"
+#include "test_common.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Relative agreement, scaled per entry so tiny covariances still count. */
+static bool close_state(const vps_ekf_state_t *a, const vps_ekf_state_t *b) {
+    for (int i = 0; i < 4; i++) {
+        double sx = fmax(fabs(a->x[i]), 1e-12);
+        if (fabs(a->x[i] - b->x[i]) > 1e-12 * sx) return false;
+        for (int j = 0; j < 4; j++) {
+            double sp = fmax(sqrt(fabs(a->P[i][i] * a->P[j][j])), 1e-300);
+            if (fabs(a->P[i][j] - b->P[i][j]) > 1e-9 * sp) return false;
+        }
+    }
+    return a->last_t == b->last_t && a->initialized == b->initialized;
+}
+
+static void test_pack_roundtrip(void) {
+    double P[4][4], Q[4][4], p[VPS_EKF_PACKED];
+    for (int i = 0; i < 4; i++)
+        for (int j = i; j < 4; j++)
+            P[i][j] = P[j][i] = 10 * i + j;
+    vps_ekf_pack_cov(p, &P[0][0]);
+    CHECK(p[0] == 0 && p[3] == 3 && p[4] == 11 && p[7] == 22 && p[9] == 33);
+    vps_ekf_unpack_cov(Q, p);
+    CHECK(memcmp(P, Q, sizeof(P)) == 0);
+}
+
+static void test_track_matches_dense(void) {
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+    vps_ekf_state_t a, b;
+    vps_ekf_init(&a);
+    vps_ekf_init(&b);
+
+    unsigned seed = 7;
+    double t = 0.0;
+    int mismatched_accept = 0, accepted = 0;
+    for (int i = 0; i < 2000; i++) {
+        t += 0.2 + 0.3 * (test_rand(&seed));
+        if (i == 1000) t += 40.0;  /* gap reset */
+        vps_geopoint_t z = {52.0 + 1e-6 * i + 2e-5 * (test_rand(&seed) - 0.5),
+                            13.0 + 2e-6 * i + 2e-5 * (test_rand(&seed) - 0.5)};
+        if (i % 97 == 13) z.lat += 0.01;  /* outlier */
+        double hdop = 0.8 + test_rand(&seed);
+
+        bool ra = vps_ekf_update_dense(&a, &cfg, z, hdop, t);
+        bool rb = vps_ekf_update(&b, &cfg, z, hdop, t);
+        if (ra != rb) mismatched_accept++;
+        if (rb) accepted++;
+        if (!close_state(&a, &b)) {
+            CHECK(close_state(&a, &b));
+            break;
+        }
+        CHECK_NEAR(a.last_gate, b.last_gate, 1e-9 * fmax(a.last_gate, 1.0));
+    }
+    CHECK(mismatched_accept == 0);
+    CHECK(accepted > 1500 && accepted < 2000);
+
+    /* dt < 0 is rejected by both without touching state */
+    vps_ekf_state_t before = b;
+    CHECK(!vps_ekf_update(&b, &cfg, (vps_geopoint_t){52.0, 13.0}, 1.0, t - 1.0));
+    CHECK(memcmp(&before, &b, sizeof(b)) == 0);
+}
+
+static void test_full_covariance_matches_dense(void) {
+    /* Cross-coupled P (lat/lon blocks correlated) exercises every term */
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+    cfg.gate_threshold = 1e9;
+    unsigned seed = 99;
+    for (int trial = 0; trial < 200; trial++) {
+        double A[4][4];
+        for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 4; j++) A[i][j] = 1e-4 * (test_rand(&seed) - 0.5);
+
+        vps_ekf_state_t a;
+        vps_ekf_init(&a);
+        a.initialized = true;
+        a.last_t = 0.0;
+        for (int i = 0; i < 4; i++) {
+            a.x[i] = (i < 2 ? 50.0 : 0.0) + 1e-4 * (test_rand(&seed) - 0.5);
+            for (int j = 0; j < 4; j++) {
+                double s = 0;
+                for (int k = 0; k < 4; k++) s += A[i][k] * A[j][k];
+                a.P[i][j] = s + (i == j ? 1e-9 : 0.0);
+            }
+        }
+        vps_ekf_state_t b = a;
+        vps_geopoint_t z = {50.0 + 1e-4 * (test_rand(&seed) - 0.5),
+                            50.0 + 1e-4 * (test_rand(&seed) - 0.5)};
+        double dt = 0.05 + test_rand(&seed);
+        CHECK(vps_ekf_update_dense(&a, &cfg, z, 2.0, dt) ==
+              vps_ekf_update(&b, &cfg, z, 2.0, dt));
+        CHECK(close_state(&a, &b));
+    }
+}
+
+static void test_propagate_matches_dense_products(void) {
+    double x[4] = {52.0, 13.0, 1e-5, -2e-5};
+    double P[4][4];
+    unsigned seed = 3;
+    for (int i = 0; i < 4; i++)
+        for (int j = i; j < 4; j++)
+            P[i][j] = P[j][i] = (i == j ? 1.0 : 0.3) * (1.0 + (test_rand(&seed) - 0.5));
+    double p[VPS_EKF_PACKED];
+    vps_ekf_pack_cov(p, &P[0][0]);
+
+    double dt = 0.37, q = 0.5;
+    vps_ekf_propagate(x, p, q, dt);
+    CHECK_NEAR(x[0], 52.0 + 1e-5 * dt, 1e-12);
+    CHECK_NEAR(x[1], 13.0 - 2e-5 * dt, 1e-12);
+
+    /* F P F' + Q written out densely */
+    double F[4][4] = {{1, 0, dt, 0}, {0, 1, 0, dt}, {0, 0, 1, 0}, {0, 0, 0, 1}};
+    double FP[4][4], R[4][4];
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++) {
+            FP[i][j] = 0;
+            for (int k = 0; k < 4; k++) FP[i][j] += F[i][k] * P[k][j];
+        }
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++) {
+            R[i][j] = 0;
+            for (int k = 0; k < 4; k++) R[i][j] += FP[i][k] * F[j][k];
+        }
+    double dt2 = dt * dt;
+    R[0][0] += q * dt2 * dt2 / 4; R[1][1] += q * dt2 * dt2 / 4;
+    R[0][2] += q * dt2 * dt / 2;  R[1][3] += q * dt2 * dt / 2;
+    R[2][2] += q * dt2;           R[3][3] += q * dt2;
+
+    double out[4][4];
+    vps_ekf_unpack_cov(out, p);
+    for (int i = 0; i < 4; i++)
+        for (int j = i; j < 4; j++) CHECK_NEAR(out[i][j], R[i][j], 1e-12);
+}
+
+int main(void) {
+    test_pack_roundtrip();
+    test_track_matches_dense();
+    test_full_covariance_matches_dense();
+    test_propagate_matches_dense_products();
+    return test_report("test_ekf_kernel");
+}
@@ -0,0 +1,274 @@
+/**
+ * @file test_fence_set.c
+ * @brief Zone set BVH against a linear scan, zone files, fusion hookup.
+ */
+#include "fence_set.h"
+#include "fusion.h"
+#include "test_common.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define N_ZONES 400
+
+static vps_fence_zone_t zones[N_ZONES];
+static vps_geofence_poly_t polys[N_ZONES];
+static vps_fence_zone_t inclusion;
+
+/* Smallest clearance by scanning every zone */
+static double scan_clearance(vps_geopoint_t p) {
+    const vps_geofence_t *f = &inclusion.fence;
+    double best = vps_geofence_distance_km(f, p) - f->margin_km;
+    for (int i = 0; i < N_ZONES; i++) {
+        f = &zones[i].fence;
+        best = fmin(best, -vps_geofence_distance_km(f, p) - f->margin_km);
+    }
+    return best;
+}
+
+static vps_geopoint_t offset(vps_geopoint_t c, double n_km, double e_km) {
+    return (vps_geopoint_t){c.lat + n_km / 111.195,
+                            c.lon + e_km / (111.195 * cos(c.lat * M_PI / 180.0))};
+}
+
+/* 30 km inclusion circle around Zurich, mixed exclusion zones inside and around it */
+static void make_zones(void) {
+    vps_geopoint_t home = {47.3977, 8.5456};
+    inclusion = (vps_fence_zone_t){.fence = {VPS_FENCE_CIRCLE, home, 30.0, 0.1, 0.0, 0.0, NULL},
+                                   .id = 1};
+    unsigned seed = 5;
+    for (int i = 0; i < N_ZONES; i++) {
+        vps_geopoint_t c = offset(home, (test_rand(&seed) - 0.5) * 70.0,
+                                  (test_rand(&seed) - 0.5) * 70.0);
+        double size = 0.2 + 1.5 * test_rand(&seed), margin = 0.05 + 0.3 * test_rand(&seed);
+        vps_geofence_t f = {VPS_FENCE_CIRCLE, c, size, margin, 0.0, 0.0, NULL};
+        if (i % 3 == 1) {
+            f.type = VPS_FENCE_RECT;
+            f.radius_km = 0.0;
+            f.half_lat_km = size;
+            f.half_lon_km = 0.5 * size + test_rand(&seed);
+        } else if (i % 3 == 2) {
+            vps_geopoint_t pts[24];
+            for (int k = 0; k < 24; k++) {
+                double a = -2.0 * M_PI * k / 24, r = size * (0.6 + 0.4 * test_rand(&seed));
+                pts[k] = offset(c, r * sin(a), r * cos(a));
+            }
+            int len[] = {24};
+            CHECK(vps_geofence_poly_build(&polys[i], pts, len, 1));
+            f.type = VPS_FENCE_POLYGON;
+            f.radius_km = 0.0;
+            f.poly = &polys[i];
+        }
+        zones[i] = (vps_fence_zone_t){.fence = f, .id = 1000u + (uint32_t)i};
+    }
+}
+
+static void test_against_scan(void) {
+    vps_fence_set_t set;
+    CHECK(vps_fence_set_build(&set, &inclusion, zones, N_ZONES));
+    CHECK(set.n_zones == N_ZONES);
+    CHECK(set.n_nodes < 2 * N_ZONES);
+
+    unsigned seed = 9;
+    int mismatch = 0, violations = 0;
+    for (int i = 0; i < 20000; i++) {
+        vps_geopoint_t p = offset(inclusion.fence.center, (test_rand(&seed) - 0.5) * 70.0,
+                                  (test_rand(&seed) - 0.5) * 70.0);
+        double want = scan_clearance(p);
+        if (fabs(want) < 1e-9) continue;
+        vps_fence_result_t r = vps_fence_set_check(&set, p);
+        mismatch += r.ok != (want >= 0.0);
+        mismatch += vps_fence_set_contains(&set, p) != (want >= 0.0);
+        violations += !r.ok;
+        if (want >= 0.0) {
+            CHECK_NEAR(r.clearance_km, want, 1e-9);
+        } else {
+            CHECK(r.clearance_km < 0.0);
+        }
+        if (r.zone >= 0) {
+            CHECK(r.zone_id == set.zones[r.zone].id);
+        } else {
+            CHECK(r.zone == -1 && r.zone_id == 1);
+        }
+    }
+    CHECK(mismatch == 0);
+    CHECK(violations > 2000 && violations < 18000);
+    vps_fence_set_free(&set);
+    CHECK(set.zones == NULL);
+}
+
+static void test_batch(void) {
+    vps_fence_set_t set;
+    CHECK(vps_fence_set_build(&set, &inclusion, zones, N_ZONES));
+    /* 5 s of 15 m/s flight sampled at 50 Hz, heading north-east from home */
+    enum { N = 250 };
+    vps_geopoint_t pts[N];
+    for (int i = 0; i < N; i++)
+        pts[i] = offset(inclusion.fence.center, 0.015 * 0.02 * i * 80.0, 0.015 * 0.02 * i * 60.0);
+    vps_fence_result_t out[N];
+    int first = vps_fence_set_check_batch(&set, pts, N, out);
+    int want = -1;
+    for (int i = 0; i < N; i++) {
+        vps_fence_result_t r = vps_fence_set_check(&set, pts[i]);
+        CHECK(r.ok == out[i].ok);
+        if (r.ok) CHECK_NEAR(r.clearance_km, out[i].clearance_km, 1e-12);
+        if (!r.ok && want < 0) want = i;
+    }
+    CHECK(first == want);
+    CHECK(vps_fence_set_check_batch(&set, pts, 0, NULL) == -1);
+
+    /* No inclusion fence, no zones: everything is clear */
+    vps_fence_set_t empty;
+    CHECK(vps_fence_set_build(&empty, NULL, NULL, 0));
+    vps_fence_result_t r = vps_fence_set_check(&empty, pts[0]);
+    CHECK(r.ok && r.zone == -2 && isinf(r.clearance_km));
+    CHECK(vps_fence_set_contains(&empty, pts[0]));
+    vps_fence_set_free(&empty);
+    vps_fence_set_free(&set);
+}
+
+/* --- Zone files --- */
+
+static size_t put_u32(uint8_t *b, size_t off, uint32_t v) {
+    for (int i = 0; i < 4; i++) b[off + i] = (uint8_t)(v >> (8 * i));
+    return off + 4;
+}
+
+static size_t put_f32(uint8_t *b, size_t off, float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return put_u32(b, off, u);
+}
+
+static size_t put_zone(uint8_t *b, size_t off, int type, int role, int rings,
+                       vps_geopoint_t c, float a, float e, float margin, uint32_t id) {
+    b[off] = (uint8_t)type;
+    b[off + 1] = (uint8_t)role;
+    b[off + 2] = (uint8_t)rings;
+    b[off + 3] = 0;
+    off = put_u32(b, off + 4, (uint32_t)(int32_t)lround(c.lat * 1e7));
+    off = put_u32(b, off, (uint32_t)(int32_t)lround(c.lon * 1e7));
+    off = put_f32(b, off, a);
+    off = put_f32(b, off, e);
+    off = put_f32(b, off, margin);
+    return put_u32(b, off, id);
+}
+
+static size_t make_file(uint8_t *b) {
+    memcpy(b, "VPSZ", 4);
+    b[4] = VPS_ZONE_FILE_VERSION;
+    b[5] = b[6] = b[7] = 0;
+    size_t off = put_u32(b, 8, 4);
+    vps_geopoint_t home = {-33.87, 151.21};
+    off = put_zone(b, off, VPS_FENCE_CIRCLE, VPS_ZONE_INCLUSION, 0, home, 10.0f, 0.0f, 0.1f, 1);
+    off = put_zone(b, off, VPS_FENCE_CIRCLE, VPS_ZONE_EXCLUSION, 0, offset(home, 3.0, 0.0),
+                   1.0f, 0.0f, 0.2f, 7);
+    off = put_zone(b, off, VPS_FENCE_RECT, VPS_ZONE_EXCLUSION, 0, offset(home, -3.0, 0.0),
+                   0.5f, 1.0f, 0.1f, 8);
+    /* 2 x 2 km square with a 1 x 1 km hole, 4 km west */
+    off = put_zone(b, off, VPS_FENCE_POLYGON, VPS_ZONE_EXCLUSION, 2, home, 0.0f, 0.0f, 0.0f, 9);
+    off = put_u32(b, off, 4);
+    off = put_u32(b, off, 4);
+    static const double sq[8][2] = {{-1, -5}, {-1, -3}, {1, -3}, {1, -5},
+                                    {-0.5, -4.5}, {0.5, -4.5}, {0.5, -3.5}, {-0.5, -3.5}};
+    for (int i = 0; i < 8; i++) {
+        vps_geopoint_t v = offset(home, sq[i][0], sq[i][1]);
+        off = put_u32(b, off, (uint32_t)(int32_t)lround(v.lat * 1e7));
+        off = put_u32(b, off, (uint32_t)(int32_t)lround(v.lon * 1e7));
+    }
+    return off;
+}
+
+static void test_zone_file(void) {
+    uint8_t buf[512];
+    size_t len = make_file(buf);
+    CHECK(len == VPS_ZONE_HEADER_SIZE + 4 * VPS_ZONE_RECORD_SIZE + 8 + 64);
+
+    vps_fence_set_t set;
+    CHECK(vps_fence_set_parse(&set, buf, len));
+    CHECK(set.has_inclusion && set.n_zones == 3 && set.n_polys == 1);
+    vps_geopoint_t home = {-33.87, 151.21};
+    CHECK(vps_fence_set_contains(&set, home));
+    vps_fence_result_t r = vps_fence_set_check(&set, offset(home, 3.0, 0.0));
+    CHECK(!r.ok && r.zone_id == 7);
+    CHECK_NEAR(r.clearance_km, -1.2, 1e-3);
+    r = vps_fence_set_check(&set, offset(home, 1.5, 0.0));   /* 0.3 km from the keep-out */
+    CHECK(r.ok && r.zone_id == 7);
+    CHECK_NEAR(r.clearance_km, 0.3, 1e-3);
+    CHECK(!vps_fence_set_contains(&set, offset(home, -3.0, 0.9)));
+    CHECK(vps_fence_set_contains(&set, offset(home, -3.0, 1.2)));
+    CHECK(!vps_fence_set_contains(&set, offset(home, 0.0, -3.2)));     /* polygon */
+    CHECK(vps_fence_set_contains(&set, offset(home, 0.0, -4.0)));      /* its hole */
+    r = vps_fence_set_check(&set, offset(home, 0.0, -4.0));
+    CHECK(r.ok && r.zone_id == 9);
+    CHECK_NEAR(r.clearance_km, 0.5, 1e-3);
+    CHECK(!vps_fence_set_contains(&set, offset(home, 0.0, 9.95)));     /* inclusion margin */
+    vps_fence_set_free(&set);
+
+    /* Through a file */
+    const char *path = "test_fence_set_zones.vpsz";
+    FILE *fp = fopen(path, "wb");
+    CHECK(fp != NULL);
+    if (fp) {
+        fwrite(buf, 1, len, fp);
+        fclose(fp);
+        CHECK(vps_fence_set_load(&set, path));
+        CHECK(set.n_zones == 3);
+        vps_fence_set_free(&set);
+        remove(path);
+    }
+    CHECK(!vps_fence_set_load(&set, "does_not_exist.vpsz"));
+
+    /* Malformed images are rejected */
+    CHECK(!vps_fence_set_parse(&set, buf, len - 1));
+    CHECK(!vps_fence_set_parse(&set, buf, 8));
+    uint8_t bad[512];
+    memcpy(bad, buf, len);
+    bad[0] = 'X';
+    CHECK(!vps_fence_set_parse(&set, bad, len));
+    memcpy(bad, buf, len);
+    bad[VPS_ZONE_HEADER_SIZE + VPS_ZONE_RECORD_SIZE + 1] = VPS_ZONE_INCLUSION;   /* 2nd inclusion */
+    CHECK(!vps_fence_set_parse(&set, bad, len));
+    memcpy(bad, buf, len);
+    bad[VPS_ZONE_HEADER_SIZE] = 7;   /* unknown type */
+    CHECK(!vps_fence_set_parse(&set, bad, len));
+    memcpy(bad, buf, len);
+    put_u32(bad, 8, 1000);           /* more zones than bytes */
+    CHECK(!vps_fence_set_parse(&set, bad, len));
+}
+
+static void test_fusion_zones(void) {
+    uint8_t buf[512];
+    size_t len = make_file(buf);
+    vps_fence_set_t set;
+    CHECK(vps_fence_set_parse(&set, buf, len));
+
+    vps_fusion_t f;
+    vps_fusion_init(&f, NULL, 10.0, NULL);
+    vps_fusion_set_zones(&f, &set);
+    vps_geopoint_t home = {-33.87, 151.21};
+    vps_fusion_output_t o = vps_fusion_update(&f, &home, 1.0, 0.0);
+    CHECK(o.has_position && o.geofence_ok);
+    vps_fusion_reset(&f);
+    vps_geopoint_t airport = offset(home, 3.0, 0.2);
+    o = vps_fusion_update(&f, &airport, 1.0, 10.0);
+    CHECK(!o.has_position && !o.geofence_ok && o.source == VPS_SOURCE_NONE);
+    vps_fusion_set_zones(&f, NULL);
+    o = vps_fusion_update(&f, &airport, 1.0, 10.3);
+    CHECK(o.has_position && o.geofence_ok);
+    vps_fence_set_free(&set);
+}
+
+int main(void) {
+    make_zones();
+    test_against_scan();
+    test_batch();
+    test_zone_file();
+    test_fusion_zones();
+    for (int i = 0; i < N_ZONES; i++)
+        if (zones[i].fence.type == VPS_FENCE_POLYGON) vps_geofence_poly_free(&polys[i]);
+    return test_report("test_fence_set");
+}
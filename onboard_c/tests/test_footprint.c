@@ -0,0 +1,147 @@
+/**
+ * @file test_footprint.c
+ * @brief Footprints from pose and homography, and their tile coverage
+ *        against point sampling.
+ */
+#include "footprint.h"
+#include "test_common.h"
+#include "tile_math.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define MAX_COVER 256
+
+/* Point in the convex footprint (either orientation) */
+static bool inside(const vps_footprint_t *fp, double x, double y) {
+    int pos = 0, neg = 0;
+    for (int i = 0; i < 4; i++) {
+        int j = (i + 1) & 3;
+        double c = (fp->x[j] - fp->x[i]) * (y - fp->y[i]) - (fp->y[j] - fp->y[i]) * (x - fp->x[i]);
+        pos += c > 0.0;
+        neg += c < 0.0;
+    }
+    return !(pos && neg);
+}
+
+/* Coverage against the area sum and a 64x64 sample grid per tile */
+static void check_cover(const vps_footprint_t *fp) {
+    vps_tile_cover_t cov[MAX_COVER];
+    int n = vps_footprint_tiles(fp, cov, MAX_COVER);
+    CHECK(n > 0 && n < MAX_COVER);
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) {
+        CHECK(cov[i].overlap > 0.0 && cov[i].overlap <= 1.0);
+        if (i) CHECK(cov[i].overlap <= cov[i - 1].overlap);
+        sum += cov[i].overlap;
+        int hits = 0;
+        double x = cov[i].tile.x, y = cov[i].tile.y;
+        for (int s = 0; s < 64; s++)
+            for (int t = 0; t < 64; t++)
+                hits += inside(fp, x + (s + 0.5) / 64.0, y + (t + 0.5) / 64.0);
+        CHECK_NEAR(hits / 4096.0, cov[i].overlap, 0.04);
+    }
+    CHECK_NEAR(sum, vps_footprint_area(fp), 1e-9 * (1.0 + sum));
+
+    /* Truncation keeps the largest overlaps */
+    vps_tile_cover_t top[4];
+    int k = vps_footprint_tiles(fp, top, 4);
+    CHECK(k == (n < 4 ? n : 4));
+    for (int i = 0; i < k; i++) CHECK(top[i].overlap == cov[i].overlap);
+}
+
+static void test_pose(void) {
+    vps_camera_t cam;
+    vps_camera_default(&cam);
+    vps_geopoint_t p = {47.3977, 8.5456};
+    vps_footprint_t fp;
+    CHECK(vps_footprint_from_pose(p, 100.0, 0.0, &cam, 19, &fp));
+    /* Ground width is altitude * sensor width / focal length */
+    double tile_m = vps_meters_per_pixel(p.lat, 19) * VPS_TILE_SIZE;
+    double width_m = 100.0 * cam.sensor_width_mm / cam.focal_length_mm;
+    CHECK_NEAR((fp.x[1] - fp.x[0]) * tile_m, width_m, 1e-6);
+    CHECK_NEAR((fp.y[3] - fp.y[0]) * tile_m, width_m * 0.75, 1e-6);
+    CHECK(fp.y[0] < fp.y[3]);                   /* image top is north */
+    check_cover(&fp);
+
+    /* Heading 90: image top is east */
+    vps_footprint_t e;
+    CHECK(vps_footprint_from_pose(p, 100.0, 90.0, &cam, 19, &e));
+    CHECK_NEAR(e.x[0], fp.x[1] + (fp.x[0] - fp.x[1]) / 2.0 + (fp.y[3] - fp.y[0]) / 2.0, 1e-9);
+    CHECK_NEAR(vps_footprint_area(&e), vps_footprint_area(&fp), 1e-9);
+    check_cover(&e);
+
+    unsigned seed = 7;
+    for (int i = 0; i < 200; i++) {
+        vps_geopoint_t q = {(2.0 * test_rand(&seed) - 1.0) * 70.0,
+                            (2.0 * test_rand(&seed) - 1.0) * 180.0};
+        double alt = 20.0 + test_rand(&seed) * 300.0, yaw = test_rand(&seed) * 360.0;
+        CHECK(vps_footprint_from_pose(q, alt, yaw, &cam, 17 + i % 3, &fp));
+        check_cover(&fp);
+    }
+    /* Antimeridian: columns wrap */
+    CHECK(vps_footprint_from_pose((vps_geopoint_t){0.0, 179.9999}, 200.0, 30.0, &cam, 19, &fp));
+    vps_tile_cover_t cov[64];
+    int n = vps_footprint_tiles(&fp, cov, 64), wrapped = 0;
+    for (int i = 0; i < n; i++) {
+        CHECK(cov[i].tile.x >= 0 && cov[i].tile.x < (1 << 19));
+        wrapped += cov[i].tile.x < 10;
+    }
+    CHECK(wrapped > 0 && wrapped < n);
+
+    CHECK(!vps_footprint_from_pose(p, 0.0, 0.0, &cam, 19, &fp));
+    CHECK(!vps_footprint_from_pose(p, 5000.0, 0.0, &cam, 19, &fp));   /* too wide */
+}
+
+static void test_homography(void) {
+    vps_camera_t cam;
+    vps_camera_default(&cam);
+    unsigned seed = 11;
+    for (int i = 0; i < 200; i++) {
+        /* The homography a match would give for a pose: affine, z17 tile pixels */
+        vps_geopoint_t p = {(2.0 * test_rand(&seed) - 1.0) * 70.0,
+                            (2.0 * test_rand(&seed) - 1.0) * 179.0};
+        vps_footprint_t fp, fh;
+        double alt = 50.0 + test_rand(&seed) * 200.0, yaw = test_rand(&seed) * 360.0;
+        CHECK(vps_footprint_from_pose(p, alt, yaw, &cam, 17, &fp));
+        vps_tile_coord_t tile = {17, (int)floor(fp.x[0]), (int)floor(fp.y[0])};
+        double w = cam.image_width_px, h = cam.image_height_px;
+        double H[9] = {(fp.x[1] - fp.x[0]) * 256.0 / w, (fp.x[3] - fp.x[0]) * 256.0 / h,
+                       (fp.x[0] - tile.x) * 256.0,      (fp.y[1] - fp.y[0]) * 256.0 / w,
+                       (fp.y[3] - fp.y[0]) * 256.0 / h, (fp.y[0] - tile.y) * 256.0,
+                       0.0, 0.0, 1.0};
+        CHECK(vps_footprint_from_homography(H, tile, cam.image_width_px, cam.image_height_px, 17,
+                                            &fh));
+        for (int k = 0; k < 4; k++) {
+            CHECK_NEAR(fh.x[k], fp.x[k], 1e-6);
+            CHECK_NEAR(fh.y[k], fp.y[k], 1e-6);
+        }
+        /* Same footprint at z19, from the z17 homography */
+        CHECK(vps_footprint_from_homography(H, tile, cam.image_width_px, cam.image_height_px, 19,
+                                            &fh));
+        CHECK_NEAR(fh.x[2], fp.x[2] * 4.0, 1e-5);
+        check_cover(&fh);
+
+        /* Scaled (the same homography) plus mild perspective: still convex */
+        for (int k = 0; k < 9; k++) H[k] *= 2.0;
+        H[6] = 1e-4;
+        H[7] = -2e-4;
+        CHECK(vps_footprint_from_homography(H, tile, cam.image_width_px, cam.image_height_px, 19,
+                                            &fh));
+        check_cover(&fh);
+    }
+    /* Corners across the horizon, and a collapsed frame */
+    double horizon[9] = {1, 0, 0, 0, 1, 0, 0, -0.004, 1};
+    vps_footprint_t f;
+    vps_tile_coord_t t = {17, 100, 100};
+    CHECK(!vps_footprint_from_homography(horizon, t, 640, 480, 17, &f));
+    double flat[9] = {1, 0, 0, 0, 0, 0, 0, 0, 1};
+    CHECK(!vps_footprint_from_homography(flat, t, 640, 480, 17, &f));
+}
+
+int main(void) {
+    test_pose();
+    test_homography();
+    return test_report("test_footprint");
+}
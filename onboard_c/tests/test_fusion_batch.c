@@ -0,0 +1,143 @@
+/**
+ * @file test_fusion_batch.c
+ * @brief SoA batch fusion vs. per-frame calls, and the work-stealing pool.
+ */
+#include "fusion_pool.h"
+#include "test_common.h"
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define FRAMES 3000
+
+typedef struct {
+    double t[FRAMES], lat[FRAMES], lon[FRAMES], hdop[FRAMES];
+    double truth_lat[FRAMES], truth_lon[FRAMES];
+    bool fix[FRAMES];
+    vps_fusion_frames_t in;
+} flight_t;
+
+/* 10 Hz frames, a fix on every third, 60 s outages, noise and outliers */
+static void make_flight(flight_t *fl, unsigned seed, size_t n) {
+    double lat = 47.0, lon = 8.0;
+    for (size_t i = 0; i < n; i++) {
+        double t = i * 0.1;
+        lat += 12.0 * sin(t / 30.0) * 0.1 / 111320.0;
+        lon += 12.0 * cos(t / 45.0) * 0.1 / (111320.0 * cos(lat * M_PI / 180.0));
+        fl->t[i] = t;
+        fl->truth_lat[i] = lat;
+        fl->truth_lon[i] = lon;
+        fl->fix[i] = i % 3 == 0 && (i / 600) % 4 != 3;
+        fl->lat[i] = lat + 4.0 * (test_rand(&seed) - 0.5) / 111320.0;
+        fl->lon[i] = lon + 4.0 * (test_rand(&seed) - 0.5) / 111320.0;
+        if (i % 151 == 75) fl->lat[i] += 0.02;
+        fl->hdop[i] = 1.0 + 0.5 * (test_rand(&seed));
+    }
+    fl->in = (vps_fusion_frames_t){n, fl->t, fl->lat, fl->lon, fl->hdop, fl->fix,
+                                   fl->truth_lat, fl->truth_lon};
+}
+
+static void test_batch_matches_frames(void) {
+    static flight_t fl;
+    make_flight(&fl, 1, FRAMES);
+    vps_geofence_t fence = {VPS_FENCE_CIRCLE, {47.0, 8.0}, 0.6, 0.0, 0.0, 0.0, NULL};
+
+    vps_fusion_t a, b;
+    vps_fusion_init(&a, NULL, 10.0, &fence);
+    vps_fusion_init(&b, NULL, 10.0, &fence);
+
+    static double lat[FRAMES], lon[FRAMES], hdop[FRAMES], speed[FRAMES];
+    static uint8_t src[FRAMES], flags[FRAMES];
+    vps_fusion_track_t out = {lat, lon, hdop, speed, NULL, NULL, src, flags};
+    vps_fusion_batch_stats_t st = {0};
+    vps_fusion_run_batch(&a, &fl.in, &out, &st);
+
+    vps_fusion_batch_stats_t ref = {0};
+    int mismatches = 0;
+    double m_lon = 111320.0 * cos(fl.truth_lat[0] * M_PI / 180.0), max2 = 0.0;
+    for (size_t i = 0; i < FRAMES; i++) {
+        vps_geopoint_t z = {fl.lat[i], fl.lon[i]};
+        vps_fusion_output_t o = vps_fusion_update(&b, fl.fix[i] ? &z : NULL, fl.hdop[i], fl.t[i]);
+        uint8_t fb = (uint8_t)((o.geofence_ok ? VPS_FUSION_FLAG_GEOFENCE_OK : 0) |
+                               (o.ekf_accepted ? VPS_FUSION_FLAG_EKF_ACCEPTED : 0) |
+                               (o.has_position ? VPS_FUSION_FLAG_POSITION : 0));
+        if (lat[i] != o.position.lat || lon[i] != o.position.lon || hdop[i] != o.hdop ||
+            speed[i] != o.speed_mps || src[i] != o.source || flags[i] != fb)
+            mismatches++;
+        ref.fixes += fl.fix[i];
+        ref.accepted += o.ekf_accepted;
+        ref.positioned += o.has_position;
+        ref.fence_blocked += !o.geofence_ok;
+        if (o.has_position) {
+            double dn = (o.position.lat - fl.truth_lat[i]) * 111320.0;
+            double de = (o.position.lon - fl.truth_lon[i]) * m_lon;
+            ref.err_sum_sq_m2 += dn * dn + de * de;
+            if (dn * dn + de * de > max2) max2 = dn * dn + de * de;
+            ref.err_n++;
+        }
+    }
+    CHECK(mismatches == 0);
+    CHECK(st.frames == FRAMES);
+    CHECK(st.fixes == ref.fixes && st.accepted == ref.accepted);
+    CHECK(st.positioned == ref.positioned && st.err_n == ref.err_n);
+    CHECK(st.fence_blocked == ref.fence_blocked && st.fence_blocked > 0);
+    CHECK(st.accepted < st.fixes);  /* outliers gated */
+    CHECK(st.positioned < st.frames);  /* DR expires during outages */
+    CHECK(st.err_sum_sq_m2 == ref.err_sum_sq_m2);
+    CHECK_NEAR(st.err_max_m, sqrt(max2), 1e-12);
+    printf("batch: %llu frames, %llu positioned, rms %.2f m, max %.2f m\n",
+           (unsigned long long)st.frames, (unsigned long long)st.positioned,
+           sqrt(st.err_sum_sq_m2 / st.err_n), st.err_max_m);
+
+    /* No outputs and no truth (speed/heading skipped): same filter path */
+    vps_fusion_frames_t bare = fl.in;
+    bare.truth_lat = bare.truth_lon = NULL;
+    vps_fusion_reset(&a);
+    vps_fusion_run_batch(&a, &bare, NULL, &st);
+    CHECK(st.frames == 2 * FRAMES && st.err_n == ref.err_n);
+    CHECK(st.accepted == 2 * ref.accepted && st.positioned == 2 * ref.positioned);
+    CHECK(memcmp(a.ekf.x, b.ekf.x, sizeof(a.ekf.x)) == 0);
+    CHECK(memcmp(a.ekf.P, b.ekf.P, sizeof(a.ekf.P)) == 0);
+}
+
+/* Parameter sweep: the pool gives the sequential results for any thread count */
+static void test_pool_sweep(void) {
+    enum { JOBS = 37 };
+    static flight_t fl[3];
+    for (int k = 0; k < 3; k++) make_flight(&fl[k], 10 + k, FRAMES / (1 + 2 * k));
+
+    static vps_fusion_t fs[JOBS];
+    vps_fusion_job_t jobs[JOBS];
+    vps_fusion_batch_stats_t seq[JOBS];
+    static const int thread_counts[] = {1, 4, 0, 64};
+    for (size_t tc = 0; tc < sizeof(thread_counts) / sizeof(thread_counts[0]); tc++) {
+        for (int j = 0; j < JOBS; j++) {
+            vps_ekf_config_t cfg = vps_ekf_default_config();
+            cfg.gate_threshold = 2.0 + 0.25 * j;
+            vps_fusion_init(&fs[j], &cfg, 2.0 + j % 7, NULL);
+            jobs[j] = (vps_fusion_job_t){&fs[j], &fl[j % 3].in, NULL, {0}};
+        }
+        vps_fusion_pool_stats_t ps;
+        CHECK(vps_fusion_run_jobs(jobs, JOBS, thread_counts[tc], &ps));
+        CHECK(ps.threads >= 1);
+        for (int j = 0; j < JOBS; j++) {
+            if (tc == 0) {
+                seq[j] = jobs[j].stats;
+                CHECK(jobs[j].stats.frames == fl[j % 3].in.n);
+                continue;
+            }
+            CHECK(memcmp(&jobs[j].stats, &seq[j], sizeof(seq[j])) == 0);
+        }
+    }
+    /* Looser gates accept more fixes */
+    CHECK(seq[JOBS - 1].accepted >= seq[0].accepted);
+    CHECK(vps_fusion_run_jobs(jobs, 0, 4, NULL));
+}
+
+int main(void) {
+    test_batch_matches_frames();
+    test_pool_sweep();
+    return test_report("test_fusion_batch");
+}
@@ -0,0 +1,327 @@
+/**
+ * @file test_fusion_fx.c
+ * @brief Fixed-point fusion core against the double-precision build.
+ */
+#include "ekf32.h"
+#include "fusion.h"
+#include "fusion_fx.h"
+#include "msp.h"
+#include "smoother.h"
+#include "test_common.h"
+#include "tile_math.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* The plain bit-by-bit integer square root vps_fx_isqrt64 must match */
+static uint32_t isqrt_ref(uint64_t v) {
+    uint64_t r = 0, bit = (uint64_t)1 << 62;
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+static void test_isqrt(void) {
+    uint64_t bad = 0;
+    unsigned seed = 1;
+    for (int i = 0; i < 1000000; i++) {
+        /* Uniform over bit lengths, so small inputs are covered too */
+        uint64_t v = (uint64_t)test_rand_u32(&seed) << 32;
+        v = (v | test_rand_u32(&seed)) >> (test_rand_next(&seed) >> 26);
+        bad += vps_fx_isqrt64(v) != isqrt_ref(v);
+    }
+    for (uint64_t r = 0; r < 100000; r++)
+        for (uint64_t d = 0; d < 3; d++) {
+            uint64_t v = r * r + d - 1;     /* around perfect squares */
+            bad += vps_fx_isqrt64(v) != isqrt_ref(v);
+        }
+    for (int b = 0; b < 64; b++) {
+        uint64_t v = (uint64_t)1 << b;
+        bad += vps_fx_isqrt64(v) != isqrt_ref(v);
+        bad += vps_fx_isqrt64(v - 1) != isqrt_ref(v - 1);
+    }
+    CHECK(bad == 0);
+}
+
+static void test_math(void) {
+    double worst = 0.0;
+    for (int32_t d = -1800000000; d < 1800000000; d += 3700001) {
+        double e = fabs(vps_fx_cos_deg7(d) / 1073741824.0 - cos(d * 1e-7 * M_PI / 180.0));
+        if (e > worst) worst = e;
+    }
+    CHECK(worst < 2e-9);
+    CHECK(vps_fx_cos_deg7(0) == 1 << 30);
+    CHECK(vps_fx_cos_deg7(900000000) == 0);
+    CHECK(vps_fx_cos_deg7(-1800000000) == -(1 << 30));
+
+    worst = 0.0;
+    unsigned seed = 3;
+    for (int i = 0; i < 20000; i++) {
+        int32_t y = (int32_t)(test_rand_next(&seed) >> 8) - (1 << 23);
+        int32_t x = (int32_t)(test_rand_next(&seed) >> (8 + i % 16)) - (1 << (23 - i % 16));
+        double e = fabs(vps_fx_atan2_deg(y, x) / 65536.0 - atan2(y, x) * 180.0 / M_PI);
+        if (e > 180.0) e = 360.0 - e;
+        if (e > worst) worst = e;
+    }
+    CHECK(worst < 1e-4);
+    CHECK(vps_fx_atan2_deg(0, 0) == 0);
+    CHECK(vps_fx_atan2_deg(0, -5) == 180 << 16);
+    CHECK(vps_fx_atan2_deg(5, 0) == 90 << 16);
+
+    uint64_t vals[] = {0, 1, 2, 3, 4, 99, 100, 4294967295ull, 4294967296ull,
+                       18446744073709551615ull, 1234567890123456789ull};
+    for (size_t i = 0; i < sizeof(vals) / sizeof(vals[0]); i++) {
+        uint64_t r = vps_fx_isqrt64(vals[i]);
+        CHECK(r * r <= vals[i]);
+        CHECK(r == 4294967295ull || (r + 1) * (r + 1) > vals[i]);
+    }
+}
+
+/* One step of the integer kernels against the float ones */
+static void test_kernels(void) {
+    float xf[4] = {12.5f, -3.25f, 4.0f, -1.5f};
+    float pf[VPS_EKF_PACKED] = {20.0f, 1.5f, 3.0f, 0.2f, 14.0f, 0.1f, 2.0f, 1.2f, 0.05f, 0.9f};
+    /* Fraction bits per packed entry: position, position-velocity, velocity */
+    static const int frac[VPS_FX_PACKED] = {8, 8, 12, 12, 8, 12, 12, 16, 16, 16};
+    int32_t x[4], p[VPS_FX_PACKED];
+    for (int i = 0; i < 4; i++) x[i] = (int32_t)lrint(xf[i] * 65536.0);
+    for (int i = 0; i < VPS_FX_PACKED; i++) p[i] = (int32_t)lrint(ldexp(pf[i], frac[i]));
+
+    vps_ekf32_propagate(xf, pf, 1.2392f, 0.57f, 0.333f);
+    vps_fx_ekf_propagate(x, p, (int32_t)lrint(1.2392 * 65536), (int32_t)lrint(0.57 * 65536),
+                         (int32_t)lrint(0.333 * 65536));
+    for (int i = 0; i < VPS_FX_PACKED; i++) CHECK_NEAR(ldexp(p[i], -frac[i]), pf[i], ldexp(2.0, -frac[i]));
+
+    float df = vps_ekf32_correct(xf, pf, 15.0f, -2.0f, 124.0f, 57.0f, 5.0f);
+    int32_t d = vps_fx_ekf_correct(x, p, 15 << 16, -(2 << 16), 124 << 8, 57 << 8, 5 << 16);
+    CHECK_NEAR(d / 65536.0, df, 1e-4);
+    for (int i = 0; i < 4; i++) CHECK_NEAR(x[i] / 65536.0, xf[i], 1e-4);
+    for (int i = 0; i < VPS_FX_PACKED; i++) CHECK_NEAR(ldexp(p[i], -frac[i]), pf[i], ldexp(2.0, -frac[i]));
+
+    /* Outside the gate nothing changes; singular S is reported */
+    int32_t x0[4], p0[VPS_FX_PACKED];
+    memcpy(x0, x, sizeof(x));
+    memcpy(p0, p, sizeof(p));
+    CHECK(vps_fx_ekf_correct(x, p, 900 << 16, 0, 124 << 8, 57 << 8, 5 << 16) > 5 << 16);
+    CHECK(memcmp(x, x0, sizeof(x)) == 0 && memcmp(p, p0, sizeof(p)) == 0);
+    int32_t pz[VPS_FX_PACKED] = {0};
+    CHECK(vps_fx_ekf_correct(x, pz, 0, 0, 0, 0, 5 << 16) == -1);
+}
+
+static int32_t rd32(const uint8_t *p) {
+    return (int32_t)((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+                     (uint32_t)p[3] << 24);
+}
+
+/* --- A recorded flight replayed through both builds --- */
+
+#define FIXES 2400
+
+static const vps_geopoint_t home = {47.3977, 8.5456};
+
+/*
+ * 3 Hz fixes with two prediction ticks between them: a survey pattern
+ * with turns and speed changes, gaussian-ish noise scaled by HDOP, a
+ * 200 m outlier every 97 fixes, a 12 s dropout and a 45 s gap (filter
+ * restart), and a leg that leaves the fence. Written as VPSF records.
+ */
+static size_t record_flight(uint8_t *buf) {
+    size_t n = 0;
+    vps_vpsf_encode_header(buf);
+    buf += VPS_VPSF_HEADER_SIZE;
+    unsigned seed = 11;
+    double north = 0.0, east = 0.0, heading = 30.0, t = 0.0;
+    for (int k = 0; k < FIXES; k++) {
+        double speed = 8.0 + 4.0 * sin(k * 0.004);
+        heading += (k / 150) % 2 ? 0.6 : -0.25;
+        double dt = (k == 900) ? 12.0 : (k == 1500) ? 45.0 : 1.0 / 3.0;
+        north += speed * dt * cos(heading * M_PI / 180.0);
+        east += speed * dt * sin(heading * M_PI / 180.0);
+        if (k >= 1900 && k < 2100) north += 2.5;   /* straight out of the fence */
+        t += dt;
+
+        for (int tick = 0; tick < 3; tick++) {
+            vps_vpsf_record_t r;
+            memset(&r, 0, sizeof(r));
+            r.timestamp = round((t + tick / 9.0) * 1000.0) / 1000.0;
+            if (tick == 0) {
+                double g[2];
+                for (int j = 0; j < 2; j++) {
+                    double s = 0.0;
+                    for (int m = 0; m < 4; m++) s += test_rand(&seed) - 0.5;
+                    g[j] = s * 1.7;
+                }
+                r.hdop = (float)(0.8 + 0.01 * (k % 90));
+                double sigma = 3.0 * r.hdop;
+                double nn = north + g[0] * sigma, ee = east + g[1] * sigma;
+                if (k % 97 == 50) nn += 200.0;
+                r.lat = round((home.lat + nn / 111320.0) * 1e7) / 1e7;
+                r.lon = round((home.lon + ee / (111320.0 * cos(home.lat * M_PI / 180.0))) * 1e7) / 1e7;
+                r.source = VPS_VPSF_SOURCE_VISUAL;
+            }
+            vps_vpsf_encode(buf + n * VPS_VPSF_RECORD_SIZE, &r);
+            n++;
+        }
+    }
+    return n;
+}
+
+static void test_flight(void) {
+    static uint8_t log[VPS_VPSF_HEADER_SIZE + 3 * FIXES * VPS_VPSF_RECORD_SIZE];
+    size_t n = record_flight(log);
+    CHECK(vps_vpsf_check_header(log));
+
+    vps_geofence_t fence = {VPS_FENCE_CIRCLE, home, 2.0, 0.05, 0.0, 0.0, NULL};
+    vps_fx_fence_t fx_fence = {VPS_FENCE_CIRCLE, {473977000, 85456000}, 2000000, 50000, 0, 0};
+
+    vps_fusion_t f;
+    vps_fusion_init(&f, NULL, 10.0, &fence);
+    vps_fx_fusion_t fx;
+    vps_fx_fusion_init(&fx, NULL, &fx_fence);
+
+    double worst = 0.0, worst_speed = 0.0, worst_heading = 0.0;
+    int mismatched = 0, accepted = 0, rejected = 0, fenced = 0, compared = 0;
+    for (size_t i = 0; i < n; i++) {
+        vps_vpsf_record_t r;
+        vps_vpsf_decode(log + VPS_VPSF_HEADER_SIZE + i * VPS_VPSF_RECORD_SIZE, &r);
+        bool fix = r.source == VPS_VPSF_SOURCE_VISUAL;
+        vps_geopoint_t z = {r.lat, r.lon};
+        uint16_t hdop = (uint16_t)lrint(r.hdop * 100.0);
+        vps_fx_point_t zq = {(int32_t)lrint(r.lat * 1e7), (int32_t)lrint(r.lon * 1e7)};
+
+        vps_fusion_output_t o = vps_fusion_update(&f, fix ? &z : NULL, hdop / 100.0, r.timestamp);
+        vps_fx_output_t q = vps_fx_fusion_update(&fx, fix ? &zq : NULL, hdop,
+                                                 (uint32_t)lrint(r.timestamp * 1000.0));
+        if (fix) {
+            accepted += o.ekf_accepted;
+            rejected += !o.ekf_accepted;
+            /* Decisions can only differ right at the gate */
+            if (o.ekf_accepted != q.ekf_accepted) {
+                CHECK(fabs(f.ekf.last_gate - 5.0) < 1e-3);
+                mismatched++;
+            }
+        }
+
+        /* Fence: outputs agree except within a metre of the boundary */
+        if (fabs(vps_geofence_distance_km(&fence, o.position) - fence.margin_km) < 1e-3) continue;
+        fenced += !o.geofence_ok;
+        CHECK(o.has_position == q.has_position);
+        CHECK(o.geofence_ok == q.geofence_ok);
+        CHECK((int)o.source == (int)q.source);
+        CHECK(lrint(o.hdop * 100.0) == q.hdop);
+        if (!o.has_position || !q.has_position) continue;
+
+        double dn = (q.position.lat * 1e-7 - o.position.lat) * 111320.0;
+        double de = (q.position.lon * 1e-7 - o.position.lon) * 111320.0 *
+                    cos(o.position.lat * M_PI / 180.0);
+        double e = hypot(dn, de);
+        if (e > worst) worst = e;
+        double ds = fabs(q.speed_cms - o.speed_mps * 100.0);
+        if (ds > worst_speed) worst_speed = ds;
+        if (o.speed_mps > 1.0) {
+            double dh = fabs(q.heading_deg10 / 10.0 - o.heading_deg);
+            if (dh > 180.0) dh = 360.0 - dh;
+            if (dh > worst_heading) worst_heading = dh;
+        }
+
+        /* Same MSP frame up to the last digit of the coordinates */
+        uint8_t a[MSP_GPS_FRAME_SIZE], b[MSP_GPS_FRAME_SIZE];
+        vps_msp_encode_position(a, o.position, o.speed_mps, o.heading_deg, o.hdop, true);
+        CHECK(vps_fx_encode_msp(b, &q) == MSP_GPS_FRAME_SIZE);
+        CHECK(memcmp(a, b, 7) == 0 && memcmp(a + 15, b + 15, 2) == 0);
+        CHECK(abs(rd32(a + 7) - rd32(b + 7)) <= 2 && abs(rd32(a + 11) - rd32(b + 11)) <= 2);
+        CHECK(abs((a[21] | a[22] << 8) - (b[21] | b[22] << 8)) <= 1);   /* HDOP truncation */
+        compared++;
+    }
+    printf("fx flight: %d outputs, %d/%d fixes accepted, %d outside the fence, "
+           "%d gate disagreements\n", compared, accepted, accepted + rejected, fenced, mismatched);
+    printf("  worst position %.4f m, speed %.2f cm/s, heading %.3f deg\n", worst, worst_speed,
+           worst_heading);
+    CHECK(accepted > FIXES * 9 / 10 && rejected >= 20 && fenced > 100);
+    CHECK(mismatched <= 2);
+    CHECK(worst < 0.01);
+    CHECK(worst_speed < 1.5);
+    CHECK(worst_heading < 0.2);
+    CHECK(fx.ekf.reanchors >= 5);
+}
+
+static void test_odometry(void) {
+    vps_fusion_t f;
+    vps_fusion_init(&f, NULL, 10.0, NULL);
+    vps_fx_fusion_t fx;
+    vps_fx_fusion_init(&fx, NULL, NULL);
+
+    vps_geopoint_t z = {-33.8568, 151.2153};
+    vps_fx_point_t zq = {-338568000, 1512153000};
+    CHECK(!vps_fx_fusion_odometry(&fx, 1000, 0, 2, 500));
+    vps_fusion_update(&f, &z, 1.2, 0.0);
+    vps_fx_fusion_update(&fx, &zq, 120, 0);
+    vps_fusion_update(&f, &z, 1.2, 1.0);
+    vps_fx_fusion_update(&fx, &zq, 120, 1000);
+    for (int k = 1; k <= 40; k++) {
+        int32_t dn = 1500 - 37 * k, de = -800 + 21 * k;   /* mm per 100 ms */
+        CHECK(vps_fusion_odometry(&f, dn / 1000.0, de / 1000.0, 0.02, 1.0 + 0.1 * k));
+        CHECK(vps_fx_fusion_odometry(&fx, dn, de, 2, 1000 + 100 * (uint32_t)k));
+    }
+    for (int k = 0; k < 3; k++) {
+        double t = 5.05 + 4.0 * k;
+        vps_fusion_output_t o = vps_fusion_update(&f, NULL, 1.0, t);
+        vps_fx_output_t q = vps_fx_fusion_update(&fx, NULL, 100, (uint32_t)lrint(t * 1000.0));
+        CHECK(o.has_position == q.has_position && (int)o.source == (int)q.source);
+        CHECK(lrint(o.hdop * 100.0) == q.hdop);
+        if (!q.has_position) continue;
+        CHECK(q.source == VPS_SOURCE_DEAD_RECKONING);
+        CHECK_NEAR(q.position.lat * 1e-7, o.position.lat, 2e-7);
+        CHECK_NEAR(q.position.lon * 1e-7, o.position.lon, 2e-7);
+    }
+    /* Past the DR horizon the EKF prediction takes over again */
+    CHECK(vps_fx_fusion_update(&fx, NULL, 100, 15100).source == VPS_SOURCE_EKF_PREDICT);
+}
+
+static void test_fence(void) {
+    vps_geofence_t circle = {VPS_FENCE_CIRCLE, {60.17, 24.94}, 2.5, 0.1, 0.0, 0.0, NULL};
+    vps_geofence_t rect = {VPS_FENCE_RECT, {-12.05, -77.04}, 0.0, 0.2, 3.0, 1.5, NULL};
+    vps_fx_fence_t fc = {VPS_FENCE_CIRCLE, {601700000, 249400000}, 2500000, 100000, 0, 0};
+    vps_fx_fence_t fr = {VPS_FENCE_RECT, {-120500000, -770400000}, 0, 200000, 3000000, 1500000};
+
+    unsigned seed = 7;
+    int inside = 0;
+    for (int i = 0; i < 20000; i++) {
+        double a = test_rand(&seed) - 0.5;
+        double b = test_rand(&seed) - 0.5;
+        const vps_geofence_t *g = i % 2 ? &rect : &circle;
+        const vps_fx_fence_t *q = i % 2 ? &fr : &fc;
+        vps_geopoint_t p = {g->center.lat + 0.08 * a, g->center.lon + 0.12 * b};
+        vps_fx_point_t pq = {(int32_t)lrint(p.lat * 1e7), (int32_t)lrint(p.lon * 1e7)};
+        p.lat = pq.lat * 1e-7;
+        p.lon = pq.lon * 1e-7;
+
+        double dkm = vps_geofence_distance_km(g, p);
+        CHECK_NEAR(vps_fx_fence_distance_mm(q, pq) * 1e-6, dkm, 1e-5);
+        if (fabs(dkm - g->margin_km) < 1e-5) continue;
+        CHECK(vps_geofence_contains(g, p) == vps_fx_fence_contains(q, pq));
+        inside += vps_fx_fence_contains(q, pq);
+    }
+    CHECK(inside > 2000 && inside < 18000);
+}
+
+int main(void) {
+    test_math();
+    test_isqrt();
+    test_kernels();
+    test_flight();
+    test_odometry();
+    test_fence();
+    return test_report("test_fusion_fx");
+}
@@ -0,0 +1,196 @@
+/**
+ * @file test_geofence_breach.c
+ * @brief Predicted breach times against dense sampling of the same track,
+ *        for single fences, zone sets and the fusion engine.
+ */
+#include "fence_set.h"
+#include "fusion.h"
+#include "geofence.h"
+#include "test_common.h"
+#include "tile_math.h"
+#include <stdlib.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define M_PER_DEG (6371000.0 * M_PI / 180.0)
+#define HORIZON 5.0
+#define STEP 0.002
+#define EPS_KM 5e-4
+
+static vps_geopoint_t offset(vps_geopoint_t c, double n_km, double e_km) {
+    return (vps_geopoint_t){c.lat + n_km * 1e3 / M_PER_DEG,
+                            c.lon + e_km * 1e3 / (M_PER_DEG * cos(c.lat * M_PI / 180.0))};
+}
+
+/* Track at constant lat/lon rates, as the EKF predicts */
+static vps_geopoint_t track(vps_geopoint_t p, double vn, double ve, double t) {
+    return offset(p, vn * t * 1e-3, ve * t * 1e-3);
+}
+
+static bool violated(const vps_geofence_t *f, bool exclusion, vps_geopoint_t p, double reach) {
+    double d = vps_geofence_distance_km(f, p);
+    return exclusion ? d > -reach : d < reach;
+}
+
+/* First sampled violation at reach (km), INFINITY if none within the horizon */
+static double sampled(const vps_geofence_t *f, bool exclusion, vps_geopoint_t p, double vn,
+                      double ve, double reach) {
+    for (double t = 0.0; t <= HORIZON; t += STEP)
+        if (violated(f, exclusion, track(p, vn, ve, t), reach)) return t;
+    return INFINITY;
+}
+
+/* Analytic time agrees with sampling at reach -/+ EPS_KM (grazing tracks) */
+static int check_sweep(const vps_geofence_t *f, bool exclusion, vps_geopoint_t p, double vn,
+                       double ve, double radius_km) {
+    double t;
+    bool hit = exclusion ? vps_geofence_time_to_entry(f, p, vn, ve, radius_km, HORIZON, &t)
+                         : vps_geofence_time_to_breach(f, p, vn, ve, radius_km, HORIZON, &t);
+    double reach = f->margin_km + radius_km;
+    double late = sampled(f, exclusion, p, vn, ve, reach - EPS_KM);
+    double early = sampled(f, exclusion, p, vn, ve, reach + EPS_KM);
+    CHECK(hit == (t <= HORIZON));
+    CHECK(hit || isinf(t));
+    bool ok = t >= early - STEP && (isinf(late) || t <= late + STEP);
+    if (!ok)
+        fprintf(stderr, "type %d excl %d: t=%.4f sampled [%.4f, %.4f]\n", f->type, exclusion,
+                t, early, late);
+    CHECK(ok);
+    return hit;
+}
+
+static void star(vps_geofence_poly_t *poly, vps_geopoint_t c, double size, unsigned *seed) {
+    vps_geopoint_t pts[40];
+    int len[] = {24, 16};
+    for (int k = 0; k < 24; k++) {
+        double a = 2.0 * M_PI * k / 24, r = size * (0.6 + 0.4 * test_rand(seed));
+        pts[k] = offset(c, r * sin(a), r * cos(a));
+    }
+    for (int k = 0; k < 16; k++) {          /* hole */
+        double a = 2.0 * M_PI * k / 16;
+        pts[24 + k] = offset(c, 0.25 * size * sin(a), 0.25 * size * cos(a));
+    }
+    CHECK(vps_geofence_poly_build(poly, pts, len, 2));
+}
+
+static void test_single(void) {
+    vps_geopoint_t home = {47.3977, 8.5456};
+    unsigned seed = 11;
+    vps_geofence_poly_t poly;
+    star(&poly, home, 0.6, &seed);
+    vps_geofence_t fences[] = {
+        {VPS_FENCE_CIRCLE, home, 0.4, 0.05, 0.0, 0.0, NULL},
+        {VPS_FENCE_RECT, home, 0.0, 0.03, 0.3, 0.45, NULL},
+        {VPS_FENCE_POLYGON, home, 0.0, 0.04, 0.0, 0.0, &poly},
+    };
+    for (int k = 0; k < 3; k++)
+        for (int exclusion = 0; exclusion < 2; exclusion++) {
+            int hits = 0, n = 150;
+            for (int i = 0; i < n; i++) {
+                vps_geopoint_t p = offset(home, (test_rand(&seed) - 0.5) * 1.6,
+                                          (test_rand(&seed) - 0.5) * 1.6);
+                double h = 2.0 * M_PI * test_rand(&seed), v = 5.0 + 25.0 * test_rand(&seed);
+                double radius = i % 4 ? 0.03 * test_rand(&seed) : 0.0;
+                hits += check_sweep(&fences[k], exclusion, p, v * cos(h), v * sin(h), radius);
+            }
+            CHECK(hits > 10 && hits < n - 10);
+        }
+
+    /* Hovering: clear stays clear, a breach is immediate */
+    double t;
+    CHECK(!vps_geofence_time_to_breach(&fences[0], home, 0.0, 0.0, 0.0, HORIZON, &t));
+    CHECK(isinf(t));
+    vps_geopoint_t out = offset(home, 1.0, 0.0);
+    CHECK(vps_geofence_time_to_breach(&fences[0], out, 0.0, 0.0, 0.0, HORIZON, &t) && t == 0.0);
+    CHECK(vps_geofence_time_to_breach(&fences[2], out, 0.0, 0.0, 0.0, HORIZON, &t) && t == 0.0);
+    /* 20 m/s due east from the centre: 0.4 - 0.05 - 0.01 km away */
+    CHECK(vps_geofence_time_to_breach(&fences[0], home, 0.0, 20.0, 0.01, HORIZON * 4, &t));
+    CHECK_NEAR(t, 340.0 / 20.0, 1e-3);
+    /* Uncertainty as large as the fence: breach now */
+    CHECK(vps_geofence_time_to_breach(&fences[1], home, 0.0, 0.0, 0.5, HORIZON, &t) && t == 0.0);
+    vps_geofence_poly_free(&poly);
+}
+
+#define N_ZONES 300
+
+static void test_set(void) {
+    vps_geopoint_t home = {47.3977, 8.5456};
+    static vps_fence_zone_t zones[N_ZONES];
+    static vps_geofence_poly_t polys[N_ZONES];
+    vps_fence_zone_t inclusion = {.fence = {VPS_FENCE_CIRCLE, home, 8.0, 0.1, 0.0, 0.0, NULL}};
+    unsigned seed = 5;
+    for (int i = 0; i < N_ZONES; i++) {
+        vps_geopoint_t c = offset(home, (test_rand(&seed) - 0.5) * 20.0,
+                                  (test_rand(&seed) - 0.5) * 20.0);
+        double size = 0.1 + 0.4 * test_rand(&seed), margin = 0.02 + 0.1 * test_rand(&seed);
+        vps_geofence_t f = {VPS_FENCE_CIRCLE, c, size, margin, 0.0, 0.0, NULL};
+        if (i % 3 == 1) {
+            f = (vps_geofence_t){VPS_FENCE_RECT, c, 0.0, margin, size, 0.7 * size, NULL};
+        } else if (i % 3 == 2) {
+            star(&polys[i], c, size, &seed);
+            f = (vps_geofence_t){VPS_FENCE_POLYGON, c, 0.0, margin, 0.0, 0.0, &polys[i]};
+        }
+        zones[i] = (vps_fence_zone_t){.fence = f, .id = (uint32_t)i};
+    }
+    vps_fence_set_t set;
+    CHECK(vps_fence_set_build(&set, &inclusion, zones, N_ZONES));
+
+    int hits = 0;
+    for (int i = 0; i < 2000; i++) {
+        vps_geopoint_t p = offset(home, (test_rand(&seed) - 0.5) * 17.0,
+                                  (test_rand(&seed) - 0.5) * 17.0);
+        double h = 2.0 * M_PI * test_rand(&seed), v = 5.0 + 25.0 * test_rand(&seed);
+        double vn = v * cos(h), ve = v * sin(h), radius = 0.02 * test_rand(&seed);
+        /* Every zone, no BVH */
+        double want, t;
+        int want_zone = -2, zone;
+        if (!vps_geofence_time_to_breach(&inclusion.fence, p, vn, ve, radius, HORIZON, &want))
+            want = INFINITY;
+        else
+            want_zone = -1;
+        for (int z = 0; z < set.n_zones; z++)
+            if (vps_geofence_time_to_entry(&set.zones[z].fence, p, vn, ve, radius, HORIZON, &t) &&
+                t < want) {
+                want = t;
+                want_zone = z;
+            }
+        bool hit = vps_fence_set_time_to_breach(&set, p, vn, ve, radius, HORIZON, &t, &zone);
+        CHECK(hit == (want_zone != -2));
+        CHECK(t == want);
+        CHECK(zone == want_zone || t == 0.0);
+        hits += hit;
+    }
+    CHECK(hits > 200 && hits < 1800);
+    vps_fence_set_free(&set);
+    for (int i = 2; i < N_ZONES; i += 3) vps_geofence_poly_free(&polys[i]);
+}
+
+static void test_fusion(void) {
+    vps_geopoint_t home = {47.3977, 8.5456};
+    vps_geofence_t fence = {VPS_FENCE_CIRCLE, home, 0.5, 0.05, 0.0, 0.0, NULL};
+    vps_fusion_t f;
+    vps_fusion_init(&f, NULL, 10.0, &fence);
+    double t_b;
+    CHECK(!vps_fusion_time_to_breach(&f, 0.0, HORIZON, 0.0, &t_b) && isinf(t_b));
+    /* 15 m/s north from home for 28 s of visual fixes */
+    double t = 0.0;
+    for (int i = 0; i < 280; i++, t += 0.1) {
+        vps_geopoint_t p = {home.lat + 15.0 * t / 111320.0, home.lon};
+        vps_fusion_update(&f, &p, 1.0, t);
+    }
+    vps_geopoint_t now = vps_ekf_predict(&f.ekf, t);
+    double left = 450.0 - vps_haversine_km(home, now) * 1000.0;   /* m to the margin */
+    CHECK(left > 0.0 && left < 5.0 * 15.0);
+    CHECK(vps_fusion_time_to_breach(&f, t, HORIZON, 0.0, &t_b));
+    CHECK_NEAR(t_b, left / vps_ekf_speed(&f.ekf), 0.05);
+    CHECK(!vps_fusion_time_to_breach(&f, t, 0.5 * t_b, 0.0, &t_b));
+}
+
+int main(void) {
+    test_single();
+    test_set();
+    test_fusion();
+    return test_report("test_geofence_breach");
+}
@@ -0,0 +1,215 @@
+/**
+ * @file test_geofence_poly.c
+ * @brief Polygon geofence: grid index against brute force, holes, margins.
+ */
+#include "geofence.h"
+#include "test_common.h"
+#include "tile_math.h"
+#include <stdlib.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Even-odd ray cast and nearest edge over the whole edge table */
+static bool brute_inside(const vps_geofence_poly_t *p, double x, double y) {
+    bool in = false;
+    for (int i = 0; i < p->n_edges; i++) {
+        const vps_poly_edge_t *e = &p->edges[i];
+        if ((e->ay > y) != (e->by > y) &&
+            x < e->ax + (y - e->ay) * (e->bx - e->ax) / (e->by - e->ay))
+            in = !in;
+    }
+    return in;
+}
+
+static double brute_dist(const vps_geofence_poly_t *p, double x, double y) {
+    double best = INFINITY;
+    for (int i = 0; i < p->n_edges; i++) {
+        const vps_poly_edge_t *e = &p->edges[i];
+        double dx = e->bx - e->ax, dy = e->by - e->ay;
+        double t = ((x - e->ax) * dx + (y - e->ay) * dy) / (dx * dx + dy * dy);
+        t = t < 0.0 ? 0.0 : t > 1.0 ? 1.0 : t;
+        best = fmin(best, hypot(x - e->ax - t * dx, y - e->ay - t * dy));
+    }
+    return best;
+}
+
+/* Star-shaped outer ring around c (radius 3..6 km) with two round holes */
+static int make_star(vps_geopoint_t *pts, int *len, int n, vps_geopoint_t c) {
+    unsigned seed = 7;
+    double kx = 1.0 / (111.195 * cos(c.lat * M_PI / 180.0)), ky = 1.0 / 111.195;
+    for (int i = 0; i < n; i++) {
+        double a = 2.0 * M_PI * i / n;
+        double r = 4.5 + 1.0 * sin(7.0 * a) + 0.5 * test_rand(&seed);
+        pts[i] = (vps_geopoint_t){c.lat + r * sin(a) * ky, c.lon + r * cos(a) * kx};
+    }
+    len[0] = n;
+    int k = n;
+    for (int h = 0; h < 2; h++) {
+        double hx = h ? 1.5 : -1.0, hy = h ? 0.5 : -1.5, hr = h ? 0.8 : 1.2;
+        for (int i = 0; i < n / 8; i++) {
+            double a = -2.0 * M_PI * i / (n / 8);
+            pts[k++] = (vps_geopoint_t){c.lat + (hy + hr * sin(a)) * ky,
+                                        c.lon + (hx + hr * cos(a)) * kx};
+        }
+        len[1 + h] = n / 8;
+    }
+    return 3;
+}
+
+static void test_square_with_hole(void) {
+    /* 2 x 2 km square (closed explicitly), 0.5 x 0.5 km hole in the middle */
+    vps_geopoint_t c = {46.0, 7.0};
+    double ky = 1.0 / 111.195, kx = ky / cos(c.lat * M_PI / 180.0);
+    vps_geopoint_t pts[] = {
+        {c.lat - ky, c.lon - kx}, {c.lat - ky, c.lon + kx}, {c.lat + ky, c.lon + kx},
+        {c.lat + ky, c.lon - kx}, {c.lat - ky, c.lon - kx},
+        {c.lat - 0.25 * ky, c.lon - 0.25 * kx}, {c.lat + 0.25 * ky, c.lon - 0.25 * kx},
+        {c.lat + 0.25 * ky, c.lon + 0.25 * kx}, {c.lat - 0.25 * ky, c.lon + 0.25 * kx},
+    };
+    int len[] = {5, 4};
+    vps_geofence_poly_t poly;
+    CHECK(vps_geofence_poly_build(&poly, pts, len, 2));
+    CHECK(poly.n_edges == 8);   /* the closing duplicate is dropped */
+
+    CHECK(!vps_geofence_poly_contains(&poly, c, 0.0));                 /* in the hole */
+    vps_geopoint_t ring = {c.lat + 0.6 * ky, c.lon};
+    CHECK(vps_geofence_poly_contains(&poly, ring, 0.0));
+    CHECK_NEAR(vps_geofence_poly_distance_km(&poly, ring), 0.35, 1e-3);
+    CHECK(vps_geofence_poly_contains(&poly, ring, 0.3));
+    CHECK(!vps_geofence_poly_contains(&poly, ring, 0.4));
+    CHECK_NEAR(vps_geofence_poly_distance_km(&poly, c), -0.25, 1e-3);
+    vps_geopoint_t out = {c.lat, c.lon + 3.0 * kx};
+    CHECK(!vps_geofence_poly_contains(&poly, out, 0.0));
+    CHECK_NEAR(vps_geofence_poly_distance_km(&poly, out), -2.0, 2e-3);
+    vps_geopoint_t far = {c.lat + 1.0, c.lon - 1.0};
+    CHECK(vps_geofence_poly_distance_km(&poly, far) < -100.0);
+
+    /* Through vps_geofence_t, margin from the fence */
+    vps_geofence_t fence = {VPS_FENCE_POLYGON, c, 0.0, 0.3, 0.0, 0.0, &poly};
+    CHECK(vps_geofence_contains(&fence, ring));
+    fence.margin_km = 0.4;
+    CHECK(!vps_geofence_contains(&fence, ring));
+    CHECK_NEAR(vps_geofence_distance_km(&fence, ring), 0.35, 1e-3);
+    vps_geofence_poly_free(&poly);
+    CHECK(poly.edges == NULL);
+}
+
+static void test_against_brute_force(void) {
+    enum { N = 4000 };
+    static vps_geopoint_t pts[N + N / 4];
+    int len[3];
+    vps_geopoint_t c = {-33.87, 151.21};
+    int rings = make_star(pts, len, N, c);
+    vps_geofence_poly_t poly;
+    CHECK(vps_geofence_poly_build(&poly, pts, len, rings));
+    CHECK(poly.n_edges == N + N / 4);
+
+    unsigned seed = 3;
+    int mismatch = 0, near_edge = 0, inside = 0;
+    for (int i = 0; i < 20000; i++) {
+        double x = -7.0 + 14.0 * test_rand(&seed), y = -7.0 + 14.0 * test_rand(&seed);
+        vps_geopoint_t p = {c.lat + y / 111.195, 0.0};
+        p.lon = c.lon + x / (111.195 * cos(p.lat * M_PI / 180.0));
+        double px, py;
+        vps_geofence_poly_project(&poly, p, &px, &py);
+        double d = brute_dist(&poly, px, py);
+        double got = vps_geofence_poly_distance_km(&poly, p);
+        CHECK_NEAR(fabs(got), d, 1e-12);
+        if (d < 1e-9) {
+            near_edge++;
+            continue;
+        }
+        bool in = brute_inside(&poly, px, py);
+        inside += in;
+        mismatch += in != vps_geofence_poly_contains(&poly, p, 0.0);
+        mismatch += in != (got > 0.0);
+        mismatch += (in && d >= 0.2) != vps_geofence_poly_contains(&poly, p, 0.2);
+    }
+    CHECK(mismatch == 0);
+    CHECK(near_edge == 0);
+    CHECK(inside > 5000 && inside < 15000);
+    vps_geofence_poly_free(&poly);
+}
+
+/* Vertices on cell-centre lines and rays through vertices */
+static void test_degenerate_alignment(void) {
+    vps_geopoint_t pts[64];
+    int n = 0;
+    /* Staircase with many collinear horizontal runs */
+    for (int i = 0; i < 16; i++) {
+        pts[n++] = (vps_geopoint_t){10.0 + 0.001 * i, 20.0 + 0.001 * i};
+        pts[n++] = (vps_geopoint_t){10.0 + 0.001 * i, 20.0 + 0.001 * (i + 1)};
+    }
+    pts[n++] = (vps_geopoint_t){10.0 + 0.016, 20.0};
+    int len[] = {n};
+    vps_geofence_poly_t poly;
+    CHECK(vps_geofence_poly_build(&poly, pts, len, 1));
+    int mismatch = 0;
+    for (int i = 0; i <= 80; i++)
+        for (int j = 0; j <= 80; j++) {
+            vps_geopoint_t p = {10.0 - 0.0005 + 0.00025 * i, 20.0 - 0.0005 + 0.00025 * j};
+            double px, py;
+            vps_geofence_poly_project(&poly, p, &px, &py);
+            if (brute_dist(&poly, px, py) < 1e-9) continue;
+            mismatch += brute_inside(&poly, px, py) != vps_geofence_poly_contains(&poly, p, 0.0);
+        }
+    CHECK(mismatch == 0);
+    vps_geofence_poly_free(&poly);
+}
+
+/* A dense polygonized circle agrees with the haversine circle fence */
+static void test_circle_polygon(void) {
+    enum { N = 2000 };
+    static vps_geopoint_t pts[N];
+    vps_geopoint_t c = {47.3977, 8.5456};
+    for (int i = 0; i < N; i++) {
+        double a = 2.0 * M_PI * i / N;
+        double r = 2.0 / 6371.0;   /* 2 km on the haversine sphere */
+        double lat = asin(sin(c.lat * M_PI / 180.0) * cos(r) +
+                          cos(c.lat * M_PI / 180.0) * sin(r) * cos(a));
+        double lon = c.lon * M_PI / 180.0 +
+                     atan2(sin(a) * sin(r) * cos(c.lat * M_PI / 180.0),
+                           cos(r) - sin(c.lat * M_PI / 180.0) * sin(lat));
+        pts[i] = (vps_geopoint_t){lat * 180.0 / M_PI, lon * 180.0 / M_PI};
+    }
+    int len[] = {N};
+    vps_geofence_poly_t poly;
+    CHECK(vps_geofence_poly_build(&poly, pts, len, 1));
+    vps_geofence_t circle = {VPS_FENCE_CIRCLE, c, 2.0, 0.0, 0.0, 0.0, NULL};
+    double worst = 0.0;
+    unsigned seed = 11;
+    for (int i = 0; i < 2000; i++) {
+        vps_geopoint_t p = {c.lat + (test_rand(&seed) - 0.5) * 0.06,
+                            c.lon + (test_rand(&seed) - 0.5) * 0.09};
+        double a = vps_geofence_distance_km(&circle, p);
+        double b = vps_geofence_poly_distance_km(&poly, p);
+        worst = fmax(worst, fabs(a - b));
+    }
+    CHECK(worst < 0.002);   /* 2 m: chord sagitta and projection */
+    vps_geofence_poly_free(&poly);
+}
+
+static void test_invalid(void) {
+    vps_geopoint_t pts[3] = {{0.0, 0.0}, {0.0, 0.01}, {0.01, 0.0}};
+    int bad[] = {2};
+    int ok[] = {3};
+    vps_geopoint_t same[3] = {{1.0, 1.0}, {1.0, 1.0}, {1.0, 1.0}};
+    vps_geofence_poly_t poly;
+    CHECK(!vps_geofence_poly_build(&poly, pts, bad, 1));
+    CHECK(!vps_geofence_poly_build(&poly, pts, ok, 0));
+    CHECK(!vps_geofence_poly_build(&poly, same, ok, 1));
+    CHECK(vps_geofence_poly_build(&poly, pts, ok, 1));
+    CHECK(vps_geofence_poly_contains(&poly, (vps_geopoint_t){0.002, 0.002}, 0.0));
+    vps_geofence_poly_free(&poly);
+}
+
+int main(void) {
+    test_square_with_hole();
+    test_against_brute_force();
+    test_degenerate_alignment();
+    test_circle_polygon();
+    test_invalid();
+    return test_report("test_geofence_poly");
+}
@@ -0,0 +1,125 @@
+/**
+ * @file test_global_pixel.c
+ * @brief z24 global pixels against the floating tile/pixel conversions.
+ */
+#include "geo_transform.h"
+#include "global_pixel.h"
+#include "test_common.h"
+#include "tile_math.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static vps_geopoint_t random_point(unsigned *seed) {
+    return (vps_geopoint_t){(2.0 * test_rand(seed) - 1.0) * 84.0,
+                            (2.0 * test_rand(seed) - 1.0) * 180.0};
+}
+
+static void test_round_trip(void) {
+    unsigned seed = 1;
+    for (int i = 0; i < 20000; i++) {
+        vps_geopoint_t p = random_point(&seed);
+        vps_gpx_t g = vps_gpx_from_gps(p);
+        CHECK(g.x >= 0 && g.x < ((int64_t)1 << 32) && g.y >= 0 && g.y < ((int64_t)1 << 32));
+        vps_geopoint_t q = vps_gpx_to_gps(g);
+        CHECK(vps_haversine_km(p, q) * 1e6 < 5.0);   /* mm */
+        /* Same tile and pixel as the floating conversion, at every zoom */
+        for (int z = 0; z <= VPS_GPX_ZOOM; z += 3) {
+            vps_tile_coord_t t;
+            vps_pixel_t px;
+            vps_gps_to_tile_pixel(p, z, &t, &px);
+            vps_tile_coord_t u = vps_gpx_tile(g, z);
+            vps_pixel_t upx = vps_gpx_tile_pixel(g, z);
+            double err = ldexp(1.0, z - VPS_GPX_ZOOM);   /* half a z24 pixel, plus rounding */
+            if (u.x != t.x || u.y != t.y) {             /* on a tile edge */
+                CHECK(fmin(fmin(px.x, 256.0 - px.x), fmin(px.y, 256.0 - px.y)) < err);
+                continue;
+            }
+            CHECK(u.z == z);
+            CHECK_NEAR(upx.x, px.x, err);
+            CHECK_NEAR(upx.y, px.y, err);
+            vps_gpx_t gz = vps_gpx_at_zoom(g, z);
+            CHECK(gz.x >> 8 == u.x && gz.y >> 8 == u.y && (gz.x & 255) == (int64_t)upx.x);
+            /* and back from the tile */
+            vps_gpx_t h = vps_gpx_from_tile_pixel(u, upx);
+            CHECK(h.x == g.x && h.y == g.y);
+        }
+    }
+    /* Poles clamp, longitudes wrap */
+    vps_gpx_t n = vps_gpx_from_gps((vps_geopoint_t){89.0, 0.0});
+    vps_gpx_t s = vps_gpx_from_gps((vps_geopoint_t){-89.0, 0.0});
+    CHECK(n.y == 0 && s.y == ((int64_t)1 << 32) - 1);
+    CHECK(vps_gpx_from_gps((vps_geopoint_t){10.0, 180.0}).x == 0);
+    CHECK(vps_gpx_from_gps((vps_geopoint_t){10.0, -180.0}).x == 0);
+}
+
+static void test_neighbors(void) {
+    vps_tile_coord_t out[64];
+    vps_gpx_t g = vps_gpx_from_gps((vps_geopoint_t){47.3977, 8.5456});
+    vps_tile_coord_t c = vps_gpx_tile(g, 17);
+    CHECK(vps_gpx_neighbors(g, 17, 1, out, 64) == 9);
+    CHECK(out[4].x == c.x && out[4].y == c.y);
+    CHECK(out[0].x == c.x - 1 && out[0].y == c.y - 1 && out[8].x == c.x + 1);
+    CHECK(vps_gpx_neighbors(g, 17, 2, out, 10) == 10);
+
+    /* Antimeridian wraps, top row drops */
+    vps_gpx_t corner = {((int64_t)1 << 32) - 1, 0};
+    int k = vps_gpx_neighbors(corner, 4, 1, out, 64);
+    CHECK(k == 6);
+    CHECK(out[0].x == 14 && out[1].x == 15 && out[2].x == 0 && out[0].y == 0);
+    /* Ring wider than the world: each column once */
+    CHECK(vps_gpx_neighbors(corner, 1, 3, out, 64) == 4);
+}
+
+static void test_delta_distance(void) {
+    vps_gpx_t a = vps_gpx_from_gps((vps_geopoint_t){0.0, 179.9999});
+    vps_gpx_t b = vps_gpx_from_gps((vps_geopoint_t){0.0, -179.9999});
+    vps_gpx_t d = vps_gpx_delta(a, b);
+    CHECK(d.x > 0 && d.x < 50000 && d.y == 0);
+    CHECK(vps_gpx_delta(b, a).x == -d.x);
+
+    static const double lats[] = {0.0, -33.9, 47.4, 60.1, 75.0};
+    unsigned seed = 4;
+    for (int i = 0; i < 5; i++) {
+        vps_geopoint_t home = {lats[i], 24.9};
+        vps_gpx_scale_t s;
+        vps_gpx_scale_init(&s, vps_gpx_from_gps(home));
+        double worst = 0.0;
+        for (int k = 0; k < 5000; k++) {
+            /* Points within 30 km of home, up to 10 km apart */
+            double n = (test_rand(&seed) - 0.5) * 60.0, e = (test_rand(&seed) - 0.5) * 60.0;
+            double clat = cos(home.lat * M_PI / 180.0);
+            vps_geopoint_t p = {home.lat + n / 111.195, home.lon + e / (111.195 * clat)};
+            vps_geopoint_t q = {p.lat + (test_rand(&seed) - 0.5) * 0.09,
+                                p.lon + (test_rand(&seed) - 0.5) * 0.09 / clat};
+            vps_gpx_t gp = vps_gpx_from_gps(p), gq = vps_gpx_from_gps(q);
+            int64_t mm;
+            CHECK(vps_gpx_distance_mm(&s, gp, gq, &mm));
+            CHECK(vps_gpx_within_mm(&s, gp, gq, mm + 1));
+            CHECK(mm < 2 || !vps_gpx_within_mm(&s, gp, gq, mm - 2));
+            /* Reference: pixel length at the mid latitude, as the float path */
+            vps_gpx_t dd = vps_gpx_delta(gp, gq);
+            double mid = vps_gpx_to_gps((vps_gpx_t){gp.x, (gp.y + gq.y) / 2}).lat;
+            double ref = vps_pixel_distance_to_meters((double)dd.x, (double)dd.y, mid, 24) * 1e3;
+            worst = fmax(worst, fabs(mm - ref) / fmax(ref, 1.0));
+            CHECK(fabs(mm - ref) <= 1e-5 * ref + 1.0);
+            /* and the great circle on the same sphere */
+            double hav = vps_haversine_km(p, q) * 1e6 * 6378137.0 / 6371000.0;
+            CHECK(fabs(mm - hav) <= 2e-4 * hav + 20.0);
+        }
+        CHECK(worst < 1e-5);
+        int64_t mm;
+        vps_gpx_t far = {s.y0, s.y0 + 2 * VPS_GPX_NEAR_PX};
+        CHECK(!vps_gpx_distance_mm(&s, (vps_gpx_t){0, s.y0}, far, &mm));
+        CHECK(!vps_gpx_within_mm(&s, (vps_gpx_t){0, s.y0}, far, INT64_MAX));
+        CHECK(vps_gpx_within_mm(&s, (vps_gpx_t){0, s.y0}, (vps_gpx_t){1000, s.y0}, INT64_MAX));
+    }
+}
+
+int main(void) {
+    test_round_trip();
+    test_neighbors();
+    test_delta_distance();
+    return test_report("test_global_pixel");
+}
@@ -0,0 +1,154 @@
+/**
+ * @file test_imm.c
+ * @brief IMM filter: reduction to one EKF, model selection, fusion output.
+ */
+#include "imm.h"
+#include "fusion.h"
+#include "test_common.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Identical models mix to themselves: the IMM is the single EKF */
+static void test_identical_models_match_ekf(void) {
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+    vps_imm_config_t icfg = vps_imm_default_config();
+    for (int j = 0; j < VPS_IMM_MODELS; j++) {
+        icfg.q_scale[j] = 1.0;
+        icfg.tau_s[j] = 0.0;
+    }
+    vps_imm_t m;
+    vps_imm_init(&m, &icfg);
+    vps_ekf_state_t ref, s;
+    vps_ekf_init(&ref);
+
+    unsigned seed = 3;
+    for (int k = 0; k < 300; k++) {
+        double t = k / 3.0;
+        vps_geopoint_t z = {52.0 + 1e-5 * t + 2e-5 * test_rand_gauss(&seed),
+                            13.0 + 2e-5 * test_rand_gauss(&seed)};
+        if (k % 50 == 49) z.lat += 0.01;
+        bool a = vps_ekf_update(&ref, &cfg, z, 1.0, t);
+        bool b = vps_imm_update(&m, &cfg, z, 1.0, t);
+        CHECK(a == b);
+    }
+    vps_imm_to_state(&m, &s);
+    double v = fabs(ref.x[2]) + fabs(ref.x[3]);  /* mixing weights sum to 1 ± ulp */
+    for (int i = 0; i < 2; i++) CHECK_NEAR(s.x[i], ref.x[i], 1e-12 * fabs(ref.x[i]));
+    for (int i = 2; i < 4; i++) CHECK_NEAR(s.x[i], ref.x[i], 1e-8 * v);
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++) CHECK_NEAR(s.P[i][j], ref.P[i][j], 1e-9 * ref.P[i][i]);
+    for (int j = 0; j < VPS_IMM_MODELS; j++) CHECK_NEAR(m.mu[j], 1.0 / VPS_IMM_MODELS, 1e-9);
+}
+
+/* Hover, then cruise north at 15 m/s, then a tight turn: each phase
+ * moves the probability to its model. */
+static void test_model_selection(void) {
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+    vps_imm_t m;
+    vps_imm_init(&m, NULL);
+    vps_ekf_state_t cv;
+    vps_ekf_init(&cv);
+
+    unsigned seed = 7;
+    double n = 0.0, e = 0.0, vn = 0.0, ve = 0.0, t = 0.0;
+    int imm_turn = 0, cv_turn = 0, turn_fixes = 0;
+    double hover_mu = 0, cruise_mu = 0, turn_mu = 0;
+    for (int k = 0; k < 3 * 90; k++) {
+        t = k / 3.0;
+        if (t >= 30.0 && t < 60.0) {        /* cruise */
+            vn = 15.0;
+            ve = 0.0;
+        } else if (t >= 60.0) {             /* 15 m/s on a 25 m radius */
+            double w = 15.0 / 25.0, th = w * (t - 60.0);
+            vn = 15.0 * cos(th);
+            ve = 15.0 * sin(th);
+        }
+        n += vn / 3.0;
+        e += ve / 3.0;
+        vps_geopoint_t z = {47.0 + (n + 1.0 * test_rand_gauss(&seed)) / 111320.0,
+                            8.0 + (e + 1.0 * test_rand_gauss(&seed)) / 111320.0};
+        bool a = vps_imm_update(&m, &cfg, z, 0.3, t);
+        bool b = vps_ekf_update(&cv, &cfg, z, 0.3, t);
+        if (t >= 60.0) {
+            turn_fixes++;
+            imm_turn += a;
+            cv_turn += b;
+        }
+        if (k == 3 * 30 - 1) hover_mu = m.mu[VPS_IMM_HOVER];
+        if (k == 3 * 60 - 1) cruise_mu = m.mu[VPS_IMM_CRUISE];
+    }
+    turn_mu = m.mu[VPS_IMM_TURN];
+    printf("imm: hover %.3f, cruise %.3f, turn %.3f; turn fixes accepted imm %d/%d, cv %d/%d\n",
+           hover_mu, cruise_mu, turn_mu, imm_turn, turn_fixes, cv_turn, turn_fixes);
+    CHECK(hover_mu > 0.5);
+    CHECK(cruise_mu > 0.5);
+    CHECK(turn_mu > 0.5);
+    CHECK(imm_turn == turn_fixes);
+    CHECK(cv_turn < turn_fixes);
+}
+
+static void test_outlier_and_gap(void) {
+    vps_ekf_config_t cfg = vps_ekf_default_config();
+    vps_imm_t m;
+    vps_imm_init(&m, NULL);
+    for (int k = 0; k < 10; k++)
+        CHECK(vps_imm_update(&m, &cfg, (vps_geopoint_t){10.0, 20.0}, 1.0, k));
+    double mu[VPS_IMM_MODELS];
+    for (int j = 0; j < VPS_IMM_MODELS; j++) mu[j] = m.mu[j];
+
+    CHECK(!vps_imm_update(&m, &cfg, (vps_geopoint_t){10.5, 20.0}, 1.0, 10.0));
+    CHECK(m.last_gate > cfg.gate_threshold);
+    CHECK(m.last_t == 10.0);
+    double sum = 0;
+    for (int j = 0; j < VPS_IMM_MODELS; j++) sum += m.mu[j];
+    CHECK_NEAR(sum, 1.0, 1e-12);
+    CHECK(m.mu[VPS_IMM_HOVER] <= mu[VPS_IMM_HOVER]);   /* only the transition prior */
+
+    CHECK(!vps_imm_update(&m, &cfg, (vps_geopoint_t){10.0, 20.0}, 1.0, 9.0));  /* stale */
+    CHECK(vps_imm_update(&m, &cfg, (vps_geopoint_t){11.0, 21.0}, 1.0, 100.0)); /* gap */
+    vps_ekf_state_t s;
+    vps_imm_to_state(&m, &s);
+    CHECK(s.x[0] == 11.0 && s.x[1] == 21.0 && s.x[2] == 0.0);
+    CHECK_NEAR(m.mu[VPS_IMM_CRUISE], 1.0 / VPS_IMM_MODELS, 1e-12);
+}
+
+static void test_fusion_output(void) {
+    vps_fusion_t f;
+    vps_fusion_init(&f, NULL, 10.0, NULL);
+    vps_fusion_output_t out = vps_fusion_update(&f, &(vps_geopoint_t){52.0, 13.0}, 1.0, 0.0);
+    for (int j = 0; j < VPS_IMM_MODELS; j++) CHECK(out.model_prob[j] == 0.0);
+
+    vps_fusion_use_imm(&f, true);
+    CHECK(f.imm.initialized);
+    for (int i = 1; i < 20; i++)
+        out = vps_fusion_update(&f, &(vps_geopoint_t){52.0, 13.0}, 1.0, i);
+    CHECK(out.ekf_accepted && out.source == VPS_SOURCE_VISUAL);
+    double sum = 0;
+    for (int j = 0; j < VPS_IMM_MODELS; j++) sum += out.model_prob[j];
+    CHECK_NEAR(sum, 1.0, 1e-9);
+    CHECK(out.model_prob[VPS_IMM_HOVER] > out.model_prob[VPS_IMM_TURN]);
+
+    /* Predictions and delayed fixes carry the probabilities too */
+    out = vps_fusion_update(&f, NULL, 1.0, 19.5);
+    CHECK(out.source == VPS_SOURCE_EKF_PREDICT);
+    CHECK_NEAR(out.model_prob[VPS_IMM_HOVER], f.imm.mu[VPS_IMM_HOVER], 0.0);
+    out = vps_fusion_update_delayed(&f, &(vps_geopoint_t){52.0, 13.0}, 1.0, 19.8, 20.0);
+    CHECK(out.ekf_accepted && f.imm.last_t == 20.0);
+    CHECK_NEAR(vps_ekf_position(&f.ekf).lat, 52.0, 1e-9);
+
+    vps_fusion_reset(&f);
+    CHECK(!f.imm.initialized);
+    vps_fusion_use_imm(&f, false);
+    out = vps_fusion_update(&f, &(vps_geopoint_t){52.0, 13.0}, 1.0, 30.0);
+    CHECK(out.model_prob[VPS_IMM_CRUISE] == 0.0);
+}
+
+int main(void) {
+    test_identical_models_match_ekf();
+    test_model_selection();
+    test_outlier_and_gap();
+    test_fusion_output();
+    return test_report("test_imm");
+}
@@ -0,0 +1,229 @@
+/**
+ * @file test_imu_nav.c
+ * @brief MSP telemetry parsing and IMU prediction between visual fixes.
+ */
+#include "imu_nav.h"
+#include "fusion.h"
+#include "test_common.h"
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Build a $M> reply frame; returns its size */
+static int make_reply(uint8_t *out, uint8_t cmd, const uint8_t *payload, uint8_t len) {
+    out[0] = '$';
+    out[1] = 'M';
+    out[2] = '>';
+    out[3] = len;
+    out[4] = cmd;
+    memcpy(&out[5], payload, len);
+    out[5 + len] = vps_msp_checksum(&out[3], (size_t)len + 2);
+    return 6 + len;
+}
+
+static void put_i16(uint8_t *p, int16_t v) {
+    p[0] = (uint8_t)(v & 0xff);
+    p[1] = (uint8_t)((uint16_t)v >> 8);
+}
+
+static void test_msp_request(void) {
+    uint8_t buf[MSP_REQUEST_SIZE];
+    CHECK(vps_msp_encode_request(buf, MSP_CMD_ATTITUDE) == 6);
+    CHECK(buf[0] == '$' && buf[1] == 'M' && buf[2] == '<');
+    CHECK(buf[3] == 0 && buf[4] == MSP_CMD_ATTITUDE);
+    CHECK(buf[5] == (0 ^ MSP_CMD_ATTITUDE));
+}
+
+static void test_msp_parse(void) {
+    uint8_t payload[MSP_RAW_IMU_PAYLOAD] = {0};
+    put_i16(&payload[0], 100);
+    put_i16(&payload[2], -200);
+    put_i16(&payload[4], 512);
+    put_i16(&payload[6], -7);
+    uint8_t frame[64];
+    int n = make_reply(frame, MSP_CMD_RAW_IMU, payload, sizeof(payload));
+
+    vps_msp_parser_t p;
+    vps_msp_parser_init(&p);
+    int done = 0;
+    vps_msp_parse_byte(&p, 0x55);  /* noise before the frame */
+    for (int i = 0; i < n; i++) done += vps_msp_parse_byte(&p, frame[i]);
+    CHECK(done == 1);
+    CHECK(p.cmd == MSP_CMD_RAW_IMU && p.len == MSP_RAW_IMU_PAYLOAD);
+
+    vps_msp_raw_imu_t raw;
+    CHECK(vps_msp_decode_raw_imu(p.payload, p.len, &raw));
+    CHECK(raw.acc[0] == 100 && raw.acc[1] == -200 && raw.acc[2] == 512);
+    CHECK(raw.gyro[0] == -7);
+    CHECK(!vps_msp_decode_raw_imu(p.payload, 4, &raw));
+
+    /* Corrupted checksum is counted and not reported */
+    frame[n - 1] ^= 0xff;
+    done = 0;
+    for (int i = 0; i < n; i++) done += vps_msp_parse_byte(&p, frame[i]);
+    CHECK(done == 0);
+    CHECK(p.errors == 1 && p.frames == 1);
+
+    uint8_t att[MSP_ATTITUDE_PAYLOAD];
+    put_i16(&att[0], -150);
+    put_i16(&att[2], 25);
+    put_i16(&att[4], 270);
+    n = make_reply(frame, MSP_CMD_ATTITUDE, att, sizeof(att));
+    done = 0;
+    for (int i = 0; i < n; i++) done += vps_msp_parse_byte(&p, frame[i]);
+    CHECK(done == 1);
+    vps_msp_attitude_t a;
+    CHECK(vps_msp_decode_attitude(p.payload, p.len, &a));
+    CHECK(a.roll_deg10 == -150 && a.pitch_deg10 == 25 && a.yaw_deg == 270);
+}
+
+static vps_ekf_state_t anchored_ekf(double lat, double lon, double vlat, double t) {
+    vps_ekf_state_t s;
+    vps_ekf_init(&s);
+    s.x[0] = lat;
+    s.x[1] = lon;
+    s.x[2] = vlat;
+    s.x[3] = 0.0;
+    s.last_t = t;
+    s.initialized = true;
+    return s;
+}
+
+static void test_constant_accel(void) {
+    vps_imu_nav_t nav;
+    vps_imu_nav_init(&nav, NULL);
+    vps_imu_nav_attitude(&nav, &(vps_attitude_t){0.0, 0.0f, 0.0f, (float)(M_PI / 2)});
+    vps_ekf_state_t s = anchored_ekf(0.0, 0.0, 0.0, 0.0);
+    vps_imu_nav_anchor(&nav, &s, 1.0);
+
+    /* Yaw 90°: body-forward 2 m/s² is due east */
+    for (int i = 1; i <= 400; i++)
+        vps_imu_nav_push(&nav, &(vps_imu_sample_t){i * 0.005, 2.0f, 0.0f, (float)-VPS_GRAVITY});
+
+    vps_geopoint_t pos;
+    vps_velocity_t vel;
+    double hdop;
+    CHECK(vps_imu_nav_position(&nav, 2.0, &pos, &vel, &hdop));
+    /* The first 5 ms is unaccelerated (held zero before the first sample) */
+    double t_acc = 2.0 - 0.005;
+    CHECK_NEAR(vel.ve, 2.0 * t_acc, 1e-4);
+    CHECK_NEAR(vel.vn, 0.0, 1e-5);
+    CHECK_NEAR(pos.lon * 111320.0, t_acc * t_acc, 1e-3);
+    CHECK_NEAR(pos.lat, 0.0, 1e-10);
+    CHECK_NEAR(hdop, 2.0, 1e-9);
+}
+
+static void test_level_at_rest(void) {
+    vps_imu_nav_t nav;
+    vps_imu_nav_init(&nav, NULL);
+    /* Nose up 10°: gravity shows on x, but the NED horizontal stays zero */
+    vps_msp_attitude_t att = {0, 100, 45};
+    vps_attitude_t a = vps_attitude_from_msp(&att, 0.0);
+    vps_imu_nav_attitude(&nav, &a);
+    vps_ekf_state_t s = anchored_ekf(52.0, 13.0, 0.0, 0.0);
+    vps_imu_nav_anchor(&nav, &s, 1.0);
+
+    double th = 10.0 * M_PI / 180.0;
+    vps_msp_raw_imu_t raw = {{0}, {0}, {0}};
+    raw.acc[0] = (int16_t)lround(MSP_ACC_1G * sin(th));    /* FC x forward */
+    raw.acc[2] = (int16_t)lround(MSP_ACC_1G * cos(th));    /* FC z up */
+    for (int i = 1; i <= 1000; i++) {
+        vps_imu_sample_t smp = vps_imu_from_msp(&raw, i * 0.002);
+        vps_imu_nav_push(&nav, &smp);
+    }
+    vps_geopoint_t pos;
+    double hdop;
+    CHECK(vps_imu_nav_position(&nav, 2.0, &pos, NULL, &hdop));
+    /* Only 1/512 g quantization residue remains */
+    CHECK(fabs(pos.lat - 52.0) * 111320.0 < 0.05);
+    CHECK(fabs(pos.lon - 13.0) * 111320.0 < 0.05);
+}
+
+static void test_anchor_replays(void) {
+    vps_imu_nav_t nav;
+    vps_imu_nav_init(&nav, NULL);
+    vps_imu_nav_attitude(&nav, &(vps_attitude_t){0.0, 0.0f, 0.0f, 0.0f});
+    for (int i = 0; i < 200; i++)
+        vps_imu_nav_push(&nav, &(vps_imu_sample_t){i * 0.01, 1.0f, 0.0f, (float)-VPS_GRAVITY});
+
+    vps_geopoint_t pos;
+    double hdop;
+    CHECK(!vps_imu_nav_position(&nav, 2.0, &pos, NULL, &hdop));  /* not anchored */
+
+    /* Fix captured at t=1 with 3 m/s north: replay the second second */
+    vps_ekf_state_t s = anchored_ekf(10.0, 20.0, 3.0 / 111320.0, 1.0);
+    vps_imu_nav_anchor(&nav, &s, 1.5);
+    vps_velocity_t vel;
+    CHECK(vps_imu_nav_position(&nav, 1.99, &pos, &vel, &hdop));
+    CHECK_NEAR(vel.vn, 3.0 + 0.99, 1e-4);
+    CHECK_NEAR((pos.lat - 10.0) * 111320.0, 3.0 * 0.99 + 0.5 * 0.99 * 0.99, 1e-3);
+    CHECK_NEAR(hdop, 1.5 + 0.5 * 0.99, 1e-9);
+
+    /* Stale */
+    CHECK(!vps_imu_nav_position(&nav, 12.0, &pos, NULL, &hdop));
+}
+
+static void test_fusion_uses_imu(void) {
+    vps_fusion_t f;
+    vps_fusion_init(&f, NULL, 10.0, NULL);
+    vps_imu_nav_t nav;
+    vps_imu_nav_init(&nav, NULL);
+    vps_fusion_attach_imu(&f, &nav);
+    vps_imu_nav_attitude(&nav, &(vps_attitude_t){0.0, 0.0f, 0.0f, 0.0f});
+
+    /* Stationary visual fixes, then the vehicle accelerates north */
+    for (int i = 0; i < 5; i++)
+        vps_fusion_update(&f, &(vps_geopoint_t){52.0, 13.0}, 1.0, i);
+    double t = 4.0;
+    for (int i = 1; i <= 400; i++) {
+        t = 4.0 + i * 0.005;
+        vps_imu_nav_push(&nav, &(vps_imu_sample_t){t, 4.0f, 0.0f, (float)-VPS_GRAVITY});
+    }
+
+    vps_fusion_output_t out = vps_fusion_update(&f, NULL, 1.0, t);
+    CHECK(out.has_position && out.source == VPS_SOURCE_EKF_PREDICT);
+    CHECK((out.position.lat - 52.0) * 111320.0 > 7.0);   /* ~8 m from 0.5·4·2² */
+    CHECK(out.speed_mps > 7.5 && out.speed_mps < 8.5);
+    CHECK(out.heading_deg < 1.0 || out.heading_deg > 359.0);
+
+    /* Without the IMU the EKF keeps predicting the stationary track */
+    vps_fusion_attach_imu(&f, NULL);
+    out = vps_fusion_update(&f, NULL, 1.0, t);
+    CHECK(fabs(out.position.lat - 52.0) * 111320.0 < 0.5);
+}
+
+static void test_feed_msp(void) {
+    vps_imu_nav_t nav;
+    vps_imu_nav_init(&nav, NULL);
+    vps_msp_parser_t p;
+    vps_msp_parser_init(&p);
+    uint8_t frame[64], payload[MSP_RAW_IMU_PAYLOAD] = {0};
+    put_i16(&payload[4], MSP_ACC_1G);
+    int n = make_reply(frame, MSP_CMD_RAW_IMU, payload, sizeof(payload));
+    for (int i = 0; i < n; i++)
+        if (vps_msp_parse_byte(&p, frame[i])) CHECK(vps_imu_nav_feed_msp(&nav, &p, 0.1));
+    CHECK(nav.samples == 0);  /* no attitude yet */
+
+    uint8_t att[MSP_ATTITUDE_PAYLOAD] = {0};
+    n = make_reply(frame, MSP_CMD_ATTITUDE, att, sizeof(att));
+    for (int i = 0; i < n; i++)
+        if (vps_msp_parse_byte(&p, frame[i])) CHECK(vps_imu_nav_feed_msp(&nav, &p, 0.2));
+    CHECK(nav.has_attitude);
+    n = make_reply(frame, MSP_CMD_RAW_IMU, payload, sizeof(payload));
+    for (int i = 0; i < n; i++)
+        if (vps_msp_parse_byte(&p, frame[i])) CHECK(vps_imu_nav_feed_msp(&nav, &p, 0.3));
+    CHECK(nav.samples == 1);
+}
+
+int main(void) {
+    test_msp_request();
+    test_msp_parse();
+    test_constant_accel();
+    test_level_at_rest();
+    test_anchor_replays();
+    test_fusion_uses_imu();
+    test_feed_msp();
+    return test_report("test_imu_nav");
+}
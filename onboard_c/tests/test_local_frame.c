@@ -0,0 +1,187 @@
+/**
+ * @file test_local_frame.c
+ * @brief Local frame against haversine/cos, and the frame-based fence, DR,
+ *        speed/heading and pixel-distance paths against their originals.
+ */
+#include "dead_reckoning.h"
+#include "ekf.h"
+#include "fusion.h"
+#include "geo_transform.h"
+#include "geofence.h"
+#include "local_frame.h"
+#include "test_common.h"
+#include "tile_math.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Uniform point in the frame's box */
+static vps_geopoint_t in_box(const vps_local_frame_t *f, unsigned *seed) {
+    vps_geopoint_t p = {f->origin.lat + (2.0 * test_rand(seed) - 1.0) * f->max_lat_off,
+                        f->origin.lon + (2.0 * test_rand(seed) - 1.0) * f->max_lon_off};
+    return p;
+}
+
+static void test_init(void) {
+    vps_local_frame_t f;
+    CHECK(!vps_local_frame_init(&f, (vps_geopoint_t){47.0, 8.0}, 0.0));
+    CHECK(!vps_local_frame_init(&f, (vps_geopoint_t){47.0, 8.0}, VPS_LOCAL_FRAME_MAX_KM + 1));
+    CHECK(!vps_local_frame_init(&f, (vps_geopoint_t){79.0, 8.0}, 200.0));
+    CHECK(vps_local_frame_init(&f, (vps_geopoint_t){-33.9, 151.2}, 50.0));
+    CHECK_NEAR(f.m_per_deg_lon, f.m_per_deg_lat * cos(-33.9 * M_PI / 180.0), 1e-9);
+    CHECK(f.max_err_m <= 0.01);
+    CHECK(vps_local_frame_covers(&f, f.origin));
+    CHECK(!vps_local_frame_covers(&f, (vps_geopoint_t){-33.9, 152.0}));
+    CHECK(!vps_local_frame_covers(&f, (vps_geopoint_t){-34.5, 151.2}));
+}
+
+static void test_distance(void) {
+    static const double lats[] = {0.0, -33.9, 47.4, 68.0, 75.4};
+    static const double radii[] = {5.0, 50.0, 500.0};
+    unsigned seed = 1;
+    for (int i = 0; i < 5; i++)
+        for (int j = 0; j < 3; j++) {
+            vps_local_frame_t f;
+            if (!vps_local_frame_init(&f, (vps_geopoint_t){lats[i], 179.9}, radii[j])) {
+                CHECK(lats[i] + radii[j] / 111.195 > VPS_LOCAL_FRAME_MAX_LAT);
+                continue;
+            }
+            double worst = 0.0, worst_cos = 0.0;
+            for (int k = 0; k < 20000; k++) {
+                vps_geopoint_t a = in_box(&f, &seed), b = in_box(&f, &seed);
+                worst = fmax(worst, fabs(vps_local_frame_distance_m(&f, a, b) -
+                                         vps_haversine_km(a, b) * 1000.0));
+                worst_cos = fmax(worst_cos, fabs(vps_local_frame_cos_lat(&f, a.lat) -
+                                                 cos(a.lat * M_PI / 180.0)));
+                double e, n;
+                vps_local_frame_to_enu(&f, a, &e, &n);
+                vps_geopoint_t back = vps_local_frame_from_enu(&f, e, n);
+                CHECK_NEAR(back.lat, a.lat, 1e-10);
+                CHECK_NEAR(back.lon, a.lon, 1e-10);
+            }
+            CHECK(worst <= f.max_err_m);
+            CHECK(f.max_err_m < 1e-3);
+            CHECK(worst_cos < 1e-11);
+        }
+}
+
+static void test_heading(void) {
+    CHECK(vps_heading_deg(0.0, 0.0) == 0.0);
+    CHECK_NEAR(vps_heading_deg(1.0, 0.0), 0.0, 1e-9);
+    CHECK_NEAR(vps_heading_deg(0.0, 1.0), 90.0, 1e-9);
+    CHECK_NEAR(vps_heading_deg(-1.0, 0.0), 180.0, 1e-9);
+    CHECK_NEAR(vps_heading_deg(0.0, -1.0), 270.0, 1e-9);
+    for (int i = 0; i < 3600; i++) {
+        double a = (i + 0.37) * M_PI / 1800.0, r = 0.1 + i % 13;
+        double h = vps_heading_deg(r * cos(a), r * sin(a));
+        CHECK(h >= 0.0 && h < 360.0);
+        double ref = fmod(atan2(r * sin(a), r * cos(a)) * 180.0 / M_PI + 360.0, 360.0);
+        CHECK_NEAR(h, ref, 2e-6);
+    }
+}
+
+static void test_geofence(void) {
+    vps_geopoint_t home = {47.3977, 8.5456};
+    vps_local_frame_t f;
+    CHECK(vps_local_frame_init(&f, home, 30.0));
+    vps_geofence_t fences[] = {
+        {VPS_FENCE_CIRCLE, {47.41, 8.53}, 5.0, 0.1, 0.0, 0.0, NULL},
+        {VPS_FENCE_RECT, {47.38, 8.56}, 0.0, 0.2, 3.0, 4.0, NULL},
+    };
+    unsigned seed = 7;
+    for (int k = 0; k < 2; k++)
+        for (int i = 0; i < 20000; i++) {
+            vps_geopoint_t p = {home.lat + (test_rand(&seed) - 0.5) * 0.2,
+                                home.lon + (test_rand(&seed) - 0.5) * 0.3};
+            double d = vps_geofence_distance_km(&fences[k], p);
+            CHECK_NEAR(vps_geofence_distance_km_local(&fences[k], &f, p), d,
+                       f.max_err_m * 1e-3);
+            if (fabs(d - fences[k].margin_km) > 1e-5)
+                CHECK(vps_geofence_contains_local(&fences[k], &f, p) ==
+                      vps_geofence_contains(&fences[k], p));
+        }
+    /* Outside the box: haversine fallback */
+    vps_geofence_t far = {VPS_FENCE_CIRCLE, {48.5, 8.5}, 5.0, 0.0, 0.0, 0.0, NULL};
+    vps_geopoint_t q = {48.52, 8.51};
+    CHECK(vps_geofence_distance_km_local(&far, &f, q) == vps_geofence_distance_km(&far, q));
+}
+
+static void test_dr_speed_pixels(void) {
+    vps_geopoint_t home = {60.1, 24.9};
+    vps_local_frame_t f;
+    CHECK(vps_local_frame_init(&f, home, 20.0));
+
+    vps_dr_state_t a, b;
+    vps_dr_init(&a, 10.0, 2.0);
+    vps_dr_init(&b, 10.0, 2.0);
+    vps_dr_set_frame(&b, &f);
+    vps_dr_update_ref(&a, home, 12.0, -7.0, 1.0, 0.0);
+    vps_dr_update_ref(&b, home, 12.0, -7.0, 1.0, 0.0);
+    CHECK(vps_dr_apply_odometry(&b, 30.0, 40.0, 0.1, 2.0));
+    CHECK(vps_dr_apply_odometry(&a, 30.0, 40.0, 0.1, 2.0));
+    vps_geopoint_t pa, pb;
+    double ha, hb;
+    CHECK(vps_dr_extrapolate(&a, 7.0, &pa, &ha));
+    CHECK(vps_dr_extrapolate(&b, 7.0, &pb, &hb));
+    CHECK(ha == hb);
+    /* Displacement differs only by the 111195 vs 111320 m/deg scale */
+    CHECK_NEAR(vps_local_frame_distance_m(&f, home, pb), 50.0 + 5.0 * 25.0, 1e-3);
+    CHECK_NEAR(vps_haversine_km(pa, pb) * 1000.0, 175.0 * (1.0 - 111195.08 / 111320.0), 0.01);
+
+    vps_ekf_state_t ekf;
+    vps_ekf_init(&ekf);
+    CHECK(vps_ekf_speed_local(&ekf, &f) == 0.0);
+    ekf.initialized = true;
+    ekf.x[0] = 60.15;
+    ekf.x[1] = 24.95;
+    ekf.x[2] = 8.0 / 111320.0;
+    ekf.x[3] = 6.0 / (111320.0 * cos(60.15 * M_PI / 180.0));
+    CHECK_NEAR(vps_ekf_speed(&ekf), 10.0, 1e-9);
+    CHECK_NEAR(vps_ekf_speed_local(&ekf, &f), 10.0 * 111195.08 / 111320.0, 1e-4);
+
+    for (int z = 10; z <= 20; z++) {
+        double ref = vps_pixel_distance_to_meters(3.0, 4.0, 60.12, z);
+        CHECK_NEAR(vps_pixel_distance_to_meters_local(&f, 3.0, 4.0, 60.12, z), ref, ref * 1e-10);
+    }
+}
+
+static void test_fusion(void) {
+    vps_geopoint_t home = {47.3977, 8.5456};
+    vps_local_frame_t frame;
+    CHECK(vps_local_frame_init(&frame, home, 30.0));
+    vps_geofence_t fence = {VPS_FENCE_CIRCLE, home, 0.2, 0.0, 0.0, 0.0, NULL};
+    vps_fusion_t a, b;
+    vps_fusion_init(&a, NULL, 10.0, &fence);
+    vps_fusion_init(&b, NULL, 10.0, &fence);
+    vps_fusion_set_frame(&b, &frame);
+    double t = 0.0;
+    for (int i = 0; i < 200; i++, t += 0.1) {
+        /* 12 m/s north-east; visual fixes stop after 10 s */
+        vps_geopoint_t p = {home.lat + 8.0 * t / 111320.0,
+                            home.lon + 9.0 * t / (111320.0 * cos(home.lat * M_PI / 180.0))};
+        const vps_geopoint_t *v = i < 100 ? &p : NULL;
+        vps_fusion_output_t oa = vps_fusion_update(&a, v, 1.0, t);
+        vps_fusion_output_t ob = vps_fusion_update(&b, v, 1.0, t);
+        CHECK(oa.source == ob.source);
+        CHECK(oa.geofence_ok == ob.geofence_ok);
+        if (oa.has_position && ob.has_position) {
+            CHECK(vps_haversine_km(oa.position, ob.position) < 0.01);
+            CHECK_NEAR(ob.speed_mps, oa.speed_mps, 0.002 * oa.speed_mps + 1e-9);
+            CHECK_NEAR(ob.heading_deg, oa.heading_deg, 1e-4);
+        }
+    }
+    CHECK(b.dr.frame == &frame);
+    vps_fusion_reset(&b);
+    CHECK(b.dr.frame == &frame);
+}
+
+int main(void) {
+    test_init();
+    test_distance();
+    test_heading();
+    test_geofence();
+    test_dr_speed_pixels();
+    test_fusion();
+    return test_report("test_local_frame");
+}
@@ -0,0 +1,206 @@
+/**
+ * @file test_output_ring.c
+ * @brief Output byte ring, stdio-free NMEA/MSP encoders and the fusion sink.
+ */
+#include "fusion.h"
+#include "msp.h"
+#include "test_common.h"
+#include <pthread.h>
+#include <string.h>
+
+static void test_ring_wrap(void) {
+    vps_out_ring_t r;
+    CHECK(vps_out_ring_init(&r, 300));
+    CHECK(r.capacity == 512);
+
+    /* Fill to 500, drain, then reserve across the end */
+    uint8_t tmp[512];
+    memset(tmp, 'x', sizeof(tmp));
+    CHECK(vps_out_ring_write(&r, tmp, 500));
+    CHECK(vps_out_ring_reserve(&r, 13) == NULL);
+    CHECK(vps_out_ring_reserve(&r, 12) != NULL);
+    CHECK(vps_out_ring_read(&r, tmp, sizeof(tmp)) == 500);
+    CHECK(vps_out_ring_used(&r) == 0);
+
+    uint8_t *w = vps_out_ring_reserve(&r, 100);
+    CHECK(w != NULL);
+    for (int i = 0; i < 100; i++) w[i] = (uint8_t)i;
+    vps_out_ring_commit(&r, 40);   /* only 40 used: 12 at the end, 28 spilled */
+    CHECK(vps_out_ring_used(&r) == 40);
+
+    const uint8_t *p;
+    CHECK(vps_out_ring_peek(&r, &p) == 12);
+    CHECK(p[0] == 0 && p[11] == 11);
+    vps_out_ring_consume(&r, 12);
+    CHECK(vps_out_ring_peek(&r, &p) == 28);
+    CHECK(p == r.buf && p[0] == 12 && p[27] == 39);
+    vps_out_ring_consume(&r, 28);
+    CHECK(vps_out_ring_peek(&r, &p) == 0);
+    CHECK(vps_out_ring_reserve(&r, VPS_OUT_RING_SPILL + 1) == NULL);
+    vps_out_ring_free(&r);
+}
+
+typedef struct {
+    vps_out_ring_t *ring;
+    size_t total;
+    size_t errors;
+} drain_t;
+
+static void *drain_main(void *arg) {
+    drain_t *d = arg;
+    size_t next = 0;
+    while (next < d->total) {
+        const uint8_t *p;
+        size_t n = vps_out_ring_peek(d->ring, &p);
+        for (size_t i = 0; i < n; i++, next++)
+            if (p[i] != (uint8_t)(next * 7)) d->errors++;
+        vps_out_ring_consume(d->ring, n);
+    }
+    return NULL;
+}
+
+/* Reservations of varying size from one thread, drained by another */
+static void test_ring_threaded(void) {
+    vps_out_ring_t r;
+    CHECK(vps_out_ring_init(&r, 1024));
+    drain_t d = {&r, 2000000, 0};
+    pthread_t tid;
+    CHECK(pthread_create(&tid, NULL, drain_main, &d) == 0);
+    size_t sent = 0;
+    unsigned seed = 3;
+    while (sent < d.total) {
+        size_t n = 1 + (size_t)(test_rand(&seed) * 200);
+        if (n > d.total - sent) n = d.total - sent;
+        uint8_t *w;
+        while (!(w = vps_out_ring_reserve(&r, n))) {}
+        for (size_t i = 0; i < n; i++) w[i] = (uint8_t)((sent + i) * 7);
+        vps_out_ring_commit(&r, n);
+        sent += n;
+    }
+    pthread_join(tid, NULL);
+    CHECK(d.errors == 0);
+    vps_out_ring_free(&r);
+}
+
+/* The in-place encoders produce the snprintf sentences byte for byte */
+static void test_nmea_matches_stdio(void) {
+    static const double ties[] = {0.05, 0.15, 0.25, 0.35, 0.45, 1.25, 2.75, 0.0, 9.95, 99.95};
+    unsigned seed = 11;
+    int mismatches = 0;
+    for (int i = 0; i < 20000; i++) {
+        vps_geopoint_t pos = {180.0 * test_rand(&seed) - 90.0, 360.0 * test_rand(&seed) - 180.0};
+        if (i % 7 == 0) pos.lat = (int)pos.lat + 0.5 / 60.0;  /* exact minutes */
+        double hdop = i % 3 ? 20.0 * test_rand(&seed) : ties[i % 10];
+        double speed = i % 5 ? 80.0 * test_rand(&seed) : ties[(i / 5) % 10];
+        double heading = 360.0 * test_rand(&seed);
+        char a[128], b[VPS_NMEA_SENTENCE_MAX];
+        vps_nmea_time_t utc;
+        utc.sec = -1;
+        int na, nb;
+        size_t nw;
+        do {
+            vps_nmea_time_set(&utc, time(NULL));
+            na = vps_format_gga(a, sizeof(a), pos, i & 1, hdop, 0.0);
+            nw = vps_nmea_write_gga(b, &utc, pos, i & 1, hdop, 0.0);
+        } while (time(NULL) != utc.sec);
+        if ((size_t)na != nw || memcmp(a, b, nw) != 0) mismatches++;
+        do {
+            vps_nmea_time_set(&utc, time(NULL));
+            nb = vps_format_rmc(a, sizeof(a), pos, i & 1, speed, heading);
+            nw = vps_nmea_write_rmc(b, &utc, pos, i & 1, speed, heading);
+        } while (time(NULL) != utc.sec);
+        if ((size_t)nb != nw || memcmp(a, b, nw) != 0) mismatches++;
+    }
+    CHECK(mismatches == 0);
+
+    /* Out-of-range fields are clamped to the sentence budget */
+    vps_nmea_time_t utc;
+    utc.sec = -1;
+    vps_nmea_time_set(&utc, 0);
+    CHECK(memcmp(utc.hms, "000000", 6) == 0 && memcmp(utc.dmy, "010170", 6) == 0);
+    char b[VPS_NMEA_SENTENCE_MAX];
+    vps_geopoint_t far = {-1e300, NAN};
+    CHECK(vps_nmea_write_gga(b, &utc, far, -12345, 1e30, -1e30) <= VPS_NMEA_SENTENCE_MAX);
+    CHECK(vps_nmea_write_rmc(b, &utc, far, true, 1e30, NAN) <= VPS_NMEA_SENTENCE_MAX);
+}
+
+static void test_msp_position(void) {
+    vps_geopoint_t pos = {52.5200123, -13.4050456};
+    uint8_t a[MSP_GPS_FRAME_SIZE], b[MSP_GPS_FRAME_SIZE];
+    vps_msp_gps_t g = vps_msp_from_position(pos, 3.21, 271.5, 1.3, true);
+    CHECK(vps_msp_encode(a, &g) == MSP_GPS_FRAME_SIZE);
+    CHECK(vps_msp_encode_position(b, pos, 3.21, 271.5, 1.3, true) == MSP_GPS_FRAME_SIZE);
+    CHECK(memcmp(a, b, sizeof(a)) == 0);
+}
+
+/* Outputs reach the ring as GGA + RMC + MSP, exactly as re-encoding them */
+static void test_fusion_sink(void) {
+    vps_out_ring_t r;
+    CHECK(vps_out_ring_init(&r, 4096));
+    vps_fusion_sink_t sink;
+    vps_fusion_sink_init(&sink, &r, VPS_SINK_NMEA | VPS_SINK_MSP);
+
+    vps_fusion_t f;
+    vps_fusion_init(&f, NULL, 10.0, NULL);
+    vps_fusion_set_sink(&f, &sink);
+
+    int mismatches = 0;
+    for (int i = 0; i < 200; i++) {
+        double t = i * 0.1;
+        vps_geopoint_t z = {52.52 + 1e-5 * t, 13.405 + 2e-5 * t};
+        vps_fusion_output_t o;
+        uint8_t ref[512];
+        size_t n;
+        do {
+            time_t sec = time(NULL);
+            if (i % 10 == 9) {
+                o = vps_fusion_update_delayed(&f, &z, 1.0, t - 0.3, t);
+            } else {
+                o = vps_fusion_update(&f, i % 3 ? NULL : &z, 1.2, t);
+            }
+            char *c = (char *)ref;
+            n = (size_t)vps_format_gga(c, sizeof(ref), o.position, o.has_position ? 1 : 0,
+                                       o.hdop, 0.0);
+            n += (size_t)vps_format_rmc(c + n, sizeof(ref) - n, o.position, o.has_position,
+                                        o.speed_mps * 1.94384, o.heading_deg);
+            n += (size_t)vps_msp_encode_position(ref + n, o.position, o.speed_mps,
+                                                 o.heading_deg, o.hdop, o.has_position);
+            if (time(NULL) == sec) break;
+            uint8_t skip[512];   /* second rolled over: discard and redo */
+            vps_out_ring_read(&r, skip, sizeof(skip));
+            i++;
+        } while (1);
+        uint8_t got[512];
+        if (vps_out_ring_read(&r, got, sizeof(got)) != n || memcmp(got, ref, n) != 0)
+            mismatches++;
+    }
+    CHECK(mismatches == 0);
+    CHECK(sink.emitted >= 200 && sink.dropped == 0);
+
+    /* Nothing is emitted by batch replay or after detaching */
+    double t0 = 30.0, lat = 52.6, lon = 13.5, hdop = 1.0;
+    vps_fusion_frames_t in = {1, &t0, &lat, &lon, &hdop, NULL, NULL, NULL};
+    vps_fusion_run_batch(&f, &in, NULL, NULL);
+    CHECK(vps_out_ring_used(&r) == 0);
+    vps_fusion_set_sink(&f, NULL);
+    vps_fusion_update(&f, NULL, 1.0, 30.1);
+    CHECK(vps_out_ring_used(&r) == 0);
+
+    /* A full ring drops whole outputs */
+    vps_fusion_set_sink(&f, &sink);
+    uint64_t emitted = sink.emitted;
+    for (int i = 0; i < 100; i++) vps_fusion_update(&f, NULL, 1.0, 31.0 + i * 0.1);
+    CHECK(sink.dropped > 0);
+    CHECK(sink.emitted + sink.dropped == emitted + 100);
+    CHECK(vps_out_ring_used(&r) <= r.capacity);
+    vps_out_ring_free(&r);
+}
+
+int main(void) {
+    test_ring_wrap();
+    test_ring_threaded();
+    test_nmea_matches_stdio();
+    test_msp_position();
+    test_fusion_sink();
+    return test_report("test_output_ring");
+}
@@ -0,0 +1,215 @@
+/**
+ * @file test_output_thread.c
+ * @brief Tests for the fixed-rate output thread and fix mailbox.
+ */
+#include "output_thread.h"
+#include "test_common.h"
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+
+/* Every field is an exact integer function of seq: no rounding, so no
+ * FP contraction can make the recomputed reference differ */
+static vps_visual_fix_t make_fix(uint32_t seq) {
+    vps_visual_fix_t f = {.seq = seq};
+    f.position.lat = (double)seq;
+    f.position.lon = -(double)seq;
+    f.hdop = (double)(seq % 7u + 1u);
+    f.t = (double)seq;
+    f.n = (int)(seq & 15u);
+    return f;
+}
+
+static bool fix_consistent(const vps_visual_fix_t *f) {
+    /* Field-wise: struct copies need not preserve padding bytes */
+    vps_visual_fix_t ref = make_fix(f->seq);
+    return ref.position.lat == f->position.lat && ref.position.lon == f->position.lon &&
+           ref.hdop == f->hdop && ref.t == f->t && ref.n == f->n;
+}
+
+static void test_mailbox_latest_wins(void) {
+    vps_fix_mailbox_t mb;
+    vps_fix_mailbox_init(&mb);
+    vps_visual_fix_t out;
+    CHECK(!vps_fix_mailbox_take(&mb, &out));
+
+    vps_visual_fix_t a = make_fix(1), b = make_fix(2), c = make_fix(3);
+    CHECK(!vps_fix_mailbox_post(&mb, &a));
+    CHECK(vps_fix_mailbox_take(&mb, &out));
+    CHECK(out.seq == 1);
+    CHECK(!vps_fix_mailbox_take(&mb, &out));
+
+    CHECK(!vps_fix_mailbox_post(&mb, &b));
+    CHECK(vps_fix_mailbox_post(&mb, &c));  /* replaces unread b */
+    CHECK(vps_fix_mailbox_take(&mb, &out));
+    CHECK(out.seq == 3);
+    CHECK(fix_consistent(&out));
+    CHECK(!vps_fix_mailbox_take(&mb, &out));
+    CHECK(atomic_load(&mb.overwritten) == 1);
+}
+
+#define N_POSTS 200000
+
+static void *producer(void *arg) {
+    vps_fix_mailbox_t *mb = arg;
+    for (uint32_t i = 1; i <= N_POSTS; i++) {
+        vps_visual_fix_t f = make_fix(i);
+        vps_fix_mailbox_post(mb, &f);
+        if ((i & 1023) == 0) sched_yield();
+    }
+    return NULL;
+}
+
+static void test_mailbox_threaded(void) {
+    vps_fix_mailbox_t mb;
+    vps_fix_mailbox_init(&mb);
+    pthread_t th;
+    pthread_create(&th, NULL, producer, &mb);
+
+    uint32_t last = 0;
+    bool monotonic = true, consistent = true;
+    while (last < N_POSTS) {
+        vps_visual_fix_t out;
+        if (!vps_fix_mailbox_take(&mb, &out)) {
+            sched_yield();
+            continue;
+        }
+        if (out.seq <= last) monotonic = false;
+        if (!fix_consistent(&out)) consistent = false;
+        last = out.seq;
+    }
+    pthread_join(th, NULL);
+    CHECK(monotonic);
+    CHECK(consistent);
+}
+
+static void test_tick_reports_at_tick_time(void) {
+    vps_fusion_t f;
+    vps_fusion_init(&f, NULL, 10.0, NULL);
+
+    /* No fix yet: nothing to report */
+    vps_fusion_output_t out = vps_output_tick(&f, NULL, 0.05);
+    CHECK(!out.has_position);
+
+    /* Two fixes moving north 1e-5 deg/s, each applied a tick later */
+    vps_visual_fix_t a = {.position = {52.0, 13.0}, .hdop = 1.0, .t = 0.0, .seq = 0};
+    out = vps_output_tick(&f, &a, 0.4);
+    CHECK(out.has_position);
+    CHECK(out.source == VPS_SOURCE_VISUAL);
+    CHECK(out.ekf_accepted);
+
+    vps_visual_fix_t b = {.position = {52.0 + 1e-5, 13.0}, .hdop = 1.0, .t = 1.0, .seq = 1};
+    out = vps_output_tick(&f, &b, 1.4);
+    CHECK(out.source == VPS_SOURCE_VISUAL);
+    CHECK(out.hdop == 1.0);
+    /* Extrapolated past the capture time of b */
+    CHECK(out.position.lat > b.position.lat);
+
+    /* Ticks in between fixes use the EKF prediction */
+    vps_fusion_output_t p1 = vps_output_tick(&f, NULL, 1.45);
+    vps_fusion_output_t p2 = vps_output_tick(&f, NULL, 1.50);
+    CHECK(p1.source == VPS_SOURCE_EKF_PREDICT);
+    CHECK(!p1.ekf_accepted);
+    CHECK(p2.position.lat > p1.position.lat);
+    CHECK(p1.position.lat > out.position.lat);
+}
+
+/* Several candidates: fuse the one the tick's own filter is closest to, or all */
+static void test_tick_selects_candidate(void) {
+    vps_fusion_t f;
+    vps_fusion_init(&f, NULL, 10.0, NULL);
+    for (int i = 0; i < 5; i++) {
+        vps_visual_fix_t a = {.position = {52.0 + 1e-5 * i, 13.0}, .hdop = 1.0, .t = i * 1.0};
+        vps_output_tick(&f, &a, i * 1.0 + 0.2);
+    }
+    vps_visual_fix_t c = {.position = {52.01, 13.0}, .hdop = 1.0, .t = 5.0, .n = 3};
+    c.fix_position[0] = (vps_geopoint_t){52.01, 13.0};
+    c.fix_position[1] = (vps_geopoint_t){52.0 + 5e-5, 13.0};
+    c.fix_position[2] = (vps_geopoint_t){52.0, 13.01};
+    for (int i = 0; i < 3; i++) c.fix_hdop[i] = 1.0;
+
+    vps_fusion_t g = f;
+    vps_visual_fix_t near = {.position = c.fix_position[1], .hdop = 1.0, .t = 5.0};
+    vps_fusion_output_t out = vps_output_tick(&f, &c, 5.2);
+    vps_fusion_output_t ref = vps_output_tick(&g, &near, 5.2);
+    CHECK(out.ekf_accepted && out.source == VPS_SOURCE_VISUAL);
+    CHECK(out.position.lat == ref.position.lat && out.position.lon == ref.position.lon);
+
+    /* Batched: every candidate goes into one update at the tick's time */
+    vps_fusion_t h = f;
+    c.t = 6.0;
+    c.fix_position[0] = (vps_geopoint_t){52.0 + 6e-5, 13.0};
+    c.fix_position[2] = (vps_geopoint_t){52.0 + 6e-5, 13.0 + 1e-5};
+    c.batch = true;
+    out = vps_output_tick(&f, &c, 6.2);
+    ref = vps_fusion_update_batch(&h, c.fix_position, c.fix_hdop, 3, 6.2);
+    CHECK(out.ekf_accepted && out.hdop < 1.0);
+    CHECK(out.position.lat == ref.position.lat && out.position.lon == ref.position.lon);
+}
+
+typedef struct {
+    int count;
+    int with_position;
+} sink_t;
+
+static void on_output(void *ctx, const vps_fusion_output_t *out, double t) {
+    sink_t *s = ctx;
+    (void)t;
+    s->count++;
+    if (out->has_position) s->with_position++;
+}
+
+static void sleep_ms(int ms) {
+    struct timespec ts = {ms / 1000, (long)(ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+static void test_thread_runs_at_rate(void) {
+    vps_config_t cfg;
+    vps_config_defaults(&cfg);
+    vps_runtime_t rt;
+    vps_frame_source_t src = {NULL, NULL};
+    vps_matcher_t m = {NULL, NULL, NULL};
+    vps_runtime_init(&rt, &cfg, src, m, NULL);
+
+    sink_t sink = {0, 0};
+    vps_output_thread_config_t oc = vps_output_thread_default_config();
+    oc.rate_hz = 100.0;
+    oc.on_output = on_output;
+    oc.on_output_ctx = &sink;
+    static vps_fusion_pub_t pub;
+    vps_fusion_pub_init(&pub);
+    oc.publish = &pub;
+
+    vps_output_thread_t ot;
+    CHECK(vps_output_thread_start(&ot, &rt, &oc));
+    vps_visual_fix_t fix = {.position = {52.52, 13.405}, .hdop = 1.0, .t = vps_monotonic_s()};
+    vps_output_thread_post(&ot, &fix);
+    sleep_ms(300);
+    vps_output_thread_stop(&ot);
+
+    vps_output_stats_t st;
+    vps_output_thread_stats(&ot, &st);
+    CHECK(st.ticks + st.missed_ticks >= 20);
+    CHECK(st.ticks + st.missed_ticks <= 40);
+    CHECK(st.fixes_applied == 1);
+    CHECK((uint64_t)sink.count == st.ticks);
+    CHECK(sink.with_position >= 1);
+
+    vps_fusion_snapshot_t snap;
+    CHECK(vps_fusion_snapshot_read(&pub, &snap, NULL));
+    CHECK(snap.version == st.ticks);
+
+    uint64_t hist_total = 0;
+    for (int i = 0; i < VPS_JITTER_BUCKETS; i++) hist_total += st.hist[i];
+    CHECK(hist_total == st.ticks);
+}
+
+int main(void) {
+    test_mailbox_latest_wins();
+    test_mailbox_threaded();
+    test_tick_reports_at_tick_time();
+    test_tick_selects_candidate();
+    test_thread_runs_at_rate();
+    return test_report("test_output_thread");
+}
@@ -0,0 +1,129 @@
+/**
+ * @file test_pipeline.c
+ * @brief Tests for the multi-stage pipelined runtime.
+ */
+#include "geo_transform.h"
+#include "match_log.h"
+#include "pipeline.h"
+#include "test_common.h"
+#include <string.h>
+
+#define N_FRAMES 500
+
+typedef struct {
+    uint32_t count;
+    uint32_t last_seq;
+    bool in_order;
+    uint32_t with_position;
+} sink_t;
+
+static void on_output(void *ctx, const vps_fusion_output_t *out,
+                      double t_capture, uint32_t seq) {
+    sink_t *s = ctx;
+    (void)t_capture;
+    if (s->count > 0 && seq <= s->last_seq) s->in_order = false;
+    s->last_seq = seq;
+    s->count++;
+    if (out->has_position) s->with_position++;
+}
+
+static void build_log(vps_match_log_t *log) {
+    memset(log, 0, sizeof(*log));
+    for (int i = 0; i < N_FRAMES; i++) {
+        vps_match_log_entry_t e;
+        memset(&e, 0, sizeof(e));
+        e.t = i / 3.0;
+        e.width = 640;
+        e.height = 640;
+        if (i % 4 != 3) {
+            vps_geopoint_t p = {52.52 + 1e-5 * i, 13.405};
+            vps_pixel_t px;
+            vps_gps_to_tile_pixel(p, 19, &e.match.tile, &px);
+            e.match.num_matches = 80;
+            e.match.inlier_ratio = 0.6;
+            e.match.confidence = 0.6;
+            e.match.H[0] = 1.0; e.match.H[2] = px.x - 320.0;
+            e.match.H[4] = 1.0; e.match.H[5] = px.y - 320.0;
+            e.match.H[8] = 1.0;
+        }
+        vps_match_log_append(log, &e);
+    }
+}
+
+static void test_blocking_delivers_all_in_order(void) {
+    vps_match_log_t log;
+    build_log(&log);
+
+    vps_config_t cfg;
+    vps_config_defaults(&cfg);
+    vps_runtime_t rt;
+    vps_runtime_init(&rt, &cfg, vps_match_log_source(&log),
+                     vps_match_log_matcher(&log), NULL);
+
+    sink_t sink = {0, 0, true, 0};
+    vps_pipeline_config_t pc = vps_pipeline_default_config();
+    pc.queue_policy[VPS_STAGE_CAPTURE] = VPS_QUEUE_BLOCK;
+    pc.on_output = on_output;
+    pc.on_output_ctx = &sink;
+
+    vps_pipeline_t pipe;
+    CHECK(vps_pipeline_start(&pipe, &rt, &pc));
+    vps_pipeline_join(&pipe);
+
+    vps_stage_stats_t st[VPS_STAGE_COUNT];
+    vps_pipeline_stats(&pipe, st);
+    for (int i = 0; i < VPS_STAGE_COUNT; i++) {
+        CHECK(st[i].processed == N_FRAMES);
+        CHECK(st[i].dropped == 0);
+        CHECK(st[i].queue_depth == 0);
+    }
+    CHECK(st[VPS_STAGE_MATCH].queue_max_depth <= 4);
+    vps_pipeline_free(&pipe);
+
+    CHECK(sink.count == N_FRAMES);
+    CHECK(sink.in_order);
+    CHECK(sink.with_position == N_FRAMES);
+    CHECK(rt.frames == N_FRAMES);
+    CHECK(rt.fixes + rt.misses == N_FRAMES);
+    CHECK(rt.fixes == N_FRAMES - N_FRAMES / 4);
+
+    vps_match_log_free(&log);
+}
+
+static void test_latest_wins_keeps_order(void) {
+    vps_match_log_t log;
+    build_log(&log);
+
+    vps_config_t cfg;
+    vps_config_defaults(&cfg);
+    vps_runtime_t rt;
+    vps_runtime_init(&rt, &cfg, vps_match_log_source(&log),
+                     vps_match_log_matcher(&log), NULL);
+
+    sink_t sink = {0, 0, true, 0};
+    vps_pipeline_config_t pc = vps_pipeline_default_config();
+    pc.on_output = on_output;
+    pc.on_output_ctx = &sink;
+
+    vps_pipeline_t pipe;
+    CHECK(vps_pipeline_start(&pipe, &rt, &pc));
+    vps_pipeline_join(&pipe);
+
+    vps_stage_stats_t st[VPS_STAGE_COUNT];
+    vps_pipeline_stats(&pipe, st);
+    CHECK(st[VPS_STAGE_CAPTURE].processed == N_FRAMES);
+    CHECK(st[VPS_STAGE_RETRIEVAL].processed + st[VPS_STAGE_RETRIEVAL].dropped == N_FRAMES);
+    CHECK(st[VPS_STAGE_OUTPUT].processed == st[VPS_STAGE_RETRIEVAL].processed);
+    vps_pipeline_free(&pipe);
+
+    CHECK(sink.in_order);
+    CHECK(sink.last_seq == N_FRAMES - 1);  /* newest frame always survives */
+
+    vps_match_log_free(&log);
+}
+
+int main(void) {
+    test_blocking_delivers_all_in_order();
+    test_latest_wins_keeps_order();
+    return test_report("test_pipeline");
+}
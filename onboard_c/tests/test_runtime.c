@@ -0,0 +1,237 @@
+/**
+ * @file test_runtime.c
+ * @brief Tests for the native positioning loop and match log replay.
+ */
+#include "geo_transform.h"
+#include "match_log.h"
+#include "msp.h"
+#include "runtime.h"
+#include "test_common.h"
+#include <stdio.h>
+#include <string.h>
+
+static vps_match_log_entry_t make_entry(double t, vps_geopoint_t p, bool matched) {
+    vps_match_log_entry_t e;
+    memset(&e, 0, sizeof(e));
+    e.t = t;
+    e.width = 640;
+    e.height = 480;
+    if (matched) {
+        vps_pixel_t px;
+        vps_gps_to_tile_pixel(p, 19, &e.match.tile, &px);
+        e.match.num_matches = 100;
+        e.match.inlier_ratio = 0.8;
+        e.match.confidence = 0.8;
+        e.match.H[0] = 1.0; e.match.H[2] = px.x - 320.0;
+        e.match.H[4] = 1.0; e.match.H[5] = px.y - 240.0;
+        e.match.H[8] = 1.0;
+    }
+    return e;
+}
+
+typedef struct {
+    uint8_t buf[4096];
+    size_t len;
+} capture_t;
+
+static bool capture_write(void *ctx, const uint8_t *data, size_t len) {
+    capture_t *c = ctx;
+    if (c->len + len > sizeof(c->buf)) return false;
+    memcpy(c->buf + c->len, data, len);
+    c->len += len;
+    return true;
+}
+
+static void test_replay_fix_and_miss(void) {
+    vps_match_log_t log;
+    memset(&log, 0, sizeof(log));
+    vps_geopoint_t p = {52.52, 13.405};
+    vps_match_log_entry_t e0 = make_entry(0.0, p, true);
+    vps_match_log_entry_t e1 = make_entry(0.333, p, false);
+    vps_match_log_append(&log, &e0);
+    vps_match_log_append(&log, &e1);
+
+    vps_config_t cfg;
+    vps_config_defaults(&cfg);
+    vps_runtime_t rt;
+    vps_runtime_init(&rt, &cfg, vps_match_log_source(&log),
+                     vps_match_log_matcher(&log), NULL);
+    capture_t cap = {{0}, 0};
+    rt.write = capture_write;
+    rt.write_ctx = &cap;
+
+    vps_step_result_t res;
+    CHECK(vps_runtime_step(&rt, &res));
+    CHECK(res.loc.has_fix);
+    CHECK_NEAR(res.loc.position.lat, p.lat, 1e-6);
+    CHECK_NEAR(res.loc.position.lon, p.lon, 1e-6);
+    CHECK_NEAR(res.loc.hdop, 1.0, 1e-9);
+    CHECK(res.out.source == VPS_SOURCE_VISUAL);
+    CHECK(res.bytes_out > 0);
+    CHECK(cap.len == (size_t)res.bytes_out);
+    CHECK(memcmp(cap.buf, "$GPGGA", 6) == 0);
+
+    CHECK(vps_runtime_step(&rt, &res));
+    CHECK(!res.loc.has_fix);
+    CHECK(res.out.source == VPS_SOURCE_EKF_PREDICT);
+
+    CHECK(!vps_runtime_step(&rt, &res));
+    CHECK(rt.frames == 2);
+    CHECK(rt.fixes == 1);
+    CHECK(rt.misses == 1);
+
+    vps_match_log_free(&log);
+}
+
+static void test_min_matches_rejects(void) {
+    vps_match_log_t log;
+    memset(&log, 0, sizeof(log));
+    vps_match_log_entry_t e = make_entry(0.0, (vps_geopoint_t){48.0, 11.0}, true);
+    e.match.num_matches = 10;
+    vps_match_log_append(&log, &e);
+
+    vps_config_t cfg;
+    vps_config_defaults(&cfg);
+    vps_runtime_t rt;
+    vps_runtime_init(&rt, &cfg, vps_match_log_source(&log),
+                     vps_match_log_matcher(&log), NULL);
+
+    vps_step_result_t res;
+    CHECK(vps_runtime_step(&rt, &res));
+    CHECK(!res.loc.has_fix);
+    CHECK(!res.out.has_position);
+
+    vps_match_log_free(&log);
+}
+
+/* Fake FC: replies queued by the test are read back in 7-byte pieces */
+typedef struct {
+    uint8_t buf[256];
+    size_t len, pos;
+} fc_t;
+
+static size_t fc_read(void *ctx, uint8_t *buf, size_t cap) {
+    fc_t *fc = ctx;
+    size_t n = fc->len - fc->pos;
+    if (n > 7) n = 7;
+    if (n > cap) n = cap;
+    memcpy(buf, fc->buf + fc->pos, n);
+    fc->pos += n;
+    return n;
+}
+
+static void fc_reply(fc_t *fc, uint8_t cmd, const uint8_t *payload, uint8_t len) {
+    uint8_t *out = fc->buf + fc->len;
+    out[0] = '$';
+    out[1] = 'M';
+    out[2] = '>';
+    out[3] = len;
+    out[4] = cmd;
+    memcpy(&out[5], payload, len);
+    out[5 + len] = vps_msp_checksum(&out[3], (size_t)len + 2);
+    fc->len += 6u + len;
+}
+
+static void test_fc_polling(void) {
+    vps_match_log_t log;
+    memset(&log, 0, sizeof(log));
+    vps_geopoint_t p = {52.52, 13.405};
+    vps_match_log_entry_t e0 = make_entry(0.0, p, true);
+    vps_match_log_entry_t e1 = make_entry(0.333, p, false);
+    vps_match_log_append(&log, &e0);
+    vps_match_log_append(&log, &e1);
+    log.restamp = true;
+
+    vps_config_t cfg;
+    vps_config_defaults(&cfg);
+    vps_runtime_t rt;
+    vps_runtime_init(&rt, &cfg, vps_match_log_source(&log),
+                     vps_match_log_matcher(&log), NULL);
+    rt.protocol = VPS_OUTPUT_MSP;
+    capture_t cap = {{0}, 0};
+    rt.write = capture_write;
+    rt.write_ctx = &cap;
+    fc_t fc = {{0}, 0, 0};
+    vps_imu_nav_t imu;
+    vps_imu_nav_init(&imu, NULL);
+    vps_runtime_attach_fc(&rt, &imu, fc_read, &fc);
+    CHECK(rt.fusion.imu == &imu);
+
+    /* Level attitude, then 1 g up: no horizontal acceleration */
+    uint8_t att[MSP_ATTITUDE_PAYLOAD] = {0};
+    uint8_t raw[MSP_RAW_IMU_PAYLOAD] = {0};
+    raw[4] = MSP_ACC_1G & 0xff;
+    raw[5] = MSP_ACC_1G >> 8;
+    fc_reply(&fc, MSP_CMD_ATTITUDE, att, sizeof(att));
+    fc_reply(&fc, MSP_CMD_RAW_IMU, raw, sizeof(raw));
+
+    vps_step_result_t res;
+    CHECK(vps_runtime_step(&rt, &res));
+    CHECK(fc.pos == fc.len);
+    CHECK(imu.has_attitude && imu.samples == 1);
+    CHECK(res.out.source == VPS_SOURCE_VISUAL);
+
+    /* Output frame, then the two poll requests */
+    uint8_t req[2 * MSP_REQUEST_SIZE];
+    vps_msp_encode_request(req, MSP_CMD_RAW_IMU);
+    vps_msp_encode_request(req + MSP_REQUEST_SIZE, MSP_CMD_ATTITUDE);
+    CHECK(cap.len == (size_t)res.bytes_out + sizeof(req));
+    CHECK(memcmp(cap.buf + res.bytes_out, req, sizeof(req)) == 0);
+
+    /* The miss is predicted by the anchored IMU (its HDOP, not the EKF's 3.0) */
+    fc_reply(&fc, MSP_CMD_RAW_IMU, raw, sizeof(raw));
+    CHECK(vps_runtime_step(&rt, &res));
+    CHECK(imu.samples == 2);
+    CHECK(res.out.source == VPS_SOURCE_EKF_PREDICT);
+    CHECK(res.out.hdop < 2.0);
+    CHECK_NEAR(res.out.position.lat, p.lat, 1e-6);
+    CHECK(rt.fc_parser.errors == 0);
+
+    vps_match_log_free(&log);
+}
+
+static void test_encode_msp(void) {
+    vps_fusion_output_t out;
+    memset(&out, 0, sizeof(out));
+    out.position = (vps_geopoint_t){52.52, 13.405};
+    out.hdop = 1.0;
+    out.has_position = true;
+
+    uint8_t buf[VPS_RUNTIME_OUT_MAX];
+    int n = vps_runtime_encode(VPS_OUTPUT_MSP, &out, buf, sizeof(buf));
+    CHECK(n == MSP_GPS_FRAME_SIZE);
+    CHECK(buf[0] == '$' && buf[1] == 'M' && buf[2] == '<');
+    CHECK(buf[4] == MSP_CMD_SET_RAW_GPS);
+}
+
+static void test_load_file(void) {
+    const char *path = "test_runtime_match_log.csv";
+    FILE *fp = fopen(path, "w");
+    CHECK(fp != NULL);
+    if (!fp) return;
+    fprintf(fp, "t,width,height,z,x,y,num_matches,inlier_ratio,confidence,"
+                "h0,h1,h2,h3,h4,h5,h6,h7,h8\n");
+    fprintf(fp, "0.0,640,640,19,281640,171940,120,0.7,0.7,"
+                "0.4,0.0,0.0,0.0,0.4,0.0,0.0,0.0,1.0\n");
+    fprintf(fp, "0.333,640,640,0,0,0,0,0.0,0.0,0,0,0,0,0,0,0,0,0\n");
+    fclose(fp);
+
+    vps_match_log_t log;
+    CHECK(vps_match_log_load(&log, path));
+    CHECK(log.count == 2);
+    CHECK(log.entries[0].match.tile.x == 281640);
+    CHECK(log.entries[0].match.num_matches == 120);
+    CHECK_NEAR(log.entries[0].match.H[4], 0.4, 1e-12);
+    CHECK(log.entries[1].match.num_matches == 0);
+    vps_match_log_free(&log);
+    remove(path);
+}
+
+int main(void) {
+    test_replay_fix_and_miss();
+    test_min_matches_rejects();
+    test_encode_msp();
+    test_fc_polling();
+    test_load_file();
+    return test_report("test_runtime");
+}
@@ -0,0 +1,212 @@
+/**
+ * @file test_smoother.c
+ * @brief VPSF codec and fixed-lag RTS smoother.
+ */
+#include "smoother.h"
+#include "test_common.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static vps_vpsf_record_t make_record(double t, double lat, double lon, uint8_t source) {
+    vps_vpsf_record_t r;
+    memset(&r, 0, sizeof(r));
+    r.timestamp = t;
+    r.lat = lat;
+    r.lon = lon;
+    r.hdop = 1.0f;
+    r.source = source;
+    r.fix_quality = source ? 1 : 0;
+    r.match_count = 42;
+    r.inlier_ratio = 0.5f;
+    r.latency_ms = 80;
+    r.flags = VPS_VPSF_FLAG_GEOFENCE_OK;
+    return r;
+}
+
+static void test_codec(void) {
+    vps_vpsf_record_t r = make_record(12.5, 52.1, 13.2, VPS_VPSF_SOURCE_VISUAL), d;
+    r.heading_deg = 271.5f;
+    uint8_t buf[VPS_VPSF_RECORD_SIZE];
+    vps_vpsf_encode(buf, &r);
+    /* Offsets of struct.pack("<3d5fBBHfHH") */
+    double t;
+    memcpy(&t, buf, 8);
+    CHECK(t == 12.5);
+    CHECK(buf[45] == VPS_VPSF_SOURCE_VISUAL);
+    CHECK(buf[46] == 42 && buf[47] == 0);
+    CHECK(buf[52] == 80 && buf[54] == VPS_VPSF_FLAG_GEOFENCE_OK);
+    vps_vpsf_decode(buf, &d);
+    CHECK(d.lat == r.lat && d.lon == r.lon && d.heading_deg == r.heading_deg);
+    CHECK(d.match_count == 42 && d.latency_ms == 80 && d.flags == r.flags);
+
+    uint8_t hdr[VPS_VPSF_HEADER_SIZE];
+    vps_vpsf_encode_header(hdr);
+    CHECK(memcmp(hdr, "VPSF\x02\x00\x38\x00", 8) == 0);
+    CHECK(vps_vpsf_check_header(hdr));
+    hdr[0] = 'X';
+    CHECK(!vps_vpsf_check_header(hdr));
+    vps_vpsf_encode_header(hdr);
+    hdr[4] = VPS_VPSF_VERSION + 1;
+    CHECK(!vps_vpsf_check_header(hdr));
+    hdr[4] = 0;
+    CHECK(!vps_vpsf_check_header(hdr));
+}
+
+typedef struct {
+    vps_vpsf_record_t *out;
+    int n;
+} collect_t;
+
+static void collect(void *ctx, const vps_vpsf_record_t *rec) {
+    collect_t *c = ctx;
+    c->out[c->n++] = *rec;
+}
+
+#define N_TRACK 3000
+
+/* Straight 10 m/s track north, 10 Hz visual fixes with 3 m noise */
+static double truth_lat(int i) {
+    return 52.0 + 10.0 * (i * 0.1) / 111320.0;
+}
+
+static void test_smoothing_reduces_error(void) {
+    static vps_smoother_t s;
+    static vps_vpsf_record_t in[N_TRACK], out[N_TRACK];
+    collect_t c = {out, 0};
+    vps_smoother_config_t cfg = vps_smoother_default_config();
+    cfg.lag = 50;
+    vps_smoother_init(&s, &cfg, collect, &c);
+
+    /* Forward-only reference */
+    vps_ekf_state_t e;
+    vps_ekf_init(&e);
+    double err_fwd = 0, err_raw = 0, err_smooth = 0;
+    unsigned seed = 7;
+    for (int i = 0; i < N_TRACK; i++) {
+        double nlat = 3.0 * test_rand_gauss(&seed) / 111320.0;
+        double nlon = 3.0 * test_rand_gauss(&seed) / (111320.0 * cos(52.0 * M_PI / 180.0));
+        in[i] = make_record(i * 0.1, truth_lat(i) + nlat, 13.0 + nlon, VPS_VPSF_SOURCE_VISUAL);
+        in[i].hdop = 3.0f;
+        vps_smoother_push(&s, &in[i]);
+        vps_ekf_update(&e, &cfg.ekf, (vps_geopoint_t){in[i].lat, in[i].lon}, 3.0, i * 0.1);
+        if (i >= 100) {
+            err_fwd += fabs(e.x[0] - truth_lat(i));
+            err_raw += fabs(in[i].lat - truth_lat(i));
+        }
+    }
+    CHECK(c.n <= N_TRACK - cfg.lag);   /* the last lag records wait for flush */
+    vps_smoother_flush(&s);
+    CHECK(c.n == N_TRACK);
+
+    for (int i = 0; i < N_TRACK; i++) {
+        CHECK(out[i].timestamp == in[i].timestamp);
+        CHECK(out[i].flags & VPS_VPSF_FLAG_SMOOTHED);
+        if (i >= 100) err_smooth += fabs(out[i].lat - truth_lat(i));
+    }
+    CHECK(err_smooth < 0.6 * err_fwd);
+    CHECK(err_fwd < err_raw);
+    CHECK_NEAR(out[N_TRACK / 2].vn_mps, 10.0, 1.0);
+    CHECK_NEAR(out[N_TRACK / 2].heading_deg, 0.0, 10.0);
+    CHECK(s.stats.records == N_TRACK && s.stats.smoothed == N_TRACK);
+    CHECK(s.stats.fixes + s.stats.rejected == N_TRACK);
+}
+
+static void test_passthrough_and_gaps(void) {
+    static vps_smoother_t s;
+    vps_vpsf_record_t out[16];
+    collect_t c = {out, 0};
+    vps_smoother_init(&s, NULL, collect, &c);
+
+    vps_vpsf_record_t none = make_record(0.0, 0.0, 0.0, 0);
+    vps_smoother_push(&s, &none);          /* before the first fix: passed through */
+    CHECK(c.n == 1 && !(out[0].flags & VPS_VPSF_FLAG_SMOOTHED));
+
+    for (int i = 1; i <= 4; i++) {
+        vps_vpsf_record_t r = make_record(i, 52.0, 13.0, VPS_VPSF_SOURCE_VISUAL);
+        vps_smoother_push(&s, &r);
+    }
+    vps_vpsf_record_t pred = make_record(5.0, 0.0, 0.0, 2);   /* EKF prediction */
+    vps_smoother_push(&s, &pred);
+    CHECK(c.n == 1);
+
+    /* A gap past max_gap_s flushes and restarts the filter */
+    vps_vpsf_record_t later = make_record(100.0, 48.0, 11.0, VPS_VPSF_SOURCE_VISUAL);
+    vps_smoother_push(&s, &later);
+    CHECK(c.n == 6);
+    CHECK(s.stats.resets == 1);
+    CHECK_NEAR(out[5].lat, 52.0, 1e-9);   /* prediction record got the track */
+    vps_smoother_flush(&s);
+    CHECK(c.n == 7);
+    CHECK_NEAR(out[6].lat, 48.0, 1e-12);
+}
+
+static void test_run_file(void) {
+    FILE *in = tmpfile(), *out = tmpfile();
+    CHECK(in && out);
+    if (!in || !out) return;
+    uint8_t hdr[VPS_VPSF_HEADER_SIZE], buf[VPS_VPSF_RECORD_SIZE];
+    vps_vpsf_encode_header(hdr);
+    fwrite(hdr, 1, sizeof(hdr), in);
+    int n = 2000;
+    for (int i = 0; i < n; i++) {
+        vps_vpsf_record_t r = make_record(i * 0.1, truth_lat(i), 13.0, VPS_VPSF_SOURCE_VISUAL);
+        vps_vpsf_encode(buf, &r);
+        fwrite(buf, 1, sizeof(buf), in);
+    }
+    rewind(in);
+
+    vps_smoother_stats_t st;
+    CHECK(vps_smoother_run_file(in, out, NULL, &st));
+    CHECK(st.records == (uint64_t)n && st.smoothed == (uint64_t)n);
+    CHECK(ftell(out) == VPS_VPSF_HEADER_SIZE + (long)n * VPS_VPSF_RECORD_SIZE);
+
+    rewind(out);
+    CHECK(fread(hdr, 1, sizeof(hdr), out) == sizeof(hdr) && vps_vpsf_check_header(hdr));
+    for (int i = 0; i < n; i++) {
+        CHECK(fread(buf, 1, sizeof(buf), out) == sizeof(buf));
+        vps_vpsf_record_t r;
+        vps_vpsf_decode(buf, &r);
+        if (i == n / 2) {
+            CHECK_NEAR(r.lat, truth_lat(i), 1e-7);
+            CHECK_NEAR(r.speed_mps, 10.0, 0.1);
+        }
+    }
+    fclose(in);
+
+    /* Not a VPSF file */
+    FILE *bad = tmpfile();
+    fwrite("NOPE\x02\x00\x38\x00", 1, 8, bad);
+    rewind(bad);
+    rewind(out);
+    CHECK(!vps_smoother_run_file(bad, out, NULL, NULL));
+    fclose(bad);
+
+    /* Truncated last record: the whole ones are written, the run fails */
+    bad = tmpfile();
+    vps_vpsf_encode_header(hdr);
+    fwrite(hdr, 1, sizeof(hdr), bad);
+    for (int i = 0; i < 3; i++) {
+        vps_vpsf_record_t r = make_record(i * 0.1, truth_lat(i), 13.0, VPS_VPSF_SOURCE_VISUAL);
+        vps_vpsf_encode(buf, &r);
+        fwrite(buf, 1, i < 2 ? sizeof(buf) : sizeof(buf) / 2, bad);
+    }
+    rewind(bad);
+    rewind(out);
+    CHECK(!vps_smoother_run_file(bad, out, NULL, &st));
+    CHECK(st.records == 2);
+    CHECK(ftell(out) == VPS_VPSF_HEADER_SIZE + 2L * VPS_VPSF_RECORD_SIZE);
+    fclose(bad);
+    fclose(out);
+}
+
+int main(void) {
+    test_codec();
+    test_smoothing_reduces_error();
+    test_passthrough_and_gaps();
+    test_run_file();
+    return test_report("test_smoother");
+}
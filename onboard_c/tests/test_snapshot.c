@@ -0,0 +1,164 @@
+/**
+ * @file test_snapshot.c
+ * @brief Seqlock snapshot publication: basics and torn-read detection.
+ */
+#include "snapshot.h"
+#include "test_common.h"
+#include <pthread.h>
+#include <string.h>
+
+#define READERS 4
+#define PUBLISHES 200000
+#define FIRST_TRIALS 2000
+
+static void test_basics(void) {
+    static vps_fusion_pub_t pub;
+    vps_fusion_pub_init(&pub);
+    vps_fusion_snapshot_t s;
+    uint32_t retries = 7;
+    CHECK(!vps_fusion_snapshot_read(&pub, &s, &retries));
+    CHECK(retries == 0);
+
+    vps_fusion_t f;
+    vps_fusion_init(&f, NULL, 10.0, NULL);
+    vps_geopoint_t z = {52.52, 13.405};
+    vps_fusion_output_t o = vps_fusion_update(&f, &z, 1.0, 1.0);
+    vps_fusion_publish(&pub, &f, &o, 1.0);
+    CHECK(vps_fusion_snapshot_read(&pub, &s, &retries));
+    CHECK(retries == 0);
+    CHECK(s.version == 1);
+    CHECK(s.t == 1.0);
+    CHECK(s.out.has_position && s.out.position.lat == o.position.lat);
+    CHECK(memcmp(s.ekf.x, f.ekf.x, sizeof(s.ekf.x)) == 0);
+    CHECK(memcmp(s.ekf.P, f.ekf.P, sizeof(s.ekf.P)) == 0);
+
+    o = vps_fusion_update(&f, NULL, 1.0, 1.5);
+    vps_fusion_publish(&pub, &f, &o, 1.5);
+    CHECK(vps_fusion_snapshot_read(&pub, &s, NULL));
+    CHECK(s.version == 2 && s.t == 1.5);
+}
+
+/* Every field the writer sets is derived from one counter k */
+static void fill(vps_fusion_snapshot_t *s, uint64_t k) {
+    memset(s, 0, sizeof(*s));
+    s->t = (double)k;
+    s->out.position.lat = (double)k * 2.0;
+    s->out.position.lon = (double)k * 3.0;
+    s->out.speed_mps = (double)(k & 0xff);
+    for (int i = 0; i < 4; i++) s->ekf.x[i] = (double)(k + (uint64_t)i);
+    for (int i = 0; i < 16; i++) s->ekf.P[i / 4][i % 4] = (double)k;
+    s->dr.ref_t = (double)k;
+}
+
+static bool consistent(const vps_fusion_snapshot_t *s) {
+    double k = s->t;
+    bool ok = s->out.position.lat == 2.0 * k && s->out.position.lon == 3.0 * k &&
+              s->dr.ref_t == k && s->version == (uint64_t)k;
+    for (int i = 0; i < 4; i++) ok = ok && s->ekf.x[i] == k + i;
+    for (int i = 0; i < 16; i++) ok = ok && s->ekf.P[i / 4][i % 4] == k;
+    return ok;
+}
+
+typedef struct {
+    vps_fusion_pub_t *pub;
+    _Atomic bool *done;
+    uint64_t reads, torn, backwards, retries;
+} reader_t;
+
+static void *reader_main(void *arg) {
+    reader_t *r = arg;
+    uint64_t last = 0;
+    vps_fusion_snapshot_t s;
+    while (!atomic_load_explicit(r->done, memory_order_acquire)) {
+        uint32_t retries;
+        if (!vps_fusion_snapshot_read(r->pub, &s, &retries)) continue;
+        r->reads++;
+        r->retries += retries;
+        if (!consistent(&s)) r->torn++;
+        if (s.version < last) r->backwards++;
+        last = s.version;
+    }
+    return NULL;
+}
+
+static void test_concurrent_readers(void) {
+    static vps_fusion_pub_t pub;
+    vps_fusion_pub_init(&pub);
+    _Atomic bool done;
+    atomic_init(&done, false);
+    reader_t r[READERS];
+    pthread_t tid[READERS];
+    for (int i = 0; i < READERS; i++) {
+        r[i] = (reader_t){&pub, &done, 0, 0, 0, 0};
+        CHECK(pthread_create(&tid[i], NULL, reader_main, &r[i]) == 0);
+    }
+    vps_fusion_snapshot_t s;
+    for (uint64_t k = 1; k <= PUBLISHES; k++) {
+        fill(&s, k);
+        vps_fusion_publish_snapshot(&pub, &s);
+    }
+    atomic_store_explicit(&done, true, memory_order_release);
+    uint64_t reads = 0, retries = 0;
+    for (int i = 0; i < READERS; i++) {
+        pthread_join(tid[i], NULL);
+        CHECK(r[i].torn == 0);
+        CHECK(r[i].backwards == 0);
+        reads += r[i].reads;
+        retries += r[i].retries;
+    }
+    CHECK(vps_fusion_snapshot_read(&pub, &s, NULL));
+    CHECK(s.version == PUBLISHES && consistent(&s));
+    printf("snapshot: %llu reads, %llu retries\n", (unsigned long long)reads,
+           (unsigned long long)retries);
+}
+
+typedef struct {
+    vps_fusion_pub_t *pub;
+    _Atomic bool *ready;
+    bool ok;
+} first_t;
+
+static void *first_main(void *arg) {
+    first_t *r = arg;
+    vps_fusion_snapshot_t s;
+    atomic_store_explicit(r->ready, true, memory_order_release);
+    while (!vps_fusion_snapshot_read(r->pub, &s, NULL)) {
+    }
+    r->ok = s.version == 1 && consistent(&s);
+    return NULL;
+}
+
+/* Reads racing the first publish see nothing or version 1, never the zeroed copy */
+static void test_first_publish(void) {
+    static vps_fusion_pub_t pub;
+    int bad = 0;
+    for (int trial = 0; trial < FIRST_TRIALS; trial++) {
+        vps_fusion_pub_init(&pub);
+        _Atomic bool ready;
+        atomic_init(&ready, false);
+        first_t r = {&pub, &ready, false};
+        pthread_t tid;
+        CHECK(pthread_create(&tid, NULL, first_main, &r) == 0);
+        while (!atomic_load_explicit(&ready, memory_order_acquire)) {
+        }
+        vps_fusion_snapshot_t s;
+        fill(&s, 1);
+        vps_fusion_publish_snapshot(&pub, &s);
+        pthread_join(tid, NULL);
+        bad += !r.ok;
+    }
+    CHECK(bad == 0);
+
+    /* A writer paused just after seq leaves 0 on a pub that never published */
+    vps_fusion_pub_init(&pub);
+    atomic_store(&pub.seq, 1);
+    vps_fusion_snapshot_t s;
+    CHECK(!vps_fusion_snapshot_read(&pub, &s, NULL));
+}
+
+int main(void) {
+    test_basics();
+    test_first_publish();
+    test_concurrent_readers();
+    return test_report("test_snapshot");
+}
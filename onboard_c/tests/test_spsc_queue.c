@@ -0,0 +1,132 @@
+/**
+ * @file test_spsc_queue.c
+ * @brief Tests for the bounded SPSC ring queue.
+ */
+#include "spsc_queue.h"
+#include "test_common.h"
+#include <pthread.h>
+#include <sched.h>
+
+static void test_fifo_and_full(void) {
+    vps_spsc_queue_t q;
+    CHECK(vps_spsc_init(&q, 3, sizeof(int)));
+    CHECK(q.capacity == 4);
+
+    for (int i = 0; i < 4; i++) CHECK(vps_spsc_push(&q, &i));
+    int x = 99;
+    CHECK(!vps_spsc_push(&q, &x));
+    CHECK(atomic_load(&q.dropped) == 1);
+    CHECK(vps_spsc_depth(&q) == 4);
+    CHECK(atomic_load(&q.max_depth) == 4);
+
+    for (int i = 0; i < 4; i++) {
+        int v = -1;
+        CHECK(vps_spsc_pop(&q, &v));
+        CHECK(v == i);
+    }
+    CHECK(!vps_spsc_pop(&q, &x));
+    vps_spsc_free(&q);
+}
+
+static void test_latest_evicts_oldest(void) {
+    vps_spsc_queue_t q;
+    CHECK(vps_spsc_init(&q, 2, sizeof(int)));
+
+    int evicted = -1;
+    for (int i = 0; i < 2; i++) CHECK(!vps_spsc_push_latest(&q, &i, &evicted));
+    int v = 2;
+    CHECK(vps_spsc_push_latest(&q, &v, &evicted));
+    CHECK(evicted == 0);
+    v = 3;
+    CHECK(vps_spsc_push_latest(&q, &v, NULL));
+
+    int out;
+    CHECK(vps_spsc_pop(&q, &out) && out == 2);
+    CHECK(vps_spsc_pop(&q, &out) && out == 3);
+    CHECK(!vps_spsc_pop(&q, &out));
+    CHECK(atomic_load(&q.dropped) == 2);
+    vps_spsc_free(&q);
+}
+
+#define N_ITEMS 200000
+
+static void *producer(void *arg) {
+    vps_spsc_queue_t *q = arg;
+    for (uint32_t i = 0; i < N_ITEMS; i++) {
+        while (!vps_spsc_try_push(q, &i)) sched_yield();
+    }
+    return NULL;
+}
+
+static void test_threaded_order(void) {
+    vps_spsc_queue_t q;
+    CHECK(vps_spsc_init(&q, 64, sizeof(uint32_t)));
+    pthread_t th;
+    pthread_create(&th, NULL, producer, &q);
+
+    uint32_t expect = 0;
+    bool in_order = true;
+    while (expect < N_ITEMS) {
+        uint32_t v;
+        if (vps_spsc_pop(&q, &v)) {
+            if (v != expect) in_order = false;
+            expect++;
+        } else {
+            sched_yield();
+        }
+    }
+    pthread_join(th, NULL);
+    CHECK(in_order);
+    CHECK(atomic_load(&q.popped) == N_ITEMS);
+    vps_spsc_free(&q);
+}
+
+typedef struct {
+    vps_spsc_queue_t *q;
+    _Atomic bool done;
+} latest_ctx_t;
+
+static void *latest_producer(void *arg) {
+    latest_ctx_t *c = arg;
+    for (uint32_t i = 0; i < N_ITEMS; i++) vps_spsc_push_latest(c->q, &i, NULL);
+    atomic_store(&c->done, true);
+    return NULL;
+}
+
+static void test_threaded_latest_monotonic(void) {
+    vps_spsc_queue_t q;
+    CHECK(vps_spsc_init(&q, 4, sizeof(uint32_t)));
+    latest_ctx_t c = {&q, false};
+    pthread_t th;
+    pthread_create(&th, NULL, latest_producer, &c);
+
+    /* Consumer may miss items but must never see them out of order */
+    int64_t last = -1;
+    bool monotonic = true;
+    uint64_t got = 0;
+    for (;;) {
+        uint32_t v;
+        if (vps_spsc_pop(&q, &v)) {
+            if ((int64_t)v <= last) monotonic = false;
+            last = v;
+            got++;
+        } else if (atomic_load(&c.done) && vps_spsc_depth(&q) == 0) {
+            break;
+        } else {
+            sched_yield();
+        }
+    }
+    pthread_join(th, NULL);
+    CHECK(monotonic);
+    CHECK(last == N_ITEMS - 1);
+    CHECK(got + atomic_load(&q.dropped) == N_ITEMS);
+    vps_spsc_free(&q);
+}
+
+int main(void) {
+    test_fifo_and_full();
+    test_latest_evicts_oldest();
+    test_threaded_order();
+    test_threaded_latest_monotonic();
+    return test_report("test_spsc_queue");
+}
@@ -0,0 +1,198 @@
+/**
+ * @file test_tile_iter.c
+ * @brief Tile iterator against a brute-force tile/ellipse intersection.
+ */
+#include "test_common.h"
+#include "tile_iter.h"
+#include "tile_math.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BOX 160                 /* brute-force window, tiles each side */
+
+/* p' S^-1 p for the iterator's ellipse */
+static double form(const vps_tile_iter_t *it, double x, double y) {
+    double det = it->sxx * it->syy - it->sxy * it->sxy;
+    return (it->syy * x * x - 2.0 * it->sxy * x * y + it->sxx * y * y) / det;
+}
+
+/* Minimum of the form along the segment p + s d, s in [0, 1] */
+static double seg_min(const vps_tile_iter_t *it, double px, double py, double dx, double dy) {
+    double a = form(it, dx, dy);
+    double b = (form(it, px + dx, py + dy) - form(it, px - dx, py - dy)) / 4.0;
+    double s = a > 0.0 ? fmax(0.0, fmin(1.0, -b / a)) : 0.0;
+    return form(it, px + s * dx, py + s * dy);
+}
+
+/* Does tile offset (i, j) from the point's tile touch the ellipse? */
+static bool touches(const vps_tile_iter_t *it, int i, int j, double eps) {
+    double x0 = i - it->fx, y0 = j - it->fy;
+    if (x0 <= 0.0 && x0 + 1.0 >= 0.0 && y0 <= 0.0 && y0 + 1.0 >= 0.0) return true;
+    double q = fmin(fmin(seg_min(it, x0, y0, 1.0, 0.0), seg_min(it, x0, y0 + 1.0, 1.0, 0.0)),
+                    fmin(seg_min(it, x0, y0, 0.0, 1.0), seg_min(it, x0 + 1.0, y0, 0.0, 1.0)));
+    return q <= 1.0 + eps;
+}
+
+static int chebyshev(int dx, int dy) {
+    dx = dx < 0 ? -dx : dx;
+    dy = dy < 0 ? -dy : dy;
+    return dx > dy ? dx : dy;
+}
+
+static unsigned char seen[2 * BOX + 1][2 * BOX + 1];
+
+/* Run an iterator to the end and compare with the brute force */
+static int check_iter(vps_tile_iter_t *it) {
+    vps_tile_iter_t start = *it;
+    int n = 1 << it->zoom, count = 0, ring = 0, axis = 0;
+    memset(seen, 0, sizeof(seen));
+    vps_tile_coord_t t;
+    while (vps_tile_iter_next(it, &t)) {
+        int dx = t.x - start.cx, dy = t.y - start.cy;
+        if (dx > n / 2) dx -= n;            /* undo the wrap */
+        if (dx < -(n / 2)) dx += n;
+        CHECK(t.z == start.zoom && t.y >= 0 && t.y < n && t.x >= 0 && t.x < n);
+        CHECK(it->ring == chebyshev(dx, dy));
+        /* Rings in order; within a ring, outward from the axes */
+        int off = it->ring == chebyshev(dx, 0) ? abs(dy) : abs(dx);
+        CHECK(it->ring > ring || (it->ring == ring && off >= axis));
+        axis = it->ring > ring ? off : axis > off ? axis : off;
+        ring = it->ring;
+        double gap = fmax(fmax(fmax(dx - start.fx, start.fx - dx - 1.0),
+                               fmax(dy - start.fy, start.fy - dy - 1.0)), 0.0);
+        CHECK(gap * it->tile_m >= vps_tile_iter_min_dist_m(it) - 1e-6);
+        CHECK(touches(&start, dx, dy, 1e-9));
+        if (abs(dx) <= BOX && abs(dy) <= BOX) {
+            CHECK(!seen[dy + BOX][dx + BOX]);
+            seen[dy + BOX][dx + BOX] = 1;
+        }
+        count++;
+    }
+    CHECK(!vps_tile_iter_next(it, &t));
+    /* Every tile in the window touching the ellipse was produced */
+    for (int dy = -BOX; dy <= BOX; dy++)
+        for (int dx = -BOX; dx <= BOX; dx++) {
+            if (start.cy + dy < 0 || start.cy + dy >= n) continue;
+            if (dx < start.x_lo || dx > start.x_hi) continue;
+            if (!seen[dy + BOX][dx + BOX]) CHECK(!touches(&start, dx, dy, -1e-9));
+        }
+    return count;
+}
+
+static void test_circle(void) {
+    unsigned seed = 3;
+    for (int k = 0; k < 300; k++) {
+        vps_geopoint_t p = {(2.0 * test_rand(&seed) - 1.0) * 80.0,
+                            (2.0 * test_rand(&seed) - 1.0) * 180.0};
+        int zoom = 17;
+        double tile_m = vps_meters_per_pixel(p.lat, zoom) * VPS_TILE_SIZE;
+        double r = test_rand(&seed) * 40.0 * tile_m;
+        if (k < 5) r = 0.0;
+        vps_tile_iter_t it;
+        vps_tile_iter_circle(&it, p, r, zoom);
+        CHECK_NEAR(it.tile_m, tile_m, 1e-9);
+        CHECK_NEAR(sqrt(it.sxx), fmax(r / tile_m, 1e-6), 1e-9);
+        vps_tile_coord_t home = vps_gps_to_tile(p, zoom);
+        CHECK(it.cx == home.x && it.cy == home.y);
+        int count = check_iter(&it);
+        /* About the circle's area plus its perimeter band */
+        double rt = r / tile_m;
+        CHECK(count >= M_PI * rt * rt * 0.9);
+        CHECK(count <= M_PI * (rt + 1.5) * (rt + 1.5));
+    }
+
+    /* Antimeridian wraps, poles clip, small worlds cut at half a world */
+    vps_tile_iter_t it;
+    vps_tile_iter_circle(&it, (vps_geopoint_t){10.0, 179.9999}, 20000.0, 15);
+    check_iter(&it);
+    vps_tile_iter_circle(&it, (vps_geopoint_t){85.0, -179.9999}, 50000.0, 12);
+    check_iter(&it);
+    /* Past the Mercator limit the circle is sized at the clipped row, not at cos(90) ~ 0 */
+    vps_tile_iter_circle(&it, (vps_geopoint_t){85.05112878, 8.5}, 1000.0, 17);
+    int edge_ring = it.max_ring, edge = check_iter(&it);
+    CHECK(edge_ring < 64);
+    static const double polar[] = {90.0, 89.99, -90.0};
+    for (int i = 0; i < 3; i++) {
+        vps_tile_iter_circle(&it, (vps_geopoint_t){polar[i], 8.5}, 1000.0, 17);
+        CHECK(it.tile_m > 20.0 && it.max_ring <= edge_ring);
+        CHECK(check_iter(&it) == edge);
+    }
+    vps_tile_iter_circle(&it, (vps_geopoint_t){0.0, 0.0}, 5e7, 3);
+    CHECK(check_iter(&it) == 64);
+    vps_tile_iter_circle(&it, (vps_geopoint_t){30.0, 100.0}, 5e7, 0);
+    CHECK(check_iter(&it) == 1);
+
+    /* Stopping early */
+    vps_tile_iter_circle(&it, (vps_geopoint_t){47.4, 8.5}, 1e5, 19);
+    it.max_ring = 2;
+    vps_tile_coord_t t;
+    int n = 0;
+    while (vps_tile_iter_next(&it, &t)) n++;
+    CHECK(n == 25 && it.ring == 2);
+}
+
+static void test_ellipse(void) {
+    unsigned seed = 5;
+    for (int k = 0; k < 300; k++) {
+        vps_ekf_state_t ekf;
+        memset(&ekf, 0, sizeof(ekf));
+        ekf.x[0] = (2.0 * test_rand(&seed) - 1.0) * 75.0;
+        ekf.x[1] = (2.0 * test_rand(&seed) - 1.0) * 180.0;
+        /* sigmas up to ~200 m, any correlation */
+        double sn = test_rand(&seed) * 2e-3;
+        double se = test_rand(&seed) * 2e-3 / cos(ekf.x[0] * M_PI / 180.0);
+        double rho = 2.0 * test_rand(&seed) - 1.0;
+        ekf.P[0][0] = sn * sn;
+        ekf.P[1][1] = se * se;
+        ekf.P[0][1] = ekf.P[1][0] = rho * sn * se;
+        vps_tile_iter_t it;
+        vps_tile_iter_ellipse(&it, &ekf, 3.0, 17);
+        check_iter(&it);
+
+        /* Points just inside the 3-sigma ellipse fall in tiles it produced */
+        vps_tile_iter_ellipse(&it, &ekf, 3.0, 17);
+        vps_tile_coord_t got[4096];
+        int n = 0;
+        while (n < 4096 && vps_tile_iter_next(&it, &got[n])) n++;
+        if (n == 4096) continue;
+        double l11 = sn, l21 = rho * se, l22 = se * sqrt(fmax(0.0, 1.0 - rho * rho));
+        for (int a = 0; a < 16; a++) {
+            double c = cos(a * M_PI / 8.0) * 2.97, s = sin(a * M_PI / 8.0) * 2.97;
+            vps_geopoint_t q = {ekf.x[0] + l11 * c, ekf.x[1] + l21 * c + l22 * s};
+            vps_tile_coord_t t = vps_gps_to_tile(q, 17);
+            bool found = false;
+            for (int i = 0; i < n && !found; i++) found = got[i].x == t.x && got[i].y == t.y;
+            CHECK(found);
+        }
+    }
+}
+
+static void test_tiles_in_radius(void) {
+    vps_tile_coord_t out[64];
+    vps_geopoint_t p = {47.3977, 8.5456};
+    vps_tile_coord_t home = vps_gps_to_tile(p, 17);
+    int n = vps_tiles_in_radius(p, 1.0, 17, out, 64);
+    CHECK(n == 64);
+    CHECK(out[0].x == home.x && out[0].y == home.y);
+    for (int i = 1; i < n; i++)
+        CHECK(chebyshev(out[i].x - home.x, out[i].y - home.y) >=
+              chebyshev(out[i - 1].x - home.x, out[i - 1].y - home.y));
+    vps_tile_iter_t it;
+    vps_tile_iter_circle(&it, p, 1000.0, 17);
+    vps_tile_coord_t t;
+    int all = 0;
+    while (vps_tile_iter_next(&it, &t)) all++;
+    static vps_tile_coord_t big[1024];
+    CHECK(vps_tiles_in_radius(p, 1.0, 17, big, 1024) == all);
+}
+
+int main(void) {
+    test_circle();
+    test_ellipse();
+    test_tiles_in_radius();
+    return test_report("test_tile_iter");
+}
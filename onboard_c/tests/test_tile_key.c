@@ -0,0 +1,144 @@
+/**
+ * @file test_tile_key.c
+ * @brief Morton keys against tile arithmetic, and the tile map against
+ *        the key list it was built from.
+ */
+#include "test_common.h"
+#include "tile_key.h"
+#include <stdlib.h>
+#include <string.h>
+
+static vps_tile_coord_t random_tile(unsigned *seed) {
+    int z = (int)(test_rand_u32(seed) % (VPS_TILE_KEY_MAX_ZOOM + 1));
+    uint32_t n = (uint32_t)1 << z;
+    return (vps_tile_coord_t){z, (int)(test_rand_u32(seed) & (n - 1)),
+                              (int)(test_rand_u32(seed) & (n - 1))};
+}
+
+static void test_keys(void) {
+    unsigned seed = 1;
+    for (int i = 0; i < 100000; i++) {
+        vps_tile_coord_t t = random_tile(&seed);
+        vps_tile_key_t k = vps_tile_key(t);
+        vps_tile_coord_t back = vps_tile_key_coord(k);
+        CHECK(back.z == t.z && back.x == t.x && back.y == t.y);
+        CHECK(vps_tile_key_zoom(k) == t.z);
+
+        /* Parent and children */
+        vps_tile_coord_t p = vps_tile_key_coord(vps_tile_key_parent(k));
+        if (t.z > 0) CHECK(p.z == t.z - 1 && p.x == t.x / 2 && p.y == t.y / 2);
+        else CHECK(vps_tile_key_parent(k) == VPS_TILE_KEY_NONE);
+        if (t.z < VPS_TILE_KEY_MAX_ZOOM) {
+            vps_tile_coord_t c = vps_tile_key_coord(vps_tile_key_child(k, 3));
+            CHECK(c.z == t.z + 1 && c.x == 2 * t.x + 1 && c.y == 2 * t.y + 1);
+            CHECK(vps_tile_key_parent(vps_tile_key_child(k, 2)) == k);
+        }
+        CHECK(vps_tile_key_ancestor(k, t.z) == k);
+        CHECK(vps_tile_key_ancestor(k, t.z + 1) == VPS_TILE_KEY_NONE);
+        vps_tile_coord_t a = vps_tile_key_coord(vps_tile_key_ancestor(k, t.z / 2));
+        CHECK(a.x == t.x >> (t.z - t.z / 2) && a.y == t.y >> (t.z - t.z / 2));
+
+        /* Neighbours: x wraps, y stops at the edges */
+        int64_t n = (int64_t)1 << t.z;
+        for (int dy = -1; dy <= 1; dy++)
+            for (int dx = -1; dx <= 1; dx++) {
+                vps_tile_key_t nk;
+                bool ok = vps_tile_key_neighbor(k, dx, dy, &nk);
+                int64_t y = t.y + dy;
+                CHECK(ok == (y >= 0 && y < n));
+                if (!ok) continue;
+                vps_tile_coord_t nt = vps_tile_key_coord(nk);
+                CHECK(nt.z == t.z && nt.y == y && nt.x == (int)((t.x + dx + n) % n));
+            }
+
+        /* Quadkey */
+        char qk[VPS_TILE_KEY_MAX_ZOOM + 1];
+        CHECK(vps_tile_key_quadkey(k, qk) == t.z && (int)strlen(qk) == t.z);
+        vps_tile_key_t kq;
+        CHECK(vps_tile_key_from_quadkey(qk, &kq) && kq == k);
+    }
+    /* Bing's example: tile (3, 5) at zoom 3 is "213" */
+    char qk[8];
+    vps_tile_key_quadkey(vps_tile_key((vps_tile_coord_t){3, 3, 5}), qk);
+    CHECK(!strcmp(qk, "213"));
+    vps_tile_key_t k;
+    CHECK(!vps_tile_key_from_quadkey("2140", &k));
+    CHECK(!vps_tile_key_from_quadkey("012301230123012301230123012301", &k));
+    CHECK(vps_tile_key_from_quadkey("", &k) && k == vps_tile_key((vps_tile_coord_t){0, 0, 0}));
+    /* Keys order by zoom, then Morton order within a zoom */
+    vps_tile_coord_t a = {5, 31, 31}, b = {6, 0, 0}, c = {5, 1, 0}, d = {5, 0, 1};
+    CHECK(vps_tile_key(a) < vps_tile_key(b) && vps_tile_key(c) < vps_tile_key(d));
+}
+
+#define N_TILES 200000
+
+static void test_map(void) {
+    vps_tile_key_t *keys = malloc(sizeof(vps_tile_key_t) * N_TILES);
+    CHECK(keys != NULL);
+    if (!keys) return;
+    /* A pack: z17 square plus its pyramid, plus scattered tiles */
+    int n = 0;
+    for (int y = 0; y < 256 && n < N_TILES; y++)
+        for (int x = 0; x < 512; x++)
+            keys[n++] = vps_tile_key((vps_tile_coord_t){17, 68000 + x, 45000 + y});
+    int z17 = n;
+    for (int i = 0; i < z17 && n < N_TILES; i++) {
+        vps_tile_coord_t t = vps_tile_key_coord(keys[i]);
+        if (t.x % 2 == 0 && t.y % 2 == 0) keys[n++] = vps_tile_key_parent(keys[i]);
+    }
+    unsigned seed = 9;
+    while (n < N_TILES) keys[n++] = vps_tile_key(random_tile(&seed));
+
+    vps_tile_map_t m;
+    CHECK(vps_tile_map_build(&m, keys, N_TILES));
+    uint32_t v;
+    int distinct = 0;
+    for (int i = 0; i < N_TILES; i++) {
+        CHECK(vps_tile_map_get(&m, keys[i], &v));
+        CHECK(keys[v] == keys[i]);          /* duplicates map to their last index */
+        distinct += v == (uint32_t)i;
+    }
+    CHECK(m.count == distinct);
+    CHECK(2 * (size_t)m.count <= m.mask + 1);
+
+    /* Neighbours inside the z17 square are all present */
+    for (int i = 512 + 100; i < 512 + 300; i++) {
+        vps_tile_key_t nk;
+        CHECK(vps_tile_key_neighbor(keys[i], 1, 1, &nk) && vps_tile_map_get(&m, nk, &v));
+        CHECK(vps_tile_map_get(&m, vps_tile_key_parent(keys[i]), &v));
+    }
+    /* Misses */
+    CHECK(!vps_tile_map_get(&m, vps_tile_key((vps_tile_coord_t){17, 1, 1}), &v));
+    CHECK(!vps_tile_map_get(&m, VPS_TILE_KEY_NONE, &v));
+    CHECK(!vps_tile_map_put(&m, VPS_TILE_KEY_NONE, 1));
+
+    /* Batch agrees with single lookups */
+    vps_tile_key_t q[100];
+    uint32_t out[100];
+    for (int i = 0; i < 100; i++)
+        q[i] = i % 3 ? keys[test_rand_u32(&seed) % N_TILES] : vps_tile_key(random_tile(&seed));
+    int found = vps_tile_map_get_batch(&m, q, 100, out), hits = 0;
+    for (int i = 0; i < 100; i++) {
+        bool hit = vps_tile_map_get(&m, q[i], &v);
+        CHECK(hit ? out[i] == v : out[i] == VPS_TILE_MAP_NONE);
+        hits += hit;
+    }
+    CHECK(found == hits);
+    vps_tile_map_free(&m);
+
+    /* Growth from a small table, with replacement */
+    CHECK(vps_tile_map_init(&m, 0));
+    for (int i = 0; i < 5000; i++) CHECK(vps_tile_map_put(&m, keys[i], (uint32_t)i));
+    for (int i = 0; i < 5000; i++) CHECK(vps_tile_map_put(&m, keys[i], (uint32_t)(i + 7)));
+    CHECK(m.count == 5000);
+    for (int i = 0; i < 5000; i++)
+        CHECK(vps_tile_map_get(&m, keys[i], &v) && v == (uint32_t)(i + 7));
+    vps_tile_map_free(&m);
+    free(keys);
+}
+
+int main(void) {
+    test_keys();
+    test_map();
+    return test_report("test_tile_key");
+}
@@ -0,0 +1,181 @@
+/**
+ * @file test_visual_odom.c
+ * @brief Visual odometry on synthetic nadir frames, and its DR feed.
+ */
+#include "fusion.h"
+#include "test_common.h"
+#include "visual_odom.h"
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define G 1024          /* ground texture, 0.2 m per pixel */
+#define W 320
+#define H 240
+
+static uint8_t ground[G * G];
+
+/* Blurred noise with stretched contrast: corners everywhere */
+static void make_ground(void) {
+    static uint8_t tmp[G * G];
+    unsigned seed = 5;
+    for (int i = 0; i < G * G; i++) ground[i] = (uint8_t)(test_rand_next(&seed) >> 24);
+    for (int pass = 0; pass < 2; pass++) {
+        for (int y = 1; y < G - 1; y++)
+            for (int x = 1; x < G - 1; x++) {
+                int s = 0;
+                for (int dy = -1; dy <= 1; dy++)
+                    for (int dx = -1; dx <= 1; dx++) s += ground[(y + dy) * G + x + dx];
+                tmp[y * G + x] = (uint8_t)(s / 9);
+            }
+        memcpy(ground, tmp, sizeof(tmp));
+    }
+    for (int i = 0; i < G * G; i++) {
+        int v = 128 + 4 * (ground[i] - 128);
+        ground[i] = (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+    }
+}
+
+static double sample(double x, double y) {
+    int ix = (int)floor(x), iy = (int)floor(y);
+    double fx = x - ix, fy = y - iy;
+    const uint8_t *p = ground + iy * G + ix;
+    return (1 - fy) * ((1 - fx) * p[0] + fx * p[1]) + fy * ((1 - fx) * p[G] + fx * p[G + 1]);
+}
+
+/* Camera over ground pixel (gx, gy) (x east, y south), image top at heading */
+static void render(uint8_t *img, double gx, double gy, double heading_deg, double scale) {
+    double h = heading_deg * M_PI / 180.0, c = cos(h) / scale, s = sin(h) / scale;
+    for (int v = 0; v < H; v++)
+        for (int u = 0; u < W; u++) {
+            double a = u - (W - 1) * 0.5, b = v - (H - 1) * 0.5;
+            img[v * W + u] = (uint8_t)lrint(sample(gx + a * c - b * s, gy + a * s + b * c));
+        }
+}
+
+static void test_track_subpixel(void) {
+    vps_vo_t vo;
+    CHECK(vps_vo_init(&vo, NULL, W, H));
+    static uint8_t f0[W * H], f1[W * H];
+    render(f0, 500.0, 500.0, 0.0, 1.0);
+    render(f1, 503.3, 497.85, 0.0, 1.0);   /* scene moves by (-3.3, +2.15) */
+    vps_vo_motion_t m;
+    CHECK(!vps_vo_process(&vo, f0, W, 100.0, 0.0, &m));
+    CHECK(vo.n_features >= 30);
+    float pts0[VPS_VO_MAX_FEATURES][2], pts1[VPS_VO_MAX_FEATURES][2];
+    int n = vo.n_features;
+    memcpy(pts0, vo.features, sizeof(float) * 2 * (size_t)n);
+    CHECK(vps_vo_process(&vo, f1, W, 100.0, 0.0, &m));
+
+    bool st[VPS_VO_MAX_FEATURES];
+    int ok = vps_vo_track(&vo, (const float(*)[2])pts0, n, pts1, st);
+    CHECK(ok >= n * 9 / 10);
+    double err = 0.0;
+    for (int i = 0; i < n; i++)
+        if (st[i]) err += hypot(pts1[i][0] - pts0[i][0] + 3.3, pts1[i][1] - pts0[i][1] - 2.15);
+    printf("vo (%s): %d corners, %d tracked, mean error %.3f px\n", vps_vo_isa(), n, ok,
+           err / ok);
+    CHECK(err / ok < 0.1);
+
+    CHECK(m.valid && m.inliers >= ok * 8 / 10);
+    CHECK_NEAR(m.dx_px, -3.3, 0.05);
+    CHECK_NEAR(m.dy_px, 2.15, 0.05);
+    CHECK_NEAR(m.scale, 1.0, 1e-3);
+    CHECK(fabs(m.dtheta_rad) < 1e-3);
+    /* gsd 0.2 m: the camera went 0.66 m east and 0.43 m north */
+    CHECK_NEAR(m.de_m, 0.66, 0.01);
+    CHECK_NEAR(m.dn_m, 0.43, 0.01);
+    vps_vo_free(&vo);
+}
+
+/* A turning, climbing flight: accumulated displacement vs truth */
+static void test_sequence(void) {
+    vps_vo_t vo;
+    CHECK(vps_vo_init(&vo, NULL, W, H));
+    static uint8_t img[W * H];
+    double gx = 400.0, gy = 600.0, heading = 30.0, alt = 100.0;
+    double sum_n = 0.0, sum_e = 0.0, x0 = gx, y0 = gy;
+    double last_dtheta = 0.0, last_scale = 1.0;
+    int valid = 0;
+    for (int k = 0; k < 25; k++) {
+        if (k > 0) {
+            double h = heading * M_PI / 180.0;
+            gx += 6.0 * sin(h);   /* 6 px = 1.2 m forward per frame */
+            gy -= 6.0 * cos(h);
+            heading += 0.8;
+            alt *= 1.002;
+        }
+        render(img, gx, gy, heading, 100.0 / alt);
+        vps_vo_motion_t m;
+        if (vps_vo_process(&vo, img, W, alt, heading, &m)) {
+            sum_n += m.dn_m;
+            sum_e += m.de_m;
+            last_dtheta = m.dtheta_rad;
+            last_scale = m.scale;
+            valid++;
+        }
+    }
+    double true_n = -(gy - y0) * 0.2, true_e = (gx - x0) * 0.2;
+    printf("vo sequence: %d steps, %.2f m N %.2f m E (truth %.2f, %.2f)\n", valid, sum_n, sum_e,
+           true_n, true_e);
+    CHECK(valid == 24);
+    CHECK(hypot(sum_n - true_n, sum_e - true_e) < 0.02 * hypot(true_n, true_e));
+    /* Yawing right turns the scene counter-clockwise; climbing shrinks it */
+    CHECK_NEAR(last_dtheta, -0.8 * M_PI / 180.0, 2e-3);
+    CHECK_NEAR(last_scale, 1.0 / 1.002, 1e-3);
+
+    /* A blank frame cannot be tracked */
+    static uint8_t flat[W * H];
+    memset(flat, 90, sizeof(flat));
+    vps_vo_motion_t m;
+    CHECK(!vps_vo_process(&vo, flat, W, alt, heading, &m));
+    CHECK(vo.n_features == 0);
+    CHECK(!vps_vo_process(&vo, img, W, alt, heading, &m) && m.features == 0);
+    vps_vo_free(&vo);
+
+    vps_vo_config_t cfg = vps_vo_default_config();
+    CHECK(!vps_vo_init(&vo, &cfg, 64, 64));   /* too small for 3 levels */
+}
+
+static void test_dr_feed(void) {
+    vps_dr_state_t dr;
+    vps_dr_init(&dr, 10.0, 2.0);
+    CHECK(!vps_dr_apply_odometry(&dr, 1.0, 0.0, 0.1, 1.0));
+    vps_dr_update_ref(&dr, (vps_geopoint_t){47.0, 8.0}, 0.0, 0.0, 1.0, 1.0);
+    CHECK(!vps_dr_apply_odometry(&dr, 1.0, 0.0, 0.1, 1.0));
+    CHECK(vps_dr_apply_odometry(&dr, 2.0, -1.0, 0.1, 1.5));
+    CHECK(dr.odometry);
+    CHECK_NEAR(dr.vn_mps, 4.0, 1e-12);
+    CHECK_NEAR(dr.ve_mps, -2.0, 1e-12);
+    CHECK_NEAR((dr.ref_pos.lat - 47.0) * 111320.0, 2.0, 1e-6);
+    CHECK_NEAR(dr.ref_hdop, 1.1, 1e-12);
+
+    /* Fusion: after a fix, outputs follow the odometry, not the EKF */
+    vps_fusion_t f;
+    vps_fusion_init(&f, NULL, 10.0, NULL);
+    vps_geopoint_t z = {47.0, 8.0};
+    vps_fusion_update(&f, &z, 1.0, 0.0);
+    vps_fusion_update(&f, &z, 1.0, 1.0);
+    double m_lon = 111320.0 * cos(47.0 * M_PI / 180.0);
+    for (int k = 1; k <= 10; k++) CHECK(vps_fusion_odometry(&f, 0.0, 1.5, 0.02, 1.0 + 0.1 * k));
+    vps_fusion_output_t o = vps_fusion_update(&f, NULL, 1.0, 2.0);
+    CHECK(o.has_position && o.source == VPS_SOURCE_DEAD_RECKONING);
+    CHECK_NEAR((o.position.lon - 8.0) * m_lon, 15.0, 0.01);
+    CHECK_NEAR(o.hdop, 1.2, 1e-9);
+
+    /* A visual fix takes over again */
+    o = vps_fusion_update(&f, &z, 1.0, 2.1);
+    CHECK(o.source == VPS_SOURCE_VISUAL && !f.dr.odometry);
+    o = vps_fusion_update(&f, NULL, 1.0, 2.2);
+    CHECK(o.source == VPS_SOURCE_EKF_PREDICT);
+}
+
+int main(void) {
+    make_ground();
+    test_track_subpixel();
+    test_sequence();
+    test_dr_feed();
+    return test_report("test_visual_odom");
+}
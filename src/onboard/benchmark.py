@@ -10,6 +10,8 @@ Benchmarks:
 - Homography estimation
 - NMEA/MSP encoding
 - Full pipeline end-to-end
+- Post-match loop replayed from a recorded frame set (compare with the
+  native onboard_c/bench/bench_runtime on the same match log)
 """
 
 from __future__ import annotations
@@ -162,6 +164,120 @@ def benchmark_msp_encoding(iterations: int = 10000) -> BenchmarkResult:
     return BenchmarkResult(name="MSP encoding", iterations=iterations, times_ms=times)
 
 
+MATCH_LOG_HEADER = (
+    "t,width,height,z,x,y,num_matches,inlier_ratio,confidence,"
+    + ",".join(f"h{i}" for i in range(9))
+)
+
+
+@dataclass(slots=True)
+class MatchLogEntry:
+    """One recorded frame: the matcher result replayed by both runtimes.
+
+    num_matches == 0 marks a frame without a usable match.
+    """
+    t: float
+    width: int = 640
+    height: int = 640
+    tile_z: int = 0
+    tile_x: int = 0
+    tile_y: int = 0
+    num_matches: int = 0
+    inlier_ratio: float = 0.0
+    confidence: float = 0.0
+    H: tuple[float, ...] = (0.0,) * 9
+
+
+def save_match_log(path: Path, entries: list[MatchLogEntry]) -> None:
+    """Write a recorded frame set in the CSV format read by match_log.c."""
+    lines = [MATCH_LOG_HEADER]
+    for e in entries:
+        fields = [
+            repr(e.t), str(e.width), str(e.height),
+            str(e.tile_z), str(e.tile_x), str(e.tile_y),
+            str(e.num_matches), repr(e.inlier_ratio), repr(e.confidence),
+        ]
+        fields.extend(repr(float(h)) for h in e.H)
+        lines.append(",".join(fields))
+    path.write_text("\n".join(lines) + "\n")
+
+
+def load_match_log(path: Path) -> list[MatchLogEntry]:
+    """Read a recorded frame set."""
+    entries = []
+    for line in path.read_text().splitlines():
+        if not line or line.startswith("#") or line.startswith("t,"):
+            continue
+        v = line.split(",")
+        entries.append(MatchLogEntry(
+            t=float(v[0]), width=int(float(v[1])), height=int(float(v[2])),
+            tile_z=int(float(v[3])), tile_x=int(float(v[4])), tile_y=int(float(v[5])),
+            num_matches=int(float(v[6])), inlier_ratio=float(v[7]),
+            confidence=float(v[8]), H=tuple(float(h) for h in v[9:18]),
+        ))
+    return entries
+
+
+def benchmark_replay_loop(
+    entries: list[MatchLogEntry],
+    iterations: int | None = None,
+    min_matches: int = 15,
+    min_inlier_ratio: float = 0.3,
+) -> tuple[BenchmarkResult, float]:
+    """Replay recorded matcher output through the Python post-match loop.
+
+    Does the per-frame work of main.py after matching: homography → GPS,
+    EKF update, GGA + RMC encoding. Frames loop (with shifted timestamps)
+    until ``iterations`` frames have been processed.
+
+    Returns:
+        (per-frame latency result, frames per second)
+    """
+    from onboard.ekf import EKFConfig, PositionEKF
+    from onboard.homography import extract_gps
+    from onboard.nmea import PositionFix, format_gga, format_rmc
+    from shared.tile_math import TileCoord
+
+    if not entries:
+        return BenchmarkResult(name="Python loop", iterations=0, times_ms=[]), 0.0
+
+    n = iterations if iterations is not None else len(entries)
+    span = entries[-1].t - entries[0].t + 1.0 / 3.0
+    ekf = PositionEKF(EKFConfig())
+
+    times = []
+    t_start = time.perf_counter()
+    for i in range(n):
+        e = entries[i % len(entries)]
+        t = e.t + (i // len(entries)) * span
+        t0 = time.perf_counter()
+
+        position = None
+        hdop = 0.0
+        if e.num_matches >= min_matches and e.inlier_ratio >= min_inlier_ratio:
+            H = np.array(e.H, dtype=np.float64).reshape(3, 3)
+            position = extract_gps(H, (e.width, e.height),
+                                   TileCoord(e.tile_z, e.tile_x, e.tile_y))
+            hdop = max(0.5, 5.0 * (1.0 - e.confidence))
+            ekf.update(position, hdop, t)
+
+        if ekf.state.initialized:
+            pos = ekf.position
+            fix = PositionFix(lat=pos.lat, lon=pos.lon,
+                              hdop=hdop if position else 2.0,
+                              speed_knots=ekf.speed_mps * 1.94384)
+        else:
+            fix = PositionFix(lat=0, lon=0, fix_quality=0)
+        format_gga(fix).encode("ascii")
+        format_rmc(fix).encode("ascii")
+
+        times.append((time.perf_counter() - t0) * 1000)
+    elapsed = time.perf_counter() - t_start
+
+    result = BenchmarkResult(name="Python loop", iterations=n, times_ms=times)
+    return result, n / elapsed if elapsed > 0 else 0.0
+
+
 def run_all_benchmarks(image_size: int = 640) -> list[BenchmarkResult]:
     """Run all benchmarks with synthetic images."""
     img1 = np.random.randint(0, 255, (image_size, image_size, 3), dtype=np.uint8)
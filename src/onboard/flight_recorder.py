@@ -43,6 +43,7 @@ SOURCE_MAP = {
 FLAG_GEOFENCE_OK = 0x01
 FLAG_EKF_ACCEPTED = 0x02
 FLAG_BLUR_SKIP = 0x04
+FLAG_SMOOTHED = 0x08  # written by onboard_c vps_smooth
 
 
 @dataclass(slots=True)
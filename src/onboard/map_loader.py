@@ -52,6 +52,7 @@ class MapLoader:
         self._pack_dir = pack_dir
         self._tiles: dict[tuple[int, int, int], TileEntry] = {}
         self._tiles_by_zoom: dict[int, list[TileEntry]] = {}
+        self._tile_list: list[TileEntry] = []
         self._info = MapPackInfo(pack_dir=pack_dir)
         self._loaded = False
 
@@ -114,6 +115,7 @@ class MapLoader:
                 self._tiles_by_zoom[z] = []
             self._tiles_by_zoom[z].append(te)
 
+        self._tile_list = list(self._tiles.values())
         self._info.tile_count = len(self._tiles)
         self._info.has_index = (self._pack_dir / "index" / "faiss.index").exists()
 
@@ -152,9 +154,8 @@ class MapLoader:
             return None
 
         # Without zoom, use insertion order
-        all_tiles = list(self._tiles.values())
-        if 0 <= index < len(all_tiles):
-            return all_tiles[index]
+        if 0 <= index < len(self._tile_list):
+            return self._tile_list[index]
         return None
 
     def nearest_tiles(self, point: GeoPoint, zoom: int, k: int = 5) -> list[TileEntry]:
@@ -4,6 +4,7 @@ Usage:
     vps-program download --center LAT,LON --radius-km 5 --zoom 17,19 --api-key KEY
     vps-program build-index ./map_pack/
     vps-program package ./map_pack/ --output map_pack.tar.gz
+    vps-program build-fences zones.geojson --output zones.vpsz
 """
 
 from __future__ import annotations
@@ -108,6 +109,21 @@ def package_cmd(pack_dir: Path, output: Path | None, include_models: bool, model
     click.echo(f"Package created: {result}")
 
 
+@cli.command("build-fences")
+@click.argument("geojson", type=click.Path(exists=True, path_type=Path))
+@click.option("--output", "-o", type=click.Path(path_type=Path),
+              default=Path("zones.vpsz"), help="Output zone file")
+def build_fences(geojson: Path, output: Path):
+    """Build the onboard zone file (inclusion fence + exclusion zones) from GeoJSON."""
+    from programmer.fence_pack import build_zone_file
+
+    try:
+        count, size = build_zone_file(geojson, output)
+    except ValueError as e:
+        raise click.UsageError(str(e))
+    click.echo(f"Zone file: {output} ({count} zones, {size} bytes)")
+
+
 @cli.command()
 @click.argument("telemetry_csv", type=click.Path(exists=True, path_type=Path))
 @click.option("--format", "fmt", type=click.Choice(["geojson", "html", "both"]),
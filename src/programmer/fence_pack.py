@@ -0,0 +1,156 @@
+"""Compact binary zone files for the onboard fence set.
+
+Converts an inclusion fence plus exclusion zones (airports, restricted
+areas) from GeoJSON into the "VPSZ" file read by onboard_c
+vps_fence_set_load(), which puts the exclusion zones behind a BVH.
+
+GeoJSON input: a FeatureCollection whose features carry
+    Point + properties.radius_m     -> circle
+    Polygon / MultiPolygon          -> polygon (inner rings are holes)
+and optional properties role ("inclusion" | "exclusion", default
+exclusion), margin_m (keep-out distance for exclusions, inset for the
+inclusion fence) and id (integer, reported back on violations).
+At most one feature may be the inclusion fence.
+
+Format (little-endian):
+    header  "<4sHHI"    magic, version, reserved, zone count
+    zone    "<BBHii3fI" type, role, ring count, centre lat/lon * 1e7,
+                        radius or half_lat km, half_lon km, margin km, id
+    polygon zones are followed by ring count uint32 ring lengths and
+    then (lat, lon) * 1e7 int32 pairs.
+"""
+
+from __future__ import annotations
+
+import json
+import struct
+from dataclasses import dataclass, field
+from pathlib import Path
+
+from shared.tile_math import GeoPoint
+
+HEADER_MAGIC = b"VPSZ"
+HEADER_VERSION = 1
+HEADER_FMT = "<4sHHI"
+HEADER_SIZE = struct.calcsize(HEADER_FMT)  # 12 bytes
+ZONE_FMT = "<BBHii3fI"
+ZONE_SIZE = struct.calcsize(ZONE_FMT)  # 28 bytes
+
+# Zone types (vps_fence_type_t) and roles (vps_zone_role_t)
+TYPE_CIRCLE = 0
+TYPE_RECT = 1
+TYPE_POLYGON = 2
+ROLE_INCLUSION = 0
+ROLE_EXCLUSION = 1
+
+ROLE_MAP = {"inclusion": ROLE_INCLUSION, "exclusion": ROLE_EXCLUSION}
+
+
+@dataclass
+class Zone:
+    """One fence zone."""
+    type: int
+    role: int = ROLE_EXCLUSION
+    center: GeoPoint = field(default_factory=lambda: GeoPoint(0.0, 0.0))
+    radius_km: float = 0.0      # circle radius, or rect half extent north
+    half_lon_km: float = 0.0    # rect half extent east
+    margin_km: float = 0.0
+    zone_id: int = 0
+    rings: list[list[GeoPoint]] = field(default_factory=list)  # polygon
+
+    def pack(self) -> bytes:
+        data = struct.pack(
+            ZONE_FMT, self.type, self.role, len(self.rings),
+            _e7(self.center.lat), _e7(self.center.lon),
+            self.radius_km, self.half_lon_km, self.margin_km, self.zone_id,
+        )
+        if self.type != TYPE_POLYGON:
+            return data
+        parts = [data, struct.pack(f"<{len(self.rings)}I", *(len(r) for r in self.rings))]
+        for ring in self.rings:
+            for p in ring:
+                parts.append(struct.pack("<ii", _e7(p.lat), _e7(p.lon)))
+        return b"".join(parts)
+
+
+def _e7(deg: float) -> int:
+    return int(round(deg * 1e7))
+
+
+def write_zone_file(path: Path, zones: list[Zone]) -> int:
+    """Write zones to a VPSZ file. Returns the file size in bytes."""
+    if sum(z.role == ROLE_INCLUSION for z in zones) > 1:
+        raise ValueError("at most one inclusion fence is allowed")
+    for z in zones:
+        if z.type == TYPE_POLYGON and (not z.rings or any(len(r) < 3 for r in z.rings)):
+            raise ValueError(f"zone {z.zone_id}: polygon rings need at least 3 vertices")
+    data = struct.pack(HEADER_FMT, HEADER_MAGIC, HEADER_VERSION, 0, len(zones))
+    data += b"".join(z.pack() for z in zones)
+    Path(path).write_bytes(data)
+    return len(data)
+
+
+def read_zone_file(path: Path) -> list[Zone]:
+    """Read a VPSZ file back (for inspection and tests)."""
+    data = Path(path).read_bytes()
+    magic, version, _, count = struct.unpack_from(HEADER_FMT, data, 0)
+    if magic != HEADER_MAGIC or version != HEADER_VERSION:
+        raise ValueError(f"{path}: not a VPSZ v{HEADER_VERSION} zone file")
+    off = HEADER_SIZE
+    zones = []
+    for _ in range(count):
+        (ztype, role, n_rings, lat, lon, a, b, margin,
+         zone_id) = struct.unpack_from(ZONE_FMT, data, off)
+        off += ZONE_SIZE
+        zone = Zone(ztype, role, GeoPoint(lat * 1e-7, lon * 1e-7), a, b, margin, zone_id)
+        if ztype == TYPE_POLYGON:
+            lengths = struct.unpack_from(f"<{n_rings}I", data, off)
+            off += 4 * n_rings
+            for n in lengths:
+                ring = []
+                for _ in range(n):
+                    plat, plon = struct.unpack_from("<ii", data, off)
+                    off += 8
+                    ring.append(GeoPoint(plat * 1e-7, plon * 1e-7))
+                zone.rings.append(ring)
+        zones.append(zone)
+    if off != len(data):
+        raise ValueError(f"{path}: {len(data) - off} trailing bytes")
+    return zones
+
+
+def zones_from_geojson(geojson: dict) -> list[Zone]:
+    """Convert a GeoJSON FeatureCollection (see module docstring) to zones."""
+    zones = []
+    for i, feature in enumerate(geojson.get("features", [])):
+        props = feature.get("properties") or {}
+        geom = feature.get("geometry") or {}
+        role_name = props.get("role", "exclusion")
+        if role_name not in ROLE_MAP:
+            raise ValueError(f"feature {i}: unknown role {role_name!r}")
+        role = ROLE_MAP[role_name]
+        margin_km = float(props.get("margin_m", 0.0)) / 1000.0
+        zone_id = int(props.get("id", i))
+        gtype = geom.get("type")
+        coords = geom.get("coordinates")
+        if gtype == "Point":
+            if "radius_m" not in props:
+                raise ValueError(f"feature {i}: Point zones need properties.radius_m")
+            zones.append(Zone(TYPE_CIRCLE, role, GeoPoint(coords[1], coords[0]),
+                              float(props["radius_m"]) / 1000.0, 0.0, margin_km, zone_id))
+        elif gtype in ("Polygon", "MultiPolygon"):
+            polygons = [coords] if gtype == "Polygon" else coords
+            for rings in polygons:
+                zones.append(Zone(
+                    TYPE_POLYGON, role, margin_km=margin_km, zone_id=zone_id,
+                    rings=[[GeoPoint(lat, lon) for lon, lat in ring] for ring in rings],
+                ))
+        else:
+            raise ValueError(f"feature {i}: unsupported geometry {gtype!r}")
+    return zones
+
+
+def build_zone_file(geojson_path: Path, output: Path) -> tuple[int, int]:
+    """GeoJSON file -> VPSZ file. Returns (zone count, bytes written)."""
+    zones = zones_from_geojson(json.loads(Path(geojson_path).read_text()))
+    return len(zones), write_zone_file(output, zones)
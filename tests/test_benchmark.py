@@ -5,12 +5,16 @@ import pytest
 
 from onboard.benchmark import (
     BenchmarkResult,
+    MatchLogEntry,
     benchmark_homography,
     benchmark_msp_encoding,
     benchmark_nmea_encoding,
     benchmark_orb_extraction,
     benchmark_orb_matching,
+    benchmark_replay_loop,
+    load_match_log,
     run_all_benchmarks,
+    save_match_log,
 )
 
 
@@ -67,3 +71,42 @@ class TestBenchmarks:
         assert len(results) == 5
         for r in results:
             assert r.mean_ms >= 0
+
+
+def _match_log(n: int = 30) -> list[MatchLogEntry]:
+    entries = []
+    for i in range(n):
+        matched = i % 5 != 4
+        entries.append(MatchLogEntry(
+            t=i / 3.0, tile_z=19, tile_x=281640, tile_y=171940,
+            num_matches=120 if matched else 0,
+            inlier_ratio=0.7 if matched else 0.0,
+            confidence=0.7 if matched else 0.0,
+            H=(0.4, 0.0, 0.0, 0.0, 0.4, 0.0, 0.0, 0.0, 1.0),
+        ))
+    return entries
+
+
+class TestMatchLog:
+    def test_roundtrip(self, tmp_path):
+        path = tmp_path / "frames.csv"
+        entries = _match_log(10)
+        save_match_log(path, entries)
+        loaded = load_match_log(path)
+        assert loaded == entries
+
+    def test_header_written(self, tmp_path):
+        path = tmp_path / "frames.csv"
+        save_match_log(path, _match_log(1))
+        assert path.read_text().startswith("t,width,height,")
+
+    def test_replay_loop(self):
+        r, fps = benchmark_replay_loop(_match_log(), iterations=60)
+        assert r.iterations == 60
+        assert len(r.times_ms) == 60
+        assert fps > 0
+
+    def test_replay_loop_empty(self):
+        r, fps = benchmark_replay_loop([])
+        assert r.iterations == 0
+        assert fps == 0.0
@@ -0,0 +1,93 @@
+"""Tests for the onboard zone file writer."""
+
+import json
+import struct
+
+import pytest
+
+from shared.tile_math import GeoPoint
+from programmer.fence_pack import (
+    HEADER_FMT, HEADER_MAGIC, HEADER_SIZE, HEADER_VERSION, ROLE_EXCLUSION,
+    ROLE_INCLUSION, TYPE_CIRCLE, TYPE_POLYGON, TYPE_RECT, ZONE_SIZE, Zone,
+    build_zone_file, read_zone_file, write_zone_file, zones_from_geojson,
+)
+
+
+def _geojson():
+    return {
+        "type": "FeatureCollection",
+        "features": [
+            {"type": "Feature",
+             "properties": {"role": "inclusion", "radius_m": 10000, "margin_m": 100, "id": 1},
+             "geometry": {"type": "Point", "coordinates": [8.5456, 47.3977]}},
+            {"type": "Feature",
+             "properties": {"radius_m": 1500, "margin_m": 200, "id": 7},
+             "geometry": {"type": "Point", "coordinates": [8.56, 47.45]}},
+            {"type": "Feature",
+             "properties": {"id": 9},
+             "geometry": {"type": "Polygon", "coordinates": [
+                 [[8.50, 47.38], [8.52, 47.38], [8.52, 47.40], [8.50, 47.40], [8.50, 47.38]],
+                 [[8.505, 47.385], [8.505, 47.395], [8.515, 47.395], [8.515, 47.385]],
+             ]}},
+        ],
+    }
+
+
+class TestGeoJson:
+    def test_zones(self):
+        zones = zones_from_geojson(_geojson())
+        assert [z.type for z in zones] == [TYPE_CIRCLE, TYPE_CIRCLE, TYPE_POLYGON]
+        assert [z.role for z in zones] == [ROLE_INCLUSION, ROLE_EXCLUSION, ROLE_EXCLUSION]
+        assert zones[0].radius_km == pytest.approx(10.0)
+        assert zones[0].center.lat == pytest.approx(47.3977)
+        assert zones[1].margin_km == pytest.approx(0.2)
+        assert len(zones[2].rings) == 2
+        assert zones[2].rings[0][1] == GeoPoint(47.38, 8.52)
+
+    def test_multipolygon_and_errors(self):
+        geo = {"features": [{"properties": {}, "geometry": {
+            "type": "MultiPolygon",
+            "coordinates": [[[[0, 0], [1, 0], [0, 1]]], [[[5, 5], [6, 5], [5, 6]]]]}}]}
+        assert len(zones_from_geojson(geo)) == 2
+        with pytest.raises(ValueError):
+            zones_from_geojson({"features": [{"properties": {},
+                                              "geometry": {"type": "Point", "coordinates": [0, 0]}}]})
+        with pytest.raises(ValueError):
+            zones_from_geojson({"features": [{"properties": {"role": "maybe", "radius_m": 1},
+                                              "geometry": {"type": "Point", "coordinates": [0, 0]}}]})
+
+
+class TestZoneFile:
+    def test_layout(self, tmp_path):
+        path = tmp_path / "zones.vpsz"
+        size = write_zone_file(path, zones_from_geojson(_geojson()))
+        data = path.read_bytes()
+        assert size == len(data) == HEADER_SIZE + 3 * ZONE_SIZE + 2 * 4 + 9 * 8
+        magic, version, _, count = struct.unpack_from(HEADER_FMT, data)
+        assert (magic, version, count) == (HEADER_MAGIC, HEADER_VERSION, 3)
+
+    def test_roundtrip(self, tmp_path):
+        path = tmp_path / "zones.vpsz"
+        zones = [
+            Zone(TYPE_RECT, ROLE_EXCLUSION, GeoPoint(-33.87, 151.21), 0.5, 1.0, 0.1, 42),
+            *zones_from_geojson(_geojson()),
+        ]
+        write_zone_file(path, zones)
+        back = read_zone_file(path)
+        assert len(back) == 4
+        assert back[0].type == TYPE_RECT and back[0].zone_id == 42
+        assert back[0].half_lon_km == pytest.approx(1.0)
+        assert back[0].center.lon == pytest.approx(151.21, abs=1e-7)
+        assert back[3].rings[1][2].lat == pytest.approx(47.395, abs=1e-7)
+
+    def test_rejects_two_inclusions(self, tmp_path):
+        zone = Zone(TYPE_CIRCLE, ROLE_INCLUSION, GeoPoint(0, 0), 1.0)
+        with pytest.raises(ValueError):
+            write_zone_file(tmp_path / "z.vpsz", [zone, zone])
+
+    def test_build_from_file(self, tmp_path):
+        src = tmp_path / "zones.geojson"
+        src.write_text(json.dumps(_geojson()))
+        count, size = build_zone_file(src, tmp_path / "zones.vpsz")
+        assert count == 3
+        assert size == (tmp_path / "zones.vpsz").stat().st_size